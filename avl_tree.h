@@ -0,0 +1,1283 @@
+/*
+ File:   avl_tree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    An AVL tree: a search_tree whose subtrees differ in height by at most
+    one. The height stays under 1.44 log n, against 2 log n for a red-black
+    tree, so lookups visit fewer nodes. Worth it when reads dominate.
+
+ Implementation:
+  - Nodes carry a parent pointer and the balance factor, height(right) -
+    height(left), stored plus one in the two low bits of the parent
+    pointer. A node is then three pointers and the element.
+  - Insertion and removal are iterative. They walk back up the parent
+    pointers fixing balance factors and stop as soon as a subtree's height
+    is unchanged: at most one (single or double) rotation per insertion and
+    O(log n) per removal.
+  - Removing a node with two children moves its in-order successor node
+    into its place rather than copying the successor's element, so no
+    element is ever copied or assigned and iterators to other elements
+    stay valid.
+  - With Ranked set every node also counts the nodes in its subtree, which
+    gives get/operator[] and index_of in O(log n). ranked_avl_tree names
+    that variant. The plain tree does not pay for the counts; the rank
+    operations fail to compile on it.
+  - Merging another avl_tree splices both trees' nodes into a perfectly
+    balanced tree in linear time without allocating.
+ */
+
+
+#ifndef avl_tree_h
+#define avl_tree_h
+
+#include <algorithm>         // max
+#include <cassert>           // assert
+#include <cstddef>           // ptrdiff_t
+#include <cstdint>           // uintptr_t
+#include <functional>        // less
+#include <initializer_list>  // initializer_list
+#include <iterator>          // iterator
+#include <memory>            // allocator, addressof
+#include <utility>           // move, forward, swap
+#include <vector>            // vector
+
+#include "search_tree.h"
+
+namespace ads {
+
+// The subtree size kept in the nodes of a ranked tree. The unranked
+// version has no storage and reports a count of zero.
+template <bool Ranked>
+struct avl_rank {
+    std::size_t count() const { return 0; }
+    void set_count(std::size_t) {}
+};
+
+template <>
+struct avl_rank<true> {
+    std::size_t subtree = 1;
+
+    std::size_t count() const { return subtree; }
+    void set_count(std::size_t n) { subtree = n; }
+};
+
+
+template <class T, class Compare = std::less<T>, bool Ranked = false,
+          class Alloc = std::allocator<T>>
+class avl_tree final : public search_tree<T> {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+
+/* Node definition */
+private:
+    struct Node : avl_rank<Ranked> {
+        std::uintptr_t parent_balance;   // Parent pointer | (balance + 1).
+        Node* left = nullptr;
+        Node* right = nullptr;
+        T data;
+
+        template <class... Args>
+        Node(Node* p, Args&&... args)
+            : parent_balance(reinterpret_cast<std::uintptr_t>(p) | 1)
+            , data(std::forward<Args>(args)...)
+        {}
+
+        Node* parent() const
+        {
+            return reinterpret_cast<Node*>(parent_balance & ~std::uintptr_t(3));
+        }
+
+        void set_parent(Node* p)
+        {
+            parent_balance = reinterpret_cast<std::uintptr_t>(p) | (parent_balance & 3);
+        }
+
+        int balance() const { return static_cast<int>(parent_balance & 3) - 1; }
+
+        void set_balance(int b)
+        {
+            parent_balance = (parent_balance & ~std::uintptr_t(3)) | static_cast<std::uintptr_t>(b + 1);
+        }
+    };
+
+    static_assert(alignof(Node) >= 4, "the balance factor needs two spare pointer bits");
+
+    typedef typename Alloc::template rebind<Node>::other node_alloc;
+
+
+/* Iterators */
+public:
+    class const_iterator : public std::iterator<std::bidirectional_iterator_tag, value_type,
+                                                std::ptrdiff_t, const T*, const T&> {
+
+        friend class avl_tree<T, Compare, Ranked, Alloc>;
+
+    private:
+        Node* node;
+        const avl_tree<T, Compare, Ranked, Alloc>* owner;   // For --end().
+
+    public:
+        const_iterator(Node* n = nullptr, const avl_tree<T, Compare, Ranked, Alloc>* t = nullptr)
+            : node(n), owner(t) {}
+        const_ref operator*() const { return node->data; }
+        const T* operator->() const { return std::addressof(node->data); }
+        const_iterator& operator++() { node = next(node); return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); ++*this; return temp; }
+        const_iterator& operator--() { node = node ? prev(node) : rightmost(owner->_root); return *this; }
+        const_iterator operator--(int) { const_iterator temp(*this); --*this; return temp; }
+        bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
+    };
+
+    typedef const_iterator iterator;
+
+
+/* Data members */
+private:
+    Node* _root = nullptr;
+    Compare _compare;
+    node_alloc _alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    avl_tree() = default;
+    avl_tree(const avl_tree<T, Compare, Ranked, Alloc>&);
+    avl_tree(avl_tree<T, Compare, Ranked, Alloc>&&);
+    avl_tree(std::initializer_list<T>);
+    ~avl_tree();
+
+    /* Assignment */
+    avl_tree<T, Compare, Ranked, Alloc>& operator=(avl_tree<T, Compare, Ranked, Alloc>);
+
+    /* Iterators */
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /* Capacity */
+    size_type height() const;
+
+    /* Element access */
+    bool has(const_ref) const override;
+    const_iterator find(const_ref) const;
+    const_iterator lower_bound(const_ref) const;
+    size_type index_of(const_ref) const;
+    const_ref get(size_type) const;
+    const_ref operator[](size_type) const;
+
+    /* Modifiers */
+    bool insert(const_ref);
+    bool insert(rvalue_ref);
+    template <class... Args>
+        bool emplace(Args&&...);
+    bool erase(const_ref);
+    void add(const_ref) override;
+    void remove(const_ref) override;
+    void swap(avl_tree<T, Compare, Ranked, Alloc>&);
+    void clear() noexcept override;
+
+    /* Operations */
+    void merge(binary_tree<T>&) override;
+    void merge(binary_tree<T>&&) override;
+    void for_each(const std::function<void(const_ref)>&) const override;
+
+/* Helper functions */
+private:
+    template <class... Args>
+        Node* create_node(Node*, Args&&...);
+    void destroy_node(Node*);
+    void destroy_subtree(Node*);
+    void copy_subtree(const Node*, Node*, Node*&);
+
+    static Node* leftmost(Node*);
+    static Node* rightmost(Node*);
+    static Node* next(Node*);
+    static Node* prev(Node*);
+    static size_type weight(const Node*);
+    static void refresh(Node*);
+    void refresh_path(Node*);
+
+    Node* descend(const_ref, Node*&, bool&) const;
+    Node* lower(const_ref) const;
+    void attach(Node*, Node*, bool);
+    void detach(Node*);
+    void replace(Node*, Node*, Node*);
+    void rotate_left(Node*);
+    void rotate_right(Node*);
+    Node* rebalance(Node*, int);
+    void fix_after_insert(Node*);
+    void fix_after_erase(Node*, bool);
+    int build(const std::vector<Node*>&, size_type, size_type, Node*, Node*&);
+    void merge_nodes(avl_tree<T, Compare, Ranked, Alloc>&);
+};
+
+
+// An AVL tree that also supports access by rank.
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+using ranked_avl_tree = avl_tree<T, Compare, true, Alloc>;
+
+
+
+// Node management
+
+/*
+ Function: create_node
+ Parameters:
+  - parent: The node's parent.
+  - args: Arguments forwarded to the element's constructor.
+ Return value: A balanced leaf. Nothing is leaked if the element's
+               constructor throws.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+template <class... Args>
+typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::create_node(Node* parent, Args&&... args)
+{
+    auto node = _alloc.allocate(1);
+    try {
+        ::new (static_cast<void*>(node)) Node(parent, std::forward<Args>(args)...);
+    } catch (...) {
+        _alloc.deallocate(node, 1);
+        throw;
+    }
+
+    return node;
+}
+
+
+/*
+ Function: destroy_node / destroy_subtree
+ Parameters:
+  - node: The node, or root of the subtree, to free.
+
+ Complexity: Linear in the size of the subtree. The recursion is only as
+             deep as the tree is high.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+inline void
+avl_tree<T, Compare, Ranked, Alloc>::destroy_node(Node* node)
+{
+    node->~Node();
+    _alloc.deallocate(node, 1);
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::destroy_subtree(Node* node)
+{
+    while (node) {
+        destroy_subtree(node->left);
+        auto right = node->right;
+        destroy_node(node);
+        node = right;
+    }
+}
+
+
+/*
+ Function: copy_subtree
+ Parameters:
+  - source: The root of the subtree to copy.
+  - parent: The parent of the copy.
+  - slot: Where the copy is linked in.
+
+ Description:
+    Copies shape and balance factors as well as the elements. Each node is
+    linked in before its children are copied, so if an element's copy
+    throws everything built so far is reachable from the root and can be
+    freed.
+
+ Complexity: Linear in the size of the subtree.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::copy_subtree(const Node* source, Node* parent, Node*& slot)
+{
+    if (!source)
+        return;
+
+    slot = create_node(parent, source->data);
+    slot->set_balance(source->balance());
+    slot->set_count(source->count());
+    copy_subtree(source->left, slot, slot->left);
+    copy_subtree(source->right, slot, slot->right);
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The tree being copied or moved from.
+  - il: Initializer list of elements, in any order.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty tree (defaulted in the class).
+  2. independent copy of rhs with the same shape.
+  3. tree that takes over rhs's nodes, leaving rhs empty.
+  4. tree holding the distinct elements of il.
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs.
+  3. Constant.
+  4. n log n in the size of il.
+ */
+
+// 2. copy
+template <class T, class Compare, bool Ranked, class Alloc>
+avl_tree<T, Compare, Ranked, Alloc>::avl_tree(const avl_tree<T, Compare, Ranked, Alloc>& rhs)
+    : _compare(rhs._compare)
+{
+    try {
+        copy_subtree(rhs._root, nullptr, _root);
+    } catch (...) {
+        destroy_subtree(_root);
+        throw;
+    }
+    this->_size = rhs._size;
+}
+
+// 3. move
+template <class T, class Compare, bool Ranked, class Alloc>
+avl_tree<T, Compare, Ranked, Alloc>::avl_tree(avl_tree<T, Compare, Ranked, Alloc>&& rhs)
+{
+    swap(rhs);
+}
+
+// 4. initializer list
+template <class T, class Compare, bool Ranked, class Alloc>
+avl_tree<T, Compare, Ranked, Alloc>::avl_tree(std::initializer_list<T> il)
+{
+    for (auto& element : il)
+        insert(element);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+avl_tree<T, Compare, Ranked, Alloc>::~avl_tree()
+{
+    destroy_subtree(_root);
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this tree.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+avl_tree<T, Compare, Ranked, Alloc>&
+avl_tree<T, Compare, Ranked, Alloc>::operator=(avl_tree<T, Compare, Ranked, Alloc> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end
+ Return value: Iterators to the smallest element and past the largest.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::const_iterator
+avl_tree<T, Compare, Ranked, Alloc>::begin() const
+{
+    return const_iterator(leftmost(_root), this);
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::const_iterator
+avl_tree<T, Compare, Ranked, Alloc>::end() const
+{
+    return const_iterator(nullptr, this);
+}
+
+
+
+// Capacity
+
+/*
+ Function: height
+ Return value: The number of nodes on the longest root to leaf path.
+
+ Description:
+    Follows the taller child at each step, which the balance factors name.
+
+ Complexity: Logarithmic.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+typename avl_tree<T, Compare, Ranked, Alloc>::size_type
+avl_tree<T, Compare, Ranked, Alloc>::height() const
+{
+    size_type h = 0;
+    for (auto node = _root; node; node = node->balance() < 0 ? node->left : node->right)
+        ++h;
+
+    return h;
+}
+
+
+
+// Element access
+
+/*
+ Function: has / find / lower_bound
+ Parameters:
+  - element: The value to look for.
+ Return value: Whether element is present, an iterator to it (end() if
+               absent), or an iterator to the first element not less
+               than it.
+
+ Complexity: Logarithmic.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+inline bool
+avl_tree<T, Compare, Ranked, Alloc>::has(const_ref element) const
+{
+    auto node = lower(element);
+    return node && !_compare(element, node->data);
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::const_iterator
+avl_tree<T, Compare, Ranked, Alloc>::find(const_ref element) const
+{
+    auto node = lower(element);
+    return const_iterator(node && !_compare(element, node->data) ? node : nullptr, this);
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::const_iterator
+avl_tree<T, Compare, Ranked, Alloc>::lower_bound(const_ref element) const
+{
+    return const_iterator(lower(element), this);
+}
+
+
+/*
+ Function: index_of
+ Parameters:
+  - element: The value to look for.
+ Return value: The rank of element, or size() if it is absent.
+
+ Description:
+    Only available on a ranked tree.
+
+ Complexity: Logarithmic.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+typename avl_tree<T, Compare, Ranked, Alloc>::size_type
+avl_tree<T, Compare, Ranked, Alloc>::index_of(const_ref element) const
+{
+    static_assert(Ranked, "index_of needs a ranked_avl_tree");
+
+    size_type rank = 0;
+    for (auto node = _root; node;) {
+        if (_compare(element, node->data)) {
+            node = node->left;
+        } else if (_compare(node->data, element)) {
+            rank += weight(node->left) + 1;
+            node = node->right;
+        } else {
+            return rank + weight(node->left);
+        }
+    }
+
+    return this->_size;
+}
+
+
+/*
+ Function: get / operator[]
+ Parameters:
+  - index: A rank in [0, size()).
+ Return value: The index-th smallest element.
+
+ Description:
+    Only available on a ranked tree.
+
+ Complexity: Logarithmic.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+typename avl_tree<T, Compare, Ranked, Alloc>::const_ref
+avl_tree<T, Compare, Ranked, Alloc>::get(size_type index) const
+{
+    static_assert(Ranked, "get needs a ranked_avl_tree");
+    assert(index < this->_size);
+
+    auto node = _root;
+    for (;;) {
+        auto left = weight(node->left);
+        if (index < left) {
+            node = node->left;
+        } else if (index > left) {
+            index -= left + 1;
+            node = node->right;
+        } else {
+            return node->data;
+        }
+    }
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::const_ref
+avl_tree<T, Compare, Ranked, Alloc>::operator[](size_type index) const
+{
+    return get(index);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / emplace
+ Parameters:
+  - element: The value to insert.
+  - args: Arguments to construct the value from.
+ Return value: Whether the value was inserted (false if already present).
+
+ Description:
+    insert only constructs a node once it knows the value is absent.
+    emplace has to build the value before it can search for it.
+
+ Complexity: Logarithmic, with at most one rotation.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+bool
+avl_tree<T, Compare, Ranked, Alloc>::insert(const_ref element)
+{
+    Node* parent;
+    bool left;
+    if (descend(element, parent, left))
+        return false;
+
+    attach(create_node(parent, element), parent, left);
+    return true;
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+bool
+avl_tree<T, Compare, Ranked, Alloc>::insert(rvalue_ref element)
+{
+    Node* parent;
+    bool left;
+    if (descend(element, parent, left))
+        return false;
+
+    attach(create_node(parent, std::move(element)), parent, left);
+    return true;
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+template <class... Args>
+bool
+avl_tree<T, Compare, Ranked, Alloc>::emplace(Args&&... args)
+{
+    auto node = create_node(nullptr, std::forward<Args>(args)...);
+
+    Node* parent;
+    bool left;
+    if (descend(node->data, parent, left)) {
+        destroy_node(node);
+        return false;
+    }
+
+    node->set_parent(parent);
+    attach(node, parent, left);
+    return true;
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - element: The value to remove.
+ Return value: Whether the value was present.
+
+ Complexity: Logarithmic.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+bool
+avl_tree<T, Compare, Ranked, Alloc>::erase(const_ref element)
+{
+    Node* parent;
+    bool left;
+    auto node = descend(element, parent, left);
+    if (!node)
+        return false;
+
+    detach(node);
+    destroy_node(node);
+    --this->_size;
+    return true;
+}
+
+
+/*
+ Function: add / remove
+ Parameters:
+  - element: The value to insert or remove.
+
+ Description:
+    The binary_tree interface to insert and erase.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::add(const_ref element)
+{
+    insert(element);
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::remove(const_ref element)
+{
+    erase(element);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - other: The tree to exchange contents with.
+
+ Complexity: Constant.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::swap(avl_tree<T, Compare, Ranked, Alloc>& other)
+{
+    using std::swap;
+    swap(_root, other._root);
+    swap(this->_size, other._size);
+    swap(_compare, other._compare);
+    swap(_alloc, other._alloc);
+}
+
+
+/*
+ Function: clear
+ Description: Removes every element.
+ Complexity: Linear.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::clear() noexcept
+{
+    destroy_subtree(_root);
+    _root = nullptr;
+    this->_size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: merge
+ Parameters:
+  - other: The tree to move every element out of.
+ Return value: None
+
+ Description:
+    Moves the elements of other into this tree, leaving other empty.
+    Elements already present here stay and other's copy is dropped. When
+    other is an avl_tree of the same type its nodes are spliced in;
+    otherwise its elements are copied in one at a time.
+
+ Complexity: Linear in the combined size for an avl_tree; m log(n + m)
+             otherwise.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::merge(binary_tree<T>& other)
+{
+    if (&other == this)
+        return;
+
+    if (auto same = dynamic_cast<avl_tree<T, Compare, Ranked, Alloc>*>(&other)) {
+        merge_nodes(*same);
+        return;
+    }
+
+    other.for_each([this](const_ref element){ insert(element); });
+    other.clear();
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::merge(binary_tree<T>&& other)
+{
+    merge(other);
+}
+
+
+/*
+ Function: for_each
+ Parameters:
+  - visit: Called with each element in ascending order.
+
+ Complexity: Linear.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::for_each(const std::function<void(const_ref)>& visit) const
+{
+    for (auto node = leftmost(_root); node; node = next(node))
+        visit(node->data);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: leftmost / rightmost / next / prev
+ Return value: The extreme node of a subtree (null for an empty one), or a
+               node's in-order neighbour (null past either end).
+
+ Complexity: Logarithmic; next and prev are amortized constant over a
+             full traversal.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::leftmost(Node* node)
+{
+    if (node)
+        while (node->left)
+            node = node->left;
+
+    return node;
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::rightmost(Node* node)
+{
+    if (node)
+        while (node->right)
+            node = node->right;
+
+    return node;
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::next(Node* node)
+{
+    if (node->right)
+        return leftmost(node->right);
+
+    auto parent = node->parent();
+    while (parent && node == parent->right) {
+        node = parent;
+        parent = parent->parent();
+    }
+
+    return parent;
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::prev(Node* node)
+{
+    if (node->left)
+        return rightmost(node->left);
+
+    auto parent = node->parent();
+    while (parent && node == parent->left) {
+        node = parent;
+        parent = parent->parent();
+    }
+
+    return parent;
+}
+
+
+/*
+ Function: weight / refresh / refresh_path
+ Parameters:
+  - node: The node (possibly null) to read or recompute the count of.
+
+ Description:
+    Subtree counts for the ranked tree. refresh recomputes a node's count
+    from its children; refresh_path does so from node up to the root. All
+    three are no-ops on an unranked tree.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::size_type
+avl_tree<T, Compare, Ranked, Alloc>::weight(const Node* node)
+{
+    return node ? node->count() : 0;
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+inline void
+avl_tree<T, Compare, Ranked, Alloc>::refresh(Node* node)
+{
+    node->set_count(1 + weight(node->left) + weight(node->right));
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+inline void
+avl_tree<T, Compare, Ranked, Alloc>::refresh_path(Node* node)
+{
+    if (Ranked)
+        for (; node; node = node->parent())
+            refresh(node);
+}
+
+
+/*
+ Function: descend
+ Parameters:
+  - element: The value to look for.
+  - parent: Receives the last node visited when element is absent.
+  - left: Receives whether element belongs to parent's left.
+ Return value: The node holding element, or null.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::descend(const_ref element, Node*& parent, bool& left) const
+{
+    parent = nullptr;
+    left = false;
+
+    for (auto node = _root; node;) {
+        if (_compare(element, node->data)) {
+            parent = node;
+            left = true;
+            node = node->left;
+        } else if (_compare(node->data, element)) {
+            parent = node;
+            left = false;
+            node = node->right;
+        } else {
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/*
+ Function: lower
+ Parameters:
+  - element: The value to look for.
+ Return value: The first node not less than element, or null.
+
+ Description:
+    One comparison per level and no early exit, which keeps the loop free
+    of hard to predict branches for lookups.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+inline typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::lower(const_ref element) const
+{
+    Node* candidate = nullptr;
+    for (auto node = _root; node;) {
+        if (_compare(node->data, element)) {
+            node = node->right;
+        } else {
+            candidate = node;
+            node = node->left;
+        }
+    }
+
+    return candidate;
+}
+
+
+/*
+ Function: attach
+ Parameters:
+  - node: A new leaf whose parent is already set.
+  - parent: Where descend said it belongs (null for an empty tree).
+  - left: Which side of parent.
+
+ Description:
+    Links the leaf in, updates the counts and rebalances.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::attach(Node* node, Node* parent, bool left)
+{
+    if (!parent)
+        _root = node;
+    else if (left)
+        parent->left = node;
+    else
+        parent->right = node;
+
+    ++this->_size;
+    refresh_path(parent);
+    fix_after_insert(node);
+}
+
+
+/*
+ Function: detach
+ Parameters:
+  - node: The node to unlink. It is not freed.
+
+ Description:
+    A node with two children is replaced by its in-order successor, which
+    takes over its links and balance factor. Rebalancing then starts where
+    the tree actually lost a node: the successor's old parent, or the
+    successor itself if it was node's right child.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::detach(Node* node)
+{
+    Node* start;
+    bool left;
+
+    if (!node->left || !node->right) {
+        start = node->parent();
+        left = start && start->left == node;
+        replace(node, node->left ? node->left : node->right, start);
+    } else {
+        auto successor = leftmost(node->right);
+        if (successor->parent() == node) {
+            start = successor;
+            left = false;
+        } else {
+            start = successor->parent();
+            left = true;
+            start->left = successor->right;
+            if (successor->right)
+                successor->right->set_parent(start);
+            successor->right = node->right;
+            successor->right->set_parent(successor);
+        }
+
+        successor->left = node->left;
+        successor->left->set_parent(successor);
+        successor->set_balance(node->balance());
+        replace(node, successor, node->parent());
+    }
+
+    refresh_path(start);
+    fix_after_erase(start, left);
+}
+
+
+/*
+ Function: replace
+ Parameters:
+  - node: The child of parent being replaced.
+  - child: What takes its place (may be null).
+  - parent: node's parent (null if node is the root).
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+inline void
+avl_tree<T, Compare, Ranked, Alloc>::replace(Node* node, Node* child, Node* parent)
+{
+    if (!parent)
+        _root = child;
+    else if (parent->left == node)
+        parent->left = child;
+    else
+        parent->right = child;
+
+    if (child)
+        child->set_parent(parent);
+}
+
+
+/*
+ Function: rotate_left / rotate_right
+ Parameters:
+  - node: The root of the subtree to rotate. Its right (left) child
+          becomes the new root.
+
+ Description:
+    Relinks the three nodes involved and their counts. Balance factors
+    are left to the caller.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::rotate_left(Node* node)
+{
+    auto pivot = node->right;
+    auto parent = node->parent();
+
+    node->right = pivot->left;
+    if (pivot->left)
+        pivot->left->set_parent(node);
+    pivot->left = node;
+    node->set_parent(pivot);
+    replace(node, pivot, parent);
+
+    refresh(node);
+    refresh(pivot);
+}
+
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::rotate_right(Node* node)
+{
+    auto pivot = node->left;
+    auto parent = node->parent();
+
+    node->left = pivot->right;
+    if (pivot->right)
+        pivot->right->set_parent(node);
+    pivot->right = node;
+    node->set_parent(pivot);
+    replace(node, pivot, parent);
+
+    refresh(node);
+    refresh(pivot);
+}
+
+
+/*
+ Function: rebalance
+ Parameters:
+  - node: A node whose balance factor has reached +-2.
+  - balance: That balance factor.
+ Return value: The new root of the subtree.
+
+ Description:
+    A single rotation when the taller child leans the same way (or not at
+    all, which only happens on removal), a double rotation otherwise. The
+    subtree ends up one shorter than it was unless the taller child was
+    level, in which case the new root is left leaning and the height is
+    unchanged.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+typename avl_tree<T, Compare, Ranked, Alloc>::Node*
+avl_tree<T, Compare, Ranked, Alloc>::rebalance(Node* node, int balance)
+{
+    if (balance > 0) {
+        auto child = node->right;
+        auto lean = child->balance();
+        if (lean >= 0) {
+            rotate_left(node);
+            node->set_balance(lean == 0 ? 1 : 0);
+            child->set_balance(lean == 0 ? -1 : 0);
+            return child;
+        }
+
+        auto grandchild = child->left;
+        lean = grandchild->balance();
+        rotate_right(child);
+        rotate_left(node);
+        node->set_balance(lean > 0 ? -1 : 0);
+        child->set_balance(lean < 0 ? 1 : 0);
+        grandchild->set_balance(0);
+        return grandchild;
+    }
+
+    auto child = node->left;
+    auto lean = child->balance();
+    if (lean <= 0) {
+        rotate_right(node);
+        node->set_balance(lean == 0 ? -1 : 0);
+        child->set_balance(lean == 0 ? 1 : 0);
+        return child;
+    }
+
+    auto grandchild = child->right;
+    lean = grandchild->balance();
+    rotate_left(child);
+    rotate_right(node);
+    node->set_balance(lean < 0 ? 1 : 0);
+    child->set_balance(lean > 0 ? -1 : 0);
+    grandchild->set_balance(0);
+    return grandchild;
+}
+
+
+/*
+ Function: fix_after_insert
+ Parameters:
+  - node: The leaf just attached.
+
+ Description:
+    Walks up while subtrees grow. A parent that becomes level absorbs the
+    growth; one that reaches +-2 is rotated back to its old height.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::fix_after_insert(Node* node)
+{
+    for (auto parent = node->parent(); parent; node = parent, parent = parent->parent()) {
+        auto balance = parent->balance() + (parent->left == node ? -1 : 1);
+        if (balance == 0) {
+            parent->set_balance(0);
+            return;
+        }
+        if (balance == 1 || balance == -1) {
+            parent->set_balance(balance);
+            continue;
+        }
+
+        rebalance(parent, balance);
+        return;
+    }
+}
+
+
+/*
+ Function: fix_after_erase
+ Parameters:
+  - node: The deepest node whose subtree lost a level.
+  - left: Whether it was node's left subtree that shrank.
+
+ Description:
+    Walks up while subtrees shrink. A level node that starts leaning
+    keeps its height; anything else shrinks and passes the change up.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::fix_after_erase(Node* node, bool left)
+{
+    while (node) {
+        auto parent = node->parent();
+        auto from_left = parent && parent->left == node;
+
+        auto balance = node->balance() + (left ? 1 : -1);
+        if (balance == 1 || balance == -1) {
+            node->set_balance(balance);
+            return;
+        }
+        if (balance == 0) {
+            node->set_balance(0);
+        } else if (rebalance(node, balance)->balance() != 0) {
+            return;
+        }
+
+        node = parent;
+        left = from_left;
+    }
+}
+
+
+/*
+ Function: build
+ Parameters:
+  - nodes: Nodes in ascending order.
+  - first, last: The range of nodes to build a subtree from.
+  - parent: The parent of the subtree.
+  - slot: Receives the subtree's root.
+ Return value: The height of the subtree.
+
+ Description:
+    Links the range into a perfectly balanced subtree around its middle
+    node.
+
+ Complexity: Linear in the size of the range.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+int
+avl_tree<T, Compare, Ranked, Alloc>::build(const std::vector<Node*>& nodes, size_type first,
+                                           size_type last, Node* parent, Node*& slot)
+{
+    if (first == last) {
+        slot = nullptr;
+        return 0;
+    }
+
+    auto mid = first + (last - first) / 2;
+    auto node = nodes[mid];
+    node->parent_balance = reinterpret_cast<std::uintptr_t>(parent);
+
+    auto left = build(nodes, first, mid, node, node->left);
+    auto right = build(nodes, mid + 1, last, node, node->right);
+    node->set_balance(right - left);
+    refresh(node);
+
+    slot = node;
+    return 1 + std::max(left, right);
+}
+
+
+/*
+ Function: merge_nodes
+ Parameters:
+  - other: A tree of the same type to take every node from.
+
+ Description:
+    Merges both trees' nodes in order, frees other's duplicates and builds
+    one balanced tree from the result.
+
+ Complexity: Linear in the combined size.
+ */
+template <class T, class Compare, bool Ranked, class Alloc>
+void
+avl_tree<T, Compare, Ranked, Alloc>::merge_nodes(avl_tree<T, Compare, Ranked, Alloc>& other)
+{
+    if (other.empty())
+        return;
+    if (this->empty()) {
+        swap(other);
+        return;
+    }
+
+    // Other's nodes are listed before any are freed, since walking the
+    // tree reads parent pointers.
+    std::vector<Node*> theirs;
+    theirs.reserve(other._size);
+    for (auto node = leftmost(other._root); node; node = next(node))
+        theirs.push_back(node);
+
+    std::vector<Node*> nodes;
+    nodes.reserve(this->_size + other._size);
+
+    auto mine = leftmost(_root);
+    auto it = theirs.begin();
+    while (mine && it != theirs.end()) {
+        if (_compare(mine->data, (*it)->data)) {
+            nodes.push_back(mine);
+            mine = next(mine);
+        } else if (_compare((*it)->data, mine->data)) {
+            nodes.push_back(*it++);
+        } else {
+            other.destroy_node(*it++);
+        }
+    }
+    for (; mine; mine = next(mine))
+        nodes.push_back(mine);
+    nodes.insert(nodes.end(), it, theirs.end());
+
+    build(nodes, 0, nodes.size(), nullptr, _root);
+    this->_size = nodes.size();
+    other._root = nullptr;
+    other._size = 0;
+}
+
+
+} // end namespace
+
+#endif /* avl_tree_h */
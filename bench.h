@@ -0,0 +1,28 @@
+/*
+ File:   bench.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Timing helpers shared by the bench_*.cc programs. Not part of the
+    library.
+
+ Implementation:
+  - time_ms runs a callable once under steady_clock and returns the
+    elapsed wall time in milliseconds.
+ */
+
+
+#ifndef bench_h
+#define bench_h
+
+#include <chrono>  // steady_clock, duration
+
+
+template <class F>
+double time_ms(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif /* bench_h */
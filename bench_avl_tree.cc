@@ -0,0 +1,83 @@
+#include "avl_tree.h"
+#include "redblack_tree.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+// redblack_tree compares through a std::function, so std::set (also
+// red-black) is listed too as the fair comparison of tree shape.
+int main() {
+    const std::size_t n = 1000000;
+    std::mt19937 rng(3);
+    std::vector<int> keys(n), probes(n), sorted;
+    for (auto& k : keys)
+        k = static_cast<int>(rng() >> 1);
+    for (auto& p : probes)
+        p = rng() % 100 ? keys[rng() % n] : static_cast<int>(rng() >> 1);
+    sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+
+    ads::avl_tree<int> avl;
+    ads::ranked_avl_tree<int> ranked;
+    redblack_tree<int> rb;
+    std::set<int> set;
+    long hits = 0;
+
+    std::printf("%-20s %10s %10s %10s %10s\n", "", "avl", "ranked", "redblack", "std::set");
+
+    double a = time_ms([&]{ for (int k : keys) avl.insert(k); });
+    double b = time_ms([&]{ for (int k : keys) ranked.insert(k); });
+    double c = time_ms([&]{ for (int k : keys) rb.push(k); });
+    double d = time_ms([&]{ for (int k : keys) set.insert(k); });
+    std::printf("%-20s %10.2f %10.2f %10.2f %10.2f\n", "insert random ms", a, b, c, d);
+
+    std::printf("%-20s %10zu %10zu %10zu %10s\n", "height", avl.height(), ranked.height(), rb.height(), "-");
+
+    // 99% of probes hit.
+    a = time_ms([&]{ for (int p : probes) hits += avl.has(p); });
+    b = time_ms([&]{ for (int p : probes) hits += ranked.has(p); });
+    c = time_ms([&]{ for (int p : probes) hits += rb.has(p); });
+    d = time_ms([&]{ for (int p : probes) hits += set.count(p); });
+    std::printf("%-20s %10.2f %10.2f %10.2f %10.2f\n", "lookup Mops/s", n / a / 1e3, n / b / 1e3, n / c / 1e3, n / d / 1e3);
+
+    // 99% reads, 1% inserts of fresh keys.
+    std::vector<int> fresh(n / 100);
+    for (auto& f : fresh)
+        f = -static_cast<int>(rng() >> 1) - 1;
+    auto mixed = [&](auto lookup, auto insert) {
+        return time_ms([&]{
+            for (std::size_t i = 0; i < n; ++i) {
+                if (i % 100 == 99)
+                    insert(fresh[i / 100]);
+                else
+                    hits += lookup(probes[i]);
+            }
+        });
+    };
+    a = mixed([&](int k){ return avl.has(k); }, [&](int k){ avl.insert(k); });
+    b = mixed([&](int k){ return ranked.has(k); }, [&](int k){ ranked.insert(k); });
+    c = mixed([&](int k){ return rb.has(k); }, [&](int k){ rb.push(k); });
+    d = mixed([&](int k){ return set.count(k); }, [&](int k){ set.insert(k); });
+    std::printf("%-20s %10.2f %10.2f %10.2f %10.2f\n", "99/1 mix Mops/s", n / a / 1e3, n / b / 1e3, n / c / 1e3, n / d / 1e3);
+
+    b = time_ms([&]{ for (std::size_t i = 0; i < n; ++i) hits += ranked[rng() % ranked.size()]; });
+    std::printf("%-20s %10s %10.2f %10s %10s\n", "get(rank) Mops/s", "n/a", n / b / 1e3, "n/a", "n/a");
+
+    // Sequential keys: the height gap is widest on sorted input.
+    ads::avl_tree<int> avl_sorted;
+    redblack_tree<int> rb_sorted;
+    for (int k : sorted) {
+        avl_sorted.insert(k);
+        rb_sorted.push(k);
+    }
+    std::printf("%-20s %10zu %10s %10zu %10s\n", "height (sorted)", avl_sorted.height(), "-", rb_sorted.height(), "-");
+
+    a = time_ms([&]{ for (int k : keys) avl.erase(k); });
+    std::printf("%-20s %10.2f\n", "erase random ms", a);
+
+    return hits == 42;
+}
@@ -0,0 +1,86 @@
+#include "btree.h"
+#include "redblack_tree.h"
+#include "bench.h"
+
+#include <malloc.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+// Heap bytes in use, allocator overhead included.
+static std::size_t heap_bytes() {
+    return mallinfo2().uordblks;
+}
+
+// A comparator the SIMD search does not recognise, to measure the binary
+// search fallback.
+struct plain_less {
+    bool operator()(int a, int b) const { return a < b; }
+};
+
+template <class Set, class Insert>
+std::size_t build(Set& set, const std::vector<int>& keys, Insert insert, double& ms) {
+    auto before = heap_bytes();
+    ms = time_ms([&]{ for (int k : keys) insert(set, k); });
+    return heap_bytes() - before;
+}
+
+template <class Set, class Has>
+double lookup_ns(const Set& set, const std::vector<int>& probes, Has has, long& hits) {
+    return time_ms([&]{ for (int p : probes) hits += has(set, p); }) * 1e6 / probes.size();
+}
+
+int main() {
+    const std::size_t n = 2000000;
+    std::mt19937 rng(7);
+    std::vector<int> keys(n), probes(n);
+    for (auto& k : keys)
+        k = static_cast<int>(rng() >> 1);
+    for (auto& p : probes)
+        p = keys[rng() % n];
+    long hits = 0;
+
+    std::printf("%-16s %12s %14s %14s\n", "", "insert ms", "bytes/key", "lookup ns");
+
+    double ms;
+    {
+        ads::btree_set<int> bt;
+        auto bytes = build(bt, keys, [](auto& s, int k){ s.insert(k); }, ms);
+        auto ns = lookup_ns(bt, probes, [](auto& s, int k){ return s.has(k); }, hits);
+        std::printf("%-16s %12.1f %14.2f %14.1f   (height %u)\n", "btree_set", ms, double(bytes) / bt.size(), ns, bt.height());
+    }
+    {
+        ads::btree_set<int, plain_less> bt;
+        auto bytes = build(bt, keys, [](auto& s, int k){ s.insert(k); }, ms);
+        auto ns = lookup_ns(bt, probes, [](auto& s, int k){ return s.has(k); }, hits);
+        std::printf("%-16s %12.1f %14.2f %14.1f\n", "btree (binary)", ms, double(bytes) / bt.size(), ns);
+    }
+    {
+        auto sorted = keys;
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        ads::btree_set<int> bt;
+        auto before = heap_bytes();
+        ms = time_ms([&]{ bt.bulk_load(sorted.begin(), sorted.end()); });
+        auto bytes = heap_bytes() - before;
+        auto ns = lookup_ns(bt, probes, [](auto& s, int k){ return s.has(k); }, hits);
+        std::printf("%-16s %12.1f %14.2f %14.1f   (bulk load of sorted keys)\n", "btree bulk", ms, double(bytes) / bt.size(), ns);
+    }
+    {
+        redblack_tree<int> rb;
+        auto bytes = build(rb, keys, [](auto& s, int k){ s.push(k); }, ms);
+        auto ns = lookup_ns(rb, probes, [](auto& s, int k){ return s.has(k); }, hits);
+        std::printf("%-16s %12.1f %14.2f %14.1f\n", "redblack_tree", ms, double(bytes) / rb.size(), ns);
+    }
+    {
+        std::set<int> set;
+        auto bytes = build(set, keys, [](auto& s, int k){ s.insert(k); }, ms);
+        auto ns = lookup_ns(set, probes, [](auto& s, int k){ return s.count(k); }, hits);
+        std::printf("%-16s %12.1f %14.2f %14.1f\n", "std::set", ms, double(bytes) / set.size(), ns);
+    }
+
+    return hits == 42;
+}
@@ -0,0 +1,90 @@
+#include "flat_hash_map.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// The baseline: std::unordered_map behind a mutex.
+class locked_map {
+public:
+    bool find(int k, int& v)
+    {
+        std::lock_guard<std::mutex> g(_lock);
+        auto it = _map.find(k);
+        if (it == _map.end())
+            return false;
+        v = it->second;
+        return true;
+    }
+    bool assign(int k, int v)
+    {
+        std::lock_guard<std::mutex> g(_lock);
+        auto result = _map.insert({k, v});
+        result.first->second = v;
+        return result.second;
+    }
+    bool erase(int k) { std::lock_guard<std::mutex> g(_lock); return _map.erase(k) == 1; }
+
+private:
+    std::mutex _lock;
+    std::unordered_map<int, int> _map;
+};
+
+// Each thread performs a mix of lookups and updates on a shared key range.
+template <class Map>
+double run(Map& map, unsigned threads, int ops, unsigned read_percent, int range, std::atomic<long>& sink) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]{
+            std::mt19937 rng(t + 1);
+            int v = 0;
+            long hits = 0;
+            for (int i = 0; i < ops; ++i) {
+                int k = static_cast<int>(rng() % range);
+                auto dice = rng() % 100;
+                if (dice < read_percent)
+                    hits += map.find(k, v) ? v : 0;
+                else if (dice % 2)
+                    map.assign(k, i);
+                else
+                    map.erase(k);
+            }
+            sink += hits;
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ops * threads / secs / 1e6;
+}
+
+int main() {
+    const int range = 1 << 20, ops = 200000;
+    std::atomic<long> sink{0};
+    std::printf("reads%%  threads  mutex Mops/s  sharded Mops/s\n");
+
+    for (unsigned reads : {50u, 90u, 99u}) {
+        for (unsigned threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+            locked_map locked;
+            ads::concurrent_flat_hash_map<int, int> sharded;
+            for (int k = 0; k < range; k += 2) {
+                locked.assign(k, k);
+                sharded.assign(k, k);
+            }
+
+            double a = run(locked, threads, ops, reads, range, sink);
+            double b = run(sharded, threads, ops, reads, range, sink);
+            std::printf("%6u  %7u  %12.2f  %14.2f\n", reads, threads, a, b);
+        }
+    }
+    std::printf("(%u hardware threads)\n", std::thread::hardware_concurrency());
+    return sink == 0;
+}
@@ -0,0 +1,68 @@
+#include "skiplist.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// The baseline: the sequential skiplist behind a mutex.
+class locked_skiplist {
+public:
+    bool has(int k) { std::lock_guard<std::mutex> g(_lock); return _list.has(k); }
+    bool insert(int k) { std::lock_guard<std::mutex> g(_lock); return _list.insert(k); }
+    bool erase(int k) { std::lock_guard<std::mutex> g(_lock); return _list.erase(k); }
+
+private:
+    std::mutex _lock;
+    ads::skiplist<int> _list;
+};
+
+// Each thread performs a mix of lookups and updates on a shared key range.
+template <class Set>
+double run(Set& set, unsigned threads, int ops, unsigned read_percent, int range) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]{
+            std::mt19937 rng(t + 1);
+            for (int i = 0; i < ops; ++i) {
+                int k = static_cast<int>(rng() % range);
+                auto dice = rng() % 100;
+                if (dice < read_percent)
+                    set.has(k);
+                else if (dice % 2)
+                    set.insert(k);
+                else
+                    set.erase(k);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ops * threads / secs / 1e6;
+}
+
+int main() {
+    const int range = 1 << 20, ops = 200000;
+    std::printf("reads%%  threads  mutex Mops/s  lock-free Mops/s\n");
+
+    for (unsigned reads : {50u, 90u, 99u}) {
+        for (unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+            locked_skiplist locked;
+            ads::concurrent_skiplist<int> lock_free;
+            for (int k = 0; k < range; k += 2) {
+                locked.insert(k);
+                lock_free.insert(k);
+            }
+
+            double a = run(locked, threads, ops, reads, range);
+            double b = run(lock_free, threads, ops, reads, range);
+            std::printf("%6u  %7u  %12.2f  %16.2f\n", reads, threads, a, b);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include "stack.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The baseline: a single-threaded ads::stack behind a mutex.
+class locked_stack {
+public:
+    void push(int v) {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stack.push(v);
+    }
+
+    bool try_pop(int& out) {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (_stack.empty())
+            return false;
+        out = _stack.pop();
+        return true;
+    }
+
+private:
+    std::mutex _lock;
+    ads::stack<int> _stack;
+};
+
+// Each thread does push/pop pairs, the free list pattern.
+template <class Stack>
+double run(Stack& s, unsigned threads, int ops) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&]{
+            int v;
+            for (int i = 0; i < ops; ++i) {
+                s.push(i);
+                s.try_pop(v);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return 2.0 * ops * threads / secs / 1e6;
+}
+
+int main() {
+    const int ops = 1000000;
+    std::printf("double-width CAS: %s\n", ads::concurrent_stack<int>::double_width_cas() ? "yes" : "no");
+    std::printf("threads  mutex Mops/s  treiber Mops/s  elimination Mops/s\n");
+
+    for (unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+        locked_stack locked;
+        ads::concurrent_stack<int> plain(0);
+        ads::concurrent_stack<int> eliminating(2 * threads);
+
+        double a = run(locked, threads, ops);
+        double b = run(plain, threads, ops);
+        double c = run(eliminating, threads, ops);
+        std::printf("%7u  %12.2f  %14.2f  %18.2f\n", threads, a, b, c);
+    }
+}
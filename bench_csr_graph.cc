@@ -0,0 +1,71 @@
+#include "csr_graph.h"
+#include "bench.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+typedef ads::csr_graph<> graph;
+
+// Graph500-style RMAT edges: each edge picks a quadrant of the adjacency
+// matrix scale times, with probabilities a, b, c and 1 - a - b - c.
+static std::vector<graph::edge_type> rmat(unsigned scale, std::size_t edge_factor, std::mt19937_64& rng) {
+    const double a = 0.57, b = 0.19, c = 0.19;
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::vector<graph::edge_type> edges((std::size_t(1) << scale) * edge_factor);
+    for (auto& e : edges) {
+        std::uint32_t from = 0, to = 0;
+        for (unsigned bit = 0; bit < scale; ++bit) {
+            double r = unit(rng);
+            from = (from << 1) | (r >= a + b);
+            to = (to << 1) | ((r >= a && r < a + b) || r >= a + b + c);
+        }
+        e = graph::edge_type(from, to);
+    }
+    return edges;
+}
+
+int main() {
+    std::mt19937_64 rng(7);
+    long sink = 0;
+
+    std::printf("scale  vertices      edges   build ms (seq / pool)   BFS MTEPS (seq / pool)\n");
+    for (unsigned scale : {16u, 18u, 20u}) {
+        auto edges = rmat(scale, 16, rng);
+        std::size_t n = std::size_t(1) << scale;
+        ads::thread_pool pool;
+
+        graph g;
+        double seq_build = time_ms([&]{ g = graph(n, edges, ads::graph_kind::undirected); });
+        double par_build = time_ms([&]{ g = graph(n, edges, pool, ads::graph_kind::undirected); });
+
+        // TEPS as in Graph500: input edges within the searched component,
+        // over the search time, averaged over several sources of nonzero
+        // degree.
+        double seq_ms = 0, par_ms = 0, traversed = 0;
+        int searches = 0;
+        for (std::uint32_t source = 0; searches < 8; source = static_cast<std::uint32_t>(rng() % n)) {
+            if (!g.degree(source))
+                continue;
+            std::vector<std::uint32_t> a, b;
+            seq_ms += time_ms([&]{ a = g.bfs(source); });
+            par_ms += time_ms([&]{ b = g.bfs(source, pool); });
+
+            std::size_t degrees = 0;
+            for (std::uint32_t v = 0; v < n; ++v)
+                if (b[v] != graph::none)
+                    degrees += g.degree(v);
+            traversed += degrees / 2.0;
+            sink += a[source] + b[source];
+            ++searches;
+        }
+
+        std::printf("%5u  %8zu  %9zu   %8.1f / %-8.1f       %8.1f / %-8.1f\n", scale, n, g.edges(), seq_build, par_build,
+                    traversed / seq_ms / 1e3, traversed / par_ms / 1e3);
+    }
+
+    std::printf("(%u hardware threads)\n", std::thread::hardware_concurrency());
+    return sink == 0;
+}
@@ -0,0 +1,88 @@
+#include "disk_btree.h"
+#include "btree.h"
+#include "redblack_tree.h"
+#include "bench.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef ads::disk_btree<std::int64_t, std::int64_t> index_type;
+
+int main() {
+    const std::size_t n = 1000000, batch = 10000, probes = 1000000;
+    const std::string path = "/tmp/bench_disk_btree.idx";
+    unlink(path.c_str());
+
+    std::mt19937_64 rng(3);
+    std::vector<std::int64_t> keys(n), lookups(probes);
+    for (auto& k : keys)
+        k = static_cast<std::int64_t>(rng() >> 1);
+    for (auto& p : lookups)
+        p = keys[rng() % n];
+    long hits = 0;
+
+    // Building: the index commits every batch keys, so each commit pays two
+    // syncs and the copies of every page touched since the last one.
+    double ms = time_ms([&]{
+        index_type index(path);
+        for (std::size_t i = 0; i < n; ++i) {
+            index.insert(keys[i], static_cast<std::int64_t>(i));
+            if (i % batch == batch - 1)
+                index.commit();
+        }
+        index.commit();
+    });
+    std::printf("build %zu keys, commit every %zu:   disk_btree %10.1f ms\n", n, batch, ms);
+
+    // Startup: mapping the index against rebuilding an in-memory tree.
+    double open_ms = 0, first_ms = 0;
+    {
+        index_type* opened = nullptr;
+        open_ms = time_ms([&]{ opened = new index_type(path); });
+        first_ms = time_ms([&]{ for (std::size_t i = 0; i < 1000; ++i) hits += opened->has(lookups[i]); });
+        delete opened;
+    }
+    double rebuild_ms = time_ms([&]{
+        redblack_tree<std::int64_t> tree;
+        for (auto k : keys)
+            tree.push(k);
+        hits += tree.has(lookups[0]);
+    });
+    std::printf("startup to serving:  disk_btree open %8.3f ms + first 1000 lookups %8.3f ms\n", open_ms, first_ms);
+    std::printf("                     redblack_tree rebuild %8.1f ms\n", rebuild_ms);
+
+    // Warm lookups.
+    {
+        index_type index(path);
+        for (std::size_t i = 0; i < probes; ++i)
+            hits += index.has(lookups[i]);
+        double disk_ns = time_ms([&]{ for (auto p : lookups) hits += index.has(p); }) * 1e6 / probes;
+
+        ads::btree_map<std::int64_t, std::int64_t> memory;
+        redblack_tree<std::int64_t> tree;
+        for (std::size_t i = 0; i < n; ++i) {
+            memory.insert(keys[i], static_cast<std::int64_t>(i));
+            tree.push(keys[i]);
+        }
+        double btree_ns = time_ms([&]{ for (auto p : lookups) hits += memory.has(p); }) * 1e6 / probes;
+        double redblack_ns = time_ms([&]{ for (auto p : lookups) hits += tree.has(p); }) * 1e6 / probes;
+
+        std::printf("warm lookup ns:      disk_btree %6.1f   btree_map %6.1f   redblack_tree %6.1f   (height %u, %zu pages)\n",
+                    disk_ns, btree_ns, redblack_ns, index.height(), index.page_count());
+
+        // Range scans follow the leaves in order.
+        std::size_t seen = 0;
+        double scan_ms = time_ms([&]{
+            index.scan(INT64_MIN, INT64_MAX, [&](std::int64_t, std::int64_t) { ++seen; });
+        });
+        std::printf("full scan:           %zu keys in %.1f ms (%.1f M keys/s)\n", seen, scan_ms, seen / scan_ms / 1e3);
+    }
+
+    unlink(path.c_str());
+    return hits == 0;
+}
@@ -0,0 +1,102 @@
+#include "dynamic_graph.h"
+#include "disjoint_set.h"
+#include "bench.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct op {
+    bool insert;
+    std::uint32_t a, b;
+};
+
+// A stream of random edge insertions and connectivity queries over n
+// vertices, one insertion per queries_per_insert queries.
+static std::vector<op> stream(std::uint32_t n, std::size_t ops, std::size_t queries_per_insert, std::mt19937& rng) {
+    std::vector<op> s(ops);
+    for (auto& o : s)
+        o = op{rng() % (queries_per_insert + 1) == 0, static_cast<std::uint32_t>(rng() % n), static_cast<std::uint32_t>(rng() % n)};
+    return s;
+}
+
+int main() {
+    std::mt19937 rng(9);
+    long sink = 0;
+    const std::uint32_t n = 1 << 20;
+    const std::size_t ops = 1 << 23;
+
+    // The whole service: adjacency lists plus components, against bare
+    // union-find doing the same unites and finds.
+    std::printf("streaming, %u vertices, %zu ops      Mops/s: %14s %14s %14s\n", n, ops, "dynamic_graph", "disjoint_set",
+                "concurrent(1)");
+    for (std::size_t ratio : {1u, 10u, 100u}) {
+        auto s = stream(n, ops, ratio, rng);
+        ads::dynamic_graph<> g(n);
+        double graph_ms = time_ms([&]{
+            for (auto& o : s) {
+                if (o.insert)
+                    g.add_edge(o.a, o.b);
+                else
+                    sink += g.connected(o.a, o.b);
+            }
+        });
+        sink += static_cast<long>(g.components());
+
+        ads::disjoint_set ds(n);
+        double set_ms = time_ms([&]{
+            for (auto& o : s) {
+                if (o.insert)
+                    ds.unite(o.a, o.b);
+                else
+                    sink += ds.connected(o.a, o.b);
+            }
+        });
+
+        ads::concurrent_disjoint_set cs(n);
+        double concurrent_ms = time_ms([&]{
+            for (auto& o : s) {
+                if (o.insert)
+                    cs.unite(o.a, o.b);
+                else
+                    sink += cs.connected(o.a, o.b);
+            }
+        });
+
+        std::printf("  1 insert per %3zu queries                %14.1f %14.1f %14.1f\n", ratio, ops / graph_ms / 1e3,
+                    ops / set_ms / 1e3, ops / concurrent_ms / 1e3);
+    }
+
+    // The concurrent set shared by threads, each replaying its own slice
+    // of a 1-in-10 stream.
+    std::printf("\nconcurrent_disjoint_set, 1 insert per 10 queries\n threads     Mops/s\n");
+    auto s = stream(n, ops, 10, rng);
+    std::atomic<long> shared_sink(0);
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        ads::concurrent_disjoint_set cs(n);
+        double ms = time_ms([&]{
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t] {
+                    long local = 0;
+                    for (std::size_t i = t; i < s.size(); i += threads) {
+                        if (s[i].insert)
+                            cs.unite(s[i].a, s[i].b);
+                        else
+                            local += cs.connected(s[i].a, s[i].b);
+                    }
+                    shared_sink += local;
+                });
+            }
+            for (auto& w : workers)
+                w.join();
+        });
+        std::printf("%8u %10.1f\n", threads, ops / ms / 1e3);
+    }
+
+    std::printf("(%u hardware threads)\n", std::thread::hardware_concurrency());
+    return sink + shared_sink == 0;
+}
@@ -0,0 +1,60 @@
+#include "flat_hash_map.h"
+#include "bench.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+struct result {
+    double insert, hit, miss, churn;
+};
+
+// Inserts n keys, looks up n present and n absent ones, then replaces the
+// whole contents one erase + insert at a time at constant size.
+template <class Map>
+static result run(const std::vector<std::uint64_t>& keys, const std::vector<std::uint64_t>& absent, long& sink) {
+    const std::size_t n = keys.size();
+    result r;
+    Map map;
+    r.insert = time_ms([&]{ for (std::size_t i = 0; i < n; ++i) map[keys[i]] = i; }) * 1e6 / n;
+    r.hit = time_ms([&]{ for (auto k : keys) sink += map.find(k) != map.end(); }) * 1e6 / n;
+    r.miss = time_ms([&]{ for (auto k : absent) sink += map.find(k) != map.end(); }) * 1e6 / n;
+    r.churn = time_ms([&]{
+        for (std::size_t i = 0; i < n; ++i) {
+            map.erase(keys[i]);
+            map[absent[i]] = i;
+        }
+    }) * 1e6 / n;
+    sink += static_cast<long>(map.size());
+    return r;
+}
+
+int main() {
+    std::mt19937_64 rng(4);
+    long sink = 0;
+
+    std::printf("ns/op                     %10s %10s %10s %10s\n", "insert", "hit", "miss", "churn");
+    for (std::size_t n : {1000u, 100000u, 1000000u, 4000000u}) {
+        std::vector<std::uint64_t> keys(n), absent(n);
+        for (auto& k : keys)
+            k = rng() | 1;
+        for (auto& k : absent)
+            k = rng() & ~std::uint64_t(1);
+
+        // Small sizes are repeated so the timer has something to measure.
+        auto rounds = 4000000 / n;
+        result flat {0, 0, 0, 0}, stdmap {0, 0, 0, 0};
+        for (std::size_t i = 0; i < rounds; ++i) {
+            auto a = run<ads::flat_hash_map<std::uint64_t, std::uint64_t>>(keys, absent, sink);
+            auto b = run<std::unordered_map<std::uint64_t, std::uint64_t>>(keys, absent, sink);
+            flat = {flat.insert + a.insert / rounds, flat.hit + a.hit / rounds, flat.miss + a.miss / rounds, flat.churn + a.churn / rounds};
+            stdmap = {stdmap.insert + b.insert / rounds, stdmap.hit + b.hit / rounds, stdmap.miss + b.miss / rounds, stdmap.churn + b.churn / rounds};
+        }
+        std::printf("n = %8zu flat_hash_map %10.1f %10.1f %10.1f %10.1f\n", n, flat.insert, flat.hit, flat.miss, flat.churn);
+        std::printf("           unordered_map %10.1f %10.1f %10.1f %10.1f\n", stdmap.insert, stdmap.hit, stdmap.miss, stdmap.churn);
+    }
+
+    return sink == 0;
+}
@@ -0,0 +1,69 @@
+#include "indexable_list.h"
+#include "list.h"
+#include "unrolled_list.h"
+#include "bench.h"
+
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// list and unrolled_list only reach a position by walking to it.
+template <class List>
+typename List::iterator walk_to(List& l, std::size_t i) {
+    auto it = l.begin();
+    std::advance(it, i);
+    return it;
+}
+
+template <class T>
+typename ads::indexable_list<T>::iterator walk_to(ads::indexable_list<T>& l, std::size_t i) {
+    return l.nth(i);
+}
+
+// Random reads by index, then random inserts and erases at an index, each
+// timed per operation.
+template <class List>
+void run(const char* name, std::size_t n, std::size_t ops, long& sink) {
+    std::mt19937 rng(11);
+    List l;
+    for (std::size_t i = 0; i < n; ++i)
+        l.push_back(static_cast<int>(rng()));
+
+    std::vector<std::size_t> at(ops);
+    for (auto& i : at)
+        i = rng() % n;
+
+    auto read = time_ms([&] {
+        for (auto i : at)
+            sink += l[i];
+    });
+    auto edit = time_ms([&] {
+        for (auto i : at) {
+            l.insert(walk_to(l, i), static_cast<int>(i));
+            l.erase(walk_to(l, (i * 7) % n));
+        }
+    });
+    auto walk = time_ms([&] {
+        for (auto it = l.begin(); it != l.end(); ++it)
+            sink += *it;
+    });
+
+    std::printf("%-16s %9zu %12.1f %12.1f %12.2f\n", name, n,
+                read * 1e6 / ops, edit * 1e6 / (2 * ops), walk * 1e6 / n);
+}
+
+int main() {
+    long sink = 0;
+    const std::size_t ops = 5000;
+
+    std::printf("%-16s %9s %12s %12s %12s\n", "container", "n", "at ns", "edit ns", "walk ns/elem");
+    for (std::size_t n : {1000, 10000, 100000, 1000000}) {
+        run<ads::indexable_list<int>>("indexable_list", n, ops, sink);
+        if (n <= 100000) {
+            run<ads::unrolled_list<int>>("unrolled_list", n, ops, sink);
+            run<ads::list<int>>("list", n, ops, sink);
+        }
+    }
+    return sink == 0;
+}
@@ -0,0 +1,100 @@
+#include "list.h"
+#include "bench.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+const std::size_t hosts = 64;
+
+// Connection churn: a random connection is opened if it is closed, and
+// otherwise either closed or touched. An open connection is on the age
+// list, where touching moves it to the back, and on its host's list.
+struct intrusive_connection {
+    unsigned host;
+    ads::list_hook by_age;
+    ads::list_hook by_host;
+};
+
+struct listed_connection {
+    unsigned host;
+    bool open = false;
+    ads::list<listed_connection*>::iterator age{nullptr};
+    ads::list<listed_connection*>::iterator peer{nullptr};
+};
+
+double run_intrusive(std::size_t n, const std::vector<std::size_t>& picks, long& sink) {
+    std::vector<intrusive_connection> pool(n);
+    for (std::size_t i = 0; i < n; ++i)
+        pool[i].host = i % hosts;
+    ads::intrusive_list<intrusive_connection, &intrusive_connection::by_age> ages;
+    std::vector<ads::intrusive_list<intrusive_connection, &intrusive_connection::by_host>> by_host(hosts);
+
+    auto ms = time_ms([&] {
+        for (auto pick : picks) {
+            auto& c = pool[pick >> 1];
+            if (!c.by_age.is_linked()) {
+                ages.push_back(c);
+                by_host[c.host].push_back(c);
+            } else if (pick & 1) {
+                ages.unlink(c);
+                by_host[c.host].unlink(c);
+            } else {
+                ages.splice(ages.cend(), ages, ages.iterator_to(c));
+            }
+        }
+    });
+    sink += ages.size() + ages.front().host;
+    ages.clear();
+    for (auto& l : by_host)
+        l.clear();
+    return ms;
+}
+
+double run_list(std::size_t n, const std::vector<std::size_t>& picks, long& sink) {
+    std::vector<listed_connection> pool(n);
+    for (std::size_t i = 0; i < n; ++i)
+        pool[i].host = i % hosts;
+    ads::list<listed_connection*> ages;
+    std::vector<ads::list<listed_connection*>> by_host(hosts);
+
+    auto ms = time_ms([&] {
+        for (auto pick : picks) {
+            auto& c = pool[pick >> 1];
+            auto& peers = by_host[c.host];
+            if (!c.open) {
+                ages.push_back(&c);
+                c.age = ages.end().prev();
+                peers.push_back(&c);
+                c.peer = peers.end().prev();
+                c.open = true;
+            } else if (pick & 1) {
+                ages.erase(c.age);
+                peers.erase(c.peer);
+                c.open = false;
+            } else {
+                ages.splice(ages.cend(), ages, c.age);
+            }
+        }
+    });
+    sink += ages.size() + ages.front()->host;
+    return ms;
+}
+
+int main() {
+    long sink = 0;
+    const std::size_t steps = 4000000;
+
+    std::printf("%9s %18s %18s\n", "conns", "intrusive ns/op", "ads::list ns/op");
+    for (std::size_t n : {1000, 100000, 1000000}) {
+        std::mt19937 rng(7);
+        std::vector<std::size_t> picks(steps);
+        for (auto& pick : picks)
+            pick = rng() % (2 * n);
+
+        auto intrusive = run_intrusive(n, picks, sink);
+        auto listed = run_list(n, picks, sink);
+        std::printf("%9zu %18.1f %18.1f\n", n, intrusive * 1e6 / steps, listed * 1e6 / steps);
+    }
+    return sink == 0;
+}
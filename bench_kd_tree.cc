@@ -0,0 +1,122 @@
+#include "kd_tree.h"
+#include "bench.h"
+
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// The baseline: every point's distance, four at a time, from coordinates
+// stored one array per dimension and padded to a multiple of four with
+// points too far away to win.
+template <std::size_t Dim>
+class brute_force {
+
+public:
+    explicit brute_force(const std::vector<std::array<float, Dim>>& points)
+        : _n(points.size())
+    {
+        auto padded = (_n + 3) / 4 * 4;
+        for (std::size_t d = 0; d < Dim; ++d) {
+            _coordinates[d].assign(padded, 1e30f);
+            for (std::size_t i = 0; i < _n; ++i)
+                _coordinates[d][i] = points[i][d];
+        }
+    }
+
+    std::size_t nearest(const std::array<float, Dim>& q) const {
+        const std::size_t padded = _coordinates[0].size();
+#ifdef __SSE2__
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i best_index = _mm_set1_epi32(-1), index = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i four = _mm_set1_epi32(4);
+        for (std::size_t i = 0; i < padded; i += 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (std::size_t d = 0; d < Dim; ++d) {
+                __m128 diff = _mm_sub_ps(_mm_loadu_ps(&_coordinates[d][i]), _mm_set1_ps(q[d]));
+                sum = _mm_add_ps(sum, _mm_mul_ps(diff, diff));
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(sum, best));
+            best = _mm_min_ps(sum, best);
+            best_index = _mm_or_si128(_mm_and_si128(closer, index), _mm_andnot_si128(closer, best_index));
+            index = _mm_add_epi32(index, four);
+        }
+        float lanes[4];
+        std::int32_t lane_index[4];
+        _mm_storeu_ps(lanes, best);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_index), best_index);
+        int winner = 0;
+        for (int l = 1; l < 4; ++l)
+            if (lanes[l] < lanes[winner])
+                winner = l;
+        return static_cast<std::size_t>(lane_index[winner]);
+#else
+        std::size_t winner = 0;
+        float best = FLT_MAX;
+        for (std::size_t i = 0; i < padded; ++i) {
+            float sum = 0;
+            for (std::size_t d = 0; d < Dim; ++d)
+                sum += (_coordinates[d][i] - q[d]) * (_coordinates[d][i] - q[d]);
+            if (sum < best) {
+                best = sum;
+                winner = i;
+            }
+        }
+        return winner;
+#endif
+    }
+
+private:
+    std::size_t _n;
+    std::vector<float> _coordinates[Dim];
+};
+
+template <std::size_t Dim>
+static void run(std::mt19937& rng, ads::thread_pool& pool, long& sink) {
+    typedef ads::kd_tree<Dim> tree;
+    std::uniform_real_distribution<float> unit(0, 1);
+
+    for (std::size_t n : {1000u, 10000u, 100000u, 1000000u}) {
+        std::vector<typename tree::point_type> points(n), queries(20000);
+        for (auto& p : points)
+            for (auto& x : p)
+                x = unit(rng);
+        for (auto& p : queries)
+            for (auto& x : p)
+                x = unit(rng);
+
+        tree t;
+        double build = time_ms([&]{ t = tree(points); });
+        double parallel_build = time_ms([&]{ t = tree(points, pool); });
+        brute_force<Dim> scan(points);
+
+        double nn = time_ms([&]{ for (auto& q : queries) sink += static_cast<long>(t.nearest(q)); });
+        double knn = time_ms([&]{ for (auto& q : queries) sink += static_cast<long>(t.nearest(q, 10).back().second); });
+        // The scan gets fewer queries at large n to keep the run short.
+        std::size_t scanned = std::min<std::size_t>(queries.size(), 2000000000u / (n * Dim));
+        double brute = time_ms([&]{
+            for (std::size_t i = 0; i < scanned; ++i)
+                sink += static_cast<long>(scan.nearest(queries[i]));
+        });
+
+        std::printf("%3zu %8zu %9.1f / %-9.1f %10.2f %10.2f %12.2f\n", Dim, n, build, parallel_build,
+                    nn * 1e3 / queries.size(), knn * 1e3 / queries.size(), brute * 1e3 / scanned);
+    }
+}
+
+int main() {
+    std::mt19937 rng(11);
+    ads::thread_pool pool;
+    long sink = 0;
+
+    std::printf("dim        n  build ms (seq / pool)   1-NN us  10-NN us  scan 1-NN us\n");
+    run<2>(rng, pool, sink);
+    run<3>(rng, pool, sink);
+    run<8>(rng, pool, sink);
+
+    return sink == 0;
+}
@@ -0,0 +1,73 @@
+#include "list.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Rebuilding a list per request: fill it from a range of values, walk it
+// once, and clear it. The bulk build takes the values through a source
+// list's iterators; the per-node build pushes them one at a time.
+int main() {
+    long sink = 0;
+    std::mt19937 rng(3);
+
+    std::printf("%9s %7s %-10s %9s %9s %9s\n", "n", "rounds", "build", "build ns", "walk ns", "clear ns");
+    for (std::size_t n : {100u, 10000u, 1000000u}) {
+        std::size_t rounds = 4000000 / n;
+        ads::list<int> source;
+        for (std::size_t i = 0; i < n; ++i)
+            source.push_back(static_cast<int>(rng()));
+
+        for (int bulk = 1; bulk >= 0; --bulk) {
+            ads::list<int> l;
+            double build = 0, walk = 0, clear = 0;
+            for (std::size_t r = 0; r < rounds; ++r) {
+                build += time_ms([&] {
+                    if (bulk)
+                        l.assign(source.begin(), source.end());
+                    else
+                        for (auto x : source)
+                            l.push_back(x);
+                });
+                walk += time_ms([&] {
+                    for (auto x : l)
+                        sink += x;
+                });
+                clear += time_ms([&] { l.clear(); });
+            }
+            auto per = 1e6 / (rounds * n);
+            std::printf("%9zu %7zu %-10s %9.1f %9.2f %9.2f\n", n, rounds, bulk ? "block" : "per node",
+                        build * per, walk * per, clear * per);
+        }
+    }
+
+    // merge_k splices one node at a time, so block bookkeeping must stay
+    // cheap per splice when the lists were built in bulk.
+    std::printf("\n%9s %-10s %9s\n", "k", "build", "merge ms");
+    for (std::size_t k : {250u, 1000u, 4000u}) {
+        for (int bulk = 1; bulk >= 0; --bulk) {
+            std::vector<ads::list<int>> lists(k);
+            for (auto& l : lists) {
+                std::vector<int> values(64);
+                for (auto& v : values)
+                    v = static_cast<int>(rng() % 1000000);
+                std::sort(values.begin(), values.end());
+                ads::list<int> sorted;
+                for (auto v : values)
+                    sorted.push_back(v);
+                if (bulk)
+                    l.assign(sorted.begin(), sorted.end());
+                else
+                    l.swap(sorted);
+            }
+
+            ads::list<int> merged;
+            double ms = time_ms([&] { merged = ads::merge_k(lists.begin(), lists.end()); });
+            sink += merged.size();
+            std::printf("%9zu %-10s %9.2f\n", k, bulk ? "block" : "per node", ms);
+        }
+    }
+    return sink == 0;
+}
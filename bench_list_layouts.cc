@@ -0,0 +1,98 @@
+#include "list.h"
+#include "bench.h"
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Counts what the lists ask for, and what glibc malloc would spend on it:
+// an 8-byte header, rounded up to 16 bytes, at least 32.
+struct usage {
+    static std::size_t bytes, footprint;
+    static void reset() { bytes = footprint = 0; }
+};
+std::size_t usage::bytes, usage::footprint;
+
+template <class T>
+struct counting_allocator : std::allocator<T> {
+    template <class U>
+    struct rebind { typedef counting_allocator<U> other; };
+
+    T* allocate(std::size_t n)
+    {
+        auto size = n * sizeof(T);
+        usage::bytes += size;
+        usage::footprint += std::max<std::size_t>(32, (size + 8 + 15) / 16 * 16);
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+template <class Layout>
+using layout_list = ads::list<long, counting_allocator<long>, Layout>;
+
+// Backwards walks, for the layouts that have them.
+template <class List>
+double walk_back(List& l, int passes, long& sink, std::true_type) {
+    return time_ms([&] {
+        for (int p = 0; p < passes; ++p)
+            for (auto it = l.rbegin(); it != l.rend(); ++it)
+                sink += *it;
+    });
+}
+
+template <class List>
+double walk_back(List&, int, long&, std::false_type) {
+    return 0;
+}
+
+template <class Layout, bool Backwards>
+void run(const char* name, std::size_t n, long& sink) {
+    typedef layout_list<Layout> list;
+    const int passes = 10;
+
+    usage::reset();
+    list l;
+    auto build = time_ms([&] {
+        for (std::size_t i = 0; i < n; ++i)
+            l.push_back(static_cast<long>(i));
+    });
+    double bytes = static_cast<double>(usage::bytes) / n;
+    double footprint = static_cast<double>(usage::footprint) / n;
+
+    auto walk = time_ms([&] {
+        for (int p = 0; p < passes; ++p)
+            for (auto it = l.begin(); it != l.end(); ++it)
+                sink += *it;
+    });
+    auto back = walk_back(l, passes, sink, std::integral_constant<bool, Backwards>());
+
+    // Queue use: take from the front, put at the back.
+    auto queue = time_ms([&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            sink += l.front();
+            l.pop_front();
+            l.push_back(static_cast<long>(i));
+        }
+    });
+
+    if (Backwards)
+        std::printf("%9zu %-14s %7.1f %9.1f %9.1f %9.2f %9.2f %9.1f\n", n, name, bytes, footprint,
+                    build * 1e6 / n, walk * 1e6 / (passes * n), back * 1e6 / (passes * n), queue * 1e6 / n);
+    else
+        std::printf("%9zu %-14s %7.1f %9.1f %9.1f %9.2f %9s %9.1f\n", n, name, bytes, footprint,
+                    build * 1e6 / n, walk * 1e6 / (passes * n), "-", queue * 1e6 / n);
+}
+
+int main() {
+    long sink = 0;
+
+    std::printf("%9s %-14s %7s %9s %9s %9s %9s %9s\n", "n", "layout", "B/elem", "malloc B",
+                "push ns", "walk ns", "back ns", "queue ns");
+    for (std::size_t n : {10000u, 1000000u, 4000000u}) {
+        run<ads::doubly_linked, true>("doubly_linked", n, sink);
+        run<ads::singly_linked, false>("singly_linked", n, sink);
+        run<ads::xor_linked, true>("xor_linked", n, sink);
+    }
+    return sink == 0;
+}
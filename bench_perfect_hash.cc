@@ -0,0 +1,75 @@
+#include "perfect_hash.h"
+#include "flat_hash_map.h"
+#include "bench.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+int main() {
+    std::mt19937_64 rng(6);
+    long sink = 0;
+
+    // The density trades build time for space.
+    {
+        const std::size_t n = 1000000;
+        std::unordered_set<std::uint64_t> unique;
+        while (unique.size() < n)
+            unique.insert(rng());
+        std::vector<std::uint64_t> keys(unique.begin(), unique.end());
+
+        std::printf("n = %zu        build ms   bits/key\n", n);
+        for (double c : {3.0, 4.0, 5.0, 6.0, 8.0}) {
+            ads::perfect_hash<std::uint64_t> ph;
+            double ms = time_ms([&]{ ph = ads::perfect_hash<std::uint64_t>(keys.begin(), keys.end(), c); });
+            std::printf("c = %.1f          %8.1f   %8.2f\n", c, ms, ph.bits_per_key());
+            sink += static_cast<long>(ph(keys[0]));
+        }
+    }
+
+    std::printf("\n%-22s %10s %10s %10s %10s\n", "", "build ms", "hit ns", "miss ns", "MB");
+    for (std::size_t n : {100000u, 1000000u, 4000000u}) {
+        std::unordered_set<std::uint64_t> unique;
+        while (unique.size() < 2 * n)
+            unique.insert(rng());
+        std::vector<std::uint64_t> all(unique.begin(), unique.end());
+        std::vector<std::uint64_t> keys(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(n));
+        std::vector<std::uint64_t> absent(all.begin() + static_cast<std::ptrdiff_t>(n), all.end());
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> pairs;
+        for (auto k : keys)
+            pairs.emplace_back(k, k + 1);
+
+        std::vector<std::uint64_t> probes(keys), misses(absent);
+        std::shuffle(probes.begin(), probes.end(), rng);
+        std::printf("n = %zu\n", n);
+
+        ads::perfect_hash<std::uint64_t> ph;
+        double build = time_ms([&]{ ph = ads::perfect_hash<std::uint64_t>(keys.begin(), keys.end()); });
+        double hit = time_ms([&]{ for (auto k : probes) sink += static_cast<long>(ph(k)); }) * 1e6 / n;
+        std::printf("  %-20s %10.1f %10.1f %10s %10.2f\n", "perfect_hash index", build, hit, "-", ph.bytes() / 1e6);
+
+        ads::static_hash_map<std::uint64_t, std::uint64_t> fixed;
+        build = time_ms([&]{ fixed = ads::static_hash_map<std::uint64_t, std::uint64_t>(pairs.begin(), pairs.end()); });
+        hit = time_ms([&]{ for (auto k : probes) sink += static_cast<long>(*fixed.get(k)); }) * 1e6 / n;
+        double miss = time_ms([&]{ for (auto k : misses) sink += fixed.has(k); }) * 1e6 / n;
+        std::printf("  %-20s %10.1f %10.1f %10.1f %10.2f\n", "static_hash_map", build, hit, miss, fixed.bytes() / 1e6);
+
+        ads::flat_hash_map<std::uint64_t, std::uint64_t> flat;
+        build = time_ms([&]{ for (auto& kv : pairs) flat.insert(kv.first, kv.second); });
+        hit = time_ms([&]{ for (auto k : probes) sink += static_cast<long>(flat.find(k).value()); }) * 1e6 / n;
+        miss = time_ms([&]{ for (auto k : misses) sink += flat.has(k); }) * 1e6 / n;
+        std::printf("  %-20s %10.1f %10.1f %10.1f %10.2f\n", "flat_hash_map", build, hit, miss,
+                    flat.capacity() * (sizeof(std::uint64_t) * 2 + 1) / 1e6);
+
+        std::unordered_map<std::uint64_t, std::uint64_t> node;
+        build = time_ms([&]{ for (auto& kv : pairs) node.insert(kv); });
+        hit = time_ms([&]{ for (auto k : probes) sink += static_cast<long>(node.find(k)->second); }) * 1e6 / n;
+        miss = time_ms([&]{ for (auto k : misses) sink += static_cast<long>(node.count(k)); }) * 1e6 / n;
+        std::printf("  %-20s %10.1f %10.1f %10.1f %10s\n", "std::unordered_map", build, hit, miss, "-");
+    }
+
+    return sink == 0;
+}
@@ -0,0 +1,90 @@
+#include "rtree.h"
+#include "bench.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+typedef ads::rtree<2, float, unsigned> tree;
+typedef tree::box_type box;
+
+// Geo-fence-like rectangles: mostly small, clustered around a few hundred
+// centres in a 10000 x 10000 world, with a sprinkling of large ones.
+static std::vector<std::pair<box, unsigned>> fences(std::size_t n, std::mt19937& rng) {
+    std::uniform_real_distribution<float> world(0, 10000), unit(0, 1);
+    std::normal_distribution<float> spread(0, 150);
+    std::vector<std::array<float, 2>> centres(300);
+    for (auto& c : centres)
+        c = {{world(rng), world(rng)}};
+
+    std::vector<std::pair<box, unsigned>> result(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        auto& c = centres[rng() % centres.size()];
+        float w = unit(rng) < 0.01f ? 500 * unit(rng) : 1 + 20 * unit(rng), h = w * (0.5f + unit(rng));
+        float x = c[0] + spread(rng), y = c[1] + spread(rng);
+        result[i] = {box{{{x, y}}, {{x + w, y + h}}}, static_cast<unsigned>(i)};
+    }
+    return result;
+}
+
+int main() {
+    std::mt19937 rng(13);
+    std::size_t sink = 0;
+
+    std::printf("%8s %-8s %10s %12s %12s %12s\n", "n", "tree", "build ms", "query", "queries/s", "candidates");
+    for (std::size_t n : {100000u, 1000000u}) {
+        auto entries = fences(n, rng);
+        // Probes near the fences: points, and boxes of about a block.
+        std::vector<box> points(200000), blocks(200000);
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            auto& near = entries[rng() % n].first;
+            float x = near.low[0] + static_cast<float>(rng() % 100) - 50, y = near.low[1] + static_cast<float>(rng() % 100) - 50;
+            points[i] = box{{{x, y}}, {{x, y}}};
+            blocks[i] = box{{{x, y}}, {{x + 50, y + 50}}};
+        }
+
+        tree packed, grown;
+        double str_ms = time_ms([&]{ packed = tree(entries); });
+        double insert_ms = time_ms([&]{ for (auto& e : entries) grown.insert(e.first, e.second); });
+
+        auto run = [&](const char* name, double build, const tree& t, const char* kind, const std::vector<box>& probes) {
+            std::size_t candidates = 0;
+            double ms = time_ms([&]{
+                for (auto& p : probes)
+                    candidates += t.query(p, [&](const box&, unsigned v) { sink += v; });
+            });
+            std::printf("%8zu %-8s %10.1f %12s %12.0f %12.1f\n", n, name, build, kind, probes.size() / ms * 1e3,
+                        double(candidates) / probes.size());
+        };
+        run("STR", str_ms, packed, "point", points);
+        run("STR", str_ms, packed, "50x50 box", blocks);
+        run("R*", insert_ms, grown, "point", points);
+        run("R*", insert_ms, grown, "50x50 box", blocks);
+
+        // Churn: replace a tenth of the fences one at a time.
+        double churn_ms = time_ms([&]{
+            for (std::size_t i = 0; i < n / 10; ++i) {
+                auto& e = entries[i];
+                packed.erase(e.first, e.second);
+                e.first.low[0] += 1;
+                e.first.high[0] += 1;
+                packed.insert(e.first, e.second);
+            }
+        });
+        std::printf("%8zu %-8s   churn: %.0f erase+insert pairs/s, height %u, %zu nodes\n", n, "STR", n / 10 / churn_ms * 1e3,
+                    packed.height(), packed.nodes());
+
+        // The scan every tree is meant to beat, on a few probes.
+        if (n <= 1000000) {
+            std::size_t probes = 200;
+            double ms = time_ms([&]{
+                for (std::size_t i = 0; i < probes; ++i)
+                    for (auto& e : entries)
+                        sink += e.first.overlaps(points[i]);
+            });
+            std::printf("%8zu %-8s %10s %12s %12.0f %12zu\n", n, "scan", "-", "point", probes / ms * 1e3, n);
+        }
+    }
+
+    return sink == 0;
+}
@@ -0,0 +1,93 @@
+#include "shortest_path.h"
+#include "bench.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+typedef ads::csr_graph<> graph;
+
+// A road network stand-in: a side x side grid of two-way streets with a
+// few percent missing, travel times of 100 to 300 per block, and every
+// 32nd row and column a highway at 30 to 60 per block. Like real roads it
+// has low degree, high diameter and a wide spread of weights.
+static graph roads(std::uint32_t side, std::mt19937& rng) {
+    std::vector<graph::edge_type> edges;
+    std::vector<std::uint32_t> weights;
+    auto street = [&](std::uint32_t a, std::uint32_t b, bool highway) {
+        if (!highway && rng() % 100 < 3)
+            return;
+        edges.emplace_back(a, b);
+        weights.push_back(highway ? 30 + rng() % 31 : 100 + rng() % 201);
+    };
+    for (std::uint32_t y = 0; y < side; ++y) {
+        for (std::uint32_t x = 0; x < side; ++x) {
+            auto v = y * side + x;
+            if (x + 1 < side)
+                street(v, v + 1, y % 32 == 0);
+            if (y + 1 < side)
+                street(v, v + side, x % 32 == 0);
+        }
+    }
+    return graph(std::size_t(side) * side, edges, weights, ads::graph_kind::undirected);
+}
+
+int main() {
+    std::mt19937 rng(5);
+    ads::thread_pool pool;
+    std::uint64_t sink = 0;
+
+    std::printf("vertices      edges  %-28s %10s %10s\n", "algorithm", "ms", "Medges/s");
+    for (std::uint32_t side : {256u, 1024u, 2048u}) {
+        auto g = roads(side, rng);
+        const int sources = 3;
+        std::vector<std::uint32_t> from(sources);
+        for (auto& s : from)
+            s = static_cast<std::uint32_t>(rng() % g.vertices());
+
+        auto report = [&](const char* name, double ms) {
+            std::printf("%8zu %10zu  %-28s %10.1f %10.1f\n", g.vertices(), g.edges(), name, ms / sources,
+                        double(g.edges()) * sources / ms / 1e3);
+        };
+        double ms = 0;
+
+        ms = time_ms([&]{ for (auto s : from) sink += ads::dijkstra(g, s).distance[0]; });
+        report("dijkstra (4-ary, dec-key)", ms);
+        ms = time_ms([&]{ for (auto s : from) sink += ads::dijkstra_radix(g, s).distance[0]; });
+        report("dijkstra_radix", ms);
+        for (std::uint64_t delta : {100u, 400u, 1600u}) {
+            char name[64];
+            std::snprintf(name, sizeof name, "delta_stepping delta=%llu", static_cast<unsigned long long>(delta));
+            ms = time_ms([&]{ for (auto s : from) sink += ads::delta_stepping(g, s, delta, pool).distance[0]; });
+            report(name, ms);
+        }
+
+        // Point to point: Dijkstra stopped at the target against A* with
+        // the Manhattan distance at highway speed as its lower bound.
+        std::vector<std::uint32_t> to(sources);
+        for (auto& t : to)
+            t = static_cast<std::uint32_t>(rng() % g.vertices());
+        auto manhattan = [side](std::uint32_t a, std::uint32_t b) {
+            return std::uint64_t(30) * (std::uint64_t(std::abs(int(a % side) - int(b % side)))
+                                        + std::uint64_t(std::abs(int(a / side) - int(b / side))));
+        };
+        ms = time_ms([&]{
+            for (int i = 0; i < sources; ++i)
+                sink += ads::a_star(g, from[i], to[i], [](std::uint32_t) { return 0; }).distance[to[i]];
+        });
+        report("point to point, no heuristic", ms);
+        ms = time_ms([&]{
+            for (int i = 0; i < sources; ++i) {
+                auto t = to[i];
+                sink += ads::a_star(g, from[i], t, [&](std::uint32_t v) { return manhattan(v, t); }).distance[t];
+            }
+        });
+        report("point to point, A*", ms);
+    }
+
+    std::printf("(%u hardware threads; Medges/s counts every edge once per search)\n", std::thread::hardware_concurrency());
+    return sink == 0;
+}
@@ -0,0 +1,47 @@
+#include "skiplist.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+int main() {
+    const std::size_t n = 1000000;
+    std::mt19937 rng(3);
+    std::vector<int> keys(n), probes(n), ascending;
+    for (auto& k : keys)
+        k = static_cast<int>(rng());
+    for (auto& p : probes)
+        p = keys[rng() % n];
+    ascending = probes;
+    std::sort(ascending.begin(), ascending.end());
+
+    ads::skiplist<int> sl;
+    std::set<int> set;
+    long hits = 0;
+
+    std::printf("%-22s %12s %12s\n", "", "skiplist ms", "std::set ms");
+
+    double a = time_ms([&]{ for (int k : keys) sl.insert(k); });
+    double b = time_ms([&]{ for (int k : keys) set.insert(k); });
+    std::printf("%-22s %12.2f %12.2f\n", "insert random", a, b);
+
+    a = time_ms([&]{ for (int p : probes) hits += sl.has(p); });
+    b = time_ms([&]{ for (int p : probes) hits += set.count(p); });
+    std::printf("%-22s %12.2f %12.2f\n", "lookup random", a, b);
+
+    a = time_ms([&]{ for (int p : ascending) hits += sl.has(p); });
+    b = time_ms([&]{ for (int p : ascending) hits += set.count(p); });
+    std::printf("%-22s %12.2f %12.2f\n", "lookup ascending", a, b);
+
+    a = time_ms([&]{ for (std::size_t i = 0; i < n; ++i) hits += sl.get(rng() % sl.size()); });
+    std::printf("%-22s %12.2f %12s\n", "get(rank) random", a, "n/a");
+
+    a = time_ms([&]{ for (int k : keys) sl.erase(k); });
+    b = time_ms([&]{ for (int k : keys) set.erase(k); });
+    std::printf("%-22s %12.2f %12.2f\n", "erase random", a, b);
+
+    std::printf("(checksum %ld)\n", hits);
+}
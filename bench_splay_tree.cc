@@ -0,0 +1,75 @@
+#include "splay_tree.h"
+#include "avl_tree.h"
+#include "redblack_tree.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <vector>
+
+// Probes drawn from a Zipf(s) distribution over the keys; s = 0 is
+// uniform. Key ranks are shuffled so hot keys are scattered through the
+// key space, not clustered at one end.
+std::vector<int> zipf_probes(const std::vector<int>& keys, double s, std::size_t count, std::mt19937& rng) {
+    std::vector<double> cdf(keys.size());
+    double total = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+        cdf[i] = total += 1.0 / std::pow(i + 1.0, s);
+
+    std::uniform_real_distribution<double> uniform(0, total);
+    std::vector<int> probes(count);
+    for (auto& p : probes)
+        p = keys[std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin()];
+
+    return probes;
+}
+
+int main() {
+    const std::size_t n = 1000000, lookups = 2000000;
+    std::mt19937 rng(5);
+    std::vector<int> keys(n);
+    for (auto& k : keys)
+        k = static_cast<int>(rng() >> 1);
+
+    ads::splay_tree<int> splay;
+    ads::avl_tree<int> avl;
+    redblack_tree<int> rb;
+    std::set<int> set;
+    for (int k : keys) {
+        splay.insert(k);
+        avl.insert(k);
+        rb.push(k);
+        set.insert(k);
+    }
+
+    long hits = 0;
+    std::printf("lookups, Mops/s\n%-10s %10s %10s %10s %10s\n", "zipf s", "splay", "avl", "redblack", "std::set");
+
+    for (double s : {0.0, 0.8, 1.0, 1.2, 1.5}) {
+        auto probes = zipf_probes(keys, s, lookups, rng);
+
+        double a = time_ms([&]{ for (int p : probes) hits += splay.has(p); });
+        double b = time_ms([&]{ for (int p : probes) hits += avl.has(p); });
+        double c = time_ms([&]{ for (int p : probes) hits += rb.has(p); });
+        double d = time_ms([&]{ for (int p : probes) hits += set.count(p); });
+        std::printf("%-10.1f %10.2f %10.2f %10.2f %10.2f\n", s,
+                    lookups / a / 1e3, lookups / b / 1e3, lookups / c / 1e3, lookups / d / 1e3);
+    }
+
+    // Joining two halves versus re-inserting one into the other.
+    std::sort(keys.begin(), keys.end());
+    ads::splay_tree<int> low, high;
+    ads::avl_tree<int> avl_low, avl_high;
+    for (std::size_t i = 0; i < n; ++i) {
+        (i < n / 2 ? low : high).insert(keys[i]);
+        (i < n / 2 ? avl_low : avl_high).insert(keys[i]);
+    }
+    double a = time_ms([&]{ low.merge(high); });
+    double b = time_ms([&]{ avl_low.merge(avl_high); });
+    std::printf("\nmerge disjoint halves ms: splay %.3f, avl %.3f\n", a, b);
+
+    return hits == 42;
+}
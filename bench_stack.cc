@@ -0,0 +1,84 @@
+#include "stack.h"
+#include "bench.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Iterative DFS over a random graph stored as adjacency vectors.
+template <class Stack>
+long dfs(const std::vector<std::vector<int>>& adj) {
+    std::vector<char> seen(adj.size());
+    Stack s;
+    long visited = 0;
+    s.push(0);
+    while (!s.empty()) {
+        int v = s.pop();
+        if (seen[v])
+            continue;
+        seen[v] = 1;
+        ++visited;
+        s.push_range(adj[v].begin(), adj[v].end());
+    }
+
+    return visited;
+}
+
+// Many short-lived shallow stacks, as in expression evaluation.
+template <class Stack>
+long shallow(int rounds) {
+    long total = 0;
+    for (int r = 0; r < rounds; ++r) {
+        Stack s;
+        for (int i = 0; i < 8; ++i)
+            s.push(i + r);
+        while (s.size() > 1) {
+            int a = s.pop();
+            int b = s.pop();
+            s.push(a + b);
+        }
+        total += s.pop();
+    }
+
+    return total;
+}
+
+// Bulk push then bulk pop.
+template <class Stack>
+long bulk(const std::vector<int>& data, int rounds) {
+    long total = 0;
+    Stack s;
+    for (int r = 0; r < rounds; ++r) {
+        s.push_range(data.begin(), data.end());
+        total += s.top();
+        s.pop_n(data.size());
+    }
+
+    return total;
+}
+
+template <class Stack>
+void run(const char* name, const std::vector<std::vector<int>>& adj, const std::vector<int>& data) {
+    long r1 = 0, r2 = 0, r3 = 0;
+    double dfs_ms = time_ms([&]{ r1 = dfs<Stack>(adj); });
+    double shallow_ms = time_ms([&]{ r2 = shallow<Stack>(2000000); });
+    double bulk_ms = time_ms([&]{ r3 = bulk<Stack>(data, 200); });
+    std::printf("%-12s dfs %8.2f ms   shallow %8.2f ms   bulk %8.2f ms   (%ld %ld %ld)\n",
+                name, dfs_ms, shallow_ms, bulk_ms, r1, r2, r3);
+}
+
+int main() {
+    const int vertices = 1 << 20;
+    std::mt19937 rng(7);
+    std::vector<std::vector<int>> adj(vertices);
+    for (auto& edges : adj)
+        for (int i = 0; i < 4; ++i)
+            edges.push_back(static_cast<int>(rng() % vertices));
+
+    std::vector<int> data(100000);
+    for (auto& x : data)
+        x = static_cast<int>(rng());
+
+    run<ads::stack<int>>("small_vector", adj, data);
+    run<ads::stack<int, ads::list<int>>>("list", adj, data);
+}
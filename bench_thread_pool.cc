@@ -0,0 +1,62 @@
+#include "thread_pool.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+long parallel_sum(ads::thread_pool& pool, const int* first, const int* last) {
+    if (last - first <= 4096)
+        return std::accumulate(first, last, 0L);
+
+    auto mid = first + (last - first) / 2;
+    long l, r;
+    pool.fork_join([&]{ l = parallel_sum(pool, first, mid); },
+                   [&]{ r = parallel_sum(pool, mid, last); });
+
+    return l + r;
+}
+
+void parallel_merge_sort(ads::thread_pool& pool, int* first, int* last, int* scratch) {
+    if (last - first <= 8192) {
+        std::sort(first, last);
+        return;
+    }
+
+    auto mid = first + (last - first) / 2;
+    pool.fork_join([&]{ parallel_merge_sort(pool, first, mid, scratch); },
+                   [&]{ parallel_merge_sort(pool, mid, last, scratch + (mid - first)); });
+
+    std::merge(first, mid, mid, last, scratch);
+    std::copy(scratch, scratch + (last - first), first);
+}
+
+int main() {
+    const std::size_t n = 1 << 24;
+    std::vector<int> data(n);
+    std::mt19937 rng(42);
+    for (auto& x : data)
+        x = static_cast<int>(rng() % 1000);
+
+    long serial = 0;
+    double serial_ms = time_ms([&]{ serial = std::accumulate(data.begin(), data.end(), 0L); });
+    std::printf("sum        serial      %8.2f ms\n", serial_ms);
+
+    std::vector<int> sorted;
+    double std_sort_ms = time_ms([&]{ sorted = data; std::sort(sorted.begin(), sorted.end()); });
+    std::printf("sort       std::sort   %8.2f ms\n", std_sort_ms);
+
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        ads::thread_pool pool(threads);
+
+        long sum = 0;
+        double ms = time_ms([&]{ pool.run([&]{ sum = parallel_sum(pool, data.data(), data.data() + n); }); });
+        std::printf("sum        %2u threads  %8.2f ms%s\n", threads, ms, sum == serial ? "" : "  WRONG");
+
+        std::vector<int> v = data, scratch(n);
+        ms = time_ms([&]{ pool.run([&]{ parallel_merge_sort(pool, v.data(), v.data() + n, scratch.data()); }); });
+        std::printf("merge sort %2u threads  %8.2f ms%s\n", threads, ms, v == sorted ? "" : "  WRONG");
+    }
+}
@@ -0,0 +1,93 @@
+#include "treap.h"
+#include "avl_tree.h"
+#include "bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+static std::vector<int> random_keys(std::mt19937& rng, std::size_t n) {
+    std::vector<int> keys(n);
+    for (auto& k : keys)
+        k = static_cast<int>(rng() >> 1);
+    return keys;
+}
+
+int main() {
+    std::mt19937 rng(5);
+    long sink = 0;
+
+    // Set union of two trees: n into n, and a small tree into a large one,
+    // where split/join touches only O(m log(n / m)) nodes.
+    std::printf("union (ms)          %10s %10s %10s %10s %10s\n", "treap", "pool x2", "pool x4", "std::set", "avl merge");
+    for (auto sizes : {std::make_pair(1000000u, 1000000u), std::make_pair(1000000u, 1000u)}) {
+        auto a_keys = random_keys(rng, sizes.first), b_keys = random_keys(rng, sizes.second);
+        double ms[5];
+
+        for (int mode = 0; mode < 3; ++mode) {
+            ads::treap<int> a(a_keys.begin(), a_keys.end()), b(b_keys.begin(), b_keys.end());
+            if (mode == 0) {
+                ms[0] = time_ms([&]{ a.unite(b); });
+            } else {
+                ads::thread_pool pool(mode == 1 ? 2 : 4);
+                ms[mode] = time_ms([&]{ a.unite(b, pool); });
+            }
+            sink += static_cast<long>(a.size());
+        }
+        {
+            std::set<int> a(a_keys.begin(), a_keys.end()), b(b_keys.begin(), b_keys.end());
+            ms[3] = time_ms([&]{ a.insert(b.begin(), b.end()); });
+            sink += static_cast<long>(a.size());
+        }
+        {
+            ads::avl_tree<int> a, b;
+            for (int k : a_keys)
+                a.insert(k);
+            for (int k : b_keys)
+                b.insert(k);
+            ms[4] = time_ms([&]{ a.merge(b); });
+            sink += static_cast<long>(a.size());
+        }
+        std::printf("%7u into %7u  %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+                    sizes.second, sizes.first, ms[0], ms[1], ms[2], ms[3], ms[4]);
+    }
+
+    // Positional inserts and erases in the middle of a sequence, against a
+    // vector's linear shifts.
+    std::printf("\nrandom position insert + erase (ns/op)   %14s %14s\n", "implicit_treap", "std::vector");
+    for (std::size_t n : {10000u, 100000u, 1000000u}) {
+        const std::size_t ops = 20000;
+        std::vector<std::size_t> positions(ops);
+        for (auto& p : positions)
+            p = rng() % n;
+
+        ads::implicit_treap<int> seq;
+        std::vector<int> vec;
+        for (std::size_t i = 0; i < n; ++i) {
+            seq.push_back(static_cast<int>(i));
+            vec.push_back(static_cast<int>(i));
+        }
+
+        double treap_ns = time_ms([&]{
+            for (auto p : positions) {
+                seq.insert(p, 1);
+                seq.erase((p * 7) % n);
+            }
+        }) * 1e6 / ops;
+        double vector_ns = time_ms([&]{
+            for (auto p : positions) {
+                vec.insert(vec.begin() + static_cast<std::ptrdiff_t>(p), 1);
+                vec.erase(vec.begin() + static_cast<std::ptrdiff_t>((p * 7) % n));
+            }
+        }) * 1e6 / ops;
+        sink += seq[n / 2] + vec[n / 2];
+        std::printf("n = %8zu                              %14.1f %14.1f\n", n, treap_ns, vector_ns);
+    }
+
+    std::printf("(%u hardware threads)\n", std::thread::hardware_concurrency());
+    return sink == 0;
+}
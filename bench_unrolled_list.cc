@@ -0,0 +1,101 @@
+#include "list.h"
+#include "unrolled_list.h"
+#include "bench.h"
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Counts what the containers ask for, and what glibc malloc would spend
+// on it: an 8-byte header, rounded up to 16 bytes, at least 32.
+struct usage {
+    static std::size_t bytes, footprint, allocations;
+    static void reset() { bytes = footprint = allocations = 0; }
+};
+std::size_t usage::bytes, usage::footprint, usage::allocations;
+
+template <class T>
+struct counting_allocator : std::allocator<T> {
+    template <class U>
+    struct rebind { typedef counting_allocator<U> other; };
+
+    T* allocate(std::size_t n)
+    {
+        auto size = n * sizeof(T);
+        usage::bytes += size;
+        usage::footprint += std::max<std::size_t>(32, (size + 8 + 15) / 16 * 16);
+        ++usage::allocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+template <class List>
+long sum(const List& l) {
+    long total = 0;
+    for (auto it = l.cbegin(); it != l.cend(); ++it)
+        total += *it;
+    return total;
+}
+
+template <class List>
+void run(const char* name, const std::vector<int>& data, long& sink) {
+    auto n = data.size();
+    usage::reset();
+    List l;
+    double build = time_ms([&] {
+        for (int x : data)
+            l.push_back(x);
+    });
+    double bytes = static_cast<double>(usage::bytes) / n;
+    double footprint = static_cast<double>(usage::footprint) / n;
+
+    const int passes = 20;
+    double walk = time_ms([&] {
+        for (int p = 0; p < passes; ++p)
+            sink += sum(l);
+    });
+
+    // Sorting relinks list nodes into an order unrelated to where they
+    // live; the unrolled list moves the values and keeps its chunks.
+    l.sort();
+    double scattered = time_ms([&] {
+        for (int p = 0; p < passes; ++p)
+            sink += sum(l);
+    });
+
+    // Insert after every fourth element, then erase every third, by
+    // iterator.
+    double edit = time_ms([&] {
+        std::size_t i = 0;
+        for (auto it = l.begin(); it != l.end(); ++i)
+            it = i % 4 == 3 ? l.insert(it, static_cast<int>(i)).next() : it.next();
+        i = 0;
+        for (auto it = l.begin(); it != l.end(); ++i)
+            it = i % 3 == 2 ? l.erase(it) : it.next();
+    });
+    sink += sum(l);
+
+    std::printf("%9zu %-14s %9.1f %9.1f %9.1f %10.2f %10.2f %10.1f\n", n, name, bytes, footprint,
+                build * 1e6 / n, walk * 1e6 / (passes * n), scattered * 1e6 / (passes * n), edit * 1e6 / n);
+}
+
+int main() {
+    std::mt19937 rng(9);
+    long sink = 0;
+
+    std::printf("%9s %-14s %9s %9s %9s %10s %10s %10s\n", "n", "list", "B/elem", "malloc B", "push ns",
+                "walk ns", "sorted ns", "edit ns");
+    for (std::size_t n : {10000u, 1000000u, 4000000u}) {
+        std::vector<int> data(n);
+        for (auto& x : data)
+            x = static_cast<int>(rng() % 1000000);
+        // The unrolled list goes first: after a million scattered 32-byte
+        // frees, glibc takes microseconds per larger allocation while it
+        // sorts its bins, which would be charged to whoever runs next.
+        run<ads::unrolled_list<int, counting_allocator<int>>>("unrolled_list", data, sink);
+        run<ads::list<int, counting_allocator<int>>>("list", data, sink);
+    }
+
+    return sink == 0;
+}
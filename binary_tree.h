@@ -1,5 +1,15 @@
 /*
- preamble.
+ File:   binary_tree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    The interface shared by the binary trees: adding and removing single
+    elements and merging a whole tree into another.
+
+ Implementation:
+  - merge takes any binary_tree. A tree merging another of its own type is
+    expected to do better than re-adding the other tree's elements one at a
+    time, which is the fallback for mixed kinds.
  */
 
 
@@ -8,9 +18,11 @@
 
 #include "tree.h"
 
+namespace ads {
+
 template <class T>
 class binary_tree : public tree<T> {
-    
+
 /* Type definitions */
 public:
     typedef std::size_t size_type;
@@ -20,23 +32,18 @@ public:
     typedef T&          reference;
     typedef T&&         rvalue_ref;
     typedef const T&    const_ref;
-    
-    
-protected:
-    class Node : public tree<T>::Node {
-        
-    public:
-        std::pair<Node*, Node*> children = std::make_pair(nullptr, nullptr);
-    };
-    
-    
+
+
 /* Member functions */
 public:
+    /* Modifiers */
     virtual void add(const_ref) = 0;
     virtual void remove(const_ref) = 0;
     virtual void merge(binary_tree<T>&) = 0;
     virtual void merge(binary_tree<T>&&) = 0;
-    
 };
 
+
+} // end namespace
+
 #endif /* binary_tree_h */
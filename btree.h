@@ -0,0 +1,1314 @@
+/*
+ File:   btree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    In-memory B+ trees: btree_set and btree_map. Each node holds many keys
+    in one contiguous array, so a lookup touches a handful of cache lines
+    per level and the tree is only a few levels deep, where the binary
+    trees chase one pointer (and usually miss the cache) per key compared.
+
+ Implementation:
+  - Elements live only in the leaves; internal nodes hold separator keys.
+    A separator is the smallest key of the child to its right. Leaves are
+    linked both ways, so iteration never climbs the tree and iterators are
+    a leaf pointer and an index.
+  - Node capacity comes from NodeBytes (256 by default, four cache lines):
+    a leaf holds as many keys (and mapped values) as fit, an internal node
+    as many keys and child pointers. For int keys that is 64 keys per leaf
+    and 20 per internal node.
+  - The search within a node counts the keys less than the target. For
+    32 bit integer and float keys under std::less this is an SSE2 scan,
+    eight keys per step with an early exit (and SSE4.2 for 64 bit keys);
+    everything else uses a binary search with Compare.
+  - Nodes have no parent pointers. insert and erase record the path on the
+    way down and split, borrow or merge on the way back up.
+  - Slots are arrays of Key (and Mapped), so both must be default
+    constructible and move assignable. Unused slots hold default
+    constructed or moved-from values.
+  - bulk_load builds the tree bottom up from sorted input in linear time,
+    packing leaves full and spreading any remainder evenly.
+ */
+
+
+#ifndef btree_h
+#define btree_h
+
+#include <algorithm>         // lower_bound, max
+#include <cassert>           // assert
+#include <cstddef>           // ptrdiff_t
+#include <cstdint>           // int32_t, uint16_t
+#include <functional>        // less
+#include <initializer_list>  // initializer_list
+#include <iterator>          // iterator
+#include <memory>            // allocator
+#include <stdexcept>         // out_of_range
+#include <type_traits>       // conditional, is_void, integral_constant
+#include <utility>           // move, forward, pair, swap
+#include <vector>            // vector
+
+#ifdef __SSE2__
+#include <emmintrin.h>       // SSE2
+#endif
+#ifdef __SSE4_2__
+#include <nmmintrin.h>       // _mm_cmpgt_epi64
+#endif
+
+namespace ads {
+
+// Intra-node search: the number of keys in keys[0, n) that are less than
+// x. The general version is a binary search with the tree's comparator.
+template <class Key, class Compare>
+struct btree_search {
+    static std::size_t lower(const Key* keys, std::size_t n, const Key& x, const Compare& compare)
+    {
+        return static_cast<std::size_t>(std::lower_bound(keys, keys + n, x, compare) - keys);
+    }
+};
+
+#ifdef __SSE2__
+// Eight 32 bit keys per step. flip maps unsigned keys onto signed order.
+template <class Key, std::uint32_t flip>
+struct btree_search_32 {
+    static std::size_t lower(const Key* keys, std::size_t n, Key x)
+    {
+        const auto bias = _mm_set1_epi32(static_cast<int>(flip));
+        const auto target = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(x)), bias);
+
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            auto a = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), bias);
+            auto b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i + 4)), bias);
+            auto mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(a, target)))
+                      | _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(b, target))) << 4;
+            if (mask != 0xFF)
+                return i + static_cast<std::size_t>(__builtin_ctz(~mask));
+        }
+        while (i < n && keys[i] < x)
+            ++i;
+
+        return i;
+    }
+};
+
+template <>
+struct btree_search<std::int32_t, std::less<std::int32_t>> {
+    static std::size_t lower(const std::int32_t* keys, std::size_t n, std::int32_t x, const std::less<std::int32_t>&)
+    {
+        return btree_search_32<std::int32_t, 0>::lower(keys, n, x);
+    }
+};
+
+template <>
+struct btree_search<std::uint32_t, std::less<std::uint32_t>> {
+    static std::size_t lower(const std::uint32_t* keys, std::size_t n, std::uint32_t x, const std::less<std::uint32_t>&)
+    {
+        return btree_search_32<std::uint32_t, 0x80000000u>::lower(keys, n, x);
+    }
+};
+
+template <>
+struct btree_search<float, std::less<float>> {
+    static std::size_t lower(const float* keys, std::size_t n, float x, const std::less<float>&)
+    {
+        const auto target = _mm_set1_ps(x);
+
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            auto mask = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(keys + i), target))
+                      | _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(keys + i + 4), target)) << 4;
+            if (mask != 0xFF)
+                return i + static_cast<std::size_t>(__builtin_ctz(~mask));
+        }
+        while (i < n && keys[i] < x)
+            ++i;
+
+        return i;
+    }
+};
+#endif
+
+#ifdef __SSE4_2__
+template <>
+struct btree_search<std::int64_t, std::less<std::int64_t>> {
+    static std::size_t lower(const std::int64_t* keys, std::size_t n, std::int64_t x, const std::less<std::int64_t>&)
+    {
+        const auto target = _mm_set1_epi64x(x);
+
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+            auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i + 2));
+            auto mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(target, a)))
+                      | _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(target, b))) << 2;
+            if (mask != 0xF)
+                return i + static_cast<std::size_t>(__builtin_ctz(~mask));
+        }
+        while (i < n && keys[i] < x)
+            ++i;
+
+        return i;
+    }
+};
+#endif
+
+
+// The mapped values of a leaf. A set's leaves have none.
+template <class Mapped, std::size_t N>
+struct btree_values {
+    Mapped values[N];
+
+    void move_value(std::size_t from, btree_values& to, std::size_t at) { to.values[at] = std::move(values[from]); }
+
+    template <class... Args>
+    void set_value(std::size_t at, Args&&... args) { values[at] = Mapped(std::forward<Args>(args)...); }
+};
+
+template <std::size_t N>
+struct btree_values<void, N> {
+    void move_value(std::size_t, btree_values&, std::size_t) {}
+    void set_value(std::size_t) {}
+};
+
+
+// What dereferencing an iterator gives: the key for a set, a pair of
+// references for a map.
+template <class Key, class Mapped, bool Const>
+struct btree_deref {
+    typedef typename std::conditional<Const, const Mapped&, Mapped&>::type mapped_ref;
+    typedef std::pair<const Key&, mapped_ref> type;
+
+    template <class Leaf>
+    static type get(Leaf* leaf, std::size_t i) { return type(leaf->keys[i], leaf->values[i]); }
+};
+
+template <class Key, bool Const>
+struct btree_deref<Key, void, Const> {
+    typedef void mapped_ref;
+    typedef const Key& type;
+
+    template <class Leaf>
+    static type get(Leaf* leaf, std::size_t i) { return leaf->keys[i]; }
+};
+
+
+// The shared B+ tree. Mapped is void for a set.
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+class btree {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef Key         key_type;
+    typedef Key&&       rvalue_ref;
+    typedef const Key&  const_ref;
+
+
+/* Node definition */
+protected:
+    static constexpr size_type max_size(size_type a, size_type b) { return a > b ? a : b; }
+
+    static constexpr size_type leaf_slots =
+        max_size(4, NodeBytes / (sizeof(Key) + (std::is_void<Mapped>::value ? 0 : sizeof(typename std::conditional<std::is_void<Mapped>::value, char, Mapped>::type))));
+    static constexpr size_type internal_slots =
+        max_size(4, (NodeBytes - sizeof(void*)) / (sizeof(Key) + sizeof(void*)));
+    static constexpr size_type leaf_min = leaf_slots / 2;
+    static constexpr size_type internal_min = (internal_slots - 1) / 2;
+    static constexpr unsigned max_depth = 64;
+
+    static_assert(leaf_slots < 65536 && internal_slots < 65536, "node counts are 16 bit");
+
+    struct Node {
+        std::uint16_t count = 0;
+    };
+
+    struct Internal : Node {
+        Key keys[internal_slots];
+        Node* children[internal_slots + 1];
+    };
+
+    struct Leaf : Node, btree_values<Mapped, leaf_slots> {
+        Key keys[leaf_slots];
+        Leaf* prev = nullptr;
+        Leaf* next = nullptr;
+    };
+
+    typedef typename Alloc::template rebind<Leaf>::other leaf_alloc;
+    typedef typename Alloc::template rebind<Internal>::other internal_alloc;
+
+    typedef std::integral_constant<bool, std::is_void<Mapped>::value> is_set;
+
+
+/* Iterators */
+public:
+    template <bool Const>
+    class basic_iterator : public std::iterator<std::bidirectional_iterator_tag, Key, std::ptrdiff_t, void,
+                                                typename btree_deref<Key, Mapped, Const>::type> {
+
+        friend class btree<Key, Mapped, Compare, Alloc, NodeBytes>;
+        friend class basic_iterator<!Const>;
+
+    private:
+        Leaf* leaf;
+        size_type index;
+        const btree<Key, Mapped, Compare, Alloc, NodeBytes>* owner;   // For --end().
+
+    public:
+        typedef typename btree_deref<Key, Mapped, Const>::type reference;
+
+        basic_iterator(Leaf* l = nullptr, size_type i = 0, const btree<Key, Mapped, Compare, Alloc, NodeBytes>* t = nullptr)
+            : leaf(l), index(i), owner(t) {}
+        template <bool C = Const, class = typename std::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& it) : leaf(it.leaf), index(it.index), owner(it.owner) {}
+
+        reference operator*() const { return btree_deref<Key, Mapped, Const>::get(leaf, index); }
+        const_ref key() const { return leaf->keys[index]; }
+        typename btree_deref<Key, Mapped, Const>::mapped_ref value() const { return leaf->values[index]; }
+
+        basic_iterator& operator++()
+        {
+            if (++index == leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+            }
+            return *this;
+        }
+
+        basic_iterator& operator--()
+        {
+            if (!leaf) {
+                leaf = owner->_last;
+                index = leaf->count - 1u;
+            } else if (index == 0) {
+                leaf = leaf->prev;
+                index = leaf->count - 1u;
+            } else {
+                --index;
+            }
+            return *this;
+        }
+
+        basic_iterator operator++(int) { basic_iterator temp(*this); ++*this; return temp; }
+        basic_iterator operator--(int) { basic_iterator temp(*this); --*this; return temp; }
+        bool operator==(const basic_iterator& rhs) const { return leaf == rhs.leaf && index == rhs.index; }
+        bool operator!=(const basic_iterator& rhs) const { return !(*this == rhs); }
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true>  const_iterator;
+
+
+/* Data members */
+protected:
+    Node* _root = nullptr;
+    Leaf* _first = nullptr;
+    Leaf* _last = nullptr;
+    size_type _size = 0;
+    unsigned _height = 0;          // Levels, counting the leaves.
+    size_type _leaves = 0;
+    size_type _internals = 0;
+    Compare _compare;
+    leaf_alloc _leaf_alloc;
+    internal_alloc _internal_alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    btree() = default;
+    btree(const btree<Key, Mapped, Compare, Alloc, NodeBytes>&);
+    btree(btree<Key, Mapped, Compare, Alloc, NodeBytes>&&);
+    ~btree();
+
+    /* Iterators */
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    unsigned height() const;
+    size_type memory_usage() const;
+
+    /* Element access */
+    bool has(const_ref) const;
+    size_type count(const_ref) const;
+    iterator find(const_ref);
+    const_iterator find(const_ref) const;
+    iterator lower_bound(const_ref);
+    const_iterator lower_bound(const_ref) const;
+
+    /* Modifiers */
+    bool erase(const_ref);
+    template <class InputIt>
+        void bulk_load(InputIt, InputIt);
+    void swap(btree<Key, Mapped, Compare, Alloc, NodeBytes>&);
+    void clear() noexcept;
+
+/* Helper functions */
+protected:
+    template <class... Args>
+        std::pair<iterator, bool> insert_unique(const_ref, Args&&...);
+
+private:
+    Leaf* create_leaf();
+    Internal* create_internal();
+    void destroy(Node*, unsigned);
+
+    size_type search(const Key*, size_type, const_ref) const;
+    size_type child_index(const Internal*, const_ref) const;
+    Leaf* descend(const_ref, Internal**, size_type*) const;
+    std::pair<Leaf*, size_type> locate(const_ref) const;
+
+    static void move_entry(Leaf*, size_type, Leaf*, size_type);
+    void insert_into_parent(Internal**, size_type*, unsigned, Key, Node*);
+    void rebalance(Internal**, size_type*, unsigned);
+
+    template <class Element>
+        void put(Leaf*, size_type, const Element&, std::true_type);
+    template <class Element>
+        void put(Leaf*, size_type, const Element&, std::false_type);
+};
+
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+constexpr typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type btree<Key, Mapped, Compare, Alloc, NodeBytes>::leaf_slots;
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+constexpr typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type btree<Key, Mapped, Compare, Alloc, NodeBytes>::internal_slots;
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+constexpr typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type btree<Key, Mapped, Compare, Alloc, NodeBytes>::leaf_min;
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+constexpr typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type btree<Key, Mapped, Compare, Alloc, NodeBytes>::internal_min;
+
+
+
+// An ordered set of unique keys.
+template <class Key, class Compare = std::less<Key>, class Alloc = std::allocator<Key>,
+          std::size_t NodeBytes = 256>
+class btree_set : public btree<Key, void, Compare, Alloc, NodeBytes> {
+
+    typedef btree<Key, void, Compare, Alloc, NodeBytes> base;
+
+public:
+    typedef Key value_type;
+    typedef typename base::iterator iterator;
+    typedef typename base::const_iterator const_iterator;
+
+    /* Constructors */
+    btree_set() = default;
+    btree_set(std::initializer_list<Key> il) { for (auto& key : il) insert(key); }
+    template <class InputIt>
+        btree_set(InputIt first, InputIt last) { for (; first != last; ++first) insert(*first); }
+
+    /* Modifiers */
+    std::pair<iterator, bool> insert(const Key& key) { return this->insert_unique(key); }
+    std::pair<iterator, bool> insert(Key&& key) { return this->insert_unique(std::move(key)); }
+};
+
+
+// An ordered map from unique keys to values.
+template <class Key, class Mapped, class Compare = std::less<Key>, class Alloc = std::allocator<Key>,
+          std::size_t NodeBytes = 256>
+class btree_map : public btree<Key, Mapped, Compare, Alloc, NodeBytes> {
+
+    typedef btree<Key, Mapped, Compare, Alloc, NodeBytes> base;
+
+public:
+    typedef Mapped mapped_type;
+    typedef std::pair<Key, Mapped> value_type;
+    typedef typename base::iterator iterator;
+    typedef typename base::const_iterator const_iterator;
+
+    /* Constructors */
+    btree_map() = default;
+    btree_map(std::initializer_list<value_type> il) { for (auto& kv : il) insert(kv.first, kv.second); }
+
+    /* Element access */
+    Mapped& operator[](const Key& key) { return this->insert_unique(key).first.value(); }
+
+    Mapped& at(const Key& key)
+    {
+        auto it = this->find(key);
+        if (it == this->end())
+            throw std::out_of_range("btree_map::at");
+        return it.value();
+    }
+
+    const Mapped& at(const Key& key) const
+    {
+        auto it = this->find(key);
+        if (it == this->end())
+            throw std::out_of_range("btree_map::at");
+        return it.value();
+    }
+
+    /* Modifiers */
+    std::pair<iterator, bool> insert(const Key& key, const Mapped& value) { return this->insert_unique(key, value); }
+    std::pair<iterator, bool> insert(const Key& key, Mapped&& value) { return this->insert_unique(key, std::move(value)); }
+};
+
+
+
+// Node management
+
+/*
+ Function: create_leaf / create_internal / destroy
+ Parameters:
+  - node: The root of the subtree to free.
+  - level: The node's height above the leaves (0 for a leaf).
+
+ Description:
+    Nodes are allocated through Alloc and counted for memory_usage.
+    destroy recurses once per level, which is only a few deep.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::Leaf*
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::create_leaf()
+{
+    auto leaf = _leaf_alloc.allocate(1);
+    try {
+        ::new (static_cast<void*>(leaf)) Leaf();
+    } catch (...) {
+        _leaf_alloc.deallocate(leaf, 1);
+        throw;
+    }
+
+    ++_leaves;
+    return leaf;
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::Internal*
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::create_internal()
+{
+    auto node = _internal_alloc.allocate(1);
+    try {
+        ::new (static_cast<void*>(node)) Internal();
+    } catch (...) {
+        _internal_alloc.deallocate(node, 1);
+        throw;
+    }
+
+    ++_internals;
+    return node;
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::destroy(Node* node, unsigned level)
+{
+    if (level == 0) {
+        auto leaf = static_cast<Leaf*>(node);
+        leaf->~Leaf();
+        _leaf_alloc.deallocate(leaf, 1);
+        --_leaves;
+        return;
+    }
+
+    auto internal = static_cast<Internal*>(node);
+    for (size_type i = 0; i <= internal->count; ++i)
+        destroy(internal->children[i], level - 1);
+
+    internal->~Internal();
+    _internal_alloc.deallocate(internal, 1);
+    --_internals;
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The tree being copied or moved from.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty tree (defaulted in the class).
+  2. independent copy of rhs, bulk loaded so its leaves are full.
+  3. tree that takes over rhs's nodes, leaving rhs empty.
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs.
+  3. Constant.
+ */
+
+// 2. copy
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::btree(const btree<Key, Mapped, Compare, Alloc, NodeBytes>& rhs)
+    : _compare(rhs._compare)
+{
+    bulk_load(rhs.begin(), rhs.end());
+}
+
+// 3. move
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::btree(btree<Key, Mapped, Compare, Alloc, NodeBytes>&& rhs)
+{
+    swap(rhs);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::~btree()
+{
+    clear();
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end
+ Return value: Iterators to the smallest element and past the largest.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::begin()
+{
+    return iterator(_first, 0, this);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::end()
+{
+    return iterator(nullptr, 0, this);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::const_iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::begin() const
+{
+    return const_iterator(_first, 0, this);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::const_iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::end() const
+{
+    return const_iterator(nullptr, 0, this);
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size / height
+ Return value: Whether the tree is empty, the number of elements, or the
+               number of levels including the leaves.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline bool
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::empty() const
+{
+    return _size == 0;
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::size() const
+{
+    return _size;
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline unsigned
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::height() const
+{
+    return _height;
+}
+
+
+/*
+ Function: memory_usage
+ Return value: The bytes held in nodes, not counting allocator overhead.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::memory_usage() const
+{
+    return _leaves * sizeof(Leaf) + _internals * sizeof(Internal);
+}
+
+
+
+// Element access
+
+/*
+ Function: has / count / find / lower_bound
+ Parameters:
+  - key: The key to look for.
+ Return value: Whether key is present (count: 1 or 0), an iterator to it
+               (end() if absent), or an iterator to the first element not
+               less than it.
+
+ Complexity: Logarithmic; one node search per level.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline bool
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::has(const_ref key) const
+{
+    auto spot = locate(key);
+    return spot.second < spot.first->count && !_compare(key, spot.first->keys[spot.second]);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::count(const_ref key) const
+{
+    return has(key) ? 1 : 0;
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::find(const_ref key)
+{
+    auto spot = locate(key);
+    if (spot.second < spot.first->count && !_compare(key, spot.first->keys[spot.second]))
+        return iterator(spot.first, spot.second, this);
+
+    return end();
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::const_iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::find(const_ref key) const
+{
+    return const_cast<btree<Key, Mapped, Compare, Alloc, NodeBytes>*>(this)->find(key);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::lower_bound(const_ref key)
+{
+    auto spot = locate(key);
+    if (spot.second == spot.first->count)
+        return iterator(spot.first->next, 0, this);
+
+    return iterator(spot.first, spot.second, this);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::const_iterator
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::lower_bound(const_ref key) const
+{
+    return const_cast<btree<Key, Mapped, Compare, Alloc, NodeBytes>*>(this)->lower_bound(key);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert_unique
+ Parameters:
+  - key: The key to insert.
+  - args: Arguments for the mapped value (none for a set).
+ Return value: An iterator to the element with key, and whether it was
+               inserted. An existing element is left untouched.
+
+ Description:
+    A full leaf is split in half and the smallest key of the new right
+    half becomes a separator in the parent, which may split in turn. A
+    root split adds a level.
+
+ Complexity: Logarithmic, plus a linear shift within the leaf.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+template <class... Args>
+std::pair<typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::iterator, bool>
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::insert_unique(const_ref key, Args&&... args)
+{
+    if (!_root) {
+        _first = _last = create_leaf();
+        _root = _first;
+        _height = 1;
+    }
+
+    Internal* path[max_depth];
+    size_type slots[max_depth];
+    auto leaf = descend(key, path, slots);
+    auto i = search(leaf->keys, leaf->count, key);
+    if (i < leaf->count && !_compare(key, leaf->keys[i]))
+        return std::make_pair(iterator(leaf, i, this), false);
+
+    if (leaf->count < leaf_slots) {
+        for (auto j = static_cast<size_type>(leaf->count); j > i; --j)
+            move_entry(leaf, j - 1, leaf, j);
+        leaf->keys[i] = key;
+        leaf->set_value(i, std::forward<Args>(args)...);
+        ++leaf->count;
+        ++_size;
+        return std::make_pair(iterator(leaf, i, this), true);
+    }
+
+    // Split: the left leaf keeps (leaf_slots + 1) / 2 entries, counting the
+    // new one, and the rest move to a new right leaf.
+    auto right = create_leaf();
+    const size_type keep = (leaf_slots + 1) / 2;
+    const size_type total = leaf_slots + 1;
+    Leaf* home;
+    size_type at;
+
+    if (i < keep) {
+        for (size_type j = keep - 1; j < leaf_slots; ++j)
+            move_entry(leaf, j, right, j - (keep - 1));
+        for (auto j = keep - 1; j > i; --j)
+            move_entry(leaf, j - 1, leaf, j);
+        home = leaf;
+        at = i;
+    } else {
+        size_type out = 0;
+        for (size_type j = keep; j < leaf_slots; ++j, ++out) {
+            if (j == i)
+                ++out;
+            move_entry(leaf, j, right, out);
+        }
+        home = right;
+        at = i - keep;
+    }
+    home->keys[at] = key;
+    home->set_value(at, std::forward<Args>(args)...);
+    leaf->count = static_cast<std::uint16_t>(keep);
+    right->count = static_cast<std::uint16_t>(total - keep);
+    ++_size;
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+        leaf->next->prev = right;
+    else
+        _last = right;
+    leaf->next = right;
+
+    insert_into_parent(path, slots, _height - 1, right->keys[0], right);
+    return std::make_pair(iterator(home, at, this), true);
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - key: The key to remove.
+ Return value: Whether the key was present.
+
+ Description:
+    A leaf left under half full borrows from a sibling or merges with one;
+    a merge removes a separator from the parent, which may underflow in
+    turn. Separators are not updated when their key is erased: they only
+    need to divide the children correctly, which they still do.
+
+ Complexity: Logarithmic, plus a linear shift within the leaf.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+bool
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::erase(const_ref key)
+{
+    if (!_root)
+        return false;
+
+    Internal* path[max_depth];
+    size_type slots[max_depth];
+    auto leaf = descend(key, path, slots);
+    auto i = search(leaf->keys, leaf->count, key);
+    if (i == leaf->count || _compare(key, leaf->keys[i]))
+        return false;
+
+    for (auto j = i + 1; j < leaf->count; ++j)
+        move_entry(leaf, j, leaf, j - 1);
+    --leaf->count;
+    --_size;
+
+    if (_height == 1) {
+        if (leaf->count == 0)
+            clear();
+    } else if (leaf->count < leaf_min) {
+        rebalance(path, slots, _height - 1);
+    }
+
+    return true;
+}
+
+
+/*
+ Function: bulk_load
+ Parameters:
+  - first, last: Elements in strictly ascending order: keys for a set,
+                 (key, value) pairs for a map.
+ Return value: None
+
+ Description:
+    Replaces the contents with the range. Leaves are packed full, then each
+    internal level is built over the one below, with the last few nodes of
+    every level evened out so none is under half full.
+
+ Complexity: Linear in the length of the range.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+template <class InputIt>
+void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::bulk_load(InputIt first, InputIt last)
+{
+    clear();
+
+    // Read the range into leaves of leaf_slots entries.
+    std::vector<Node*> level;
+    Leaf* leaf = nullptr;
+    for (; first != last; ++first) {
+        if (!leaf || leaf->count == leaf_slots) {
+            auto fresh = create_leaf();
+            if (leaf) {
+                leaf->next = fresh;
+                fresh->prev = leaf;
+            } else {
+                _first = fresh;
+            }
+            leaf = fresh;
+            level.push_back(leaf);
+        }
+        put(leaf, leaf->count, *first, is_set());
+        assert(leaf->count == 0 || _compare(leaf->keys[leaf->count - 1], leaf->keys[leaf->count]));
+        assert(leaf->count > 0 || !leaf->prev || _compare(leaf->prev->keys[leaf_slots - 1], leaf->keys[0]));
+        ++leaf->count;
+        ++_size;
+    }
+    if (!leaf)
+        return;
+    _last = leaf;
+    _height = 1;
+
+    // Top up a short last leaf from its neighbour.
+    if (leaf->prev && leaf->count < leaf_min) {
+        auto donor = leaf->prev;
+        auto need = static_cast<size_type>((donor->count + leaf->count) / 2 - leaf->count);
+        for (auto j = static_cast<size_type>(leaf->count); j-- > 0;)
+            move_entry(leaf, j, leaf, j + need);
+        for (size_type j = 0; j < need; ++j)
+            move_entry(donor, donor->count - need + j, leaf, j);
+        donor->count = static_cast<std::uint16_t>(donor->count - need);
+        leaf->count = static_cast<std::uint16_t>(leaf->count + need);
+    }
+
+    // Build internal levels. Children are dealt out evenly so every node
+    // has between (internal_slots + 1) / 2 and internal_slots + 1.
+    std::vector<Key> lows;   // Smallest key under each node of the level.
+    lows.reserve(level.size());
+    for (auto node : level)
+        lows.push_back(static_cast<Leaf*>(node)->keys[0]);
+
+    while (level.size() > 1) {
+        const size_type fan = internal_slots + 1;
+        const size_type parents = (level.size() + fan - 1) / fan;
+        std::vector<Node*> upper;
+        std::vector<Key> upper_lows;
+        upper.reserve(parents);
+        upper_lows.reserve(parents);
+
+        size_type next = 0;
+        for (size_type p = 0; p < parents; ++p) {
+            auto take = level.size() / parents + (p < level.size() % parents ? 1 : 0);
+            auto node = create_internal();
+            node->children[0] = level[next];
+            for (size_type c = 1; c < take; ++c) {
+                node->keys[c - 1] = std::move(lows[next + c]);
+                node->children[c] = level[next + c];
+            }
+            node->count = static_cast<std::uint16_t>(take - 1);
+            upper.push_back(node);
+            upper_lows.push_back(std::move(lows[next]));
+            next += take;
+        }
+
+        level.swap(upper);
+        lows.swap(upper_lows);
+        ++_height;
+    }
+
+    _root = level[0];
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - other: The tree to exchange contents with.
+
+ Complexity: Constant.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::swap(btree<Key, Mapped, Compare, Alloc, NodeBytes>& other)
+{
+    using std::swap;
+    swap(_root, other._root);
+    swap(_first, other._first);
+    swap(_last, other._last);
+    swap(_size, other._size);
+    swap(_height, other._height);
+    swap(_leaves, other._leaves);
+    swap(_internals, other._internals);
+    swap(_compare, other._compare);
+    swap(_leaf_alloc, other._leaf_alloc);
+    swap(_internal_alloc, other._internal_alloc);
+}
+
+
+/*
+ Function: clear
+ Description: Removes every element.
+ Complexity: Linear.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::clear() noexcept
+{
+    if (_root)
+        destroy(_root, _height - 1);
+
+    _root = nullptr;
+    _first = _last = nullptr;
+    _size = 0;
+    _height = 0;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: search / child_index
+ Parameters:
+  - keys, n: A node's key array and count.
+  - node: An internal node.
+  - key: The key to look for.
+ Return value: The number of keys less than key, or the index of the child
+               to descend into (keys equal to a separator go right).
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::search(const Key* keys, size_type n, const_ref key) const
+{
+    return btree_search<Key, Compare>::lower(keys, n, key, _compare);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::child_index(const Internal* node, const_ref key) const
+{
+    auto i = search(node->keys, node->count, key);
+    return i < node->count && !_compare(key, node->keys[i]) ? i + 1 : i;
+}
+
+
+/*
+ Function: descend / locate
+ Parameters:
+  - key: The key to look for.
+  - path: Receives the internal nodes visited, root first.
+  - slots: Receives the child index taken at each of them.
+ Return value: The leaf key belongs in; locate also gives the index of
+               the first key in it not less than key. The tree must not be
+               empty.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::Leaf*
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::descend(const_ref key, Internal** path, size_type* slots) const
+{
+    auto node = _root;
+    for (unsigned level = 0; level + 1 < _height; ++level) {
+        auto internal = static_cast<Internal*>(node);
+        path[level] = internal;
+        slots[level] = child_index(internal, key);
+        node = internal->children[slots[level]];
+    }
+
+    return static_cast<Leaf*>(node);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+std::pair<typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::Leaf*,
+          typename btree<Key, Mapped, Compare, Alloc, NodeBytes>::size_type>
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::locate(const_ref key) const
+{
+    static Leaf empty_leaf;   // Lets lookups on an empty tree fall through.
+    if (!_root)
+        return std::make_pair(&empty_leaf, size_type(0));
+
+    auto node = _root;
+    for (unsigned level = 1; level < _height; ++level) {
+        auto internal = static_cast<const Internal*>(node);
+        node = internal->children[child_index(internal, key)];
+    }
+
+    auto leaf = static_cast<Leaf*>(node);
+    return std::make_pair(leaf, search(leaf->keys, leaf->count, key));
+}
+
+
+/*
+ Function: move_entry
+ Parameters:
+  - from, i: The leaf and slot to move out of.
+  - to, j: The leaf and slot to move into.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+inline void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::move_entry(Leaf* from, size_type i, Leaf* to, size_type j)
+{
+    to->keys[j] = std::move(from->keys[i]);
+    from->move_value(i, *to, j);
+}
+
+
+/*
+ Function: put
+ Parameters:
+  - leaf, i: Where to store the element.
+  - element: A key (set) or a key/value pair (map).
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+template <class Element>
+inline void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::put(Leaf* leaf, size_type i, const Element& element, std::true_type)
+{
+    leaf->keys[i] = element;
+}
+
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+template <class Element>
+inline void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::put(Leaf* leaf, size_type i, const Element& element, std::false_type)
+{
+    leaf->keys[i] = element.first;
+    leaf->set_value(i, element.second);
+}
+
+
+/*
+ Function: insert_into_parent
+ Parameters:
+  - path, slots: The descent that reached the node that split.
+  - level: The depth of that node (0 for the root).
+  - separator: The smallest key under right.
+  - right: The new right sibling of the node that split.
+
+ Description:
+    Adds separator and right to the parent just after the split node. A
+    full parent is split around its middle key, which moves up another
+    level. Splitting the root grows a new one.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::insert_into_parent(Internal** path, size_type* slots,
+                                                                 unsigned level, Key separator, Node* right)
+{
+    for (;;) {
+        if (level == 0) {
+            auto root = create_internal();
+            root->keys[0] = std::move(separator);
+            root->children[0] = _root;
+            root->children[1] = right;
+            root->count = 1;
+            _root = root;
+            ++_height;
+            return;
+        }
+
+        auto parent = path[level - 1];
+        auto at = slots[level - 1];
+        if (parent->count < internal_slots) {
+            for (auto j = static_cast<size_type>(parent->count); j > at; --j) {
+                parent->keys[j] = std::move(parent->keys[j - 1]);
+                parent->children[j + 1] = parent->children[j];
+            }
+            parent->keys[at] = std::move(separator);
+            parent->children[at + 1] = right;
+            ++parent->count;
+            return;
+        }
+
+        // Lay the overfull node out in order, then deal it into two.
+        Key keys[internal_slots + 1];
+        Node* children[internal_slots + 2];
+        for (size_type j = 0, k = 0; j <= internal_slots; ++j) {
+            if (j == at) {
+                keys[j] = std::move(separator);
+            } else {
+                keys[j] = std::move(parent->keys[k++]);
+            }
+        }
+        for (size_type j = 0, k = 0; j <= internal_slots + 1; ++j)
+            children[j] = j == at + 1 ? right : parent->children[k++];
+
+        const size_type mid = (internal_slots + 1) / 2;
+        auto sibling = create_internal();
+        for (size_type j = 0; j < mid; ++j) {
+            parent->keys[j] = std::move(keys[j]);
+            parent->children[j] = children[j];
+        }
+        parent->children[mid] = children[mid];
+        parent->count = static_cast<std::uint16_t>(mid);
+
+        for (size_type j = mid + 1; j <= internal_slots; ++j) {
+            sibling->keys[j - mid - 1] = std::move(keys[j]);
+            sibling->children[j - mid - 1] = children[j];
+        }
+        sibling->children[internal_slots - mid] = children[internal_slots + 1];
+        sibling->count = static_cast<std::uint16_t>(internal_slots - mid);
+
+        separator = std::move(keys[mid]);
+        right = sibling;
+        --level;
+    }
+}
+
+
+/*
+ Function: rebalance
+ Parameters:
+  - path, slots: The descent that reached the underfull node.
+  - level: The depth of the underfull node.
+
+ Description:
+    Borrows an entry from an adjacent sibling with one to spare, rotating
+    it through the parent's separator, or else merges with a sibling and
+    removes their separator from the parent. Repeats up the tree while
+    parents underflow; a root left with a single child is removed.
+ */
+template <class Key, class Mapped, class Compare, class Alloc, std::size_t NodeBytes>
+void
+btree<Key, Mapped, Compare, Alloc, NodeBytes>::rebalance(Internal** path, size_type* slots, unsigned level)
+{
+    for (bool is_leaf = true; level > 0; is_leaf = false, --level) {
+        auto parent = path[level - 1];
+        auto at = slots[level - 1];
+        auto node = parent->children[at];
+        auto left = at > 0 ? parent->children[at - 1] : nullptr;
+        auto right = at < parent->count ? parent->children[at + 1] : nullptr;
+
+        if (is_leaf) {
+            auto leaf = static_cast<Leaf*>(node);
+            auto l = static_cast<Leaf*>(left);
+            auto r = static_cast<Leaf*>(right);
+
+            if (l && l->count > leaf_min) {
+                for (auto j = static_cast<size_type>(leaf->count); j > 0; --j)
+                    move_entry(leaf, j - 1, leaf, j);
+                move_entry(l, l->count - 1u, leaf, 0);
+                --l->count;
+                ++leaf->count;
+                parent->keys[at - 1] = leaf->keys[0];
+                return;
+            }
+            if (r && r->count > leaf_min) {
+                move_entry(r, 0, leaf, leaf->count);
+                for (size_type j = 1; j < r->count; ++j)
+                    move_entry(r, j, r, j - 1);
+                --r->count;
+                ++leaf->count;
+                parent->keys[at] = r->keys[0];
+                return;
+            }
+
+            // Merge the right one of the pair into the left.
+            if (!l) {
+                l = leaf;
+                leaf = r;
+                ++at;
+            }
+            for (size_type j = 0; j < leaf->count; ++j)
+                move_entry(leaf, j, l, l->count + j);
+            l->count = static_cast<std::uint16_t>(l->count + leaf->count);
+            l->next = leaf->next;
+            if (leaf->next)
+                leaf->next->prev = l;
+            else
+                _last = l;
+            destroy(leaf, 0);
+        } else {
+            auto inner = static_cast<Internal*>(node);
+            auto l = static_cast<Internal*>(left);
+            auto r = static_cast<Internal*>(right);
+
+            if (l && l->count > internal_min) {
+                inner->children[inner->count + 1u] = inner->children[inner->count];
+                for (auto j = static_cast<size_type>(inner->count); j > 0; --j) {
+                    inner->keys[j] = std::move(inner->keys[j - 1]);
+                    inner->children[j] = inner->children[j - 1];
+                }
+                inner->keys[0] = std::move(parent->keys[at - 1]);
+                inner->children[0] = l->children[l->count];
+                parent->keys[at - 1] = std::move(l->keys[l->count - 1u]);
+                --l->count;
+                ++inner->count;
+                return;
+            }
+            if (r && r->count > internal_min) {
+                inner->keys[inner->count] = std::move(parent->keys[at]);
+                inner->children[inner->count + 1u] = r->children[0];
+                parent->keys[at] = std::move(r->keys[0]);
+                for (size_type j = 1; j < r->count; ++j) {
+                    r->keys[j - 1] = std::move(r->keys[j]);
+                    r->children[j - 1] = r->children[j];
+                }
+                r->children[r->count - 1u] = r->children[r->count];
+                --r->count;
+                ++inner->count;
+                return;
+            }
+
+            if (!l) {
+                l = inner;
+                inner = r;
+                ++at;
+            }
+            l->keys[l->count] = std::move(parent->keys[at - 1]);
+            for (size_type j = 0; j < inner->count; ++j) {
+                l->keys[l->count + 1 + j] = std::move(inner->keys[j]);
+                l->children[l->count + 1 + j] = inner->children[j];
+            }
+            l->children[l->count + 1u + inner->count] = inner->children[inner->count];
+            l->count = static_cast<std::uint16_t>(l->count + 1 + inner->count);
+            inner->count = 0;
+            inner->~Internal();
+            _internal_alloc.deallocate(inner, 1);
+            --_internals;
+        }
+
+        // Remove separator at - 1 and child at from the parent.
+        for (auto j = at; j < parent->count; ++j) {
+            parent->keys[j - 1] = std::move(parent->keys[j]);
+            parent->children[j] = parent->children[j + 1];
+        }
+        --parent->count;
+
+        if (level == 1) {
+            if (parent->count == 0) {
+                _root = parent->children[0];
+                parent->~Internal();
+                _internal_alloc.deallocate(parent, 1);
+                --_internals;
+                --_height;
+            }
+            return;
+        }
+        if (parent->count >= internal_min)
+            return;
+    }
+}
+
+
+} // end namespace
+
+#endif /* btree_h */
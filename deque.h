@@ -1,5 +1,366 @@
+/*
+ File:   deque.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A Chase-Lev work-stealing deque. One owner thread pushes and pops at the
+    bottom while any number of thief threads steal from the top. This is the
+    per-worker task queue underneath thread_pool.h.
+
+ Implementation:
+  - Elements live in a circular buffer whose capacity is a power of two so
+    indices can be masked instead of reduced modulo the size.
+  - top and bottom are monotonically increasing 64 bit counters. Only the
+    owner writes bottom; top is advanced with a CAS by whoever takes the
+    last element (owner) or any element (thief).
+  - When the owner runs out of room the buffer is doubled. Thieves may still
+    be reading the old buffer, so retired buffers are kept until the deque is
+    destroyed rather than freed immediately. The total retired memory is
+    bounded by the size of the live buffer.
+  - Memory orderings follow Le, Pop, Cohen and Zappa Nardelli, "Correct and
+    Efficient Work-Stealing for Weak Memory Models" (PPoPP 2013).
+
+ TODO:
+  - A general purpose (non-concurrent) double ended queue.
+ */
+
+
 #ifndef deque_h
 #define deque_h
 
+#include <atomic>       // atomic
+#include <cassert>      // assert
+#include <cstdint>      // int64_t
+#include <memory>       // unique_ptr
+#include <type_traits>  // is_trivially_copyable
+#include <vector>       // vector
+
+namespace ads {
+
+template <class T>
+class ws_deque {
+
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "ws_deque elements are copied racily and must be trivially copyable");
+
+/* Type definitions */
+public:
+    typedef std::size_t  size_type;
+    typedef T            value_type;
+    typedef T&           reference;
+    typedef const T&     const_ref;
+
+
+/* Buffer definition */
+private:
+    class Buffer {
+
+    public:
+        const std::int64_t capacity;
+        const std::int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Buffer(std::int64_t);
+
+        T get(std::int64_t) const;
+        void put(std::int64_t, const_ref);
+        Buffer* grow(std::int64_t, std::int64_t) const;
+    };
+
+
+/* Data members */
+private:
+    // top and bottom are padded onto separate cache lines so thieves hitting
+    // top do not keep invalidating the owner's bottom. (Padding rather than
+    // alignas since C++14 new ignores extended alignment.)
+    std::atomic<std::int64_t> _top;
+    char _pad_top[64 - sizeof(std::atomic<std::int64_t>)];
+    std::atomic<std::int64_t> _bottom;
+    char _pad_bottom[64 - sizeof(std::atomic<std::int64_t>)];
+    std::atomic<Buffer*> _buffer;
+    std::vector<std::unique_ptr<Buffer>> _retired;  // Owner only.
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit ws_deque(size_type = 64);
+    ws_deque(const ws_deque<T>&) = delete;
+    ws_deque<T>& operator=(const ws_deque<T>&) = delete;
+    ~ws_deque();
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    size_type capacity() const;
+
+    /* Owner operations */
+    void push(const_ref);
+    bool pop(reference);
+
+    /* Thief operations */
+    bool steal(reference);
+};
+
+
+
+// Buffer
+
+/*
+ Function: buffer constructor
+ Parameters:
+  - cap: The number of slots. Must be a power of two.
+
+ Complexity: Linear in cap.
+ */
+template <class T>
+ws_deque<T>::Buffer::Buffer(std::int64_t cap)
+    : capacity(cap)
+    , mask(cap - 1)
+    , slots(new std::atomic<T>[cap])
+{
+    assert(cap > 0 && (cap & (cap - 1)) == 0);
+}
+
+
+/*
+ Function: get / put
+ Parameters:
+  - i: The logical (unmasked) index of the slot.
+  - element: The element to store.
+
+ Description:
+    Relaxed slot accesses. Ordering is provided by the fences and the
+    top/bottom operations in the deque itself.
+
+ Complexity: Constant.
+ */
+template <class T>
+inline T
+ws_deque<T>::Buffer::get(std::int64_t i) const
+{
+    return slots[i & mask].load(std::memory_order_relaxed);
+}
+
+template <class T>
+inline void
+ws_deque<T>::Buffer::put(std::int64_t i, const_ref element)
+{
+    slots[i & mask].store(element, std::memory_order_relaxed);
+}
+
+
+/*
+ Function: grow
+ Parameters:
+  - top: The current top index.
+  - bottom: The current bottom index.
+ Return value: A new buffer of twice the capacity holding [top, bottom).
+
+ Complexity: Linear in the number of elements in the deque.
+ */
+template <class T>
+typename ws_deque<T>::Buffer*
+ws_deque<T>::Buffer::grow(std::int64_t top, std::int64_t bottom) const
+{
+    auto bigger = new Buffer(capacity * 2);
+    for (auto i = top; i != bottom; ++i)
+        bigger->put(i, get(i));
+
+    return bigger;
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - initial_capacity: A hint for the starting number of slots. It is
+                      rounded up to a power of two.
+
+ Description:
+    Makes an empty deque.
+
+ Complexity: Linear in initial_capacity.
+ */
+template <class T>
+ws_deque<T>::ws_deque(size_type initial_capacity)
+    : _top(0)
+    , _bottom(0)
+{
+    std::int64_t cap = 1;
+    while (cap < static_cast<std::int64_t>(initial_capacity))
+        cap <<= 1;
+
+    _buffer.store(new Buffer(cap), std::memory_order_relaxed);
+}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Frees the live buffer and every retired one. No other thread may be
+    touching the deque at this point.
+ */
+template <class T>
+ws_deque<T>::~ws_deque()
+{
+    delete _buffer.load(std::memory_order_relaxed);
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: A snapshot of whether the deque is empty or how many elements
+               it holds. Only exact when no other thread is operating on it.
+ */
+template <class T>
+inline bool
+ws_deque<T>::empty() const
+{
+    return size() == 0;
+}
+
+template <class T>
+inline typename ws_deque<T>::size_type
+ws_deque<T>::size() const
+{
+    auto b = _bottom.load(std::memory_order_relaxed);
+    auto t = _top.load(std::memory_order_relaxed);
+
+    return b > t ? static_cast<size_type>(b - t) : 0;
+}
+
+
+/*
+ Function: capacity
+ Return value: The number of slots in the live buffer.
+ */
+template <class T>
+inline typename ws_deque<T>::size_type
+ws_deque<T>::capacity() const
+{
+    return static_cast<size_type>(_buffer.load(std::memory_order_relaxed)->capacity);
+}
+
+
+
+// Owner operations
+
+/*
+ Function: push
+ Parameters:
+  - element: The element to add to the bottom of the deque.
+ Return value: None
+
+ Description:
+    Adds an element at the owner's end. Must only be called by the owner.
+
+ Complexity: Amortized constant; linear when the buffer grows.
+ */
+template <class T>
+void
+ws_deque<T>::push(const_ref element)
+{
+    auto b = _bottom.load(std::memory_order_relaxed);
+    auto t = _top.load(std::memory_order_acquire);
+    auto a = _buffer.load(std::memory_order_relaxed);
+
+    if (b - t > a->capacity - 1) {
+        _retired.emplace_back(a);
+        a = a->grow(t, b);
+        _buffer.store(a, std::memory_order_release);
+    }
+
+    a->put(b, element);
+    std::atomic_thread_fence(std::memory_order_release);
+    _bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+
+/*
+ Function: pop
+ Parameters:
+  - out: Receives the element if one was taken.
+ Return value: Whether an element was taken.
+
+ Description:
+    Takes the most recently pushed element. Must only be called by the
+    owner. Races with thieves only when a single element remains, in which
+    case the CAS on top decides the winner.
+
+ Complexity: Constant.
+ */
+template <class T>
+bool
+ws_deque<T>::pop(reference out)
+{
+    auto b = _bottom.load(std::memory_order_relaxed) - 1;
+    auto a = _buffer.load(std::memory_order_relaxed);
+    _bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = _top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    out = a->get(b);
+    if (t == b) {
+        bool won = _top.compare_exchange_strong(t, t + 1,
+                                                std::memory_order_seq_cst,
+                                                std::memory_order_relaxed);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    return true;
+}
+
+
+
+// Thief operations
+
+/*
+ Function: steal
+ Parameters:
+  - out: Receives the element if one was stolen.
+ Return value: Whether an element was stolen. A false return may be spurious
+               if another thread won the race for the same element.
+
+ Description:
+    Takes the oldest element from the top of the deque. May be called by
+    any thread.
+
+ Complexity: Constant.
+ */
+template <class T>
+bool
+ws_deque<T>::steal(reference out)
+{
+    auto t = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = _bottom.load(std::memory_order_acquire);
+
+    if (t >= b)
+        return false;
+
+    auto a = _buffer.load(std::memory_order_acquire);
+    out = a->get(t);
+
+    return _top.compare_exchange_strong(t, t + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+}
+
+
+} // end namespace
 
 #endif /* deque_h */
@@ -0,0 +1,418 @@
+/*
+ File:   disjoint_set.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Union-find over elements 0..n-1: which set is an element in, and
+    merge two sets. disjoint_set is for one thread; concurrent_disjoint_set
+    takes unites and queries from any number of threads at once.
+
+ Implementation:
+  - Both link by rank: the root of lower rank goes under the other, and
+    equal ranks break the tie by index with the survivor's rank going up.
+    Trees stay O(log n) deep and, with path compression, operations cost
+    an amortised inverse Ackermann.
+  - disjoint_set compresses fully: after a find, every node on the path
+    points at the root.
+  - concurrent_disjoint_set packs each element's rank and parent into one
+    64-bit atomic word (Anderson and Woll). A find halves the path as it
+    goes, each node's parent CASed to its grandparent; a failed CAS means
+    someone else changed that node and is simply not retried, so find
+    finishes in a bounded number of its own steps whatever other threads
+    do. A unite links one root under another with a CAS that only succeeds
+    while the first is still a root of that rank; if another unite got
+    there first it finds the new roots and tries again, so some unite
+    always succeeds. Raising the rank after an equal-rank link is a
+    separate CAS that may lose to a later link, which costs balance but
+    never correctness.
+  - connected in the concurrent set finds both roots and, if they differ,
+    checks that the first is still a root: if so the answer held at that
+    moment, if not it retries.
+
+ TODO:
+  - Deletion from a set.
+ */
+
+
+#ifndef disjoint_set_h
+#define disjoint_set_h
+
+#include <atomic>     // atomic
+#include <cstdint>    // uint8_t, uint32_t, uint64_t
+#include <memory>     // unique_ptr
+#include <stdexcept>  // out_of_range, length_error
+#include <utility>    // swap
+#include <vector>     // vector
+
+namespace ads {
+
+class disjoint_set {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+
+
+/* Data members */
+private:
+    std::vector<size_type> _parent;
+    std::vector<std::uint8_t> _rank;
+    size_type _sets = 0;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit disjoint_set(size_type = 0);
+
+    /* Capacity */
+    size_type size() const;
+    size_type sets() const;
+
+    /* Modifiers */
+    size_type add();
+    void resize(size_type);
+    bool unite(size_type, size_type);
+    void clear();
+
+    /* Operations */
+    size_type find(size_type);
+    bool connected(size_type, size_type);
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - n: The number of elements, each alone in its own set.
+ Return value: None
+
+ Complexity: Linear.
+ */
+inline
+disjoint_set::disjoint_set(size_type n)
+{
+    resize(n);
+}
+
+
+
+// Capacity
+
+/*
+ Function: size / sets
+ Return value: The number of elements, and of sets among them.
+ */
+inline disjoint_set::size_type
+disjoint_set::size() const
+{
+    return _parent.size();
+}
+
+inline disjoint_set::size_type
+disjoint_set::sets() const
+{
+    return _sets;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: add / resize
+ Parameters:
+  - n: The new number of elements, at least size().
+ Return value: add returns the new element.
+
+ Description:
+    Adds singleton sets.
+
+ Complexity: Amortised constant per element.
+
+ Exceptions:
+    resize throws std::out_of_range if n is below size().
+ */
+inline disjoint_set::size_type
+disjoint_set::add()
+{
+    resize(size() + 1);
+    return size() - 1;
+}
+
+inline void
+disjoint_set::resize(size_type n)
+{
+    if (n < size())
+        throw std::out_of_range("disjoint_set::resize: cannot remove elements");
+
+    _sets += n - size();
+    _rank.resize(n, 0);
+    for (auto x = _parent.size(); x < n; ++x)
+        _parent.push_back(x);
+}
+
+
+/*
+ Function: unite
+ Parameters:
+  - a, b: Two elements.
+ Return value: Whether they were in different sets, now merged.
+
+ Complexity: Amortised inverse Ackermann.
+ */
+inline bool
+disjoint_set::unite(size_type a, size_type b)
+{
+    a = find(a);
+    b = find(b);
+    if (a == b)
+        return false;
+
+    if (_rank[a] > _rank[b] || (_rank[a] == _rank[b] && a > b))
+        std::swap(a, b);
+    _parent[a] = b;
+    if (_rank[a] == _rank[b])
+        ++_rank[b];
+    --_sets;
+    return true;
+}
+
+
+/*
+ Function: clear
+ Description:
+    Puts every element back in a set of its own.
+
+ Complexity: Linear.
+ */
+inline void
+disjoint_set::clear()
+{
+    for (size_type x = 0; x < size(); ++x)
+        _parent[x] = x;
+    _rank.assign(size(), 0);
+    _sets = size();
+}
+
+
+
+// Operations
+
+/*
+ Function: find / connected
+ Parameters:
+  - x, a, b: Elements.
+ Return value: The representative of x's set, and whether a and b share
+               a set.
+
+ Complexity: Amortised inverse Ackermann.
+ */
+inline disjoint_set::size_type
+disjoint_set::find(size_type x)
+{
+    auto root = x;
+    while (_parent[root] != root)
+        root = _parent[root];
+    while (_parent[x] != root) {
+        auto next = _parent[x];
+        _parent[x] = root;
+        x = next;
+    }
+    return root;
+}
+
+inline bool
+disjoint_set::connected(size_type a, size_type b)
+{
+    return find(a) == find(b);
+}
+
+
+
+
+class concurrent_disjoint_set {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+
+
+/* Data members */
+private:
+    // Rank in the high 32 bits, parent in the low 32.
+    std::unique_ptr<std::atomic<std::uint64_t>[]> _nodes;
+    size_type _size;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit concurrent_disjoint_set(size_type);
+    concurrent_disjoint_set(const concurrent_disjoint_set&) = delete;
+    concurrent_disjoint_set& operator=(const concurrent_disjoint_set&) = delete;
+
+    /* Capacity */
+    size_type size() const;
+
+    /* Modifiers */
+    bool unite(size_type, size_type);
+
+    /* Operations */
+    size_type find(size_type);
+    bool connected(size_type, size_type);
+
+/* Helper functions */
+private:
+    static std::uint64_t pack(std::uint64_t rank, std::uint64_t parent) { return rank << 32 | parent; }
+    static size_type parent_of(std::uint64_t node) { return static_cast<size_type>(node & 0xffffffffu); }
+    static std::uint64_t rank_of(std::uint64_t node) { return node >> 32; }
+    bool is_root(size_type) const;
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - n: The number of elements, each alone in its own set. The size is
+       fixed, so no operation ever reallocates under another thread.
+ Return value: None
+
+ Complexity: Linear.
+
+ Exceptions:
+    Throws std::length_error if n does not fit in 32 bits.
+ */
+inline
+concurrent_disjoint_set::concurrent_disjoint_set(size_type n)
+    : _nodes()
+    , _size(n)
+{
+    if (n > 0xffffffffu)
+        throw std::length_error("concurrent_disjoint_set: at most 2^32 - 1 elements");
+
+    _nodes.reset(new std::atomic<std::uint64_t>[n]);
+    for (size_type x = 0; x < n; ++x)
+        _nodes[x].store(pack(0, x), std::memory_order_relaxed);
+}
+
+
+
+// Capacity
+
+inline concurrent_disjoint_set::size_type
+concurrent_disjoint_set::size() const
+{
+    return _size;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: unite
+ Parameters:
+  - a, b: Two elements.
+ Return value: Whether this call merged their sets; false if they already
+               shared one, including through a concurrent unite.
+
+ Complexity: Amortised inverse Ackermann without contention. Lock-free:
+             a retry means another unite succeeded.
+ */
+inline bool
+concurrent_disjoint_set::unite(size_type a, size_type b)
+{
+    for (;;) {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return false;
+
+        auto node_a = _nodes[a].load(std::memory_order_acquire);
+        auto node_b = _nodes[b].load(std::memory_order_acquire);
+        if (parent_of(node_a) != a || parent_of(node_b) != b)
+            continue;
+
+        auto rank_a = rank_of(node_a), rank_b = rank_of(node_b);
+        if (rank_a > rank_b || (rank_a == rank_b && a > b)) {
+            std::swap(a, b);
+            std::swap(node_a, node_b);
+            std::swap(rank_a, rank_b);
+        }
+
+        // Link a under b, provided a is still the root it was.
+        if (!_nodes[a].compare_exchange_strong(node_a, pack(rank_a, b), std::memory_order_acq_rel))
+            continue;
+
+        if (rank_a == rank_b)
+            _nodes[b].compare_exchange_strong(node_b, pack(rank_b + 1, b), std::memory_order_acq_rel);
+        return true;
+    }
+}
+
+
+
+// Operations
+
+/*
+ Function: find / connected
+ Parameters:
+  - x, a, b: Elements.
+ Return value: The representative of x's set at some moment during the
+               call, and whether a and b shared a set at some moment
+               during it.
+
+ Complexity: Amortised inverse Ackermann. find is wait-free; connected
+             retries only while its first root is being linked.
+ */
+inline concurrent_disjoint_set::size_type
+concurrent_disjoint_set::find(size_type x)
+{
+    for (;;) {
+        auto node = _nodes[x].load(std::memory_order_acquire);
+        auto parent = parent_of(node);
+        if (parent == x)
+            return x;
+
+        auto up = _nodes[parent].load(std::memory_order_acquire);
+        auto grandparent = parent_of(up);
+        if (grandparent != parent)
+            _nodes[x].compare_exchange_weak(node, pack(rank_of(node), grandparent), std::memory_order_acq_rel);
+        x = grandparent;
+    }
+}
+
+inline bool
+concurrent_disjoint_set::connected(size_type a, size_type b)
+{
+    for (;;) {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+            return true;
+        if (is_root(a))
+            return false;
+    }
+}
+
+
+
+// Helper functions
+
+inline bool
+concurrent_disjoint_set::is_root(size_type x) const
+{
+    return parent_of(_nodes[x].load(std::memory_order_acquire)) == x;
+}
+
+
+} // end namespace
+
+#endif /* disjoint_set_h */
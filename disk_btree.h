@@ -0,0 +1,1397 @@
+/*
+ File:   disk_btree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A B+ tree whose pages live in a file. Opening an existing index maps
+    the file rather than reading it, so a process can start serving
+    lookups straight away, and the index may be far larger than memory:
+    the kernel keeps whichever pages are hot. Updates are grouped into
+    transactions that either reach the disk whole or not at all.
+
+ Implementation:
+  - The file is an array of PageSize pages. Pages 0 and 1 hold two copies
+    of the meta record (root, height, size, page count, generation and a
+    checksum); the valid copy with the higher generation is current.
+  - Pages are copy-on-write. The first change to a committed page in a
+    transaction copies it to a free page and rewrites the parent's child
+    id, which is itself copied first, so a transaction builds a new tree
+    beside the committed one and never touches a page the committed root
+    can reach. commit writes the new pages, syncs, writes the meta record
+    over the older copy and syncs again. A crash at any point leaves one
+    of the two trees intact.
+  - Committed pages are read through a read-only shared mapping. Pages
+    written in the current transaction sit in a page cache; past
+    cache_pages the least recently used are written to their place in
+    the file early, which is safe because nothing committed refers to
+    them, and read back with pread if needed again. A mutation trims the
+    cache before it starts, so page pointers stay valid within it.
+  - Pages replaced in a transaction become free once it commits. The free
+    list is not stored: the first transaction after opening walks the
+    internal pages of the committed tree and takes every page id they do
+    not reach.
+  - Leaves are not linked to their neighbours. Under copy-on-write a
+    sibling pointer would force a copy of every leaf to the left of a
+    changed one. Iterators and scan keep the path from the root instead
+    and step to the next leaf through the lowest ancestor with a child to
+    the right, which visits leaves in the same order.
+  - Keys and values are stored as raw bytes, so both must be trivially
+    copyable, and Compare must order them the same way every time the
+    file is opened.
+  - Not thread safe: even lookups may move pages in the cache.
+
+ TODO:
+  - Borrow and merge on erase. Leaves are only removed once empty, so a
+    tree that shrinks a lot keeps mostly empty pages until rebuilt.
+ */
+
+
+#ifndef disk_btree_h
+#define disk_btree_h
+
+#include "btree.h"      // btree_search
+
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap, madvise
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // pread, pwrite, fdatasync
+
+#include <algorithm>     // copy, copy_backward, max
+#include <cerrno>        // errno
+#include <cstddef>       // offsetof
+#include <cstdint>       // uint64_t
+#include <cstring>       // memcpy
+#include <functional>    // less
+#include <iterator>      // iterator
+#include <list>          // list
+#include <memory>        // unique_ptr
+#include <stdexcept>     // runtime_error
+#include <string>        // string
+#include <system_error>  // system_error
+#include <type_traits>   // is_trivially_copyable
+#include <unordered_map> // unordered_map
+#include <unordered_set> // unordered_set
+#include <utility>       // pair
+#include <vector>        // vector
+
+namespace ads {
+
+template <class Key, class Value, class Compare = std::less<Key>, std::size_t PageSize = 4096>
+class disk_btree {
+
+/* Type definitions */
+public:
+    typedef std::size_t   size_type;
+    typedef Key           key_type;
+    typedef Value         mapped_type;
+    typedef const Key&    const_ref;
+    typedef std::uint64_t page_id;
+
+
+/* Page definitions */
+private:
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "keys and values are stored as raw bytes");
+
+    struct Header {
+        std::uint16_t leaf;
+        std::uint16_t count;      // Keys in the page.
+        std::uint32_t unused;
+    };
+
+    static constexpr size_type leaf_slots = (PageSize - sizeof(Header)) / (sizeof(Key) + sizeof(Value));
+    static constexpr size_type internal_slots =
+        (PageSize - sizeof(Header) - sizeof(page_id)) / (sizeof(Key) + sizeof(page_id));
+    static constexpr unsigned max_depth = 32;
+
+    static_assert(leaf_slots >= 2 && internal_slots >= 3, "a page must hold two entries and three keys");
+    static_assert(leaf_slots < 65536 && internal_slots < 65536, "page counts are 16 bit");
+
+    struct Leaf {
+        Header header;
+        Key keys[leaf_slots];
+        Value values[leaf_slots];
+    };
+
+    struct Internal {
+        Header header;
+        page_id children[internal_slots + 1];
+        Key keys[internal_slots];
+    };
+
+    static_assert(sizeof(Leaf) <= PageSize && sizeof(Internal) <= PageSize, "padding overflows the page");
+
+    struct Meta {
+        std::uint64_t magic;
+        std::uint32_t version;
+        std::uint32_t page_size;
+        std::uint32_t key_size;
+        std::uint32_t value_size;
+        std::uint64_t generation;
+        page_id root;             // 0 when empty.
+        std::uint64_t height;
+        std::uint64_t size;
+        std::uint64_t pages;      // Every page in use has a lower id.
+        std::uint64_t checksum;
+    };
+
+    static constexpr std::uint64_t file_magic = 0x65657274626b7364;   // "dskbtree"
+    static constexpr std::uint32_t file_version = 1;
+
+    struct Buffer {
+        std::unique_ptr<char[]> bytes;
+        std::list<page_id>::iterator use;
+    };
+
+    typedef btree_search<Key, Compare> search;
+
+
+/* Iterators */
+public:
+    // Forward only, and invalidated by any change to the tree.
+    class const_iterator : public std::iterator<std::forward_iterator_tag, std::pair<Key, Value>, std::ptrdiff_t,
+                                                const std::pair<Key, Value>*, std::pair<Key, Value>> {
+
+        friend class disk_btree<Key, Value, Compare, PageSize>;
+
+    private:
+        const disk_btree<Key, Value, Compare, PageSize>* owner = nullptr;
+        page_id path[max_depth] = {};         // path[depth - 1] is the leaf.
+        std::uint16_t slot[max_depth] = {};   // The child taken, or the entry in the leaf.
+        unsigned depth = 0;                   // 0 at the end.
+
+    public:
+        std::pair<Key, Value> operator*() const { return std::pair<Key, Value>(key(), value()); }
+        Key key() const { return owner->leaf_page(path[depth - 1])->keys[slot[depth - 1]]; }
+        Value value() const { return owner->leaf_page(path[depth - 1])->values[slot[depth - 1]]; }
+
+        const_iterator& operator++() { owner->advance(*this); return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); ++*this; return temp; }
+
+        bool operator==(const const_iterator& rhs) const
+        {
+            return depth == rhs.depth
+                && (!depth || (path[depth - 1] == rhs.path[depth - 1] && slot[depth - 1] == rhs.slot[depth - 1]));
+        }
+        bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+    };
+
+
+/* Data members */
+private:
+    int _fd = -1;
+    const char* _map = nullptr;
+    size_type _mapped = 0;                  // Bytes.
+    Meta _committed;
+
+    page_id _root = 0;                      // The working tree.
+    unsigned _height = 0;
+    size_type _size = 0;
+    page_id _pages = 0;
+
+    size_type _capacity;
+    mutable std::unordered_map<page_id, Buffer> _cache;
+    mutable std::list<page_id> _lru;        // Most recently used first.
+    std::unordered_set<page_id> _fresh;     // Allocated in this transaction.
+    std::vector<page_id> _free;
+    std::vector<page_id> _retired;          // Free once this transaction commits.
+    bool _free_known = false;
+    Compare _compare;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit disk_btree(const std::string&, size_type = 1024);
+    disk_btree(const disk_btree<Key, Value, Compare, PageSize>&) = delete;
+    disk_btree& operator=(const disk_btree<Key, Value, Compare, PageSize>&) = delete;
+    ~disk_btree();
+
+    /* Iterators */
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    unsigned height() const;
+    size_type page_count() const;
+    size_type cached_pages() const;
+
+    /* Element access */
+    bool has(const_ref) const;
+    bool find(const_ref, Value&) const;
+    const_iterator lower_bound(const_ref) const;
+    template <class Function>
+        void scan(const_ref, const_ref, Function) const;
+
+    /* Modifiers */
+    bool insert(const_ref, const Value&);
+    bool assign(const_ref, const Value&);
+    bool erase(const_ref);
+
+    /* Transactions */
+    void commit();
+    void rollback();
+    std::uint64_t generation() const;
+
+/* Helper functions */
+private:
+    const char* page(page_id) const;
+    const Leaf* leaf_page(page_id id) const { return reinterpret_cast<const Leaf*>(page(id)); }
+    const Internal* internal_page(page_id id) const { return reinterpret_cast<const Internal*>(page(id)); }
+    const char* load(page_id) const;
+    char* writable(page_id&);
+    char* allocate(page_id&);
+    void release(page_id);
+    void trim();
+    void find_free();
+
+    size_type child_slot(const Internal*, const_ref) const;
+    const Leaf* descend(const_ref) const;
+    Leaf* descend_writable(const_ref, char**, size_type*);
+    void insert_into_parent(char**, size_type*, Key, page_id);
+    bool put(const_ref, const Value&);
+    void advance(const_iterator&) const;
+    void leftmost(const_iterator&, unsigned) const;
+
+    Meta make_meta(std::uint64_t) const;
+    static std::uint64_t checksum(const Meta&);
+    bool valid(const Meta&) const;
+    void restore(const Meta&);
+    void read_at(char*, size_type, std::uint64_t) const;
+    void write_at(const char*, size_type, std::uint64_t);
+    void sync();
+    void remap();
+};
+
+
+template <class Key, class Value, class Compare, std::size_t PageSize>
+constexpr typename disk_btree<Key, Value, Compare, PageSize>::size_type disk_btree<Key, Value, Compare, PageSize>::leaf_slots;
+template <class Key, class Value, class Compare, std::size_t PageSize>
+constexpr typename disk_btree<Key, Value, Compare, PageSize>::size_type disk_btree<Key, Value, Compare, PageSize>::internal_slots;
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - path: The index file. Created empty if it does not exist.
+  - cache_pages: How many pages written in a transaction to keep in
+                 memory before writing the least recently used ones out.
+
+ Description:
+    Maps the file and takes the newest meta record whose checksum holds.
+    Throws std::system_error if the file cannot be opened, read or mapped
+    and std::runtime_error if it is not an index with this page size, key
+    size and value size.
+
+ Complexity: Constant; no tree pages are read.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+disk_btree<Key, Value, Compare, PageSize>::disk_btree(const std::string& path, size_type cache_pages)
+    : _capacity(cache_pages)
+{
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd < 0)
+        throw std::system_error(errno, std::generic_category(), "disk_btree: open " + path);
+
+    try {
+        struct stat info;
+        if (::fstat(_fd, &info) != 0)
+            throw std::system_error(errno, std::generic_category(), "disk_btree: fstat " + path);
+
+        if (info.st_size == 0) {
+            _pages = 2;
+            auto meta = make_meta(1);
+            std::unique_ptr<char[]> bytes(new char[2 * PageSize]());
+            std::memcpy(bytes.get() + PageSize, &meta, sizeof(meta));
+            write_at(bytes.get(), 2 * PageSize, 0);
+            sync();
+            _committed = meta;
+        } else {
+            Meta copies[2];
+            std::memset(copies, 0, sizeof(copies));
+            for (int i = 0; i < 2; ++i)
+                if (static_cast<std::uint64_t>(info.st_size) >= (i + 1) * PageSize)
+                    read_at(reinterpret_cast<char*>(&copies[i]), sizeof(Meta), i * PageSize);
+
+            bool first = valid(copies[0]), second = valid(copies[1]);
+            if (!first && !second)
+                throw std::runtime_error("disk_btree: " + path + " is not a compatible index");
+            _committed = (first && (!second || copies[0].generation > copies[1].generation)) ? copies[0] : copies[1];
+        }
+
+        restore(_committed);
+        remap();
+    } catch (...) {
+        ::close(_fd);
+        throw;
+    }
+}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Unmaps and closes the file. Changes since the last commit are lost,
+    exactly as if the process had crashed.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+disk_btree<Key, Value, Compare, PageSize>::~disk_btree()
+{
+    if (_map)
+        ::munmap(const_cast<char*>(_map), _mapped);
+    ::close(_fd);
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin
+ Return value: An iterator to the smallest key.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::const_iterator
+disk_btree<Key, Value, Compare, PageSize>::begin() const
+{
+    const_iterator it;
+    it.owner = this;
+    if (_root) {
+        it.path[0] = _root;
+        it.depth = _height;
+        leftmost(it, 0);
+    }
+
+    return it;
+}
+
+
+/*
+ Function: end
+ Return value: The iterator past the largest key.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::const_iterator
+disk_btree<Key, Value, Compare, PageSize>::end() const
+{
+    const_iterator it;
+    it.owner = this;
+    return it;
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty
+ Return value: Whether the working tree has no keys.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::empty() const
+{
+    return !_size;
+}
+
+
+/*
+ Function: size
+ Return value: The number of keys in the working tree, committed or not.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::size_type
+disk_btree<Key, Value, Compare, PageSize>::size() const
+{
+    return _size;
+}
+
+
+/*
+ Function: height
+ Return value: Levels in the tree, counting the leaves; 0 when empty.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+unsigned
+disk_btree<Key, Value, Compare, PageSize>::height() const
+{
+    return _height;
+}
+
+
+/*
+ Function: page_count
+ Return value: The number of pages the file needs, meta pages included.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::size_type
+disk_btree<Key, Value, Compare, PageSize>::page_count() const
+{
+    return _pages;
+}
+
+
+/*
+ Function: cached_pages
+ Return value: The number of pages held in memory for this transaction.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::size_type
+disk_btree<Key, Value, Compare, PageSize>::cached_pages() const
+{
+    return _cache.size();
+}
+
+
+
+// Element access
+
+/*
+ Function: has
+ Parameters:
+  - key: The key to look for.
+ Return value: Whether key is in the working tree.
+
+ Complexity: Logarithmic; one page per level.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::has(const_ref key) const
+{
+    if (!_root)
+        return false;
+
+    auto leaf = descend(key);
+    auto i = search::lower(leaf->keys, leaf->header.count, key, _compare);
+    return i < leaf->header.count && !_compare(key, leaf->keys[i]);
+}
+
+
+/*
+ Function: find
+ Parameters:
+  - key: The key to look for.
+  - value: Set to the key's value if it is present.
+ Return value: Whether key is in the working tree.
+
+ Complexity: Logarithmic; one page per level.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::find(const_ref key, Value& value) const
+{
+    if (!_root)
+        return false;
+
+    auto leaf = descend(key);
+    auto i = search::lower(leaf->keys, leaf->header.count, key, _compare);
+    if (i == leaf->header.count || _compare(key, leaf->keys[i]))
+        return false;
+
+    value = leaf->values[i];
+    return true;
+}
+
+
+/*
+ Function: lower_bound
+ Parameters:
+  - key: The key to look for.
+ Return value: An iterator to the first key not less than key.
+
+ Complexity: Logarithmic.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::const_iterator
+disk_btree<Key, Value, Compare, PageSize>::lower_bound(const_ref key) const
+{
+    auto it = end();
+    if (!_root)
+        return it;
+
+    it.depth = _height;
+    page_id id = _root;
+    for (unsigned level = 0; level + 1 < _height; ++level) {
+        auto node = internal_page(id);
+        it.path[level] = id;
+        it.slot[level] = static_cast<std::uint16_t>(child_slot(node, key));
+        id = node->children[it.slot[level]];
+    }
+
+    auto leaf = leaf_page(id);
+    auto i = search::lower(leaf->keys, leaf->header.count, key, _compare);
+    it.path[_height - 1] = id;
+    if (i < leaf->header.count) {
+        it.slot[_height - 1] = static_cast<std::uint16_t>(i);
+    } else {
+        it.slot[_height - 1] = static_cast<std::uint16_t>(i - 1);
+        advance(it);
+    }
+
+    return it;
+}
+
+
+/*
+ Function: scan
+ Parameters:
+  - from: The first key to visit, if present.
+  - to: The end of the range, not visited.
+  - f: Called as f(key, value) for each key in [from, to), in order.
+
+ Description:
+    Works a leaf at a time, so it costs one page lookup per leaf rather
+    than one per key as the iterators do.
+
+ Complexity: Logarithmic plus linear in the keys visited.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+template <class Function>
+void
+disk_btree<Key, Value, Compare, PageSize>::scan(const_ref from, const_ref to, Function f) const
+{
+    for (auto it = lower_bound(from); it.depth;) {
+        auto leaf = leaf_page(it.path[it.depth - 1]);
+        size_type n = leaf->header.count;
+        for (size_type i = it.slot[it.depth - 1]; i < n; ++i) {
+            if (!_compare(leaf->keys[i], to))
+                return;
+            f(leaf->keys[i], leaf->values[i]);
+        }
+
+        it.slot[it.depth - 1] = static_cast<std::uint16_t>(n - 1);
+        advance(it);
+    }
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert
+ Parameters:
+  - key: The key to add.
+  - value: Its value.
+ Return value: Whether key was added; an existing key keeps its value.
+
+ Complexity: Logarithmic. The first change under a committed page copies
+             the path to it.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::insert(const_ref key, const Value& value)
+{
+    if (has(key))
+        return false;
+
+    return put(key, value);
+}
+
+
+/*
+ Function: assign
+ Parameters:
+  - key: The key to add or update.
+  - value: Its new value.
+ Return value: Whether key was added rather than updated.
+
+ Complexity: Logarithmic.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::assign(const_ref key, const Value& value)
+{
+    return put(key, value);
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - key: The key to remove.
+ Return value: Whether the key was present.
+
+ Description:
+    A leaf left empty is removed from its parent, and so on up; the root
+    is replaced by its only child while it has one. Other underfull pages
+    are left as they are.
+
+ Complexity: Logarithmic.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::erase(const_ref key)
+{
+    if (!has(key))
+        return false;
+
+    trim();
+    find_free();
+
+    char* nodes[max_depth];
+    size_type slots[max_depth];
+    auto leaf = descend_writable(key, nodes, slots);
+    size_type n = leaf->header.count;
+    auto i = search::lower(leaf->keys, n, key, _compare);
+    std::copy(leaf->keys + i + 1, leaf->keys + n, leaf->keys + i);
+    std::copy(leaf->values + i + 1, leaf->values + n, leaf->values + i);
+    leaf->header.count = static_cast<std::uint16_t>(n - 1);
+    --_size;
+
+    if (leaf->header.count)
+        return true;
+
+    // Remove the empty leaf, and any parent it leaves without children.
+    int level = static_cast<int>(_height) - 2;
+    for (; level >= 0; --level) {
+        auto node = reinterpret_cast<Internal*>(nodes[level]);
+        release(node->children[slots[level]]);
+        if (!node->header.count)
+            continue;
+
+        size_type s = slots[level], count = node->header.count;
+        size_type key_at = s ? s - 1 : 0;
+        std::copy(node->keys + key_at + 1, node->keys + count, node->keys + key_at);
+        std::copy(node->children + s + 1, node->children + count + 1, node->children + s);
+        node->header.count = static_cast<std::uint16_t>(count - 1);
+        break;
+    }
+
+    if (level < 0) {
+        release(_root);
+        _root = 0;
+        _height = 0;
+        return true;
+    }
+
+    while (_height > 1) {
+        auto root = internal_page(_root);
+        if (root->header.count)
+            break;
+        auto only = root->children[0];
+        release(_root);
+        _root = only;
+        --_height;
+    }
+
+    return true;
+}
+
+
+
+// Transactions
+
+/*
+ Function: commit
+ Description:
+    Makes every change since the last commit durable. The new pages are
+    written and synced before the meta record that points at them, and
+    the meta record replaces the older of the two copies, so the previous
+    commit stays readable until this one is complete. Throws
+    std::system_error if a write or sync fails; the working tree is then
+    unchanged and commit may be retried.
+
+ Complexity: Linear in the pages changed, plus two syncs.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::commit()
+{
+    if (_fresh.empty() && _retired.empty())
+        return;
+
+    for (auto& entry : _cache)
+        write_at(entry.second.bytes.get(), PageSize, entry.first * PageSize);
+    sync();
+
+    auto meta = make_meta(_committed.generation + 1);
+    std::unique_ptr<char[]> bytes(new char[PageSize]());
+    std::memcpy(bytes.get(), &meta, sizeof(meta));
+    write_at(bytes.get(), PageSize, (meta.generation % 2) * PageSize);
+    sync();
+
+    _committed = meta;
+    _cache.clear();
+    _lru.clear();
+    _fresh.clear();
+    _free.insert(_free.end(), _retired.begin(), _retired.end());
+    _retired.clear();
+    remap();
+}
+
+
+/*
+ Function: rollback
+ Description:
+    Discards every change since the last commit. Pages already written
+    out of the cache are left in the file unreferenced and reused later.
+
+ Complexity: Linear in the pages changed.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::rollback()
+{
+    _cache.clear();
+    _lru.clear();
+    _fresh.clear();
+    _retired.clear();
+    _free.clear();
+    _free_known = false;
+    restore(_committed);
+}
+
+
+/*
+ Function: generation
+ Return value: How many commits the file has seen.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+std::uint64_t
+disk_btree<Key, Value, Compare, PageSize>::generation() const
+{
+    return _committed.generation;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: page
+ Parameters:
+  - id: A page of the working tree.
+ Return value: Its bytes: from the cache if it changed in this
+               transaction, otherwise from the mapping.
+
+ Description:
+    After a commit the cache is empty and this is pointer arithmetic.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+const char*
+disk_btree<Key, Value, Compare, PageSize>::page(page_id id) const
+{
+    if (!_fresh.empty()) {
+        auto found = _cache.find(id);
+        if (found != _cache.end()) {
+            _lru.splice(_lru.begin(), _lru, found->second.use);
+            return found->second.bytes.get();
+        }
+        if (_fresh.count(id))
+            return load(id);
+    }
+
+    return _map + id * PageSize;
+}
+
+
+/*
+ Function: load
+ Parameters:
+  - id: A page of this transaction that was written out of the cache.
+ Return value: Its bytes, read back into the cache.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+const char*
+disk_btree<Key, Value, Compare, PageSize>::load(page_id id) const
+{
+    std::unique_ptr<char[]> bytes(new char[PageSize]);
+    read_at(bytes.get(), PageSize, id * PageSize);
+    _lru.push_front(id);
+    auto& buffer = _cache[id];
+    buffer.bytes = std::move(bytes);
+    buffer.use = _lru.begin();
+    return buffer.bytes.get();
+}
+
+
+/*
+ Function: writable
+ Parameters:
+  - id: A page of the working tree. Replaced by the id of its copy if it
+        had to be copied.
+ Return value: Bytes that may be changed in place.
+
+ Description:
+    A page from this transaction is changed in place. A committed page is
+    copied to a new page and retired; the caller must point the parent
+    at the new id.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+char*
+disk_btree<Key, Value, Compare, PageSize>::writable(page_id& id)
+{
+    if (_fresh.count(id))
+        return const_cast<char*>(page(id));
+
+    page_id copy;
+    auto bytes = allocate(copy);
+    std::memcpy(bytes, page(id), PageSize);
+    _retired.push_back(id);
+    id = copy;
+    return bytes;
+}
+
+
+/*
+ Function: allocate
+ Parameters:
+  - id: Set to the new page's id.
+ Return value: The new page's bytes, zeroed, in the cache.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+char*
+disk_btree<Key, Value, Compare, PageSize>::allocate(page_id& id)
+{
+    if (!_free.empty()) {
+        id = _free.back();
+        _free.pop_back();
+    } else {
+        id = _pages++;
+    }
+
+    _fresh.insert(id);
+    _lru.push_front(id);
+    auto& buffer = _cache[id];
+    buffer.bytes.reset(new char[PageSize]());
+    buffer.use = _lru.begin();
+    return buffer.bytes.get();
+}
+
+
+/*
+ Function: release
+ Parameters:
+  - id: A page no longer in the working tree.
+
+ Description:
+    A page from this transaction is free at once. A committed page is
+    still part of the committed tree, so it waits for the commit.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::release(page_id id)
+{
+    if (!_fresh.erase(id)) {
+        _retired.push_back(id);
+        return;
+    }
+
+    auto found = _cache.find(id);
+    if (found != _cache.end()) {
+        _lru.erase(found->second.use);
+        _cache.erase(found);
+    }
+    _free.push_back(id);
+}
+
+
+/*
+ Function: trim
+ Description:
+    Writes the least recently used pages out until the cache is back to
+    its capacity. Nothing committed refers to them, so a crash afterwards
+    cannot expose them.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::trim()
+{
+    while (_cache.size() > _capacity) {
+        auto id = _lru.back();
+        write_at(_cache[id].bytes.get(), PageSize, id * PageSize);
+        _cache.erase(id);
+        _lru.pop_back();
+    }
+}
+
+
+/*
+ Function: find_free
+ Description:
+    Builds the free list on the first change after opening or rolling
+    back: every page id below the page count that the committed tree does
+    not use. Only internal pages are read; leaves are known from their
+    parents.
+
+ Complexity: Linear in the internal pages.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::find_free()
+{
+    if (_free_known)
+        return;
+
+    std::vector<bool> used(_pages, false);
+    used[0] = used[1] = true;
+
+    std::vector<std::pair<page_id, unsigned>> stack;
+    if (_root)
+        stack.emplace_back(_root, 1u);
+    while (!stack.empty()) {
+        auto top = stack.back();
+        stack.pop_back();
+        used[top.first] = true;
+        if (top.second == _height)
+            continue;
+
+        auto node = internal_page(top.first);
+        for (size_type i = 0; i <= node->header.count; ++i)
+            stack.emplace_back(node->children[i], top.second + 1);
+    }
+
+    _free.clear();
+    for (page_id id = _pages; id-- > 2;)
+        if (!used[id])
+            _free.push_back(id);
+    _free_known = true;
+}
+
+
+/*
+ Function: child_slot
+ Parameters:
+  - node: An internal page.
+  - key: The key to look for.
+ Return value: The child whose range holds key. A separator is the
+               smallest key of the child to its right.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::size_type
+disk_btree<Key, Value, Compare, PageSize>::child_slot(const Internal* node, const_ref key) const
+{
+    size_type n = node->header.count;
+    auto i = search::lower(node->keys, n, key, _compare);
+    if (i < n && !_compare(key, node->keys[i]))
+        ++i;
+
+    return i;
+}
+
+
+/*
+ Function: descend
+ Parameters:
+  - key: The key to look for.
+ Return value: The leaf whose range holds key. The tree must not be empty.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+const typename disk_btree<Key, Value, Compare, PageSize>::Leaf*
+disk_btree<Key, Value, Compare, PageSize>::descend(const_ref key) const
+{
+    page_id id = _root;
+    for (unsigned level = 0; level + 1 < _height; ++level) {
+        auto node = internal_page(id);
+        id = node->children[child_slot(node, key)];
+    }
+
+    return leaf_page(id);
+}
+
+
+/*
+ Function: descend_writable
+ Parameters:
+  - key: The key to look for.
+  - nodes: Filled with the writable page at each level, root first.
+  - slots: Filled with the child taken at each internal level.
+ Return value: The writable leaf whose range holds key.
+
+ Description:
+    Makes every page on the path writable, top down, so that each copy is
+    linked into a parent that is already a copy.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::Leaf*
+disk_btree<Key, Value, Compare, PageSize>::descend_writable(const_ref key, char** nodes, size_type* slots)
+{
+    nodes[0] = writable(_root);
+    for (unsigned level = 0; level + 1 < _height; ++level) {
+        auto node = reinterpret_cast<Internal*>(nodes[level]);
+        slots[level] = child_slot(node, key);
+        nodes[level + 1] = writable(node->children[slots[level]]);
+    }
+
+    return reinterpret_cast<Leaf*>(nodes[_height - 1]);
+}
+
+
+/*
+ Function: put
+ Parameters:
+  - key: The key to add or update.
+  - value: Its value.
+ Return value: Whether key was added.
+
+ Description:
+    A full leaf splits in half and passes the smallest key of the right
+    half up as a separator.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::put(const_ref key, const Value& value)
+{
+    trim();
+    find_free();
+
+    if (!_root) {
+        auto leaf = reinterpret_cast<Leaf*>(allocate(_root));
+        leaf->header.leaf = 1;
+        leaf->header.count = 1;
+        leaf->keys[0] = key;
+        leaf->values[0] = value;
+        _height = 1;
+        _size = 1;
+        return true;
+    }
+
+    char* nodes[max_depth];
+    size_type slots[max_depth];
+    auto leaf = descend_writable(key, nodes, slots);
+    size_type n = leaf->header.count;
+    auto i = search::lower(leaf->keys, n, key, _compare);
+    if (i < n && !_compare(key, leaf->keys[i])) {
+        leaf->values[i] = value;
+        return false;
+    }
+
+    ++_size;
+    Leaf* target = leaf;
+    if (n == leaf_slots) {
+        page_id right_id;
+        auto right = reinterpret_cast<Leaf*>(allocate(right_id));
+        size_type half = n / 2;
+        std::copy(leaf->keys + half, leaf->keys + n, right->keys);
+        std::copy(leaf->values + half, leaf->values + n, right->values);
+        right->header.leaf = 1;
+        right->header.count = static_cast<std::uint16_t>(n - half);
+        leaf->header.count = static_cast<std::uint16_t>(half);
+
+        if (i > half) {
+            target = right;
+            i -= half;
+        }
+        n = target->header.count;
+        insert_into_parent(nodes, slots, right->keys[0], right_id);
+    }
+
+    std::copy_backward(target->keys + i, target->keys + n, target->keys + n + 1);
+    std::copy_backward(target->values + i, target->values + n, target->values + n + 1);
+    target->keys[i] = key;
+    target->values[i] = value;
+    target->header.count = static_cast<std::uint16_t>(n + 1);
+    return true;
+}
+
+
+/*
+ Function: insert_into_parent
+ Parameters:
+  - nodes: The writable path from descend_writable.
+  - slots: The children taken along it.
+  - separator: The smallest key of the new page.
+  - child: The new page, to go right of the one split at the bottom of
+           the path.
+
+ Description:
+    A full internal page splits around its middle key, which moves up; a
+    split root grows the tree by a level.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::insert_into_parent(char** nodes, size_type* slots, Key separator, page_id child)
+{
+    for (int level = static_cast<int>(_height) - 2; level >= 0; --level) {
+        auto node = reinterpret_cast<Internal*>(nodes[level]);
+        size_type at = slots[level], n = node->header.count;
+        Internal* target = node;
+
+        if (n == internal_slots) {
+            page_id right_id;
+            auto right = reinterpret_cast<Internal*>(allocate(right_id));
+            size_type mid = n / 2;
+            Key up = node->keys[mid];
+            std::copy(node->keys + mid + 1, node->keys + n, right->keys);
+            std::copy(node->children + mid + 1, node->children + n + 1, right->children);
+            right->header.count = static_cast<std::uint16_t>(n - mid - 1);
+            node->header.count = static_cast<std::uint16_t>(mid);
+
+            if (at > mid) {
+                target = right;
+                at -= mid + 1;
+            }
+            size_type count = target->header.count;
+            std::copy_backward(target->keys + at, target->keys + count, target->keys + count + 1);
+            std::copy_backward(target->children + at + 1, target->children + count + 1, target->children + count + 2);
+            target->keys[at] = separator;
+            target->children[at + 1] = child;
+            target->header.count = static_cast<std::uint16_t>(count + 1);
+
+            separator = up;
+            child = right_id;
+            continue;
+        }
+
+        std::copy_backward(node->keys + at, node->keys + n, node->keys + n + 1);
+        std::copy_backward(node->children + at + 1, node->children + n + 1, node->children + n + 2);
+        node->keys[at] = separator;
+        node->children[at + 1] = child;
+        node->header.count = static_cast<std::uint16_t>(n + 1);
+        return;
+    }
+
+    page_id root_id;
+    auto root = reinterpret_cast<Internal*>(allocate(root_id));
+    root->header.count = 1;
+    root->keys[0] = separator;
+    root->children[0] = _root;
+    root->children[1] = child;
+    _root = root_id;
+    ++_height;
+}
+
+
+/*
+ Function: advance
+ Parameters:
+  - it: An iterator that is not at the end.
+
+ Description:
+    Moves within the leaf, or climbs to the lowest ancestor with a child
+    further right and takes the leftmost leaf under that child.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::advance(const_iterator& it) const
+{
+    unsigned level = it.depth - 1;
+    if (++it.slot[level] < leaf_page(it.path[level])->header.count)
+        return;
+
+    while (level-- > 0) {
+        if (it.slot[level] < internal_page(it.path[level])->header.count) {
+            ++it.slot[level];
+            leftmost(it, level);
+            return;
+        }
+    }
+
+    it.depth = 0;
+}
+
+
+/*
+ Function: leftmost
+ Parameters:
+  - it: An iterator with path[level] and slot[level] set.
+  - level: Where to start descending.
+
+ Description:
+    Follows the chosen child, then first children, down to the first
+    entry of a leaf.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::leftmost(const_iterator& it, unsigned level) const
+{
+    for (; level + 1 < it.depth; ++level) {
+        it.path[level + 1] = internal_page(it.path[level])->children[it.slot[level]];
+        it.slot[level + 1] = 0;
+    }
+}
+
+
+/*
+ Function: make_meta
+ Parameters:
+  - generation: The generation to record.
+ Return value: A meta record for the working tree.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+typename disk_btree<Key, Value, Compare, PageSize>::Meta
+disk_btree<Key, Value, Compare, PageSize>::make_meta(std::uint64_t generation) const
+{
+    Meta meta;
+    std::memset(&meta, 0, sizeof(meta));
+    meta.magic = file_magic;
+    meta.version = file_version;
+    meta.page_size = PageSize;
+    meta.key_size = sizeof(Key);
+    meta.value_size = sizeof(Value);
+    meta.generation = generation;
+    meta.root = _root;
+    meta.height = _height;
+    meta.size = _size;
+    meta.pages = _pages;
+    meta.checksum = checksum(meta);
+    return meta;
+}
+
+
+/*
+ Function: checksum
+ Parameters:
+  - meta: A meta record.
+ Return value: FNV-1a over every field before the checksum.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+std::uint64_t
+disk_btree<Key, Value, Compare, PageSize>::checksum(const Meta& meta)
+{
+    auto bytes = reinterpret_cast<const unsigned char*>(&meta);
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (size_type i = 0; i < offsetof(Meta, checksum); ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001b3;
+
+    return hash;
+}
+
+
+/*
+ Function: valid
+ Parameters:
+  - meta: A meta record read from the file.
+ Return value: Whether it is intact and describes pages of this type.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+bool
+disk_btree<Key, Value, Compare, PageSize>::valid(const Meta& meta) const
+{
+    return meta.magic == file_magic && meta.version == file_version && meta.page_size == PageSize
+        && meta.key_size == sizeof(Key) && meta.value_size == sizeof(Value)
+        && meta.checksum == checksum(meta) && meta.height <= max_depth;
+}
+
+
+/*
+ Function: restore
+ Parameters:
+  - meta: The committed meta record.
+
+ Description:
+    Makes the working tree the committed one.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::restore(const Meta& meta)
+{
+    _root = meta.root;
+    _height = static_cast<unsigned>(meta.height);
+    _size = meta.size;
+    _pages = meta.pages;
+}
+
+
+/*
+ Function: read_at
+ Parameters:
+  - bytes: Where to read to.
+  - count: How many bytes.
+  - offset: Where in the file.
+
+ Description:
+    Reads past the end of the file as zeros.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::read_at(char* bytes, size_type count, std::uint64_t offset) const
+{
+    while (count) {
+        auto got = ::pread(_fd, bytes, count, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got < 0)
+            throw std::system_error(errno, std::generic_category(), "disk_btree: pread");
+        if (got == 0) {
+            std::memset(bytes, 0, count);
+            return;
+        }
+        bytes += got;
+        count -= static_cast<size_type>(got);
+        offset += static_cast<std::uint64_t>(got);
+    }
+}
+
+
+/*
+ Function: write_at
+ Parameters:
+  - bytes: What to write.
+  - count: How many bytes.
+  - offset: Where in the file.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::write_at(const char* bytes, size_type count, std::uint64_t offset)
+{
+    while (count) {
+        auto put = ::pwrite(_fd, bytes, count, static_cast<off_t>(offset));
+        if (put < 0 && errno == EINTR)
+            continue;
+        if (put < 0)
+            throw std::system_error(errno, std::generic_category(), "disk_btree: pwrite");
+        bytes += put;
+        count -= static_cast<size_type>(put);
+        offset += static_cast<std::uint64_t>(put);
+    }
+}
+
+
+/*
+ Function: sync
+ Description:
+    Waits for everything written so far to reach the disk.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::sync()
+{
+    if (::fdatasync(_fd) != 0)
+        throw std::system_error(errno, std::generic_category(), "disk_btree: fdatasync");
+}
+
+
+/*
+ Function: remap
+ Description:
+    Grows the mapping to cover every committed page. The mapping is made
+    twice as large as needed, since mapping past the end of the file is
+    allowed as long as those pages are not touched, so most commits that
+    grow the file do not remap. Lookups are random, so read-ahead is
+    turned off.
+ */
+template <class Key, class Value, class Compare, std::size_t PageSize>
+void
+disk_btree<Key, Value, Compare, PageSize>::remap()
+{
+    size_type needed = _committed.pages * PageSize;
+    if (needed <= _mapped)
+        return;
+
+    if (_map)
+        ::munmap(const_cast<char*>(_map), _mapped);
+    _map = nullptr;
+    _mapped = 0;
+
+    size_type length = std::max<size_type>(2 * needed, 256 * PageSize);
+    auto map = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED)
+        throw std::system_error(errno, std::generic_category(), "disk_btree: mmap");
+    ::madvise(map, length, MADV_RANDOM);
+
+    _map = static_cast<const char*>(map);
+    _mapped = length;
+}
+
+
+} // end namespace
+
+#endif /* disk_btree_h */
@@ -0,0 +1,387 @@
+/*
+ File:   dynamic_graph.h
+ Author: Kyle Thompson
+
+ Purpose:
+    An undirected graph that changes edge by edge and answers "are u and v
+    connected?" as it goes. Vertices and edges are added and removed at
+    any time; snapshot() freezes it into a csr_graph for heavy analysis.
+
+ Implementation:
+  - Adjacency lists: one vector of neighbours per vertex. A self loop
+    appears once in its vertex's list, any other edge once in each
+    endpoint's list, and parallel edges are kept.
+  - Connected components live in a disjoint_set that every add_edge
+    unites, so insertions and queries cost an amortised inverse Ackermann
+    each. Union-find cannot split a set, so remove_edge only marks the
+    components stale; the next query rebuilds them from the edges in
+    linear time. A stream of insertions and queries never rebuilds.
+  - Queries are const but may compress paths or rebuild, so they are
+    not safe to call from several threads at once.
+
+ TODO:
+  - Decremental connectivity without rebuilding (Holm et al.).
+ */
+
+
+#ifndef dynamic_graph_h
+#define dynamic_graph_h
+
+#include <algorithm>  // find
+#include <cstdint>    // uint32_t
+#include <stdexcept>  // out_of_range
+#include <utility>    // pair
+#include <vector>     // vector
+
+#include "csr_graph.h"
+#include "disjoint_set.h"
+
+namespace ads {
+
+template <class Vertex = std::uint32_t>
+class dynamic_graph {
+
+/* Type definitions */
+public:
+    typedef std::size_t                 size_type;
+    typedef Vertex                      vertex_type;
+    typedef std::pair<Vertex, Vertex>   edge_type;
+
+
+/* Data members */
+private:
+    std::vector<std::vector<Vertex>> _adjacency;
+    size_type _edges = 0;
+    mutable disjoint_set _components;
+    mutable bool _stale = false;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit dynamic_graph(size_type = 0);
+
+    /* Capacity */
+    size_type vertices() const;
+    size_type edges() const;
+    size_type components() const;
+
+    /* Element access */
+    const std::vector<Vertex>& neighbours(Vertex) const;
+    size_type degree(Vertex) const;
+    bool has_edge(Vertex, Vertex) const;
+
+    /* Modifiers */
+    Vertex add_vertex();
+    void add_edge(Vertex, Vertex);
+    bool remove_edge(Vertex, Vertex);
+    void clear();
+
+    /* Operations */
+    bool connected(Vertex, Vertex) const;
+    Vertex component(Vertex) const;
+    csr_graph<Vertex> snapshot() const;
+
+/* Helper functions */
+private:
+    void check(Vertex, const char*) const;
+    void refresh() const;
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - vertices: The number of vertices to start with, and no edges.
+ Return value: None
+
+ Complexity: Linear.
+ */
+template <class Vertex>
+dynamic_graph<Vertex>::dynamic_graph(size_type vertices)
+    : _adjacency(vertices)
+    , _components(vertices)
+{}
+
+
+
+// Capacity
+
+/*
+ Function: vertices / edges / components
+ Return value: The number of vertices, of edges, and of connected
+               components, isolated vertices included.
+
+ Complexity: Constant, except that components may rebuild after a
+             removal.
+ */
+template <class Vertex>
+inline typename dynamic_graph<Vertex>::size_type
+dynamic_graph<Vertex>::vertices() const
+{
+    return _adjacency.size();
+}
+
+template <class Vertex>
+inline typename dynamic_graph<Vertex>::size_type
+dynamic_graph<Vertex>::edges() const
+{
+    return _edges;
+}
+
+template <class Vertex>
+typename dynamic_graph<Vertex>::size_type
+dynamic_graph<Vertex>::components() const
+{
+    refresh();
+    return _components.sets();
+}
+
+
+
+// Element access
+
+/*
+ Function: neighbours / degree / has_edge
+ Parameters:
+  - u, v: Vertices.
+ Return value: u's neighbours in insertion order (with removals swapped
+               in from the back), their number, and whether an edge joins
+               u and v.
+
+ Complexity: Constant, and linear in u's degree for has_edge.
+
+ Exceptions:
+    Throws std::out_of_range if a vertex does not exist.
+ */
+template <class Vertex>
+inline const std::vector<Vertex>&
+dynamic_graph<Vertex>::neighbours(Vertex u) const
+{
+    check(u, "dynamic_graph::neighbours");
+    return _adjacency[u];
+}
+
+template <class Vertex>
+inline typename dynamic_graph<Vertex>::size_type
+dynamic_graph<Vertex>::degree(Vertex u) const
+{
+    return neighbours(u).size();
+}
+
+template <class Vertex>
+bool
+dynamic_graph<Vertex>::has_edge(Vertex u, Vertex v) const
+{
+    check(v, "dynamic_graph::has_edge");
+    auto& list = neighbours(u);
+    return std::find(list.begin(), list.end(), v) != list.end();
+}
+
+
+
+// Modifiers
+
+/*
+ Function: add_vertex
+ Parameters: None
+ Return value: The new vertex, with no edges.
+
+ Complexity: Amortised constant.
+ */
+template <class Vertex>
+Vertex
+dynamic_graph<Vertex>::add_vertex()
+{
+    _adjacency.emplace_back();
+    _components.add();
+    return static_cast<Vertex>(_adjacency.size() - 1);
+}
+
+
+/*
+ Function: add_edge
+ Parameters:
+  - u, v: The endpoints.
+ Return value: None
+
+ Description:
+    Adds the edge and merges the endpoints' components.
+
+ Complexity: Amortised inverse Ackermann.
+
+ Exceptions:
+    Throws std::out_of_range if a vertex does not exist.
+ */
+template <class Vertex>
+void
+dynamic_graph<Vertex>::add_edge(Vertex u, Vertex v)
+{
+    check(u, "dynamic_graph::add_edge");
+    check(v, "dynamic_graph::add_edge");
+
+    _adjacency[u].push_back(v);
+    if (u != v)
+        _adjacency[v].push_back(u);
+    ++_edges;
+    if (!_stale)
+        _components.unite(u, v);
+}
+
+
+/*
+ Function: remove_edge
+ Parameters:
+  - u, v: The endpoints.
+ Return value: Whether there was such an edge. One of several parallel
+               edges is removed.
+
+ Description:
+    Removes the edge and marks the components for rebuilding at the next
+    query.
+
+ Complexity: Linear in the endpoints' degrees.
+
+ Exceptions:
+    Throws std::out_of_range if a vertex does not exist.
+ */
+template <class Vertex>
+bool
+dynamic_graph<Vertex>::remove_edge(Vertex u, Vertex v)
+{
+    check(u, "dynamic_graph::remove_edge");
+    check(v, "dynamic_graph::remove_edge");
+
+    auto drop = [](std::vector<Vertex>& list, Vertex x) {
+        auto it = std::find(list.begin(), list.end(), x);
+        if (it == list.end())
+            return false;
+        *it = list.back();
+        list.pop_back();
+        return true;
+    };
+    if (!drop(_adjacency[u], v))
+        return false;
+    if (u != v)
+        drop(_adjacency[v], u);
+    --_edges;
+    _stale = true;
+    return true;
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every edge, keeping the vertices.
+
+ Complexity: Linear.
+ */
+template <class Vertex>
+void
+dynamic_graph<Vertex>::clear()
+{
+    for (auto& list : _adjacency)
+        list.clear();
+    _edges = 0;
+    _components.clear();
+    _stale = false;
+}
+
+
+
+// Operations
+
+/*
+ Function: connected / component
+ Parameters:
+  - u, v: Vertices.
+ Return value: Whether a path joins u and v, and a representative of u's
+               component, the same for every vertex in it until the graph
+               next changes.
+
+ Complexity: Amortised inverse Ackermann; linear after a removal.
+
+ Exceptions:
+    Throws std::out_of_range if a vertex does not exist.
+ */
+template <class Vertex>
+bool
+dynamic_graph<Vertex>::connected(Vertex u, Vertex v) const
+{
+    check(u, "dynamic_graph::connected");
+    check(v, "dynamic_graph::connected");
+    refresh();
+    return _components.connected(u, v);
+}
+
+template <class Vertex>
+Vertex
+dynamic_graph<Vertex>::component(Vertex u) const
+{
+    check(u, "dynamic_graph::component");
+    refresh();
+    return static_cast<Vertex>(_components.find(u));
+}
+
+
+/*
+ Function: snapshot
+ Parameters: None
+ Return value: The graph as an undirected csr_graph.
+
+ Complexity: O(V + E log d).
+ */
+template <class Vertex>
+csr_graph<Vertex>
+dynamic_graph<Vertex>::snapshot() const
+{
+    std::vector<typename csr_graph<Vertex>::edge_type> list;
+    list.reserve(_edges);
+    for (size_type u = 0; u < vertices(); ++u)
+        for (auto v : _adjacency[u])
+            if (u <= v)
+                list.emplace_back(static_cast<Vertex>(u), v);
+    return csr_graph<Vertex>(vertices(), list, graph_kind::undirected);
+}
+
+
+
+// Helper functions
+
+template <class Vertex>
+inline void
+dynamic_graph<Vertex>::check(Vertex u, const char* name) const
+{
+    if (u >= _adjacency.size())
+        throw std::out_of_range(name);
+}
+
+
+/*
+ Function: refresh
+ Description:
+    Rebuilds the components from the edges if a removal made them stale.
+ */
+template <class Vertex>
+void
+dynamic_graph<Vertex>::refresh() const
+{
+    if (!_stale)
+        return;
+
+    _components.clear();
+    for (size_type u = 0; u < vertices(); ++u)
+        for (auto v : _adjacency[u])
+            if (u < v)
+                _components.unite(u, v);
+    _stale = false;
+}
+
+
+} // end namespace
+
+#endif /* dynamic_graph_h */
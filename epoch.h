@@ -0,0 +1,281 @@
+/*
+ File:   epoch.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Epoch-based memory reclamation for the lock-free containers. A thread
+    pins the domain for the duration of an operation; memory it unlinks is
+    retired rather than freed, and only freed once every thread that could
+    still hold a reference has unpinned.
+
+ Implementation:
+  - The domain owns a fixed table of per-thread records. A guard claims a
+    free record (probing from a hash of the thread id, so a thread usually
+    gets the same record back) and announces the global epoch in it.
+  - The global epoch may advance from e to e + 1 once every pinned record
+    has announced e. Anything retired in epoch e is therefore unreachable
+    by the time the epoch reaches e + 2.
+  - Each record keeps three buckets of retired objects, indexed by epoch
+    modulo three. Pinning in epoch e frees the bucket last filled in
+    epoch e - 3 or earlier before reusing it.
+  - Retired objects carry their own deleter and a context pointer, so a
+    container can free nodes through its allocator.
+ */
+
+
+#ifndef epoch_h
+#define epoch_h
+
+#include <atomic>      // atomic
+#include <cstdint>     // uint64_t
+#include <functional>  // hash
+#include <memory>      // unique_ptr
+#include <thread>      // this_thread
+#include <vector>      // vector
+
+namespace ads {
+
+class epoch_domain {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef void (*deleter)(void* context, void* object);
+
+
+/* Record definition */
+private:
+    struct Retired {
+        void* object;
+        deleter destroy;
+        void* context;
+    };
+
+    struct Record {
+        std::atomic<bool> in_use{false};
+        std::atomic<std::uint64_t> announced{0};   // (epoch << 1) | 1 while pinned.
+        std::uint64_t bucket_epoch[3] = {0, 0, 0};
+        std::vector<Retired> buckets[3];
+        size_type retired_since_advance = 0;
+        char pad[64];
+    };
+
+
+/* Data members */
+private:
+    std::atomic<std::uint64_t> _epoch{3};
+    std::unique_ptr<Record[]> _records;
+    size_type _capacity;
+
+
+/* Guard definition */
+public:
+    class guard {
+
+    public:
+        explicit guard(epoch_domain&);
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+        ~guard();
+
+        void retire(void*, deleter, void*);
+
+    private:
+        epoch_domain& _domain;
+        Record* _record;
+        std::uint64_t _epoch;
+    };
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit epoch_domain(size_type = 256);
+    epoch_domain(const epoch_domain&) = delete;
+    epoch_domain& operator=(const epoch_domain&) = delete;
+    ~epoch_domain();
+
+    /* Observers */
+    std::uint64_t epoch() const;
+
+/* Helper functions */
+private:
+    bool try_advance(std::uint64_t);
+    static void free_bucket(std::vector<Retired>&);
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - max_threads: The number of threads that may be pinned at once. Extra
+                 threads wait for a record to free up.
+
+ Complexity: Linear in max_threads.
+ */
+inline
+epoch_domain::epoch_domain(size_type max_threads)
+    : _records(new Record[max_threads ? max_threads : 1])
+    , _capacity(max_threads ? max_threads : 1)
+{}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Frees everything still waiting in any record. No thread may be pinned.
+ */
+inline
+epoch_domain::~epoch_domain()
+{
+    for (size_type i = 0; i < _capacity; ++i)
+        for (auto& bucket : _records[i].buckets)
+            free_bucket(bucket);
+}
+
+
+
+// Observers
+
+/*
+ Function: epoch
+ Return value: The current global epoch.
+ */
+inline std::uint64_t
+epoch_domain::epoch() const
+{
+    return _epoch.load(std::memory_order_acquire);
+}
+
+
+
+// Guard
+
+/*
+ Function: guard constructor
+ Parameters:
+  - domain: The domain to pin.
+
+ Description:
+    Claims a record and announces the current epoch in it. Objects
+    reachable when the guard is created stay allocated until it is
+    destroyed. Frees the oldest bucket of the claimed record if it has
+    become safe.
+
+ Complexity: Constant while records are plentiful.
+ */
+inline
+epoch_domain::guard::guard(epoch_domain& domain)
+    : _domain(domain)
+{
+    auto start = std::hash<std::thread::id>()(std::this_thread::get_id());
+    for (size_type i = 0;; ++i) {
+        auto& record = domain._records[(start + i) % domain._capacity];
+        bool expected = false;
+        if (!record.in_use.load(std::memory_order_relaxed)
+            && record.in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            _record = &record;
+            break;
+        }
+        if (i % domain._capacity == domain._capacity - 1)
+            std::this_thread::yield();
+    }
+
+    _epoch = domain._epoch.load(std::memory_order_acquire);
+    _record->announced.store((_epoch << 1) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto slot = _epoch % 3;
+    if (_record->bucket_epoch[slot] != _epoch) {
+        free_bucket(_record->buckets[slot]);
+        _record->bucket_epoch[slot] = _epoch;
+    }
+}
+
+
+/*
+ Function: guard destructor
+
+ Description:
+    Unpins and releases the record.
+ */
+inline
+epoch_domain::guard::~guard()
+{
+    _record->announced.store(0, std::memory_order_release);
+    _record->in_use.store(false, std::memory_order_release);
+}
+
+
+/*
+ Function: retire
+ Parameters:
+  - object: An object that is no longer reachable from the container.
+  - destroy: Called as destroy(context, object) once it is safe.
+  - context: Passed through to destroy.
+
+ Description:
+    Defers freeing object. Every so often tries to advance the epoch so
+    retired objects do not pile up.
+
+ Complexity: Amortized constant; an advance attempt is linear in the
+             number of records.
+ */
+inline void
+epoch_domain::guard::retire(void* object, deleter destroy, void* context)
+{
+    _record->buckets[_epoch % 3].push_back(Retired{object, destroy, context});
+
+    if (++_record->retired_since_advance >= 64) {
+        _record->retired_since_advance = 0;
+        _domain.try_advance(_epoch);
+    }
+}
+
+
+
+// Helper functions
+
+/*
+ Function: try_advance
+ Parameters:
+  - seen: The epoch the caller is pinned in.
+ Return value: Whether the global epoch moved past seen.
+
+ Complexity: Linear in the number of records.
+ */
+inline bool
+epoch_domain::try_advance(std::uint64_t seen)
+{
+    for (size_type i = 0; i < _capacity; ++i) {
+        auto announced = _records[i].announced.load(std::memory_order_seq_cst);
+        if ((announced & 1) && (announced >> 1) != seen)
+            return false;
+    }
+
+    return _epoch.compare_exchange_strong(seen, seen + 1, std::memory_order_acq_rel);
+}
+
+
+/*
+ Function: free_bucket
+ Parameters:
+  - bucket: Retired objects that are safe to free.
+ */
+inline void
+epoch_domain::free_bucket(std::vector<Retired>& bucket)
+{
+    for (auto& retired : bucket)
+        retired.destroy(retired.context, retired.object);
+
+    bucket.clear();
+}
+
+
+} // end namespace
+
+#endif /* epoch_h */
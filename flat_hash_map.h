@@ -0,0 +1,1657 @@
+/*
+ File:   flat_hash_map.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Open addressing hash tables: flat_hash_set and flat_hash_map. Elements
+    sit directly in one array of slots, and a parallel array of one byte
+    per slot says which are in use and holds seven bits of each element's
+    hash, so a lookup compares sixteen candidates with a couple of vector
+    instructions and almost never touches a slot that does not match.
+    concurrent_flat_hash_map is a sharded variant for many threads.
+
+ Implementation:
+  - The layout follows the Swiss table. Each control byte is empty,
+    deleted (a tombstone), or the low seven bits of a full slot's hash
+    (H2). The rest of the hash (H1) picks the slot probing starts at.
+  - Probing reads a group of sixteen control bytes at any offset. With
+    SSE2 a group is compared against H2 (or against empty) in one step and
+    the result is a 16 bit mask of candidates; without it the same masks
+    are built a byte at a time. The first 16 control bytes are repeated
+    after the last, so a group that runs off the end wraps without a
+    branch. Groups are visited in triangular steps, which covers the
+    whole table when the capacity is a power of two.
+  - A lookup stops at the first group holding an empty byte. Erasing
+    therefore leaves a tombstone, unless the slot's neighbourhood shows
+    no probe can ever have passed through a full group there, in which
+    case the slot goes straight back to empty.
+  - The table holds at most 7/8 of its capacity in full slots and
+    tombstones together. When that is used up, a table that is mostly
+    tombstones is rehashed at the same capacity, and one that is mostly
+    full doubles.
+  - Hashes are mixed (a 128 bit multiply folded in half) before use, so an
+    identity std::hash on integers still spreads over H1 and H2.
+  - find, has, count and erase take any key type the hasher and the key
+    comparison both accept when both declare is_transparent.
+  - Elements move when the table is rehashed, so iterators and pointers
+    are invalidated by any insertion, and moving an element must not
+    throw.
+  - concurrent_flat_hash_map splits the keys over lock-striped shards,
+    each its own open addressing table on the same control bytes, chosen
+    by the top bits of the hash. Writers take their shard's mutex and
+    bracket each change with a sequence number (a seqlock). Readers take
+    no lock: they copy what they probe and retry if the sequence number
+    moved, so keys and values must be trivially copyable.
+  - A shard grows by building a bigger table beside the current one and
+    publishing it with one pointer store. Other shards never notice, and
+    the shard's own readers keep reading the old table, which stays
+    allocated until the map is destroyed (all of a shard's old tables
+    together are smaller than its current one).
+ */
+
+
+#ifndef flat_hash_map_h
+#define flat_hash_map_h
+
+#include <atomic>            // atomic, atomic_thread_fence
+#include <cstddef>           // ptrdiff_t
+#include <cstdint>           // int8_t, uint32_t, uint64_t
+#include <cstring>           // memset, memcpy
+#include <functional>        // hash, equal_to
+#include <initializer_list>  // initializer_list
+#include <iterator>          // iterator
+#include <limits>            // numeric_limits
+#include <memory>            // allocator, unique_ptr
+#include <mutex>             // mutex, lock_guard
+#include <stdexcept>         // out_of_range
+#include <type_traits>       // conditional, integral_constant
+#include <utility>           // move, forward, pair, swap
+#include <vector>            // vector
+
+#ifdef __SSE2__
+#include <emmintrin.h>       // SSE2
+#endif
+
+namespace ads {
+
+// Control bytes. Full slots hold H2, from 0 to 127.
+typedef std::int8_t hash_ctrl;
+static const hash_ctrl ctrl_empty = -128;
+static const hash_ctrl ctrl_deleted = -2;
+
+// Sixteen control bytes, matched as bit masks with bit i for byte i.
+#ifdef __SSE2__
+struct hash_group {
+    static constexpr std::size_t width = 16;
+    __m128i ctrl;
+
+    explicit hash_group(const hash_ctrl* p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+    std::uint32_t match(hash_ctrl h2) const
+    {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+    }
+    std::uint32_t match_empty() const { return match(ctrl_empty); }
+    std::uint32_t match_free() const { return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl)); }
+};
+#else
+struct hash_group {
+    static constexpr std::size_t width = 16;
+    const hash_ctrl* ctrl;
+
+    explicit hash_group(const hash_ctrl* p) : ctrl(p) {}
+
+    std::uint32_t match(hash_ctrl h2) const
+    {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < width; ++i)
+            mask |= static_cast<std::uint32_t>(ctrl[i] == h2) << i;
+        return mask;
+    }
+    std::uint32_t match_empty() const { return match(ctrl_empty); }
+    std::uint32_t match_free() const
+    {
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < width; ++i)
+            mask |= static_cast<std::uint32_t>(ctrl[i] < 0) << i;
+        return mask;
+    }
+};
+#endif
+
+
+// Spreads every bit of a hasher's result over every output bit, so that
+// H1 and H2 are independent even for an identity hash.
+inline std::size_t
+hash_mix(std::size_t hash)
+{
+    __extension__ typedef unsigned __int128 wide;
+    auto product = static_cast<wide>(hash) * 0x9E3779B97F4A7C15ull;
+    return static_cast<std::size_t>(product) ^ static_cast<std::size_t>(product >> 64);
+}
+
+
+// Whether slot i of a table can be marked empty when erased. A probe only
+// passes slot i if it started within the 16 bytes before it and found every
+// group up to i full. If the empty bytes nearest to i on either side are
+// less than a group apart, no group containing i was ever full.
+inline bool
+hash_never_full(const hash_ctrl* ctrl, std::size_t i, std::size_t capacity)
+{
+    auto before = (i - hash_group::width) & (capacity - 1);
+    auto empty_after = hash_group(ctrl + i).match_empty();
+    auto empty_before = hash_group(ctrl + before).match_empty();
+    return empty_after && empty_before
+        && static_cast<std::size_t>(__builtin_ctz(empty_after) + __builtin_clz(empty_before) - 16) < hash_group::width;
+}
+
+
+// A slot's contents: the key, and for a map the mapped value.
+template <class Key, class Mapped>
+struct flat_hash_slot {
+    Key key;
+    Mapped value;
+
+    template <class K, class... Args>
+    explicit flat_hash_slot(K&& k, Args&&... args) : key(std::forward<K>(k)), value(std::forward<Args>(args)...) {}
+};
+
+template <class Key>
+struct flat_hash_slot<Key, void> {
+    Key key;
+
+    template <class K>
+    explicit flat_hash_slot(K&& k) : key(std::forward<K>(k)) {}
+};
+
+
+// What dereferencing an iterator gives: the key for a set, a pair of
+// references for a map.
+template <class Key, class Mapped, bool Const>
+struct flat_hash_deref {
+    typedef typename std::conditional<Const, const Mapped&, Mapped&>::type mapped_ref;
+    typedef std::pair<const Key&, mapped_ref> type;
+
+    static type get(flat_hash_slot<Key, Mapped>* slot) { return type(slot->key, slot->value); }
+};
+
+template <class Key, bool Const>
+struct flat_hash_deref<Key, void, Const> {
+    typedef void mapped_ref;
+    typedef const Key& type;
+
+    static type get(flat_hash_slot<Key, void>* slot) { return slot->key; }
+};
+
+
+template <class> struct flat_hash_void { typedef void type; };
+
+template <class T, class = void>
+struct flat_hash_transparent : std::false_type {};
+
+template <class T>
+struct flat_hash_transparent<T, typename flat_hash_void<typename T::is_transparent>::type> : std::true_type {};
+
+
+// The shared table. Mapped is void for a set.
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+class flat_hash_table {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef Key         key_type;
+    typedef Key&&       rvalue_ref;
+    typedef const Key&  const_ref;
+
+
+/* Slot definition */
+protected:
+    typedef flat_hash_slot<Key, Mapped> Slot;
+    typedef typename Alloc::template rebind<Slot>::other slot_alloc;
+    typedef typename Alloc::template rebind<hash_ctrl>::other ctrl_alloc;
+
+    static constexpr size_type width = hash_group::width;
+    static constexpr size_type min_capacity = 16;
+
+    typedef std::integral_constant<bool, flat_hash_transparent<Hash>::value && flat_hash_transparent<KeyEqual>::value>
+        is_transparent;
+
+
+/* Iterators */
+public:
+    template <bool Const>
+    class basic_iterator : public std::iterator<std::forward_iterator_tag, Key, std::ptrdiff_t, void,
+                                                typename flat_hash_deref<Key, Mapped, Const>::type> {
+
+        friend class flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>;
+        friend class basic_iterator<!Const>;
+
+    private:
+        const hash_ctrl* ctrl;
+        Slot* slot;
+        const hash_ctrl* last;     // One past the final control byte.
+
+        void skip_free() { while (ctrl != last && *ctrl < 0) { ++ctrl; ++slot; } }
+
+    public:
+        typedef typename flat_hash_deref<Key, Mapped, Const>::type reference;
+
+        basic_iterator(const hash_ctrl* c = nullptr, Slot* s = nullptr, const hash_ctrl* l = nullptr)
+            : ctrl(c), slot(s), last(l) {}
+        template <bool C = Const, class = typename std::enable_if<C>::type>
+        basic_iterator(const basic_iterator<false>& it) : ctrl(it.ctrl), slot(it.slot), last(it.last) {}
+
+        reference operator*() const { return flat_hash_deref<Key, Mapped, Const>::get(slot); }
+        const_ref key() const { return slot->key; }
+        typename flat_hash_deref<Key, Mapped, Const>::mapped_ref value() const { return slot->value; }
+
+        basic_iterator& operator++() { ++ctrl; ++slot; skip_free(); return *this; }
+        basic_iterator operator++(int) { basic_iterator temp(*this); ++*this; return temp; }
+        bool operator==(const basic_iterator& rhs) const { return ctrl == rhs.ctrl; }
+        bool operator!=(const basic_iterator& rhs) const { return ctrl != rhs.ctrl; }
+    };
+
+    typedef basic_iterator<false> iterator;
+    typedef basic_iterator<true>  const_iterator;
+
+
+/* Data members */
+protected:
+    hash_ctrl* _ctrl = nullptr;     // _capacity + width bytes; the last width copy the first.
+    Slot* _slots = nullptr;
+    size_type _capacity = 0;        // 0 or a power of two, at least min_capacity.
+    size_type _size = 0;
+    size_type _growth_left = 0;     // Empty slots that may still be filled.
+    Hash _hash;
+    KeyEqual _equal;
+    slot_alloc _slot_alloc;
+    ctrl_alloc _ctrl_alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    flat_hash_table() = default;
+    flat_hash_table(const flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>&);
+    flat_hash_table(flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>&&);
+    ~flat_hash_table();
+
+    /* Assignment */
+    flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>& operator=(flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>);
+
+    /* Iterators */
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    size_type capacity() const;
+    double load_factor() const;
+    void reserve(size_type);
+
+    /* Element access */
+    bool has(const_ref key) const { return find_index(key) != _capacity; }
+    size_type count(const_ref key) const { return has(key); }
+    iterator find(const_ref key) { return iterator_at(find_index(key)); }
+    const_iterator find(const_ref key) const { return iterator_at(find_index(key)); }
+
+    template <class K, class = typename std::enable_if<is_transparent::value, K>::type>
+        bool has(const K& key) const { return find_index(key) != _capacity; }
+    template <class K, class = typename std::enable_if<is_transparent::value, K>::type>
+        size_type count(const K& key) const { return has(key); }
+    template <class K, class = typename std::enable_if<is_transparent::value, K>::type>
+        iterator find(const K& key) { return iterator_at(find_index(key)); }
+    template <class K, class = typename std::enable_if<is_transparent::value, K>::type>
+        const_iterator find(const K& key) const { return iterator_at(find_index(key)); }
+
+    /* Modifiers */
+    bool erase(const_ref key) { return erase_key(key); }
+    template <class K, class = typename std::enable_if<is_transparent::value, K>::type>
+        bool erase(const K& key) { return erase_key(key); }
+    void erase(const_iterator);
+    void swap(flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>&);
+    void clear() noexcept;
+
+/* Helper functions */
+protected:
+    template <class K, class... Args>
+        std::pair<iterator, bool> insert_unique(K&&, Args&&...);
+
+    iterator iterator_at(size_type i) { return iterator(_ctrl + i, _slots + i, _ctrl + _capacity); }
+    const_iterator iterator_at(size_type i) const { return const_iterator(_ctrl + i, _slots + i, _ctrl + _capacity); }
+
+private:
+    static hash_ctrl h2(size_type hash) { return static_cast<hash_ctrl>(hash & 0x7F); }
+    size_type start(size_type hash) const { return (hash >> 7) & (_capacity - 1); }
+
+    template <class K>
+        size_type find_index(const K&) const;
+    template <class K>
+        size_type find_hashed(const K&, size_type) const;
+    size_type find_free(size_type) const;
+    template <class K>
+        bool erase_key(const K&);
+    void erase_at(size_type);
+
+    void set_ctrl(size_type, hash_ctrl);
+    void resize(size_type);
+    void destroy_all() noexcept;
+    static size_type max_filled(size_type capacity) { return capacity - capacity / 8; }
+};
+
+
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+constexpr typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size_type flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::width;
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+constexpr typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size_type flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::min_capacity;
+
+
+
+// A set of unique keys.
+template <class Key, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class Alloc = std::allocator<Key>>
+class flat_hash_set : public flat_hash_table<Key, void, Hash, KeyEqual, Alloc> {
+
+    typedef flat_hash_table<Key, void, Hash, KeyEqual, Alloc> base;
+
+public:
+    typedef Key value_type;
+    typedef typename base::iterator iterator;
+    typedef typename base::const_iterator const_iterator;
+
+    /* Constructors */
+    flat_hash_set() = default;
+    flat_hash_set(std::initializer_list<Key> il) : flat_hash_set(il.begin(), il.end()) {}
+    template <class InputIt>
+        flat_hash_set(InputIt first, InputIt last) { for (; first != last; ++first) insert(*first); }
+
+    /* Modifiers */
+    std::pair<iterator, bool> insert(const Key& key) { return this->insert_unique(key); }
+    std::pair<iterator, bool> insert(Key&& key) { return this->insert_unique(std::move(key)); }
+};
+
+
+// A map from unique keys to values.
+template <class Key, class Mapped, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class Alloc = std::allocator<Key>>
+class flat_hash_map : public flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc> {
+
+    typedef flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc> base;
+
+public:
+    typedef Mapped mapped_type;
+    typedef std::pair<Key, Mapped> value_type;
+    typedef typename base::iterator iterator;
+    typedef typename base::const_iterator const_iterator;
+
+    /* Constructors */
+    flat_hash_map() = default;
+    flat_hash_map(std::initializer_list<value_type> il) { for (auto& kv : il) insert(kv.first, kv.second); }
+
+    /* Element access */
+    Mapped& operator[](const Key& key) { return this->insert_unique(key).first.value(); }
+    Mapped& operator[](Key&& key) { return this->insert_unique(std::move(key)).first.value(); }
+
+    Mapped& at(const Key& key)
+    {
+        auto it = this->find(key);
+        if (it == this->end())
+            throw std::out_of_range("flat_hash_map::at");
+        return it.value();
+    }
+
+    const Mapped& at(const Key& key) const
+    {
+        auto it = this->find(key);
+        if (it == this->end())
+            throw std::out_of_range("flat_hash_map::at");
+        return it.value();
+    }
+
+    /* Modifiers */
+    std::pair<iterator, bool> insert(const Key& key, const Mapped& value) { return this->insert_unique(key, value); }
+    std::pair<iterator, bool> insert(const Key& key, Mapped&& value) { return this->insert_unique(key, std::move(value)); }
+    std::pair<iterator, bool> insert(Key&& key, Mapped&& value) { return this->insert_unique(std::move(key), std::move(value)); }
+
+    std::pair<iterator, bool> insert_or_assign(const Key& key, Mapped value)
+    {
+        auto result = this->insert_unique(key);
+        result.first.value() = std::move(value);
+        return result;
+    }
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The table being copied or moved from.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty table with no storage (defaulted in the class).
+  2. independent copy of rhs, sized for its elements alone, so it has no
+     tombstones.
+  3. table that takes over rhs's storage, leaving rhs empty.
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs.
+  3. Constant.
+ */
+
+// 2. copy
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::flat_hash_table(const flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>& rhs)
+    : _hash(rhs._hash)
+    , _equal(rhs._equal)
+{
+    reserve(rhs._size);
+    try {
+        for (size_type i = 0; i < rhs._capacity; ++i) {
+            if (rhs._ctrl[i] < 0)
+                continue;
+            auto hash = hash_mix(_hash(rhs._slots[i].key));
+            auto j = find_free(hash);
+            ::new (static_cast<void*>(_slots + j)) Slot(static_cast<const Slot&>(rhs._slots[i]));
+            set_ctrl(j, h2(hash));
+            ++_size;
+            --_growth_left;
+        }
+    } catch (...) {
+        destroy_all();
+        throw;
+    }
+}
+
+// 3. move
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::flat_hash_table(flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>&& rhs)
+{
+    swap(rhs);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::~flat_hash_table()
+{
+    destroy_all();
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this table.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>&
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::operator=(flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end
+ Return value: An iterator to the first full slot, or past the last slot.
+
+ Description:
+    Iteration order is slot order, which has nothing to do with the keys.
+
+ Complexity: begin is linear in the capacity in the worst case.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::iterator
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::begin()
+{
+    auto it = iterator_at(0);
+    it.skip_free();
+    return it;
+}
+
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::iterator
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::end()
+{
+    return iterator_at(_capacity);
+}
+
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::const_iterator
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::begin() const
+{
+    auto it = iterator_at(0);
+    it.skip_free();
+    return it;
+}
+
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::const_iterator
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::end() const
+{
+    return iterator_at(_capacity);
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty
+ Return value: Whether the table has no elements.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+bool
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::empty() const
+{
+    return !_size;
+}
+
+
+/*
+ Function: size
+ Return value: The number of elements.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size_type
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size() const
+{
+    return _size;
+}
+
+
+/*
+ Function: capacity
+ Return value: The number of slots.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size_type
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::capacity() const
+{
+    return _capacity;
+}
+
+
+/*
+ Function: load_factor
+ Return value: The fraction of slots that are full.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+double
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::load_factor() const
+{
+    return _capacity ? static_cast<double>(_size) / _capacity : 0.0;
+}
+
+
+/*
+ Function: reserve
+ Parameters:
+  - n: A number of elements.
+
+ Description:
+    Grows the table so that n elements fit without another rehash.
+
+ Complexity: Linear in the size and the new capacity if it grows.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::reserve(size_type n)
+{
+    size_type capacity = min_capacity;
+    while (max_filled(capacity) < n)
+        capacity *= 2;
+
+    if (capacity > _capacity)
+        resize(capacity);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: erase
+ Parameters:
+  - position: An iterator to the element to remove.
+
+ Complexity: Constant.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::erase(const_iterator position)
+{
+    erase_at(static_cast<size_type>(position.ctrl - _ctrl));
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - other: The table to exchange contents with.
+
+ Complexity: Constant.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::swap(flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>& other)
+{
+    using std::swap;
+    swap(_ctrl, other._ctrl);
+    swap(_slots, other._slots);
+    swap(_capacity, other._capacity);
+    swap(_size, other._size);
+    swap(_growth_left, other._growth_left);
+    swap(_hash, other._hash);
+    swap(_equal, other._equal);
+    swap(_slot_alloc, other._slot_alloc);
+    swap(_ctrl_alloc, other._ctrl_alloc);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every element and tombstone, keeping the capacity.
+
+ Complexity: Linear in the capacity.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::clear() noexcept
+{
+    for (size_type i = 0; i < _capacity; ++i)
+        if (_ctrl[i] >= 0)
+            _slots[i].~Slot();
+
+    if (_capacity)
+        std::memset(_ctrl, static_cast<unsigned char>(ctrl_empty), _capacity + width);
+    _size = 0;
+    _growth_left = max_filled(_capacity);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: insert_unique
+ Parameters:
+  - key: The key to insert.
+  - args: Arguments for the mapped value, if any.
+ Return value: An iterator to the element with key, and whether it was
+               inserted.
+
+ Description:
+    Reuses the first tombstone or empty slot on the key's probe sequence.
+    Only filling an empty slot uses up growth, and when there is none
+    left the table is rehashed first. The slot is constructed before its
+    control byte is set, so a throwing constructor leaves no trace.
+
+ Complexity: Constant expected; linear when it rehashes.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+template <class K, class... Args>
+std::pair<typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::iterator, bool>
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::insert_unique(K&& key, Args&&... args)
+{
+    auto hash = hash_mix(_hash(key));
+    auto found = find_hashed(key, hash);
+    if (found != _capacity)
+        return std::make_pair(iterator_at(found), false);
+
+    if (!_capacity)
+        resize(min_capacity);
+    auto i = find_free(hash);
+    if (!_growth_left && _ctrl[i] == ctrl_empty) {
+        // Mostly tombstones: clean up in place. Mostly elements: grow.
+        resize(_size * 32 <= _capacity * 25 ? _capacity : _capacity * 2);
+        i = find_free(hash);
+    }
+
+    ::new (static_cast<void*>(_slots + i)) Slot(std::forward<K>(key), std::forward<Args>(args)...);
+    if (_ctrl[i] == ctrl_empty)
+        --_growth_left;
+    set_ctrl(i, h2(hash));
+    ++_size;
+    return std::make_pair(iterator_at(i), true);
+}
+
+
+/*
+ Function: find_index / find_hashed
+ Parameters:
+  - key: The key to look for.
+  - hash: Its mixed hash.
+ Return value: The slot holding key, or the capacity if it is absent.
+
+ Description:
+    Visits the key's probe groups in order. In each, every byte matching
+    H2 is checked with KeyEqual; a group with an empty byte ends the
+    search.
+
+ Complexity: Constant expected.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+template <class K>
+inline typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size_type
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::find_index(const K& key) const
+{
+    if (!_size)
+        return _capacity;
+    return find_hashed(key, hash_mix(_hash(key)));
+}
+
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+template <class K>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size_type
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::find_hashed(const K& key, size_type hash) const
+{
+    if (!_capacity)
+        return 0;
+
+    size_type mask = _capacity - 1, pos = start(hash), step = 0;
+    for (;;) {
+        hash_group group(_ctrl + pos);
+        for (auto bits = group.match(h2(hash)); bits; bits &= bits - 1) {
+            auto i = (pos + static_cast<size_type>(__builtin_ctz(bits))) & mask;
+            if (_equal(_slots[i].key, key))
+                return i;
+        }
+        if (group.match_empty())
+            return _capacity;
+
+        step += width;
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/*
+ Function: find_free
+ Parameters:
+  - hash: A mixed hash.
+ Return value: The first empty or deleted slot on its probe sequence.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+typename flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::size_type
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::find_free(size_type hash) const
+{
+    size_type mask = _capacity - 1, pos = start(hash), step = 0;
+    for (;;) {
+        if (auto bits = hash_group(_ctrl + pos).match_free())
+            return (pos + static_cast<size_type>(__builtin_ctz(bits))) & mask;
+
+        step += width;
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/*
+ Function: erase_key
+ Parameters:
+  - key: The key to remove.
+ Return value: Whether it was present.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+template <class K>
+bool
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::erase_key(const K& key)
+{
+    auto i = find_index(key);
+    if (i == _capacity)
+        return false;
+
+    erase_at(i);
+    return true;
+}
+
+
+/*
+ Function: erase_at
+ Parameters:
+  - i: A full slot.
+
+ Description:
+    Leaves a tombstone unless hash_never_full says the slot can go back to
+    empty.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::erase_at(size_type i)
+{
+    _slots[i].~Slot();
+    --_size;
+
+    if (hash_never_full(_ctrl, i, _capacity)) {
+        set_ctrl(i, ctrl_empty);
+        ++_growth_left;
+    } else {
+        set_ctrl(i, ctrl_deleted);
+    }
+}
+
+
+/*
+ Function: set_ctrl
+ Parameters:
+  - i: A slot.
+  - value: Its new control byte.
+
+ Description:
+    Keeps the copy of the first width bytes after the end in step.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+inline void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::set_ctrl(size_type i, hash_ctrl value)
+{
+    _ctrl[i] = value;
+    if (i < width)
+        _ctrl[_capacity + i] = value;
+}
+
+
+/*
+ Function: resize
+ Parameters:
+  - capacity: The new number of slots, a power of two.
+
+ Description:
+    Moves every element into fresh arrays, dropping all tombstones. The
+    capacity may be the current one.
+
+ Complexity: Linear in the old and new capacities.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::resize(size_type capacity)
+{
+    auto ctrl = _ctrl_alloc.allocate(capacity + width);
+    Slot* slots;
+    try {
+        slots = _slot_alloc.allocate(capacity);
+    } catch (...) {
+        _ctrl_alloc.deallocate(ctrl, capacity + width);
+        throw;
+    }
+    std::memset(ctrl, static_cast<unsigned char>(ctrl_empty), capacity + width);
+
+    auto old_ctrl = _ctrl;
+    auto old_slots = _slots;
+    auto old_capacity = _capacity;
+    _ctrl = ctrl;
+    _slots = slots;
+    _capacity = capacity;
+
+    for (size_type i = 0; i < old_capacity; ++i) {
+        if (old_ctrl[i] < 0)
+            continue;
+        auto hash = hash_mix(_hash(old_slots[i].key));
+        auto j = find_free(hash);
+        ::new (static_cast<void*>(_slots + j)) Slot(std::move(old_slots[i]));
+        old_slots[i].~Slot();
+        set_ctrl(j, h2(hash));
+    }
+    _growth_left = max_filled(capacity) - _size;
+
+    if (old_capacity) {
+        _ctrl_alloc.deallocate(old_ctrl, old_capacity + width);
+        _slot_alloc.deallocate(old_slots, old_capacity);
+    }
+}
+
+
+/*
+ Function: destroy_all
+ Description:
+    Destroys every element and frees the arrays.
+ */
+template <class Key, class Mapped, class Hash, class KeyEqual, class Alloc>
+void
+flat_hash_table<Key, Mapped, Hash, KeyEqual, Alloc>::destroy_all() noexcept
+{
+    if (!_capacity)
+        return;
+
+    clear();
+    _ctrl_alloc.deallocate(_ctrl, _capacity + width);
+    _slot_alloc.deallocate(_slots, _capacity);
+    _ctrl = nullptr;
+    _slots = nullptr;
+    _capacity = 0;
+    _growth_left = 0;
+}
+
+
+
+// A map for many threads. Writers lock one shard; readers take no lock
+// and write nothing.
+template <class Key, class Value, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class Alloc = std::allocator<Key>>
+class concurrent_flat_hash_map {
+
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "concurrent_flat_hash_map copies keys and values while they may be changing");
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef Key         key_type;
+    typedef Value       mapped_type;
+    typedef const Key&  const_ref;
+
+
+/* Shard definition */
+private:
+    static constexpr size_type width = hash_group::width;
+    static constexpr size_type min_capacity = 16;
+    static constexpr int optimistic_attempts = 16;
+
+    typedef flat_hash_slot<Key, Value> Slot;
+    typedef typename Alloc::template rebind<Slot>::other slot_alloc;
+    typedef typename Alloc::template rebind<hash_ctrl>::other ctrl_alloc;
+
+    // Laid out as in flat_hash_table. Never changes size once published.
+    struct Table {
+        size_type capacity;
+        hash_ctrl* ctrl;
+        Slot* slots;
+    };
+
+    struct Shard {
+        std::atomic<std::uint64_t> sequence{0};  // Odd while a writer changes the table.
+        std::atomic<Table*> table{nullptr};
+        std::atomic<size_type> size{0};
+        std::mutex lock;                         // Held by writers.
+        size_type growth_left = 0;
+        std::vector<Table*> tables;              // Every table published, current last.
+        char pad[64];
+    };
+
+
+/* Data members */
+private:
+    std::unique_ptr<Shard[]> _shards;
+    unsigned _shard_bits;
+    Hash _hash;
+    KeyEqual _equal;
+    slot_alloc _slot_alloc;
+    ctrl_alloc _ctrl_alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit concurrent_flat_hash_map(size_type = 64);
+    concurrent_flat_hash_map(const concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>&) = delete;
+    concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>& operator=(const concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>&) = delete;
+    ~concurrent_flat_hash_map();
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    size_type capacity() const;
+    size_type shard_count() const;
+
+    /* Element access */
+    bool has(const_ref) const;
+    bool find(const_ref, Value&) const;
+
+    /* Modifiers */
+    bool insert(const_ref, const Value&);
+    bool assign(const_ref, const Value&);
+    template <class Function>
+        bool update(const_ref, Function);
+    bool erase(const_ref);
+    void clear();
+
+/* Helper functions */
+private:
+    Shard& shard_of(size_type) const;
+    bool read(const_ref, Slot*) const;
+    bool probe(const Table*, const_ref, size_type, Slot*) const;
+    size_type locate(const Table*, const_ref, size_type) const;
+    static size_type find_free(const Table*, size_type);
+    size_type claim(Shard&, size_type);
+    void rebuild(Shard&, size_type);
+    static void write_begin(Shard&);
+    static void write_end(Shard&);
+    static void set_ctrl(Table*, size_type, hash_ctrl);
+    Table* create_table(size_type);
+    void destroy_table(Table*);
+    static size_type max_filled(size_type capacity) { return capacity - capacity / 8; }
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - shards: The number of independently locked shards, rounded up to a
+            power of two. More shards let more writers run at once.
+
+ Complexity: Linear in shards.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::concurrent_flat_hash_map(size_type shards)
+    : _shard_bits(0)
+{
+    while ((size_type(1) << _shard_bits) < shards)
+        ++_shard_bits;
+
+    _shards.reset(new Shard[size_type(1) << _shard_bits]);
+    try {
+        for (size_type i = 0; i < shard_count(); ++i) {
+            _shards[i].tables.reserve(1);
+            auto table = create_table(min_capacity);
+            _shards[i].tables.push_back(table);
+            _shards[i].table.store(table, std::memory_order_relaxed);
+            _shards[i].growth_left = max_filled(min_capacity);
+        }
+    } catch (...) {
+        for (size_type i = 0; i < shard_count(); ++i)
+            for (auto table : _shards[i].tables)
+                destroy_table(table);
+        throw;
+    }
+}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Frees every table, including ones replaced by a resize. No other thread
+    may be using the map.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::~concurrent_flat_hash_map()
+{
+    for (size_type i = 0; i < shard_count(); ++i)
+        for (auto table : _shards[i].tables)
+            destroy_table(table);
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: Whether the map is empty, and its number of elements.
+
+ Description:
+    Sums the shards without stopping writers, so under concurrent updates
+    the result is only a snapshot of each shard at a slightly different
+    time.
+
+ Complexity: Linear in the number of shards.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::empty() const
+{
+    return !size();
+}
+
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::size_type
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::size() const
+{
+    size_type total = 0;
+    for (size_type i = 0; i < shard_count(); ++i)
+        total += _shards[i].size.load(std::memory_order_relaxed);
+    return total;
+}
+
+
+/*
+ Function: capacity
+ Return value: The total number of slots in the shards' current tables.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::size_type
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::capacity() const
+{
+    size_type total = 0;
+    for (size_type i = 0; i < shard_count(); ++i)
+        total += _shards[i].table.load(std::memory_order_acquire)->capacity;
+    return total;
+}
+
+
+/*
+ Function: shard_count
+ Return value: The number of shards.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::size_type
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::shard_count() const
+{
+    return size_type(1) << _shard_bits;
+}
+
+
+
+// Element access
+
+/*
+ Function: has / find
+ Parameters:
+  - key: The key to look for.
+  - value: Set to the key's value if it is present.
+ Return value: Whether key is present.
+
+ Description:
+    Lock-free: see read.
+
+ Complexity: Constant expected.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::has(const_ref key) const
+{
+    typename std::aligned_storage<sizeof(Slot), alignof(Slot)>::type copy;
+    return read(key, reinterpret_cast<Slot*>(&copy));
+}
+
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::find(const_ref key, Value& value) const
+{
+    typename std::aligned_storage<sizeof(Slot), alignof(Slot)>::type copy;
+    if (!read(key, reinterpret_cast<Slot*>(&copy)))
+        return false;
+
+    value = reinterpret_cast<Slot*>(&copy)->value;
+    return true;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / assign
+ Parameters:
+  - key: The key to add.
+  - value: Its value.
+ Return value: Whether key was new.
+
+ Description:
+    insert leaves an existing value alone; assign overwrites it.
+
+ Complexity: Constant expected; linear in the shard when it resizes.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::insert(const_ref key, const Value& value)
+{
+    auto hash = hash_mix(_hash(key));
+    auto& shard = shard_of(hash);
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    if (locate(shard.table.load(std::memory_order_relaxed), key, hash) != size_type(-1))
+        return false;
+
+    auto i = claim(shard, hash);
+    auto table = shard.table.load(std::memory_order_relaxed);
+    write_begin(shard);
+    ::new (static_cast<void*>(table->slots + i)) Slot(key, value);
+    set_ctrl(table, i, static_cast<hash_ctrl>(hash & 0x7F));
+    write_end(shard);
+    return true;
+}
+
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::assign(const_ref key, const Value& value)
+{
+    auto hash = hash_mix(_hash(key));
+    auto& shard = shard_of(hash);
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    auto table = shard.table.load(std::memory_order_relaxed);
+    auto found = locate(table, key, hash);
+    if (found != size_type(-1)) {
+        write_begin(shard);
+        table->slots[found].value = value;
+        write_end(shard);
+        return false;
+    }
+
+    auto i = claim(shard, hash);
+    table = shard.table.load(std::memory_order_relaxed);
+    write_begin(shard);
+    ::new (static_cast<void*>(table->slots + i)) Slot(key, value);
+    set_ctrl(table, i, static_cast<hash_ctrl>(hash & 0x7F));
+    write_end(shard);
+    return true;
+}
+
+
+/*
+ Function: update
+ Parameters:
+  - key: The key whose value to change.
+  - f: Called as f(value) with a reference to the stored value.
+ Return value: Whether key was present.
+
+ Description:
+    A read-modify-write under the shard's lock, such as incrementing a
+    counter. f should be short: readers of the shard retry, and then wait,
+    until it returns.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+template <class Function>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::update(const_ref key, Function f)
+{
+    auto hash = hash_mix(_hash(key));
+    auto& shard = shard_of(hash);
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    auto table = shard.table.load(std::memory_order_relaxed);
+    auto i = locate(table, key, hash);
+    if (i == size_type(-1))
+        return false;
+
+    write_begin(shard);
+    try {
+        f(table->slots[i].value);
+    } catch (...) {
+        write_end(shard);
+        throw;
+    }
+    write_end(shard);
+    return true;
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - key: The key to remove.
+ Return value: Whether it was present.
+
+ Complexity: Constant expected.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::erase(const_ref key)
+{
+    auto hash = hash_mix(_hash(key));
+    auto& shard = shard_of(hash);
+    std::lock_guard<std::mutex> lock(shard.lock);
+
+    auto table = shard.table.load(std::memory_order_relaxed);
+    auto i = locate(table, key, hash);
+    if (i == size_type(-1))
+        return false;
+
+    bool never_full = hash_never_full(table->ctrl, i, table->capacity);
+    write_begin(shard);
+    set_ctrl(table, i, never_full ? ctrl_empty : ctrl_deleted);
+    write_end(shard);
+
+    shard.growth_left += never_full;
+    shard.size.store(shard.size.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    return true;
+}
+
+
+/*
+ Function: clear
+ Description:
+    Empties the shards one at a time, keeping their capacity. Concurrent
+    inserts into shards already cleared survive.
+
+ Complexity: Linear in the capacity.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+void
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::clear()
+{
+    for (size_type s = 0; s < shard_count(); ++s) {
+        auto& shard = _shards[s];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        auto table = shard.table.load(std::memory_order_relaxed);
+
+        write_begin(shard);
+        std::memset(table->ctrl, static_cast<unsigned char>(ctrl_empty), table->capacity + width);
+        write_end(shard);
+
+        shard.growth_left = max_filled(table->capacity);
+        shard.size.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+
+// Helper functions
+
+/*
+ Function: shard_of
+ Parameters:
+  - hash: A mixed hash.
+ Return value: The shard for it, chosen by the top bits, which the tables
+               themselves only use once they are enormous.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+inline typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::Shard&
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::shard_of(size_type hash) const
+{
+    return _shards[_shard_bits ? hash >> (std::numeric_limits<size_type>::digits - _shard_bits) : 0];
+}
+
+
+/*
+ Function: read
+ Parameters:
+  - key: The key to look for.
+  - copy: Storage the key's slot is copied into.
+ Return value: Whether key is present.
+
+ Description:
+    Reads the shard's sequence number, probes whichever table is current,
+    copying candidate slots out, and then reads the sequence number again.
+    If it is even and unchanged no writer touched the shard in between, so
+    the copy is consistent. Otherwise the read is retried, and after
+    optimistic_attempts failures it takes the shard's lock, so a reader
+    cannot be starved by a steady stream of writes.
+
+    A table that a resize replaced is never written again and stays
+    allocated, so a reader that loaded it before the switch still reads a
+    consistent (and, if the sequence number agrees, current) state.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::read(const_ref key, Slot* copy) const
+{
+    auto hash = hash_mix(_hash(key));
+    auto& shard = shard_of(hash);
+
+    for (int attempt = 0; attempt < optimistic_attempts; ++attempt) {
+        auto before = shard.sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        bool found = probe(shard.table.load(std::memory_order_acquire), key, hash, copy);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (shard.sequence.load(std::memory_order_relaxed) == before)
+            return found;
+    }
+
+    std::lock_guard<std::mutex> lock(shard.lock);
+    return probe(shard.table.load(std::memory_order_relaxed), key, hash, copy);
+}
+
+
+/*
+ Function: probe
+ Parameters:
+  - table: The table to search, possibly being written.
+  - key: The key to look for.
+  - hash: Its mixed hash.
+  - copy: Where candidate slots are copied.
+ Return value: Whether a slot equal to key was copied.
+
+ Description:
+    KeyEqual only ever sees the copy. Because the bytes may be torn, the
+    probe is bounded by the table's size rather than trusting to find an
+    empty group.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+bool
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::probe(const Table* table, const_ref key, size_type hash,
+                                                                    Slot* copy) const
+{
+    size_type mask = table->capacity - 1, pos = (hash >> 7) & mask;
+    for (size_type step = width; step <= table->capacity; step += width) {
+        hash_group group(table->ctrl + pos);
+        for (auto bits = group.match(static_cast<hash_ctrl>(hash & 0x7F)); bits; bits &= bits - 1) {
+            auto i = (pos + static_cast<size_type>(__builtin_ctz(bits))) & mask;
+            std::memcpy(static_cast<void*>(copy), static_cast<const void*>(table->slots + i), sizeof(Slot));
+            if (_equal(copy->key, key))
+                return true;
+        }
+        if (group.match_empty())
+            return false;
+
+        pos = (pos + step) & mask;
+    }
+
+    return false;
+}
+
+
+/*
+ Function: locate
+ Parameters:
+  - table: The shard's current table, with its lock held.
+  - key: The key to look for.
+  - hash: Its mixed hash.
+ Return value: The slot holding key, or size_type(-1).
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::size_type
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::locate(const Table* table, const_ref key, size_type hash) const
+{
+    size_type mask = table->capacity - 1, pos = (hash >> 7) & mask;
+    for (size_type step = width;; step += width) {
+        hash_group group(table->ctrl + pos);
+        for (auto bits = group.match(static_cast<hash_ctrl>(hash & 0x7F)); bits; bits &= bits - 1) {
+            auto i = (pos + static_cast<size_type>(__builtin_ctz(bits))) & mask;
+            if (_equal(table->slots[i].key, key))
+                return i;
+        }
+        if (group.match_empty())
+            return size_type(-1);
+
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/*
+ Function: find_free
+ Parameters:
+  - table: A table.
+  - hash: A mixed hash.
+ Return value: The first empty or deleted slot on its probe sequence.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::size_type
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::find_free(const Table* table, size_type hash)
+{
+    size_type mask = table->capacity - 1, pos = (hash >> 7) & mask;
+    for (size_type step = width;; step += width) {
+        if (auto bits = hash_group(table->ctrl + pos).match_free())
+            return (pos + static_cast<size_type>(__builtin_ctz(bits))) & mask;
+
+        pos = (pos + step) & mask;
+    }
+}
+
+
+/*
+ Function: claim
+ Parameters:
+  - shard: A shard whose lock is held.
+  - hash: The mixed hash of a key about to be inserted.
+ Return value: The free slot to insert into, in the shard's (possibly
+               new) current table.
+
+ Description:
+    Accounts for the element about to be added. As in flat_hash_table, a
+    shard out of growth is first rebuilt at the same capacity if it is
+    mostly tombstones, and at double otherwise.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::size_type
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::claim(Shard& shard, size_type hash)
+{
+    auto table = shard.table.load(std::memory_order_relaxed);
+    auto i = find_free(table, hash);
+    if (!shard.growth_left && table->ctrl[i] == ctrl_empty) {
+        auto size = shard.size.load(std::memory_order_relaxed);
+        rebuild(shard, size * 32 <= table->capacity * 25 ? table->capacity : table->capacity * 2);
+        table = shard.table.load(std::memory_order_relaxed);
+        i = find_free(table, hash);
+    }
+
+    if (table->ctrl[i] == ctrl_empty)
+        --shard.growth_left;
+    shard.size.store(shard.size.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return i;
+}
+
+
+/*
+ Function: rebuild
+ Parameters:
+  - shard: A shard whose lock is held.
+  - capacity: The capacity to rebuild at.
+
+ Description:
+    Copies the live elements into a new table without touching the current
+    one, so readers carry on as normal, and only this shard's writers wait.
+    A larger table is then published with a single pointer store and the
+    old one is kept for readers still inside it. A table rebuilt at its own
+    capacity, to drop tombstones, is instead copied back over the current
+    one as a write, so repeated cleanups do not accumulate tables.
+
+ Complexity: Linear in the shard's capacity.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+void
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::rebuild(Shard& shard, size_type capacity)
+{
+    auto old = shard.table.load(std::memory_order_relaxed);
+    auto fresh = create_table(capacity);
+    for (size_type i = 0; i < old->capacity; ++i) {
+        if (old->ctrl[i] < 0)
+            continue;
+        auto j = find_free(fresh, hash_mix(_hash(old->slots[i].key)));
+        std::memcpy(static_cast<void*>(fresh->slots + j), static_cast<const void*>(old->slots + i), sizeof(Slot));
+        set_ctrl(fresh, j, old->ctrl[i]);
+    }
+    shard.growth_left = max_filled(capacity) - shard.size.load(std::memory_order_relaxed);
+
+    if (capacity == old->capacity) {
+        write_begin(shard);
+        std::memcpy(old->ctrl, fresh->ctrl, capacity + width);
+        std::memcpy(static_cast<void*>(old->slots), static_cast<const void*>(fresh->slots), capacity * sizeof(Slot));
+        write_end(shard);
+        destroy_table(fresh);
+        return;
+    }
+
+    try {
+        shard.tables.push_back(fresh);
+    } catch (...) {
+        destroy_table(fresh);
+        throw;
+    }
+    shard.table.store(fresh, std::memory_order_release);
+}
+
+
+/*
+ Function: write_begin / write_end
+ Parameters:
+  - shard: A shard whose lock is held.
+
+ Description:
+    Bracket every change to a published table. The sequence number is odd
+    in between, and the fences order it against the changes themselves.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+inline void
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::write_begin(Shard& shard)
+{
+    shard.sequence.store(shard.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+inline void
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::write_end(Shard& shard)
+{
+    shard.sequence.store(shard.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+/*
+ Function: set_ctrl
+ Description:
+    As in flat_hash_table, mirrors the first width bytes after the end.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+inline void
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::set_ctrl(Table* table, size_type i, hash_ctrl value)
+{
+    table->ctrl[i] = value;
+    if (i < width)
+        table->ctrl[table->capacity + i] = value;
+}
+
+
+/*
+ Function: create_table / destroy_table
+ Parameters:
+  - capacity: The number of slots, a power of two.
+  - table: A table no thread can reach any more.
+ */
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+typename concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::Table*
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::create_table(size_type capacity)
+{
+    std::unique_ptr<Table> table(new Table{capacity, nullptr, nullptr});
+    table->ctrl = _ctrl_alloc.allocate(capacity + width);
+    try {
+        table->slots = _slot_alloc.allocate(capacity);
+    } catch (...) {
+        _ctrl_alloc.deallocate(table->ctrl, capacity + width);
+        throw;
+    }
+    std::memset(table->ctrl, static_cast<unsigned char>(ctrl_empty), capacity + width);
+    return table.release();
+}
+
+template <class Key, class Value, class Hash, class KeyEqual, class Alloc>
+void
+concurrent_flat_hash_map<Key, Value, Hash, KeyEqual, Alloc>::destroy_table(Table* table)
+{
+    _ctrl_alloc.deallocate(table->ctrl, table->capacity + width);
+    _slot_alloc.deallocate(table->slots, table->capacity);
+    delete table;
+}
+
+
+} // end namespace
+
+#endif /* flat_hash_map_h */
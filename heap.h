@@ -1,67 +1,99 @@
 /*
- *
+ File:   heap.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Priority queues. heap is a plain binary heap over a vector.
+    indexed_heap holds priorities for keys 0..n-1 and can change any key's
+    priority in place, the decrease-key that Dijkstra and Prim want.
+    radix_heap is a monotone queue of unsigned integer keys: every key
+    pushed must be at least the last one popped, which a shortest path
+    search guarantees.
+
+ Implementation:
+  - heap and indexed_heap keep Compare's greatest element on top, as
+    std::priority_queue does; pass std::greater for a min-heap.
+  - indexed_heap is d-ary (4 by default): a shallower tree makes the
+    frequent decrease-key sift-ups shorter, and the children a pop scans
+    share a cache line. A position array maps each key to its slot, or to
+    npos when absent.
+  - radix_heap files each key in the bucket numbered by the highest bit in
+    which it differs from the last key popped (bucket 0 when equal). A pop
+    from an empty bucket 0 finds the first non-empty bucket, takes its
+    minimum as the new last key, and redistributes the bucket; every key
+    moves to a lower bucket each time, so a key is moved at most once per
+    bit.
+
+ TODO:
+  - Meldable heaps (pairing, Fibonacci).
  */
 
-#include <algorithm>  // std::swap
-#include <vector> // replace this with custom vector when ready.
 
+#ifndef heap_h
+#define heap_h
 
-template <class T>
+#include <algorithm>   // swap, min_element
+#include <cassert>     // assert
+#include <cstdint>     // uint64_t
+#include <functional>  // less
+#include <limits>      // numeric_limits
+#include <stdexcept>   // out_of_range
+#include <type_traits> // is_integral, is_unsigned
+#include <utility>     // move, forward, pair
+#include <vector>      // vector
+
+namespace ads {
+
+template <class T, class Compare = std::less<T>>
 class heap {
 
 /* Type definitions */
 public:
     typedef std::size_t size_type;
     typedef T           value_type;
-    typedef T*          pointer;
-    typedef const T*    const_ptr;
     typedef T&          reference;
-    typedef T&&         rvalue_ref;
-    typedef const T&    const_ref;
+    typedef const T&    const_reference;
 
 
 /* Data members */
 private:
-    std::vector data;
+    std::vector<T> _data;
+    Compare _compare;
 
 
 /* Member functions */
 public:
     /* Constructors */
-    heap();
-    ~heap();
-
-    /* Assignment */
+    explicit heap(const Compare& = Compare());
+    template <class InputIt>
+        heap(InputIt, InputIt, const Compare& = Compare());
 
     /* Capacity */
     bool empty() const;
     size_type size() const;
 
     /* Element access */
-    reference get() const;
+    const_reference get() const;
 
     /* Modifiers */
-    void push(const_ref);
-    void push(rvalue_ref);
+    void push(const_reference);
+    void push(T&&);
     template <class... Args>
-        emplace(Args&&...);
+        void emplace(Args&&...);
     void pop();
-    // add something for group insert.
-    void swap(heap<T>&);
+    void swap(heap&);
     void clear() noexcept;
 
     /* Operations */
-    void merge(heap<T>&);
-    void merge(heap<T>&&);
-    template <class Compare>
-        void merge(heap<T>&, Compare);
-    template <class Compare>
-        void merge(heap<T>&&, Compare);
+    void merge(heap&);
+    void merge(heap&&);
 
-
-/* Helpers */
+/* Helper functions */
 private:
-    auto parent = [](size_type c) { return (curr - (curr+1)%2)/2; }
+    static size_type parent(size_type i) { return (i - 1) / 2; }
+    void sift_up(size_type);
+    void sift_down(size_type);
+    void make_heap();
 };
 
 
@@ -70,69 +102,644 @@ private:
 
 /*
  Function: constructor
- Parameters: None
+ Parameters:
+  - first, last: Elements to start with.
+  - compare: The ordering; its greatest element is on top.
  Return value: None
 
  Description:
-    Makes an empty heap.
+    Makes a(n)...
+  1. empty heap.
+  2. heap of [first, last), built bottom-up.
 
  Complexity:
-    Constant.
+  1. Constant.
+  2. Linear.
  */
 
 // 1. default
-template <class T>
-heap<T>::heap()
+template <class T, class Compare>
+heap<T, Compare>::heap(const Compare& compare)
+    : _compare(compare)
 {}
 
+// 2. range
+template <class T, class Compare>
+template <class InputIt>
+heap<T, Compare>::heap(InputIt first, InputIt last, const Compare& compare)
+    : _data(first, last)
+    , _compare(compare)
+{
+    make_heap();
+}
+
+
+
+// Capacity
 
 /*
- Function: destructor
+ Function: empty / size
  Parameters: None
+ Return value: Whether the heap is empty, and its number of elements.
+ */
+template <class T, class Compare>
+inline bool
+heap<T, Compare>::empty() const
+{
+    return _data.empty();
+}
+
+template <class T, class Compare>
+inline typename heap<T, Compare>::size_type
+heap<T, Compare>::size() const
+{
+    return _data.size();
+}
+
+
+
+// Element access
+
+/*
+ Function: get
+ Parameters: None
+ Return value: The top element. The heap must not be empty.
+ */
+template <class T, class Compare>
+inline typename heap<T, Compare>::const_reference
+heap<T, Compare>::get() const
+{
+    assert(!empty());
+    return _data[0];
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push / emplace
+ Parameters:
+  - element / args: The element, or arguments to construct it from.
+ Return value: None
+
+ Complexity: O(log n).
+ */
+template <class T, class Compare>
+void
+heap<T, Compare>::push(const_reference element)
+{
+    _data.push_back(element);
+    sift_up(_data.size() - 1);
+}
+
+template <class T, class Compare>
+void
+heap<T, Compare>::push(T&& element)
+{
+    _data.push_back(std::move(element));
+    sift_up(_data.size() - 1);
+}
+
+template <class T, class Compare>
+template <class... Args>
+void
+heap<T, Compare>::emplace(Args&&... args)
+{
+    _data.emplace_back(std::forward<Args>(args)...);
+    sift_up(_data.size() - 1);
+}
+
+
+/*
+ Function: pop
+ Parameters: None
+ Return value: None
+
+ Description:
+    Removes the top element. The heap must not be empty.
+
+ Complexity: O(log n).
+ */
+template <class T, class Compare>
+void
+heap<T, Compare>::pop()
+{
+    assert(!empty());
+    std::swap(_data.front(), _data.back());
+    _data.pop_back();
+    if (!_data.empty())
+        sift_down(0);
+}
+
+
+/*
+ Function: swap / clear
+ */
+template <class T, class Compare>
+void
+heap<T, Compare>::swap(heap& rhs)
+{
+    using std::swap;
+    swap(_data, rhs._data);
+    swap(_compare, rhs._compare);
+}
+
+template <class T, class Compare>
+void
+heap<T, Compare>::clear() noexcept
+{
+    _data.clear();
+}
+
+
+
+// Operations
+
+/*
+ Function: merge
+ Parameters:
+  - rhs: A heap to empty into this one.
  Return value: None
 
  Description:
-    Clears all data within the heap.
+    Moves every element of rhs into this heap and rebuilds it.
+
+ Complexity: Linear in the combined size.
  */
-template <class T>
-heap<T>::~heap()
-{} // Since destroying this will likely cause vector to clean up, maybe nothing is needed.
+template <class T, class Compare>
+void
+heap<T, Compare>::merge(heap& rhs)
+{
+    if (&rhs == this)
+        return;
+    _data.insert(_data.end(), std::make_move_iterator(rhs._data.begin()), std::make_move_iterator(rhs._data.end()));
+    rhs.clear();
+    make_heap();
+}
+
+template <class T, class Compare>
+void
+heap<T, Compare>::merge(heap&& rhs)
+{
+    merge(rhs);
+}
 
 
 
-// Assignment
+// Helper functions
+
+template <class T, class Compare>
+void
+heap<T, Compare>::sift_up(size_type i)
+{
+    T element = std::move(_data[i]);
+    for (; i && _compare(_data[parent(i)], element); i = parent(i))
+        _data[i] = std::move(_data[parent(i)]);
+    _data[i] = std::move(element);
+}
+
+template <class T, class Compare>
+void
+heap<T, Compare>::sift_down(size_type i)
+{
+    const size_type n = _data.size();
+    T element = std::move(_data[i]);
+    for (size_type child; (child = 2 * i + 1) < n; i = child) {
+        if (child + 1 < n && _compare(_data[child], _data[child + 1]))
+            ++child;
+        if (!_compare(element, _data[child]))
+            break;
+        _data[i] = std::move(_data[child]);
+    }
+    _data[i] = std::move(element);
+}
+
+template <class T, class Compare>
+void
+heap<T, Compare>::make_heap()
+{
+    for (size_type i = _data.size() / 2; i-- > 0;)
+        sift_down(i);
+}
+
+
+
+
+template <class Priority, class Compare = std::less<Priority>, std::size_t Arity = 4>
+class indexed_heap {
+
+    static_assert(Arity >= 2, "indexed_heap needs at least two children per node");
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef size_type   key_type;
+    typedef Priority    priority_type;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+
+/* Data members */
+private:
+    struct entry {
+        Priority priority;
+        key_type key;
+    };
+
+    std::vector<entry> _heap;
+    std::vector<size_type> _position;   // Slot of each key in _heap, or npos.
+    Compare _compare;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit indexed_heap(size_type = 0, const Compare& = Compare());
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    size_type keys() const;
+
+    /* Element access */
+    bool contains(key_type) const;
+    const Priority& priority(key_type) const;
+    key_type top() const;
+    const Priority& top_priority() const;
+
+    /* Modifiers */
+    void push(key_type, const Priority&);
+    void update(key_type, const Priority&);
+    bool push_or_update(key_type, const Priority&);
+    void pop();
+    void erase(key_type);
+    void resize(size_type);
+    void clear() noexcept;
+
+/* Helper functions */
+private:
+    void place(size_type, entry&&);
+    void sift_up(size_type);
+    void sift_down(size_type);
+};
+
+
+template <class Priority, class Compare, std::size_t Arity>
+constexpr typename indexed_heap<Priority, Compare, Arity>::size_type indexed_heap<Priority, Compare, Arity>::npos;
+
+
+
+// Constructors
 
 /*
- 
+ Function: constructor
+ Parameters:
+  - keys: The number of keys; keys are 0 to keys - 1.
+  - compare: The ordering; its greatest priority is on top.
+ Return value: None
+
+ Description:
+    Makes an empty heap over keys keys.
+
+ Complexity: Linear in keys.
  */
+template <class Priority, class Compare, std::size_t Arity>
+indexed_heap<Priority, Compare, Arity>::indexed_heap(size_type keys, const Compare& compare)
+    : _position(keys, npos)
+    , _compare(compare)
+{}
 
 
 
 // Capacity
 
 /*
- Function: empty
- Parameters: None
- Return value: Whether or not the heap is empty.
+ Function: empty / size / keys
+ Return value: Whether no key is queued, how many are, and how many keys
+               the heap was made for.
+ */
+template <class Priority, class Compare, std::size_t Arity>
+inline bool
+indexed_heap<Priority, Compare, Arity>::empty() const
+{
+    return _heap.empty();
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+inline typename indexed_heap<Priority, Compare, Arity>::size_type
+indexed_heap<Priority, Compare, Arity>::size() const
+{
+    return _heap.size();
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+inline typename indexed_heap<Priority, Compare, Arity>::size_type
+indexed_heap<Priority, Compare, Arity>::keys() const
+{
+    return _position.size();
+}
+
+
+
+// Element access
+
+/*
+ Function: contains / priority
+ Parameters:
+  - key: A key below keys().
+ Return value: Whether key is queued, and its priority, which it must be.
+
+ Complexity: Constant.
  */
-template <class T>
+template <class Priority, class Compare, std::size_t Arity>
 inline bool
-heap<T>::empty()
+indexed_heap<Priority, Compare, Arity>::contains(key_type key) const
+{
+    return _position[key] != npos;
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+inline const Priority&
+indexed_heap<Priority, Compare, Arity>::priority(key_type key) const
 {
-    return data.empty();
+    assert(contains(key));
+    return _heap[_position[key]].priority;
 }
 
 
 /*
- Function: size
- Parameters: None
- Return value: The size of the heap.
+ Function: top / top_priority
+ Return value: The key on top and its priority. The heap must not be empty.
+ */
+template <class Priority, class Compare, std::size_t Arity>
+inline typename indexed_heap<Priority, Compare, Arity>::key_type
+indexed_heap<Priority, Compare, Arity>::top() const
+{
+    assert(!empty());
+    return _heap[0].key;
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+inline const Priority&
+indexed_heap<Priority, Compare, Arity>::top_priority() const
+{
+    assert(!empty());
+    return _heap[0].priority;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push / update / push_or_update
+ Parameters:
+  - key: A key below keys().
+  - priority: Its new priority.
+ Return value: push_or_update returns whether key was newly queued.
+
+ Description:
+    push queues a key that is not queued; update changes the priority of
+    one that is, in either direction; push_or_update does whichever
+    applies.
+
+ Complexity: O(log n). Raising a key toward the top costs
+             O(log n / log Arity).
+
+ Exceptions:
+    Throws std::out_of_range if key is not below keys().
+ */
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::push(key_type key, const Priority& priority)
+{
+    if (key >= _position.size())
+        throw std::out_of_range("indexed_heap::push");
+    assert(!contains(key));
+
+    _heap.push_back(entry{priority, key});
+    _position[key] = _heap.size() - 1;
+    sift_up(_heap.size() - 1);
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::update(key_type key, const Priority& priority)
+{
+    if (key >= _position.size())
+        throw std::out_of_range("indexed_heap::update");
+    assert(contains(key));
+
+    const auto i = _position[key];
+    const bool up = _compare(_heap[i].priority, priority);
+    _heap[i].priority = priority;
+    if (up)
+        sift_up(i);
+    else
+        sift_down(i);
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+bool
+indexed_heap<Priority, Compare, Arity>::push_or_update(key_type key, const Priority& priority)
+{
+    if (key < _position.size() && contains(key)) {
+        update(key, priority);
+        return false;
+    }
+    push(key, priority);
+    return true;
+}
+
+
+/*
+ Function: pop / erase
+ Parameters:
+  - key: A queued key.
+ Return value: None
+
+ Description:
+    Dequeues the top key, or the given one.
+
+ Complexity: O(Arity log n / log Arity).
+ */
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::pop()
+{
+    assert(!empty());
+    erase(_heap[0].key);
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::erase(key_type key)
+{
+    assert(contains(key));
+    const auto i = _position[key];
+    _position[key] = npos;
+
+    entry last = std::move(_heap.back());
+    _heap.pop_back();
+    if (i == _heap.size())
+        return;
+
+    const bool up = _compare(_heap[i].priority, last.priority);
+    place(i, std::move(last));
+    if (up)
+        sift_up(i);
+    else
+        sift_down(i);
+}
+
+
+/*
+ Function: resize / clear
+ Parameters:
+  - keys: The new number of keys. Queued keys at or above it are dropped.
+
+ Description:
+    clear dequeues every key in time linear in the number queued, so a
+    search can reuse one heap without touching the whole position array.
+ */
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::resize(size_type keys)
+{
+    for (size_type k = keys; k < _position.size(); ++k)
+        if (contains(k))
+            erase(k);
+    _position.resize(keys, npos);
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::clear() noexcept
+{
+    for (auto& e : _heap)
+        _position[e.key] = npos;
+    _heap.clear();
+}
+
+
+
+// Helper functions
+
+template <class Priority, class Compare, std::size_t Arity>
+inline void
+indexed_heap<Priority, Compare, Arity>::place(size_type i, entry&& e)
+{
+    _position[e.key] = i;
+    _heap[i] = std::move(e);
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::sift_up(size_type i)
+{
+    entry e = std::move(_heap[i]);
+    while (i) {
+        auto p = (i - 1) / Arity;
+        if (!_compare(_heap[p].priority, e.priority))
+            break;
+        place(i, std::move(_heap[p]));
+        i = p;
+    }
+    place(i, std::move(e));
+}
+
+template <class Priority, class Compare, std::size_t Arity>
+void
+indexed_heap<Priority, Compare, Arity>::sift_down(size_type i)
+{
+    const size_type n = _heap.size();
+    entry e = std::move(_heap[i]);
+    for (;;) {
+        const size_type first = Arity * i + 1;
+        if (first >= n)
+            break;
+        size_type best = first;
+        for (size_type c = first + 1; c < std::min(n, first + Arity); ++c)
+            if (_compare(_heap[best].priority, _heap[c].priority))
+                best = c;
+        if (!_compare(e.priority, _heap[best].priority))
+            break;
+        place(i, std::move(_heap[best]));
+        i = best;
+    }
+    place(i, std::move(e));
+}
+
+
+
+
+template <class Key, class Value>
+class radix_heap {
+
+    static_assert(std::is_integral<Key>::value && std::is_unsigned<Key>::value,
+                  "radix_heap keys must be unsigned integers");
+
+/* Type definitions */
+public:
+    typedef std::size_t             size_type;
+    typedef Key                     key_type;
+    typedef std::pair<Key, Value>   value_type;
+
+
+/* Data members */
+private:
+    static constexpr size_type bits = std::numeric_limits<Key>::digits;
+
+    std::vector<value_type> _buckets[bits + 1];
+    Key _last = 0;
+    size_type _size = 0;
+
+
+/* Member functions */
+public:
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+
+    /* Element access */
+    const value_type& get();
+    Key last() const;
+
+    /* Modifiers */
+    void push(Key, const Value&);
+    void pop();
+    void clear() noexcept;
+
+/* Helper functions */
+private:
+    static size_type bucket(Key, Key);
+    void refill();
+};
+
+
+template <class Key, class Value>
+constexpr typename radix_heap<Key, Value>::size_type radix_heap<Key, Value>::bits;
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
  */
-template <class T>
+template <class Key, class Value>
 inline bool
-heap<T>::empty()
+radix_heap<Key, Value>::empty() const
 {
-    return data.size();
+    return _size == 0;
+}
+
+template <class Key, class Value>
+inline typename radix_heap<Key, Value>::size_type
+radix_heap<Key, Value>::size() const
+{
+    return _size;
 }
 
 
@@ -142,14 +749,31 @@ heap<T>::empty()
 /*
  Function: get
  Parameters: None
- Return value: A reference to the head element of the heap.
+ Return value: An element of least key. The heap must not be empty. Not
+               const: finding it may redistribute a bucket.
+
+ Complexity: Amortised O(bits).
  */
-template <class T>
-inline T&
-heap<T>::get()
+template <class Key, class Value>
+const typename radix_heap<Key, Value>::value_type&
+radix_heap<Key, Value>::get()
 {
     assert(!empty());
-    return data[0];
+    refill();
+    return _buckets[0].back();
+}
+
+
+/*
+ Function: last
+ Return value: The key last taken from the heap, which is the least that
+               may be pushed.
+ */
+template <class Key, class Value>
+inline Key
+radix_heap<Key, Value>::last() const
+{
+    return _last;
 }
 
 
@@ -158,63 +782,104 @@ heap<T>::get()
 
 /*
  Function: push
- Parameters: 
+ Parameters:
+  - key: At least last().
+  - value: The value to file under it.
+ Return value: None
+
+ Complexity: Constant.
+
+ Exceptions:
+    Throws std::out_of_range if key is below last().
  */
-template <class T>
+template <class Key, class Value>
 void
-heap<T>::push(const_ref element)
+radix_heap<Key, Value>::push(Key key, const Value& value)
 {
-    size_type curr = data.size();
-    data.push_back(element);
-
-    for (size_type p = parent(curr); data[p] < data[curr]; curr = p, p = parent(curr))
-        std::swap(data[parent], data[curr]);
+    if (key < _last)
+        throw std::out_of_range("radix_heap::push: key below the last popped");
+    _buckets[bucket(key, _last)].emplace_back(key, value);
+    ++_size;
 }
 
-template <class T>
+
+/*
+ Function: pop
+ Parameters: None
+ Return value: None
+
+ Description:
+    Removes the element get() returns. The heap must not be empty.
+
+ Complexity: Amortised O(bits).
+ */
+template <class Key, class Value>
 void
-heap<T>::push(rvalue_ref element)
+radix_heap<Key, Value>::pop()
 {
-    
+    assert(!empty());
+    refill();
+    _buckets[0].pop_back();
+    --_size;
 }
 
 
-/*
- Function: emplace
- */
-template <class T, class... Args>
+template <class Key, class Value>
 void
-heap<T>::emplace(Args&&...)
+radix_heap<Key, Value>::clear() noexcept
 {
-    
+    for (auto& b : _buckets)
+        b.clear();
+    _last = 0;
+    _size = 0;
 }
 
 
+
+// Helper functions
+
 /*
-Function: pop
-Parameters: None
-Return value: None
+ Function: bucket
+ Return value: 0 if key equals last, otherwise one more than the index of
+               the highest bit in which they differ.
+ */
+template <class Key, class Value>
+inline typename radix_heap<Key, Value>::size_type
+radix_heap<Key, Value>::bucket(Key key, Key last)
+{
+    auto x = static_cast<std::uint64_t>(key ^ last);
+    return x ? 64 - static_cast<size_type>(__builtin_clzll(x)) : 0;
+}
 
-Description:
 
-Complexity:
+/*
+ Function: refill
+ Description:
+    If bucket 0 is empty, makes the minimum of the first non-empty bucket
+    the new last key and refiles that bucket against it; all of its keys
+    land in lower buckets, the minimum's in bucket 0.
  */
-template <class T>
+template <class Key, class Value>
 void
-heap<T>::pop()
+radix_heap<Key, Value>::refill()
 {
-    
+    if (!_buckets[0].empty())
+        return;
+
+    size_type i = 1;
+    while (_buckets[i].empty())
+        ++i;
+
+    auto& from = _buckets[i];
+    _last = std::min_element(from.begin(), from.end(), [](const value_type& a, const value_type& b) {
+        return a.first < b.first;
+    })->first;
+    for (auto& e : from)
+        _buckets[bucket(e.first, _last)].push_back(std::move(e));
+    from.clear();
 }
-    
 
-void swap(heap<T>&);
-void clear() noexcept;
 
-/* Operations */
-void merge(heap<T>&);
-void merge(heap<T>&&);
-template <class Compare>
-    void merge(heap<T>&, Compare);
-template <class Compare>
-    void merge(heap<T>&&, Compare);
+} // end namespace
 
+#endif /* heap_h */
@@ -0,0 +1,1078 @@
+/*
+ File:   indexable_list.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A list that can also be indexed. Elements stay where they are put, and
+    iterators stay valid until their element is erased, as in list, but
+    finding the i-th element, an iterator's position, and inserting or
+    erasing anywhere are O(log n) instead of a walk from the front.
+
+ Implementation:
+  - A skip list ordered by position rather than by key. Every node has a
+    tower of forward links, one per level, and each link records its
+    width: how many elements it jumps over. Descending from the top
+    level and adding up widths finds any position in O(log n) expected
+    steps.
+  - Level 0 is also linked backwards, so iterators are bidirectional. The
+    dummy node is both the head and the end, at every level.
+  - A node's height is drawn once, with a quarter of the nodes reaching
+    each next level, which averages 1.33 links per node. The tower is
+    allocated in one block with the node.
+  - An iterator's position is found by walking forward along the top
+    link of each node it reaches until the end, and subtracting the
+    distance covered from size() + 1. Insert and erase at an iterator
+    find its position and then the predecessors at every level from the
+    top.
+  - Splicing moves nodes and their towers between lists without copying,
+    at O(log n) per element.
+ */
+
+
+#ifndef indexable_list_h
+#define indexable_list_h
+
+#include <cassert>           // assert
+#include <cstdint>           // uint64_t
+#include <initializer_list>  // initializer_list
+#include <iterator>          // iterator
+#include <memory>            // allocator, addressof
+#include <new>               // placement new
+#include <utility>           // move, forward, swap
+
+namespace ads {
+
+template <class T, class Alloc = std::allocator<T>>
+class indexable_list {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+    static constexpr unsigned max_height = 32;
+
+
+/* Node definition */
+private:
+    struct Node;
+
+    struct link {
+        Node* next;
+        size_type width;
+    };
+
+    // The tower of links follows the node in the same allocation, at an
+    // offset of sizeof(data_node) so that the dummy, which has no
+    // element, lays out the same way.
+    struct Node {
+        Node* prev = nullptr;
+        unsigned height = 0;
+    };
+
+    struct data_node : Node {
+        T data;
+
+        template <class... Args>
+        explicit data_node(Args&&... args) : data(std::forward<Args>(args)...) {}
+    };
+
+    typedef typename Alloc::template rebind<data_node>::other node_allocator;
+
+
+/* Iterators */
+public:
+    class const_iterator;
+
+    class iterator : public std::iterator< std::bidirectional_iterator_tag, value_type > {
+
+        friend class indexable_list<T, Alloc>;
+        friend class const_iterator;
+
+    /* Iterator data members */
+    private:
+        Node* node;
+
+    /* Iterator member functions */
+    public:
+        iterator(Node* n = nullptr) : node(n) {}
+        reference operator*() const { return static_cast<data_node*>(node)->data; }
+        pointer operator->() const { return std::addressof(static_cast<data_node*>(node)->data); }
+        iterator& operator++() { node = tower(node)[0].next; return *this; }
+        iterator operator++(int) { iterator temp(*this); ++*this; return temp; }
+        iterator& operator--() { node = node->prev; return *this; }
+        iterator operator--(int) { iterator temp(*this); --*this; return temp; }
+        iterator next() const { return iterator(tower(node)[0].next); }
+        iterator prev() const { return iterator(node->prev); }
+        bool operator==(const iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const iterator& rhs) const { return node != rhs.node; }
+    };
+
+
+    class const_iterator : public std::iterator< std::bidirectional_iterator_tag, const value_type > {
+
+        friend class indexable_list<T, Alloc>;
+
+    /* Iterator data members */
+    private:
+        Node* node;
+
+    /* Iterator member functions */
+    public:
+        const_iterator(Node* n = nullptr) : node(n) {}
+        const_iterator(const iterator& it) : node(it.node) {}
+        const_ref operator*() const { return static_cast<data_node*>(node)->data; }
+        const_ptr operator->() const { return std::addressof(static_cast<data_node*>(node)->data); }
+        const_iterator& operator++() { node = tower(node)[0].next; return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); ++*this; return temp; }
+        const_iterator& operator--() { node = node->prev; return *this; }
+        const_iterator operator--(int) { const_iterator temp(*this); --*this; return temp; }
+        const_iterator next() const { return const_iterator(tower(node)[0].next); }
+        const_iterator prev() const { return const_iterator(node->prev); }
+        bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
+    };
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+
+/* Data members */
+private:
+    Node* _dummy;               // Head of every level, and the end.
+    size_type _size = 0;
+    unsigned _levels = 1;       // Levels in use; the dummy's higher links are stale.
+    std::uint64_t _seed = 0x9e3779b97f4a7c15ull;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    indexable_list();
+    indexable_list(size_type, const_ref);
+    indexable_list(const indexable_list<T, Alloc>&);
+    indexable_list(indexable_list<T, Alloc>&&);
+    indexable_list(std::initializer_list<T>);
+    ~indexable_list();
+
+    /* Assignment */
+    indexable_list<T, Alloc>& operator=(indexable_list<T, Alloc>);
+    indexable_list<T, Alloc>& operator=(std::initializer_list<T>);
+
+    /* Iterators */
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin();
+    reverse_iterator rend();
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+
+    /* Element access */
+    reference front();
+    reference last();
+    reference at(size_type);
+    const_ref at(size_type) const;
+    reference operator[](size_type);
+    const_ref operator[](size_type) const;
+    iterator nth(size_type);
+    const_iterator nth(size_type) const;
+    size_type index_of(const_iterator) const;
+
+    /* Modifiers */
+    void push_front(const_ref);
+    void push_front(rvalue_ref);
+    void push_back(const_ref);
+    void push_back(rvalue_ref);
+    template <class... Args>
+        void emplace_front(Args&&...);
+    template <class... Args>
+        void emplace_back(Args&&...);
+    template <class... Args>
+        iterator emplace(const_iterator, Args&&...);
+    void pop_front();
+    void pop_back();
+    iterator insert(const_iterator, const_ref);
+    iterator insert(const_iterator, rvalue_ref);
+    iterator insert(const_iterator, size_type, const_ref);
+    iterator erase(const_iterator);
+    iterator erase(const_iterator, const_iterator);
+    void swap(indexable_list<T, Alloc>&);
+    void clear() noexcept;
+
+    /* Operations */
+    void splice(const_iterator, indexable_list<T, Alloc>&);
+    void splice(const_iterator, indexable_list<T, Alloc>&, const_iterator);
+    void splice(const_iterator, indexable_list<T, Alloc>&, const_iterator, const_iterator);
+
+/* Helper functions */
+private:
+    static link* tower(const Node*);
+    static size_type units(unsigned);
+    template <class... Args>
+        static Node* create_node(unsigned, Args&&...);
+    static void delete_node(Node*);
+
+    unsigned random_height();
+    Node* locate(size_type) const;
+    size_type position(const Node*) const;
+    void predecessors(size_type, Node**, size_type*) const;
+    void link_at(size_type, Node*);
+    Node* unlink_at(size_type);
+    template <class InputIt>
+        void append(InputIt, InputIt);
+};
+
+template <class T, class Alloc>
+constexpr unsigned indexable_list<T, Alloc>::max_height;
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - n: The number of times to insert 'element'.
+  - element: The element to be inserted.
+  - rhs: The list which is being either copied or moved from.
+  - il: Initializer list of elements.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty list.
+  2. list with n instances of 'element'.
+  3. copy of rhs.
+  4. list that takes over rhs's nodes, leaving rhs empty.
+  5. list with all elements in il, preserving order.
+
+ Complexity: Constant for 1 and 4, otherwise linear: nodes are appended
+             with the last node of every level in hand.
+ */
+
+// 1. default
+template <class T, class Alloc>
+indexable_list<T, Alloc>::indexable_list()
+{
+    node_allocator alloc;
+    _dummy = ::new (static_cast<void*>(alloc.allocate(units(max_height)))) Node();
+    _dummy->prev = _dummy;
+    _dummy->height = max_height;
+    tower(_dummy)[0] = link{_dummy, 1};
+}
+
+// 2. fill
+template <class T, class Alloc>
+indexable_list<T, Alloc>::indexable_list(size_type n, const_ref element)
+    : indexable_list()
+{
+    struct repeat {
+        const_ref value;
+        size_type left;
+        bool operator!=(const repeat& rhs) const { return left != rhs.left; }
+        repeat& operator++() { --left; return *this; }
+        const_ref operator*() const { return value; }
+    };
+
+    append(repeat{element, n}, repeat{element, 0});
+}
+
+// 3. copy
+template <class T, class Alloc>
+indexable_list<T, Alloc>::indexable_list(const indexable_list<T, Alloc>& rhs)
+    : indexable_list()
+{
+    append(rhs.begin(), rhs.end());
+}
+
+// 4. move
+template <class T, class Alloc>
+indexable_list<T, Alloc>::indexable_list(indexable_list<T, Alloc>&& rhs)
+    : indexable_list()
+{
+    swap(rhs);
+}
+
+// 5. initializer list
+template <class T, class Alloc>
+indexable_list<T, Alloc>::indexable_list(std::initializer_list<T> il)
+    : indexable_list()
+{
+    append(il.begin(), il.end());
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Alloc>
+indexable_list<T, Alloc>::~indexable_list()
+{
+    clear();
+    node_allocator alloc;
+    alloc.deallocate(static_cast<data_node*>(static_cast<void*>(_dummy)), units(max_height));
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: The list to copy or move from.
+  - il: An initializer list of new elements.
+ Return value: A reference to this list.
+
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+indexable_list<T, Alloc>&
+indexable_list<T, Alloc>::operator=(indexable_list<T, Alloc> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template <class T, class Alloc>
+indexable_list<T, Alloc>&
+indexable_list<T, Alloc>::operator=(std::initializer_list<T> il)
+{
+    clear();
+    append(il.begin(), il.end());
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end / cbegin / cend / rbegin / rend / crbegin / crend
+ Return value: Iterators to the first element and past the last, and
+               their const and reverse versions.
+ */
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::begin()
+{
+    return iterator(tower(_dummy)[0].next);
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::end()
+{
+    return iterator(_dummy);
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::const_iterator
+indexable_list<T, Alloc>::begin() const
+{
+    return cbegin();
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::const_iterator
+indexable_list<T, Alloc>::end() const
+{
+    return cend();
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::const_iterator
+indexable_list<T, Alloc>::cbegin() const
+{
+    return const_iterator(tower(_dummy)[0].next);
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::const_iterator
+indexable_list<T, Alloc>::cend() const
+{
+    return const_iterator(_dummy);
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::reverse_iterator
+indexable_list<T, Alloc>::rbegin()
+{
+    return reverse_iterator(end());
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::reverse_iterator
+indexable_list<T, Alloc>::rend()
+{
+    return reverse_iterator(begin());
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::const_reverse_iterator
+indexable_list<T, Alloc>::crbegin() const
+{
+    return const_reverse_iterator(cend());
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::const_reverse_iterator
+indexable_list<T, Alloc>::crend() const
+{
+    return const_reverse_iterator(cbegin());
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: Whether the list is empty, and the number of elements.
+ */
+template <class T, class Alloc>
+inline bool
+indexable_list<T, Alloc>::empty() const
+{
+    return _size == 0;
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::size_type
+indexable_list<T, Alloc>::size() const
+{
+    return _size;
+}
+
+
+
+// Element access
+
+/*
+ Function: front / last
+ Return value: A reference to the first or the last element.
+ */
+template <class T, class Alloc>
+inline T&
+indexable_list<T, Alloc>::front()
+{
+    assert(!empty());
+    return *begin();
+}
+
+template <class T, class Alloc>
+inline T&
+indexable_list<T, Alloc>::last()
+{
+    assert(!empty());
+    return static_cast<data_node*>(_dummy->prev)->data;
+}
+
+
+/*
+ Function: at / operator[] / nth
+ Parameters:
+  - index: A position in [0, size()), or up to size() for nth.
+ Return value: A reference to the element at index, or an iterator to it
+               (end() for size()).
+
+ Complexity: O(log n) expected.
+ */
+template <class T, class Alloc>
+inline T&
+indexable_list<T, Alloc>::at(size_type index)
+{
+    assert(index < _size);
+    return static_cast<data_node*>(locate(index + 1))->data;
+}
+
+template <class T, class Alloc>
+inline const T&
+indexable_list<T, Alloc>::at(size_type index) const
+{
+    assert(index < _size);
+    return static_cast<data_node*>(locate(index + 1))->data;
+}
+
+template <class T, class Alloc>
+inline T&
+indexable_list<T, Alloc>::operator[](size_type index)
+{
+    return at(index);
+}
+
+template <class T, class Alloc>
+inline const T&
+indexable_list<T, Alloc>::operator[](size_type index) const
+{
+    return at(index);
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::nth(size_type index)
+{
+    assert(index <= _size);
+    return iterator(index == _size ? _dummy : locate(index + 1));
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::const_iterator
+indexable_list<T, Alloc>::nth(size_type index) const
+{
+    assert(index <= _size);
+    return const_iterator(index == _size ? _dummy : locate(index + 1));
+}
+
+
+/*
+ Function: index_of
+ Parameters:
+  - pos: An iterator into this list.
+ Return value: Its index; size() for end().
+
+ Complexity: O(log n) expected.
+ */
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::size_type
+indexable_list<T, Alloc>::index_of(const_iterator pos) const
+{
+    return position(pos.node) - 1;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push_front / push_back / emplace_front / emplace_back
+ Parameters:
+  - element / args: The new element, or its constructor's arguments.
+ Return value: None
+
+ Complexity: O(log n) expected.
+ */
+template <class T, class Alloc>
+inline void
+indexable_list<T, Alloc>::push_front(const_ref element)
+{
+    emplace(cbegin(), element);
+}
+
+template <class T, class Alloc>
+inline void
+indexable_list<T, Alloc>::push_front(rvalue_ref element)
+{
+    emplace(cbegin(), std::move(element));
+}
+
+template <class T, class Alloc>
+inline void
+indexable_list<T, Alloc>::push_back(const_ref element)
+{
+    emplace(cend(), element);
+}
+
+template <class T, class Alloc>
+inline void
+indexable_list<T, Alloc>::push_back(rvalue_ref element)
+{
+    emplace(cend(), std::move(element));
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+indexable_list<T, Alloc>::emplace_front(Args&&... args)
+{
+    emplace(cbegin(), std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+indexable_list<T, Alloc>::emplace_back(Args&&... args)
+{
+    emplace(cend(), std::forward<Args>(args)...);
+}
+
+
+/*
+ Function: emplace / insert
+ Parameters:
+  - pos: The element to insert in front of.
+  - args / element: The new element, or its constructor's arguments.
+  - n: The number of copies of element to insert.
+ Return value: An iterator to the (first) new element, or pos if n is 0.
+
+ Complexity: O(log n) expected per element.
+ */
+template <class T, class Alloc>
+template <class... Args>
+typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::emplace(const_iterator pos, Args&&... args)
+{
+    auto node = create_node(random_height(), std::forward<Args>(args)...);
+    link_at(position(pos.node), node);
+    return iterator(node);
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::insert(const_iterator pos, const_ref element)
+{
+    return emplace(pos, element);
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::insert(const_iterator pos, rvalue_ref element)
+{
+    return emplace(pos, std::move(element));
+}
+
+template <class T, class Alloc>
+typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::insert(const_iterator pos, size_type n, const_ref element)
+{
+    auto p = position(pos.node);
+    for (auto i = n; i-- > 0;)
+        link_at(p, create_node(random_height(), element));
+    return iterator(n == 0 ? pos.node : locate(p));
+}
+
+
+/*
+ Function: pop_front / pop_back
+ Description:
+    Removes the first or the last element.
+
+ Complexity: O(log n) expected.
+ */
+template <class T, class Alloc>
+inline void
+indexable_list<T, Alloc>::pop_front()
+{
+    assert(!empty());
+    delete_node(unlink_at(1));
+}
+
+template <class T, class Alloc>
+inline void
+indexable_list<T, Alloc>::pop_back()
+{
+    assert(!empty());
+    delete_node(unlink_at(_size));
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - pos: The element to remove.
+  - first, last: The range of elements to remove.
+ Return value: An iterator to the element after the last one removed.
+
+ Complexity: O(log n) expected per element.
+ */
+template <class T, class Alloc>
+typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::erase(const_iterator pos)
+{
+    auto next = tower(pos.node)[0].next;
+    delete_node(unlink_at(position(pos.node)));
+    return iterator(next);
+}
+
+template <class T, class Alloc>
+typename indexable_list<T, Alloc>::iterator
+indexable_list<T, Alloc>::erase(const_iterator first, const_iterator last)
+{
+    if (first == last)
+        return iterator(last.node);
+
+    auto p = position(first.node);
+    while (first != last) {
+        ++first;
+        delete_node(unlink_at(p));
+    }
+    return iterator(last.node);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - rhs: The other list.
+ Return value: None
+
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::swap(indexable_list<T, Alloc>& rhs)
+{
+    std::swap(_dummy, rhs._dummy);
+    std::swap(_size, rhs._size);
+    std::swap(_levels, rhs._levels);
+    std::swap(_seed, rhs._seed);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every element.
+
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::clear() noexcept
+{
+    for (auto node = tower(_dummy)[0].next; node != _dummy;) {
+        auto next = tower(node)[0].next;
+        delete_node(node);
+        node = next;
+    }
+    _dummy->prev = _dummy;
+    tower(_dummy)[0] = link{_dummy, 1};
+    _size = 0;
+    _levels = 1;
+}
+
+
+
+// Operations
+
+/*
+ Function: splice
+ Parameters:
+  - pos: The element to move elements in front of.
+  - x: The list to take them from; may be this list, in which case pos
+       must not lie in the moved range.
+  - i: The element of x to move.
+  - first, last: The range of x to move.
+ Return value: None
+
+ Description:
+  1. Moves every element of x in front of pos.
+  2. Moves one element of x in front of pos.
+  3. Moves [first, last) of x in front of pos.
+    Nodes are relinked, not copied, so iterators to them stay valid and
+    now refer into this list.
+
+ Complexity: O(log n) expected per element moved; constant to move all
+             of x into an empty list.
+ */
+
+// 1. entire list
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::splice(const_iterator pos, indexable_list<T, Alloc>& x)
+{
+    if (this == &x)
+        return;
+    if (empty()) {
+        swap(x);
+        return;
+    }
+    splice(pos, x, x.cbegin(), x.cend());
+}
+
+// 2. single element
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::splice(const_iterator pos, indexable_list<T, Alloc>& x, const_iterator i)
+{
+    if (this == &x && (pos == i || pos == i.next()))
+        return;
+
+    auto node = x.unlink_at(x.position(i.node));
+    link_at(position(pos.node), node);
+}
+
+// 3. element range
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::splice(const_iterator pos, indexable_list<T, Alloc>& x, const_iterator first, const_iterator last)
+{
+    while (first != last)
+        splice(pos, x, first++);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: tower / units
+ Parameters:
+  - node: A node.
+  - height: A tower height.
+ Return value: The node's links, and how many data_node-sized units a
+               node with that many links takes.
+ */
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::link*
+indexable_list<T, Alloc>::tower(const Node* node)
+{
+    return reinterpret_cast<link*>(reinterpret_cast<char*>(const_cast<Node*>(node)) + sizeof(data_node));
+}
+
+template <class T, class Alloc>
+inline typename indexable_list<T, Alloc>::size_type
+indexable_list<T, Alloc>::units(unsigned height)
+{
+    return 1 + (height * sizeof(link) + sizeof(data_node) - 1) / sizeof(data_node);
+}
+
+
+/*
+ Function: create_node / delete_node
+ Parameters:
+  - height: The number of links.
+  - args: Arguments for the element's constructor.
+  - node: A node no longer linked into any list.
+ Return value: The new, unlinked node.
+ */
+template <class T, class Alloc>
+template <class... Args>
+typename indexable_list<T, Alloc>::Node*
+indexable_list<T, Alloc>::create_node(unsigned height, Args&&... args)
+{
+    node_allocator alloc;
+    auto node = alloc.allocate(units(height));
+    try {
+        alloc.construct(node, std::forward<Args>(args)...);
+    } catch (...) {
+        alloc.deallocate(node, units(height));
+        throw;
+    }
+    node->height = height;
+    return node;
+}
+
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::delete_node(Node* node)
+{
+    node_allocator alloc;
+    auto data = static_cast<data_node*>(node);
+    auto height = node->height;
+    alloc.destroy(data);
+    alloc.deallocate(data, units(height));
+}
+
+
+/*
+ Function: random_height
+ Return value: A height of at least 1, going up a level with probability
+               1/4 each time: two bits of an xorshift64 state per level.
+ */
+template <class T, class Alloc>
+unsigned
+indexable_list<T, Alloc>::random_height()
+{
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 7;
+    _seed ^= _seed << 17;
+
+    unsigned height = 1;
+    for (auto bits = _seed; height < max_height && (bits & 3) == 0; bits >>= 2)
+        ++height;
+    return height;
+}
+
+
+/*
+ Function: locate / position
+ Parameters:
+  - p: A position: 0 is the dummy, 1 to size() the elements.
+  - node: A node in this list, or the dummy as the end.
+ Return value: The node at position p, and the position of node, with
+               size() + 1 for the end.
+
+ Description:
+    locate descends from the top level adding widths. position walks
+    forward along each node's top link to the end and counts the
+    elements it jumps over.
+ */
+template <class T, class Alloc>
+typename indexable_list<T, Alloc>::Node*
+indexable_list<T, Alloc>::locate(size_type p) const
+{
+    auto node = _dummy;
+    size_type at = 0;
+    for (auto level = _levels; level-- > 0;) {
+        while (at + tower(node)[level].width <= p) {
+            at += tower(node)[level].width;
+            node = tower(node)[level].next;
+        }
+    }
+    return node;
+}
+
+template <class T, class Alloc>
+typename indexable_list<T, Alloc>::size_type
+indexable_list<T, Alloc>::position(const Node* node) const
+{
+    size_type ahead = 0;
+    while (node != _dummy) {
+        auto& top = tower(node)[node->height - 1];
+        ahead += top.width;
+        node = top.next;
+    }
+    return _size + 1 - ahead;
+}
+
+
+/*
+ Function: predecessors
+ Parameters:
+  - p: A position from 1 to size() + 1.
+  - before: Filled, for each level in use, with the last node before p.
+  - at: Filled with those nodes' positions.
+ */
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::predecessors(size_type p, Node** before, size_type* at) const
+{
+    auto node = _dummy;
+    size_type here = 0;
+    auto level = _levels;
+    do {
+        --level;
+        while (here + tower(node)[level].width < p) {
+            here += tower(node)[level].width;
+            node = tower(node)[level].next;
+        }
+        before[level] = node;
+        at[level] = here;
+    } while (level > 0);
+}
+
+
+/*
+ Function: link_at / unlink_at
+ Parameters:
+  - p: The position the node takes, or leaves.
+  - node: An unlinked node, with its height set.
+ Return value: unlink_at returns the node it took out.
+
+ Description:
+    Splits or joins the link over p at each level the node reaches, and
+    widens or narrows the links above it. Levels come into use as a node
+    first reaches them and go out of use when their last node leaves.
+
+ Complexity: O(log n) expected.
+ */
+template <class T, class Alloc>
+void
+indexable_list<T, Alloc>::link_at(size_type p, Node* node)
+{
+    for (; _levels < node->height; ++_levels)
+        tower(_dummy)[_levels] = link{_dummy, _size + 1};
+
+    Node* before[max_height];
+    size_type at[max_height];
+    predecessors(p, before, at);
+
+    auto links = tower(node);
+    for (unsigned level = 0; level < _levels; ++level) {
+        auto& over = tower(before[level])[level];
+        if (level < node->height) {
+            links[level] = link{over.next, at[level] + over.width + 1 - p};
+            over = link{node, p - at[level]};
+        } else {
+            ++over.width;
+        }
+    }
+    node->prev = before[0];
+    links[0].next->prev = node;
+    ++_size;
+}
+
+template <class T, class Alloc>
+typename indexable_list<T, Alloc>::Node*
+indexable_list<T, Alloc>::unlink_at(size_type p)
+{
+    Node* before[max_height];
+    size_type at[max_height];
+    predecessors(p, before, at);
+
+    auto node = tower(before[0])[0].next;
+    auto links = tower(node);
+    for (unsigned level = 0; level < _levels; ++level) {
+        auto& over = tower(before[level])[level];
+        if (over.next == node)
+            over = link{links[level].next, over.width + links[level].width - 1};
+        else
+            --over.width;
+    }
+    links[0].next->prev = node->prev;
+    --_size;
+
+    while (_levels > 1 && tower(_dummy)[_levels - 1].next == _dummy)
+        --_levels;
+    return node;
+}
+
+
+/*
+ Function: append
+ Parameters:
+  - first, last: Elements to add at the end.
+
+ Description:
+    Keeps the last node of every level and its position, links each new
+    node after them, and points the last ones at the end once done.
+
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+template <class InputIt>
+void
+indexable_list<T, Alloc>::append(InputIt first, InputIt last)
+{
+    Node* tail[max_height];
+    size_type at[max_height];
+    predecessors(_size + 1, tail, at);
+
+    for (; first != last; ++first) {
+        auto node = create_node(random_height(), *first);
+        auto p = ++_size;
+        for (; _levels < node->height; ++_levels) {
+            tail[_levels] = _dummy;
+            at[_levels] = 0;
+        }
+        node->prev = tail[0];
+        for (unsigned level = 0; level < node->height; ++level) {
+            tower(tail[level])[level] = link{node, p - at[level]};
+            tail[level] = node;
+            at[level] = p;
+        }
+    }
+
+    for (unsigned level = 0; level < _levels; ++level)
+        tower(tail[level])[level] = link{_dummy, _size + 1 - at[level]};
+    _dummy->prev = tail[0];
+}
+
+
+} // end namespace
+
+#endif /* indexable_list_h */
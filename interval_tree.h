@@ -0,0 +1,325 @@
+/*
+ File:   interval_tree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A set of closed intervals [low, high] that answers "which of them
+    contain this point?" (stabbing) and "which of them overlap this
+    interval?" without looking at the ones that cannot.
+
+ Implementation:
+  - A redblack_tree of intervals ordered by low endpoint, then high,
+    augmented with the largest high endpoint in each subtree. The tree
+    recomputes that maximum on the insertion path and in rotate_left and
+    rotate_right, each a constant amount of work, so insertion stays
+    O(log n).
+  - A query skips every subtree whose maximum is below the query's low
+    end, and stops going right once intervals start past its high end.
+    Every left subtree it enters then holds at least one answer, so a
+    query costs O(log n) plus the paths down to the answers: O(log n + k)
+    when the answers cluster, as they do for short intervals, and never
+    more than O(min(n, (k + 1) log n)).
+  - Building from sorted intervals links a balanced tree in linear time
+    instead of n insertions.
+
+ TODO:
+  - Removal, once redblack_tree has it.
+ */
+
+
+#ifndef interval_tree_h
+#define interval_tree_h
+
+#include <initializer_list>  // initializer_list
+#include <stdexcept>         // invalid_argument
+#include <vector>            // vector
+
+#include "redblack_tree.h"
+
+namespace ads {
+
+// A closed interval, ordered by low endpoint and then high.
+template <class Key>
+struct interval {
+    Key low, high;
+
+    bool contains(const Key& point) const { return !(point < low) && !(high < point); }
+    bool overlaps(const interval& b) const { return !(b.high < low) && !(high < b.low); }
+
+    bool operator<(const interval& b) const { return low < b.low || (!(b.low < low) && high < b.high); }
+    bool operator==(const interval& b) const { return !(*this < b) && !(b < *this); }
+};
+
+
+// The redblack_tree augmentation: the largest high endpoint in a subtree.
+template <class Key>
+struct interval_max {
+    struct summary_type {
+        Key max;
+    };
+
+    template <class Node>
+    static void update(Node* node)
+    {
+        node->max = node->data.high;
+        if (node->left && node->max < node->left->max)
+            node->max = node->left->max;
+        if (node->right && node->max < node->right->max)
+            node->max = node->right->max;
+    }
+};
+
+
+template <class Key>
+class interval_tree : private redblack_tree<interval<Key>, interval_max<Key>> {
+
+/* Type definitions */
+public:
+    typedef std::size_t     size_type;
+    typedef Key             key_type;
+    typedef interval<Key>   value_type;
+
+private:
+    typedef redblack_tree<interval<Key>, interval_max<Key>> base;
+    typedef typename base::Node Node;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    interval_tree() = default;
+    template <class ForwardIt>
+        interval_tree(ForwardIt, ForwardIt);
+    interval_tree(std::initializer_list<value_type>);
+
+    /* Capacity */
+    using base::empty;
+    using base::size;
+    using base::height;
+
+    /* Element access */
+    bool has(const value_type&) const;
+
+    /* Modifiers */
+    bool insert(const value_type&);
+    bool insert(const Key&, const Key&);
+    using base::clear;
+
+    /* Operations */
+    template <class F>
+        void stab(const Key&, F) const;
+    std::vector<value_type> stab(const Key&) const;
+    template <class F>
+        void overlap(const value_type&, F) const;
+    std::vector<value_type> overlap(const value_type&) const;
+    const value_type* any_overlap(const value_type&) const;
+
+/* Helper functions */
+private:
+    template <class F>
+        static void report(const Node*, const value_type&, F&);
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - first, last / list: Intervals sorted by low endpoint and then high,
+                        with no repeats.
+ Return value: None
+
+ Description:
+    Makes a tree of the given intervals:
+    1. range
+    2. initializer list
+
+ Complexity: Linear.
+
+ Exceptions:
+    Throws std::invalid_argument if the intervals are out of order,
+    repeated, or have high below low.
+ */
+// 1. range
+template <class Key>
+template <class ForwardIt>
+interval_tree<Key>::interval_tree(ForwardIt first, ForwardIt last)
+{
+    for (auto it = first; it != last; ++it)
+        if (it->high < it->low)
+            throw std::invalid_argument("interval_tree: high endpoint below low");
+    this->build(first, last);
+}
+
+// 2. initializer list
+template <class Key>
+interval_tree<Key>::interval_tree(std::initializer_list<value_type> list)
+    : interval_tree(list.begin(), list.end())
+{}
+
+
+
+// Element access
+
+/*
+ Function: has
+ Parameters:
+  - i: An interval.
+ Return value: Whether the tree holds exactly that interval.
+
+ Complexity: O(log n).
+ */
+template <class Key>
+inline bool
+interval_tree<Key>::has(const value_type& i) const
+{
+    return base::has(i);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert
+ Parameters:
+  - i / low, high: The interval to add.
+ Return value: Whether it was added; false if the tree already held it.
+
+ Complexity: O(log n).
+
+ Exceptions:
+    Throws std::invalid_argument if high is below low.
+ */
+template <class Key>
+bool
+interval_tree<Key>::insert(const value_type& i)
+{
+    if (i.high < i.low)
+        throw std::invalid_argument("interval_tree::insert: high endpoint below low");
+
+    auto before = size();
+    this->push(i);
+    return size() != before;
+}
+
+template <class Key>
+inline bool
+interval_tree<Key>::insert(const Key& low, const Key& high)
+{
+    return insert(value_type{low, high});
+}
+
+
+
+// Operations
+
+/*
+ Function: stab / overlap
+ Parameters:
+  - point / query: What to look for.
+  - f: Called with each interval that contains point or overlaps query,
+       in increasing order.
+ Return value: The visitor versions return nothing; the others return
+               the intervals found, in increasing order.
+
+ Complexity: O(log n + k) for k results when they cluster; at worst
+             O(min(n, (k + 1) log n)).
+ */
+template <class Key>
+template <class F>
+inline void
+interval_tree<Key>::stab(const Key& point, F f) const
+{
+    report(this->_root, value_type{point, point}, f);
+}
+
+template <class Key>
+std::vector<typename interval_tree<Key>::value_type>
+interval_tree<Key>::stab(const Key& point) const
+{
+    std::vector<value_type> found;
+    stab(point, [&](const value_type& i) { found.push_back(i); });
+    return found;
+}
+
+template <class Key>
+template <class F>
+inline void
+interval_tree<Key>::overlap(const value_type& query, F f) const
+{
+    report(this->_root, query, f);
+}
+
+template <class Key>
+std::vector<typename interval_tree<Key>::value_type>
+interval_tree<Key>::overlap(const value_type& query) const
+{
+    std::vector<value_type> found;
+    overlap(query, [&](const value_type& i) { found.push_back(i); });
+    return found;
+}
+
+
+/*
+ Function: any_overlap
+ Parameters:
+  - query: An interval.
+ Return value: Some stored interval that overlaps query, or nullptr if
+               none does.
+
+ Description:
+    Walks a single path: left whenever the left subtree reaches query's
+    low end (if anything overlaps, something there does), right
+    otherwise.
+
+ Complexity: O(log n).
+ */
+template <class Key>
+const typename interval_tree<Key>::value_type*
+interval_tree<Key>::any_overlap(const value_type& query) const
+{
+    const Node* node = this->_root;
+    while (node && !node->data.overlaps(query))
+        node = node->left && !(node->left->max < query.low) ? node->left : node->right;
+    return node ? &node->data : nullptr;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: report
+ Parameters:
+  - node: The subtree to search.
+  - query: The interval to overlap.
+  - f: The visitor.
+
+ Description:
+    In-order over the subtree, skipping subtrees whose maximum is below
+    query.low and everything from the first interval that starts past
+    query.high. Recursion follows left children and the loop right
+    ones, so the depth is the tree's height.
+ */
+template <class Key>
+template <class F>
+void
+interval_tree<Key>::report(const Node* node, const value_type& query, F& f)
+{
+    while (node && !(node->max < query.low)) {
+        report(node->left, query, f);
+        if (query.high < node->data.low)
+            return;
+        if (!(node->data.high < query.low))
+            f(node->data);
+        node = node->right;
+    }
+}
+
+
+} // end namespace
+
+#endif /* interval_tree_h */
@@ -0,0 +1,436 @@
+/*
+ File:   kd_tree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A static k-d tree over points of a compile-time dimension, for
+    nearest-neighbour, k-nearest-neighbour and axis-aligned box queries.
+    Built once from a vector of points, optionally on a thread_pool;
+    queries answer with the points' indices in that vector.
+
+ Implementation:
+  - Implicit layout: the points are permuted so that the subtree over
+    [lo, hi) has its splitting point at mid = (lo + hi) / 2, the left
+    subtree over [lo, mid) and the right over [mid + 1, hi). No node
+    holds a pointer; the only per-node data is a byte naming the split
+    dimension, stored at mid.
+  - Building splits on the dimension of widest spread at the median,
+    found with nth_element, so every level costs O(n) and the tree is
+    O(log n) deep: O(n log n) in all. On a pool the two halves of every
+    large subtree are built in parallel with fork_join.
+  - Subtrees of at most 8 points are leaves and are scanned in order,
+    which is cheaper than descending through them.
+  - Queries descend toward the query point first and visit the far side
+    of a split only if the splitting plane is closer than the worst
+    candidate so far. k-NN keeps its candidates in a bounded max-heap
+    (ads::heap), so the worst is always on top.
+  - Distances are squared Euclidean, in T.
+
+ TODO:
+  - Insertion and deletion, by rebuilding subtrees (scapegoat style).
+ */
+
+
+#ifndef kd_tree_h
+#define kd_tree_h
+
+#include <algorithm>  // nth_element, min, max
+#include <array>      // array
+#include <cstdint>    // uint8_t
+#include <limits>     // numeric_limits
+#include <utility>    // pair
+#include <vector>     // vector
+
+#include "heap.h"
+#include "thread_pool.h"
+
+namespace ads {
+
+template <std::size_t Dim, class T = float>
+class kd_tree {
+
+    static_assert(Dim >= 1 && Dim <= 255, "kd_tree dimension must be between 1 and 255");
+
+/* Type definitions */
+public:
+    typedef std::size_t                     size_type;
+    typedef T                               coordinate_type;
+    typedef std::array<T, Dim>              point_type;
+    typedef std::pair<T, size_type>         neighbour;   // (squared distance, index)
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+    static constexpr size_type dimension = Dim;
+
+
+/* Data members */
+private:
+    static constexpr size_type leaf = 8;
+    static constexpr size_type parallel_cutoff = 1 << 14;
+
+    struct entry {
+        point_type point;
+        size_type index;
+    };
+
+    std::vector<point_type> _points;     // In tree order.
+    std::vector<size_type> _index;       // Input index of each point in tree order.
+    std::vector<std::uint8_t> _split;    // Split dimension of the node at each mid.
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    kd_tree() = default;
+    explicit kd_tree(const std::vector<point_type>&);
+    kd_tree(const std::vector<point_type>&, thread_pool&);
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+
+    /* Operations */
+    size_type nearest(const point_type&) const;
+    std::vector<neighbour> nearest(const point_type&, size_type) const;
+    std::vector<size_type> range(const point_type&, const point_type&) const;
+    static T distance(const point_type&, const point_type&);
+
+/* Helper functions */
+private:
+    void build(const std::vector<point_type>&, thread_pool*);
+    void split(std::vector<entry>&, size_type, size_type, thread_pool*);
+    template <class Visit>
+        void search(const point_type&, size_type, size_type, T&, Visit&) const;
+    void collect(const point_type&, const point_type&, size_type, size_type, std::vector<size_type>&) const;
+};
+
+
+template <std::size_t Dim, class T>
+constexpr typename kd_tree<Dim, T>::size_type kd_tree<Dim, T>::npos;
+template <std::size_t Dim, class T>
+constexpr typename kd_tree<Dim, T>::size_type kd_tree<Dim, T>::dimension;
+template <std::size_t Dim, class T>
+constexpr typename kd_tree<Dim, T>::size_type kd_tree<Dim, T>::leaf;
+template <std::size_t Dim, class T>
+constexpr typename kd_tree<Dim, T>::size_type kd_tree<Dim, T>::parallel_cutoff;
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - points: The points to index. Duplicates are allowed.
+  - pool: Threads to build with.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty tree (defaulted in the class).
+  2. tree of points, built on the calling thread.
+  3. tree of points, built on pool. The result is identical.
+
+ Complexity: O(n log n); divided by the available parallelism on a pool,
+             apart from the top levels' linear partitions.
+ */
+
+// 2. sequential
+template <std::size_t Dim, class T>
+kd_tree<Dim, T>::kd_tree(const std::vector<point_type>& points)
+{
+    build(points, nullptr);
+}
+
+// 3. parallel
+template <std::size_t Dim, class T>
+kd_tree<Dim, T>::kd_tree(const std::vector<point_type>& points, thread_pool& pool)
+{
+    build(points, &pool);
+}
+
+
+
+// Capacity
+
+template <std::size_t Dim, class T>
+inline bool
+kd_tree<Dim, T>::empty() const
+{
+    return _points.empty();
+}
+
+template <std::size_t Dim, class T>
+inline typename kd_tree<Dim, T>::size_type
+kd_tree<Dim, T>::size() const
+{
+    return _points.size();
+}
+
+
+
+// Operations
+
+/*
+ Function: nearest
+ Parameters:
+  - query: A point.
+  - k: How many neighbours to find.
+ Return value:
+  1. The index of a point nearest query, or npos if the tree is empty.
+  2. The k points nearest query (fewer if the tree is smaller) as
+     (squared distance, index) pairs, nearest first. Ties are broken
+     arbitrarily.
+
+ Complexity: O(log n) expected for well-spread points in low dimension;
+             O(n) at worst.
+ */
+
+// 1. one neighbour
+template <std::size_t Dim, class T>
+typename kd_tree<Dim, T>::size_type
+kd_tree<Dim, T>::nearest(const point_type& query) const
+{
+    size_type best = npos;
+    T worst = std::numeric_limits<T>::max();
+    auto visit = [&](size_type i, T d) {
+        if (d < worst) {
+            worst = d;
+            best = i;
+        }
+    };
+    search(query, 0, size(), worst, visit);
+    return best == npos ? npos : _index[best];
+}
+
+// 2. k neighbours
+template <std::size_t Dim, class T>
+std::vector<typename kd_tree<Dim, T>::neighbour>
+kd_tree<Dim, T>::nearest(const point_type& query, size_type k) const
+{
+    std::vector<neighbour> result;
+    if (k == 0)
+        return result;
+
+    heap<neighbour> candidates;
+    T worst = std::numeric_limits<T>::max();
+    auto visit = [&](size_type i, T d) {
+        if (candidates.size() == k) {
+            if (d >= worst)
+                return;
+            candidates.pop();
+        }
+        candidates.emplace(d, _index[i]);
+        if (candidates.size() == k)
+            worst = candidates.get().first;
+    };
+    search(query, 0, size(), worst, visit);
+
+    result.resize(candidates.size());
+    for (auto i = result.size(); i-- > 0; candidates.pop())
+        result[i] = candidates.get();
+    return result;
+}
+
+
+/*
+ Function: range
+ Parameters:
+  - low, high: Opposite corners of a box, low no greater than high in
+               every dimension.
+ Return value: The indices of the points inside the box, boundary
+               included, in no particular order.
+
+ Complexity: O(n^(1 - 1/Dim) + m) for m points reported.
+ */
+template <std::size_t Dim, class T>
+std::vector<typename kd_tree<Dim, T>::size_type>
+kd_tree<Dim, T>::range(const point_type& low, const point_type& high) const
+{
+    std::vector<size_type> result;
+    collect(low, high, 0, size(), result);
+    return result;
+}
+
+
+/*
+ Function: distance
+ Return value: The squared Euclidean distance between a and b.
+ */
+template <std::size_t Dim, class T>
+inline T
+kd_tree<Dim, T>::distance(const point_type& a, const point_type& b)
+{
+    T sum = 0;
+    for (size_type d = 0; d < Dim; ++d)
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    return sum;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: build
+ Description:
+    Pairs each point with its index, arranges the pairs in tree order,
+    then separates them into the point and index arrays.
+ */
+template <std::size_t Dim, class T>
+void
+kd_tree<Dim, T>::build(const std::vector<point_type>& points, thread_pool* pool)
+{
+    const size_type n = points.size();
+    std::vector<entry> entries(n);
+    for (size_type i = 0; i < n; ++i)
+        entries[i] = entry{points[i], i};
+    _split.assign(n, 0);
+
+    if (pool)
+        pool->run([&]{ split(entries, 0, n, pool); });
+    else
+        split(entries, 0, n, nullptr);
+
+    _points.resize(n);
+    _index.resize(n);
+    for (size_type i = 0; i < n; ++i) {
+        _points[i] = entries[i].point;
+        _index[i] = entries[i].index;
+    }
+}
+
+
+/*
+ Function: split
+ Parameters:
+  - entries: The points being arranged.
+  - lo, hi: The subtree to arrange.
+  - pool: Threads to build with, or null.
+
+ Description:
+    Picks the dimension of widest spread over [lo, hi), puts the median
+    along it at mid with no greater coordinate before it and no smaller
+    after, and recurses on both sides.
+ */
+template <std::size_t Dim, class T>
+void
+kd_tree<Dim, T>::split(std::vector<entry>& entries, size_type lo, size_type hi, thread_pool* pool)
+{
+    if (hi - lo <= leaf)
+        return;
+
+    point_type low = entries[lo].point, high = entries[lo].point;
+    for (auto i = lo + 1; i < hi; ++i) {
+        for (size_type d = 0; d < Dim; ++d) {
+            low[d] = std::min(low[d], entries[i].point[d]);
+            high[d] = std::max(high[d], entries[i].point[d]);
+        }
+    }
+    size_type dim = 0;
+    for (size_type d = 1; d < Dim; ++d)
+        if (high[d] - low[d] > high[dim] - low[dim])
+            dim = d;
+
+    const auto mid = lo + (hi - lo) / 2;
+    std::nth_element(entries.begin() + static_cast<std::ptrdiff_t>(lo), entries.begin() + static_cast<std::ptrdiff_t>(mid),
+                     entries.begin() + static_cast<std::ptrdiff_t>(hi),
+                     [dim](const entry& a, const entry& b) { return a.point[dim] < b.point[dim]; });
+    _split[mid] = static_cast<std::uint8_t>(dim);
+
+    if (pool && hi - lo > parallel_cutoff)
+        pool->fork_join([&]{ split(entries, lo, mid, pool); }, [&]{ split(entries, mid + 1, hi, pool); });
+    else {
+        split(entries, lo, mid, nullptr);
+        split(entries, mid + 1, hi, nullptr);
+    }
+}
+
+
+/*
+ Function: search
+ Parameters:
+  - query: The point searched around.
+  - lo, hi: The subtree to search.
+  - worst: The squared distance a point must beat to matter; visit
+           lowers it as candidates improve.
+  - visit: Called as visit(i, d) for each point in tree order i at
+           squared distance d that is not pruned.
+ */
+template <std::size_t Dim, class T>
+template <class Visit>
+void
+kd_tree<Dim, T>::search(const point_type& query, size_type lo, size_type hi, T& worst, Visit& visit) const
+{
+    while (hi - lo > leaf) {
+        const auto mid = lo + (hi - lo) / 2;
+        const auto dim = _split[mid];
+        const T gap = query[dim] - _points[mid][dim];
+
+        visit(mid, distance(query, _points[mid]));
+        // Nearer side now, farther side after, if the plane is in reach.
+        if (gap < 0) {
+            search(query, lo, mid, worst, visit);
+            if (gap * gap >= worst)
+                return;
+            lo = mid + 1;
+        } else {
+            search(query, mid + 1, hi, worst, visit);
+            if (gap * gap >= worst)
+                return;
+            hi = mid;
+        }
+    }
+
+    for (auto i = lo; i < hi; ++i)
+        visit(i, distance(query, _points[i]));
+}
+
+
+/*
+ Function: collect
+ Parameters:
+  - low, high: The box.
+  - lo, hi: The subtree to search.
+  - out: Where to append the indices found.
+ */
+template <std::size_t Dim, class T>
+void
+kd_tree<Dim, T>::collect(const point_type& low, const point_type& high, size_type lo, size_type hi,
+                         std::vector<size_type>& out) const
+{
+    auto inside = [&](const point_type& p) {
+        for (size_type d = 0; d < Dim; ++d)
+            if (p[d] < low[d] || p[d] > high[d])
+                return false;
+        return true;
+    };
+
+    while (hi - lo > leaf) {
+        const auto mid = lo + (hi - lo) / 2;
+        const auto dim = _split[mid];
+        const T at = _points[mid][dim];
+
+        if (inside(_points[mid]))
+            out.push_back(_index[mid]);
+        const bool left = low[dim] <= at, right = high[dim] >= at;
+        if (left && right) {
+            collect(low, high, lo, mid, out);
+            lo = mid + 1;
+        } else if (left) {
+            hi = mid;
+        } else if (right) {
+            lo = mid + 1;
+        } else {
+            return;
+        }
+    }
+
+    for (auto i = lo; i < hi; ++i)
+        if (inside(_points[i]))
+            out.push_back(_index[i]);
+}
+
+
+} // end namespace
+
+#endif /* kd_tree_h */
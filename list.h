@@ -11,12 +11,30 @@
     elements. 
   - A single dummy node is used to simplify insertion and deletion operations as well as 
     iterator functions like end() and rbegin().
+  - Filling, range and initializer-list inserts, and the constructors and assigns built on
+    them, allocate their nodes as one contiguous block. Nodes carry no record of their
+    block: each list keeps the blocks it holds nodes of in a vector sorted by address,
+    with how many of its nodes each one has, and a node's block is found by binary
+    search there. A list that never bulk-inserts has an empty vector and pays one
+    emptiness check per erase. Splicing moves only the moved nodes' counts, and a list
+    drops a block when its count reaches zero. A block is freed once no list holds it.
+    While every node of a list is in its blocks, clear() frees the blocks without
+    visiting the nodes when T is trivially destructible.
+  - The third template parameter picks the node layout. doubly_linked is the list
+    described above. singly_linked drops prev, saving a pointer per node, and keeps a
+    tail pointer so it still works as a queue. xor_linked stores prev ^ next in one
+    field and walks both ways with iterators that carry the previous node. Each
+    layout is its own specialisation and offers only what it can do.
+  - intrusive_list links objects that live elsewhere through a list_hook member of theirs,
+    so it never allocates, and an object with several hooks can be on several lists.
+  - merge_k merges k sorted lists through a tournament tree of their fronts.
+    parallel_list.h adds an overload that merges halves of the lists on a thread_pool.
  
  TODO:
   - Get const_reverse_iterator functions working.
   - Test with valgrind for memory leaks. Like for real. Who knows what's happened with these
     allocators now.
-  - Find out what merge(&&, comp) needs different from merge(&, comp). (Also insert& and &&)
+  - Find out what insert(&) needs different from insert(&&).
   - See how much code can be moved from derived iterators to list_iterator.
   - Find out how the current use of allocators actually works.
   - Find out what emplace constructed means and how it applies to range constructor.
@@ -30,15 +48,27 @@
 #include <algorithm>   // move
 #include <cassert>     // assert
 #include <cstddef>     // ptrdiff_t
+#include <cstdint>     // uintptr_t
 #include <functional>  // function
 #include <iterator>    // iterator
 #include <memory>      // allocator
+#include <new>         // placement new
+#include <type_traits> // aligned_storage, is_trivially_destructible
 #include <utility>     // swap
+#include <vector>      // vector
 
 namespace ads {
 
-template <class T, class Alloc = std::allocator<T>>
-class list {
+// Node layouts for list, chosen by its third template parameter.
+struct doubly_linked {};   // prev and next: the full interface.
+struct singly_linked {};   // next only: a forward list for queue-style use.
+struct xor_linked {};      // prev ^ next in one field: both directions, no splicing.
+
+template <class T, class Alloc = std::allocator<T>, class Layout = doubly_linked>
+class list;
+
+template <class T, class Alloc>
+class list<T, Alloc, doubly_linked> {
     
 /* Type definitions */
 public:
@@ -68,7 +98,7 @@ private:
         static Node* create_dummy();
         static Node* create_node(const_ref, Node*);
         static Node* create_node(rvalue_ref, Node*);
-        static void  delete_node(Node*);
+        static void  delete_dummy(Node*);
     };
     
     class data_node : public Node {
@@ -80,6 +110,29 @@ private:
         data_node(const_ref, Node*);
         data_node(rvalue_ref, Node*);
     };
+    
+    // A block is its header followed by capacity nodes. It stays allocated
+    // while any list holds one of its nodes, so that list can search its
+    // blocks by address without meeting memory reused for something else.
+    struct block_header {
+        size_type capacity;
+        size_type refs;       // Lists with an entry for it.
+    };
+    
+    struct block_entry {
+        block_header* block;
+        size_type count;      // The list's nodes from block, at least one.
+    };
+    
+    typedef std::vector<block_entry, typename Alloc::template rebind<block_entry>::other> block_set;
+    
+    struct root_node : Node {
+        block_set blocks;     // Sorted by address.
+    };
+    
+    typedef typename Alloc::template rebind<data_node>::other node_allocator;
+    
+    static constexpr size_type header_slots = (sizeof(block_header) + sizeof(data_node) - 1) / sizeof(data_node);
 
     
 /* Iterators */
@@ -128,6 +181,7 @@ public:
     /* Iterator member functions */
     public:
         const_iterator(Node* n) : list_iterator(n) {}
+        const_iterator(const iterator& it) : list_iterator(it) {}
         const_ref operator*()  { return static_cast<data_node*>(node)->data; }
         const_ptr operator->() { return std::addressof(static_cast<data_node*>(node)->data); }
         const_iterator& operator++() { node = node->next; return *this; }
@@ -233,9 +287,31 @@ public:
     template <class Compare>
         void sort(Compare);
     void reverse() noexcept;
+
+/* Helper functions */
+private:
+    template <class Predicate>
+        static iterator gallop(iterator, iterator, Predicate, size_type&);
+    void transfer(const_iterator, list<T, Alloc>&, const_iterator, const_iterator, size_type);
+    template <class Next>
+        iterator insert_block(const_iterator, size_type, Next);
+    block_set& blocks() const;
+    block_entry* entry_of(const Node*) const;
+    void delete_node(Node*, block_entry*);
+    void reserve_blocks(size_type);
+    block_entry& add_block(block_header*, size_type);
+    void drop_block(block_header*, size_type);
+    void take_blocks(list<T, Alloc>&);
+    void move_blocks(list<T, Alloc>&, Node*, Node*);
+    static void release(block_header*);
+    size_type owned() const;
     
 };
 
+template <class T, class Alloc>
+constexpr typename list<T, Alloc>::size_type list<T, Alloc>::header_slots;
+
+
 
 
 // Node
@@ -280,7 +356,7 @@ template <class T, class Alloc>
 list<T, Alloc>::data_node::data_node(rvalue_ref element, Node* next_node)
     : data(std::move(element))
 {
-    insert_before(next_node);
+    this->insert_before(next_node);
 }
 
 
@@ -365,7 +441,8 @@ list<T, Alloc>::Node::move_before(Node* next_node)
  Return value: Node*
  
  Description:
-    Creates an empty node to act as a sentinel in a list.
+    Creates an empty node to act as a sentinel in a list, along with
+    the list's empty set of blocks.
  
  Complexity: Constant.
  */
@@ -373,7 +450,7 @@ template <class T, class Alloc>
 typename list<T, Alloc>::Node*
 list<T, Alloc>::Node::create_dummy()
 {
-    typename Alloc::template rebind<Node>::other alloc;
+    typename Alloc::template rebind<root_node>::other alloc;
     auto node = alloc.allocate(1);
     alloc.construct(node);
     
@@ -419,23 +496,25 @@ list<T, Alloc>::Node::create_node(rvalue_ref element, Node* next_node)
 
 
 /*
- Function: delete_node
+ Function: delete_dummy
  Parameters:
-  - node: The node to be deleted.
+  - node: The sentinel node to be deleted.
  Return value: None
  
  Description:
-    Deletes a given node.
+    Frees a node created by create_dummy.
  
  Complexity: Constant.
  */
 template <class T, class Alloc>
 void
-list<T, Alloc>::Node::delete_node(Node* node)
+list<T, Alloc>::Node::delete_dummy(Node* node)
 {
-    typename Alloc::template rebind<Node>::other alloc;
-    alloc.destroy(node);
-    alloc.deallocate(node, 1);
+    typename Alloc::template rebind<root_node>::other alloc;
+    auto root = static_cast<root_node*>(node);
+    assert(root->blocks.empty());
+    alloc.destroy(root);
+    alloc.deallocate(root, 1);
 }
 
 
@@ -468,6 +547,7 @@ list<T, Alloc>::Node::delete_node(Node* node)
   4. Linear in size of rhs.
   5. Constant.
   6. Linear in the size of il.
+    2, 3, 4 and 6 allocate their nodes as a single block.
  */
 
 // 1. default
@@ -505,7 +585,7 @@ template <class T, class Alloc>
 list<T, Alloc>::list(list<T, Alloc>&& rhs)
     : _dummy(Node::create_dummy())
 {
-    splice(end(), std::move(rhs));
+    swap(rhs);
 }
 
 // 6. initializer list
@@ -529,7 +609,7 @@ template <class T, class Alloc>
 list<T, Alloc>::~list()
 {
     clear();
-    Node::delete_node(_dummy);
+    Node::delete_dummy(_dummy);
 }
 
 
@@ -571,7 +651,7 @@ list<T, Alloc>&
 list<T, Alloc>::operator=(list<T, Alloc>&& rhs)
 {
     clear();
-    splice(begin(), rhs);
+    swap(rhs);
     
     return *this;
 }
@@ -763,6 +843,8 @@ list<T, Alloc>::last() const
  Parameters:
   - index: The position within the list to access.
  Return value: A reference to the index-th position in the list.
+
+ Complexity: Linear in index; indexable_list does this in O(log n).
  */
 template <class T, class Alloc>
 T&
@@ -774,7 +856,7 @@ list<T, Alloc>::at(size_type index) const
     while (index-- > 0)
         node = node->next;
     
-    return node->data;
+    return static_cast<data_node*>(node)->data;
 }
 
 
@@ -811,7 +893,9 @@ list<T, Alloc>::operator[](size_type index) const
     3. an initializer list of new elements.
  
  Complexity: Linear in the current size of the list
-             and the number of elements replacing them.
+             and the number of elements replacing them. The new
+             elements are allocated as one block, and the old ones
+             are cleared as by clear().
  */
 
 // 1. assign range
@@ -932,7 +1016,8 @@ template <class... Args>
 typename list<T, Alloc>::iterator
 list<T, Alloc>::emplace(const_iterator pos, Args&&... args)
 {
-    Node* n = Node::create_node(T(std::forward<Args>(args)...), pos().node);
+    Node* n = Node::create_node(T(std::forward<Args>(args)...), pos.node);
+    ++_size;
     
     return iterator(n);
 }
@@ -984,7 +1069,8 @@ list<T, Alloc>::pop_back()
   - first: The first element in the range of elements to be copied.
   - last: One element past the last to be inserted.
   - il: An initializer list of new values to be added to the list.
- Return value: An iterator pointing to the newly inserted element.
+ Return value: An iterator pointing to the (first) newly inserted
+               element, or pos if there were none.
  
  Description:
   1. Adds an element into the list before pos.
@@ -994,6 +1080,8 @@ list<T, Alloc>::pop_back()
   4. Adds an element into the list before pos.
   5. Adds all the items in an initializer list to the list at a given
      position.
+    2, 3 and 5 allocate all their nodes as one block and link them in
+    a single pass.
  
  Complexity: Linear in the number of elements being inserted.
  */
@@ -1005,9 +1093,6 @@ list<T, Alloc>::insert(const_iterator pos, const_ref element)
 {
     auto node = Node::create_node(element, pos.node);
     
-    node->prev->next = node;
-    node->next->prev = node;
-    
     ++_size;
     
     return iterator(node);
@@ -1018,10 +1103,7 @@ template <class T, class Alloc>
 typename list<T, Alloc>::iterator
 list<T, Alloc>::insert(const_iterator pos, size_type n, const_ref element)
 {
-    while (--n > 0)
-        insert(pos, element);
-    
-    return insert(pos, element);
+    return insert_block(pos, n, [&]() -> const_ref { return element; });
 }
 
 // 3. range
@@ -1029,10 +1111,7 @@ template <class T, class Alloc>
 typename list<T, Alloc>::iterator
 list<T, Alloc>::insert(const_iterator pos, iterator first, iterator last)
 {
-    while (first != last)
-        insert(pos, *first++);
-    
-    return iterator(pos.node);
+    return insert_block(pos, std::distance(first, last), [&]() -> const_ref { return *first++; });
 }
 
 // 4. move
@@ -1040,7 +1119,11 @@ template <class T, class Alloc>
 typename list<T, Alloc>::iterator
 list<T, Alloc>::insert(const_iterator pos, rvalue_ref element)
 {
-    return insert(pos, element);
+    auto node = Node::create_node(std::move(element), pos.node);
+    
+    ++_size;
+    
+    return iterator(node);
 }
 
 // 5. initializer list
@@ -1048,10 +1131,8 @@ template <class T, class Alloc>
 typename list<T, Alloc>::iterator
 list<T, Alloc>::insert(const_iterator pos, std::initializer_list<T> il)
 {
-    for (auto it : il)
-        insert(pos, it);
-    
-    return iterator(pos.node->prev);
+    auto it = il.begin();
+    return insert_block(pos, il.size(), [&]() -> const_ref { return *it++; });
 }
 
 
@@ -1076,15 +1157,16 @@ typename list<T, Alloc>::iterator
 list<T, Alloc>::erase(const_iterator pos)
 {
     auto node = pos.node;
+    auto next = node->next;
     
-    node->prev->next = node->next;
-    node->next->prev = node->prev;
+    node->prev->next = next;
+    next->prev = node->prev;
     
-    Node::delete_node(node);
+    delete_node(node, entry_of(node));
     
     --_size;
     
-    return iterator(pos.node->next);
+    return iterator(next);
 }
 
 template <class T, class Alloc>
@@ -1124,15 +1206,31 @@ list<T, Alloc>::swap(list<T, Alloc>& rhs)
  Return value: None
  
  Description:
-    Removes all elements in the list.
+    Removes all elements in the list. If every node is in the list's
+    blocks and needs no destructor, the blocks are released whole, to be
+    freed once no other list holds nodes of them. Otherwise the nodes are
+    erased one by one.
  
- Complexity: Linear in the size of the list.
+ Complexity: Linear in the number of blocks in the first case, and in
+             the size of the list otherwise.
  */
 template <class T, class Alloc>
-inline void
+void
 list<T, Alloc>::clear() noexcept
 {
+    auto& set = blocks();
+    
+    if (std::is_trivially_destructible<T>::value && owned() == _size) {
+        for (auto& entry : set)
+            release(entry.block);
+        set.clear();
+        _dummy->prev = _dummy->next = _dummy;
+        _size = 0;
+        return;
+    }
+    
     erase(cbegin(), cend());
+    assert(set.empty());
 }
 
 
@@ -1152,8 +1250,12 @@ list<T, Alloc>::clear() noexcept
   1. Moves the entirety of another list into this list behind pos.
   2. Moves a particular element from x into this list behind pos.
   3. Moves a range of elements from x into this list behind pos.
+    The moved nodes' blocks move with them (see transfer).
  
- Complexity: Linear in the number of elements being spliced in.
+ Complexity: 1 is constant into an empty list and otherwise linear in
+             the number of blocks of both lists. 2 is constant, or
+             logarithmic in the number of blocks if the node is in one.
+             3 is linear in the number of elements being spliced in.
  */
 
 // 1. entire list
@@ -1161,20 +1263,10 @@ template <class T, class Alloc>
 void
 list<T, Alloc>::splice(const_iterator pos, list<T, Alloc>& x)
 {
-    assert(!x.empty());
-    
-    _size += x._size;
-    x._size = 0;
-    
-    auto first = x.begin();
-    auto last = x.end();
-    
-    pos.node->prev->next = first.node;
-    last.node->prev->next = pos.node;
-    first.node->prev->next = last.node;
-    (last--).node->prev = first.node->prev;
-    first.node->prev = pos.node->prev;
-    pos.node->prev = last.node;
+    if (empty() && this != &x)
+        swap(x);
+    else
+        transfer(pos, x, x.cbegin(), x.cend(), x._size);
 }
 
 // 1. entire list
@@ -1182,20 +1274,7 @@ template <class T, class Alloc>
 void
 list<T, Alloc>::splice(const_iterator pos, list<T, Alloc>&& x)
 {
-    assert(!x.empty());
-    
-    _size += x._size;
-    x._size = 0;
-    
-    auto first = x.begin();
-    auto last = x.end();
-    
-    pos.node->prev->next = first.node;
-    last.node->prev->next = pos.node;
-    first.node->prev->next = last.node;
-    (last--).node->prev = first.node->prev;
-    first.node->prev = pos.node->prev;
-    pos.node->prev = last.node;
+    splice(pos, x);
 }
 
 // 2. single element
@@ -1221,14 +1300,10 @@ list<T, Alloc>::splice(const_iterator pos, list<T, Alloc>& x, const_iterator fir
 {
     assert(first != last);
     
-    for (auto it = first; it != last; ++it, ++_size, --x._size);
+    size_type n = 0;
+    for (auto it = first; it != last; ++it, ++n);
     
-    pos.node->prev->next = first.node;
-    last.node->prev->next = pos.node;
-    first.node->prev->next = last.node;
-    (last--).node->prev = first.node->prev;
-    first.node->prev = pos.node->prev;
-    pos.node->prev = last.node;
+    transfer(pos, x, first, last, n);
 }
 
 // 3. element range
@@ -1236,16 +1311,7 @@ template <class T, class Alloc>
 void
 list<T, Alloc>::splice(const_iterator pos, list<T, Alloc>&& x, const_iterator first, const_iterator last)
 {
-    assert(first != last);
-    
-    for (auto it = first; it != last; ++it, ++_size, --x._size);
-    
-    pos.itr->prev->next = first.itr;
-    last.itr->prev->next = pos.itr;
-    first.itr->prev->next = last.itr;
-    (last--).itr->prev = first.itr->prev;
-    first.itr->prev = pos.itr->prev;
-    pos.itr->prev = last.itr;
+    splice(pos, x, first, last);
 }
 
 
@@ -1341,8 +1407,14 @@ list<T, Alloc>::unique(BinaryPredicate predicate)
  Description:
     Combines this sorted list with another sorted list leaving the 
     other list empty after moving all its elements into this list.
+    Equal elements from this list stay in front of those from other.
+    Elements of other that go between the same two elements of this
+    list are moved as one run, and both lists are searched for the end
+    of the current run by galloping.
  
- Complexity: Linear in the combined size of both lists.
+ Complexity: Linear in the combined size of both lists. A run of k
+             elements takes O(log k) comparisons, so lists that
+             interleave in few runs need far fewer than n comparisons.
  
  Notes:
   - Functions like insert are not used here since it would
@@ -1354,8 +1426,8 @@ template <class T, class Alloc>
 void
 list<T, Alloc>::merge(list<T, Alloc>& other)
 {
-    merge(other, [](iterator other_el, iterator this_el) { // TODO: rename these variables
-        return *other_el < *this_el;
+    merge(other, [](iterator other_it, iterator this_it) {
+        return *other_it < *this_it;
     });
 }
 
@@ -1363,8 +1435,8 @@ template <class T, class Alloc>
 void
 list<T, Alloc>::merge(list<T, Alloc>&& other)
 {
-    merge(std::move(other), [](iterator other_el, iterator this_el) { // TODO: rename these variables
-        return *other_el < *this_el;
+    merge(other, [](iterator other_it, iterator this_it) {
+        return *other_it < *this_it;
     });
 }
 
@@ -1373,22 +1445,28 @@ template <class Compare>
 void
 list<T, Alloc>::merge(list<T, Alloc>& other, Compare compare)
 {
+    if (this == &other)
+        return;
+    
+    auto itr = begin();
     auto o_itr = other.begin();
+    size_type run;
     
-    // Iterate over this list inserting other elements on successful compare.
-    for (auto itr = begin(); itr != end() && o_itr != other.end();) {
-        for (; !compare(o_itr, itr) && itr != end(); ++itr);
+    while (o_itr != other.end()) {
+        // Skip the elements of this list that o_itr does not go before.
+        itr = gallop(itr, end(), [&](iterator it) { return !compare(o_itr, it); }, run);
         
-        if (itr != end()) {
-            (o_itr++).node->move_before(itr.node);
-            ++_size;
-            --other._size;
+        // If nothing here is greater, the rest of other goes at the end.
+        if (itr == end()) {
+            transfer(cend(), other, o_itr, other.cend(), other._size);
+            return;
         }
+        
+        // Otherwise move the run of other that goes before itr.
+        auto o_last = gallop(o_itr.next(), other.end(), [&](iterator it) { return compare(it, itr); }, run);
+        transfer(itr, other, o_itr, o_last, run + 1);
+        o_itr = o_last;
     }
-    
-    // If any elements remain in the other list, splice them into the end of this one.
-    if (o_itr != other.end())
-        splice(cend(), other);
 }
 
 template <class T, class Alloc>
@@ -1396,7 +1474,7 @@ template <class Compare>
 void
 list<T, Alloc>::merge(list<T, Alloc>&& other, Compare compare)
 {
-    merge(other, compare); // TODO: Find out what should really be done here.
+    merge(other, compare);
 }
 
 
@@ -1462,6 +1540,2451 @@ list<T, Alloc>::reverse() noexcept
 }
 
 
+
+// Helper functions
+
+/*
+ Function: gallop
+ Parameters:
+  - first, last: A range in which the elements satisfying pred all come
+                 before those that do not.
+  - pred: Tested on iterators into the range.
+  - count: Set to the number of elements that satisfy pred.
+ Return value: An iterator to the first element that does not satisfy
+               pred, or last.
+ 
+ Description:
+    Probes 1, 2, 4, ... elements ahead until one fails, then bisects the
+    last gap.
+ 
+ Complexity: O(log k) calls to pred for k elements that satisfy it. The
+             nodes are still walked, O(k).
+ */
+template <class T, class Alloc>
+template <class Predicate>
+typename list<T, Alloc>::iterator
+list<T, Alloc>::gallop(iterator first, iterator last, Predicate pred, size_type& count)
+{
+    count = 0;
+    if (first == last || !pred(first))
+        return first;
+    
+    // first satisfies pred from here on.
+    for (size_type step = 1;; step *= 2) {
+        auto probe = first;
+        size_type gap = 0;
+        for (; gap < step && probe != last; ++gap)
+            ++probe;
+        
+        if (probe != last && pred(probe)) {
+            first = probe;
+            count += gap;
+            continue;
+        }
+        
+        // The first failure is in (first, probe].
+        while (gap > 1) {
+            auto half = gap / 2;
+            auto mid = first;
+            for (size_type i = 0; i < half; ++i)
+                ++mid;
+            
+            if (pred(mid)) {
+                first = mid;
+                count += half;
+                gap -= half;
+            } else {
+                gap = half;
+            }
+        }
+        ++count;
+        return first.next();
+    }
+}
+
+
+/*
+ Function: transfer
+ Parameters:
+  - pos: The element to move the range in front of.
+  - x: The list the range is in.
+  - first, last: The range, holding n elements.
+ 
+ Description:
+    Relinks the range in front of pos and moves n from x's size to this
+    list's. A range already in front of pos stays put. Between lists the
+    block counts move first: all of x's for the whole of x, or those of
+    the nodes in the range otherwise. Should that throw, nothing has
+    changed.
+ 
+ Complexity: Constant for lists without blocks. Otherwise linear in the
+             number of blocks of both lists for the whole of x, and in n
+             times the logarithm of the number of blocks for a range.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc>::transfer(const_iterator pos, list<T, Alloc>& x, const_iterator first, const_iterator last, size_type n)
+{
+    if (first == last || pos == last)
+        return;
+    
+    if (this != &x) {
+        if (n == x._size)
+            take_blocks(x);
+        else
+            move_blocks(x, first.node, last.node);
+        _size += n;
+        x._size -= n;
+    }
+    
+    pos.node->prev->next = first.node;
+    last.node->prev->next = pos.node;
+    first.node->prev->next = last.node;
+    (last--).node->prev = first.node->prev;
+    first.node->prev = pos.node->prev;
+    pos.node->prev = last.node;
+}
+
+
+/*
+ Function: insert_block
+ Parameters:
+  - pos: The element to insert in front of.
+  - n: The number of elements.
+  - next: Called n times for the elements, in order.
+ Return value: An iterator to the first new element, or pos if n is 0.
+ 
+ Description:
+    Allocates one block for all n nodes, adds it to this list's set, and
+    constructs and links the nodes in order. Should a constructor throw,
+    the nodes made so far stay in the list.
+ 
+ Complexity: Linear in n, with one allocation, plus linear in the number
+             of blocks in the list.
+ */
+template <class T, class Alloc>
+template <class Next>
+typename list<T, Alloc>::iterator
+list<T, Alloc>::insert_block(const_iterator pos, size_type n, Next next)
+{
+    if (n == 0)
+        return iterator(pos.node);
+    
+    node_allocator alloc;
+    auto before = pos.node->prev;
+    reserve_blocks(1);
+    
+    auto base = alloc.allocate(header_slots + n);
+    auto block = ::new (static_cast<void*>(base)) block_header();
+    block->capacity = n;
+    block->refs = 0;
+    auto& entry = add_block(block, 0);
+    
+    auto nodes = base + header_slots;
+    try {
+        for (size_type i = 0; i < n; ++i) {
+            alloc.construct(nodes + i, next(), pos.node);
+            ++entry.count;
+            ++_size;
+        }
+    } catch (...) {
+        if (entry.count == 0)
+            drop_block(block, 0);
+        throw;
+    }
+    
+    return iterator(before->next);
+}
+
+
+/*
+ Function: blocks / entry_of
+ Parameters:
+  - node: A node in this list.
+ Return value: The list's block entries, and the entry of the node's
+               block, or null if it was allocated alone.
+ 
+ Description:
+    A block is its header followed by its nodes, so the node is in the
+    last block of the set starting at or below it, if it is in any.
+ 
+ Complexity: Logarithmic in the number of blocks in the list.
+ */
+template <class T, class Alloc>
+inline typename list<T, Alloc>::block_set&
+list<T, Alloc>::blocks() const
+{
+    return static_cast<root_node*>(_dummy)->blocks;
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc>::block_entry*
+list<T, Alloc>::entry_of(const Node* node) const
+{
+    auto& set = blocks();
+    if (set.empty())
+        return nullptr;
+    
+    std::less<const void*> less;
+    auto data = static_cast<const data_node*>(node);
+    auto it = std::upper_bound(set.begin(), set.end(), data, [&](const data_node* d, const block_entry& e) {
+        return less(d, e.block);
+    });
+    if (it == set.begin())
+        return nullptr;
+    
+    --it;
+    auto nodes = reinterpret_cast<const data_node*>(it->block) + header_slots;
+    return less(data, nodes + it->block->capacity) ? &*it : nullptr;
+}
+
+
+/*
+ Function: delete_node
+ Parameters:
+  - node: A data node unlinked from this list.
+  - entry: The entry of the node's block, or null if it was allocated
+           alone.
+ Return value: None
+ 
+ Description:
+    Destroys the element and frees the node, or, for a node in a block,
+    drops the block from the list once that was the list's last node of
+    it.
+ 
+ Complexity: Constant for a node allocated alone, and linear in the
+             number of blocks in the list when it drops one.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc>::delete_node(Node* node, block_entry* entry)
+{
+    node_allocator alloc;
+    auto data = static_cast<data_node*>(node);
+    alloc.destroy(data);
+    
+    if (!entry) {
+        alloc.deallocate(data, 1);
+    } else if (--entry->count == 0) {
+        auto& set = blocks();
+        auto block = entry->block;
+        set.erase(set.begin() + (entry - set.data()));
+        release(block);
+    }
+}
+
+
+/*
+ Function: reserve_blocks / add_block / drop_block
+ Parameters:
+  - extra: How many entries may be added without allocating.
+  - block: A block.
+  - count: How many of the list's nodes it gains or loses.
+ Return value: add_block returns block's entry.
+ 
+ Description:
+    reserve_blocks grows the set's capacity geometrically, and is the
+    only one of these that can throw. add_block adds count to block's
+    entry, making one and taking a reference to the block if there is
+    none; there must be room for it. drop_block takes count off the
+    entry and, at zero, removes it and releases the block.
+ 
+ Complexity: Logarithmic in the number of blocks in the list, plus
+             linear when an entry is made or removed.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc>::reserve_blocks(size_type extra)
+{
+    auto& set = blocks();
+    if (set.capacity() - set.size() < extra)
+        set.reserve(std::max(set.size() + extra, 2 * set.capacity()));
+}
+
+template <class T, class Alloc>
+typename list<T, Alloc>::block_entry&
+list<T, Alloc>::add_block(block_header* block, size_type count)
+{
+    auto& set = blocks();
+    auto it = std::lower_bound(set.begin(), set.end(), block, [](const block_entry& e, const block_header* b) {
+        return std::less<const block_header*>()(e.block, b);
+    });
+    
+    if (it != set.end() && it->block == block) {
+        it->count += count;
+        return *it;
+    }
+    
+    assert(set.size() < set.capacity());
+    ++block->refs;
+    return *set.insert(it, block_entry{block, count});
+}
+
+template <class T, class Alloc>
+void
+list<T, Alloc>::drop_block(block_header* block, size_type count)
+{
+    auto& set = blocks();
+    auto it = std::lower_bound(set.begin(), set.end(), block, [](const block_entry& e, const block_header* b) {
+        return std::less<const block_header*>()(e.block, b);
+    });
+    assert(it != set.end() && it->block == block && it->count >= count);
+    
+    if ((it->count -= count) == 0) {
+        set.erase(it);
+        release(block);
+    }
+}
+
+
+/*
+ Function: take_blocks / move_blocks
+ Parameters:
+  - x: Another list giving up nodes to this one.
+  - first, last: The range of x's nodes being moved.
+ Return value: None
+ 
+ Description:
+    take_blocks moves all of x's entries into this list, for a splice of
+    the whole of x, merging entries for blocks both lists hold.
+    move_blocks walks the range and moves each run of nodes from one
+    block with one add_block and one drop_block. Both allocate, if at
+    all, before changing anything.
+ 
+ Complexity: take_blocks is constant if this list has no blocks and
+             otherwise linear in the number of blocks of both lists.
+             move_blocks is linear in the length of the range times the
+             logarithm of the number of blocks.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc>::take_blocks(list<T, Alloc>& x)
+{
+    auto& from = x.blocks();
+    auto& set = blocks();
+    if (from.empty())
+        return;
+    if (set.empty()) {
+        set.swap(from);
+        return;
+    }
+    
+    block_set merged;
+    merged.reserve(set.size() + from.size());
+    
+    std::less<const block_header*> less;
+    auto a = set.begin(), b = from.begin();
+    while (a != set.end() || b != from.end()) {
+        if (b == from.end() || (a != set.end() && less(a->block, b->block))) {
+            merged.push_back(*a++);
+        } else if (a == set.end() || less(b->block, a->block)) {
+            merged.push_back(*b++);
+        } else {
+            merged.push_back(block_entry{a->block, a->count + b->count});
+            release(b->block);        // x's reference; this list keeps its own.
+            ++a;
+            ++b;
+        }
+    }
+    
+    set.swap(merged);
+    from.clear();
+}
+
+template <class T, class Alloc>
+void
+list<T, Alloc>::move_blocks(list<T, Alloc>& x, Node* first, Node* last)
+{
+    if (x.blocks().empty())
+        return;
+    
+    size_type n = 0;
+    for (auto node = first; node != last && n < x.blocks().size(); node = node->next, ++n);
+    reserve_blocks(n);
+    
+    block_header* block = nullptr;
+    size_type run = 0;
+    auto shift = [&] {
+        if (block) {
+            add_block(block, run);
+            x.drop_block(block, run);
+        }
+    };
+    
+    for (auto node = first; node != last; node = node->next) {
+        auto entry = x.entry_of(node);
+        auto from = entry ? entry->block : nullptr;
+        if (from != block) {
+            shift();
+            block = from;
+            run = 0;
+        }
+        ++run;
+    }
+    shift();
+}
+
+
+/*
+ Function: release
+ Parameters:
+  - block: A block leaving a list's set.
+ Return value: None
+ 
+ Description:
+    Drops a reference to the block and frees it at the last.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc>::release(block_header* block)
+{
+    if (--block->refs > 0)
+        return;
+    
+    node_allocator alloc;
+    auto slots = header_slots + block->capacity;
+    block->~block_header();
+    alloc.deallocate(reinterpret_cast<data_node*>(block), slots);
+}
+
+
+/*
+ Function: owned
+ Parameters: None
+ Return value: How many of the list's nodes are in its blocks.
+ 
+ Complexity: Linear in the number of blocks in the list.
+ */
+template <class T, class Alloc>
+typename list<T, Alloc>::size_type
+list<T, Alloc>::owned() const
+{
+    size_type count = 0;
+    for (auto& entry : blocks())
+        count += entry.count;
+    return count;
+}
+
+
+/*
+ Class: list<T, Alloc, singly_linked>
+ 
+ Description:
+    A forward list: each node links only to the next, saving a pointer
+    per node. The list keeps its last node, so it pushes at both ends and
+    pops at the front, which is all a queue needs. Changes go after a
+    position, as positions cannot reach back.
+ */
+template <class T, class Alloc>
+class list<T, Alloc, singly_linked> {
+    
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+    
+    
+/* Node definition */
+private:
+    struct Node {
+        Node* next = nullptr;
+    };
+    
+    struct data_node : Node {
+        T data;
+        
+        template <class... Args>
+        explicit data_node(Args&&... args) : data(std::forward<Args>(args)...) {}
+    };
+    
+    typedef typename Alloc::template rebind<data_node>::other node_allocator;
+    
+    
+/* Iterators */
+public:
+    class const_iterator;
+    
+    class iterator : public std::iterator< std::forward_iterator_tag, value_type > {
+        
+        friend class list<T, Alloc, singly_linked>;
+        friend class const_iterator;
+        
+    /* Iterator data members */
+    private:
+        Node* node;
+        
+    /* Iterator member functions */
+    public:
+        iterator(Node* n = nullptr) : node(n) {}
+        reference operator*() const { return static_cast<data_node*>(node)->data; }
+        pointer operator->() const { return std::addressof(static_cast<data_node*>(node)->data); }
+        iterator& operator++() { node = node->next; return *this; }
+        iterator operator++(int) { iterator temp(*this); node = node->next; return temp; }
+        iterator next() const { return iterator(node->next); }
+        bool operator==(const iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const iterator& rhs) const { return node != rhs.node; }
+    };
+    
+    class const_iterator : public std::iterator< std::forward_iterator_tag, const value_type > {
+        
+        friend class list<T, Alloc, singly_linked>;
+        
+    /* Iterator data members */
+    private:
+        Node* node;
+        
+    /* Iterator member functions */
+    public:
+        const_iterator(Node* n = nullptr) : node(n) {}
+        const_iterator(const iterator& it) : node(it.node) {}
+        const_ref operator*() const { return static_cast<data_node*>(node)->data; }
+        const_ptr operator->() const { return std::addressof(static_cast<data_node*>(node)->data); }
+        const_iterator& operator++() { node = node->next; return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); node = node->next; return temp; }
+        const_iterator next() const { return const_iterator(node->next); }
+        bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
+    };
+    
+    
+/* Data members */
+private:
+    Node _head;            // Before the first element; the last links to null.
+    Node* _tail;           // The last node, or &_head when empty.
+    size_type _size = 0;
+    
+    
+/* Member functions */
+public:
+    /* Constructors */
+    list();
+    list(size_type, const_ref);
+    list(const list<T, Alloc, singly_linked>&);
+    list(list<T, Alloc, singly_linked>&&);
+    list(std::initializer_list<T>);
+    ~list();
+    
+    /* Assignment */
+    list<T, Alloc, singly_linked>& operator=(list<T, Alloc, singly_linked>);
+    list<T, Alloc, singly_linked>& operator=(std::initializer_list<T>);
+    
+    /* Iterators */
+    iterator before_begin();
+    iterator begin();
+    iterator end();
+    const_iterator cbefore_begin() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    
+    /* Element access */
+    reference front();
+    reference last();
+    
+    /* Modifiers */
+    void push_front(const_ref);
+    void push_front(rvalue_ref);
+    void push_back(const_ref);
+    void push_back(rvalue_ref);
+    template <class... Args>
+        void emplace_front(Args&&...);
+    template <class... Args>
+        void emplace_back(Args&&...);
+    template <class... Args>
+        iterator emplace_after(const_iterator, Args&&...);
+    void pop_front();
+    iterator insert_after(const_iterator, const_ref);
+    iterator insert_after(const_iterator, rvalue_ref);
+    iterator erase_after(const_iterator);
+    void swap(list<T, Alloc, singly_linked>&);
+    void clear() noexcept;
+    
+    /* Operations */
+    void splice_after(const_iterator, list<T, Alloc, singly_linked>&);
+    template <class Predicate>
+        void remove_if(Predicate);
+    void reverse() noexcept;
+    
+/* Helper functions */
+private:
+    void adopt(list<T, Alloc, singly_linked>&);
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - n: The number of times to insert 'element'.
+  - element: The element to be inserted.
+  - rhs: The list which is being either copied or moved from.
+  - il: Initializer list of elements.
+ Return value: None
+ 
+ Description:
+    Makes a(n)...
+  1. empty list.
+  2. list with n instances of 'element'.
+  3. copy of rhs.
+  4. list that takes over rhs's nodes, leaving rhs empty.
+  5. list with all elements in il, preserving order.
+ 
+ Complexity: Constant for 1 and 4, otherwise linear.
+ */
+
+// 1. default
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>::list()
+    : _tail(&_head)
+{}
+
+// 2. fill
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>::list(size_type n, const_ref element)
+    : list()
+{
+    while (n-- > 0)
+        push_back(element);
+}
+
+// 3. copy
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>::list(const list<T, Alloc, singly_linked>& rhs)
+    : list()
+{
+    for (auto& element : rhs)
+        push_back(element);
+}
+
+// 4. move
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>::list(list<T, Alloc, singly_linked>&& rhs)
+    : list()
+{
+    adopt(rhs);
+}
+
+// 5. initializer list
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>::list(std::initializer_list<T> il)
+    : list()
+{
+    for (auto& element : il)
+        push_back(element);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>::~list()
+{
+    clear();
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: The list to copy or move from.
+  - il: An initializer list of new elements.
+ Return value: A reference to this list.
+ 
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>&
+list<T, Alloc, singly_linked>::operator=(list<T, Alloc, singly_linked> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template <class T, class Alloc>
+list<T, Alloc, singly_linked>&
+list<T, Alloc, singly_linked>::operator=(std::initializer_list<T> il)
+{
+    clear();
+    for (auto& element : il)
+        push_back(element);
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: before_begin / begin / end / cbefore_begin / cbegin / cend
+ Return value: Iterators to the position before the first element, to
+               the first element, and past the last.
+ */
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::iterator
+list<T, Alloc, singly_linked>::before_begin()
+{
+    return iterator(&_head);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::iterator
+list<T, Alloc, singly_linked>::begin()
+{
+    return iterator(_head.next);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::iterator
+list<T, Alloc, singly_linked>::end()
+{
+    return iterator(nullptr);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::const_iterator
+list<T, Alloc, singly_linked>::cbefore_begin() const
+{
+    return const_iterator(const_cast<Node*>(&_head));
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::const_iterator
+list<T, Alloc, singly_linked>::begin() const
+{
+    return cbegin();
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::const_iterator
+list<T, Alloc, singly_linked>::end() const
+{
+    return cend();
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::const_iterator
+list<T, Alloc, singly_linked>::cbegin() const
+{
+    return const_iterator(_head.next);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::const_iterator
+list<T, Alloc, singly_linked>::cend() const
+{
+    return const_iterator(nullptr);
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: Whether the list is empty, and the number of elements.
+ */
+template <class T, class Alloc>
+inline bool
+list<T, Alloc, singly_linked>::empty() const
+{
+    return _size == 0;
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::size_type
+list<T, Alloc, singly_linked>::size() const
+{
+    return _size;
+}
+
+
+
+// Element access
+
+/*
+ Function: front / last
+ Return value: A reference to the first or the last element.
+ */
+template <class T, class Alloc>
+inline T&
+list<T, Alloc, singly_linked>::front()
+{
+    assert(!empty());
+    return static_cast<data_node*>(_head.next)->data;
+}
+
+template <class T, class Alloc>
+inline T&
+list<T, Alloc, singly_linked>::last()
+{
+    assert(!empty());
+    return static_cast<data_node*>(_tail)->data;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push_front / push_back / emplace_front / emplace_back
+ Parameters:
+  - element / args: The new element, or its constructor's arguments.
+ Return value: None
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+inline void
+list<T, Alloc, singly_linked>::push_front(const_ref element)
+{
+    emplace_after(cbefore_begin(), element);
+}
+
+template <class T, class Alloc>
+inline void
+list<T, Alloc, singly_linked>::push_front(rvalue_ref element)
+{
+    emplace_after(cbefore_begin(), std::move(element));
+}
+
+template <class T, class Alloc>
+inline void
+list<T, Alloc, singly_linked>::push_back(const_ref element)
+{
+    emplace_after(const_iterator(_tail), element);
+}
+
+template <class T, class Alloc>
+inline void
+list<T, Alloc, singly_linked>::push_back(rvalue_ref element)
+{
+    emplace_after(const_iterator(_tail), std::move(element));
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+list<T, Alloc, singly_linked>::emplace_front(Args&&... args)
+{
+    emplace_after(cbefore_begin(), std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+list<T, Alloc, singly_linked>::emplace_back(Args&&... args)
+{
+    emplace_after(const_iterator(_tail), std::forward<Args>(args)...);
+}
+
+
+/*
+ Function: emplace_after / insert_after
+ Parameters:
+  - pos: The position to insert after; before_begin() for the front.
+  - args / element: The new element, or its constructor's arguments.
+ Return value: An iterator to the new element.
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+template <class... Args>
+typename list<T, Alloc, singly_linked>::iterator
+list<T, Alloc, singly_linked>::emplace_after(const_iterator pos, Args&&... args)
+{
+    node_allocator alloc;
+    auto node = alloc.allocate(1);
+    try {
+        alloc.construct(node, std::forward<Args>(args)...);
+    } catch (...) {
+        alloc.deallocate(node, 1);
+        throw;
+    }
+    
+    node->next = pos.node->next;
+    pos.node->next = node;
+    if (pos.node == _tail)
+        _tail = node;
+    ++_size;
+    return iterator(node);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::iterator
+list<T, Alloc, singly_linked>::insert_after(const_iterator pos, const_ref element)
+{
+    return emplace_after(pos, element);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, singly_linked>::iterator
+list<T, Alloc, singly_linked>::insert_after(const_iterator pos, rvalue_ref element)
+{
+    return emplace_after(pos, std::move(element));
+}
+
+
+/*
+ Function: pop_front / erase_after
+ Parameters:
+  - pos: The position before the element to remove.
+ Return value: erase_after returns an iterator to the element after the
+               one removed.
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+inline void
+list<T, Alloc, singly_linked>::pop_front()
+{
+    assert(!empty());
+    erase_after(cbefore_begin());
+}
+
+template <class T, class Alloc>
+typename list<T, Alloc, singly_linked>::iterator
+list<T, Alloc, singly_linked>::erase_after(const_iterator pos)
+{
+    auto node = static_cast<data_node*>(pos.node->next);
+    assert(node);
+    
+    pos.node->next = node->next;
+    if (node == _tail)
+        _tail = pos.node;
+    --_size;
+    
+    node_allocator alloc;
+    alloc.destroy(node);
+    alloc.deallocate(node, 1);
+    return iterator(pos.node->next);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - rhs: The other list.
+ Return value: None
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, singly_linked>::swap(list<T, Alloc, singly_linked>& rhs)
+{
+    list<T, Alloc, singly_linked> temp;
+    temp.adopt(rhs);
+    rhs.adopt(*this);
+    adopt(temp);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every element.
+ 
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, singly_linked>::clear() noexcept
+{
+    node_allocator alloc;
+    for (auto node = _head.next; node;) {
+        auto data = static_cast<data_node*>(node);
+        node = node->next;
+        alloc.destroy(data);
+        alloc.deallocate(data, 1);
+    }
+    _head.next = nullptr;
+    _tail = &_head;
+    _size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: splice_after
+ Parameters:
+  - pos: The position to move x's elements after.
+  - x: Another list, left empty.
+ Return value: None
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, singly_linked>::splice_after(const_iterator pos, list<T, Alloc, singly_linked>& x)
+{
+    if (this == &x || x.empty())
+        return;
+    
+    x._tail->next = pos.node->next;
+    pos.node->next = x._head.next;
+    if (pos.node == _tail)
+        _tail = x._tail;
+    _size += x._size;
+    
+    x._head.next = nullptr;
+    x._tail = &x._head;
+    x._size = 0;
+}
+
+
+/*
+ Function: remove_if
+ Parameters:
+  - pred: The predicate used to test all elements in the list.
+ Return value: None
+ 
+ Description:
+    Removes from the list all elements that satisfy a predicate.
+ 
+ Complexity: Linear in the size of the list.
+ */
+template <class T, class Alloc>
+template <class Predicate>
+void
+list<T, Alloc, singly_linked>::remove_if(Predicate pred)
+{
+    for (auto before = cbefore_begin(); before.node->next;) {
+        if (pred(static_cast<data_node*>(before.node->next)->data))
+            erase_after(before);
+        else
+            ++before;
+    }
+}
+
+
+/*
+ Function: reverse
+ Description:
+    Reverses the list by turning every link around.
+ 
+ Complexity: Linear in the size of the list.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, singly_linked>::reverse() noexcept
+{
+    Node* reversed = nullptr;
+    _tail = _head.next ? _head.next : &_head;
+    for (auto node = _head.next; node;) {
+        auto next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+    }
+    _head.next = reversed;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: adopt
+ Parameters:
+  - x: A list whose nodes this empty list takes over, leaving x empty.
+ 
+ Description:
+    Needed because an empty list's tail is its own head, which moving
+    the pointers alone would not carry over.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, singly_linked>::adopt(list<T, Alloc, singly_linked>& x)
+{
+    assert(empty());
+    splice_after(cbefore_begin(), x);
+}
+
+
+/*
+ Class: list<T, Alloc, xor_linked>
+ 
+ Description:
+    A bidirectional list in which each node stores the exclusive or of
+    its neighbours' addresses, so one field serves for both directions.
+    An iterator carries the node before its own to decode the next one.
+    Inserting or erasing at a position therefore invalidates iterators to
+    the elements on either side, as well as to an erased element; all
+    other iterators stay valid. Reversing takes constant time.
+ */
+template <class T, class Alloc>
+class list<T, Alloc, xor_linked> {
+    
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+    
+    
+/* Node definition */
+private:
+    struct Node {
+        std::uintptr_t link = 0;   // Address of prev ^ address of next.
+    };
+    
+    struct data_node : Node {
+        T data;
+        
+        template <class... Args>
+        explicit data_node(Args&&... args) : data(std::forward<Args>(args)...) {}
+    };
+    
+    typedef typename Alloc::template rebind<data_node>::other node_allocator;
+    
+    // The neighbour of node on the other side from 'from'.
+    static Node* across(const Node* node, const Node* from)
+    {
+        return reinterpret_cast<Node*>(node->link ^ reinterpret_cast<std::uintptr_t>(from));
+    }
+    
+    // Replaces neighbour 'was' of node with 'now'.
+    static void relink(Node* node, const Node* was, const Node* now)
+    {
+        node->link ^= reinterpret_cast<std::uintptr_t>(was) ^ reinterpret_cast<std::uintptr_t>(now);
+    }
+    
+    
+/* Iterators */
+public:
+    class const_iterator;
+    
+    class iterator : public std::iterator< std::bidirectional_iterator_tag, value_type > {
+        
+        friend class list<T, Alloc, xor_linked>;
+        friend class const_iterator;
+        
+    /* Iterator data members */
+    private:
+        Node* prev;
+        Node* node;
+        
+    /* Iterator member functions */
+    public:
+        iterator(Node* p = nullptr, Node* n = nullptr) : prev(p), node(n) {}
+        reference operator*() const { return static_cast<data_node*>(node)->data; }
+        pointer operator->() const { return std::addressof(static_cast<data_node*>(node)->data); }
+        iterator& operator++() { auto next = across(node, prev); prev = node; node = next; return *this; }
+        iterator operator++(int) { iterator temp(*this); ++*this; return temp; }
+        iterator& operator--() { auto before = across(prev, node); node = prev; prev = before; return *this; }
+        iterator operator--(int) { iterator temp(*this); --*this; return temp; }
+        bool operator==(const iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const iterator& rhs) const { return node != rhs.node; }
+    };
+    
+    class const_iterator : public std::iterator< std::bidirectional_iterator_tag, const value_type > {
+        
+        friend class list<T, Alloc, xor_linked>;
+        
+    /* Iterator data members */
+    private:
+        Node* prev;
+        Node* node;
+        
+    /* Iterator member functions */
+    public:
+        const_iterator(Node* p = nullptr, Node* n = nullptr) : prev(p), node(n) {}
+        const_iterator(const iterator& it) : prev(it.prev), node(it.node) {}
+        const_ref operator*() const { return static_cast<data_node*>(node)->data; }
+        const_ptr operator->() const { return std::addressof(static_cast<data_node*>(node)->data); }
+        const_iterator& operator++() { auto next = across(node, prev); prev = node; node = next; return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); ++*this; return temp; }
+        const_iterator& operator--() { auto before = across(prev, node); node = prev; prev = before; return *this; }
+        const_iterator operator--(int) { const_iterator temp(*this); --*this; return temp; }
+        bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
+    };
+    
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    
+    
+/* Data members */
+private:
+    Node* _dummy;          // Between the last element and the first.
+    Node* _back;           // The last node, or _dummy when empty.
+    size_type _size = 0;
+    
+    
+/* Member functions */
+public:
+    /* Constructors */
+    list();
+    list(size_type, const_ref);
+    list(const list<T, Alloc, xor_linked>&);
+    list(list<T, Alloc, xor_linked>&&);
+    list(std::initializer_list<T>);
+    ~list();
+    
+    /* Assignment */
+    list<T, Alloc, xor_linked>& operator=(list<T, Alloc, xor_linked>);
+    list<T, Alloc, xor_linked>& operator=(std::initializer_list<T>);
+    
+    /* Iterators */
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin();
+    reverse_iterator rend();
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+    
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    
+    /* Element access */
+    reference front();
+    reference last();
+    
+    /* Modifiers */
+    void push_front(const_ref);
+    void push_front(rvalue_ref);
+    void push_back(const_ref);
+    void push_back(rvalue_ref);
+    template <class... Args>
+        void emplace_front(Args&&...);
+    template <class... Args>
+        void emplace_back(Args&&...);
+    template <class... Args>
+        iterator emplace(const_iterator, Args&&...);
+    void pop_front();
+    void pop_back();
+    iterator insert(const_iterator, const_ref);
+    iterator insert(const_iterator, rvalue_ref);
+    iterator erase(const_iterator);
+    void swap(list<T, Alloc, xor_linked>&);
+    void clear() noexcept;
+    
+    /* Operations */
+    template <class Predicate>
+        void remove_if(Predicate);
+    void reverse() noexcept;
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - n: The number of times to insert 'element'.
+  - element: The element to be inserted.
+  - rhs: The list which is being either copied or moved from.
+  - il: Initializer list of elements.
+ Return value: None
+ 
+ Description:
+    Makes a(n)...
+  1. empty list.
+  2. list with n instances of 'element'.
+  3. copy of rhs.
+  4. list that takes over rhs's nodes, leaving rhs empty.
+  5. list with all elements in il, preserving order.
+ 
+ Complexity: Constant for 1 and 4, otherwise linear.
+ */
+
+// 1. default
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>::list()
+{
+    typename Alloc::template rebind<Node>::other alloc;
+    _dummy = _back = alloc.allocate(1);
+    alloc.construct(_dummy);
+}
+
+// 2. fill
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>::list(size_type n, const_ref element)
+    : list()
+{
+    while (n-- > 0)
+        push_back(element);
+}
+
+// 3. copy
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>::list(const list<T, Alloc, xor_linked>& rhs)
+    : list()
+{
+    for (auto& element : rhs)
+        push_back(element);
+}
+
+// 4. move
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>::list(list<T, Alloc, xor_linked>&& rhs)
+    : list()
+{
+    swap(rhs);
+}
+
+// 5. initializer list
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>::list(std::initializer_list<T> il)
+    : list()
+{
+    for (auto& element : il)
+        push_back(element);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>::~list()
+{
+    clear();
+    typename Alloc::template rebind<Node>::other alloc;
+    alloc.destroy(_dummy);
+    alloc.deallocate(_dummy, 1);
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: The list to copy or move from.
+  - il: An initializer list of new elements.
+ Return value: A reference to this list.
+ 
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>&
+list<T, Alloc, xor_linked>::operator=(list<T, Alloc, xor_linked> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template <class T, class Alloc>
+list<T, Alloc, xor_linked>&
+list<T, Alloc, xor_linked>::operator=(std::initializer_list<T> il)
+{
+    clear();
+    for (auto& element : il)
+        push_back(element);
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end / cbegin / cend / rbegin / rend / crbegin / crend
+ Return value: Iterators to the first element and past the last, and
+               their const and reverse versions.
+ */
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::iterator
+list<T, Alloc, xor_linked>::begin()
+{
+    return iterator(_dummy, across(_dummy, _back));
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::iterator
+list<T, Alloc, xor_linked>::end()
+{
+    return iterator(_back, _dummy);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::const_iterator
+list<T, Alloc, xor_linked>::begin() const
+{
+    return cbegin();
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::const_iterator
+list<T, Alloc, xor_linked>::end() const
+{
+    return cend();
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::const_iterator
+list<T, Alloc, xor_linked>::cbegin() const
+{
+    return const_iterator(_dummy, across(_dummy, _back));
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::const_iterator
+list<T, Alloc, xor_linked>::cend() const
+{
+    return const_iterator(_back, _dummy);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::reverse_iterator
+list<T, Alloc, xor_linked>::rbegin()
+{
+    return reverse_iterator(end());
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::reverse_iterator
+list<T, Alloc, xor_linked>::rend()
+{
+    return reverse_iterator(begin());
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::const_reverse_iterator
+list<T, Alloc, xor_linked>::crbegin() const
+{
+    return const_reverse_iterator(cend());
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::const_reverse_iterator
+list<T, Alloc, xor_linked>::crend() const
+{
+    return const_reverse_iterator(cbegin());
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: Whether the list is empty, and the number of elements.
+ */
+template <class T, class Alloc>
+inline bool
+list<T, Alloc, xor_linked>::empty() const
+{
+    return _size == 0;
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::size_type
+list<T, Alloc, xor_linked>::size() const
+{
+    return _size;
+}
+
+
+
+// Element access
+
+/*
+ Function: front / last
+ Return value: A reference to the first or the last element.
+ */
+template <class T, class Alloc>
+inline T&
+list<T, Alloc, xor_linked>::front()
+{
+    assert(!empty());
+    return static_cast<data_node*>(across(_dummy, _back))->data;
+}
+
+template <class T, class Alloc>
+inline T&
+list<T, Alloc, xor_linked>::last()
+{
+    assert(!empty());
+    return static_cast<data_node*>(_back)->data;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push_front / push_back / emplace_front / emplace_back
+ Parameters:
+  - element / args: The new element, or its constructor's arguments.
+ Return value: None
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+inline void
+list<T, Alloc, xor_linked>::push_front(const_ref element)
+{
+    emplace(cbegin(), element);
+}
+
+template <class T, class Alloc>
+inline void
+list<T, Alloc, xor_linked>::push_front(rvalue_ref element)
+{
+    emplace(cbegin(), std::move(element));
+}
+
+template <class T, class Alloc>
+inline void
+list<T, Alloc, xor_linked>::push_back(const_ref element)
+{
+    emplace(cend(), element);
+}
+
+template <class T, class Alloc>
+inline void
+list<T, Alloc, xor_linked>::push_back(rvalue_ref element)
+{
+    emplace(cend(), std::move(element));
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+list<T, Alloc, xor_linked>::emplace_front(Args&&... args)
+{
+    emplace(cbegin(), std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+list<T, Alloc, xor_linked>::emplace_back(Args&&... args)
+{
+    emplace(cend(), std::forward<Args>(args)...);
+}
+
+
+/*
+ Function: emplace / insert
+ Parameters:
+  - pos: The element to insert in front of.
+  - args / element: The new element, or its constructor's arguments.
+ Return value: An iterator to the new element. pos and the iterator to
+               the element before it are no longer valid.
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+template <class... Args>
+typename list<T, Alloc, xor_linked>::iterator
+list<T, Alloc, xor_linked>::emplace(const_iterator pos, Args&&... args)
+{
+    node_allocator alloc;
+    auto node = alloc.allocate(1);
+    try {
+        alloc.construct(node, std::forward<Args>(args)...);
+    } catch (...) {
+        alloc.deallocate(node, 1);
+        throw;
+    }
+    
+    node->link = reinterpret_cast<std::uintptr_t>(pos.prev) ^ reinterpret_cast<std::uintptr_t>(pos.node);
+    relink(pos.prev, pos.node, node);
+    relink(pos.node, pos.prev, node);
+    if (pos.node == _dummy)
+        _back = node;
+    ++_size;
+    return iterator(pos.prev, node);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::iterator
+list<T, Alloc, xor_linked>::insert(const_iterator pos, const_ref element)
+{
+    return emplace(pos, element);
+}
+
+template <class T, class Alloc>
+inline typename list<T, Alloc, xor_linked>::iterator
+list<T, Alloc, xor_linked>::insert(const_iterator pos, rvalue_ref element)
+{
+    return emplace(pos, std::move(element));
+}
+
+
+/*
+ Function: pop_front / pop_back / erase
+ Parameters:
+  - pos: The element to remove.
+ Return value: erase returns an iterator to the element after the one
+               removed. Iterators to its neighbours are no longer valid.
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+inline void
+list<T, Alloc, xor_linked>::pop_front()
+{
+    assert(!empty());
+    erase(cbegin());
+}
+
+template <class T, class Alloc>
+inline void
+list<T, Alloc, xor_linked>::pop_back()
+{
+    assert(!empty());
+    erase(--cend());
+}
+
+template <class T, class Alloc>
+typename list<T, Alloc, xor_linked>::iterator
+list<T, Alloc, xor_linked>::erase(const_iterator pos)
+{
+    assert(pos.node != _dummy);
+    
+    auto next = across(pos.node, pos.prev);
+    relink(pos.prev, pos.node, next);
+    relink(next, pos.node, pos.prev);
+    if (pos.node == _back)
+        _back = pos.prev;
+    --_size;
+    
+    node_allocator alloc;
+    auto data = static_cast<data_node*>(pos.node);
+    alloc.destroy(data);
+    alloc.deallocate(data, 1);
+    return iterator(pos.prev, next);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - rhs: The other list.
+ Return value: None
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, xor_linked>::swap(list<T, Alloc, xor_linked>& rhs)
+{
+    std::swap(_dummy, rhs._dummy);
+    std::swap(_back, rhs._back);
+    std::swap(_size, rhs._size);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every element.
+ 
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, xor_linked>::clear() noexcept
+{
+    node_allocator alloc;
+    Node* prev = _dummy;
+    for (auto node = across(_dummy, _back); node != _dummy;) {
+        auto next = across(node, prev);
+        prev = node;
+        alloc.destroy(static_cast<data_node*>(node));
+        alloc.deallocate(static_cast<data_node*>(node), 1);
+        node = next;
+    }
+    _dummy->link = 0;
+    _back = _dummy;
+    _size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: remove_if
+ Parameters:
+  - pred: The predicate used to test all elements in the list.
+ Return value: None
+ 
+ Description:
+    Removes from the list all elements that satisfy a predicate.
+ 
+ Complexity: Linear in the size of the list.
+ */
+template <class T, class Alloc>
+template <class Predicate>
+void
+list<T, Alloc, xor_linked>::remove_if(Predicate pred)
+{
+    for (auto it = cbegin(); it != cend();) {
+        if (pred(*it))
+            it = erase(it);
+        else
+            ++it;
+    }
+}
+
+
+/*
+ Function: reverse
+ Description:
+    The links read the same in both directions, so reversing only swaps
+    which end the list starts from.
+ 
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+void
+list<T, Alloc, xor_linked>::reverse() noexcept
+{
+    _back = across(_dummy, _back);
+}
+
+
+
+/*
+ Function: merge_tournament
+ Parameters:
+  - lists: The sorted lists to merge, each left empty.
+  - compare: Compares two elements through iterators to them.
+ Return value: A list of every element, sorted.
+ 
+ Description:
+    Keeps a tournament tree of the lists' fronts that remembers the loser
+    of each match. The overall winner's front node is moved to the result,
+    and only the matches on its list's path are replayed. Equal elements
+    keep the order of the lists they came from.
+ 
+ Complexity: O(n log k) for n elements in k lists.
+ */
+template <class List, class Compare>
+List
+merge_tournament(const std::vector<List*>& lists, Compare compare)
+{
+    List merged;
+    auto k = lists.size();
+    if (k == 0)
+        return merged;
+    
+    // Whether list a's front goes before list b's. An empty list loses to
+    // anything and ties go to the earlier list.
+    auto beats = [&](std::size_t a, std::size_t b) {
+        if (lists[a]->empty() || lists[b]->empty())
+            return lists[b]->empty() && (!lists[a]->empty() || a < b);
+        return a < b ? !compare(lists[b]->begin(), lists[a]->begin())
+                     : compare(lists[a]->begin(), lists[b]->begin());
+    };
+    
+    // Match i is played between the winners of 2i and 2i + 1; list j
+    // enters as k + j. Each match keeps its loser.
+    std::vector<std::size_t> loser(k);
+    std::function<std::size_t (std::size_t)> play = [&](std::size_t match) {
+        if (match >= k)
+            return match - k;
+        auto a = play(2 * match), b = play(2 * match + 1);
+        if (beats(a, b)) {
+            loser[match] = b;
+            return a;
+        }
+        loser[match] = a;
+        return b;
+    };
+    auto winner = play(1);
+    
+    while (!lists[winner]->empty()) {
+        merged.splice(merged.cend(), *lists[winner], lists[winner]->cbegin());
+        for (auto match = (k + winner) / 2; match > 0; match /= 2)
+            if (beats(loser[match], winner))
+                std::swap(loser[match], winner);
+    }
+    return merged;
+}
+
+
+/*
+ Function: merge_k
+ Parameters:
+  - first, last: A range of sorted lists.
+  - compare: Compares two elements through iterators to them, as in
+             list::sort.
+ Return value: A list of every element, sorted, leaving the inputs empty.
+ Equal elements keep the order of the lists they came from.
+ 
+ Description:
+    Every list is merged at once through a tournament tree
+    (merge_tournament). parallel_list.h has an overload taking a
+    thread_pool.
+ 
+ Complexity: O(n log k) for n elements in k lists. No elements are
+             copied; nodes are relinked.
+ */
+template <class ForwardIt, class Compare>
+typename std::iterator_traits<ForwardIt>::value_type
+merge_k(ForwardIt first, ForwardIt last, Compare compare)
+{
+    typedef typename std::iterator_traits<ForwardIt>::value_type list_type;
+    
+    std::vector<list_type*> lists;
+    for (; first != last; ++first)
+        lists.push_back(&*first);
+    
+    return merge_tournament(lists, compare);
+}
+
+template <class ForwardIt>
+inline typename std::iterator_traits<ForwardIt>::value_type
+merge_k(ForwardIt first, ForwardIt last)
+{
+    typedef typename std::iterator_traits<ForwardIt>::value_type::iterator iterator;
+    return merge_k(first, last, [](iterator a, iterator b) { return *a < *b; });
+}
+
+
+
+/*
+ Class: list_hook
+ 
+ Description:
+    The links an object needs to be on one intrusive_list. An object
+    embeds one hook per list it can be on at the same time. A hook that is
+    not on a list has null links; copying an object does not copy its
+    hook's membership.
+ */
+class list_hook {
+    
+    template <class T, list_hook T::*Hook>
+        friend class intrusive_list;
+    
+/* Data members */
+private:
+    list_hook* prev = nullptr;
+    list_hook* next = nullptr;
+    
+/* Member functions */
+public:
+    list_hook() = default;
+    list_hook(const list_hook&) {}
+    list_hook& operator=(const list_hook&) { return *this; }
+    ~list_hook() { assert(!is_linked()); }
+    
+    bool is_linked() const { return next != nullptr; }
+};
+
+
+
+/*
+ Class: intrusive_list
+ 
+ Description:
+    A list of objects it does not own, linked through their Hook member.
+    Nothing is allocated or copied: pushing links the object itself, and
+    an object can be unlinked in constant time from a reference to it.
+    An object with several hooks can be on several lists at once. Objects
+    must stay put, and must be unlinked before they are destroyed.
+ 
+ Complexity: Everything is constant except clear(), the destructor, and
+             range erase, which are linear in the elements unlinked.
+ */
+template <class T, list_hook T::*Hook>
+class intrusive_list {
+    
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef const T&    const_ref;
+    
+    class iterator : public std::iterator< std::bidirectional_iterator_tag, value_type > {
+        
+        friend class intrusive_list<T, Hook>;
+        
+    /* Iterator data members */
+    private:
+        list_hook* hook;
+        
+    /* Iterator member functions */
+    public:
+        iterator(list_hook* h = nullptr) : hook(h) {}
+        reference operator*() const { return *owner(hook); }
+        pointer operator->() const { return owner(hook); }
+        iterator& operator++() { hook = hook->next; return *this; }
+        iterator operator++(int) { iterator temp(*this); hook = hook->next; return temp; }
+        iterator& operator--() { hook = hook->prev; return *this; }
+        iterator operator--(int) { iterator temp(*this); hook = hook->prev; return temp; }
+        bool operator==(const iterator& rhs) const { return hook == rhs.hook; }
+        bool operator!=(const iterator& rhs) const { return hook != rhs.hook; }
+    };
+    
+    class const_iterator : public std::iterator< std::bidirectional_iterator_tag, const value_type > {
+        
+        friend class intrusive_list<T, Hook>;
+        
+    /* Iterator data members */
+    private:
+        list_hook* hook;
+        
+    /* Iterator member functions */
+    public:
+        const_iterator(list_hook* h = nullptr) : hook(h) {}
+        const_iterator(const iterator& it) : hook(it.hook) {}
+        const_ref operator*() const { return *owner(hook); }
+        const_ptr operator->() const { return owner(hook); }
+        const_iterator& operator++() { hook = hook->next; return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); hook = hook->next; return temp; }
+        const_iterator& operator--() { hook = hook->prev; return *this; }
+        const_iterator operator--(int) { const_iterator temp(*this); hook = hook->prev; return temp; }
+        bool operator==(const const_iterator& rhs) const { return hook == rhs.hook; }
+        bool operator!=(const const_iterator& rhs) const { return hook != rhs.hook; }
+    };
+    
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    
+    
+/* Data members */
+private:
+    list_hook _root;       // Sentinel between the last element and the first.
+    size_type _size = 0;
+    
+    
+/* Member functions */
+public:
+    /* Constructors */
+    intrusive_list();
+    intrusive_list(const intrusive_list<T, Hook>&) = delete;
+    intrusive_list(intrusive_list<T, Hook>&&);
+    ~intrusive_list();
+    
+    /* Assignment */
+    intrusive_list<T, Hook>& operator=(const intrusive_list<T, Hook>&) = delete;
+    intrusive_list<T, Hook>& operator=(intrusive_list<T, Hook>&&);
+    
+    /* Iterators */
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin();
+    reverse_iterator rend();
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+    iterator iterator_to(reference);
+    
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    
+    /* Element access */
+    reference front();
+    reference last();
+    
+    /* Modifiers */
+    void push_front(reference);
+    void push_back(reference);
+    iterator insert(const_iterator, reference);
+    void pop_front();
+    void pop_back();
+    iterator erase(const_iterator);
+    iterator erase(const_iterator, const_iterator);
+    void unlink(reference);
+    void swap(intrusive_list<T, Hook>&);
+    void clear() noexcept;
+    
+    /* Operations */
+    void splice(const_iterator, intrusive_list<T, Hook>&);
+    void splice(const_iterator, intrusive_list<T, Hook>&, const_iterator);
+    
+/* Helper functions */
+private:
+    static T* owner(const list_hook*);
+    void repair();
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The list whose elements are being taken over.
+ Return value: None
+ 
+ Description:
+    Makes a(n)...
+  1. empty list.
+  2. list of rhs's elements, leaving rhs empty.
+ 
+ Complexity: Constant.
+ */
+
+// 1. default
+template <class T, list_hook T::*Hook>
+intrusive_list<T, Hook>::intrusive_list()
+{
+    _root.prev = _root.next = &_root;
+}
+
+// 2. move
+template <class T, list_hook T::*Hook>
+intrusive_list<T, Hook>::intrusive_list(intrusive_list<T, Hook>&& rhs)
+    : intrusive_list()
+{
+    swap(rhs);
+}
+
+
+/*
+ Function: destructor
+ 
+ Description:
+    Unlinks every element; the elements themselves are untouched.
+ */
+template <class T, list_hook T::*Hook>
+intrusive_list<T, Hook>::~intrusive_list()
+{
+    clear();
+    _root.prev = _root.next = nullptr;
+}
+
+
+
+// Assignment
+
+/*
+ Function: move assignment
+ Parameters:
+  - rhs: The list whose elements are being taken over.
+ Return value: This list.
+ 
+ Description:
+    Unlinks this list's elements and takes over rhs's.
+ */
+template <class T, list_hook T::*Hook>
+intrusive_list<T, Hook>&
+intrusive_list<T, Hook>::operator=(intrusive_list<T, Hook>&& rhs)
+{
+    clear();
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end / cbegin / cend / rbegin / rend / crbegin / crend
+ Return value: Iterators to the first element and past the last, and
+               their const and reverse versions.
+ */
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::iterator
+intrusive_list<T, Hook>::begin()
+{
+    return iterator(_root.next);
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::iterator
+intrusive_list<T, Hook>::end()
+{
+    return iterator(&_root);
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::const_iterator
+intrusive_list<T, Hook>::begin() const
+{
+    return cbegin();
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::const_iterator
+intrusive_list<T, Hook>::end() const
+{
+    return cend();
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::const_iterator
+intrusive_list<T, Hook>::cbegin() const
+{
+    return const_iterator(_root.next);
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::const_iterator
+intrusive_list<T, Hook>::cend() const
+{
+    return const_iterator(const_cast<list_hook*>(&_root));
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::reverse_iterator
+intrusive_list<T, Hook>::rbegin()
+{
+    return reverse_iterator(end());
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::reverse_iterator
+intrusive_list<T, Hook>::rend()
+{
+    return reverse_iterator(begin());
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::const_reverse_iterator
+intrusive_list<T, Hook>::crbegin() const
+{
+    return const_reverse_iterator(cend());
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::const_reverse_iterator
+intrusive_list<T, Hook>::crend() const
+{
+    return const_reverse_iterator(cbegin());
+}
+
+
+/*
+ Function: iterator_to
+ Parameters:
+  - element: An object on this list.
+ Return value: An iterator to it.
+ 
+ Complexity: Constant.
+ */
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::iterator
+intrusive_list<T, Hook>::iterator_to(reference element)
+{
+    assert((element.*Hook).is_linked());
+    return iterator(&(element.*Hook));
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: Whether the list is empty, and the number of elements.
+ */
+template <class T, list_hook T::*Hook>
+inline bool
+intrusive_list<T, Hook>::empty() const
+{
+    return _size == 0;
+}
+
+template <class T, list_hook T::*Hook>
+inline typename intrusive_list<T, Hook>::size_type
+intrusive_list<T, Hook>::size() const
+{
+    return _size;
+}
+
+
+
+// Element access
+
+/*
+ Function: front / last
+ Return value: The first or the last element.
+ */
+template <class T, list_hook T::*Hook>
+inline T&
+intrusive_list<T, Hook>::front()
+{
+    assert(!empty());
+    return *owner(_root.next);
+}
+
+template <class T, list_hook T::*Hook>
+inline T&
+intrusive_list<T, Hook>::last()
+{
+    assert(!empty());
+    return *owner(_root.prev);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push_front / push_back / insert
+ Parameters:
+  - pos: The element to link in front of.
+  - element: An object whose hook is not on any list.
+ Return value: insert returns an iterator to element.
+ 
+ Complexity: Constant.
+ */
+template <class T, list_hook T::*Hook>
+inline void
+intrusive_list<T, Hook>::push_front(reference element)
+{
+    insert(cbegin(), element);
+}
+
+template <class T, list_hook T::*Hook>
+inline void
+intrusive_list<T, Hook>::push_back(reference element)
+{
+    insert(cend(), element);
+}
+
+template <class T, list_hook T::*Hook>
+typename intrusive_list<T, Hook>::iterator
+intrusive_list<T, Hook>::insert(const_iterator pos, reference element)
+{
+    auto hook = &(element.*Hook);
+    assert(!hook->is_linked());
+    
+    hook->next = pos.hook;
+    hook->prev = pos.hook->prev;
+    pos.hook->prev->next = hook;
+    pos.hook->prev = hook;
+    ++_size;
+    return iterator(hook);
+}
+
+
+/*
+ Function: pop_front / pop_back / erase / unlink
+ Parameters:
+  - pos: The element to unlink.
+  - first, last: The range of elements to unlink.
+  - element: An object on this list.
+ Return value: erase returns an iterator to the element after the last
+               one unlinked.
+ 
+ Description:
+    Takes elements off the list, leaving their hooks unlinked. Nothing is
+    destroyed.
+ 
+ Complexity: Constant per element.
+ */
+template <class T, list_hook T::*Hook>
+inline void
+intrusive_list<T, Hook>::pop_front()
+{
+    assert(!empty());
+    erase(cbegin());
+}
+
+template <class T, list_hook T::*Hook>
+inline void
+intrusive_list<T, Hook>::pop_back()
+{
+    assert(!empty());
+    erase(const_iterator(_root.prev));
+}
+
+template <class T, list_hook T::*Hook>
+typename intrusive_list<T, Hook>::iterator
+intrusive_list<T, Hook>::erase(const_iterator pos)
+{
+    auto hook = pos.hook, next = hook->next;
+    assert(hook != &_root);
+    
+    hook->prev->next = next;
+    next->prev = hook->prev;
+    hook->prev = hook->next = nullptr;
+    --_size;
+    return iterator(next);
+}
+
+template <class T, list_hook T::*Hook>
+typename intrusive_list<T, Hook>::iterator
+intrusive_list<T, Hook>::erase(const_iterator first, const_iterator last)
+{
+    while (first != last)
+        erase(first++);
+    return iterator(last.hook);
+}
+
+template <class T, list_hook T::*Hook>
+inline void
+intrusive_list<T, Hook>::unlink(reference element)
+{
+    erase(iterator_to(element));
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - rhs: The other list.
+ Return value: None
+ 
+ Complexity: Constant.
+ */
+template <class T, list_hook T::*Hook>
+void
+intrusive_list<T, Hook>::swap(intrusive_list<T, Hook>& rhs)
+{
+    std::swap(_root.prev, rhs._root.prev);
+    std::swap(_root.next, rhs._root.next);
+    std::swap(_size, rhs._size);
+    repair();
+    rhs.repair();
+}
+
+
+/*
+ Function: clear
+ 
+ Description:
+    Unlinks every element.
+ 
+ Complexity: Linear.
+ */
+template <class T, list_hook T::*Hook>
+void
+intrusive_list<T, Hook>::clear() noexcept
+{
+    for (auto hook = _root.next; hook != &_root;) {
+        auto next = hook->next;
+        hook->prev = hook->next = nullptr;
+        hook = next;
+    }
+    _root.prev = _root.next = &_root;
+    _size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: splice
+ Parameters:
+  - pos: The element to move elements in front of.
+  - x: The list to take them from; may be this list for 2.
+  - i: The element of x to move.
+ Return value: None
+ 
+ Description:
+  1. Moves every element of x in front of pos.
+  2. Moves one element of x in front of pos.
+ 
+ Complexity: Constant.
+ */
+
+// 1. entire list
+template <class T, list_hook T::*Hook>
+void
+intrusive_list<T, Hook>::splice(const_iterator pos, intrusive_list<T, Hook>& x)
+{
+    if (this == &x || x.empty())
+        return;
+    
+    auto first = x._root.next, last = x._root.prev;
+    pos.hook->prev->next = first;
+    first->prev = pos.hook->prev;
+    last->next = pos.hook;
+    pos.hook->prev = last;
+    _size += x._size;
+    
+    x._root.prev = x._root.next = &x._root;
+    x._size = 0;
+}
+
+// 2. single element
+template <class T, list_hook T::*Hook>
+void
+intrusive_list<T, Hook>::splice(const_iterator pos, intrusive_list<T, Hook>& x, const_iterator i)
+{
+    if (pos == i || pos.hook == i.hook->next)
+        return;
+    
+    auto& element = *owner(i.hook);
+    x.erase(i);
+    insert(pos, element);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: owner
+ Parameters:
+  - hook: A hook that is the Hook member of some T.
+ Return value: That T.
+ 
+ Description:
+    Steps back by the hook's offset within T, measured on storage shaped
+    like a T.
+ */
+template <class T, list_hook T::*Hook>
+inline T*
+intrusive_list<T, Hook>::owner(const list_hook* hook)
+{
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type shape;
+    auto base = reinterpret_cast<const char*>(&shape);
+    auto offset = reinterpret_cast<const char*>(&(reinterpret_cast<const T*>(base)->*Hook)) - base;
+    return reinterpret_cast<T*>(const_cast<char*>(reinterpret_cast<const char*>(hook) - offset));
+}
+
+
+/*
+ Function: repair
+ 
+ Description:
+    Points the first and last elements back at this list's root after
+    the root's links were copied from another list.
+ */
+template <class T, list_hook T::*Hook>
+void
+intrusive_list<T, Hook>::repair()
+{
+    if (_size == 0) {
+        _root.prev = _root.next = &_root;
+    } else {
+        _root.next->prev = &_root;
+        _root.prev->next = &_root;
+    }
+}
+
+
 } // end namespace
 
 #endif /* list_h */
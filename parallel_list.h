@@ -0,0 +1,91 @@
+/*
+ File:   parallel_list.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Algorithms over list.h's lists that run on a thread_pool. Kept apart
+    from list.h so that plain list users do not pull in threads.
+
+ Implementation:
+  - merge_k halves the range of lists recursively, merges the halves in
+    parallel with fork_join and joins them with list::merge, which
+    relinks whole runs. Groups of a few lists at the bottom go through
+    list.h's tournament tree.
+ */
+
+
+#ifndef parallel_list_h
+#define parallel_list_h
+
+#include <cstddef>     // size_t
+#include <functional>  // function
+#include <iterator>    // iterator_traits
+#include <vector>      // vector
+
+#include "list.h"
+#include "thread_pool.h"
+
+namespace ads {
+
+/*
+ Function: merge_k
+ Parameters:
+  - first, last: A range of sorted lists.
+  - compare: Compares two elements through iterators to them, as in
+             list::sort.
+  - pool: Merges independent groups of lists in parallel.
+ Return value: A list of every element, sorted, leaving the inputs empty.
+ Equal elements keep the order of the lists they came from.
+ 
+ Description:
+    As list.h's merge_k, with the lists halved recursively and the halves
+    merged in parallel.
+ 
+ Complexity: O(n log k) for n elements in k lists. The span is O(n),
+             dominated by the last two-way merge; the levels below it
+             run in parallel. No elements are copied; nodes are relinked.
+ */
+template <class ForwardIt, class Compare>
+typename std::iterator_traits<ForwardIt>::value_type
+merge_k(ForwardIt first, ForwardIt last, Compare compare, thread_pool& pool)
+{
+    typedef typename std::iterator_traits<ForwardIt>::value_type list_type;
+    const std::size_t grain = 4;      // Lists merged by one tournament tree.
+    
+    std::vector<list_type*> lists;
+    for (; first != last; ++first)
+        lists.push_back(&*first);
+    
+    // Leaves the merge of lists [lo, hi) in *lists[lo].
+    std::function<void (std::size_t, std::size_t)> merge_range = [&](std::size_t lo, std::size_t hi) {
+        if (hi - lo <= grain) {
+            std::vector<list_type*> group(lists.begin() + lo, lists.begin() + hi);
+            auto merged = merge_tournament(group, compare);
+            lists[lo]->swap(merged);
+            return;
+        }
+        
+        auto mid = lo + (hi - lo) / 2;
+        pool.fork_join([&] { merge_range(lo, mid); }, [&] { merge_range(mid, hi); });
+        lists[lo]->merge(*lists[mid], compare);
+    };
+    
+    list_type merged;
+    if (!lists.empty()) {
+        pool.run([&] { merge_range(0, lists.size()); });
+        merged.swap(*lists[0]);
+    }
+    return merged;
+}
+
+template <class ForwardIt>
+inline typename std::iterator_traits<ForwardIt>::value_type
+merge_k(ForwardIt first, ForwardIt last, thread_pool& pool)
+{
+    typedef typename std::iterator_traits<ForwardIt>::value_type::iterator iterator;
+    return merge_k(first, last, [](iterator a, iterator b) { return *a < *b; }, pool);
+}
+
+} // end namespace
+
+#endif /* parallel_list_h */
@@ -0,0 +1,935 @@
+/*
+ File:   perfect_hash.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Hashing for key sets that are fixed once built. perfect_hash maps each
+    of n keys to its own index in [0, n) in constant worst-case time using
+    about three bits per key. static_hash_map stores values at those
+    indices. Both live in a single flat buffer that can be written to a
+    file and memory-mapped back later without being rebuilt.
+
+ Implementation:
+  - The construction is PTHash. Keys are hashed to 64 bits and split into
+    about c * n / log2(n) buckets, skewed so that 60% of the keys land in
+    the first 30% of buckets. Buckets are placed largest first: each gets
+    the smallest "pilot" value for which hash(key ^ hash(pilot)) sends all
+    of its keys to free slots. A lookup is then one hash, one pilot read
+    and one multiply-shift reduction.
+  - The slot table is n / alpha long, a little more than n, which makes
+    the last buckets much cheaper to place. The few keys landing past n
+    are sent through a remap array into the slots below n that stayed
+    empty, so the result is minimal.
+  - Pilots and remap entries are packed at the width of the largest one.
+  - The buffer starts with a header (magic, version, seed and sizes),
+    followed by the packed arrays, all in 64 bit words. A buffer is either
+    owned or a view over memory the caller keeps alive, such as an mmap of
+    a file. Views are checked for a valid header but otherwise trusted.
+  - The hasher must give the same results in every process that reads a
+    buffer. std::hash does for integers, and for strings within one
+    standard library.
+  - Keys outside the set get some index in [0, n) too. static_hash_map
+    stores the keys to reject them, so its keys and values must be
+    trivially copyable.
+ */
+
+
+#ifndef perfect_hash_h
+#define perfect_hash_h
+
+#include <algorithm>         // sort, max
+#include <cmath>             // ceil, log2
+#include <cstdint>           // uint64_t
+#include <cstring>           // memcmp, memcpy
+#include <functional>        // hash, equal_to
+#include <initializer_list>  // initializer_list
+#include <iterator>          // iterator_traits
+#include <stdexcept>         // invalid_argument, runtime_error
+#include <type_traits>       // is_trivially_copyable
+#include <utility>           // swap
+#include <vector>            // vector
+
+#include "flat_hash_map.h"   // hash_mix
+
+namespace ads {
+
+template <class Key, class Hash = std::hash<Key>>
+class perfect_hash {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef Key         key_type;
+    typedef const Key&  const_ref;
+
+
+/* Buffer layout */
+private:
+    struct Header {
+        char magic[8];              // "perfhash"
+        std::uint64_t version;
+        std::uint64_t seed;
+        std::uint64_t keys;
+        std::uint64_t table_size;
+        std::uint64_t buckets;
+        std::uint64_t dense_buckets;
+        std::uint64_t pilot_bits;
+        std::uint64_t remap_bits;
+        std::uint64_t words;        // Of the whole buffer, header included.
+    };
+
+    static constexpr std::uint64_t version = 1;
+    static constexpr size_type header_words = sizeof(Header) / sizeof(std::uint64_t);
+    static constexpr std::uint64_t dense_threshold = 0x9999999999999999ull;   // 60% of the hash range.
+    static constexpr std::uint64_t max_pilot = std::uint64_t(1) << 24;
+
+
+/* Data members */
+private:
+    std::vector<std::uint64_t> _owned;      // Empty for a view.
+    const std::uint64_t* _data = nullptr;
+    const std::uint64_t* _pilots = nullptr;
+    const std::uint64_t* _remap = nullptr;
+    Header _header;
+    Hash _hash;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    perfect_hash();
+    template <class InputIt>
+        perfect_hash(InputIt, InputIt, double = 5.0, double = 0.99);
+    perfect_hash(std::initializer_list<Key>, double = 5.0, double = 0.99);
+    perfect_hash(const perfect_hash<Key, Hash>&);
+    perfect_hash(perfect_hash<Key, Hash>&&) = default;
+    static perfect_hash<Key, Hash> view(const void*, size_type);
+
+    /* Assignment */
+    perfect_hash<Key, Hash>& operator=(perfect_hash<Key, Hash>);
+
+    /* Capacity */
+    size_type size() const;
+    double bits_per_key() const;
+
+    /* Lookup */
+    size_type operator()(const_ref) const;
+
+    /* Serialization */
+    const void* data() const;
+    size_type bytes() const;
+
+    /* Modifiers */
+    void swap(perfect_hash<Key, Hash>&);
+
+/* Helper functions */
+private:
+    void build(std::vector<std::uint64_t>&, double, double);
+    bool place(const std::vector<std::uint64_t>&, std::uint64_t, double, double);
+    void attach(const std::uint64_t*);
+    std::uint64_t bucket(std::uint64_t) const;
+    static std::uint64_t reduce(std::uint64_t hash, std::uint64_t range);
+    static std::uint64_t read_packed(const std::uint64_t*, std::uint64_t, std::uint64_t);
+    static void write_packed(std::uint64_t*, std::uint64_t, std::uint64_t, std::uint64_t);
+    static std::uint64_t width(std::uint64_t);
+    static std::uint64_t packed_words(std::uint64_t count, std::uint64_t bits) { return (count * bits + 63) / 64 + 1; }
+};
+
+
+template <class Key, class Hash>
+constexpr std::uint64_t perfect_hash<Key, Hash>::version;
+template <class Key, class Hash>
+constexpr typename perfect_hash<Key, Hash>::size_type perfect_hash<Key, Hash>::header_words;
+template <class Key, class Hash>
+constexpr std::uint64_t perfect_hash<Key, Hash>::dense_threshold;
+template <class Key, class Hash>
+constexpr std::uint64_t perfect_hash<Key, Hash>::max_pilot;
+
+
+
+// A read-only map over a fixed set of keys, laid out for memory mapping.
+template <class Key, class Value, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+class static_hash_map {
+
+    static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value,
+                  "static_hash_map stores keys and values as raw bytes");
+    static_assert(alignof(Key) <= alignof(std::uint64_t) && alignof(Value) <= alignof(std::uint64_t),
+                  "static_hash_map aligns its arrays to 8 bytes");
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef Key         key_type;
+    typedef Value       mapped_type;
+    typedef const Key&  const_ref;
+
+
+/* Buffer layout */
+private:
+    struct Header {
+        char magic[8];              // "phashmap"
+        std::uint64_t version;
+        std::uint64_t key_size;
+        std::uint64_t value_size;
+        std::uint64_t keys;
+        std::uint64_t index_words;
+        std::uint64_t words;
+    };
+
+    static constexpr size_type header_words = sizeof(Header) / sizeof(std::uint64_t);
+
+
+/* Data members */
+private:
+    std::vector<std::uint64_t> _owned;
+    const std::uint64_t* _data = nullptr;
+    perfect_hash<Key, Hash> _index;
+    const Key* _keys = nullptr;
+    const Value* _values = nullptr;
+    KeyEqual _equal;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    static_hash_map() = default;
+    template <class InputIt>
+        static_hash_map(InputIt, InputIt);
+    static_hash_map(std::initializer_list<std::pair<Key, Value>>);
+    static_hash_map(const static_hash_map<Key, Value, Hash, KeyEqual>&);
+    static_hash_map(static_hash_map<Key, Value, Hash, KeyEqual>&&) = default;
+    static static_hash_map<Key, Value, Hash, KeyEqual> view(const void*, size_type);
+
+    /* Assignment */
+    static_hash_map<Key, Value, Hash, KeyEqual>& operator=(static_hash_map<Key, Value, Hash, KeyEqual>);
+
+    /* Capacity */
+    bool empty() const { return !size(); }
+    size_type size() const { return _index.size(); }
+
+    /* Element access */
+    bool has(const_ref) const;
+    bool find(const_ref, Value&) const;
+    const Value* get(const_ref) const;
+
+    /* Serialization */
+    const void* data() const { return _data; }
+    size_type bytes() const { return _data ? reinterpret_cast<const Header*>(_data)->words * sizeof(std::uint64_t) : 0; }
+
+    /* Modifiers */
+    void swap(static_hash_map<Key, Value, Hash, KeyEqual>&);
+
+/* Helper functions */
+private:
+    void attach(const std::uint64_t*, size_type);
+    static size_type array_words(size_type count, size_type size) { return (count * size + 7) / 8; }
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - first, last: The keys to hash. Duplicates are an error.
+  - il: The keys to hash.
+  - c: Bucket density. Larger c builds faster and uses more bits per key;
+       the default gives about three.
+  - alpha: The fraction of table slots keys end up in before the remap.
+  - rhs: The perfect hash to copy.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty perfect hash over no keys.
+  2. perfect hash over the keys in [first, last).
+  3. perfect hash over the keys in il.
+  4. copy of rhs. A copy of a view is a view of the same memory.
+
+ Complexity:
+  1. Constant.
+  2. Expected O(n log n) for n keys.
+  3. Expected O(n log n) for n keys.
+  4. Linear in the size of rhs's buffer.
+
+ Exceptions:
+    Throws std::invalid_argument if two keys hash to the same 64 bit value,
+    which in practice means they are equal.
+ */
+
+// 1. default
+template <class Key, class Hash>
+perfect_hash<Key, Hash>::perfect_hash()
+{
+    std::vector<std::uint64_t> none;
+    build(none, 5.0, 0.99);
+}
+
+// 2. range
+template <class Key, class Hash>
+template <class InputIt>
+perfect_hash<Key, Hash>::perfect_hash(InputIt first, InputIt last, double c, double alpha)
+{
+    std::vector<std::uint64_t> hashes;
+    for (; first != last; ++first)
+        hashes.push_back(static_cast<std::uint64_t>(_hash(*first)));
+    build(hashes, c, alpha);
+}
+
+// 3. initializer list
+template <class Key, class Hash>
+perfect_hash<Key, Hash>::perfect_hash(std::initializer_list<Key> il, double c, double alpha)
+    : perfect_hash(il.begin(), il.end(), c, alpha)
+{}
+
+// 4. copy
+template <class Key, class Hash>
+perfect_hash<Key, Hash>::perfect_hash(const perfect_hash<Key, Hash>& rhs)
+    : _owned(rhs._owned)
+    , _hash(rhs._hash)
+{
+    attach(_owned.empty() ? rhs._data : _owned.data());
+}
+
+
+/*
+ Function: view
+ Parameters:
+  - data: A buffer produced by data(), aligned to 8 bytes. It must outlive
+          the returned object and every copy of it.
+  - size: Its length in bytes.
+ Return value: A perfect hash reading the buffer in place.
+
+ Complexity: Constant.
+
+ Exceptions:
+    Throws std::runtime_error if the buffer is not a perfect hash of this
+    format, or is too short for the sizes its header claims.
+ */
+template <class Key, class Hash>
+perfect_hash<Key, Hash>
+perfect_hash<Key, Hash>::view(const void* data, size_type size)
+{
+    auto words = static_cast<const std::uint64_t*>(data);
+    const Header* header = reinterpret_cast<const Header*>(words);
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t) || size < sizeof(Header)
+        || std::memcmp(header->magic, "perfhash", 8) || header->version != version)
+        throw std::runtime_error("perfect_hash: not a perfect hash buffer");
+
+    auto expected = header_words + packed_words(header->buckets, header->pilot_bits)
+                  + packed_words(header->table_size - header->keys, header->remap_bits);
+    if (header->words != expected || size < header->words * sizeof(std::uint64_t)
+        || header->table_size < header->keys || header->dense_buckets >= header->buckets
+        || header->pilot_bits > 64 || header->remap_bits > 64)
+        throw std::runtime_error("perfect_hash: truncated or inconsistent buffer");
+
+    perfect_hash<Key, Hash> result;
+    result._owned.clear();
+    result.attach(words);
+    return result;
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this perfect hash.
+ */
+template <class Key, class Hash>
+perfect_hash<Key, Hash>&
+perfect_hash<Key, Hash>::operator=(perfect_hash<Key, Hash> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Capacity
+
+/*
+ Function: size
+ Return value: The number of keys, which is also the range of indices.
+ */
+template <class Key, class Hash>
+typename perfect_hash<Key, Hash>::size_type
+perfect_hash<Key, Hash>::size() const
+{
+    return static_cast<size_type>(_header.keys);
+}
+
+
+/*
+ Function: bits_per_key
+ Return value: The space taken by pilots and remap entries per key. The
+               fixed size header is not counted.
+ */
+template <class Key, class Hash>
+double
+perfect_hash<Key, Hash>::bits_per_key() const
+{
+    if (!_header.keys)
+        return 0;
+    double bits = static_cast<double>(_header.buckets * _header.pilot_bits
+                                      + (_header.table_size - _header.keys) * _header.remap_bits);
+    return bits / static_cast<double>(_header.keys);
+}
+
+
+
+// Lookup
+
+/*
+ Function: operator()
+ Parameters:
+  - key: A key.
+ Return value: Its index, distinct for every key of the set and in
+               [0, size()). Other keys get an arbitrary index in range,
+               except that an empty set gives 0 (== size()) for every key.
+
+ Description:
+    An empty set has no slots to land in, and every probe would otherwise
+    take the remap branch and read past the empty remap table.
+
+ Complexity: Constant.
+ */
+template <class Key, class Hash>
+inline typename perfect_hash<Key, Hash>::size_type
+perfect_hash<Key, Hash>::operator()(const_ref key) const
+{
+    if (!_header.keys)
+        return 0;
+
+    auto hash = hash_mix(static_cast<std::uint64_t>(_hash(key)) ^ _header.seed);
+    auto pilot = read_packed(_pilots, bucket(hash), _header.pilot_bits);
+    auto slot = reduce(hash_mix(hash ^ hash_mix(pilot)), _header.table_size);
+    if (slot >= _header.keys)
+        slot = read_packed(_remap, slot - _header.keys, _header.remap_bits);
+    return static_cast<size_type>(slot);
+}
+
+
+
+// Serialization
+
+/*
+ Function: data / bytes
+ Return value: The buffer holding the whole perfect hash, and its length.
+               Written out and passed back to view, it needs no rebuild.
+ */
+template <class Key, class Hash>
+const void*
+perfect_hash<Key, Hash>::data() const
+{
+    return _data;
+}
+
+template <class Key, class Hash>
+typename perfect_hash<Key, Hash>::size_type
+perfect_hash<Key, Hash>::bytes() const
+{
+    return static_cast<size_type>(_header.words * sizeof(std::uint64_t));
+}
+
+
+
+// Modifiers
+
+/*
+ Function: swap
+ Parameters:
+  - other: The perfect hash to exchange contents with.
+
+ Description:
+    Swapping vectors keeps their buffers where they are, so the pointers
+    into them stay valid.
+ */
+template <class Key, class Hash>
+void
+perfect_hash<Key, Hash>::swap(perfect_hash<Key, Hash>& other)
+{
+    using std::swap;
+    swap(_owned, other._owned);
+    swap(_data, other._data);
+    swap(_pilots, other._pilots);
+    swap(_remap, other._remap);
+    swap(_header, other._header);
+    swap(_hash, other._hash);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: build
+ Parameters:
+  - hashes: The hasher's results for every key. Sorted in place.
+  - c: Bucket density.
+  - alpha: Load of the slot table.
+
+ Description:
+    Retries place with a new seed until every bucket finds a pilot. Each
+    attempt succeeds with high probability.
+
+ Exceptions:
+    Throws std::invalid_argument on duplicate hashes, and
+    std::runtime_error if no seed works, which should not happen.
+ */
+template <class Key, class Hash>
+void
+perfect_hash<Key, Hash>::build(std::vector<std::uint64_t>& hashes, double c, double alpha)
+{
+    std::sort(hashes.begin(), hashes.end());
+    if (std::adjacent_find(hashes.begin(), hashes.end()) != hashes.end())
+        throw std::invalid_argument("perfect_hash: duplicate keys");
+
+    for (std::uint64_t attempt = 1; attempt <= 64; ++attempt)
+        if (place(hashes, hash_mix(attempt * 0x9E3779B97F4A7C15ull) | 1, c, alpha))
+            return;
+
+    throw std::runtime_error("perfect_hash: no seed placed every key");
+}
+
+
+/*
+ Function: place
+ Parameters:
+  - raw: The hasher's results, all distinct.
+  - seed: Mixed into every hash.
+  - c: Bucket density.
+  - alpha: Load of the slot table.
+ Return value: Whether every bucket found a pilot. If so the buffer is
+               built and attached.
+
+ Description:
+    Groups the keys by bucket and visits buckets from largest to
+    smallest, searching pilots upwards from 0 and marking the slots of
+    each success taken. Then pairs the taken slots past n with the free
+    slots below it, in order.
+
+ Complexity: Expected O(n log n).
+ */
+template <class Key, class Hash>
+bool
+perfect_hash<Key, Hash>::place(const std::vector<std::uint64_t>& raw, std::uint64_t seed, double c, double alpha)
+{
+    std::uint64_t n = raw.size();
+    Header header;
+    std::memcpy(header.magic, "perfhash", 8);
+    header.version = version;
+    header.seed = seed;
+    header.keys = n;
+    header.table_size = std::max<std::uint64_t>(n, static_cast<std::uint64_t>(std::ceil(n / alpha)));
+    header.buckets = std::max<std::uint64_t>(2, static_cast<std::uint64_t>(std::ceil(c * n / std::log2(std::max<double>(n, 2)))));
+    header.dense_buckets = std::max<std::uint64_t>(1, std::min<std::uint64_t>(header.buckets - 1, header.buckets * 3 / 10));
+    _header = header;
+
+    // Hashes grouped by bucket, and buckets ordered by size, largest first.
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> keyed(n);
+    for (std::uint64_t i = 0; i < n; ++i) {
+        auto hash = hash_mix(raw[i] ^ seed);
+        keyed[i] = std::make_pair(bucket(hash), hash);
+    }
+    std::sort(keyed.begin(), keyed.end());
+    for (std::uint64_t i = 1; i < n; ++i)
+        if (keyed[i].second == keyed[i - 1].second)
+            return false;
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> order;     // (size, first key)
+    for (std::uint64_t i = 0; i < n;) {
+        auto j = i;
+        while (j < n && keyed[j].first == keyed[i].first)
+            ++j;
+        order.emplace_back(j - i, i);
+        i = j;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](const std::pair<std::uint64_t, std::uint64_t>& a, const std::pair<std::uint64_t, std::uint64_t>& b) {
+                         return a.first > b.first;
+                     });
+
+    std::vector<std::uint64_t> taken(header.table_size / 64 + 1, 0), pilots(header.buckets, 0), slots;
+    std::uint64_t largest = 0;
+    for (auto& group : order) {
+        auto first = keyed.begin() + static_cast<std::ptrdiff_t>(group.second);
+        std::uint64_t pilot = 0;
+        for (;; ++pilot) {
+            if (pilot == max_pilot)
+                return false;
+
+            auto pilot_hash = hash_mix(pilot);
+            slots.clear();
+            bool fits = true;
+            for (std::uint64_t k = 0; k < group.first && fits; ++k) {
+                auto slot = reduce(hash_mix(first[static_cast<std::ptrdiff_t>(k)].second ^ pilot_hash), header.table_size);
+                fits = !(taken[slot / 64] >> (slot % 64) & 1);
+                if (fits) {
+                    taken[slot / 64] |= std::uint64_t(1) << (slot % 64);
+                    slots.push_back(slot);
+                }
+            }
+            if (fits)
+                break;
+            for (auto slot : slots)
+                taken[slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+        }
+        pilots[first->first] = pilot;
+        largest = std::max(largest, pilot);
+    }
+
+    // Remap the slots past n onto the holes below it.
+    std::vector<std::uint64_t> remap(header.table_size - n, 0);
+    std::uint64_t hole = 0;
+    for (std::uint64_t slot = n; slot < header.table_size; ++slot) {
+        if (!(taken[slot / 64] >> (slot % 64) & 1))
+            continue;
+        while (taken[hole / 64] >> (hole % 64) & 1)
+            ++hole;
+        remap[slot - n] = hole++;
+    }
+
+    header.pilot_bits = width(largest);
+    header.remap_bits = width(n ? n - 1 : 0);
+    auto pilot_words = packed_words(header.buckets, header.pilot_bits);
+    header.words = header_words + pilot_words + packed_words(remap.size(), header.remap_bits);
+
+    std::vector<std::uint64_t> buffer(header.words, 0);
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+    for (std::uint64_t b = 0; b < header.buckets; ++b)
+        write_packed(buffer.data() + header_words, b, header.pilot_bits, pilots[b]);
+    for (std::uint64_t i = 0; i < remap.size(); ++i)
+        write_packed(buffer.data() + header_words + pilot_words, i, header.remap_bits, remap[i]);
+
+    _owned.swap(buffer);
+    attach(_owned.data());
+    return true;
+}
+
+
+/*
+ Function: attach
+ Parameters:
+  - data: A validated buffer.
+
+ Description:
+    Points the lookup fields into data.
+ */
+template <class Key, class Hash>
+void
+perfect_hash<Key, Hash>::attach(const std::uint64_t* data)
+{
+    _data = data;
+    std::memcpy(&_header, data, sizeof(Header));
+    _pilots = data + header_words;
+    _remap = _pilots + packed_words(_header.buckets, _header.pilot_bits);
+}
+
+
+/*
+ Function: bucket
+ Parameters:
+  - hash: A key's seeded hash.
+ Return value: Its bucket. Hashes below dense_threshold (60% of them) go
+               to the first dense_buckets buckets (30% of them). The
+               choice within a part uses the low half of the hash, so it
+               is independent of the split.
+ */
+template <class Key, class Hash>
+inline std::uint64_t
+perfect_hash<Key, Hash>::bucket(std::uint64_t hash) const
+{
+    auto rotated = (hash << 32) | (hash >> 32);
+    if (hash < dense_threshold)
+        return reduce(rotated, _header.dense_buckets);
+    return _header.dense_buckets + reduce(rotated, _header.buckets - _header.dense_buckets);
+}
+
+
+/*
+ Function: reduce
+ Parameters:
+  - hash: A uniformly distributed 64 bit value.
+  - range: The size of the target range.
+ Return value: The high half of hash * range, which is uniform in
+               [0, range) without a division.
+ */
+template <class Key, class Hash>
+inline std::uint64_t
+perfect_hash<Key, Hash>::reduce(std::uint64_t hash, std::uint64_t range)
+{
+    __extension__ typedef unsigned __int128 wide;
+    return static_cast<std::uint64_t>((static_cast<wide>(hash) * range) >> 64);
+}
+
+
+/*
+ Function: read_packed / write_packed
+ Parameters:
+  - words: A packed array with one spare word at the end.
+  - i: An index into it.
+  - bits: The width of each entry, from 1 to 64.
+  - value: The value to store.
+ Return value: The entry at index i.
+
+ Description:
+    The spare word lets read_packed load two words unconditionally.
+ */
+template <class Key, class Hash>
+inline std::uint64_t
+perfect_hash<Key, Hash>::read_packed(const std::uint64_t* words, std::uint64_t i, std::uint64_t bits)
+{
+    auto bit = i * bits, word = bit / 64, shift = bit % 64;
+    auto mask = bits == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << bits) - 1;
+    auto low = words[word] >> shift;
+    auto high = (words[word + 1] << 1) << (63 - shift);
+    return (low | high) & mask;
+}
+
+template <class Key, class Hash>
+void
+perfect_hash<Key, Hash>::write_packed(std::uint64_t* words, std::uint64_t i, std::uint64_t bits, std::uint64_t value)
+{
+    auto bit = i * bits, word = bit / 64, shift = bit % 64;
+    words[word] |= value << shift;
+    if (shift + bits > 64)
+        words[word + 1] |= value >> (64 - shift);
+}
+
+
+/*
+ Function: width
+ Parameters:
+  - value: The largest value to store.
+ Return value: The number of bits it needs, at least 1.
+ */
+template <class Key, class Hash>
+std::uint64_t
+perfect_hash<Key, Hash>::width(std::uint64_t value)
+{
+    std::uint64_t bits = 1;
+    while (bits < 64 && value >> bits)
+        ++bits;
+    return bits;
+}
+
+
+
+// static_hash_map
+
+/*
+ Function: constructor
+ Parameters:
+  - first, last: (key, value) pairs with distinct keys.
+  - il: (key, value) pairs with distinct keys.
+  - rhs: The map to copy.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty map (defaulted in the class).
+  2. map of the pairs in [first, last). The buffer holds a header, the
+     perfect hash's own buffer, then the keys and the values, each stored
+     at its key's index.
+  3. map of the pairs in il.
+  4. copy of rhs. A copy of a view is a view of the same memory.
+
+ Complexity: Expected O(n log n) to build; linear to copy.
+
+ Exceptions:
+    Throws std::invalid_argument on duplicate keys.
+ */
+
+// 2. range
+template <class Key, class Value, class Hash, class KeyEqual>
+template <class InputIt>
+static_hash_map<Key, Value, Hash, KeyEqual>::static_hash_map(InputIt first, InputIt last)
+{
+    std::vector<std::pair<Key, Value>> pairs(first, last);
+    std::vector<Key> keys;
+    keys.reserve(pairs.size());
+    for (auto& kv : pairs)
+        keys.push_back(kv.first);
+
+    perfect_hash<Key, Hash> index(keys.begin(), keys.end());
+    Header header;
+    std::memcpy(header.magic, "phashmap", 8);
+    header.version = 1;
+    header.key_size = sizeof(Key);
+    header.value_size = sizeof(Value);
+    header.keys = pairs.size();
+    header.index_words = index.bytes() / sizeof(std::uint64_t);
+    header.words = header_words + header.index_words + array_words(pairs.size(), sizeof(Key))
+                 + array_words(pairs.size(), sizeof(Value));
+
+    std::vector<std::uint64_t> buffer(header.words, 0);
+    std::memcpy(buffer.data(), &header, sizeof(Header));
+    std::memcpy(buffer.data() + header_words, index.data(), index.bytes());
+    auto key_bytes = reinterpret_cast<char*>(buffer.data() + header_words + header.index_words);
+    auto value_bytes = reinterpret_cast<char*>(buffer.data() + header_words + header.index_words
+                                               + array_words(pairs.size(), sizeof(Key)));
+    for (auto& kv : pairs) {
+        auto i = index(kv.first);
+        std::memcpy(key_bytes + i * sizeof(Key), &kv.first, sizeof(Key));
+        std::memcpy(value_bytes + i * sizeof(Value), &kv.second, sizeof(Value));
+    }
+
+    _owned.swap(buffer);
+    attach(_owned.data(), bytes());
+}
+
+// 3. initializer list
+template <class Key, class Value, class Hash, class KeyEqual>
+static_hash_map<Key, Value, Hash, KeyEqual>::static_hash_map(std::initializer_list<std::pair<Key, Value>> il)
+    : static_hash_map(il.begin(), il.end())
+{}
+
+// 4. copy
+template <class Key, class Value, class Hash, class KeyEqual>
+static_hash_map<Key, Value, Hash, KeyEqual>::static_hash_map(const static_hash_map<Key, Value, Hash, KeyEqual>& rhs)
+    : _owned(rhs._owned)
+    , _equal(rhs._equal)
+{
+    if (rhs._data)
+        attach(_owned.empty() ? rhs._data : _owned.data(), rhs.bytes());
+}
+
+
+/*
+ Function: view
+ Parameters:
+  - data: A buffer produced by data(), aligned to 8 bytes, that outlives
+          the returned map.
+  - size: Its length in bytes.
+ Return value: A map reading the buffer in place.
+
+ Exceptions:
+    Throws std::runtime_error if the buffer is not a static_hash_map with
+    these key and value sizes.
+ */
+template <class Key, class Value, class Hash, class KeyEqual>
+static_hash_map<Key, Value, Hash, KeyEqual>
+static_hash_map<Key, Value, Hash, KeyEqual>::view(const void* data, size_type size)
+{
+    const Header* header = static_cast<const Header*>(data);
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t) || size < sizeof(Header)
+        || std::memcmp(header->magic, "phashmap", 8) || header->version != 1)
+        throw std::runtime_error("static_hash_map: not a static hash map buffer");
+    if (header->key_size != sizeof(Key) || header->value_size != sizeof(Value))
+        throw std::runtime_error("static_hash_map: key or value type does not match");
+
+    auto expected = header_words + header->index_words + array_words(header->keys, sizeof(Key))
+                  + array_words(header->keys, sizeof(Value));
+    if (header->words != expected || size < header->words * sizeof(std::uint64_t))
+        throw std::runtime_error("static_hash_map: truncated or inconsistent buffer");
+
+    static_hash_map<Key, Value, Hash, KeyEqual> result;
+    result.attach(static_cast<const std::uint64_t*>(data), size);
+    if (result._index.size() != header->keys)
+        throw std::runtime_error("static_hash_map: truncated or inconsistent buffer");
+    return result;
+}
+
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this map.
+ */
+template <class Key, class Value, class Hash, class KeyEqual>
+static_hash_map<Key, Value, Hash, KeyEqual>&
+static_hash_map<Key, Value, Hash, KeyEqual>::operator=(static_hash_map<Key, Value, Hash, KeyEqual> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+/*
+ Function: has / find / get
+ Parameters:
+  - key: The key to look for.
+  - value: Set to its value if it is present.
+ Return value: Whether key is present, or a pointer to its value in the
+               buffer (nullptr if absent).
+
+ Complexity: Constant.
+ */
+template <class Key, class Value, class Hash, class KeyEqual>
+bool
+static_hash_map<Key, Value, Hash, KeyEqual>::has(const_ref key) const
+{
+    return get(key) != nullptr;
+}
+
+template <class Key, class Value, class Hash, class KeyEqual>
+bool
+static_hash_map<Key, Value, Hash, KeyEqual>::find(const_ref key, Value& value) const
+{
+    auto found = get(key);
+    if (!found)
+        return false;
+
+    value = *found;
+    return true;
+}
+
+template <class Key, class Value, class Hash, class KeyEqual>
+inline const Value*
+static_hash_map<Key, Value, Hash, KeyEqual>::get(const_ref key) const
+{
+    if (!_keys)
+        return nullptr;
+
+    auto i = _index(key);
+    return i < _index.size() && _equal(_keys[i], key) ? _values + i : nullptr;
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - other: The map to exchange contents with.
+ */
+template <class Key, class Value, class Hash, class KeyEqual>
+void
+static_hash_map<Key, Value, Hash, KeyEqual>::swap(static_hash_map<Key, Value, Hash, KeyEqual>& other)
+{
+    using std::swap;
+    swap(_owned, other._owned);
+    swap(_data, other._data);
+    _index.swap(other._index);
+    swap(_keys, other._keys);
+    swap(_values, other._values);
+    swap(_equal, other._equal);
+}
+
+
+/*
+ Function: attach
+ Parameters:
+  - data: A validated buffer.
+  - size: Its length in bytes.
+ */
+template <class Key, class Value, class Hash, class KeyEqual>
+void
+static_hash_map<Key, Value, Hash, KeyEqual>::attach(const std::uint64_t* data, size_type size)
+{
+    const Header* header = reinterpret_cast<const Header*>(data);
+    _data = data;
+    _index = perfect_hash<Key, Hash>::view(data + header_words, size - header_words * sizeof(std::uint64_t));
+    _keys = reinterpret_cast<const Key*>(data + header_words + header->index_words);
+    _values = reinterpret_cast<const Value*>(data + header_words + header->index_words
+                                             + array_words(header->keys, sizeof(Key)));
+}
+
+
+} // end namespace
+
+#endif /* perfect_hash_h */
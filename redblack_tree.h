@@ -7,10 +7,25 @@
 #define redblack_tree_h
 
 
-#include <memory>   // allocator
-#include <stdio.h>
+#include <algorithm>   // max, adjacent_find
+#include <functional>  // function
+#include <iterator>    // distance
+#include <memory>      // allocator
+#include <stdexcept>   // invalid_argument
+
+// Per-node data a tree keeps up to date from each node's children. Node
+// derives from summary_type, and update(node) recomputes node's summary
+// from its element and its children's summaries; the tree calls it
+// bottom up on every node whose subtree changes, rotations included. The
+// default keeps nothing.
+struct redblack_plain {
+    struct summary_type {};
+
+    template <class Node>
+    static void update(Node*) {}
+};
 
-template <class T>
+template <class T, class Augment = redblack_plain>
 class redblack_tree {
 
 /* Type definitions */
@@ -25,8 +40,8 @@ public:
 
 
 /* Node definition */
-private:
-    struct Node {
+protected:
+    struct Node : Augment::summary_type {
         enum Colour { RED, BLACK };
 
         value_type data;
@@ -69,7 +84,7 @@ private:
    
 
 /* Data members */
-private:
+protected:
     Node* _root = nullptr;
     size_type _size = 0;
     std::allocator<Node> alloc;
@@ -81,19 +96,20 @@ private:
 public:
     /* Constructors */
     redblack_tree() = default;
-    redblack_tree(const redblack_tree<T>&);
-    redblack_tree(redblack_tree<T>&&);
+    redblack_tree(const redblack_tree&);
+    redblack_tree(redblack_tree&&);
     redblack_tree(std::initializer_list<T>);
-    ~redblack_tree() = default;
+    ~redblack_tree();
 
     /* Assignmnent */
-    redblack_tree<T>& operator=(const redblack_tree<T>&); 
-    redblack_tree<T>& operator=(redblack_tree<T>&&); 
-    redblack_tree<T>& operator=(std::initializer_list<T>); 
+    redblack_tree& operator=(const redblack_tree&); 
+    redblack_tree& operator=(redblack_tree&&); 
+    redblack_tree& operator=(std::initializer_list<T>); 
 
     /* Capacity */
     bool empty() const;
     size_type size() const;
+    size_type height() const;
 
     /* Element access */
     bool has(const_ref) const;
@@ -104,16 +120,21 @@ public:
     //void push(rvalue_ref);
     template <class... Args>
         void emplace(Args&&...);
-    void swap(redblack_tree<T>&);
+    void swap(redblack_tree&);
     void clear() noexcept;
 
     /* Operations */
     void remove(const_ref);
-    void merge(redblack_tree<T>&);
-    void merge(redblack_tree<T>&&);
+    void merge(redblack_tree&);
+    void merge(redblack_tree&&);
 
 /* Helper functions */
-private:
+protected:
+    template <class ForwardIt>
+        void build(ForwardIt, ForwardIt);
+    template <class ForwardIt>
+        Node* build(ForwardIt&, size_type, size_type, size_type, Node*);
+
     pointer find(const_ref);
     pointer find(rvalue_ref);
 
@@ -122,6 +143,7 @@ private:
     
     void rotate_left(Node*);
     void rotate_right(Node*);
+    void destroy(Node*);
 
     void insert_case1(Node*);
     void insert_case2(Node*);
@@ -135,9 +157,9 @@ public:
 
 
 #include <iostream>
-template <class T>
+template <class T, class Augment>
 void
-redblack_tree<T>::print() {
+redblack_tree<T, Augment>::print() {
     std::function<void (Node*, size_type)> helper = [&](Node* n, size_type count) {
         for (size_type i = 0; i < count; ++i) std::cout << "| ";
         std::cout << n->data << "\n";
@@ -152,18 +174,86 @@ redblack_tree<T>::print() {
     if (_root) helper(_root, 0);
 }
 
-template <class T>
+/*
+ Function: destructor
+ */
+template <class T, class Augment>
+redblack_tree<T, Augment>::~redblack_tree()
+{
+    clear();
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: Whether the tree is empty, or the number of elements.
+ */
+template <class T, class Augment>
+inline bool
+redblack_tree<T, Augment>::empty() const
+{
+    return _size == 0;
+}
+
+template <class T, class Augment>
+inline typename redblack_tree<T, Augment>::size_type
+redblack_tree<T, Augment>::size() const
+{
+    return _size;
+}
+
+
+/*
+ Function: height
+ Return value: The number of nodes on the longest root to leaf path.
+
+ Complexity: Linear.
+ */
+template <class T, class Augment>
+typename redblack_tree<T, Augment>::size_type
+redblack_tree<T, Augment>::height() const
+{
+    std::function<size_type (const Node*)> helper = [&](const Node* n) -> size_type {
+        return n ? 1 + std::max(helper(n->left), helper(n->right)) : 0;
+    };
+
+    return helper(_root);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: clear
+ Description: Removes every element.
+ */
+template <class T, class Augment>
+void
+redblack_tree<T, Augment>::clear() noexcept
+{
+    destroy(_root);
+    _root = nullptr;
+    _size = 0;
+}
+
+
+
+template <class T, class Augment>
 bool
-redblack_tree<T>::has(const_ref element) const
+redblack_tree<T, Augment>::has(const_ref element) const
 {
-    for (auto node = _root; _root;) {
-        switch (compare(element, node.data)) {
+    for (auto node = _root; node;) {
+        switch (compare(element, node->data)) {
         case -1:
-            node = node.left;
+            node = node->left;
             break;
 
         case 1:
-            node = node.right;
+            node = node->right;
             break;
 
         default:
@@ -176,18 +266,18 @@ redblack_tree<T>::has(const_ref element) const
 
 
 
-template <class T>
+template <class T, class Augment>
 bool
-redblack_tree<T>::has(rvalue_ref element) const
+redblack_tree<T, Augment>::has(rvalue_ref element) const
 {
     for (auto node = _root; node;) {
-        switch (compare(element, node.data)) {
+        switch (compare(element, node->data)) {
         case -1:
-            node = node.left;
+            node = node->left;
             break;
 
         case 1:
-            node = node.right;
+            node = node->right;
             break;
 
         default:
@@ -201,26 +291,29 @@ redblack_tree<T>::has(rvalue_ref element) const
 
 
 
-template <class T>
+template <class T, class Augment>
 void
-redblack_tree<T>::push(const_ref element)
+redblack_tree<T, Augment>::push(const_ref element)
 {
-    auto node = alloc.allocate(1);
-
     // If the tree is empty.
     if (!_root) {
+        auto node = alloc.allocate(1);
         alloc.construct(node, element, nullptr, Node::Colour::BLACK);
+        Augment::update(node);
         _root = node;
+        ++_size;
         return;
     }
 
     // Find the correct insertion spot.
     auto curr = _root;
+    Node* node = nullptr;
     bool added = false;
     while (!added) {
         switch (compare(element, curr->data)) {
         case -1:
             if (!curr->left) {
+                node = alloc.allocate(1);
                 alloc.construct(node, element, curr);
                 curr->left = node;
                 curr = curr->left;
@@ -233,6 +326,7 @@ redblack_tree<T>::push(const_ref element)
 
         case 1:
             if (!curr->right) {
+                node = alloc.allocate(1);
                 alloc.construct(node, element, curr);
                 curr->right = node;
                 curr = curr->right;
@@ -248,32 +342,105 @@ redblack_tree<T>::push(const_ref element)
         }
     }
 
+    ++_size;
+    for (auto up = curr; up; up = up->parent)
+        Augment::update(up);
     insert_case2(curr);
-    
 }
 
 
 
 // Helper functions
 
-template <class T>
-typename redblack_tree<T>::Node* 
-redblack_tree<T>::grandparent(Node* n) {
+/*
+ Function: build
+ Parameters:
+  - first, last: The new elements, strictly increasing.
+ Return value: None
+
+ Description:
+    Replaces the contents with a tree of the given elements. Each subtree
+    takes the middle of its range as its root, so every path from the
+    root ends within one level of the others; the nodes on the last,
+    partly filled level are red and the rest black, which gives every
+    path the same number of black nodes. Summaries are computed bottom
+    up as the nodes are linked.
+
+ Complexity: Linear.
+
+ Exceptions:
+    Throws std::invalid_argument, leaving the tree unchanged, if the
+    elements are not strictly increasing.
+ */
+template <class T, class Augment>
+template <class ForwardIt>
+void
+redblack_tree<T, Augment>::build(ForwardIt first, ForwardIt last)
+{
+    if (std::adjacent_find(first, last, [&](const_ref a, const_ref b) { return compare(a, b) >= 0; }) != last)
+        throw std::invalid_argument("redblack_tree::build: elements must be strictly increasing");
+
+    clear();
+    auto n = static_cast<size_type>(std::distance(first, last));
+    size_type full = 0;
+    while ((size_type(2) << full) - 1 <= n)
+        ++full;
+    _root = build(first, n, 0, full, nullptr);
+    _size = n;
+}
+
+/*
+ Builds the subtree of the next n elements at depth, advancing first past
+ them. Nodes at depth red_depth, the partly filled level, are red.
+ */
+template <class T, class Augment>
+template <class ForwardIt>
+typename redblack_tree<T, Augment>::Node*
+redblack_tree<T, Augment>::build(ForwardIt& first, size_type n, size_type depth, size_type red_depth, Node* parent)
+{
+    if (n == 0)
+        return nullptr;
+
+    auto left = build(first, (n - 1) / 2, depth + 1, red_depth, nullptr);
+    auto node = alloc.allocate(1);
+    alloc.construct(node, *first, parent, depth == red_depth ? Node::Colour::RED : Node::Colour::BLACK);
+    ++first;
+    node->left = left;
+    if (left)
+        left->parent = node;
+    node->right = build(first, n / 2, depth + 1, red_depth, node);
+    Augment::update(node);
+    return node;
+}
+
+
+template <class T, class Augment>
+typename redblack_tree<T, Augment>::Node* 
+redblack_tree<T, Augment>::grandparent(Node* n) {
     return (n->parent != nullptr ? n->parent->parent : nullptr);
 }
 
-template <class T>
-typename redblack_tree<T>::Node* 
-redblack_tree<T>::uncle(Node* n) {
+template <class T, class Augment>
+typename redblack_tree<T, Augment>::Node* 
+redblack_tree<T, Augment>::uncle(Node* n) {
     Node* g = grandparent(n);
     if (g == nullptr) return nullptr;
     return (n->parent == g->left ? g->right : g->left);
 }
 
-template <class T>
+template <class T, class Augment>
+void
+redblack_tree<T, Augment>::destroy(Node* n) {
+    if (!n) return;
+    destroy(n->left);
+    destroy(n->right);
+    alloc.destroy(n);
+    alloc.deallocate(n, 1);
+}
+
+template <class T, class Augment>
 void 
-redblack_tree<T>::rotate_left(Node* n) {
-    printf("Rotating left");
+redblack_tree<T, Augment>::rotate_left(Node* n) {
     n->right->parent = n->parent;
     if (n->parent) {
         if (n == n->parent->left) {
@@ -281,17 +448,20 @@ redblack_tree<T>::rotate_left(Node* n) {
         } else {
             n->parent->right = n->right;
         }
+    } else {
+        _root = n->right;
     }
     n->parent = n->right;
     n->right = n->parent->left;
-    n->right->parent = n;
+    if (n->right) n->right->parent = n;
     n->parent->left = n;
+    Augment::update(n);
+    Augment::update(n->parent);
 }
 
-template <class T>
+template <class T, class Augment>
 void 
-redblack_tree<T>::rotate_right(Node* n) {
-    printf("Rotating right");
+redblack_tree<T, Augment>::rotate_right(Node* n) {
     n->left->parent = n->parent;
     if (n->parent) {
         if (n == n->parent->left) {
@@ -299,16 +469,19 @@ redblack_tree<T>::rotate_right(Node* n) {
         } else {
             n->parent->right = n->left;
         }
+    } else {
+        _root = n->left;
     }
     n->parent = n->left;
     n->left = n->parent->right;
-    n->left->parent = n;
+    if (n->left) n->left->parent = n;
     n->parent->right = n;
+    Augment::update(n);
+    Augment::update(n->parent);
 }
 
-template <class T>
-void redblack_tree<T>::insert_case1(Node* n) {
-    printf("Inside insert case 1\n");
+template <class T, class Augment>
+void redblack_tree<T, Augment>::insert_case1(Node* n) {
     if (n->parent == nullptr) {
         n->colour = Node::Colour::BLACK;
     } else {
@@ -316,9 +489,8 @@ void redblack_tree<T>::insert_case1(Node* n) {
     }
 }
 
-template <class T>
-void redblack_tree<T>::insert_case2(Node* n) {
-    printf("Inside insert case 2\n");
+template <class T, class Augment>
+void redblack_tree<T, Augment>::insert_case2(Node* n) {
     if (n->parent->colour == Node::Colour::BLACK) {
         return;
     } else {
@@ -326,24 +498,22 @@ void redblack_tree<T>::insert_case2(Node* n) {
     }
 }
 
-template <class T>
-void redblack_tree<T>::insert_case3(Node* n) {
-    printf("Inside insert case 3\n");
+template <class T, class Augment>
+void redblack_tree<T, Augment>::insert_case3(Node* n) {
     Node* u = uncle(n);
     if (u != nullptr && u->colour == Node::Colour::RED) {
         n->parent->colour = Node::Colour::BLACK;
         u->colour = Node::Colour::BLACK;
         Node* g = grandparent(n);
         g->colour = Node::Colour::RED;
-        insert_case1(n);
+        insert_case1(g);
     } else {
         insert_case4(n);
     }
 }
 
-template <class T>
-void redblack_tree<T>::insert_case4(Node* n) {
-    printf("Inside insert case 4\n");
+template <class T, class Augment>
+void redblack_tree<T, Augment>::insert_case4(Node* n) {
     Node* g = grandparent(n);
     if (n == n->parent->right && n->parent == g->left) {
         rotate_left(n->parent);
@@ -355,9 +525,8 @@ void redblack_tree<T>::insert_case4(Node* n) {
     insert_case5(n);
 }
 
-template <class T>
-void redblack_tree<T>::insert_case5(Node* n) {
-    printf("Inside insert case 5\n");
+template <class T, class Augment>
+void redblack_tree<T, Augment>::insert_case5(Node* n) {
     Node* g = grandparent(n);
     n->parent->colour = Node::Colour::BLACK;
     g->colour = Node::Colour::RED;
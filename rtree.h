@@ -0,0 +1,1142 @@
+/*
+ File:   rtree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    An R-tree: a balanced tree of nested bounding boxes over a set of
+    boxes, answering "which boxes overlap this one (or contain this
+    point)?" while visiting only the branches whose bounds overlap it.
+    Loaded in bulk with Sort-Tile-Recursive packing, or grown and shrunk
+    one box at a time with the R* tree's insertion rules.
+
+ Implementation:
+  - Nodes hold up to 16 entries, and at least 6 unless they are the root
+    or were left underfull by bulk loading. Each node stores its entry
+    boxes as structure of arrays, one array of 16 per bound and
+    dimension, so an overlap test runs over all entries at once; for
+    float coordinates this is SSE2, four entries per instruction,
+    producing a bit mask of the entries to follow.
+  - As in btree.h, leaves and internal nodes are separate types sharing a
+    base, told apart by their level (0 for leaves), and there are no
+    parent pointers: insert and erase record the path on the way down.
+  - Insertion (Beckmann et al.): the subtree chosen is the one whose box
+    grows least, or, just above the leaves, whose overlap with its
+    siblings grows least. A full node first evicts the 5 entries farthest
+    from its centre and reinserts them, once per level per insertion;
+    only then does it split. The split picks the axis whose candidate
+    distributions have the least total margin, then the distribution on
+    it with the least overlap, then the least area.
+  - Erasing condenses the tree: an underfull node is removed and its
+    entries are reinserted at their own level, and a root left with one
+    child is replaced by it.
+  - Bulk loading (Leutenegger et al.) sorts entry centres along the
+    first dimension into slabs, each slab along the next dimension, and
+    so on, then packs runs into nodes, sizing the slabs and nodes of each
+    run evenly; the level above is packed the same way from the nodes'
+    boxes.
+  - Value must be default constructible and copy assignable; erase finds
+    entries with operator==.
+
+ TODO:
+  - Nearest-neighbour queries (best-first over node boxes).
+ */
+
+
+#ifndef rtree_h
+#define rtree_h
+
+#include <algorithm>   // sort, min, max
+#include <array>       // array
+#include <cmath>       // ceil, pow
+#include <cstdint>     // uint32_t
+#include <memory>      // allocator
+#include <utility>     // move, pair, swap
+#include <vector>      // vector
+
+#ifdef __SSE2__
+#include <emmintrin.h> // SSE2
+#endif
+
+namespace ads {
+
+// An axis-aligned box, bounds included.
+template <std::size_t Dim, class T>
+struct rtree_box {
+    std::array<T, Dim> low, high;
+
+    bool overlaps(const rtree_box& b) const
+    {
+        for (std::size_t d = 0; d < Dim; ++d)
+            if (b.high[d] < low[d] || high[d] < b.low[d])
+                return false;
+        return true;
+    }
+
+    bool contains(const rtree_box& b) const
+    {
+        for (std::size_t d = 0; d < Dim; ++d)
+            if (b.low[d] < low[d] || high[d] < b.high[d])
+                return false;
+        return true;
+    }
+
+    rtree_box merged(const rtree_box& b) const
+    {
+        rtree_box result;
+        for (std::size_t d = 0; d < Dim; ++d) {
+            result.low[d] = std::min(low[d], b.low[d]);
+            result.high[d] = std::max(high[d], b.high[d]);
+        }
+        return result;
+    }
+
+    double area() const
+    {
+        double a = 1;
+        for (std::size_t d = 0; d < Dim; ++d)
+            a *= static_cast<double>(high[d]) - static_cast<double>(low[d]);
+        return a;
+    }
+
+    double margin() const
+    {
+        double m = 0;
+        for (std::size_t d = 0; d < Dim; ++d)
+            m += static_cast<double>(high[d]) - static_cast<double>(low[d]);
+        return m;
+    }
+
+    double overlap(const rtree_box& b) const
+    {
+        double a = 1;
+        for (std::size_t d = 0; d < Dim; ++d) {
+            double lo = std::max<double>(low[d], b.low[d]), hi = std::min<double>(high[d], b.high[d]);
+            if (hi < lo)
+                return 0;
+            a *= hi - lo;
+        }
+        return a;
+    }
+
+    double centre(std::size_t d) const
+    {
+        return (static_cast<double>(low[d]) + static_cast<double>(high[d])) / 2;
+    }
+
+    bool operator==(const rtree_box& b) const { return low == b.low && high == b.high; }
+};
+
+
+// Overlap of one box against a node's entries: bit i of the result is set
+// if entry i overlaps. The general version tests entry by entry.
+template <class T, std::size_t Dim, std::size_t Slots>
+struct rtree_overlap {
+    static std::uint32_t mask(const T (&low)[Dim][Slots], const T (&high)[Dim][Slots], std::size_t n,
+                              const rtree_box<Dim, T>& q)
+    {
+        std::uint32_t result = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            bool hit = true;
+            for (std::size_t d = 0; d < Dim; ++d)
+                hit = hit && low[d][i] <= q.high[d] && q.low[d] <= high[d][i];
+            result |= static_cast<std::uint32_t>(hit) << i;
+        }
+        return result;
+    }
+};
+
+#ifdef __SSE2__
+// Four float entries per step. Slots past n hold stale boxes and are
+// masked off at the end.
+template <std::size_t Dim, std::size_t Slots>
+struct rtree_overlap<float, Dim, Slots> {
+    static_assert(Slots % 4 == 0, "rtree node slots must be a multiple of four");
+
+    static std::uint32_t mask(const float (&low)[Dim][Slots], const float (&high)[Dim][Slots], std::size_t n,
+                              const rtree_box<Dim, float>& q)
+    {
+        std::uint32_t result = 0;
+        for (std::size_t i = 0; i < n; i += 4) {
+            auto hit = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (std::size_t d = 0; d < Dim; ++d) {
+                hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_loadu_ps(&low[d][i]), _mm_set1_ps(q.high[d])));
+                hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_set1_ps(q.low[d]), _mm_loadu_ps(&high[d][i])));
+            }
+            result |= static_cast<std::uint32_t>(_mm_movemask_ps(hit)) << i;
+        }
+        return result & ((std::uint32_t(1) << n) - 1);
+    }
+};
+#endif
+
+
+template <std::size_t Dim = 2, class T = float, class Value = std::size_t, class Alloc = std::allocator<Value>>
+class rtree {
+
+/* Type definitions */
+public:
+    typedef std::size_t                     size_type;
+    typedef rtree_box<Dim, T>               box_type;
+    typedef std::array<T, Dim>              point_type;
+    typedef std::pair<box_type, Value>      value_type;
+
+
+/* Node definitions */
+private:
+    static constexpr size_type max_entries = 16;
+    static constexpr size_type min_entries = 6;
+    static constexpr size_type reinsert_entries = 5;
+
+    struct Node {
+        size_type count = 0;
+        T low[Dim][max_entries];
+        T high[Dim][max_entries];
+    };
+
+    struct Leaf : Node {
+        Value values[max_entries];
+    };
+
+    struct Internal : Node {
+        Node* children[max_entries];
+    };
+
+    // An entry on its way into a node: a value at level 0, a child above.
+    struct item {
+        box_type box;
+        Node* child;
+        Value value;
+    };
+
+    typedef std::vector<std::pair<Internal*, size_type>> path_type;
+
+    typedef typename Alloc::template rebind<Leaf>::other leaf_alloc;
+    typedef typename Alloc::template rebind<Internal>::other internal_alloc;
+
+
+/* Data members */
+private:
+    Node* _root = nullptr;
+    size_type _size = 0;
+    unsigned _height = 0;          // Levels, counting the leaves.
+    size_type _nodes = 0;
+    leaf_alloc _leaf_alloc;
+    internal_alloc _internal_alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    rtree() = default;
+    explicit rtree(const std::vector<value_type>&);
+    rtree(const rtree&);
+    rtree(rtree&&);
+    ~rtree();
+
+    /* Assignment */
+    rtree& operator=(rtree);
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    unsigned height() const;
+    size_type nodes() const;
+    box_type bounds() const;
+
+    /* Modifiers */
+    void insert(const box_type&, const Value&);
+    bool erase(const box_type&, const Value&);
+    void bulk_load(std::vector<value_type>);
+    void swap(rtree&);
+    void clear() noexcept;
+
+    /* Operations */
+    template <class F>
+        size_type query(const box_type&, F&&) const;
+    std::vector<Value> query(const box_type&) const;
+    std::vector<Value> query(const point_type&) const;
+
+/* Helper functions */
+private:
+    Leaf* create_leaf();
+    Internal* create_internal();
+    void destroy(Node*, unsigned);
+    Node* clone(const Node*, unsigned);
+
+    static box_type box_at(const Node*, size_type);
+    static box_type node_bounds(const Node*);
+    static item item_at(const Node*, size_type, unsigned);
+    static void put(Node*, size_type, const item&, unsigned);
+    static void remove_at(Node*, size_type, unsigned);
+    static void refresh(path_type&, size_type);
+
+    size_type choose_subtree(const Internal*, const box_type&, unsigned) const;
+    void insert_item(const item&, unsigned, std::vector<bool>&);
+    void overflow(Node*, unsigned, const item&, path_type&, std::vector<bool>&);
+    static size_type split(std::vector<item>&);
+    bool remove(Node*, unsigned, const box_type&, const Value&, std::vector<std::pair<item, unsigned>>&);
+    void pack(std::vector<item>&, size_type, size_type, size_type, std::vector<item>&, unsigned);
+    template <class F>
+        void search(const Node*, unsigned, const box_type&, F&, size_type&) const;
+};
+
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+constexpr typename rtree<Dim, T, Value, Alloc>::size_type rtree<Dim, T, Value, Alloc>::max_entries;
+template <std::size_t Dim, class T, class Value, class Alloc>
+constexpr typename rtree<Dim, T, Value, Alloc>::size_type rtree<Dim, T, Value, Alloc>::min_entries;
+template <std::size_t Dim, class T, class Value, class Alloc>
+constexpr typename rtree<Dim, T, Value, Alloc>::size_type rtree<Dim, T, Value, Alloc>::reinsert_entries;
+
+
+
+// Node management
+
+/*
+ Function: create_leaf / create_internal / destroy / clone
+ Parameters:
+  - node: The root of the subtree to free or copy.
+  - level: The node's height above the leaves (0 for a leaf).
+
+ Description:
+    Nodes are allocated through Alloc and counted for nodes(). destroy
+    and clone recurse once per level, which is only a few deep.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+typename rtree<Dim, T, Value, Alloc>::Leaf*
+rtree<Dim, T, Value, Alloc>::create_leaf()
+{
+    auto leaf = _leaf_alloc.allocate(1);
+    try {
+        ::new (static_cast<void*>(leaf)) Leaf();
+    } catch (...) {
+        _leaf_alloc.deallocate(leaf, 1);
+        throw;
+    }
+
+    ++_nodes;
+    return leaf;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+typename rtree<Dim, T, Value, Alloc>::Internal*
+rtree<Dim, T, Value, Alloc>::create_internal()
+{
+    auto node = _internal_alloc.allocate(1);
+    ::new (static_cast<void*>(node)) Internal();
+    ++_nodes;
+    return node;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::destroy(Node* node, unsigned level)
+{
+    if (level == 0) {
+        auto leaf = static_cast<Leaf*>(node);
+        leaf->~Leaf();
+        _leaf_alloc.deallocate(leaf, 1);
+        --_nodes;
+        return;
+    }
+
+    auto internal = static_cast<Internal*>(node);
+    for (size_type i = 0; i < internal->count; ++i)
+        destroy(internal->children[i], level - 1);
+
+    internal->~Internal();
+    _internal_alloc.deallocate(internal, 1);
+    --_nodes;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+typename rtree<Dim, T, Value, Alloc>::Node*
+rtree<Dim, T, Value, Alloc>::clone(const Node* node, unsigned level)
+{
+    if (level == 0) {
+        auto leaf = create_leaf();
+        static_cast<Node&>(*leaf) = *node;
+        for (size_type i = 0; i < node->count; ++i)
+            leaf->values[i] = static_cast<const Leaf*>(node)->values[i];
+        return leaf;
+    }
+
+    auto internal = create_internal();
+    static_cast<Node&>(*internal) = *node;
+    internal->count = 0;
+    try {
+        for (; internal->count < node->count; ++internal->count)
+            internal->children[internal->count] = clone(static_cast<const Internal*>(node)->children[internal->count], level - 1);
+    } catch (...) {
+        destroy(internal, level);
+        throw;
+    }
+    return internal;
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - entries: (box, value) pairs to bulk load.
+  - rhs: The tree being copied or moved from.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty tree (defaulted in the class).
+  2. tree of entries, bulk loaded.
+  3. deep copy of rhs.
+  4. tree holding rhs's nodes, leaving rhs empty.
+
+ Complexity:
+  2. O(n log n).
+  3. Linear.
+  4. Constant.
+ */
+
+// 2. bulk load
+template <std::size_t Dim, class T, class Value, class Alloc>
+rtree<Dim, T, Value, Alloc>::rtree(const std::vector<value_type>& entries)
+{
+    bulk_load(entries);
+}
+
+// 3. copy
+template <std::size_t Dim, class T, class Value, class Alloc>
+rtree<Dim, T, Value, Alloc>::rtree(const rtree& rhs)
+    : _size(rhs._size)
+    , _height(rhs._height)
+    , _leaf_alloc(rhs._leaf_alloc)
+    , _internal_alloc(rhs._internal_alloc)
+{
+    if (rhs._root)
+        _root = clone(rhs._root, _height - 1);
+}
+
+// 4. move
+template <std::size_t Dim, class T, class Value, class Alloc>
+rtree<Dim, T, Value, Alloc>::rtree(rtree&& rhs)
+{
+    swap(rhs);
+}
+
+
+/*
+ Function: destructor
+ Description:
+    Frees every node.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+rtree<Dim, T, Value, Alloc>::~rtree()
+{
+    clear();
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: The tree to copy or move, already taken by value.
+ Return value: This tree.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+rtree<Dim, T, Value, Alloc>&
+rtree<Dim, T, Value, Alloc>::operator=(rtree rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size / height / nodes / bounds
+ Return value: Whether the tree holds no entries, how many it holds, its
+               levels counting the leaves, its node count, and the box
+               bounding every entry (meaningless when empty).
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline bool
+rtree<Dim, T, Value, Alloc>::empty() const
+{
+    return _size == 0;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline typename rtree<Dim, T, Value, Alloc>::size_type
+rtree<Dim, T, Value, Alloc>::size() const
+{
+    return _size;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline unsigned
+rtree<Dim, T, Value, Alloc>::height() const
+{
+    return _height;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline typename rtree<Dim, T, Value, Alloc>::size_type
+rtree<Dim, T, Value, Alloc>::nodes() const
+{
+    return _nodes;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+typename rtree<Dim, T, Value, Alloc>::box_type
+rtree<Dim, T, Value, Alloc>::bounds() const
+{
+    return _root && _root->count ? node_bounds(_root) : box_type();
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert
+ Parameters:
+  - box: The entry's box, low no greater than high in every dimension.
+  - value: Its value. Equal entries may be inserted more than once.
+ Return value: None
+
+ Complexity: O(log n) nodes touched, each in O(M^2) for M entries per
+             node, plus the occasional reinsertion.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::insert(const box_type& box, const Value& value)
+{
+    if (!_root) {
+        _root = create_leaf();
+        _height = 1;
+    }
+
+    std::vector<bool> reinserted(_height, false);
+    insert_item(item{box, nullptr, value}, 0, reinserted);
+    ++_size;
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - box, value: The entry to remove; box must match exactly.
+ Return value: Whether such an entry was found. One of several equal
+               entries is removed.
+
+ Complexity: O(n) at worst, usually O(log n) when entries overlap
+             little.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+bool
+rtree<Dim, T, Value, Alloc>::erase(const box_type& box, const Value& value)
+{
+    if (!_root)
+        return false;
+
+    std::vector<std::pair<item, unsigned>> orphans;
+    if (!remove(_root, _height - 1, box, value, orphans))
+        return false;
+    --_size;
+
+    for (auto& orphan : orphans) {
+        std::vector<bool> reinserted(_height, false);
+        insert_item(orphan.first, orphan.second, reinserted);
+    }
+
+    while (_height > 1 && _root->count == 1) {
+        auto old = static_cast<Internal*>(_root);
+        _root = old->children[0];
+        old->~Internal();
+        _internal_alloc.deallocate(old, 1);
+        --_nodes;
+        --_height;
+    }
+    if (_size == 0)
+        clear();
+    return true;
+}
+
+
+/*
+ Function: bulk_load
+ Parameters:
+  - entries: (box, value) pairs to replace the contents with.
+ Return value: None
+
+ Description:
+    Sort-Tile-Recursive packing, level by level from the leaves up.
+
+ Complexity: O(n log n).
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::bulk_load(std::vector<value_type> entries)
+{
+    clear();
+    if (entries.empty())
+        return;
+
+    std::vector<item> items, parents;
+    items.reserve(entries.size());
+    for (auto& e : entries)
+        items.push_back(item{e.first, nullptr, std::move(e.second)});
+    _size = items.size();
+
+    for (unsigned level = 0; ; ++level) {
+        parents.clear();
+        pack(items, 0, items.size(), 0, parents, level);
+        _height = level + 1;
+        if (parents.size() == 1) {
+            _root = parents[0].child;
+            return;
+        }
+        items.swap(parents);
+    }
+}
+
+
+/*
+ Function: swap / clear
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::swap(rtree& rhs)
+{
+    using std::swap;
+    swap(_root, rhs._root);
+    swap(_size, rhs._size);
+    swap(_height, rhs._height);
+    swap(_nodes, rhs._nodes);
+    swap(_leaf_alloc, rhs._leaf_alloc);
+    swap(_internal_alloc, rhs._internal_alloc);
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::clear() noexcept
+{
+    if (_root)
+        destroy(_root, _height - 1);
+    _root = nullptr;
+    _size = 0;
+    _height = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: query
+ Parameters:
+  - box: The box to test against; a point is a box with low == high.
+  - f: Called as f(box, value) for every entry overlapping box.
+ Return value:
+  1. The number of candidates: entry boxes, in nodes and leaves, that
+     were tested against box.
+  2, 3. The values of the entries overlapping box or containing point.
+
+ Complexity: O(log n + k) for k results when entries overlap little;
+             O(n) at worst.
+ */
+
+// 1. visitor
+template <std::size_t Dim, class T, class Value, class Alloc>
+template <class F>
+typename rtree<Dim, T, Value, Alloc>::size_type
+rtree<Dim, T, Value, Alloc>::query(const box_type& box, F&& f) const
+{
+    size_type candidates = 0;
+    if (_root)
+        search(_root, _height - 1, box, f, candidates);
+    return candidates;
+}
+
+// 2. box
+template <std::size_t Dim, class T, class Value, class Alloc>
+std::vector<Value>
+rtree<Dim, T, Value, Alloc>::query(const box_type& box) const
+{
+    std::vector<Value> result;
+    query(box, [&](const box_type&, const Value& value) { result.push_back(value); });
+    return result;
+}
+
+// 3. point
+template <std::size_t Dim, class T, class Value, class Alloc>
+std::vector<Value>
+rtree<Dim, T, Value, Alloc>::query(const point_type& point) const
+{
+    return query(box_type{point, point});
+}
+
+
+
+// Helper functions
+
+/*
+ Function: box_at / node_bounds / item_at / put / remove_at
+ Description:
+    Entry access across the structure of arrays: entry i's box, the box
+    bounding all of a node's entries, entry i as an item, storing an item
+    at slot i, and removing slot i by moving the last entry into it.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline typename rtree<Dim, T, Value, Alloc>::box_type
+rtree<Dim, T, Value, Alloc>::box_at(const Node* node, size_type i)
+{
+    box_type box;
+    for (size_type d = 0; d < Dim; ++d) {
+        box.low[d] = node->low[d][i];
+        box.high[d] = node->high[d][i];
+    }
+    return box;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+typename rtree<Dim, T, Value, Alloc>::box_type
+rtree<Dim, T, Value, Alloc>::node_bounds(const Node* node)
+{
+    box_type box = box_at(node, 0);
+    for (size_type d = 0; d < Dim; ++d) {
+        for (size_type i = 1; i < node->count; ++i) {
+            box.low[d] = std::min(box.low[d], node->low[d][i]);
+            box.high[d] = std::max(box.high[d], node->high[d][i]);
+        }
+    }
+    return box;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline typename rtree<Dim, T, Value, Alloc>::item
+rtree<Dim, T, Value, Alloc>::item_at(const Node* node, size_type i, unsigned level)
+{
+    if (level == 0)
+        return item{box_at(node, i), nullptr, static_cast<const Leaf*>(node)->values[i]};
+    return item{box_at(node, i), static_cast<const Internal*>(node)->children[i], Value()};
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline void
+rtree<Dim, T, Value, Alloc>::put(Node* node, size_type i, const item& it, unsigned level)
+{
+    for (size_type d = 0; d < Dim; ++d) {
+        node->low[d][i] = it.box.low[d];
+        node->high[d][i] = it.box.high[d];
+    }
+    if (level == 0)
+        static_cast<Leaf*>(node)->values[i] = it.value;
+    else
+        static_cast<Internal*>(node)->children[i] = it.child;
+}
+
+template <std::size_t Dim, class T, class Value, class Alloc>
+inline void
+rtree<Dim, T, Value, Alloc>::remove_at(Node* node, size_type i, unsigned level)
+{
+    auto last = --node->count;
+    if (i != last)
+        put(node, i, item_at(node, last, level), level);
+}
+
+
+/*
+ Function: refresh
+ Parameters:
+  - path: (node, child index) pairs from the root down.
+  - depth: How many of them, from the root, to update.
+
+ Description:
+    Recomputes each recorded child's box in its parent, bottom up.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::refresh(path_type& path, size_type depth)
+{
+    for (auto j = depth; j-- > 0;) {
+        auto parent = path[j].first;
+        auto i = path[j].second;
+        auto box = node_bounds(parent->children[i]);
+        for (size_type d = 0; d < Dim; ++d) {
+            parent->low[d][i] = box.low[d];
+            parent->high[d][i] = box.high[d];
+        }
+    }
+}
+
+
+/*
+ Function: choose_subtree
+ Parameters:
+  - node: The internal node to descend from.
+  - box: The box being inserted.
+  - level: node's level.
+ Return value: The child to descend into: least overlap enlargement just
+               above the leaves, least area enlargement elsewhere, ties
+               going to the smaller area.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+typename rtree<Dim, T, Value, Alloc>::size_type
+rtree<Dim, T, Value, Alloc>::choose_subtree(const Internal* node, const box_type& box, unsigned level) const
+{
+    box_type boxes[max_entries];
+    double areas[max_entries];
+    for (size_type i = 0; i < node->count; ++i) {
+        boxes[i] = box_at(node, i);
+        areas[i] = boxes[i].area();
+    }
+
+    // A child that already contains the box grows neither in area nor in
+    // overlap, so the smallest such child wins outright.
+    size_type best = max_entries;
+    for (size_type i = 0; i < node->count; ++i)
+        if (boxes[i].contains(box) && (best == max_entries || areas[i] < areas[best]))
+            best = i;
+    if (best != max_entries)
+        return best;
+
+    best = 0;
+    double best_overlap = 0, best_growth = 0, best_area = 0;
+    for (size_type i = 0; i < node->count; ++i) {
+        auto grown = boxes[i].merged(box);
+        double area = areas[i], growth = grown.area() - area, overlap = 0;
+        if (level == 1) {
+            for (size_type j = 0; j < node->count; ++j)
+                if (j != i)
+                    overlap += grown.overlap(boxes[j]) - boxes[i].overlap(boxes[j]);
+        }
+        if (i == 0 || overlap < best_overlap || (overlap == best_overlap
+            && (growth < best_growth || (growth == best_growth && area < best_area)))) {
+            best = i;
+            best_overlap = overlap;
+            best_growth = growth;
+            best_area = area;
+        }
+    }
+    return best;
+}
+
+
+/*
+ Function: insert_item
+ Parameters:
+  - it: The entry to insert.
+  - level: The level of the node it belongs in: 0 for values, higher for
+           subtrees being reinserted.
+  - reinserted: For each level, whether an overflow there has already
+                reinserted entries during this insertion.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::insert_item(const item& it, unsigned level, std::vector<bool>& reinserted)
+{
+    path_type path;
+    Node* node = _root;
+    for (auto l = _height - 1; l > level; --l) {
+        auto internal = static_cast<Internal*>(node);
+        auto i = choose_subtree(internal, it.box, l);
+        path.emplace_back(internal, i);
+        node = internal->children[i];
+    }
+
+    if (node->count < max_entries) {
+        put(node, node->count++, it, level);
+        refresh(path, path.size());
+        return;
+    }
+    overflow(node, level, it, path, reinserted);
+}
+
+
+/*
+ Function: overflow
+ Parameters:
+  - node: A full node at the end of path.
+  - level: node's level.
+  - it: The entry that does not fit.
+  - path: The path to node.
+  - reinserted: As for insert_item.
+
+ Description:
+    Below the root, the first overflow at each level evicts the entries
+    farthest from the node's centre and reinserts them, nearest first.
+    Otherwise the node splits, and the new sibling goes into the parent,
+    which may overflow in turn; a root split grows the tree.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::overflow(Node* node, unsigned level, const item& it, path_type& path,
+                                      std::vector<bool>& reinserted)
+{
+    std::vector<item> items;
+    items.reserve(max_entries + 1);
+    for (size_type i = 0; i < node->count; ++i)
+        items.push_back(item_at(node, i, level));
+    items.push_back(it);
+
+    if (level + 1 < _height && !reinserted[level]) {
+        reinserted[level] = true;
+
+        box_type all = items[0].box;
+        for (auto& x : items)
+            all = all.merged(x.box);
+        auto far = [&all](const item& x) {
+            double sum = 0;
+            for (size_type d = 0; d < Dim; ++d)
+                sum += (x.box.centre(d) - all.centre(d)) * (x.box.centre(d) - all.centre(d));
+            return sum;
+        };
+        std::sort(items.begin(), items.end(), [&far](const item& a, const item& b) { return far(a) > far(b); });
+
+        node->count = 0;
+        for (auto i = reinsert_entries; i < items.size(); ++i)
+            put(node, node->count++, items[i], level);
+        refresh(path, path.size());
+
+        for (auto i = reinsert_entries; i-- > 0;)
+            insert_item(items[i], level, reinserted);
+        return;
+    }
+
+    auto cut = split(items);
+    Node* sibling = level == 0 ? static_cast<Node*>(create_leaf()) : create_internal();
+    node->count = 0;
+    for (size_type i = 0; i < cut; ++i)
+        put(node, node->count++, items[i], level);
+    for (auto i = cut; i < items.size(); ++i)
+        put(sibling, sibling->count++, items[i], level);
+
+    item up {node_bounds(sibling), sibling, Value()};
+    if (path.empty()) {
+        auto root = create_internal();
+        put(root, root->count++, item{node_bounds(node), node, Value()}, level + 1);
+        put(root, root->count++, up, level + 1);
+        _root = root;
+        ++_height;
+        reinserted.push_back(false);
+        return;
+    }
+
+    refresh(path, path.size());
+    auto parent = path.back().first;
+    path.pop_back();
+    if (parent->count < max_entries) {
+        put(parent, parent->count++, up, level + 1);
+        refresh(path, path.size());
+        return;
+    }
+    overflow(parent, level + 1, up, path, reinserted);
+}
+
+
+/*
+ Function: split
+ Parameters:
+  - items: The M + 1 entries of an overflowing node, reordered in place.
+ Return value: The split point: [0, cut) stays, [cut, end) moves out.
+
+ Description:
+    The R* split. For each axis the entries are sorted by lower and by
+    upper bound, and every distribution leaving at least min_entries on
+    each side is scored; the axis with the least total margin wins, and
+    on it the distribution with the least overlap, then least area.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+typename rtree<Dim, T, Value, Alloc>::size_type
+rtree<Dim, T, Value, Alloc>::split(std::vector<item>& items)
+{
+    const size_type n = items.size();
+    std::vector<box_type> prefix(n), suffix(n);
+    auto bounds = [&] {
+        prefix[0] = items[0].box;
+        for (size_type i = 1; i < n; ++i)
+            prefix[i] = prefix[i - 1].merged(items[i].box);
+        suffix[n - 1] = items[n - 1].box;
+        for (auto i = n - 1; i-- > 0;)
+            suffix[i] = suffix[i + 1].merged(items[i].box);
+    };
+    auto sort_by = [&](size_type d, bool upper) {
+        std::sort(items.begin(), items.end(), [d, upper](const item& a, const item& b) {
+            return upper ? a.box.high[d] < b.box.high[d] : a.box.low[d] < b.box.low[d];
+        });
+    };
+
+    size_type axis = 0;
+    double best_margin = 0;
+    for (size_type d = 0; d < Dim; ++d) {
+        double margin = 0;
+        for (bool upper : {false, true}) {
+            sort_by(d, upper);
+            bounds();
+            for (auto k = min_entries; k + min_entries <= n; ++k)
+                margin += prefix[k - 1].margin() + suffix[k].margin();
+        }
+        if (d == 0 || margin < best_margin) {
+            axis = d;
+            best_margin = margin;
+        }
+    }
+
+    bool best_upper = false;
+    size_type best_cut = min_entries;
+    double best_overlap = 0, best_area = 0;
+    bool first = true;
+    for (bool upper : {false, true}) {
+        sort_by(axis, upper);
+        bounds();
+        for (auto k = min_entries; k + min_entries <= n; ++k) {
+            double overlap = prefix[k - 1].overlap(suffix[k]), area = prefix[k - 1].area() + suffix[k].area();
+            if (first || overlap < best_overlap || (overlap == best_overlap && area < best_area)) {
+                first = false;
+                best_upper = upper;
+                best_cut = k;
+                best_overlap = overlap;
+                best_area = area;
+            }
+        }
+    }
+
+    sort_by(axis, best_upper);
+    return best_cut;
+}
+
+
+/*
+ Function: remove
+ Parameters:
+  - node: The subtree to search.
+  - level: Its level.
+  - box, value: The entry to remove.
+  - orphans: Where to put the entries of nodes dissolved for being
+             underfull, with the level each belongs at.
+ Return value: Whether the entry was found and removed below node.
+
+ Description:
+    Descends into every child whose box contains box. On the way back up
+    from a removal, a child left underfull is dissolved into orphans and
+    any other child's box is tightened.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+bool
+rtree<Dim, T, Value, Alloc>::remove(Node* node, unsigned level, const box_type& box, const Value& value,
+                                    std::vector<std::pair<item, unsigned>>& orphans)
+{
+    if (level == 0) {
+        auto leaf = static_cast<Leaf*>(node);
+        for (size_type i = 0; i < leaf->count; ++i) {
+            if (leaf->values[i] == value && box_at(leaf, i) == box) {
+                remove_at(leaf, i, 0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto internal = static_cast<Internal*>(node);
+    for (size_type i = 0; i < internal->count; ++i) {
+        auto child = internal->children[i];
+        if (!box_at(internal, i).contains(box) || !remove(child, level - 1, box, value, orphans))
+            continue;
+
+        if (child->count < min_entries) {
+            for (size_type j = 0; j < child->count; ++j)
+                orphans.emplace_back(item_at(child, j, level - 1), level - 1);
+            child->count = 0;
+            destroy(child, level - 1);
+            remove_at(internal, i, level);
+        } else {
+            auto tight = node_bounds(child);
+            for (size_type d = 0; d < Dim; ++d) {
+                internal->low[d][i] = tight.low[d];
+                internal->high[d][i] = tight.high[d];
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+
+/*
+ Function: pack
+ Parameters:
+  - items: The entries of one level, reordered in place.
+  - first, last: The run to pack.
+  - dim: The dimension to sort this run along.
+  - parents: Where to append an item for each node made.
+  - level: The level of the nodes being made.
+
+ Description:
+    One step of Sort-Tile-Recursive: sorts the run by centre along dim
+    and cuts it into evenly sized slabs, each packed along the next
+    dimension, or, along the last dimension, into evenly sized nodes.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+void
+rtree<Dim, T, Value, Alloc>::pack(std::vector<item>& items, size_type first, size_type last, size_type dim,
+                                  std::vector<item>& parents, unsigned level)
+{
+    const size_type n = last - first, nodes = (n + max_entries - 1) / max_entries;
+    std::sort(items.begin() + static_cast<std::ptrdiff_t>(first), items.begin() + static_cast<std::ptrdiff_t>(last),
+              [dim](const item& a, const item& b) { return a.box.centre(dim) < b.box.centre(dim); });
+
+    if (dim + 1 == Dim) {
+        for (size_type j = 0; j < nodes; ++j) {
+            auto lo = first + n * j / nodes, hi = first + n * (j + 1) / nodes;
+            Node* node = level == 0 ? static_cast<Node*>(create_leaf()) : create_internal();
+            for (auto i = lo; i < hi; ++i)
+                put(node, node->count++, items[i], level);
+            parents.push_back(item{node_bounds(node), node, Value()});
+        }
+        return;
+    }
+
+    auto slabs = static_cast<size_type>(std::ceil(std::pow(static_cast<double>(nodes), 1.0 / static_cast<double>(Dim - dim))));
+    slabs = std::max<size_type>(1, std::min(slabs, nodes));
+    for (size_type j = 0; j < slabs; ++j)
+        pack(items, first + n * j / slabs, first + n * (j + 1) / slabs, dim + 1, parents, level);
+}
+
+
+/*
+ Function: search
+ Parameters:
+  - node: The subtree to search.
+  - level: Its level.
+  - box: The query box.
+  - f: The visitor.
+  - candidates: Incremented by the entries tested.
+ */
+template <std::size_t Dim, class T, class Value, class Alloc>
+template <class F>
+void
+rtree<Dim, T, Value, Alloc>::search(const Node* node, unsigned level, const box_type& box, F& f,
+                                    size_type& candidates) const
+{
+    candidates += node->count;
+    auto hits = rtree_overlap<T, Dim, max_entries>::mask(node->low, node->high, node->count, box);
+    for (; hits; hits &= hits - 1) {
+        auto i = static_cast<size_type>(__builtin_ctz(hits));
+        if (level == 0)
+            f(box_at(node, i), static_cast<const Leaf*>(node)->values[i]);
+        else
+            search(static_cast<const Internal*>(node)->children[i], level - 1, box, f, candidates);
+    }
+}
+
+
+} // end namespace
+
+#endif /* rtree_h */
@@ -0,0 +1,448 @@
+/*
+ File:   shortest_path.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Single-source shortest paths over a weighted csr_graph: Dijkstra on
+    the decrease-key indexed_heap, Dijkstra on a radix_heap for integer
+    weights, A* toward one target, and delta-stepping on a thread_pool.
+    Weights must not be negative.
+
+ Implementation:
+  - Integer weights are summed in uint64_t and floating ones in double,
+    so a long path cannot overflow a narrow weight type.
+  - dijkstra keeps each unsettled vertex in the heap at most once and
+    lowers its key in place. dijkstra_radix pushes a new entry on every
+    improvement instead and skips the stale ones when they surface; the
+    radix heap's pushes are constant time, and Dijkstra's popped
+    distances never decrease, which is all a radix heap asks.
+  - a_star is dijkstra ordered by distance plus heuristic, stopping once
+    the target is settled. A vertex improved after it was settled goes
+    back into the heap, so an admissible but inconsistent heuristic still
+    finds a shortest path.
+  - delta_stepping (Meyer and Sanders) keeps buckets of width delta. The
+    lowest non-empty bucket is emptied repeatedly, relaxing light edges
+    (weight at most delta) of all its vertices in parallel, since those
+    can land back in it; then the heavy edges of every vertex it settled
+    are relaxed once. Distances are atomics read without locking to
+    discard useless relaxations; an improvement takes a per-vertex spin
+    flag so that distance and parent change together. Buckets are filled
+    on the calling thread and may hold stale or repeated entries, which
+    are filtered out when the bucket is taken.
+
+ TODO:
+  - Bidirectional Dijkstra, which needs weights on incoming edges.
+ */
+
+
+#ifndef shortest_path_h
+#define shortest_path_h
+
+#include <atomic>       // atomic
+#include <cstdint>      // uint64_t
+#include <functional>   // greater
+#include <limits>       // numeric_limits
+#include <memory>       // unique_ptr
+#include <stdexcept>    // out_of_range, logic_error, invalid_argument
+#include <string>       // string
+#include <type_traits>  // conditional, is_integral
+#include <vector>       // vector
+
+#include "csr_graph.h"
+#include "heap.h"
+#include "thread_pool.h"
+
+namespace ads {
+
+// The type path lengths over Weight are summed in.
+template <class Weight>
+using path_distance = typename std::conditional<std::is_integral<Weight>::value, std::uint64_t, double>::type;
+
+
+template <class Vertex, class Weight>
+struct shortest_paths {
+
+/* Type definitions */
+    typedef path_distance<Weight> distance_type;
+
+    static constexpr distance_type unreachable = std::numeric_limits<distance_type>::max();
+
+
+/* Data members */
+    std::vector<distance_type> distance;    // unreachable where not reached.
+    std::vector<Vertex> parent;             // The source is its own parent; none where not reached.
+
+
+/* Member functions */
+    bool reached(Vertex) const;
+    std::vector<Vertex> path_to(Vertex) const;
+};
+
+
+template <class Vertex, class Weight>
+constexpr typename shortest_paths<Vertex, Weight>::distance_type shortest_paths<Vertex, Weight>::unreachable;
+
+
+
+/*
+ Function: reached / path_to
+ Parameters:
+  - target: A vertex.
+ Return value: Whether the search reached target, and the vertices of the
+               path to it from the source, both ends included; empty if
+               it was not reached.
+
+ Complexity: Constant, and linear in the path's length.
+ */
+template <class Vertex, class Weight>
+inline bool
+shortest_paths<Vertex, Weight>::reached(Vertex target) const
+{
+    return distance[target] != unreachable;
+}
+
+template <class Vertex, class Weight>
+std::vector<Vertex>
+shortest_paths<Vertex, Weight>::path_to(Vertex target) const
+{
+    std::vector<Vertex> path;
+    if (!reached(target))
+        return path;
+
+    for (auto v = target; ; v = parent[v]) {
+        path.push_back(v);
+        if (parent[v] == v)
+            break;
+    }
+    return std::vector<Vertex>(path.rbegin(), path.rend());
+}
+
+
+
+namespace detail {
+
+/*
+ Function: start_paths
+ Parameters:
+  - g: The graph to search.
+  - source: The vertex to search from.
+  - name: The caller, for exception messages.
+ Return value: Paths with only the source reached.
+
+ Exceptions:
+    Throws std::logic_error if g is unweighted and std::out_of_range if
+    source is not one of its vertices.
+ */
+template <class Vertex, class Weight>
+shortest_paths<Vertex, Weight>
+start_paths(const csr_graph<Vertex, Weight>& g, Vertex source, const char* name)
+{
+    if (!g.weighted())
+        throw std::logic_error(std::string(name) + ": the graph is unweighted");
+    if (source >= g.vertices())
+        throw std::out_of_range(name);
+
+    shortest_paths<Vertex, Weight> paths;
+    paths.distance.assign(g.vertices(), paths.unreachable);
+    paths.parent.assign(g.vertices(), csr_graph<Vertex, Weight>::none);
+    paths.distance[source] = 0;
+    paths.parent[source] = source;
+    return paths;
+}
+
+} // end namespace detail
+
+
+
+/*
+ Function: dijkstra
+ Parameters:
+  - g: A weighted graph with no negative weights.
+  - source: The vertex to search from.
+ Return value: Distances and a shortest path tree from source.
+
+ Description:
+    Dijkstra's algorithm with a 4-ary indexed_heap, lowering a queued
+    vertex's key in place when a shorter path to it is found.
+
+ Complexity: O((V + E) log V).
+
+ Exceptions:
+    Throws std::logic_error if g is unweighted and std::out_of_range if
+    source is not a vertex.
+ */
+template <class Vertex, class Weight>
+shortest_paths<Vertex, Weight>
+dijkstra(const csr_graph<Vertex, Weight>& g, Vertex source)
+{
+    typedef path_distance<Weight> distance_type;
+
+    auto paths = detail::start_paths(g, source, "dijkstra");
+    auto& distance = paths.distance;
+    indexed_heap<distance_type, std::greater<distance_type>> queue(g.vertices());
+    queue.push(source, 0);
+
+    while (!queue.empty()) {
+        auto u = static_cast<Vertex>(queue.top());
+        auto d = queue.top_priority();
+        queue.pop();
+
+        auto targets = g.neighbours(u);
+        auto weights = g.weights(u);
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            auto v = targets[i];
+            auto through = d + static_cast<distance_type>(weights[i]);
+            if (through < distance[v]) {
+                distance[v] = through;
+                paths.parent[v] = u;
+                queue.push_or_update(v, through);
+            }
+        }
+    }
+
+    return paths;
+}
+
+
+/*
+ Function: dijkstra_radix
+ Parameters:
+  - g: A graph with non-negative integer weights.
+  - source: The vertex to search from.
+ Return value: As for dijkstra.
+
+ Description:
+    Dijkstra's algorithm with a radix_heap keyed on distance. Improving a
+    queued vertex pushes it again; entries whose key no longer matches the
+    vertex's distance are skipped.
+
+ Complexity: O(E + V log C) for a largest distance C.
+
+ Exceptions:
+    As for dijkstra.
+ */
+template <class Vertex, class Weight>
+shortest_paths<Vertex, Weight>
+dijkstra_radix(const csr_graph<Vertex, Weight>& g, Vertex source)
+{
+    static_assert(std::is_integral<Weight>::value, "dijkstra_radix needs integer weights");
+    typedef path_distance<Weight> distance_type;
+
+    auto paths = detail::start_paths(g, source, "dijkstra_radix");
+    auto& distance = paths.distance;
+    radix_heap<distance_type, Vertex> queue;
+    queue.push(0, source);
+
+    while (!queue.empty()) {
+        auto top = queue.get();
+        queue.pop();
+        auto d = top.first;
+        auto u = top.second;
+        if (d != distance[u])
+            continue;
+
+        auto targets = g.neighbours(u);
+        auto weights = g.weights(u);
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            auto v = targets[i];
+            auto through = d + static_cast<distance_type>(weights[i]);
+            if (through < distance[v]) {
+                distance[v] = through;
+                paths.parent[v] = u;
+                queue.push(through, v);
+            }
+        }
+    }
+
+    return paths;
+}
+
+
+/*
+ Function: a_star
+ Parameters:
+  - g: A weighted graph with no negative weights.
+  - source: The vertex to search from.
+  - target: The vertex to search toward.
+  - heuristic: Called with a vertex, returns a lower bound on its distance
+               to target, convertible to path_distance<Weight>.
+ Return value: Distances and parents of the vertices explored. Those of
+               target and of every vertex on paths.path_to(target) are
+               exact; others may be overestimates or unreachable.
+
+ Description:
+    Dijkstra ordered by distance plus heuristic, stopping when target is
+    settled. A heuristic of zero makes it Dijkstra stopped early.
+
+ Complexity: O((V + E) log V) with a consistent heuristic; a merely
+             admissible one may settle vertices more than once.
+
+ Exceptions:
+    As for dijkstra, also for target.
+ */
+template <class Vertex, class Weight, class Heuristic>
+shortest_paths<Vertex, Weight>
+a_star(const csr_graph<Vertex, Weight>& g, Vertex source, Vertex target, Heuristic heuristic)
+{
+    typedef path_distance<Weight> distance_type;
+
+    auto paths = detail::start_paths(g, source, "a_star");
+    if (target >= g.vertices())
+        throw std::out_of_range("a_star");
+    auto& distance = paths.distance;
+    indexed_heap<distance_type, std::greater<distance_type>> queue(g.vertices());
+    queue.push(source, static_cast<distance_type>(heuristic(source)));
+
+    while (!queue.empty()) {
+        auto u = static_cast<Vertex>(queue.top());
+        queue.pop();
+        if (u == target)
+            break;
+
+        auto d = distance[u];
+        auto targets = g.neighbours(u);
+        auto weights = g.weights(u);
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            auto v = targets[i];
+            auto through = d + static_cast<distance_type>(weights[i]);
+            if (through < distance[v]) {
+                distance[v] = through;
+                paths.parent[v] = u;
+                queue.push_or_update(v, through + static_cast<distance_type>(heuristic(v)));
+            }
+        }
+    }
+
+    return paths;
+}
+
+
+/*
+ Function: delta_stepping
+ Parameters:
+  - g: A weighted graph with no negative weights.
+  - source: The vertex to search from.
+  - delta: The bucket width, positive. Around the average weight divided
+           by the average degree is a reasonable start; larger values
+           expose more parallelism and redo more work.
+  - pool: Threads to search with.
+ Return value: As for dijkstra. Distances are exact; which of several
+               shortest paths the parents trace may vary between runs.
+
+ Complexity: O(V + E + L) work for L the number of buckets up to the
+             largest distance, plus the relaxations repeated within a
+             bucket, which grow with delta.
+
+ Exceptions:
+    As for dijkstra, and std::invalid_argument if delta is not positive.
+ */
+template <class Vertex, class Weight>
+shortest_paths<Vertex, Weight>
+delta_stepping(const csr_graph<Vertex, Weight>& g, Vertex source, path_distance<Weight> delta, thread_pool& pool)
+{
+    typedef path_distance<Weight> distance_type;
+    typedef std::size_t size_type;
+    const size_type n = g.vertices(), grain = 4096, chunk = 64;
+
+    auto paths = detail::start_paths(g, source, "delta_stepping");
+    if (!(delta > 0))
+        throw std::invalid_argument("delta_stepping: delta must be positive");
+
+    std::unique_ptr<std::atomic<distance_type>[]> distance(new std::atomic<distance_type>[n]);
+    std::unique_ptr<std::atomic<bool>[]> locked(new std::atomic<bool>[n]);
+    auto& parent = paths.parent;
+    pool.parallel_for(0, n, grain, [&](size_type lo, size_type hi) {
+        for (auto v = lo; v < hi; ++v) {
+            distance[v].store(paths.unreachable, std::memory_order_relaxed);
+            locked[v].store(false, std::memory_order_relaxed);
+        }
+    });
+    distance[source].store(0, std::memory_order_relaxed);
+
+    auto bucket_of = [delta](distance_type d) { return static_cast<size_type>(d / delta); };
+    std::vector<std::vector<Vertex>> buckets(1, std::vector<Vertex>{source});
+    std::vector<std::vector<Vertex>> parts;
+    std::vector<Vertex> frontier, settled;
+    std::vector<size_type> taken(n, static_cast<size_type>(-1)), settled_in(n, static_cast<size_type>(-1));
+    size_type round = 0;
+
+    // Lowers v's distance to through, with u as its parent, if that is
+    // still an improvement.
+    auto improve = [&](Vertex v, distance_type through, Vertex u) {
+        while (locked[v].exchange(true, std::memory_order_acquire))
+            ;
+        bool better = through < distance[v].load(std::memory_order_relaxed);
+        if (better) {
+            distance[v].store(through, std::memory_order_relaxed);
+            parent[v] = u;
+        }
+        locked[v].store(false, std::memory_order_release);
+        return better;
+    };
+
+    // Relaxes the light or the heavy edges out of from, in parallel, and
+    // files every improved vertex in its bucket.
+    auto relax = [&](const std::vector<Vertex>& from, bool light) {
+        parts.assign((from.size() + chunk - 1) / chunk, std::vector<Vertex>());
+        pool.parallel_for(0, from.size(), chunk, [&](size_type lo, size_type hi) {
+            auto& out = parts[lo / chunk];
+            for (auto i = lo; i < hi; ++i) {
+                auto u = from[i];
+                auto d = distance[u].load(std::memory_order_relaxed);
+                auto targets = g.neighbours(u);
+                auto weights = g.weights(u);
+                for (size_type k = 0; k < targets.size(); ++k) {
+                    auto w = static_cast<distance_type>(weights[k]);
+                    if ((w <= delta) != light)
+                        continue;
+                    auto v = targets[k];
+                    auto through = d + w;
+                    if (through < distance[v].load(std::memory_order_relaxed) && improve(v, through, u))
+                        out.push_back(v);
+                }
+            }
+        });
+        for (auto& part : parts) {
+            for (auto v : part) {
+                auto b = bucket_of(distance[v].load(std::memory_order_relaxed));
+                if (b >= buckets.size())
+                    buckets.resize(b + 1);
+                buckets[b].push_back(v);
+            }
+        }
+    };
+
+    for (size_type i = 0; i < buckets.size(); ++i) {
+        settled.clear();
+        while (!buckets[i].empty()) {
+            // Take the bucket, dropping entries that have since moved to a
+            // lower bucket and repeats within this round.
+            ++round;
+            frontier.clear();
+            for (auto v : buckets[i]) {
+                if (taken[v] != round && bucket_of(distance[v].load(std::memory_order_relaxed)) == i) {
+                    taken[v] = round;
+                    frontier.push_back(v);
+                    if (settled_in[v] != i) {
+                        settled_in[v] = i;
+                        settled.push_back(v);
+                    }
+                }
+            }
+            buckets[i].clear();
+            relax(frontier, true);
+        }
+        relax(settled, false);
+    }
+
+    pool.parallel_for(0, n, grain, [&](size_type lo, size_type hi) {
+        for (auto v = lo; v < hi; ++v)
+            paths.distance[v] = distance[v].load(std::memory_order_relaxed);
+    });
+    return paths;
+}
+
+
+} // end namespace
+
+#endif /* shortest_path_h */
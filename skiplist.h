@@ -1,21 +1,82 @@
 /*
  File:   skiplist.h
  Author: Kyle Thompson
- 
- 
- TODO:
-  - Replace std::vector with custom vector when vector is written.
-  - Organize.
+
+ Purpose:
+    An ordered set (skiplist) and map (skiplist_map) kept in a skiplist, with
+    O(log n) access by rank as well as by value, and lock-free versions of
+    both (concurrent_skiplist and concurrent_skiplist_map).
+
+ Implementation:
+  - Each node is a single allocation: the element and its height, followed
+    directly by its tower of links. Searches touch one block per node
+    rather than a node plus a separately allocated vector of pointers.
+  - Heights are geometric with p = 1/4, drawn from the trailing zero count
+    of a xorshift64* generator, so a node has 1.33 links on average.
+  - Every link records its width, the number of level 0 steps it skips.
+    Links past the last node count the steps to the last element. Widths
+    give rank based get/set/add/remove and index_of in O(log n).
+  - The predecessors found by the most recent search are kept as a finger.
+    A search for a larger value starts from the finger and only climbs as
+    high as it needs to, so ascending or clustered lookups cost
+    O(log distance) instead of O(log n). Modifiers and lookups through a
+    non-const skiplist move the finger. Lookups through a const one start
+    from it but record their predecessors in a local array, so they never
+    write and may run concurrently, as with the standard containers.
+  - skiplist_map stores pair<const Key, Mapped> elements in a skiplist
+    whose comparator looks only at the key, and also orders a bare key
+    against a pair, so find, operator[] and erase search by key alone.
+    operator[] and insert search before constructing, so nothing is built
+    for a key that is already present.
+  - concurrent_skiplist is the lock-free variant (Herlihy and Shavit's
+    LockFreeSkipList, after Fraser). A node is removed by setting the low
+    bit of each of its next pointers, top level first; the level 0 mark is
+    the linearization point. Traversals that meet a marked node snip it
+    out with a CAS on the predecessor. insert and erase are lock-free and
+    has/find are wait-free: they skip marked nodes without writing.
+  - Unlinked nodes are handed to an epoch_domain (epoch.h) and freed once
+    no thread can still be reading them. Because the inserting thread may
+    still be linking upper levels when a node is removed, each node starts
+    with two owners and is only retired once both the inserter and the
+    remover have let go of it.
+  - concurrent_skiplist_map keeps a key and an atomic pointer to a
+    separately allocated value in each node. insert_or_assign swaps in a
+    new value with a CAS and retires the old one through the epoch domain,
+    so readers copy a value that cannot change under them. erase first
+    CASes the value to null, which is its linearization point, and then
+    unlinks the node; any thread that meets a null value helps unlink it.
  */
 
 #ifndef skiplist_h
 #define skiplist_h
 
-#include <vector> // temporary
+#include <atomic>      // atomic
+#include <cassert>     // assert
+#include <cstdint>     // uint64_t, uintptr_t
+#include <functional>  // less
+#include <iterator>    // iterator
+#include <memory>      // allocator
+#include <stdexcept>   // out_of_range
+#include <thread>      // this_thread
+#include <tuple>       // forward_as_tuple
+#include <utility>     // move, forward, pair, swap
+
+#include "epoch.h"
+
+namespace ads {
 
-template <class T, class Alloc>
+template <class Key, class Mapped, class Compare, class Alloc>
+class skiplist_map;
+
+template <class Key, class Mapped, class Compare, class Alloc>
+class concurrent_skiplist_map;
+
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
 class skiplist {
 
+    template <class, class, class, class>
+        friend class skiplist_map;
+
 /* Type definitions */
 public:
     typedef std::size_t size_type;
@@ -24,98 +85,1990 @@ public:
     typedef T&&         rvalue_ref;
     typedef const T&    const_ref;
 
-    
+
 /* Node definition */
 private:
-    class Node {
-        
+    static constexpr unsigned max_height = 32;
+
+    struct Node;
+
+    struct Link {
+        Node* next;
+        size_type width;
+    };
+
+    struct alignas(alignof(Link)) Node {
+        T data;                 // Unconstructed in the head node.
+        unsigned height;
+
+        Link* links() { return reinterpret_cast<Link*>(this + 1); }
+        const Link* links() const { return reinterpret_cast<const Link*>(this + 1); }
+    };
+
+    typedef typename Alloc::template rebind<Node>::other node_alloc;
+
+
+/* Iterators */
+public:
+    class const_iterator : public std::iterator<std::forward_iterator_tag, value_type> {
+
+        friend class skiplist<T, Compare, Alloc>;
+
+    private:
+        const Node* node;
+
     public:
-        std::vector<Node> next;
-        size_type height;
-        T data;
-        
-        Node()
-            : height(2)
-            , next({nullptr, nullptr})
-        {}
-        
-        Node(Node* rhs)
-        
-        Node(const_ref element)
-            : data(element)
-            , height(get_height())
-        {}
-        
-        size_type get_height()
-        {
-            return 2; // Temporary
-        }
+        const_iterator(const Node* n = nullptr) : node(n) {}
+        const_ref operator*() const { return node->data; }
+        const T* operator->() const { return std::addressof(node->data); }
+        const_iterator& operator++() { node = node->links()[0].next; return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); ++*this; return temp; }
+        bool operator==(const const_iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const const_iterator& rhs) const { return node != rhs.node; }
     };
 
-    
+    typedef const_iterator iterator;
+
+
 /* Data members */
 private:
-    Node* _start;
-    Node* _end;
-    size_type _height;
-    
-    
+    Node* _head;
+    unsigned _height = 1;                  // Levels in use, at least one.
+    size_type _size = 0;
+    std::uint64_t _seed;
+    Compare _compare;
+    node_alloc _alloc;
+    Node* _finger[max_height];             // Predecessors from the last search.
+
+
 /* Member functions */
 public:
+    /* Constructors */
     skiplist();
-    const_ref get(size_type);
+    skiplist(const skiplist<T, Compare, Alloc>&);
+    skiplist(skiplist<T, Compare, Alloc>&&);
+    skiplist(std::initializer_list<T>);
+    ~skiplist();
+
+    /* Assignment */
+    skiplist<T, Compare, Alloc>& operator=(skiplist<T, Compare, Alloc>);
+
+    /* Iterators */
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+
+    /* Element access */
+    bool has(const_ref);
+    bool has(const_ref) const;
+    const_iterator find(const_ref);
+    const_iterator find(const_ref) const;
+    const_iterator lower_bound(const_ref);
+    const_iterator lower_bound(const_ref) const;
+    size_type index_of(const_ref) const;
+    const_ref get(size_type) const;
+    const_ref operator[](size_type) const;
+
+    /* Modifiers */
+    bool insert(const_ref);
+    bool insert(rvalue_ref);
+    template <class... Args>
+        bool emplace(Args&&...);
+    bool erase(const_ref);
     void set(size_type, const_ref);
     void add(size_type, const_ref);
     void remove(size_type);
+    void swap(skiplist<T, Compare, Alloc>&);
+    void clear() noexcept;
+
+/* Helper functions */
+private:
+    Node* create_node(unsigned);
+    void destroy_node(Node*, bool);
+    unsigned random_height();
+    template <class K>
+        bool less(const Node*, const K&) const;
+    template <class K>
+        Node* search(const K&, Node**, size_type*) const;
+    template <class K>
+        Node* locate(const K&, Node**) const;
+    Node* search_rank(size_type, Node**, size_type*) const;
+    template <class K, class... Args>
+        std::pair<Node*, bool> try_emplace(const K&, Args&&...);
+    void link(Node*, Node**, size_type*);
+    void unlink(Node*, Node**);
 };
 
 
 
+// Node management
+
+/*
+ Function: create_node
+ Parameters:
+  - height: The number of links in the node's tower.
+ Return value: A node with its links nulled and its element unconstructed.
+
+ Description:
+    Allocates the node and its tower as one block, sized in whole nodes so
+    the block keeps the node's alignment.
+
+ Complexity: Linear in height.
+ */
+template <class T, class Compare, class Alloc>
+typename skiplist<T, Compare, Alloc>::Node*
+skiplist<T, Compare, Alloc>::create_node(unsigned height)
+{
+    auto units = 1 + (height * sizeof(Link) + sizeof(Node) - 1) / sizeof(Node);
+    auto node = _alloc.allocate(units);
+    node->height = height;
+    for (unsigned i = 0; i < height; ++i)
+        ::new (node->links() + i) Link{nullptr, 0};
+
+    return node;
+}
+
+
+/*
+ Function: destroy_node
+ Parameters:
+  - node: The node to free.
+  - has_data: Whether the node's element was constructed.
+ */
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::destroy_node(Node* node, bool has_data)
+{
+    if (has_data)
+        node->data.~T();
+
+    auto units = 1 + (node->height * sizeof(Link) + sizeof(Node) - 1) / sizeof(Node);
+    _alloc.deallocate(node, units);
+}
+
+
+/*
+ Function: random_height
+ Return value: A height in [1, max_height], geometric with p = 1/4.
+ */
+template <class T, class Compare, class Alloc>
+inline unsigned
+skiplist<T, Compare, Alloc>::random_height()
+{
+    _seed ^= _seed >> 12;
+    _seed ^= _seed << 25;
+    _seed ^= _seed >> 27;
+    auto bits = (_seed * 0x2545F4914F6CDD1Dull) | (1ull << 62);
+
+    auto height = 1 + static_cast<unsigned>(__builtin_ctzll(bits)) / 2;
+    return height < max_height ? height : max_height;
+}
+
+
+/*
+ Function: less
+ Return value: Whether node sorts before element. The head sorts before
+               everything and the end (null) after everything.
+ */
+template <class T, class Compare, class Alloc>
+template <class K>
+inline bool
+skiplist<T, Compare, Alloc>::less(const Node* node, const K& element) const
+{
+    return node == _head || (node && _compare(node->data, element));
+}
+
+
+
 // Constructors
 
 /*
- 
+ Function: constructor
+ Parameters:
+  - rhs: The skiplist being copied or moved from.
+  - il: Initializer list of elements, in any order.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty skiplist.
+  2. independent copy of rhs.
+  3. skiplist that takes over rhs's nodes, leaving rhs empty.
+  4. skiplist holding the distinct elements of il.
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs (elements are appended in order).
+  3. Constant.
+  4. n log n in the size of il.
+ */
+
+// 1. default
+template <class T, class Compare, class Alloc>
+skiplist<T, Compare, Alloc>::skiplist()
+    : _head(create_node(max_height))
+    , _seed(reinterpret_cast<std::uintptr_t>(this) * 0x9E3779B97F4A7C15ull | 1)
+{
+    for (auto& f : _finger)
+        f = _head;
+}
+
+// 2. copy
+template <class T, class Compare, class Alloc>
+skiplist<T, Compare, Alloc>::skiplist(const skiplist<T, Compare, Alloc>& rhs)
+    : skiplist()
+{
+    _compare = rhs._compare;
+    for (auto& element : rhs)
+        add(_size, element);
+}
+
+// 3. move
+template <class T, class Compare, class Alloc>
+skiplist<T, Compare, Alloc>::skiplist(skiplist<T, Compare, Alloc>&& rhs)
+    : skiplist()
+{
+    swap(rhs);
+}
+
+// 4. initializer list
+template <class T, class Compare, class Alloc>
+skiplist<T, Compare, Alloc>::skiplist(std::initializer_list<T> il)
+    : skiplist()
+{
+    for (auto& element : il)
+        insert(element);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Compare, class Alloc>
+skiplist<T, Compare, Alloc>::~skiplist()
+{
+    clear();
+    destroy_node(_head, false);
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this skiplist.
+ */
+template <class T, class Compare, class Alloc>
+skiplist<T, Compare, Alloc>&
+skiplist<T, Compare, Alloc>::operator=(skiplist<T, Compare, Alloc> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end
+ Return value: Iterators to the smallest element and past the largest.
+ */
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::const_iterator
+skiplist<T, Compare, Alloc>::begin() const
+{
+    return const_iterator(_head->links()[0].next);
+}
+
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::const_iterator
+skiplist<T, Compare, Alloc>::end() const
+{
+    return const_iterator(nullptr);
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty
+ Return value: Whether or not the skiplist is empty.
+ */
+template <class T, class Compare, class Alloc>
+inline bool
+skiplist<T, Compare, Alloc>::empty() const
+{
+    return _size == 0;
+}
+
+
+/*
+ Function: size
+ Return value: The number of elements.
+ */
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::size_type
+skiplist<T, Compare, Alloc>::size() const
+{
+    return _size;
+}
+
+
+
+// Element access
+
+/*
+ Function: has / find / lower_bound
+ Parameters:
+  - element: The value to look for.
+ Return value: Whether element is present, an iterator to it (end() if
+               absent), or an iterator to the first element not less
+               than it.
+
+ Description:
+    The non-const forms leave the finger at element's predecessors. The
+    const forms only read it, so concurrent const lookups are safe.
+
+ Complexity: Expected logarithmic; logarithmic in the distance from the
+             finger when moving forward.
+ */
+template <class T, class Compare, class Alloc>
+inline bool
+skiplist<T, Compare, Alloc>::has(const_ref element)
+{
+    return locate(element, _finger) != nullptr;
+}
+
+template <class T, class Compare, class Alloc>
+inline bool
+skiplist<T, Compare, Alloc>::has(const_ref element) const
+{
+    Node* update[max_height];
+    return locate(element, update) != nullptr;
+}
+
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::const_iterator
+skiplist<T, Compare, Alloc>::find(const_ref element)
+{
+    return const_iterator(locate(element, _finger));
+}
+
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::const_iterator
+skiplist<T, Compare, Alloc>::find(const_ref element) const
+{
+    Node* update[max_height];
+    return const_iterator(locate(element, update));
+}
+
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::const_iterator
+skiplist<T, Compare, Alloc>::lower_bound(const_ref element)
+{
+    return const_iterator(search(element, _finger, nullptr));
+}
+
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::const_iterator
+skiplist<T, Compare, Alloc>::lower_bound(const_ref element) const
+{
+    Node* update[max_height];
+    return const_iterator(search(element, update, nullptr));
+}
+
+
+/*
+ Function: index_of
+ Parameters:
+  - element: The value to look for.
+ Return value: The rank of element, or size() if it is absent.
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+typename skiplist<T, Compare, Alloc>::size_type
+skiplist<T, Compare, Alloc>::index_of(const_ref element) const
+{
+    Node* update[max_height];
+    size_type rank[max_height];
+    auto node = search(element, update, rank);
+
+    return node && !_compare(element, node->data) ? rank[0] : _size;
+}
+
+
+/*
+ Function: get / operator[]
+ Parameters:
+  - index: A rank in [0, size()).
+ Return value: The index-th smallest element.
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+typename skiplist<T, Compare, Alloc>::const_ref
+skiplist<T, Compare, Alloc>::get(size_type index) const
+{
+    assert(index < _size);
+    return search_rank(index, nullptr, nullptr)->data;
+}
+
+template <class T, class Compare, class Alloc>
+inline typename skiplist<T, Compare, Alloc>::const_ref
+skiplist<T, Compare, Alloc>::operator[](size_type index) const
+{
+    return get(index);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / emplace
+ Parameters:
+  - element: The value to insert.
+  - args: Arguments to construct the value from.
+ Return value: Whether the value was inserted; false if an equal value was
+               already present.
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+inline bool
+skiplist<T, Compare, Alloc>::insert(const_ref element)
+{
+    return emplace(element);
+}
+
+template <class T, class Compare, class Alloc>
+inline bool
+skiplist<T, Compare, Alloc>::insert(rvalue_ref element)
+{
+    return emplace(std::move(element));
+}
+
+template <class T, class Compare, class Alloc>
+template <class... Args>
+bool
+skiplist<T, Compare, Alloc>::emplace(Args&&... args)
+{
+    auto node = create_node(random_height());
+    try {
+        ::new (std::addressof(node->data)) T(std::forward<Args>(args)...);
+    } catch (...) {
+        destroy_node(node, false);
+        throw;
+    }
+
+    size_type rank[max_height];
+    auto found = search(node->data, _finger, rank);
+    if (found && !_compare(node->data, found->data)) {
+        destroy_node(node, true);
+        return false;
+    }
+
+    link(node, _finger, rank);
+    return true;
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - element: The value to remove.
+ Return value: Whether a value was removed.
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+bool
+skiplist<T, Compare, Alloc>::erase(const_ref element)
+{
+    auto node = search(element, _finger, nullptr);
+    if (!node || _compare(element, node->data))
+        return false;
+
+    unlink(node, _finger);
+    return true;
+}
+
+
+/*
+ Function: set
+ Parameters:
+  - index: A rank in [0, size()).
+  - element: The replacement value. It must sort strictly between the
+             neighbours of the index-th element.
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::set(size_type index, const_ref element)
+{
+    assert(index < _size);
+    auto node = search_rank(index, nullptr, nullptr);
+
+    assert(index == 0 || _compare(get(index - 1), element));
+    assert(!node->links()[0].next || _compare(element, node->links()[0].next->data));
+    node->data = element;
+}
+
+
+/*
+ Function: add
+ Parameters:
+  - index: A rank in [0, size()].
+  - element: The new value. It must sort strictly between the elements at
+             index - 1 and index.
+
+ Description:
+    Positional insert for callers that already know where a value goes,
+    e.g. appending sorted input with add(size(), x). No comparisons are
+    made outside of debug assertions.
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::add(size_type index, const_ref element)
+{
+    assert(index <= _size);
+
+    size_type rank[max_height];
+    auto next = search_rank(index, _finger, rank);
+    assert(index == 0 || _compare(_finger[0]->data, element));
+    assert(!next || _compare(element, next->data));
+    (void)next;
+
+    auto node = create_node(random_height());
+    try {
+        ::new (std::addressof(node->data)) T(element);
+    } catch (...) {
+        destroy_node(node, false);
+        throw;
+    }
+
+    link(node, _finger, rank);
+}
+
+
+/*
+ Function: remove
+ Parameters:
+  - index: A rank in [0, size()).
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::remove(size_type index)
+{
+    assert(index < _size);
+    unlink(search_rank(index, _finger, nullptr), _finger);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - rhs: The skiplist to exchange contents with.
+
+ Complexity: Constant.
+ */
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::swap(skiplist<T, Compare, Alloc>& rhs)
+{
+    std::swap(_head, rhs._head);
+    std::swap(_height, rhs._height);
+    std::swap(_size, rhs._size);
+    std::swap(_compare, rhs._compare);
+
+    for (auto& f : _finger)
+        f = _head;
+    for (auto& f : rhs._finger)
+        f = rhs._head;
+}
+
+
+/*
+ Function: clear
+ Description:
+    Frees every element's node and resets the head's links.
+
+ Complexity: Linear in the size.
  */
-template <class T, class Alloc>
-skiplist<T, Alloc>::skiplist()
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::clear() noexcept
 {
-    _end = new Node();
-    _start = new Node(_end);
-    _height = 2;
+    for (auto node = _head->links()[0].next; node;) {
+        auto next = node->links()[0].next;
+        destroy_node(node, true);
+        node = next;
+    }
+
+    for (unsigned i = 0; i < max_height; ++i)
+        _head->links()[i] = Link{nullptr, 0};
+    for (auto& f : _finger)
+        f = _head;
+
+    _height = 1;
+    _size = 0;
 }
 
 
 
+// Helper functions
+
+/*
+ Function: search
+ Parameters:
+  - element: The value being searched for, or anything Compare can order
+             against the elements (skiplist_map searches by key).
+  - update: Receives, per level, the last node that sorts before element.
+  - rank: If not null, receives the rank of each update node plus one
+          (the head is rank 0), so rank[0] is element's rank.
+ Return value: The first node not less than element, or null.
+
+ Description:
+    Starts from the finger when element is past it, climbing only until a
+    finger node's link overshoots element. Passing the finger itself as
+    update moves it here, so the next search continues from this one;
+    const lookups pass a local array instead.
+
+ Complexity: Expected logarithmic in the distance from the finger.
+ */
+template <class T, class Compare, class Alloc>
+template <class K>
+typename skiplist<T, Compare, Alloc>::Node*
+skiplist<T, Compare, Alloc>::search(const K& element, Node** update, size_type* rank) const
+{
+    // Rank tracking needs absolute positions, which the finger lacks.
+    bool from_finger = !rank && _finger[0] != _head && less(_finger[0], element);
+
+    unsigned level = _height;
+    if (from_finger) {
+        level = 1;
+        while (level < _height && less(_finger[level - 1]->links()[level - 1].next, element))
+            ++level;
+    }
+
+    Node* node = from_finger ? _finger[level - 1] : _head;
+    Node* stop = nullptr;       // Known not to sort before element.
+    size_type position = 0;
+
+    for (unsigned i = level; i-- > 0;) {
+        // Every finger node sorts before element; a lower one may be further along.
+        auto finger = _finger[i];
+        if (from_finger && finger != _head && (node == _head || _compare(node->data, finger->data)))
+            node = finger;
+
+        auto next = node->links()[i].next;
+        for (; next != stop && next && _compare(next->data, element); next = node->links()[i].next) {
+            position += node->links()[i].width;
+            node = next;
+        }
 
+        stop = next;
+        update[i] = node;
+        if (rank)
+            rank[i] = position;
+    }
 
+    for (unsigned i = level; i < _height; ++i)
+        update[i] = _finger[i];
 
+    return node->links()[0].next;
+}
 
 
+/*
+ Function: locate
+ Parameters:
+  - element: As for search.
+  - update: As for search.
+ Return value: The node equal to element, or null.
+ */
+template <class T, class Compare, class Alloc>
+template <class K>
+inline typename skiplist<T, Compare, Alloc>::Node*
+skiplist<T, Compare, Alloc>::locate(const K& element, Node** update) const
+{
+    auto node = search(element, update, nullptr);
+    return node && !_compare(element, node->data) ? node : nullptr;
+}
 
 
+/*
+ Function: search_rank
+ Parameters:
+  - index: A rank in [0, size()].
+  - update: If not null, receives the predecessor at each level.
+  - rank: If not null, receives the rank of each predecessor plus one.
+ Return value: The node at rank index, or null for index == size().
 
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+typename skiplist<T, Compare, Alloc>::Node*
+skiplist<T, Compare, Alloc>::search_rank(size_type index, Node** update, size_type* rank) const
+{
+    Node* node = _head;
+    size_type position = 0;
 
+    for (unsigned i = _height; i-- > 0;) {
+        while (node->links()[i].next && position + node->links()[i].width <= index) {
+            position += node->links()[i].width;
+            node = node->links()[i].next;
+        }
 
+        if (update)
+            update[i] = node;
+        if (rank)
+            rank[i] = position;
+    }
 
+    return node->links()[0].next;
+}
 
 
+/*
+ Function: try_emplace
+ Parameters:
+  - key: What the new element will compare equal to.
+  - args: Arguments to construct the element from.
+ Return value: The node equal to key and whether it was just inserted.
 
+ Description:
+    Searches before constructing anything, so nothing is built when key is
+    already present. skiplist_map's operator[] and insert go through here.
 
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+template <class K, class... Args>
+std::pair<typename skiplist<T, Compare, Alloc>::Node*, bool>
+skiplist<T, Compare, Alloc>::try_emplace(const K& key, Args&&... args)
+{
+    size_type rank[max_height];
+    auto found = search(key, _finger, rank);
+    if (found && !_compare(key, found->data))
+        return {found, false};
 
+    auto node = create_node(random_height());
+    try {
+        ::new (std::addressof(node->data)) T(std::forward<Args>(args)...);
+    } catch (...) {
+        destroy_node(node, false);
+        throw;
+    }
 
+    link(node, _finger, rank);
+    return {node, true};
+}
 
 
+/*
+ Function: link
+ Parameters:
+  - node: A new node with its element constructed.
+  - update: The predecessors of node's position at every level in use.
+  - rank: The ranks of those predecessors.
 
+ Description:
+    Splices node in after update[0], raising the list's height if needed,
+    and adjusts every width that spans the new position. Leaves the finger
+    at the new node's predecessors.
 
+ Complexity: Linear in the list's height.
+ */
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::link(Node* node, Node** update, size_type* rank)
+{
+    auto height = node->height;
+    for (; _height < height; ++_height) {
+        update[_height] = _head;
+        rank[_height] = 0;
+        _head->links()[_height].width = _size;
+    }
 
+    auto position = rank[0];
+    for (unsigned i = 0; i < height; ++i) {
+        auto& prev = update[i]->links()[i];
+        auto& link = node->links()[i];
 
+        link.next = prev.next;
+        link.width = prev.width - (position - rank[i]);
+        prev.next = node;
+        prev.width = position - rank[i] + 1;
+    }
 
+    for (unsigned i = height; i < _height; ++i)
+        ++update[i]->links()[i].width;
 
+    ++_size;
 
+    if (update != _finger)
+        for (unsigned i = 0; i < _height; ++i)
+            _finger[i] = update[i];
+}
 
 
+/*
+ Function: unlink
+ Parameters:
+  - node: The node to remove.
+  - update: Its predecessors at every level in use.
 
+ Description:
+    Removes and frees node, fixes the widths that spanned it, and lowers
+    the height if the top levels emptied. Leaves the finger at node's
+    predecessors.
 
+ Complexity: Linear in the list's height.
+ */
+template <class T, class Compare, class Alloc>
+void
+skiplist<T, Compare, Alloc>::unlink(Node* node, Node** update)
+{
+    for (unsigned i = 0; i < _height; ++i) {
+        auto& prev = update[i]->links()[i];
+        if (prev.next == node) {
+            prev.width += node->links()[i].width - 1;
+            prev.next = node->links()[i].next;
+        } else {
+            --prev.width;
+        }
+    }
+
+    destroy_node(node, true);
+    --_size;
+
+    while (_height > 1 && !_head->links()[_height - 1].next)
+        --_height;
+
+    if (update != _finger)
+        for (unsigned i = 0; i < _height; ++i)
+            _finger[i] = update[i];
+}
+
+
+
+
+
+// An ordered map from unique keys to values: a skiplist of key/value pairs
+// ordered by key alone, searched by key without building a pair.
+template <class Key, class Mapped, class Compare = std::less<Key>,
+          class Alloc = std::allocator<std::pair<const Key, Mapped>>>
+class skiplist_map {
+
+public:
+    typedef std::size_t                  size_type;
+    typedef Key                          key_type;
+    typedef Mapped                       mapped_type;
+    typedef std::pair<const Key, Mapped> value_type;
+
+private:
+    // Orders entries by key, and keys against entries.
+    struct entry_compare {
+        Compare compare;
+
+        bool operator()(const value_type& a, const value_type& b) const { return compare(a.first, b.first); }
+        bool operator()(const value_type& a, const Key& b) const { return compare(a.first, b); }
+        bool operator()(const Key& a, const value_type& b) const { return compare(a, b.first); }
+    };
+
+    typedef skiplist<value_type, entry_compare, Alloc> list_type;
+    typedef typename list_type::Node Node;
+
+public:
+    typedef typename list_type::const_iterator const_iterator;
+
+    class iterator : public std::iterator<std::forward_iterator_tag, value_type> {
+
+        friend class skiplist_map<Key, Mapped, Compare, Alloc>;
+
+    private:
+        Node* node;
+
+    public:
+        iterator(Node* n = nullptr) : node(n) {}
+        value_type& operator*() const { return node->data; }
+        value_type* operator->() const { return std::addressof(node->data); }
+        iterator& operator++() { node = node->links()[0].next; return *this; }
+        iterator operator++(int) { iterator temp(*this); ++*this; return temp; }
+        bool operator==(const iterator& rhs) const { return node == rhs.node; }
+        bool operator!=(const iterator& rhs) const { return node != rhs.node; }
+        operator const_iterator() const { return const_iterator(node); }
+    };
+
+private:
+    list_type _list;
+
+public:
+    /* Constructors */
+    skiplist_map() = default;
+    skiplist_map(std::initializer_list<value_type> il) { for (auto& kv : il) insert(kv.first, kv.second); }
+
+    /* Iterators */
+    iterator begin() { return iterator(_list._head->links()[0].next); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return _list.begin(); }
+    const_iterator end() const { return _list.end(); }
+
+    /* Capacity */
+    bool empty() const { return _list.empty(); }
+    size_type size() const { return _list.size(); }
+
+    /* Element access */
+    // As with skiplist, only the non-const lookups move the finger.
+    bool has(const Key& key) { return locate(key) != nullptr; }
+    bool has(const Key& key) const { return locate(key) != nullptr; }
+    iterator find(const Key& key) { return iterator(locate(key)); }
+    const_iterator find(const Key& key) const { return const_iterator(locate(key)); }
+    iterator lower_bound(const Key& key) { return iterator(_list.search(key, _list._finger, nullptr)); }
+    const_iterator lower_bound(const Key& key) const
+    {
+        Node* update[list_type::max_height];
+        return const_iterator(_list.search(key, update, nullptr));
+    }
+
+    // The rank of key, or size() if it is absent.
+    size_type index_of(const Key& key) const
+    {
+        Node* update[list_type::max_height];
+        size_type rank[list_type::max_height];
+        auto node = _list.search(key, update, rank);
+        return node && !_list._compare(key, node->data) ? rank[0] : size();
+    }
+
+    value_type& get(size_type index)
+    {
+        assert(index < size());
+        return _list.search_rank(index, nullptr, nullptr)->data;
+    }
+
+    const value_type& get(size_type index) const { return _list.get(index); }
+
+    Mapped& operator[](const Key& key)
+    {
+        return _list.try_emplace(key, std::piecewise_construct, std::forward_as_tuple(key), std::tuple<>())
+                   .first->data.second;
+    }
+
+    Mapped& at(const Key& key)
+    {
+        auto node = locate(key);
+        if (!node)
+            throw std::out_of_range("skiplist_map::at");
+        return node->data.second;
+    }
+
+    const Mapped& at(const Key& key) const
+    {
+        auto node = locate(key);
+        if (!node)
+            throw std::out_of_range("skiplist_map::at");
+        return node->data.second;
+    }
+
+    /* Modifiers */
+    // Whether key was inserted; an existing value is left alone.
+    bool insert(const Key& key, const Mapped& value) { return _list.try_emplace(key, key, value).second; }
+    bool insert(const Key& key, Mapped&& value) { return _list.try_emplace(key, key, std::move(value)).second; }
+
+    // Whether key was inserted rather than its value replaced.
+    template <class M>
+    bool insert_or_assign(const Key& key, M&& value)
+    {
+        auto placed = _list.try_emplace(key, key, std::forward<M>(value));
+        if (!placed.second)
+            placed.first->data.second = std::forward<M>(value);
+        return placed.second;
+    }
+
+    bool erase(const Key& key)
+    {
+        auto node = locate(key);
+        if (!node)
+            return false;
+        _list.unlink(node, _list._finger);
+        return true;
+    }
+
+    void remove(size_type index) { _list.remove(index); }
+    void swap(skiplist_map<Key, Mapped, Compare, Alloc>& rhs) { _list.swap(rhs._list); }
+    void clear() noexcept { _list.clear(); }
+
+private:
+    // The node holding key, or null. The non-const form leaves the finger
+    // at its predecessors.
+    Node* locate(const Key& key) { return _list.locate(key, _list._finger); }
+
+    Node* locate(const Key& key) const
+    {
+        Node* update[list_type::max_height];
+        return _list.locate(key, update);
+    }
+};
+
+
+
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class concurrent_skiplist {
+
+    template <class, class, class, class>
+        friend class concurrent_skiplist_map;
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+
+/* Node definition */
+private:
+    static constexpr unsigned max_height = 24;
+
+    typedef std::atomic<std::uintptr_t> Link;     // Node pointer, low bit = removed.
+
+    struct alignas(alignof(Link)) Node {
+        T data;                 // Unconstructed in the head node.
+        unsigned height;
+        std::atomic<int> owners;
+
+        Link* links() { return reinterpret_cast<Link*>(this + 1); }
+    };
+
+    typedef typename Alloc::template rebind<Node>::other node_alloc;
+
+
+/* Data members */
+private:
+    Node* _head;
+    std::atomic<size_type> _size{0};
+    Compare _compare;
+    node_alloc _alloc;
+    epoch_domain _epochs;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit concurrent_skiplist(size_type = 256);
+    concurrent_skiplist(const concurrent_skiplist<T, Compare, Alloc>&) = delete;
+    concurrent_skiplist<T, Compare, Alloc>& operator=(const concurrent_skiplist<T, Compare, Alloc>&) = delete;
+    ~concurrent_skiplist();
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+
+    /* Element access */
+    bool has(const_ref);
+    bool find(const_ref, reference);
+    template <class Function>
+        void for_each(Function);
+
+    /* Modifiers */
+    bool insert(const_ref);
+    bool insert(rvalue_ref);
+    template <class... Args>
+        bool emplace(Args&&...);
+    bool erase(const_ref);
+
+/* Helper functions */
+private:
+    static Node* pointer(std::uintptr_t);
+    static bool marked(std::uintptr_t);
+    static std::uintptr_t word(Node*, bool = false);
+    Node* create_node(unsigned);
+    void destroy_node(Node*, bool);
+    template <class... Args>
+        Node* make_node(Args&&...);
+    static void reclaim(void*, void*);
+    static unsigned random_height();
+    template <class K>
+        bool locate(const K&, Node**, Node**);
+    template <class K>
+        Node* wait_free_search(const K&);
+    bool insert_node(Node*, epoch_domain::guard&);
+    bool remove_node(Node*, epoch_domain::guard&);
+    void release(Node*, epoch_domain::guard&);
+};
+
+
+
+// Pointer marking
+
+/*
+ Function: pointer / marked / word
+ Description:
+    A link is a node address with its low bit set once the node owning the
+    link has been removed at that level.
+ */
+template <class T, class Compare, class Alloc>
+inline typename concurrent_skiplist<T, Compare, Alloc>::Node*
+concurrent_skiplist<T, Compare, Alloc>::pointer(std::uintptr_t link)
+{
+    return reinterpret_cast<Node*>(link & ~std::uintptr_t(1));
+}
+
+template <class T, class Compare, class Alloc>
+inline bool
+concurrent_skiplist<T, Compare, Alloc>::marked(std::uintptr_t link)
+{
+    return link & 1;
+}
+
+template <class T, class Compare, class Alloc>
+inline std::uintptr_t
+concurrent_skiplist<T, Compare, Alloc>::word(Node* node, bool mark)
+{
+    return reinterpret_cast<std::uintptr_t>(node) | std::uintptr_t(mark);
+}
+
+
+
+// Node management
+
+/*
+ Function: create_node / destroy_node
+ Parameters:
+  - height: The number of links in the tower.
+  - node: The node to free.
+  - has_data: Whether the node's element was constructed.
+
+ Description:
+    As in skiplist, the node and its tower are one allocation.
+ */
+template <class T, class Compare, class Alloc>
+typename concurrent_skiplist<T, Compare, Alloc>::Node*
+concurrent_skiplist<T, Compare, Alloc>::create_node(unsigned height)
+{
+    auto units = 1 + (height * sizeof(Link) + sizeof(Node) - 1) / sizeof(Node);
+    auto node = _alloc.allocate(units);
+    node->height = height;
+    ::new (&node->owners) std::atomic<int>(2);
+    for (unsigned i = 0; i < height; ++i)
+        ::new (node->links() + i) Link(0);
+
+    return node;
+}
+
+template <class T, class Compare, class Alloc>
+void
+concurrent_skiplist<T, Compare, Alloc>::destroy_node(Node* node, bool has_data)
+{
+    if (has_data)
+        node->data.~T();
+
+    auto units = 1 + (node->height * sizeof(Link) + sizeof(Node) - 1) / sizeof(Node);
+    _alloc.deallocate(node, units);
+}
+
+
+/*
+ Function: make_node
+ Parameters:
+  - args: Arguments to construct the element from.
+ Return value: A new node of random height with its element constructed
+               and its links nulled.
+ */
+template <class T, class Compare, class Alloc>
+template <class... Args>
+typename concurrent_skiplist<T, Compare, Alloc>::Node*
+concurrent_skiplist<T, Compare, Alloc>::make_node(Args&&... args)
+{
+    auto node = create_node(random_height());
+    try {
+        ::new (std::addressof(node->data)) T(std::forward<Args>(args)...);
+    } catch (...) {
+        destroy_node(node, false);
+        throw;
+    }
+
+    return node;
+}
+
+
+/*
+ Function: reclaim
+ Parameters:
+  - context: The owning concurrent_skiplist.
+  - node: A retired node.
+
+ Description:
+    The epoch_domain deleter.
+ */
+template <class T, class Compare, class Alloc>
+void
+concurrent_skiplist<T, Compare, Alloc>::reclaim(void* context, void* node)
+{
+    static_cast<concurrent_skiplist<T, Compare, Alloc>*>(context)->destroy_node(static_cast<Node*>(node), true);
+}
+
+
+/*
+ Function: random_height
+ Return value: A height in [1, max_height], geometric with p = 1/4, from a
+               per-thread xorshift generator.
+ */
+template <class T, class Compare, class Alloc>
+inline unsigned
+concurrent_skiplist<T, Compare, Alloc>::random_height()
+{
+    static thread_local std::uint64_t seed =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull | 1;
+
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    auto bits = (seed * 0x2545F4914F6CDD1Dull) | (1ull << 62);
+
+    auto height = 1 + static_cast<unsigned>(__builtin_ctzll(bits)) / 2;
+    return height < max_height ? height : max_height;
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - max_threads: The most threads that may operate on the skiplist at once.
+
+ Complexity: Linear in max_threads.
+ */
+template <class T, class Compare, class Alloc>
+concurrent_skiplist<T, Compare, Alloc>::concurrent_skiplist(size_type max_threads)
+    : _head(create_node(max_height))
+    , _epochs(max_threads)
+{}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Frees every node still linked at level 0. Nodes that were retired are
+    already unlinked and are freed by the epoch domain. No other thread may
+    be using the skiplist.
+ */
+template <class T, class Compare, class Alloc>
+concurrent_skiplist<T, Compare, Alloc>::~concurrent_skiplist()
+{
+    for (auto node = pointer(_head->links()[0].load()); node;) {
+        auto next = pointer(node->links()[0].load());
+        destroy_node(node, true);
+        node = next;
+    }
+
+    destroy_node(_head, false);
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size
+ Return value: Snapshots of the element count; exact when quiescent.
+ */
+template <class T, class Compare, class Alloc>
+inline bool
+concurrent_skiplist<T, Compare, Alloc>::empty() const
+{
+    return size() == 0;
+}
+
+template <class T, class Compare, class Alloc>
+inline typename concurrent_skiplist<T, Compare, Alloc>::size_type
+concurrent_skiplist<T, Compare, Alloc>::size() const
+{
+    return _size.load(std::memory_order_relaxed);
+}
+
+
+
+// Element access
+
+/*
+ Function: has / find
+ Parameters:
+  - element: The value to look for.
+  - out: Receives a copy of the stored value equal to element.
+ Return value: Whether an equal value was present.
+
+ Description:
+    Wait-free: marked nodes are stepped over, never unlinked.
+
+ Complexity: Expected logarithmic.
+ */
+template <class T, class Compare, class Alloc>
+bool
+concurrent_skiplist<T, Compare, Alloc>::has(const_ref element)
+{
+    epoch_domain::guard guard(_epochs);
+    return wait_free_search(element) != nullptr;
+}
+
+template <class T, class Compare, class Alloc>
+bool
+concurrent_skiplist<T, Compare, Alloc>::find(const_ref element, reference out)
+{
+    epoch_domain::guard guard(_epochs);
+    auto node = wait_free_search(element);
+    if (node)
+        out = node->data;
+
+    return node != nullptr;
+}
+
+
+/*
+ Function: for_each
+ Parameters:
+  - function: Called with each value in ascending order.
+
+ Description:
+    Visits the values that are not removed as the traversal reaches them.
+    Not a snapshot: concurrent updates may or may not be seen.
+
+ Complexity: Linear in the size.
+ */
+template <class T, class Compare, class Alloc>
+template <class Function>
+void
+concurrent_skiplist<T, Compare, Alloc>::for_each(Function function)
+{
+    epoch_domain::guard guard(_epochs);
+    for (auto node = pointer(_head->links()[0].load(std::memory_order_acquire)); node;) {
+        auto next = node->links()[0].load(std::memory_order_acquire);
+        if (!marked(next))
+            function(static_cast<const_ref>(node->data));
+        node = pointer(next);
+    }
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / emplace
+ Parameters:
+  - element: The value to insert.
+  - args: Arguments to construct the value from.
+ Return value: Whether the value was inserted; false if an equal value was
+               present.
+
+ Description:
+    Links the node at level 0 (the linearization point) and then at each
+    higher level, stopping early if the node is removed meanwhile.
+
+ Complexity: Expected logarithmic without contention.
+ */
+template <class T, class Compare, class Alloc>
+inline bool
+concurrent_skiplist<T, Compare, Alloc>::insert(const_ref element)
+{
+    return emplace(element);
+}
+
+template <class T, class Compare, class Alloc>
+inline bool
+concurrent_skiplist<T, Compare, Alloc>::insert(rvalue_ref element)
+{
+    return emplace(std::move(element));
+}
+
+template <class T, class Compare, class Alloc>
+template <class... Args>
+bool
+concurrent_skiplist<T, Compare, Alloc>::emplace(Args&&... args)
+{
+    auto node = make_node(std::forward<Args>(args)...);
+
+    epoch_domain::guard guard(_epochs);
+    return insert_node(node, guard);
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - element: The value to remove.
+ Return value: Whether this call removed it.
+
+ Description:
+    Marks the node's links from the top down. The thread whose CAS marks
+    level 0 is the one that removed the value.
+
+ Complexity: Expected logarithmic without contention.
+ */
+template <class T, class Compare, class Alloc>
+bool
+concurrent_skiplist<T, Compare, Alloc>::erase(const_ref element)
+{
+    epoch_domain::guard guard(_epochs);
+    Node* preds[max_height];
+    Node* succs[max_height];
+
+    if (!locate(element, preds, succs))
+        return false;
+
+    return remove_node(succs[0], guard);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: insert_node
+ Parameters:
+  - node: A new node with its element constructed.
+  - guard: The caller's pin on the epoch domain.
+ Return value: Whether node was linked; if an equal value was present the
+               node is freed instead.
+ */
+template <class T, class Compare, class Alloc>
+bool
+concurrent_skiplist<T, Compare, Alloc>::insert_node(Node* node, epoch_domain::guard& guard)
+{
+    Node* preds[max_height];
+    Node* succs[max_height];
+
+    for (;;) {
+        if (locate(node->data, preds, succs)) {
+            destroy_node(node, true);
+            return false;
+        }
+
+        for (unsigned i = 0; i < node->height; ++i)
+            node->links()[i].store(word(succs[i]), std::memory_order_relaxed);
+
+        auto expected = word(succs[0]);
+        if (preds[0]->links()[0].compare_exchange_strong(expected, word(node), std::memory_order_release,
+                                                         std::memory_order_relaxed))
+            break;
+    }
+
+    _size.fetch_add(1, std::memory_order_relaxed);
+
+    for (unsigned i = 1; i < node->height; ++i) {
+        for (;;) {
+            // Only a remover changes our links once we are visible, and only
+            // by marking them, so a failed CAS here means we are being removed.
+            auto current = node->links()[i].load(std::memory_order_acquire);
+            if (marked(current))
+                goto done;
+            if (current != word(succs[i])
+                && !node->links()[i].compare_exchange_strong(current, word(succs[i]), std::memory_order_release))
+                goto done;
+
+            auto expected = word(succs[i]);
+            if (preds[i]->links()[i].compare_exchange_strong(expected, word(node), std::memory_order_release,
+                                                             std::memory_order_relaxed))
+                break;
+
+            locate(node->data, preds, succs);
+            if (succs[0] != node)
+                goto done;
+        }
+    }
+
+done:
+    release(node, guard);
+    return true;
+}
+
+
+/*
+ Function: remove_node
+ Parameters:
+  - victim: A node that was reached while pinned.
+  - guard: The caller's pin on the epoch domain.
+ Return value: Whether this call removed it; false if another thread got
+               to level 0 first.
+ */
+template <class T, class Compare, class Alloc>
+bool
+concurrent_skiplist<T, Compare, Alloc>::remove_node(Node* victim, epoch_domain::guard& guard)
+{
+    for (unsigned i = victim->height; i-- > 1;) {
+        auto next = victim->links()[i].load(std::memory_order_acquire);
+        while (!marked(next)
+               && !victim->links()[i].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel));
+    }
+
+    auto next = victim->links()[0].load(std::memory_order_acquire);
+    for (;;) {
+        if (marked(next))
+            return false;
+        if (victim->links()[0].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel))
+            break;
+    }
+
+    _size.fetch_sub(1, std::memory_order_relaxed);
+    release(victim, guard);
+
+    return true;
+}
+
+
+/*
+ Function: locate
+ Parameters:
+  - element: The value being searched for.
+  - preds: Receives the last node before element at each level.
+  - succs: Receives the first node not before element at each level.
+ Return value: Whether succs[0] holds a value equal to element.
+
+ Description:
+    The lock-free search. Snips out every marked node it meets; if a snip
+    fails the predecessor changed under us and the search restarts.
+
+ Complexity: Expected logarithmic without contention.
+ */
+template <class T, class Compare, class Alloc>
+template <class K>
+bool
+concurrent_skiplist<T, Compare, Alloc>::locate(const K& element, Node** preds, Node** succs)
+{
+retry:
+    Node* pred = _head;
+    Node* curr = nullptr;
+
+    for (unsigned i = max_height; i-- > 0;) {
+        curr = pointer(pred->links()[i].load(std::memory_order_acquire));
+        while (curr) {
+            auto succ = curr->links()[i].load(std::memory_order_acquire);
+            while (marked(succ)) {
+                auto expected = word(curr);
+                if (!pred->links()[i].compare_exchange_strong(expected, word(pointer(succ)),
+                                                              std::memory_order_acq_rel))
+                    goto retry;
+
+                curr = pointer(succ);
+                if (!curr)
+                    break;
+                succ = curr->links()[i].load(std::memory_order_acquire);
+            }
+
+            if (!curr || !_compare(curr->data, element))
+                break;
+
+            pred = curr;
+            curr = pointer(succ);
+        }
+
+        preds[i] = pred;
+        succs[i] = curr;
+    }
+
+    return curr && !_compare(element, curr->data);
+}
+
+
+/*
+ Function: wait_free_search
+ Parameters:
+  - element: The value being searched for.
+ Return value: A node holding an equal value that was not removed when it
+               was reached, or null.
+ */
+template <class T, class Compare, class Alloc>
+template <class K>
+typename concurrent_skiplist<T, Compare, Alloc>::Node*
+concurrent_skiplist<T, Compare, Alloc>::wait_free_search(const K& element)
+{
+    Node* pred = _head;
+    Node* curr = nullptr;
+
+    for (unsigned i = max_height; i-- > 0;) {
+        curr = pointer(pred->links()[i].load(std::memory_order_acquire));
+        while (curr) {
+            auto succ = curr->links()[i].load(std::memory_order_acquire);
+            while (marked(succ)) {
+                curr = pointer(succ);
+                if (!curr)
+                    break;
+                succ = curr->links()[i].load(std::memory_order_acquire);
+            }
+
+            if (!curr || !_compare(curr->data, element))
+                break;
+
+            pred = curr;
+            curr = pointer(succ);
+        }
+    }
+
+    return curr && !_compare(element, curr->data) ? curr : nullptr;
+}
+
+
+/*
+ Function: release
+ Parameters:
+  - node: A node whose inserter or remover is done with it.
+  - guard: The caller's pin on the epoch domain.
+
+ Description:
+    The second owner to let go of a removed node runs one more search to
+    snip it from every level it may still be linked at, then retires it.
+ */
+template <class T, class Compare, class Alloc>
+void
+concurrent_skiplist<T, Compare, Alloc>::release(Node* node, epoch_domain::guard& guard)
+{
+    if (node->owners.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    Node* preds[max_height];
+    Node* succs[max_height];
+    locate(node->data, preds, succs);
+
+    guard.retire(node, &reclaim, this);
+}
+
+
+
+
+
+// A lock-free map from unique keys to values. Each node holds its key and
+// an atomic pointer to its value; a value is never changed in place, only
+// replaced by swapping in a new one, so readers copy it without locking.
+template <class Key, class Mapped, class Compare = std::less<Key>,
+          class Alloc = std::allocator<std::pair<const Key, Mapped>>>
+class concurrent_skiplist_map {
+
+public:
+    typedef std::size_t size_type;
+    typedef Key         key_type;
+    typedef Mapped      mapped_type;
+
+private:
+    struct entry {
+        Key key;
+        std::atomic<Mapped*> value;     // Null once the key is erased.
+
+        entry(const Key& k, Mapped* v) : key(k), value(v) {}
+    };
+
+    // Orders entries by key, and keys against entries.
+    struct entry_compare {
+        Compare compare;
+
+        bool operator()(const entry& a, const entry& b) const { return compare(a.key, b.key); }
+        bool operator()(const entry& a, const Key& b) const { return compare(a.key, b); }
+        bool operator()(const Key& a, const entry& b) const { return compare(a, b.key); }
+    };
+
+    typedef concurrent_skiplist<entry, entry_compare, Alloc> list_type;
+    typedef typename list_type::Node Node;
+    typedef typename Alloc::template rebind<Mapped>::other value_alloc;
+
+private:
+    list_type _list;
+
+public:
+    /* Constructors */
+    explicit concurrent_skiplist_map(size_type max_threads = 256) : _list(max_threads) {}
+    concurrent_skiplist_map(const concurrent_skiplist_map<Key, Mapped, Compare, Alloc>&) = delete;
+    concurrent_skiplist_map<Key, Mapped, Compare, Alloc>&
+        operator=(const concurrent_skiplist_map<Key, Mapped, Compare, Alloc>&) = delete;
+    ~concurrent_skiplist_map();
+
+    /* Capacity */
+    bool empty() const { return _list.empty(); }
+    size_type size() const { return _list.size(); }
+
+    /* Element access */
+    bool has(const Key&);
+    bool find(const Key&, Mapped&);
+    template <class Function>
+        void for_each(Function);
+
+    /* Modifiers */
+    template <class M>
+        bool insert(const Key&, M&&);
+    template <class M>
+        bool insert_or_assign(const Key&, M&&);
+    bool erase(const Key&);
+
+/* Helper functions */
+private:
+    template <class M>
+        static Mapped* make_value(M&&);
+    static void free_value(void*, void*);
+    template <class M>
+        bool put(const Key&, M&&, bool);
+};
+
+
+
+// Constructors
+
+/*
+ Function: destructor
+
+ Description:
+    Frees the values of the keys still present; their nodes are freed by
+    the underlying concurrent_skiplist. Erased keys had their values
+    retired when they were erased. No other thread may be using the map.
+ */
+template <class Key, class Mapped, class Compare, class Alloc>
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::~concurrent_skiplist_map()
+{
+    for (auto node = list_type::pointer(_list._head->links()[0].load()); node;
+         node = list_type::pointer(node->links()[0].load()))
+        free_value(nullptr, node->data.value.load());
+}
+
+
+
+// Element access
+
+/*
+ Function: has / find
+ Parameters:
+  - key: The key to look for.
+  - out: Receives a copy of key's value.
+ Return value: Whether key was present.
+
+ Description:
+    Wait-free, as in concurrent_skiplist. A node whose value has been
+    nulled is an erased key whose node has not been unlinked yet.
+
+ Complexity: Expected logarithmic.
+ */
+template <class Key, class Mapped, class Compare, class Alloc>
+bool
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::has(const Key& key)
+{
+    epoch_domain::guard guard(_list._epochs);
+    auto node = _list.wait_free_search(key);
+
+    return node && node->data.value.load(std::memory_order_acquire);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc>
+bool
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::find(const Key& key, Mapped& out)
+{
+    epoch_domain::guard guard(_list._epochs);
+    auto node = _list.wait_free_search(key);
+    auto value = node ? node->data.value.load(std::memory_order_acquire) : nullptr;
+    if (value)
+        out = *value;
+
+    return value != nullptr;
+}
+
+
+/*
+ Function: for_each
+ Parameters:
+  - function: Called as function(key, value) for each key in ascending
+              order.
+
+ Description:
+    Not a snapshot, as in concurrent_skiplist.
+
+ Complexity: Linear in the size.
+ */
+template <class Key, class Mapped, class Compare, class Alloc>
+template <class Function>
+void
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::for_each(Function function)
+{
+    epoch_domain::guard guard(_list._epochs);
+    for (auto node = list_type::pointer(_list._head->links()[0].load(std::memory_order_acquire)); node;) {
+        auto next = node->links()[0].load(std::memory_order_acquire);
+        auto value = node->data.value.load(std::memory_order_acquire);
+        if (!list_type::marked(next) && value)
+            function(static_cast<const Key&>(node->data.key), static_cast<const Mapped&>(*value));
+        node = list_type::pointer(next);
+    }
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / insert_or_assign
+ Parameters:
+  - key: The key to insert.
+  - value: Its value.
+ Return value: Whether key was inserted. insert leaves an existing value
+               alone; insert_or_assign replaces it.
+
+ Complexity: Expected logarithmic without contention.
+ */
+template <class Key, class Mapped, class Compare, class Alloc>
+template <class M>
+inline bool
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::insert(const Key& key, M&& value)
+{
+    return put(key, std::forward<M>(value), false);
+}
+
+template <class Key, class Mapped, class Compare, class Alloc>
+template <class M>
+inline bool
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::insert_or_assign(const Key& key, M&& value)
+{
+    return put(key, std::forward<M>(value), true);
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - key: The key to remove.
+ Return value: Whether this call removed it.
+
+ Description:
+    Nulling the value with a CAS is the linearization point; the old value
+    is retired and the node is then unlinked as in concurrent_skiplist.
+    Any thread that meets a node with a null value finishes unlinking it.
+
+ Complexity: Expected logarithmic without contention.
+ */
+template <class Key, class Mapped, class Compare, class Alloc>
+bool
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::erase(const Key& key)
+{
+    epoch_domain::guard guard(_list._epochs);
+    auto node = _list.wait_free_search(key);
+    if (!node)
+        return false;
+
+    auto value = node->data.value.load(std::memory_order_acquire);
+    while (value && !node->data.value.compare_exchange_weak(value, nullptr, std::memory_order_acq_rel));
+
+    _list.remove_node(node, guard);
+    if (!value)
+        return false;
+
+    guard.retire(value, &free_value, nullptr);
+    return true;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: make_value / free_value
+ Description:
+    Values live in their own allocations so they can be replaced with one
+    CAS and retired through the epoch domain. free_value is also the epoch
+    domain deleter.
+ */
+template <class Key, class Mapped, class Compare, class Alloc>
+template <class M>
+Mapped*
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::make_value(M&& value)
+{
+    value_alloc alloc;
+    auto cell = alloc.allocate(1);
+    try {
+        ::new (cell) Mapped(std::forward<M>(value));
+    } catch (...) {
+        alloc.deallocate(cell, 1);
+        throw;
+    }
+
+    return cell;
+}
+
+template <class Key, class Mapped, class Compare, class Alloc>
+void
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::free_value(void*, void* value)
+{
+    if (!value)
+        return;
+
+    auto cell = static_cast<Mapped*>(value);
+    cell->~Mapped();
+    value_alloc().deallocate(cell, 1);
+}
+
+
+/*
+ Function: put
+ Parameters:
+  - key: The key to insert.
+  - value: Its value.
+  - assign: Whether to replace the value of a key that is present.
+ Return value: Whether key was inserted.
+
+ Description:
+    The value is built once up front. A present key's value is swapped
+    with a CAS, which is where an assignment takes effect. A present node
+    whose value is null is an erase in progress; it is unlinked before
+    retrying, so the new node does not collide with it.
+ */
+template <class Key, class Mapped, class Compare, class Alloc>
+template <class M>
+bool
+concurrent_skiplist_map<Key, Mapped, Compare, Alloc>::put(const Key& key, M&& value, bool assign)
+{
+    auto cell = make_value(std::forward<M>(value));
+
+    epoch_domain::guard guard(_list._epochs);
+    try {
+        for (;;) {
+            if (auto node = _list.wait_free_search(key)) {
+                auto current = node->data.value.load(std::memory_order_acquire);
+                if (!current) {
+                    _list.remove_node(node, guard);
+                    continue;
+                }
+                if (!assign) {
+                    free_value(nullptr, cell);
+                    return false;
+                }
+                if (node->data.value.compare_exchange_strong(current, cell, std::memory_order_acq_rel)) {
+                    guard.retire(current, &free_value, nullptr);
+                    return false;
+                }
+                continue;
+            }
+
+            // A failed insert frees the node but not the value, which is
+            // tried again.
+            if (_list.insert_node(_list.make_node(key, cell), guard))
+                return true;
+        }
+    } catch (...) {
+        free_value(nullptr, cell);
+        throw;
+    }
+}
 
+} // end namespace
 
 #endif /* skiplist_h */
@@ -0,0 +1,739 @@
+/*
+ File:   splay_tree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A splay tree: a self-adjusting search_tree that moves every element it
+    touches to the root. Recently and frequently used elements stay near
+    the top, so skewed access patterns cost much less than log n per
+    operation, and everything is O(log n) amortized.
+
+ Implementation:
+  - Top-down splaying (Sleator and Tarjan). One pass down the search path
+    breaks the tree into a left tree, a right tree and the middle node,
+    then reassembles them. No parent pointers, no recursion and no stack:
+    a node is just two pointers and the element.
+  - Lookups splay too, so has() changes the shape of the tree. The root is
+    mutable; like skiplist's finger this makes even const members
+    non-reentrant.
+  - Insertion splits the tree around the new element and makes it the
+    root. Removal splays the element up and joins its two subtrees by
+    splaying the largest element of the left one.
+  - Merging another splay_tree whose elements all sort after (or before)
+    this tree's is a join: splay this tree's maximum to the root and hang
+    the other tree off it, O(log n) amortized. Interleaved trees are merged
+    by moving the other tree's nodes across in ascending order, splitting
+    this tree around each one. Ascending splits are cheap (the sequential
+    access theorem), and no node is reallocated.
+  - Destruction flattens the tree with right rotations as it goes, so a
+    degenerate (path shaped) tree does not recurse.
+ */
+
+
+#ifndef splay_tree_h
+#define splay_tree_h
+
+#include <functional>        // less
+#include <initializer_list>  // initializer_list
+#include <memory>            // allocator
+#include <utility>           // move, forward, swap
+#include <vector>            // vector
+
+#include "search_tree.h"
+
+namespace ads {
+
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class splay_tree final : public search_tree<T> {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+
+/* Node definition */
+private:
+    struct Node;
+
+    // The links alone double as the header while splaying.
+    struct Links {
+        Node* left = nullptr;
+        Node* right = nullptr;
+    };
+
+    struct Node : Links {
+        T data;
+
+        template <class... Args>
+        explicit Node(Args&&... args) : data(std::forward<Args>(args)...) {}
+    };
+
+    typedef typename Alloc::template rebind<Node>::other node_alloc;
+
+
+/* Data members */
+private:
+    mutable Node* _root = nullptr;   // Lookups splay.
+    Compare _compare;
+    node_alloc _alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    splay_tree() = default;
+    splay_tree(const splay_tree<T, Compare, Alloc>&);
+    splay_tree(splay_tree<T, Compare, Alloc>&&);
+    splay_tree(std::initializer_list<T>);
+    ~splay_tree();
+
+    /* Assignment */
+    splay_tree<T, Compare, Alloc>& operator=(splay_tree<T, Compare, Alloc>);
+
+    /* Element access */
+    bool has(const_ref) const override;
+
+    /* Modifiers */
+    bool insert(const_ref);
+    bool insert(rvalue_ref);
+    template <class... Args>
+        bool emplace(Args&&...);
+    bool erase(const_ref);
+    void add(const_ref) override;
+    void remove(const_ref) override;
+    void swap(splay_tree<T, Compare, Alloc>&);
+    void clear() noexcept override;
+
+    /* Operations */
+    void merge(binary_tree<T>&) override;
+    void merge(binary_tree<T>&&) override;
+    void for_each(const std::function<void(const_ref)>&) const override;
+
+/* Helper functions */
+private:
+    template <class... Args>
+        Node* create_node(Args&&...);
+    void destroy_node(Node*);
+
+    template <class Direction>
+        static Node* splay_by(Node*, Direction);
+    Node* splay(Node*, const_ref) const;
+    static Node* splay_min(Node*);
+    static Node* splay_max(Node*);
+    int order(const Node*, const_ref) const;
+
+    void link_root(Node*);
+    void merge_nodes(splay_tree<T, Compare, Alloc>&);
+};
+
+
+
+// Node management
+
+/*
+ Function: create_node / destroy_node
+ Parameters:
+  - args: Arguments forwarded to the element's constructor.
+  - node: The node to free.
+
+ Description:
+    create_node leaks nothing if the element's constructor throws.
+ */
+template <class T, class Compare, class Alloc>
+template <class... Args>
+typename splay_tree<T, Compare, Alloc>::Node*
+splay_tree<T, Compare, Alloc>::create_node(Args&&... args)
+{
+    auto node = _alloc.allocate(1);
+    try {
+        ::new (static_cast<void*>(node)) Node(std::forward<Args>(args)...);
+    } catch (...) {
+        _alloc.deallocate(node, 1);
+        throw;
+    }
+
+    return node;
+}
+
+template <class T, class Compare, class Alloc>
+inline void
+splay_tree<T, Compare, Alloc>::destroy_node(Node* node)
+{
+    node->~Node();
+    _alloc.deallocate(node, 1);
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The tree being copied or moved from.
+  - il: Initializer list of elements, in any order.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty tree (defaulted in the class).
+  2. independent copy of rhs with the same shape.
+  3. tree that takes over rhs's nodes, leaving rhs empty.
+  4. tree holding the distinct elements of il.
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs.
+  3. Constant.
+  4. n log n amortized in the size of il.
+ */
+
+// 2. copy
+template <class T, class Compare, class Alloc>
+splay_tree<T, Compare, Alloc>::splay_tree(const splay_tree<T, Compare, Alloc>& rhs)
+    : _compare(rhs._compare)
+{
+    // Each copy is linked in before its children are copied, so a throwing
+    // element copy leaves a tree the destructor can free.
+    std::vector<std::pair<const Node*, Node**>> pending;
+    if (rhs._root)
+        pending.emplace_back(rhs._root, &_root);
+
+    try {
+        while (!pending.empty()) {
+            auto source = pending.back().first;
+            auto slot = pending.back().second;
+            pending.pop_back();
+
+            *slot = create_node(source->data);
+            if (source->left)
+                pending.emplace_back(source->left, &(*slot)->left);
+            if (source->right)
+                pending.emplace_back(source->right, &(*slot)->right);
+        }
+    } catch (...) {
+        clear();
+        throw;
+    }
+    this->_size = rhs._size;
+}
+
+// 3. move
+template <class T, class Compare, class Alloc>
+splay_tree<T, Compare, Alloc>::splay_tree(splay_tree<T, Compare, Alloc>&& rhs)
+{
+    swap(rhs);
+}
+
+// 4. initializer list
+template <class T, class Compare, class Alloc>
+splay_tree<T, Compare, Alloc>::splay_tree(std::initializer_list<T> il)
+{
+    for (auto& element : il)
+        insert(element);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Compare, class Alloc>
+splay_tree<T, Compare, Alloc>::~splay_tree()
+{
+    clear();
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this tree.
+ */
+template <class T, class Compare, class Alloc>
+splay_tree<T, Compare, Alloc>&
+splay_tree<T, Compare, Alloc>::operator=(splay_tree<T, Compare, Alloc> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Element access
+
+/*
+ Function: has
+ Parameters:
+  - element: The value to look for.
+ Return value: Whether element is present.
+
+ Description:
+    Splays element, or the last node on its search path, to the root.
+
+ Complexity: Logarithmic amortized.
+ */
+template <class T, class Compare, class Alloc>
+bool
+splay_tree<T, Compare, Alloc>::has(const_ref element) const
+{
+    if (!_root)
+        return false;
+
+    _root = splay(_root, element);
+    return order(_root, element) == 0;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / emplace
+ Parameters:
+  - element: The value to insert.
+  - args: Arguments to construct the value from.
+ Return value: Whether the value was inserted (false if already present).
+
+ Description:
+    The value ends up at the root either way. insert only constructs a
+    node once it knows the value is absent; emplace has to build the value
+    before it can search for it.
+
+ Complexity: Logarithmic amortized.
+ */
+template <class T, class Compare, class Alloc>
+bool
+splay_tree<T, Compare, Alloc>::insert(const_ref element)
+{
+    if (has(element))
+        return false;
+
+    link_root(create_node(element));
+    return true;
+}
+
+template <class T, class Compare, class Alloc>
+bool
+splay_tree<T, Compare, Alloc>::insert(rvalue_ref element)
+{
+    if (has(element))
+        return false;
+
+    link_root(create_node(std::move(element)));
+    return true;
+}
+
+template <class T, class Compare, class Alloc>
+template <class... Args>
+bool
+splay_tree<T, Compare, Alloc>::emplace(Args&&... args)
+{
+    auto node = create_node(std::forward<Args>(args)...);
+    if (has(node->data)) {
+        destroy_node(node);
+        return false;
+    }
+
+    link_root(node);
+    return true;
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - element: The value to remove.
+ Return value: Whether the value was present.
+
+ Description:
+    Splays element to the root, then joins its subtrees: splaying the
+    left subtree's maximum leaves it with no right child to take the
+    right subtree.
+
+ Complexity: Logarithmic amortized.
+ */
+template <class T, class Compare, class Alloc>
+bool
+splay_tree<T, Compare, Alloc>::erase(const_ref element)
+{
+    if (!has(element))
+        return false;
+
+    auto node = _root;
+    if (node->left) {
+        _root = splay_max(node->left);
+        _root->right = node->right;
+    } else {
+        _root = node->right;
+    }
+
+    destroy_node(node);
+    --this->_size;
+    return true;
+}
+
+
+/*
+ Function: add / remove
+ Parameters:
+  - element: The value to insert or remove.
+
+ Description:
+    The binary_tree interface to insert and erase.
+ */
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::add(const_ref element)
+{
+    insert(element);
+}
+
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::remove(const_ref element)
+{
+    erase(element);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - other: The tree to exchange contents with.
+
+ Complexity: Constant.
+ */
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::swap(splay_tree<T, Compare, Alloc>& other)
+{
+    using std::swap;
+    swap(_root, other._root);
+    swap(this->_size, other._size);
+    swap(_compare, other._compare);
+    swap(_alloc, other._alloc);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every element. Left children are rotated up until the node in
+    hand has none, then it is freed and its right child taken, so this
+    needs no recursion or stack whatever the tree's shape.
+ Complexity: Linear.
+ */
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::clear() noexcept
+{
+    auto node = _root;
+    while (node) {
+        if (auto left = node->left) {
+            node->left = left->right;
+            left->right = node;
+            node = left;
+        } else {
+            auto right = node->right;
+            destroy_node(node);
+            node = right;
+        }
+    }
+
+    _root = nullptr;
+    this->_size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: merge
+ Parameters:
+  - other: The tree to move every element out of.
+ Return value: None
+
+ Description:
+    Moves the elements of other into this tree, leaving other empty.
+    Elements already present here stay and other's copy is dropped. A
+    splay_tree of the same type has its nodes moved across (joined whole
+    when the two trees do not overlap); any other binary_tree has its
+    elements copied in.
+
+ Complexity: Logarithmic amortized for non-overlapping splay_trees;
+             m log(n + m) amortized otherwise.
+ */
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::merge(binary_tree<T>& other)
+{
+    if (&other == this)
+        return;
+
+    if (auto same = dynamic_cast<splay_tree<T, Compare, Alloc>*>(&other)) {
+        merge_nodes(*same);
+        return;
+    }
+
+    other.for_each([this](const_ref element){ insert(element); });
+    other.clear();
+}
+
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::merge(binary_tree<T>&& other)
+{
+    merge(other);
+}
+
+
+/*
+ Function: for_each
+ Parameters:
+  - visit: Called with each element in ascending order.
+
+ Description:
+    Does not splay. Uses an explicit stack since the tree may be deep.
+
+ Complexity: Linear.
+ */
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::for_each(const std::function<void(const_ref)>& visit) const
+{
+    std::vector<const Node*> path;
+    for (const Node* node = _root; node || !path.empty();) {
+        if (node) {
+            path.push_back(node);
+            node = node->left;
+        } else {
+            node = path.back();
+            path.pop_back();
+            visit(node->data);
+            node = node->right;
+        }
+    }
+}
+
+
+
+// Helper functions
+
+/*
+ Function: splay_by
+ Parameters:
+  - root: The root of a non-empty subtree.
+  - direction: Given a node, returns negative to go left, positive to go
+               right and zero to stop.
+ Return value: The new root of the subtree: the node direction stopped at,
+               or the last node on the path if it ran off the tree.
+
+ Description:
+    Top-down splay. Nodes passed on the way down are hung off the left
+    tree (everything smaller than the target) or the right tree
+    (everything larger), with a rotation first on zig-zig steps. The
+    header's links collect the two trees' roots.
+
+ Complexity: Logarithmic amortized.
+ */
+template <class T, class Compare, class Alloc>
+template <class Direction>
+typename splay_tree<T, Compare, Alloc>::Node*
+splay_tree<T, Compare, Alloc>::splay_by(Node* root, Direction direction)
+{
+    Links header;
+    Links* left_max = &header;    // Largest node of the left tree.
+    Links* right_min = &header;   // Smallest node of the right tree.
+
+    for (;;) {
+        auto way = direction(root);
+        if (way < 0) {
+            if (!root->left)
+                break;
+            if (direction(root->left) < 0) {
+                auto child = root->left;
+                root->left = child->right;
+                child->right = root;
+                root = child;
+                if (!root->left)
+                    break;
+            }
+            right_min->left = root;
+            right_min = root;
+            root = root->left;
+        } else if (way > 0) {
+            if (!root->right)
+                break;
+            if (direction(root->right) > 0) {
+                auto child = root->right;
+                root->right = child->left;
+                child->left = root;
+                root = child;
+                if (!root->right)
+                    break;
+            }
+            left_max->right = root;
+            left_max = root;
+            root = root->right;
+        } else {
+            break;
+        }
+    }
+
+    left_max->right = root->left;
+    right_min->left = root->right;
+    root->left = header.right;
+    root->right = header.left;
+
+    return root;
+}
+
+
+/*
+ Function: splay / splay_min / splay_max
+ Parameters:
+  - root: The root of a non-empty subtree.
+  - element: The value to splay towards.
+ Return value: The new root: element's node, its neighbour on the search
+               path, or the subtree's smallest or largest node.
+ */
+template <class T, class Compare, class Alloc>
+inline typename splay_tree<T, Compare, Alloc>::Node*
+splay_tree<T, Compare, Alloc>::splay(Node* root, const_ref element) const
+{
+    return splay_by(root, [&](const Node* node){ return -order(node, element); });
+}
+
+template <class T, class Compare, class Alloc>
+inline typename splay_tree<T, Compare, Alloc>::Node*
+splay_tree<T, Compare, Alloc>::splay_min(Node* root)
+{
+    return splay_by(root, [](const Node*){ return -1; });
+}
+
+template <class T, class Compare, class Alloc>
+inline typename splay_tree<T, Compare, Alloc>::Node*
+splay_tree<T, Compare, Alloc>::splay_max(Node* root)
+{
+    return splay_by(root, [](const Node*){ return 1; });
+}
+
+
+/*
+ Function: order
+ Return value: Negative, zero or positive as node's element sorts before,
+               with or after element.
+ */
+template <class T, class Compare, class Alloc>
+inline int
+splay_tree<T, Compare, Alloc>::order(const Node* node, const_ref element) const
+{
+    if (_compare(node->data, element))
+        return -1;
+    return _compare(element, node->data) ? 1 : 0;
+}
+
+
+/*
+ Function: link_root
+ Parameters:
+  - node: A new node whose element is absent, after a splay for it.
+
+ Description:
+    Splits the tree around the root, which is the new element's neighbour,
+    and makes node the root over the two halves.
+ */
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::link_root(Node* node)
+{
+    if (_root) {
+        if (order(_root, node->data) > 0) {
+            node->left = _root->left;
+            node->right = _root;
+            _root->left = nullptr;
+        } else {
+            node->right = _root->right;
+            node->left = _root;
+            _root->right = nullptr;
+        }
+    }
+
+    _root = node;
+    ++this->_size;
+}
+
+
+/*
+ Function: merge_nodes
+ Parameters:
+  - other: A tree of the same type to take every node from.
+
+ Description:
+    Joins the trees outright when one's maximum sorts before the other's
+    minimum. Otherwise takes other's nodes in ascending order, each one
+    split off as other's minimum, and links it in as this tree's root.
+
+ Complexity: Logarithmic amortized when the trees do not overlap;
+             m log(n + m) amortized otherwise.
+ */
+template <class T, class Compare, class Alloc>
+void
+splay_tree<T, Compare, Alloc>::merge_nodes(splay_tree<T, Compare, Alloc>& other)
+{
+    if (!other._root)
+        return;
+    if (!_root) {
+        swap(other);
+        return;
+    }
+
+    _root = splay_max(_root);
+    other._root = splay_min(other._root);
+    if (_compare(_root->data, other._root->data)) {
+        _root->right = other._root;
+        this->_size += other._size;
+        other._root = nullptr;
+        other._size = 0;
+        return;
+    }
+
+    _root = splay_min(_root);
+    other._root = splay_max(other._root);
+    if (_compare(other._root->data, _root->data)) {
+        _root->left = other._root;
+        this->_size += other._size;
+        other._root = nullptr;
+        other._size = 0;
+        return;
+    }
+
+    other._root = splay_min(other._root);
+    while (other._root) {
+        auto node = other._root;
+        other._root = node->right ? splay_min(node->right) : nullptr;
+        node->left = node->right = nullptr;
+
+        if (has(node->data))
+            destroy_node(node);
+        else
+            link_root(node);
+    }
+    other._size = 0;
+}
+
+
+} // end namespace
+
+#endif /* splay_tree_h */
@@ -1,65 +1,883 @@
 /*
  File:   stack.h
  Author: Kyle Thompson
- 
+
  Purpose:
- A stack using an arbitrary backing store.
- 
+ A stack using an arbitrary backing store, and a lock-free stack for
+ sharing between threads.
+
  Implementation:
- 
- 
- TODO:
- - Separate function implementations from class definition.
- - Fill in implementation ^^^.
+  - The default backing store is a small_vector (vector.h): elements are
+    contiguous, the first cache line's worth lives inside the stack object
+    itself, and past that the buffer doubles. Pushes and pops therefore
+    never allocate per element, unlike a list<T> backing store.
+  - Any container with push_back, emplace_back, pop_back, last, size and
+    clear can be used instead. Bulk operations use the container's append
+    and pop_back(n) when it has them and fall back to element loops.
+  - concurrent_stack is a Treiber stack. Its head pointer carries a counter
+    that is bumped on every successful CAS so a node that is popped and
+    pushed back between a thread's read and its CAS (ABA) is detected.
+    With a double-width CAS (x86-64 built with -mcx16) the counter is a
+    full word next to the pointer; otherwise it is packed into the unused
+    upper bits of a 64 bit word.
+  - Popped nodes go onto an internal free list and are reused rather than
+    freed, so a thread that read a stale head can always safely read its
+    next pointer. Nodes are only returned to the allocator by the
+    destructor.
+  - Under contention a thread whose CAS fails visits a random slot of an
+    elimination array, where a concurrent push and pop can hand a node
+    directly to each other without touching the head at all.
  */
 
 
 #ifndef stack_h
 #define stack_h
 
+#include <atomic>       // atomic
+#include <cstdint>      // uint64_t, uintptr_t
+#include <functional>   // hash
+#include <memory>       // allocator, unique_ptr
+#include <thread>       // yield
+#include <type_traits>  // aligned_storage
+#include <utility>      // move, forward
+
 #include "list.h"
+#include "vector.h"
+
+namespace ads {
+
+/*
+ The default number of elements kept inline: as many as fit in 64 bytes, and
+ at least one.
+ */
+template <class T>
+struct stack_inline_capacity {
+    static constexpr std::size_t value = sizeof(T) < 64 ? 64 / sizeof(T) : 1;
+};
 
-template <class T, class C = list<T, Alloc>>
+template <class T, class C = small_vector<T, stack_inline_capacity<T>::value>>
 class stack {
-    
+
 
 /* Type definitions */
 public:
     typedef std::size_t size_type;
     typedef C           container_type;
+    typedef T           value_type;
     typedef T&          reference;
+    typedef T&&         rvalue_ref;
     typedef const T&    const_ref;
-    
+
+
+/* Data members */
+private:
+    container_type _container;
+
+
 /* Member functions */
 public:
     /* Capacity */
-    size_type size() {
-        return _container.size();
-    }
-    
+    bool empty() const;
+    size_type size() const;
+
     /* Element access */
-    reference top() {
-        return _container.last();
-    }
-    
+    reference top();
+
     /* Modifiers */
-    void push(const_ref element) {
-        _container.push_back(element);
-    }
-    
-    void pop() {
+    void push(const_ref);
+    void push(rvalue_ref);
+    template <class... Args>
+        void emplace(Args&&...);
+    template <class InputIt>
+        void push_range(InputIt, InputIt);
+    value_type pop();
+    void pop_n(size_type);
+    template <class OutputIt>
+        OutputIt pop_n(size_type, OutputIt);
+    void clear();
+
+/* Helper functions */
+private:
+    template <class D, class InputIt>
+        static auto append(D&, InputIt, InputIt, int) -> decltype(std::declval<D&>().append(std::declval<InputIt>(), std::declval<InputIt>()));
+    template <class D, class InputIt>
+        static void append(D&, InputIt, InputIt, long);
+    template <class D>
+        static auto drop(D&, size_type, int) -> decltype(std::declval<D&>().pop_back(size_type()));
+    template <class D>
+        static void drop(D&, size_type, long);
+};
+
+
+
+// Capacity
+
+/*
+ Function: empty
+ Parameters: None
+ Return value: Whether or not the stack is empty.
+ */
+template <class T, class C>
+inline bool
+stack<T, C>::empty() const
+{
+    return _container.size() == 0;
+}
+
+
+/*
+ Function: size
+ Parameters: None
+ Return value: The number of elements on the stack.
+ */
+template <class T, class C>
+inline typename stack<T, C>::size_type
+stack<T, C>::size() const
+{
+    return _container.size();
+}
+
+
+
+// Element access
+
+/*
+ Function: top
+ Parameters: None
+ Return value: A reference to the most recently pushed element.
+ */
+template <class T, class C>
+inline typename stack<T, C>::reference
+stack<T, C>::top()
+{
+    return _container.last();
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push
+ Parameters:
+  - element: The element to push.
+ Return value: None
+
+ Complexity: That of the container's push_back. Amortized constant by
+             default.
+ */
+template <class T, class C>
+inline void
+stack<T, C>::push(const_ref element)
+{
+    _container.push_back(element);
+}
+
+template <class T, class C>
+inline void
+stack<T, C>::push(rvalue_ref element)
+{
+    _container.push_back(std::move(element));
+}
+
+
+/*
+ Function: emplace
+ Parameters:
+  - args: Arguments used to construct the new element in place.
+ Return value: None
+ */
+template <class T, class C>
+template <class... Args>
+inline void
+stack<T, C>::emplace(Args&&... args)
+{
+    _container.emplace_back(std::forward<Args>(args)...);
+}
+
+
+/*
+ Function: push_range
+ Parameters:
+  - first: The first element to push.
+  - last: One past the last element to push.
+ Return value: None
+
+ Description:
+    Pushes every element of [first, last) in order, so *(last - 1) ends
+    up on top.
+
+ Complexity: Linear in the length of the range. With the default container
+             a forward range causes at most one reallocation.
+ */
+template <class T, class C>
+template <class InputIt>
+inline void
+stack<T, C>::push_range(InputIt first, InputIt last)
+{
+    append(_container, first, last, 0);
+}
+
+
+/*
+ Function: pop
+ Parameters: None
+ Return value: The element that was on top, moved out of the stack.
+
+ Complexity: Constant.
+ */
+template <class T, class C>
+inline typename stack<T, C>::value_type
+stack<T, C>::pop()
+{
+    value_type element = std::move(_container.last());
+    _container.pop_back();
+
+    return element;
+}
+
+
+/*
+ Function: pop_n
+ Parameters:
+  - n: The number of elements to pop.
+  - out: Receives the popped elements, top first.
+ Return value: None, or out advanced past the last written element.
+
+ Description:
+    1. Discards the top n elements.
+    2. Moves the top n elements into out, then discards them.
+
+ Complexity: Linear in n.
+ */
+
+// 1. discard
+template <class T, class C>
+inline void
+stack<T, C>::pop_n(size_type n)
+{
+    assert(n <= size());
+    drop(_container, n, 0);
+}
+
+// 2. move out
+template <class T, class C>
+template <class OutputIt>
+OutputIt
+stack<T, C>::pop_n(size_type n, OutputIt out)
+{
+    assert(n <= size());
+    for (size_type i = 0; i < n; ++i) {
+        *out++ = std::move(_container.last());
         _container.pop_back();
     }
-    
-    void clear() {
-        _container.clear();
-    }
-    
 
-    
+    return out;
+}
+
+
+/*
+ Function: clear
+ Parameters: None
+ Return value: None
+ */
+template <class T, class C>
+inline void
+stack<T, C>::clear()
+{
+    _container.clear();
+}
+
+
+
+// Helper functions
+
+/*
+ Function: append / drop
+
+ Description:
+    Dispatch the bulk operations to the container's own append and
+    pop_back(n) when it provides them (the int overloads are preferred and
+    drop out by SFINAE otherwise), and to element loops when it does not.
+ */
+template <class T, class C>
+template <class D, class InputIt>
+inline auto
+stack<T, C>::append(D& c, InputIt first, InputIt last, int)
+    -> decltype(std::declval<D&>().append(std::declval<InputIt>(), std::declval<InputIt>()))
+{
+    return c.append(first, last);
+}
+
+template <class T, class C>
+template <class D, class InputIt>
+inline void
+stack<T, C>::append(D& c, InputIt first, InputIt last, long)
+{
+    for (; first != last; ++first)
+        c.push_back(*first);
+}
+
+template <class T, class C>
+template <class D>
+inline auto
+stack<T, C>::drop(D& c, size_type n, int)
+    -> decltype(std::declval<D&>().pop_back(size_type()))
+{
+    return c.pop_back(n);
+}
+
+template <class T, class C>
+template <class D>
+inline void
+stack<T, C>::drop(D& c, size_type n, long)
+{
+    while (n-- > 0)
+        c.pop_back();
+}
+
+
+
+
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define ADS_STACK_DWCAS 1
+#else
+#define ADS_STACK_DWCAS 0
+#endif
+
+template <class T, class Alloc = std::allocator<T>>
+class concurrent_stack {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+
+/* Node definition */
 private:
-    container_type _container;
-    
+    class Node {
+
+    public:
+        std::atomic<Node*> next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        Node() : next(nullptr) {}
+        T& data() { return *reinterpret_cast<T*>(&storage); }
+    };
+
+
+/* Tagged pointer definition */
+private:
+    class Tagged {
+
+    public:
+        struct Snapshot {
+            Node* ptr;
+            std::uint64_t tag;
+
+            bool operator==(const Snapshot& rhs) const { return ptr == rhs.ptr && tag == rhs.tag; }
+            bool operator!=(const Snapshot& rhs) const { return !(*this == rhs); }
+        };
+
+        Tagged();
+        Snapshot load();
+        bool compare_exchange(Snapshot&, Node*);
+
+    private:
+#if ADS_STACK_DWCAS
+        __extension__ typedef unsigned __int128 word_type;
+        alignas(16) std::uint64_t _word[2];   // Low word is the pointer (little endian).
+#else
+        typedef std::uint64_t word_type;
+        std::atomic<word_type> _word;
+#endif
+
+        static word_type pack(Node*, std::uint64_t);
+        static Snapshot unpack(word_type);
+    };
+
+    struct Slot {
+        Tagged offer;
+        char pad[64 - sizeof(Tagged)];
+    };
+
+
+/* Data members */
+private:
+    Tagged _head;
+    char _pad_head[64 - sizeof(Tagged)];
+    Tagged _free;
+    char _pad_free[64 - sizeof(Tagged)];
+    std::unique_ptr<Slot[]> _slots;     // Elimination array.
+    size_type _slot_count;
+    size_type _spin;                    // How long an offer waits in a slot.
+    typename Alloc::template rebind<Node>::other _alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit concurrent_stack(size_type = 8, size_type = 256);
+    concurrent_stack(const concurrent_stack<T, Alloc>&) = delete;
+    concurrent_stack<T, Alloc>& operator=(const concurrent_stack<T, Alloc>&) = delete;
+    ~concurrent_stack();
+
+    /* Capacity */
+    bool empty();
+    static constexpr bool double_width_cas() { return ADS_STACK_DWCAS; }
+
+    /* Modifiers */
+    void push(const_ref);
+    void push(rvalue_ref);
+    template <class... Args>
+        void emplace(Args&&...);
+    bool try_pop(reference);
+
+/* Helper functions */
+private:
+    Node* acquire_node();
+    static void push_node(Tagged&, Node*);
+    static Node* pop_node(Tagged&);
+    void push_shared(Node*);
+    Node* pop_shared();
+    bool eliminate_push(Node*);
+    Node* eliminate_pop();
+    Slot& random_slot();
 };
 
+
+
+// Tagged pointer
+
+/*
+ Function: tagged constructor
+
+ Description:
+    A null pointer with a zero counter.
+ */
+template <class T, class Alloc>
+concurrent_stack<T, Alloc>::Tagged::Tagged()
+    : _word()
+{}
+
+
+/*
+ Function: pack / unpack
+ Parameters:
+  - ptr: The pointer half.
+  - tag: The counter half. Truncated to the bits available.
+  - word: A packed word.
+
+ Description:
+    With a double-width CAS the pointer takes the low word and the tag the
+    high word. Otherwise 64 bit targets keep the pointer in the low 48 bits
+    (all current x86-64 and AArch64 user space addresses fit) and the tag
+    in the top 16, and 32 bit targets split the word evenly.
+ */
+template <class T, class Alloc>
+inline typename concurrent_stack<T, Alloc>::Tagged::word_type
+concurrent_stack<T, Alloc>::Tagged::pack(Node* ptr, std::uint64_t tag)
+{
+    auto address = static_cast<word_type>(reinterpret_cast<std::uintptr_t>(ptr));
+#if ADS_STACK_DWCAS
+    return address | (static_cast<word_type>(tag) << 64);
+#else
+    const unsigned shift = sizeof(void*) == 8 ? 48 : 32;
+    return address | (static_cast<word_type>(tag) << shift);
+#endif
+}
+
+template <class T, class Alloc>
+inline typename concurrent_stack<T, Alloc>::Tagged::Snapshot
+concurrent_stack<T, Alloc>::Tagged::unpack(word_type word)
+{
+#if ADS_STACK_DWCAS
+    return Snapshot{ reinterpret_cast<Node*>(static_cast<std::uintptr_t>(word)),
+                     static_cast<std::uint64_t>(word >> 64) };
+#else
+    const unsigned shift = sizeof(void*) == 8 ? 48 : 32;
+    const word_type mask = (word_type(1) << shift) - 1;
+    return Snapshot{ reinterpret_cast<Node*>(static_cast<std::uintptr_t>(word & mask)),
+                     static_cast<std::uint64_t>(word >> shift) };
+#endif
+}
+
+
+/*
+ Function: load
+ Return value: The current pointer and counter.
+
+ Description:
+    A double-width word has no plain atomic load, and emulating one with a
+    CAS would make every reader write the cache line. The two halves are
+    read separately instead: a torn pair never matches the word as a
+    whole, so the CAS that follows simply fails and the caller retries,
+    and the pointer half always names a live node because nodes are never
+    freed while the stack is in use.
+ */
+template <class T, class Alloc>
+inline typename concurrent_stack<T, Alloc>::Tagged::Snapshot
+concurrent_stack<T, Alloc>::Tagged::load()
+{
+#if ADS_STACK_DWCAS
+    auto tag = __atomic_load_n(&_word[1], __ATOMIC_ACQUIRE);
+    auto ptr = __atomic_load_n(&_word[0], __ATOMIC_ACQUIRE);
+    return unpack(static_cast<word_type>(ptr) | (static_cast<word_type>(tag) << 64));
+#else
+    return unpack(_word.load(std::memory_order_acquire));
+#endif
+}
+
+
+/*
+ Function: compare_exchange
+ Parameters:
+  - expected: The value believed to be current. Updated to the value seen
+              on failure, or to the value written on success.
+  - desired: The new pointer. Its counter is expected's plus one.
+ Return value: Whether the exchange happened.
+
+ Description:
+    A full-barrier CAS of pointer and counter together.
+ */
+template <class T, class Alloc>
+inline bool
+concurrent_stack<T, Alloc>::Tagged::compare_exchange(Snapshot& expected, Node* desired)
+{
+    auto old_word = pack(expected.ptr, expected.tag);
+    auto new_word = pack(desired, expected.tag + 1);
+
+#if ADS_STACK_DWCAS
+    auto seen = __sync_val_compare_and_swap(reinterpret_cast<word_type*>(_word), old_word, new_word);
+    bool success = seen == old_word;
+#else
+    auto seen = old_word;
+    bool success = _word.compare_exchange_strong(seen, new_word, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire);
+#endif
+
+    expected = unpack(success ? new_word : seen);
+    return success;
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - slots: The number of elimination slots. Zero disables elimination.
+  - spin: How many times a push offered in a slot polls for a partner
+          before withdrawing.
+
+ Description:
+    Makes an empty stack.
+
+ Complexity: Linear in slots.
+ */
+template <class T, class Alloc>
+concurrent_stack<T, Alloc>::concurrent_stack(size_type slots, size_type spin)
+    : _slots(slots ? new Slot[slots] : nullptr)
+    , _slot_count(slots)
+    , _spin(spin)
+{}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Destroys the remaining elements and frees every node, including those
+    on the free list. No other thread may be using the stack.
+
+ Complexity: Linear in the number of nodes ever live at once.
+ */
+template <class T, class Alloc>
+concurrent_stack<T, Alloc>::~concurrent_stack()
+{
+    while (auto node = pop_node(_head)) {
+        node->data().~T();
+        _alloc.destroy(node);
+        _alloc.deallocate(node, 1);
+    }
+
+    while (auto node = pop_node(_free)) {
+        _alloc.destroy(node);
+        _alloc.deallocate(node, 1);
+    }
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty
+ Return value: Whether the stack was empty at the moment it was checked.
+ */
+template <class T, class Alloc>
+inline bool
+concurrent_stack<T, Alloc>::empty()
+{
+    return _head.load().ptr == nullptr;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push
+ Parameters:
+  - element: The element to push.
+ Return value: None
+
+ Description:
+    Pushes an element. Lock-free: some thread always makes progress.
+
+ Complexity: Constant without contention.
+ */
+template <class T, class Alloc>
+inline void
+concurrent_stack<T, Alloc>::push(const_ref element)
+{
+    emplace(element);
+}
+
+template <class T, class Alloc>
+inline void
+concurrent_stack<T, Alloc>::push(rvalue_ref element)
+{
+    emplace(std::move(element));
+}
+
+
+/*
+ Function: emplace
+ Parameters:
+  - args: Arguments used to construct the new element.
+ Return value: None
+ */
+template <class T, class Alloc>
+template <class... Args>
+void
+concurrent_stack<T, Alloc>::emplace(Args&&... args)
+{
+    auto node = acquire_node();
+    try {
+        ::new (&node->storage) T(std::forward<Args>(args)...);
+    } catch (...) {
+        push_node(_free, node);
+        throw;
+    }
+
+    push_shared(node);
+}
+
+
+/*
+ Function: try_pop
+ Parameters:
+  - out: Receives the popped element.
+ Return value: Whether an element was popped. False means the stack was
+               empty at some point during the call.
+
+ Complexity: Constant without contention.
+ */
+template <class T, class Alloc>
+bool
+concurrent_stack<T, Alloc>::try_pop(reference out)
+{
+    auto node = pop_shared();
+    if (!node)
+        return false;
+
+    out = std::move(node->data());
+    node->data().~T();
+    push_node(_free, node);
+
+    return true;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: acquire_node
+ Return value: A node without an element, recycled when possible.
+ */
+template <class T, class Alloc>
+typename concurrent_stack<T, Alloc>::Node*
+concurrent_stack<T, Alloc>::acquire_node()
+{
+    if (auto node = pop_node(_free))
+        return node;
+
+    auto node = _alloc.allocate(1);
+    _alloc.construct(node);
+
+    return node;
+}
+
+
+/*
+ Function: push_node / pop_node
+ Parameters:
+  - head: The tagged head of a Treiber stack.
+  - node: The node to link in.
+ Return value: None, or the unlinked node (null if the stack was empty).
+
+ Description:
+    Plain Treiber push and pop. Used directly for the free list, and as the
+    first attempt for the element stack.
+ */
+template <class T, class Alloc>
+void
+concurrent_stack<T, Alloc>::push_node(Tagged& head, Node* node)
+{
+    auto top = head.load();
+    do {
+        node->next.store(top.ptr, std::memory_order_relaxed);
+    } while (!head.compare_exchange(top, node));
+}
+
+template <class T, class Alloc>
+typename concurrent_stack<T, Alloc>::Node*
+concurrent_stack<T, Alloc>::pop_node(Tagged& head)
+{
+    for (auto top = head.load(); top.ptr;) {
+        auto node = top.ptr;
+        if (head.compare_exchange(top, node->next.load(std::memory_order_relaxed)))
+            return node;
+    }
+
+    return nullptr;
+}
+
+
+/*
+ Function: push_shared / pop_shared
+ Parameters:
+  - node: A node holding an element.
+ Return value: None, or a node holding an element (null if empty).
+
+ Description:
+    Treiber push and pop on the element stack, falling back to the
+    elimination array each time a CAS on the head loses a race.
+ */
+template <class T, class Alloc>
+void
+concurrent_stack<T, Alloc>::push_shared(Node* node)
+{
+    auto top = _head.load();
+    for (;;) {
+        node->next.store(top.ptr, std::memory_order_relaxed);
+        if (_head.compare_exchange(top, node) || eliminate_push(node))
+            return;
+        top = _head.load();
+    }
+}
+
+template <class T, class Alloc>
+typename concurrent_stack<T, Alloc>::Node*
+concurrent_stack<T, Alloc>::pop_shared()
+{
+    for (;;) {
+        auto top = _head.load();
+        if (!top.ptr)
+            return nullptr;
+
+        auto expected = top;
+        if (_head.compare_exchange(expected, top.ptr->next.load(std::memory_order_relaxed)))
+            return top.ptr;
+
+        if (auto node = eliminate_pop())
+            return node;
+    }
+}
+
+
+/*
+ Function: eliminate_push
+ Parameters:
+  - node: The node being pushed.
+ Return value: Whether a concurrent pop took the node.
+
+ Description:
+    Offers the node in a random free slot and polls for a partner. If none
+    arrives the offer is withdrawn with a CAS; losing that CAS means a pop
+    took the node just in time. The slot's counter keeps a recycled node
+    offered again by another thread from being mistaken for ours.
+ */
+template <class T, class Alloc>
+bool
+concurrent_stack<T, Alloc>::eliminate_push(Node* node)
+{
+    if (_slot_count == 0)
+        return false;
+
+    auto& slot = random_slot().offer;
+    auto offered = slot.load();
+    if (offered.ptr || !slot.compare_exchange(offered, node))
+        return false;
+
+    for (size_type i = 0; i < _spin; ++i) {
+        if (slot.load() != offered)
+            return true;
+        if ((i & 31) == 31)
+            std::this_thread::yield();
+    }
+
+    return !slot.compare_exchange(offered, nullptr);
+}
+
+
+/*
+ Function: eliminate_pop
+ Return value: A node taken from a waiting push, or null.
+ */
+template <class T, class Alloc>
+typename concurrent_stack<T, Alloc>::Node*
+concurrent_stack<T, Alloc>::eliminate_pop()
+{
+    if (_slot_count == 0)
+        return nullptr;
+
+    auto& slot = random_slot().offer;
+    auto offered = slot.load();
+    if (!offered.ptr)
+        return nullptr;
+
+    auto node = offered.ptr;
+    return slot.compare_exchange(offered, nullptr) ? node : nullptr;
+}
+
+
+/*
+ Function: random_slot
+ Return value: A pseudo-randomly chosen elimination slot.
+ */
+template <class T, class Alloc>
+inline typename concurrent_stack<T, Alloc>::Slot&
+concurrent_stack<T, Alloc>::random_slot()
+{
+    static thread_local std::uint32_t seed =
+        static_cast<std::uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return _slots[seed % _slot_count];
+}
+
+
+} // end namespace
+
 #endif /* stack_h */
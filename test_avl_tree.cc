@@ -0,0 +1,118 @@
+#include "avl_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// The AVL height bound, 1.44 log2(n + 2) - 0.328.
+static bool within_bound(std::size_t height, std::size_t n) {
+    return height <= 1.4405 * std::log2(n + 2.0) - 0.3277 + 1e-9;
+}
+
+int main() {
+    ads::ranked_avl_tree<int> t {5, 1, 4, 2, 3, 3};
+    assert(t.size() == 5);
+    assert((std::vector<int>(t.begin(), t.end()) == std::vector<int>{1, 2, 3, 4, 5}));
+    assert(t.get(0) == 1 && t.get(4) == 5 && t[2] == 3);
+    assert(t.index_of(4) == 3 && t.index_of(9) == t.size());
+    assert(*std::prev(t.end()) == 5 && *t.lower_bound(0) == 1 && t.find(7) == t.end());
+
+    // Ascending inserts are the classic worst case for an unbalanced tree.
+    ads::avl_tree<int> seq;
+    for (int i = 0; i < 100000; ++i)
+        seq.insert(i);
+    assert(seq.height() == 17 && within_bound(seq.height(), seq.size()));
+    for (int i = 0; i < 100000; i += 3)
+        assert(seq.erase(i));
+    assert(within_bound(seq.height(), seq.size()));
+
+    // Randomised against std::set, mixing value and rank operations.
+    std::mt19937 rng(1);
+    ads::ranked_avl_tree<int> avl;
+    std::set<int> ref;
+    for (int i = 0; i < 40000; ++i) {
+        int x = static_cast<int>(rng() % 3000);
+        switch (rng() % 5) {
+        case 0:
+        case 1:
+            assert(avl.insert(x) == ref.insert(x).second);
+            break;
+        case 2:
+            assert(avl.erase(x) == (ref.erase(x) == 1));
+            break;
+        case 3:
+            if (!ref.empty()) {
+                auto index = rng() % ref.size();
+                auto it = std::next(ref.begin(), static_cast<long>(index));
+                assert(avl.get(index) == *it);
+                assert(avl.index_of(*it) == index);
+            }
+            break;
+        default:
+            assert(avl.has(x) == (ref.count(x) == 1));
+            auto lb = avl.lower_bound(x);
+            auto rlb = ref.lower_bound(x);
+            assert((lb == avl.end()) == (rlb == ref.end()));
+            if (rlb != ref.end())
+                assert(*lb == *rlb);
+        }
+        assert(avl.size() == ref.size());
+        assert(within_bound(avl.height(), avl.size()));
+    }
+    assert(std::equal(avl.begin(), avl.end(), ref.begin()));
+    assert(std::equal(ref.rbegin(), ref.rend(), std::reverse_iterator<decltype(avl.end())>(avl.end())));
+
+    // Merging another avl_tree splices its nodes and drops duplicates.
+    ads::ranked_avl_tree<int> evens, threes;
+    std::set<int> both;
+    for (int i = 0; i < 5000; i += 2) {
+        evens.insert(i);
+        both.insert(i);
+    }
+    for (int i = 0; i < 5000; i += 3) {
+        threes.insert(i);
+        both.insert(i);
+    }
+    evens.merge(threes);
+    assert(threes.empty() && evens.size() == both.size());
+    assert(std::equal(evens.begin(), evens.end(), both.begin()));
+    assert(within_bound(evens.height(), evens.size()));
+    for (std::size_t i = 0; i < evens.size(); i += 97)
+        assert(evens.index_of(evens[i]) == i);
+    evens.erase(0);
+    evens.insert(-1);
+    assert(evens[0] == -1);
+
+    // Through the search_tree interface.
+    ads::avl_tree<std::string> words;
+    ads::search_tree<std::string>& base = words;
+    base.add("pear");
+    base.add("apple");
+    base.add("fig");
+    base.remove("pear");
+    assert(base.has("fig") && !base.has("pear") && base.size() == 2);
+    std::string joined;
+    base.for_each([&](const std::string& w){ joined += w; });
+    assert(joined == "applefig");
+    ads::avl_tree<std::string> more {"kiwi", "apple"};
+    base.merge(std::move(more));
+    assert(more.empty() && words.size() == 3);
+
+    // Copy, move and emplace.
+    auto copy = words;
+    assert(std::equal(copy.begin(), copy.end(), words.begin()) && copy.height() == words.height());
+    auto moved = std::move(copy);
+    assert(copy.empty() && moved.size() == 3);
+    assert(moved.emplace(3, 'z') && !moved.emplace("zzz"));
+    copy = moved;
+    moved.clear();
+    assert(moved.empty() && copy.size() == 4 && copy.has("zzz"));
+
+    std::cout << "avl_tree tests passed\n";
+}
@@ -0,0 +1,193 @@
+#include "btree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Checks a set against a reference, both directions.
+template <class Set, class Ref>
+static void same(const Set& s, const Ref& ref) {
+    assert(s.size() == ref.size());
+    assert(std::equal(s.begin(), s.end(), ref.begin(), ref.end()));
+    assert(std::equal(ref.rbegin(), ref.rend(), std::make_reverse_iterator(s.end())));
+}
+
+// Randomised against std::set for a key type (and so a node search).
+template <class Key, std::size_t NodeBytes = 256>
+static void randomised(unsigned seed, Key range) {
+    std::mt19937 rng(seed);
+    ads::btree_set<Key, std::less<Key>, std::allocator<Key>, NodeBytes> bt;
+    std::set<Key> ref;
+    for (int i = 0; i < 60000; ++i) {
+        auto x = static_cast<Key>(rng() % static_cast<unsigned>(range));
+        switch (rng() % 5) {
+        case 0:
+        case 1:
+            assert(bt.insert(x).second == ref.insert(x).second);
+            break;
+        case 2:
+        case 3:
+            assert(bt.erase(x) == (ref.erase(x) == 1));
+            break;
+        default:
+            assert(bt.has(x) == (ref.count(x) == 1));
+            auto lb = bt.lower_bound(x);
+            auto rlb = ref.lower_bound(x);
+            assert((lb == bt.end()) == (rlb == ref.end()));
+            if (rlb != ref.end())
+                assert(*lb == *rlb);
+        }
+    }
+    same(bt, ref);
+    for (auto x : std::vector<Key>(ref.begin(), ref.end()))
+        assert(bt.erase(x));
+    assert(bt.empty() && bt.height() == 0 && bt.begin() == bt.end());
+}
+
+// The node search for a key type against std::lower_bound, for every
+// length around the SIMD block sizes and targets at and between the keys,
+// including the type's extremes.
+template <class Key>
+static void node_search(unsigned seed, std::vector<Key> pool) {
+    std::mt19937_64 rng(seed);
+    std::vector<Key> targets(pool);
+    for (int i = 0; i < 100; ++i) {
+        pool.push_back(static_cast<Key>(static_cast<std::int64_t>(rng())));
+        pool.push_back(static_cast<Key>(static_cast<int>(rng() % 1000) - 500));
+    }
+    for (std::size_t n = 0; n <= 70; ++n) {
+        for (int round = 0; round < 20; ++round) {
+            std::vector<Key> keys;
+            for (std::size_t i = 0; i < n; ++i)
+                keys.push_back(pool[rng() % pool.size()]);
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+            std::vector<Key> probes(targets);
+            probes.insert(probes.end(), keys.begin(), keys.end());
+            probes.push_back(pool[rng() % pool.size()]);
+            for (auto x : probes) {
+                auto simd = ads::btree_search<Key, std::less<Key>>::lower(keys.data(), keys.size(), x, std::less<Key>());
+                auto scalar = static_cast<std::size_t>(std::lower_bound(keys.begin(), keys.end(), x) - keys.begin());
+                assert(simd == scalar);
+            }
+        }
+    }
+}
+
+int main() {
+    // The Makefile builds this with SSE4.2, so every specialised search is
+    // checked against the scalar one.
+    const auto i64_min = std::numeric_limits<std::int64_t>::min();
+    const auto i64_max = std::numeric_limits<std::int64_t>::max();
+    node_search<std::int64_t>(10, {i64_min, i64_min + 1, -1, 0, 1, i64_max - 1, i64_max, std::int64_t(1) << 40});
+    node_search<std::int32_t>(11, {INT32_MIN, -1, 0, 1, INT32_MAX});
+    node_search<std::uint32_t>(12, {0u, 1u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu});
+    node_search<float>(13, {-1e30f, -1.0f, 0.0f, 1.5f, 1e30f});
+
+    ads::btree_set<int> s {5, 1, 4, 2, 3, 3};
+    assert(s.size() == 5 && s.has(3) && !s.has(6) && s.count(1) == 1);
+    assert((std::vector<int>(s.begin(), s.end()) == std::vector<int>{1, 2, 3, 4, 5}));
+    assert(*std::prev(s.end()) == 5 && s.find(9) == s.end() && s.lower_bound(6) == s.end());
+
+    randomised<int>(1, 5000);
+    randomised<int>(2, 200);
+    randomised<unsigned>(3, 5000);
+    randomised<float>(4, 5000);
+    randomised<long long>(5, 5000);
+    randomised<std::int64_t>(7, 5000);
+    randomised<int, 32>(6, 5000);      // Minimum size nodes: deep trees.
+
+    // Negative and unsigned keys beyond the signed range go through the
+    // SIMD search's sign handling.
+    ads::btree_set<unsigned> big;
+    for (unsigned x : {0u, 1u, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu})
+        big.insert(x);
+    assert(big.has(0x80000000u) && big.has(0xFFFFFFFFu) && *big.lower_bound(2) == 0x7FFFFFFFu);
+    ads::btree_set<int> neg;
+    for (int x = -1000; x < 1000; x += 7)
+        neg.insert(x);
+    for (int x = -1000; x < 1000; ++x)
+        assert(neg.has(x) == ((x + 1000) % 7 == 0));
+
+    // Bulk load, then keep modifying.
+    std::vector<int> sorted;
+    for (int i = 0; i < 100000; ++i)
+        sorted.push_back(i * 2);
+    ads::btree_set<int> bulk;
+    bulk.bulk_load(sorted.begin(), sorted.end());
+    std::set<int> ref(sorted.begin(), sorted.end());
+    same(bulk, ref);
+    assert(bulk.height() == 4);   // 1563 leaves under fan-out 21.
+    for (int i = 0; i < 200000; i += 3) {
+        assert(bulk.insert(i).second == ref.insert(i).second);
+        if (i % 5 == 0)
+            assert(bulk.erase(i + 1) == (ref.erase(i + 1) == 1));
+    }
+    same(bulk, ref);
+    for (std::size_t n : {0, 1, 63, 64, 65, 129, 1345}) {
+        ads::btree_set<int> small;
+        small.bulk_load(sorted.begin(), sorted.begin() + static_cast<long>(n));
+        assert(small.size() == n && std::equal(small.begin(), small.end(), sorted.begin()));
+        for (std::size_t i = 0; i < n; ++i)
+            assert(small.erase(sorted[i]));
+        assert(small.empty());
+    }
+
+    // Map.
+    ads::btree_map<std::string, int> m {{"one", 1}, {"two", 2}};
+    m["three"] = 3;
+    ++m["one"];
+    assert(m.size() == 3 && m.at("one") == 2 && m.at("three") == 3);
+    bool threw = false;
+    try {
+        m.at("four");
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+    std::string keys;
+    for (auto kv : m) {
+        keys += kv.first;
+        kv.second *= 10;
+    }
+    assert(keys == "onethreetwo" && m.at("two") == 20);
+    assert(!m.insert("two", 5).second && m.insert("zero", 0).second);
+    assert(m.find("two").value() == 20 && m.erase("one") && !m.has("one"));
+
+    std::map<int, int> mref;
+    ads::btree_map<int, int> mt;
+    std::mt19937 rng(9);
+    for (int i = 0; i < 50000; ++i) {
+        int k = static_cast<int>(rng() % 4000);
+        if (rng() % 3) {
+            mt[k] = i;
+            mref[k] = i;
+        } else {
+            assert(mt.erase(k) == (mref.erase(k) == 1));
+        }
+    }
+    assert(mt.size() == mref.size());
+    auto it = mt.begin();
+    for (auto& kv : mref) {
+        assert(it.key() == kv.first && it.value() == kv.second);
+        ++it;
+    }
+
+    // Copy and move.
+    auto copy = mt;
+    assert(copy.size() == mt.size() && std::equal(copy.begin(), copy.end(), mt.begin()));
+    copy.clear();
+    auto moved = std::move(mt);
+    assert(mt.empty() && moved.size() == mref.size());
+
+    std::cout << "btree tests passed\n";
+}
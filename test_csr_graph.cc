@@ -0,0 +1,116 @@
+#include "csr_graph.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+typedef ads::csr_graph<> graph;
+
+// Levels from a plain queue-based BFS over an adjacency list.
+static std::vector<int> levels(std::size_t n, const std::vector<std::vector<std::uint32_t>>& adj, std::uint32_t source) {
+    std::vector<int> level(n, -1);
+    std::vector<std::uint32_t> queue {source};
+    level[source] = 0;
+    for (std::size_t head = 0; head < queue.size(); ++head)
+        for (auto v : adj[queue[head]])
+            if (level[v] < 0) {
+                level[v] = level[queue[head]] + 1;
+                queue.push_back(v);
+            }
+    return level;
+}
+
+// A parent array is a valid BFS tree if it reaches exactly the reachable
+// vertices, every tree edge exists, and every parent is one level closer.
+static void check_tree(const graph& g, const std::vector<std::uint32_t>& parent, const std::vector<int>& level,
+                       std::uint32_t source) {
+    assert(parent.size() == g.vertices() && parent[source] == source);
+    for (std::uint32_t v = 0; v < g.vertices(); ++v) {
+        assert((parent[v] == graph::none) == (level[v] < 0));
+        if (v == source || level[v] < 0)
+            continue;
+        auto p = parent[v];
+        assert(level[p] == level[v] - 1);
+        bool edge = false;
+        for (auto w : g.neighbours(p))
+            edge |= w == v;
+        assert(edge);
+    }
+}
+
+static std::vector<graph::edge_type> random_edges(std::mt19937& rng, std::size_t n, std::size_t m) {
+    std::vector<graph::edge_type> edges(m);
+    for (auto& e : edges)
+        e = graph::edge_type(static_cast<std::uint32_t>(rng() % n), static_cast<std::uint32_t>(rng() % n));
+    return edges;
+}
+
+int main() {
+    ads::thread_pool pool(4);
+
+    // A small directed graph by hand.
+    {
+        std::vector<graph::edge_type> edges {{0, 1}, {0, 2}, {1, 2}, {2, 0}, {3, 3}, {2, 1}};
+        graph g(5, edges);
+        assert(g.vertices() == 5 && g.edges() == 6 && g.kind() == ads::graph_kind::directed);
+        assert(g.degree(0) == 2 && g.degree(2) == 2 && g.degree(4) == 0);
+        std::vector<std::uint32_t> out(g.neighbours(2).begin(), g.neighbours(2).end());
+        assert((out == std::vector<std::uint32_t>{0, 1}));
+        auto parent = g.bfs(0);
+        assert(parent[0] == 0 && parent[1] == 0 && parent[2] == 0 && parent[3] == graph::none);
+
+        bool thrown = false;
+        try {
+            g.in_neighbours(0);
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        graph both(5, edges, ads::graph_kind::bidirectional);
+        std::vector<std::uint32_t> in(both.in_neighbours(2).begin(), both.in_neighbours(2).end());
+        assert((in == std::vector<std::uint32_t>{0, 1}));
+
+        graph undirected(5, edges, pool, ads::graph_kind::undirected);
+        assert(undirected.edges() == 11 && undirected.degree(3) == 1 && undirected.degree(0) == 3);
+
+        thrown = false;
+        try {
+            graph bad(3, edges);
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // Parallel and sequential builds agree exactly; both BFS variants give
+    // valid trees, on graphs dense enough to switch to bottom-up and on
+    // sparse ones with many components.
+    std::mt19937 rng(2);
+    for (auto kind : {ads::graph_kind::directed, ads::graph_kind::bidirectional, ads::graph_kind::undirected}) {
+        for (std::size_t degree : {1u, 3u, 16u}) {
+            const std::size_t n = 50000;
+            auto edges = random_edges(rng, n, n * degree);
+            graph seq(n, edges, kind), par(n, edges, pool, kind);
+            assert(seq.edges() == par.edges());
+            for (std::uint32_t v = 0; v < n; ++v) {
+                assert(seq.degree(v) == par.degree(v));
+                assert(std::equal(seq.neighbours(v).begin(), seq.neighbours(v).end(), par.neighbours(v).begin()));
+            }
+
+            std::vector<std::vector<std::uint32_t>> adj(n);
+            for (std::uint32_t v = 0; v < n; ++v)
+                adj[v].assign(seq.neighbours(v).begin(), seq.neighbours(v).end());
+            for (std::uint32_t source : {0u, 12345u}) {
+                auto level = levels(n, adj, source);
+                check_tree(seq, seq.bfs(source), level, source);
+                check_tree(par, par.bfs(source, pool), level, source);
+            }
+        }
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
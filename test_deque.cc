@@ -0,0 +1,69 @@
+#include "deque.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+long fib(ads::thread_pool& pool, int n) {
+    if (n < 2)
+        return n;
+
+    long a, b;
+    pool.fork_join([&]{ a = fib(pool, n - 1); }, [&]{ b = fib(pool, n - 2); });
+
+    return a + b;
+}
+
+int main() {
+    // Owner end is LIFO, thief end is FIFO, and the buffer grows.
+    ads::ws_deque<int> d(2);
+    for (int i = 0; i < 100; ++i)
+        d.push(i);
+    assert(d.size() == 100 && d.capacity() >= 100);
+
+    int x;
+    assert(d.pop(x) && x == 99);
+    assert(d.steal(x) && x == 0);
+    while (d.pop(x));
+    assert(d.empty() && !d.steal(x));
+
+    // Every pushed element is taken exactly once under contention.
+    const int n = 200000;
+    ads::ws_deque<int> shared;
+    std::vector<std::atomic<int>> seen(n);
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&]{
+            int v;
+            while (!done.load() || !shared.empty())
+                if (shared.steal(v))
+                    seen[v].fetch_add(1);
+        });
+    }
+    for (int i = 0; i < n; ++i) {
+        shared.push(i);
+        if (i % 3 == 0 && shared.pop(x))
+            seen[x].fetch_add(1);
+    }
+    while (shared.pop(x))
+        seen[x].fetch_add(1);
+    done.store(true);
+    for (auto& t : thieves)
+        t.join();
+    for (auto& s : seen)
+        assert(s.load() == 1);
+
+    // Fork/join on the pool.
+    ads::thread_pool pool(4);
+    long result = 0;
+    pool.run([&]{ result = fib(pool, 20); });
+    assert(result == 6765);
+    assert(fib(pool, 15) == 610);
+
+    std::cout << "deque tests passed\n";
+}
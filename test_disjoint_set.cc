@@ -0,0 +1,104 @@
+#include "disjoint_set.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+int main() {
+    ads::disjoint_set ds(10);
+    assert(ds.size() == 10 && ds.sets() == 10 && !ds.connected(1, 2));
+    assert(ds.unite(1, 2) && ds.unite(2, 3) && !ds.unite(1, 3) && ds.connected(3, 1));
+    assert(ds.sets() == 8 && ds.find(1) == ds.find(3));
+    assert(ds.add() == 10 && ds.sets() == 9 && !ds.connected(10, 1));
+    ds.clear();
+    assert(ds.sets() == 11 && !ds.connected(1, 2));
+    bool thrown = false;
+    try {
+        ds.resize(5);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // Randomised against relabelling a plain label array.
+    std::mt19937 rng(6);
+    {
+        const std::size_t n = 3000;
+        ads::disjoint_set set(n);
+        std::vector<std::size_t> label(n);
+        for (std::size_t x = 0; x < n; ++x)
+            label[x] = x;
+        std::size_t sets = n;
+        for (int i = 0; i < 20000; ++i) {
+            std::size_t a = rng() % n, b = rng() % n;
+            if (rng() % 2) {
+                bool merged = label[a] != label[b];
+                assert(set.unite(a, b) == merged);
+                if (merged) {
+                    auto from = label[a];
+                    for (auto& l : label)
+                        if (l == from)
+                            l = label[b];
+                    --sets;
+                }
+            } else {
+                assert(set.connected(a, b) == (label[a] == label[b]));
+            }
+            assert(set.sets() == sets);
+        }
+    }
+
+    // Threads unite disjoint slices of one edge list while others query;
+    // the final partition must match the sequential one, and a pair once
+    // seen connected must stay connected.
+    {
+        const std::size_t n = 200000, m = 150000;
+        std::vector<std::pair<std::size_t, std::size_t>> edges(m);
+        for (auto& e : edges)
+            e = {rng() % n, rng() % n};
+
+        ads::disjoint_set reference(n);
+        std::size_t merges = 0;
+        for (auto& e : edges)
+            merges += reference.unite(e.first, e.second);
+
+        ads::concurrent_disjoint_set set(n);
+        std::vector<std::size_t> merged(4, 0);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                for (std::size_t i = t; i < m; i += 4)
+                    merged[t] += set.unite(edges[i].first, edges[i].second);
+            });
+        }
+        for (unsigned t = 0; t < 2; ++t) {
+            threads.emplace_back([&, t] {
+                std::mt19937 local(t);
+                for (int i = 0; i < 100000; ++i) {
+                    auto& e = edges[local() % m];
+                    std::size_t a = e.first, b = local() % n;
+                    if (set.connected(a, b))
+                        assert(set.connected(b, a));
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        assert(merged[0] + merged[1] + merged[2] + merged[3] == merges);
+        for (std::size_t i = 0; i < 100000; ++i) {
+            std::size_t a = rng() % n, b = i % 2 ? rng() % n : edges[rng() % m].second;
+            assert(set.connected(a, b) == reference.connected(a, b));
+        }
+        for (auto& e : edges)
+            assert(set.find(e.first) == set.find(e.second));
+        assert(set.size() == n);
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
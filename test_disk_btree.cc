@@ -0,0 +1,220 @@
+#include "disk_btree.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef ads::disk_btree<std::int64_t, std::int64_t> index_type;
+
+static std::string temp_path() {
+    char name[] = "/tmp/test_disk_btree_XXXXXX";
+    int fd = mkstemp(name);
+    assert(fd >= 0);
+    close(fd);
+    std::remove(name);
+    return name;
+}
+
+static long file_size(const std::string& path) {
+    struct stat info;
+    stat(path.c_str(), &info);
+    return static_cast<long>(info.st_size);
+}
+
+// Checks the tree against a reference: size, lookups, iteration order.
+template <class Tree>
+static void same(const Tree& tree, const std::map<std::int64_t, std::int64_t>& ref) {
+    assert(tree.size() == ref.size());
+    assert(tree.empty() == ref.empty());
+    auto it = tree.begin();
+    for (auto& entry : ref) {
+        assert(it != tree.end());
+        assert(it.key() == entry.first && it.value() == entry.second);
+        ++it;
+    }
+    assert(it == tree.end());
+
+    for (auto& entry : ref) {
+        std::int64_t value = -1;
+        assert(tree.find(entry.first, value) && value == entry.second);
+    }
+}
+
+// Randomised inserts, updates and erases against std::map, committing as
+// it goes and reopening the file now and then. A small cache forces pages
+// out to the file in the middle of transactions.
+static void randomised(const std::string& path) {
+    std::mt19937 rng(11);
+    std::map<std::int64_t, std::int64_t> ref, committed;
+    std::unique_ptr<index_type> tree(new index_type(path, 8));
+
+    for (int round = 0; round < 40; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            std::int64_t key = rng() % 20000, value = rng();
+            switch (rng() % 4) {
+            case 0:
+                assert(tree->insert(key, value) == ref.emplace(key, value).second);
+                break;
+            case 1:
+                assert(tree->assign(key, value) == (ref.count(key) == 0));
+                ref[key] = value;
+                break;
+            case 2:
+                assert(tree->erase(key) == (ref.erase(key) == 1));
+                break;
+            default:
+                assert(tree->has(key) == (ref.count(key) == 1));
+            }
+        }
+        same(*tree, ref);
+
+        if (round % 5 == 4) {
+            tree->rollback();
+            ref = committed;
+        } else {
+            tree->commit();
+            committed = ref;
+        }
+        same(*tree, ref);
+
+        if (round % 3 == 2) {
+            tree.reset();
+            tree.reset(new index_type(path, 8));
+            same(*tree, ref);
+        }
+    }
+}
+
+int main() {
+    auto path = temp_path();
+
+    // A new file is an empty index.
+    {
+        index_type tree(path);
+        assert(tree.empty() && tree.height() == 0 && tree.begin() == tree.end());
+        assert(!tree.has(1) && tree.lower_bound(1) == tree.end());
+        assert(!tree.erase(1));
+        assert(tree.generation() == 1);
+    }
+
+    // Bulk inserts split to several levels; reopening reads them back.
+    {
+        index_type tree(path);
+        std::map<std::int64_t, std::int64_t> ref;
+        for (std::int64_t i = 0; i < 100000; ++i) {
+            std::int64_t key = (i * 7919) % 100000;
+            assert(tree.insert(key, key * 2));
+            ref[key] = key * 2;
+        }
+        assert(!tree.insert(5, 0));
+        assert(tree.height() == 3);
+        same(tree, ref);
+        tree.commit();
+        assert(tree.cached_pages() == 0);
+    }
+    {
+        index_type tree(path);
+        assert(tree.size() == 100000 && tree.height() == 3 && tree.generation() == 2);
+
+        // Range scans cross leaves in order and stop before the end key.
+        std::vector<std::int64_t> seen;
+        tree.scan(1000, 3000, [&](std::int64_t key, std::int64_t value) {
+            assert(value == key * 2);
+            seen.push_back(key);
+        });
+        assert(seen.size() == 2000 && seen.front() == 1000 && seen.back() == 2999);
+        for (std::size_t i = 1; i < seen.size(); ++i)
+            assert(seen[i] == seen[i - 1] + 1);
+
+        auto it = tree.lower_bound(99998);
+        assert(it.key() == 99998 && (*it).second == 199996);
+        assert(++it != tree.end() && it.key() == 99999 && ++it == tree.end());
+        assert(tree.lower_bound(100000) == tree.end());
+
+        // Erasing everything leaves an empty tree, and the freed pages are
+        // reused rather than the file growing.
+        for (std::int64_t key = 0; key < 100000; ++key)
+            assert(tree.erase(key));
+        assert(tree.empty() && tree.height() == 0);
+        tree.commit();
+        auto pages = tree.page_count();
+        for (std::int64_t i = 0; i < 100000; ++i)
+            tree.insert((i * 7919) % 100000, i);
+        tree.commit();
+        assert(tree.page_count() == pages);
+    }
+    std::remove(path.c_str());
+
+    // Uncommitted changes vanish with the process, even ones the cache
+    // already wrote to the file.
+    {
+        {
+            index_type tree(path, 4);
+            for (std::int64_t key = 0; key < 5000; ++key)
+                tree.insert(key, key);
+            tree.commit();
+            for (std::int64_t key = 0; key < 5000; ++key)
+                tree.assign(key, -key);
+            for (std::int64_t key = 5000; key < 20000; ++key)
+                tree.insert(key, key);
+            assert(tree.size() == 20000);
+        }
+        index_type tree(path);
+        assert(tree.size() == 5000);
+        std::int64_t value;
+        for (std::int64_t key = 0; key < 5000; ++key)
+            assert(tree.find(key, value) && value == key);
+        assert(!tree.has(5000));
+    }
+
+    // A torn write of the newest meta record falls back to the commit
+    // before it.
+    {
+        std::uint64_t generation;
+        {
+            index_type tree(path);
+            tree.insert(-1, 1);
+            tree.commit();
+            generation = tree.generation();
+        }
+        int fd = open(path.c_str(), O_WRONLY);
+        char garbage[64] = {1, 2, 3};
+        auto written = pwrite(fd, garbage, sizeof(garbage), static_cast<off_t>((generation % 2) * 4096));
+        assert(written == sizeof(garbage));
+        close(fd);
+
+        index_type tree(path);
+        assert(tree.generation() == generation - 1);
+        assert(tree.size() == 5000 && !tree.has(-1));
+    }
+    std::remove(path.c_str());
+
+    // A file of another key type is refused.
+    {
+        { index_type tree(path); }
+        bool refused = false;
+        try {
+            ads::disk_btree<std::int32_t, std::int64_t> other(path);
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        assert(refused);
+    }
+    std::remove(path.c_str());
+
+    randomised(path);
+    assert(file_size(path) > 0);
+    std::remove(path.c_str());
+
+    std::cout << "All tests passed." << std::endl;
+}
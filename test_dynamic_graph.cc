@@ -0,0 +1,106 @@
+#include "dynamic_graph.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+typedef ads::dynamic_graph<> graph;
+
+// Component labels by breadth-first search.
+static std::vector<std::uint32_t> labels(const graph& g) {
+    std::vector<std::uint32_t> label(g.vertices(), std::uint32_t(-1)), queue;
+    for (std::uint32_t s = 0; s < g.vertices(); ++s) {
+        if (label[s] != std::uint32_t(-1))
+            continue;
+        label[s] = s;
+        queue.assign(1, s);
+        for (std::size_t head = 0; head < queue.size(); ++head)
+            for (auto v : g.neighbours(queue[head]))
+                if (label[v] == std::uint32_t(-1)) {
+                    label[v] = s;
+                    queue.push_back(v);
+                }
+    }
+    return label;
+}
+
+int main() {
+    graph g(5);
+    g.add_edge(0, 1);
+    g.add_edge(1, 2);
+    g.add_edge(3, 3);
+    assert(g.edges() == 3 && g.components() == 3 && g.connected(0, 2) && !g.connected(0, 3));
+    assert(g.has_edge(2, 1) && !g.has_edge(0, 2) && g.degree(3) == 1 && g.degree(1) == 2);
+    assert(g.component(0) == g.component(2));
+
+    assert(g.remove_edge(2, 1) && !g.remove_edge(2, 1) && g.remove_edge(3, 3));
+    assert(g.edges() == 1 && !g.connected(0, 2) && g.connected(0, 1) && g.components() == 4);
+    auto v = g.add_vertex();
+    assert(v == 5 && g.vertices() == 6 && g.components() == 5);
+    g.add_edge(5, 4);
+    assert(g.connected(4, 5) && g.components() == 4);
+    g.clear();
+    assert(g.edges() == 0 && g.components() == 6 && g.degree(0) == 0);
+
+    bool thrown = false;
+    try {
+        g.add_edge(0, 6);
+    } catch (const std::out_of_range&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // A random stream of insertions, removals and queries against BFS
+    // labels recomputed after every change.
+    std::mt19937 rng(8);
+    {
+        const std::uint32_t n = 300;
+        graph h(n);
+        std::vector<graph::edge_type> present;
+        auto label = labels(h);
+        for (int i = 0; i < 20000; ++i) {
+            std::uint32_t a = rng() % n, b = rng() % n;
+            switch (rng() % 8) {
+            case 0:
+            case 1:
+                h.add_edge(a, b);
+                present.emplace_back(a, b);
+                label = labels(h);
+                break;
+            case 2:
+                if (!present.empty()) {
+                    auto at = rng() % present.size();
+                    auto e = present[at];
+                    assert(h.remove_edge(e.first, e.second));
+                    present[at] = present.back();
+                    present.pop_back();
+                    label = labels(h);
+                }
+                break;
+            default:
+                assert(h.connected(a, b) == (label[a] == label[b]));
+            }
+            assert(h.edges() == present.size());
+        }
+
+        std::size_t expected = 0;
+        for (std::uint32_t x = 0; x < n; ++x)
+            expected += label[x] == x;
+        assert(h.components() == expected);
+
+        // The snapshot holds the same edges, each stored both ways.
+        auto csr = h.snapshot();
+        assert(csr.vertices() == n && csr.kind() == ads::graph_kind::undirected);
+        std::size_t stored = 0;
+        for (std::uint32_t x = 0; x < n; ++x) {
+            assert(csr.degree(x) == h.degree(x));
+            stored += h.degree(x);
+        }
+        assert(csr.edges() == stored);
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
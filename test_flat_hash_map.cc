@@ -0,0 +1,252 @@
+#include "flat_hash_map.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Hashes std::string and const char* alike, so lookups by literal build no
+// string.
+struct string_hash {
+    typedef void is_transparent;
+    std::size_t operator()(const std::string& s) const { return std::hash<std::string>()(s); }
+    std::size_t operator()(const char* s) const { return std::hash<std::string>()(std::string(s)); }
+};
+
+struct string_equal {
+    typedef void is_transparent;
+    bool operator()(const std::string& a, const std::string& b) const { return a == b; }
+    bool operator()(const std::string& a, const char* b) const { return a == b; }
+};
+
+// A value readers can check for tearing.
+struct checked {
+    long a, b;
+};
+
+// Puts every key in the same probe sequence and H2.
+struct collide {
+    std::size_t operator()(int) const { return 42; }
+};
+
+int main() {
+    ads::flat_hash_set<int> s {3, 1, 4, 1, 5};
+    assert(s.size() == 4 && s.has(4) && !s.has(2) && s.count(1) == 1);
+    assert(!s.insert(3).second && s.insert(2).second && *s.find(2) == 2);
+    assert(s.erase(1) && !s.erase(1) && s.find(1) == s.end() && s.size() == 4);
+    {
+        std::size_t n = 0;
+        for (int x : s)
+            n += static_cast<std::size_t>(s.has(x));
+        assert(n == 4);
+    }
+
+    // Randomised against std::unordered_map, with enough erases that
+    // tombstones pile up and force rehashes in place.
+    std::mt19937 rng(1);
+    ads::flat_hash_map<int, int> map;
+    std::unordered_map<int, int> ref;
+    for (int i = 0; i < 300000; ++i) {
+        int k = static_cast<int>(rng() % 5000), v = static_cast<int>(rng());
+        switch (rng() % 6) {
+        case 0:
+        case 1:
+            assert(map.insert(k, v).second == ref.insert({k, v}).second);
+            break;
+        case 2:
+            map[k] = v;
+            ref[k] = v;
+            break;
+        case 3:
+            assert(map.erase(k) == (ref.erase(k) == 1));
+            break;
+        case 4:
+        {
+            auto it = map.find(k);
+            auto r = ref.find(k);
+            assert((it == map.end()) == (r == ref.end()));
+            if (r != ref.end()) {
+                assert(it.key() == k && it.value() == r->second && (*it).second == r->second);
+                if (v & 1) {
+                    map.erase(it);
+                    ref.erase(r);
+                }
+            }
+            break;
+        }
+        default:
+            map.insert_or_assign(k, v);
+            ref[k] = v;
+        }
+        assert(map.size() == ref.size());
+    }
+    assert(map.capacity() <= 16384 && map.load_factor() <= 0.875);
+    {
+        std::size_t n = 0;
+        for (auto kv : map) {
+            assert(ref.at(kv.first) == kv.second);
+            ++n;
+        }
+        assert(n == ref.size());
+    }
+
+    // Copies are independent; assignment and move leave valid tables.
+    {
+        ads::flat_hash_map<int, int> copy(map);
+        assert(copy.size() == map.size());
+        for (auto& kv : ref)
+            assert(copy.at(kv.first) == kv.second);
+        copy[-1] = 7;
+        assert(!map.has(-1));
+
+        ads::flat_hash_map<int, int> moved(std::move(copy));
+        assert(copy.empty() && !copy.has(-1) && moved.at(-1) == 7);
+        copy = moved;
+        assert(copy.size() == moved.size());
+        moved.clear();
+        assert(moved.empty() && moved.begin() == moved.end() && !moved.has(-1));
+        moved[5] = 5;
+        assert(moved.size() == 1);
+
+        bool thrown = false;
+        try {
+            moved.at(6);
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // Steady churn at a fixed size: capacity must not keep growing.
+    {
+        ads::flat_hash_set<int> churn;
+        std::unordered_set<int> live;
+        for (int i = 0; i < 1000; ++i) {
+            churn.insert(i);
+            live.insert(i);
+        }
+        auto capacity = churn.capacity();
+        for (int i = 1000; i < 200000; ++i) {
+            assert(churn.erase(i - 1000));
+            churn.insert(i);
+        }
+        assert(churn.size() == 1000 && churn.capacity() == capacity);
+        for (int i = 199000; i < 200000; ++i)
+            assert(churn.has(i));
+    }
+
+    // Every key on one probe sequence: lookups must walk all groups.
+    {
+        ads::flat_hash_set<int, collide> bad;
+        for (int i = 0; i < 200; ++i)
+            bad.insert(i);
+        for (int i = 0; i < 200; i += 2)
+            assert(bad.erase(i));
+        for (int i = 0; i < 200; ++i)
+            assert(bad.has(i) == (i % 2 == 1));
+        bad.reserve(1000);
+        assert(bad.size() == 100 && bad.has(199) && !bad.has(198));
+    }
+
+    // Heterogeneous lookup and move-only mapped values.
+    {
+        ads::flat_hash_map<std::string, std::unique_ptr<int>, string_hash, string_equal> names;
+        names.insert("one", std::unique_ptr<int>(new int(1)));
+        names["two"].reset(new int(2));
+        assert(names.has("one") && names.count("two") == 1 && !names.has("three"));
+        assert(*names.find("two").value() == 2);
+        assert(names.erase("one") && !names.erase("one") && names.size() == 1);
+        const auto& view = names;
+        assert(*view.at("two") == 2 && view.find("one") == view.end());
+    }
+
+    // The concurrent map on one thread, against std::unordered_map, with few
+    // shards so they resize often.
+    {
+        ads::concurrent_flat_hash_map<int, int> cmap(4);
+        std::unordered_map<int, int> cref;
+        for (int i = 0; i < 200000; ++i) {
+            int k = static_cast<int>(rng() % 20000), v = static_cast<int>(rng() % 1000);
+            int found = 0;
+            switch (rng() % 6) {
+            case 0:
+                assert(cmap.insert(k, v) == cref.insert({k, v}).second);
+                break;
+            case 1:
+                assert(cmap.assign(k, v) == (cref.count(k) == 0));
+                cref[k] = v;
+                break;
+            case 2:
+                assert(cmap.erase(k) == (cref.erase(k) == 1));
+                break;
+            case 3:
+                assert(cmap.update(k, [](int& x){ ++x; }) == (cref.count(k) == 1));
+                if (cref.count(k))
+                    ++cref[k];
+                break;
+            default:
+                assert(cmap.find(k, found) == (cref.count(k) == 1));
+                assert(!cref.count(k) || found == cref[k]);
+            }
+            assert(cmap.size() == cref.size());
+        }
+        assert(cmap.shard_count() == 4 && cmap.capacity() >= cref.size());
+        cmap.clear();
+        assert(cmap.empty() && !cmap.has(cref.begin()->first));
+    }
+
+    // Concurrent writers churn their own key ranges, growing every shard,
+    // while readers check that values are never torn and that keys which
+    // are never erased are always found.
+    {
+        ads::concurrent_flat_hash_map<long, checked> cmap(8);
+        const long stable = 1000, range = 50000;
+        for (long k = 0; k < stable; ++k)
+            cmap.insert(k, checked{k, ~k});
+        cmap.insert(-1, checked{0, ~0L});
+
+        std::vector<std::thread> threads;
+        for (long t = 0; t < 4; ++t) {
+            threads.emplace_back([&cmap, t, stable, range]{
+                std::mt19937 local(static_cast<unsigned>(t));
+                for (long i = 0; i < 100000; ++i) {
+                    long k = stable + t * range + static_cast<long>(local() % range);
+                    if (local() % 3)
+                        cmap.assign(k, checked{i, ~i});
+                    else
+                        cmap.erase(k);
+                    if (i % 16 == 0)
+                        cmap.update(-1, [](checked& c){ ++c.a; c.b = ~c.a; });
+                }
+            });
+        }
+        for (long t = 0; t < 4; ++t) {
+            threads.emplace_back([&cmap, t, stable, range]{
+                std::mt19937 local(static_cast<unsigned>(t + 100));
+                for (long i = 0; i < 200000; ++i) {
+                    checked c {0, 0};
+                    long k = static_cast<long>(local() % static_cast<unsigned long>(stable + 4 * range));
+                    bool found = cmap.find(k, c);
+                    assert(!found || c.b == ~c.a);
+                    assert(found || k >= stable);
+                    assert(k >= stable || c.a == k);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        checked counter {0, 0};
+        assert(cmap.find(-1, counter) && counter.a == 4 * 100000 / 16 && counter.b == ~counter.a);
+        assert(cmap.size() > stable && cmap.capacity() > 8 * 16);
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
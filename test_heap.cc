@@ -1,15 +1,172 @@
 #include "heap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
 #include <iostream>
-using namespace std;
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 int main() {
-    heap<int> h;
-    for (int i : {9, 8, 7, 6, 5, 4, 3, 2, 1}) {
+    ads::heap<int> h;
+    for (int i : {9, 8, 7, 6, 5, 4, 3, 2, 1, 5})
         h.push(i);
-    }
-
+    std::vector<int> order;
     while (!h.empty()) {
-        h.get();
+        order.push_back(h.get());
         h.pop();
     }
+    assert((order == std::vector<int>{9, 8, 7, 6, 5, 5, 4, 3, 2, 1}));
+
+    // Randomised against std::multiset, as a min-heap, with merges.
+    std::mt19937 rng(2);
+    {
+        ads::heap<int, std::greater<int>> a, b;
+        std::multiset<int> ref;
+        for (int i = 0; i < 100000; ++i) {
+            int x = static_cast<int>(rng() % 1000);
+            switch (rng() % 5) {
+            case 0:
+            case 1:
+                a.push(x);
+                ref.insert(x);
+                break;
+            case 2:
+                b.emplace(x);
+                ref.insert(x);
+                break;
+            case 3:
+                if (!a.empty()) {
+                    assert(a.get() == *ref.begin() || b.size());
+                    a.merge(b);
+                    assert(b.empty() && a.get() == *ref.begin());
+                    a.pop();
+                    ref.erase(ref.begin());
+                }
+                break;
+            default:
+                if (i % 1000 == 0) {
+                    a.merge(std::move(b));
+                    assert(a.size() == ref.size());
+                }
+            }
+        }
+        a.merge(b);
+        for (int x : ref) {
+            assert(a.get() == x);
+            a.pop();
+        }
+        assert(a.empty());
+
+        std::vector<int> v {4, 1, 3, 9, 7};
+        ads::heap<int> built(v.begin(), v.end());
+        assert(built.size() == 5 && built.get() == 9);
+        built.swap(h);
+        assert(built.empty() && h.get() == 9);
+    }
+
+    // indexed_heap against a std::set of (priority, key), with every
+    // modifier.
+    {
+        const std::size_t keys = 500;
+        ads::indexed_heap<long, std::greater<long>> ih(keys);
+        std::set<std::pair<long, std::size_t>> ref;
+        std::vector<long> prio(keys, -1);
+        for (int i = 0; i < 200000; ++i) {
+            std::size_t k = rng() % keys;
+            long p = static_cast<long>(rng() % 10000);
+            switch (rng() % 5) {
+            case 0:
+            case 1:
+                if (ih.contains(k)) {
+                    ref.erase({prio[k], k});
+                    ih.update(k, p);
+                } else {
+                    ih.push(k, p);
+                }
+                ref.insert({p, k});
+                prio[k] = p;
+                break;
+            case 2:
+                if (ih.contains(k)) {
+                    ih.erase(k);
+                    ref.erase({prio[k], k});
+                }
+                break;
+            case 3:
+                assert(ih.push_or_update(k, p) == (ref.erase({prio[k], k}) == 0 || !ih.contains(k)));
+                ref.insert({p, k});
+                prio[k] = p;
+                break;
+            default:
+                if (!ih.empty()) {
+                    assert(ih.top_priority() == ref.begin()->first);
+                    assert(ih.priority(ih.top()) == ih.top_priority());
+                    ref.erase({ih.top_priority(), ih.top()});
+                    ih.pop();
+                }
+            }
+            assert(ih.size() == ref.size());
+        }
+        for (auto& e : ref)
+            assert(ih.contains(e.second) && ih.priority(e.second) == e.first);
+        ih.clear();
+        assert(ih.empty() && !ih.contains(ref.begin()->second) && ih.keys() == keys);
+
+        ih.push(3, 30);
+        ih.push(499, 10);
+        ih.resize(100);
+        assert(ih.keys() == 100 && ih.size() == 1 && ih.top() == 3);
+        bool thrown = false;
+        try {
+            ih.push(100, 1);
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // radix_heap against std::multimap, pushing only keys at or above the
+    // last one popped, as Dijkstra does.
+    {
+        ads::radix_heap<std::uint64_t, int> rh;
+        std::multimap<std::uint64_t, int> ref;
+        std::uint64_t last = 0;
+        for (int i = 0; i < 200000; ++i) {
+            if (rng() % 3 || ref.empty()) {
+                std::uint64_t key = last + (rng() % 4 ? rng() % 100 : rng() % (std::uint64_t(1) << 40));
+                rh.push(key, i);
+                ref.insert({key, i});
+            } else {
+                auto top = rh.get();
+                assert(top.first == ref.begin()->first);
+                auto range = ref.equal_range(top.first);
+                auto it = range.first;
+                while (it->second != top.second)
+                    ++it;
+                ref.erase(it);
+                rh.pop();
+                last = top.first;
+                assert(rh.last() == last);
+            }
+            assert(rh.size() == ref.size());
+        }
+
+        bool thrown = false;
+        try {
+            rh.push(last - 1, 0);
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown || last == 0);
+        rh.clear();
+        assert(rh.empty() && rh.last() == 0);
+    }
+
+    std::cout << "All tests passed." << std::endl;
 }
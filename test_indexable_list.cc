@@ -0,0 +1,182 @@
+#include "indexable_list.h"
+
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Counts live objects so that leaks and double destruction show up.
+struct tracked {
+    static long live;
+    int value;
+
+    tracked(int v = 0) : value(v) { ++live; }
+    tracked(const tracked& t) : value(t.value) { ++live; }
+    tracked& operator=(const tracked&) = default;
+    ~tracked() { --live; }
+};
+long tracked::live = 0;
+
+typedef ads::indexable_list<tracked> list;
+
+// Checks the list against the model in both directions and by index.
+static void check(const list& l, const std::vector<int>& model) {
+    assert(l.size() == model.size());
+    std::size_t i = 0;
+    for (auto it = l.cbegin(); it != l.cend(); ++it, ++i) {
+        assert(it->value == model[i]);
+        assert(l.index_of(it) == i);
+    }
+    for (auto it = l.crbegin(); it != l.crend(); ++it)
+        assert(it->value == model[--i]);
+    for (i = 0; i < model.size(); ++i)
+        assert(l[i].value == model[i]);
+    assert(l.index_of(l.cend()) == model.size());
+}
+
+int main() {
+    std::mt19937 rng(5);
+    {
+        // Basic interface, mirroring list.
+        ads::indexable_list<int> l({4, 3, 6, 1});
+        l.push_back(2);
+        l.push_front(9);
+        assert((std::vector<int>(l.begin(), l.end()) == std::vector<int>{9, 4, 3, 6, 1, 2}));
+        assert(l.front() == 9 && l.last() == 2 && l[3] == 6 && l.at(5) == 2);
+        l[1] = 7;
+        assert(*l.nth(1) == 7 && l.nth(6) == l.end());
+        l.erase(l.nth(2));
+        l.insert(l.nth(2), 2, 8);
+        assert((std::vector<int>(l.begin(), l.end()) == std::vector<int>{9, 7, 8, 8, 6, 1, 2}));
+        l.pop_front();
+        l.pop_back();
+        l.erase(l.nth(1), l.nth(3));
+        assert((std::vector<int>(l.begin(), l.end()) == std::vector<int>{7, 6, 1}));
+
+        const ads::indexable_list<int>& c = l;
+        assert(c[2] == 1 && *c.nth(0) == 7);
+
+        ads::indexable_list<int> copy(l), filled(3, 5);
+        copy.emplace_back(10);
+        assert(copy.size() == 4 && l.size() == 3 && copy[3] == 10);
+        assert((std::vector<int>(filled.begin(), filled.end()) == std::vector<int>{5, 5, 5}));
+        filled = copy;
+        ads::indexable_list<int> moved(std::move(copy));
+        assert(copy.empty() && moved.size() == 4 && filled.size() == 4);
+        filled = {1, 2};
+        assert(filled.size() == 2 && filled[1] == 2);
+        filled.clear();
+        assert(filled.empty() && filled.begin() == filled.end());
+        filled.push_back(3);
+        assert(filled[0] == 3);
+    }
+    {
+        // Random positional edits against a vector, large enough to grow
+        // many levels.
+        list l;
+        std::vector<int> model;
+        for (int step = 0; step < 20000; ++step) {
+            auto op = rng() % 6;
+            auto i = model.empty() ? 0 : rng() % (model.size() + 1);
+            if (op < 3 || model.empty()) {
+                int v = static_cast<int>(rng() % 1000);
+                auto it = l.insert(l.nth(i), tracked(v));
+                assert(l.index_of(it) == i);
+                model.insert(model.begin() + i, v);
+            } else if (op < 5) {
+                i %= model.size();
+                l.erase(l.nth(i));
+                model.erase(model.begin() + i);
+            } else {
+                i %= model.size();
+                l[i].value = -l[i].value;
+                model[i] = -model[i];
+            }
+            if (step % 2000 == 0)
+                check(l, model);
+        }
+        check(l, model);
+
+        // Empty it and build it up again, so levels retire and return.
+        while (!l.empty()) {
+            auto i = rng() % l.size();
+            l.erase(l.nth(i));
+            model.erase(model.begin() + i);
+        }
+        check(l, model);
+        for (int i = 0; i < 1000; ++i) {
+            l.push_front(i);
+            model.insert(model.begin(), i);
+        }
+        check(l, model);
+    }
+    {
+        // Copies are appended level by level; check them after edits.
+        std::vector<int> model;
+        list a;
+        for (int i = 0; i < 3000; ++i) {
+            a.push_back(i);
+            model.push_back(i);
+        }
+        list b(a);
+        check(b, model);
+        for (int i = 0; i < 500; ++i) {
+            auto j = rng() % model.size();
+            b.erase(b.nth(j));
+            model.erase(model.begin() + j);
+        }
+        check(b, model);
+    }
+    {
+        // Splicing keeps iterators, within and between lists.
+        list a, b;
+        std::vector<int> ma, mb;
+        for (int i = 0; i < 2000; ++i) {
+            a.push_back(i);
+            ma.push_back(i);
+            b.push_back(-i);
+            mb.push_back(-i);
+        }
+        for (int step = 0; step < 1500; ++step) {
+            auto from = rng() % mb.size();
+            auto to = rng() % (ma.size() + 1);
+            auto it = b.nth(from);
+            a.splice(a.nth(to), b, it);
+            assert(a.index_of(it) == to && it->value == mb[from]);
+            ma.insert(ma.begin() + to, mb[from]);
+            mb.erase(mb.begin() + from);
+
+            // Within a list, in both directions.
+            from = rng() % ma.size();
+            to = rng() % (ma.size() + 1);
+            a.splice(a.nth(to), a, a.nth(from));
+            auto v = ma[from];
+            ma.insert(ma.begin() + to, v);
+            ma.erase(ma.begin() + (from < to ? from : from + 1));
+        }
+        check(a, ma);
+        check(b, mb);
+
+        a.splice(a.nth(3), b, b.nth(10), b.nth(200));
+        ma.insert(ma.begin() + 3, mb.begin() + 10, mb.begin() + 200);
+        mb.erase(mb.begin() + 10, mb.begin() + 200);
+        check(a, ma);
+        check(b, mb);
+
+        a.splice(a.nth(ma.size() / 2), b);
+        ma.insert(ma.begin() + ma.size() / 2, mb.begin(), mb.end());
+        mb.clear();
+        check(a, ma);
+        check(b, mb);
+
+        list c;
+        c.splice(c.end(), a);
+        check(c, ma);
+        assert(a.empty());
+    }
+    assert(tracked::live == 0);
+
+    std::cout << "All tests passed." << std::endl;
+}
@@ -0,0 +1,111 @@
+#include "interval_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+typedef ads::interval_tree<int> tree;
+typedef tree::value_type interval;
+
+// Checks stabbing and overlap queries against a scan of the stored set.
+static void check(const tree& t, const std::set<interval>& all, std::mt19937& rng, int spread) {
+    assert(t.size() == all.size());
+    assert(t.height() <= 2 * std::log2(all.size() + 1) + 1);
+
+    std::uniform_int_distribution<int> coordinate(-5, spread + 5), length(0, spread / 20);
+    for (int q = 0; q < 200; ++q) {
+        int low = coordinate(rng);
+        interval query{low, low + length(rng)};
+
+        std::vector<interval> expected, stabbed;
+        for (auto& i : all)
+            if (i.overlaps(query))
+                expected.push_back(i);
+        assert(t.overlap(query) == expected);
+
+        for (auto& i : all)
+            if (i.contains(low))
+                stabbed.push_back(i);
+        assert(t.stab(low) == stabbed);
+
+        std::size_t count = 0;
+        t.overlap(query, [&](const interval&) { ++count; });
+        assert(count == expected.size());
+
+        auto any = t.any_overlap(query);
+        assert(expected.empty() ? !any : any && any->overlaps(query) && all.count(*any));
+    }
+}
+
+int main() {
+    std::mt19937 rng(12);
+
+    // Small cases by hand, closed endpoints included.
+    tree small { {1, 3}, {2, 2}, {5, 8}, {6, 10}, {15, 23} };
+    assert(small.size() == 5);
+    assert((small.stab(2) == std::vector<interval>{ {1, 3}, {2, 2} }));
+    assert((small.stab(8) == std::vector<interval>{ {5, 8}, {6, 10} }));
+    assert(small.stab(4).empty() && small.stab(24).empty());
+    assert((small.overlap({3, 5}) == std::vector<interval>{ {1, 3}, {5, 8} }));
+    assert((small.overlap({11, 14}).empty()));
+    assert(!small.any_overlap({11, 14}) && small.any_overlap({10, 14})->high == 10);
+    assert(small.has({6, 10}) && !small.has({6, 9}));
+    assert(!small.insert(5, 8) && small.insert(5, 9) && small.size() == 6);
+
+    tree empty;
+    assert(empty.empty() && empty.stab(0).empty() && !empty.any_overlap({0, 100}));
+
+    bool threw = false;
+    try { small.insert(4, 3); } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw && small.size() == 6);
+    threw = false;
+    try { tree bad { {2, 3}, {1, 5} }; } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { tree bad { {1, 3}, {1, 3} }; } catch (const std::invalid_argument&) { threw = true; }
+    assert(threw);
+
+    // Random intervals, inserted one by one and built in bulk.
+    for (int spread : {100, 10000}) {
+        for (std::size_t n : {1u, 2u, 3u, 7u, 8u, 100u, 500u, 5000u}) {
+            if (n > static_cast<std::size_t>(spread) * spread / 20)
+                continue;
+            std::uniform_int_distribution<int> coordinate(0, spread), length(0, spread / 10);
+            std::set<interval> all;
+            tree inserted;
+            while (all.size() < n) {
+                int low = coordinate(rng);
+                interval i{low, low + length(rng)};
+                assert(inserted.insert(i) == all.insert(i).second);
+            }
+            check(inserted, all, rng, spread);
+
+            tree built(all.begin(), all.end());
+            check(built, all, rng, spread);
+
+            // A bulk-built tree keeps its invariants under insertion.
+            for (int extra = 0; extra < 500; ++extra) {
+                int low = coordinate(rng);
+                interval i{low, low + length(rng)};
+                assert(built.insert(i) == all.insert(i).second);
+            }
+            check(built, all, rng, spread);
+        }
+    }
+
+    // Sorted insertion, the rotation-heavy case.
+    std::set<interval> all;
+    tree ascending;
+    for (int i = 0; i < 20000; ++i) {
+        ascending.insert(i, i + i % 50);
+        all.insert({i, i + i % 50});
+    }
+    check(ascending, all, rng, 20000);
+
+    std::cout << "All tests passed." << std::endl;
+}
@@ -0,0 +1,88 @@
+#include "kd_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Checks every query against a linear scan, for a tree built both ways.
+template <std::size_t Dim, class T>
+static void check(std::size_t n, T spread, std::mt19937& rng, ads::thread_pool& pool) {
+    typedef ads::kd_tree<Dim, T> tree;
+    typedef typename tree::point_type point;
+
+    std::uniform_int_distribution<int> coordinate(0, static_cast<int>(spread));
+    auto random_point = [&] {
+        point p;
+        for (auto& x : p)
+            x = static_cast<T>(coordinate(rng));
+        return p;
+    };
+    std::vector<point> points(n);
+    for (auto& p : points)
+        p = random_point();
+
+    tree sequential(points), parallel(points, pool);
+    assert(sequential.size() == n && parallel.size() == n);
+
+    for (int q = 0; q < 100; ++q) {
+        auto query = random_point();
+        std::vector<T> all(n);
+        for (std::size_t i = 0; i < n; ++i)
+            all[i] = tree::distance(query, points[i]);
+        auto sorted = all;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto best = sequential.nearest(query);
+        assert(all[best] == sorted[0] && parallel.nearest(query) == best);
+
+        for (std::size_t k : {1u, 5u, 40u}) {
+            auto found = sequential.nearest(query, k);
+            assert(found.size() == std::min(k, n));
+            for (std::size_t i = 0; i < found.size(); ++i)
+                assert(found[i].first == sorted[i] && all[found[i].second] == found[i].first);
+            assert(parallel.nearest(query, k) == found);
+        }
+
+        point low = random_point(), high = random_point();
+        for (std::size_t d = 0; d < Dim; ++d)
+            if (low[d] > high[d])
+                std::swap(low[d], high[d]);
+        auto inside = sequential.range(low, high);
+        std::sort(inside.begin(), inside.end());
+        std::vector<std::size_t> expected;
+        for (std::size_t i = 0; i < n; ++i) {
+            bool in = true;
+            for (std::size_t d = 0; d < Dim; ++d)
+                in = in && low[d] <= points[i][d] && points[i][d] <= high[d];
+            if (in)
+                expected.push_back(i);
+        }
+        assert(inside == expected);
+    }
+}
+
+int main() {
+    std::mt19937 rng(10);
+    ads::thread_pool pool(4);
+
+    ads::kd_tree<2> empty;
+    assert(empty.empty() && empty.nearest({{0, 0}}) == empty.npos && empty.nearest({{0, 0}}, 3).empty());
+    assert(empty.range({{0, 0}}, {{1, 1}}).empty());
+
+    ads::kd_tree<2> tiny(std::vector<ads::kd_tree<2>::point_type>{{{0, 0}}, {{3, 4}}, {{1, 1}}});
+    assert(tiny.nearest({{2.9f, 3.9f}}) == 1 && tiny.nearest({{0, 0}}, 5).size() == 3);
+    assert(tiny.nearest({{0, 0}}, 2)[1] == std::make_pair(2.0f, std::size_t(2)));
+
+    // Sizes around the leaf and parallel cutoffs; small spreads make many
+    // duplicate coordinates and tied distances.
+    for (std::size_t n : {1u, 8u, 9u, 100u, 5000u, 20000u}) {
+        check<2, float>(n, 1000.0f, rng, pool);
+        check<3, double>(n, 10.0, rng, pool);
+        check<8, float>(n, 100.0f, rng, pool);
+    }
+    check<1, int>(3000, 50, rng, pool);
+
+    std::cout << "All tests passed." << std::endl;
+}
@@ -1,15 +1,438 @@
-
+#include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "list.h"
+#include "parallel_list.h"
 
-int main() {
-    ads::list<int> l({4, 3, 6, 1});
-    l.push_back(2);
-    l.remove(3);
+typedef std::pair<int, int> tagged;  // (key, where it came from)
+
+template <class List>
+static std::vector<typename List::value_type> contents(const List& l) {
+    std::vector<typename List::value_type> out(l.begin(), l.end());
+    assert(out.size() == l.size());
+    return out;
+}
+
+static bool by_key(const tagged& a, const tagged& b) {
+    return a.first < b.first;
+}
+
+// Counts the allocations lists make, to check that bulk operations make one.
+struct counts {
+    static long allocations, frees;
+    static std::size_t bytes;   // Size of the last allocation.
+};
+long counts::allocations = 0, counts::frees = 0;
+std::size_t counts::bytes = 0;
+
+template <class T>
+struct counting_allocator : std::allocator<T> {
+    template <class U>
+    struct rebind { typedef counting_allocator<U> other; };
+
+    T* allocate(std::size_t n) { ++counts::allocations; counts::bytes = n * sizeof(T); return std::allocator<T>::allocate(n); }
+    void deallocate(T* p, std::size_t n) { ++counts::frees; std::allocator<T>::deallocate(p, n); }
+};
+
+// An object on two intrusive lists at once.
+struct connection {
+    int id;
+    ads::list_hook by_age;
+    ads::list_hook by_host;
+};
+
+typedef ads::intrusive_list<connection, &connection::by_age> age_list;
+typedef ads::intrusive_list<connection, &connection::by_host> host_list;
 
-    for (int i : l) {
-        std::cout << i << "\n";
+template <class List>
+static std::vector<int> ids(const List& l) {
+    std::vector<int> out, backwards;
+    for (auto it = l.cbegin(); it != l.cend(); ++it)
+        out.push_back(it->id);
+    for (auto it = l.crbegin(); it != l.crend(); ++it)
+        backwards.insert(backwards.begin(), it->id);
+    assert(out == backwards && out.size() == l.size());
+    return out;
+}
+
+// merge_k, with and without a pool, including empty lists and ties across
+// lists.
+static void merge_k_lists(ads::thread_pool* pool, std::mt19937& rng) {
+    typedef ads::list<tagged>::iterator iterator;
+    auto by_first = [](iterator x, iterator y) { return x->first < y->first; };
+
+    ads::list<int>* none = nullptr;
+    assert((pool ? ads::merge_k(none, none, *pool) : ads::merge_k(none, none)).empty());
+    for (std::size_t k : {1, 2, 3, 5, 7, 64, 1000}) {
+        std::vector<ads::list<tagged>> lists(k);
+        std::vector<tagged> expected;
+        for (std::size_t i = 0; i < k; ++i) {
+            std::vector<int> keys(i % 5 == 1 ? 0 : rng() % 200);
+            for (auto& key : keys)
+                key = static_cast<int>(rng() % 50);
+            std::sort(keys.begin(), keys.end());
+            for (auto key : keys) {
+                lists[i].push_back(tagged(key, static_cast<int>(i)));
+                expected.push_back(tagged(key, static_cast<int>(i)));
+            }
+        }
+        std::stable_sort(expected.begin(), expected.end(), by_key);
+
+        auto merged = pool ? ads::merge_k(lists.begin(), lists.end(), by_first, *pool)
+                           : ads::merge_k(lists.begin(), lists.end(), by_first);
+        assert(contents(merged) == expected);
+        for (auto& l : lists)
+            assert(l.empty());
     }
+
+    std::vector<ads::list<int>> lists(3);
+    lists[0] = {1, 4};
+    lists[2] = {2, 3, 5};
+    auto merged = pool ? ads::merge_k(lists.begin(), lists.end(), *pool) : ads::merge_k(lists.begin(), lists.end());
+    assert((contents(merged) == std::vector<int>{1, 2, 3, 4, 5}));
 }
 
+int main() {
+    std::mt19937 rng(9);
+    {
+        ads::list<int> l({4, 3, 6, 1});
+        l.push_back(2);
+        l.remove(3);
+        assert((contents(l) == std::vector<int>{4, 6, 1, 2}));
+        assert(l.at(1) == 6 && l[3] == 2);
+
+        ads::list<int> other({7, 8});
+        l.splice(l.cbegin(), other);
+        assert(other.empty() && (contents(l) == std::vector<int>{7, 8, 4, 6, 1, 2}));
+        l.splice(l.cend(), std::move(other));
+        ads::list<int> moved(std::move(other));
+        assert(moved.empty() && l.size() == 6);
+        l.splice(l.cend(), l, l.end().prev());
+        l.splice(l.cend(), l, l.cbegin());
+        assert((contents(l) == std::vector<int>{8, 4, 6, 1, 2, 7}));
+    }
+    {
+        // merge against std::stable_sort, from interleaved to disjoint runs.
+        for (int spread : {1, 4, 100, 100000}) {
+            for (int trial = 0; trial < 20; ++trial) {
+                std::vector<tagged> a(rng() % 300), b(rng() % 300);
+                for (auto& x : a)
+                    x = tagged(static_cast<int>(rng() % spread), 0);
+                for (auto& x : b)
+                    x = tagged(static_cast<int>(rng() % spread) + trial, 1);
+                std::sort(a.begin(), a.end(), by_key);
+                std::sort(b.begin(), b.end(), by_key);
+
+                ads::list<tagged> la, lb;
+                for (auto& x : a)
+                    la.push_back(x);
+                for (auto& x : b)
+                    lb.push_back(x);
+                typedef ads::list<tagged>::iterator iterator;
+                la.merge(lb, [](iterator x, iterator y) { return x->first < y->first; });
+
+                std::vector<tagged> expected(a);
+                expected.insert(expected.end(), b.begin(), b.end());
+                std::stable_sort(expected.begin(), expected.end(), by_key);
+                assert(lb.empty() && contents(la) == expected);
+            }
+        }
+
+        ads::list<int> a({1, 3, 5}), b({2, 4, 6, 8});
+        a.merge(std::move(b));
+        assert(b.empty() && (contents(a) == std::vector<int>{1, 2, 3, 4, 5, 6, 8}));
+        a.merge(a);
+        assert(a.size() == 7);
+        ads::list<int> empty;
+        empty.merge(a);
+        assert(a.empty() && empty.size() == 7);
+    }
+    merge_k_lists(nullptr, rng);
+    {
+        ads::thread_pool pool(4);
+        merge_k_lists(&pool, rng);
+    }
+    {
+        // intrusive_list: random membership changes on two lists against
+        // vectors of ids.
+        std::vector<connection> pool(200);
+        for (int i = 0; i < 200; ++i)
+            pool[i].id = i;
+        {
+            age_list ages;
+            host_list hosts[2];
+            std::vector<int> age_ids, host_ids[2];
+            auto drop = [](std::vector<int>& v, int id) { v.erase(std::find(v.begin(), v.end(), id)); };
+
+            for (int step = 0; step < 5000; ++step) {
+                auto& c = pool[rng() % pool.size()];
+                auto h = c.id % 2;
+                if (!c.by_age.is_linked()) {
+                    ages.push_back(c);
+                    age_ids.push_back(c.id);
+                    hosts[h].push_front(c);
+                    host_ids[h].insert(host_ids[h].begin(), c.id);
+                } else if (rng() % 2) {
+                    ages.unlink(c);
+                    drop(age_ids, c.id);
+                    hosts[h].unlink(c);
+                    drop(host_ids[h], c.id);
+                    assert(!c.by_age.is_linked() && !c.by_host.is_linked());
+                } else {
+                    // Touched: to the back of the age list, in place on hosts.
+                    ages.splice(ages.cend(), ages, ages.iterator_to(c));
+                    drop(age_ids, c.id);
+                    age_ids.push_back(c.id);
+                }
+            }
+            assert(ids(ages) == age_ids && ids(hosts[0]) == host_ids[0] && ids(hosts[1]) == host_ids[1]);
+            if (!ages.empty()) {
+                assert(ages.front().id == age_ids.front() && ages.last().id == age_ids.back());
+                ages.pop_front();
+                ages.pop_back();
+                age_ids.erase(age_ids.begin());
+                age_ids.pop_back();
+            }
+
+            // Moving, swapping and splicing between lists of the same hook.
+            host_list moved(std::move(hosts[0]));
+            assert(hosts[0].empty() && ids(moved) == host_ids[0]);
+            hosts[0].swap(moved);
+            assert(moved.empty() && ids(hosts[0]) == host_ids[0]);
+            hosts[1].splice(hosts[1].cbegin(), hosts[0]);
+            host_ids[1].insert(host_ids[1].begin(), host_ids[0].begin(), host_ids[0].end());
+            assert(hosts[0].empty() && ids(hosts[1]) == host_ids[1]);
+            if (hosts[1].size() > 2) {
+                hosts[0].splice(hosts[0].cend(), hosts[1], ++hosts[1].cbegin());
+                assert(hosts[0].size() == 1 && hosts[0].front().id == host_ids[1][1]);
+            }
+            hosts[1].erase(hosts[1].cbegin(), hosts[1].cend());
+            assert(hosts[1].empty());
+            age_list other;
+            other = std::move(ages);
+            assert(ids(other) == age_ids);
+        }
+        for (auto& c : pool)
+            assert(!c.by_age.is_linked() && !c.by_host.is_linked());
+    }
+
+    {
+        // Bulk operations allocate one block, besides the list's first set of
+        // blocks; clear frees the block whole.
+        typedef ads::list<int, counting_allocator<int>> counted_list;
+        {
+            counted_list a(1000, 7);
+            assert(counts::allocations == 3 && a.size() == 1000 && a.last() == 7);
+            a.insert(a.cbegin(), 0, 5);
+            a.push_back(8);
+            assert(counts::allocations == 4 && a.size() == 1001);
+            a.pop_back();
+            a.clear();
+            assert(counts::frees == 2 && a.empty());
+
+            a.assign({1, 2, 3});
+            counted_list copy(a), moved(std::move(a));
+            assert(counts::allocations == 9 && a.empty() && (contents(copy) == std::vector<int>{1, 2, 3}));
+            auto it = copy.insert(copy.cbegin().next(), moved.begin(), moved.end());
+            assert(*it == 1 && (contents(copy) == std::vector<int>{1, 1, 2, 3, 2, 3}));
+
+            // A block outlives its list while another list holds its nodes.
+            a.assign(100, 4);
+            moved.splice(moved.cend(), a, a.cbegin());
+            moved.splice(moved.cbegin(), a, a.cbegin().next());
+            a.clear();
+            assert((contents(moved) == std::vector<int>{4, 1, 2, 3, 4}));
+            auto frees = counts::frees;
+            moved.pop_front();
+            assert(counts::frees == frees);
+            moved.clear();
+            assert(counts::frees == frees + 2);
+
+            // Whole lists moved into empty ones keep their blocks.
+            a.assign(50, 1);
+            counted_list b;
+            b.splice(b.cend(), a);
+            frees = counts::frees;
+            b.clear();
+            assert(counts::frees == frees + 1);
+
+            // A list that splices away all its nodes of a block lets go of it.
+            a.assign(20, 2);
+            a.push_back(3);
+            b.splice(b.cend(), a, a.cbegin(), a.cend().prev());
+            assert(a.size() == 1 && b.size() == 20);
+            frees = counts::frees;
+            b.clear();
+            assert(counts::frees == frees + 1 && a.size() == 1 && *a.begin() == 3);
+        }
+        assert(counts::allocations == counts::frees);
+
+        // Nodes hold two links and the element, whichever way they were allocated.
+        {
+            ads::list<long, counting_allocator<long>> longs(3, 1);
+            longs.push_back(2);
+            assert(counts::bytes == 2 * sizeof(void*) + sizeof(long));
+        }
+
+        // Blocks spliced between lists, interleaved with loose nodes, match std::list.
+        {
+            std::mt19937 rng(50);
+            std::vector<ads::list<int>> lists(4);
+            std::vector<std::list<int>> expect(4);
+            for (int step = 0; step < 2000; ++step) {
+                auto i = rng() % 4, j = rng() % 4;
+                auto& l = lists[i];
+                auto& e = expect[i];
+                int v = static_cast<int>(rng() % 1000);
+                std::size_t n = rng() % 8;
+                switch (rng() % 6) {
+                case 0:
+                    l.insert(l.cend(), n, v);
+                    e.insert(e.end(), n, v);
+                    break;
+                case 1:
+                    l.push_front(v);
+                    e.push_front(v);
+                    break;
+                case 2:
+                    if (i != j && lists[j].size() > 1) {
+                        auto half = lists[j].size() / 2;
+                        auto first = lists[j].cbegin(), last = first;
+                        for (std::size_t k = 0; k < half; ++k)
+                            last = last.next();
+                        l.splice(l.cend(), lists[j], first, last);
+                        e.splice(e.end(), expect[j], expect[j].begin(), std::next(expect[j].begin(), half));
+                    }
+                    break;
+                case 3:
+                    for (; n > 0 && !l.empty(); --n) {
+                        l.pop_front();
+                        e.pop_front();
+                    }
+                    break;
+                case 4:
+                    if (!l.empty()) {
+                        l.erase(l.cbegin().next(), l.cend());
+                        e.erase(std::next(e.begin()), e.end());
+                    }
+                    break;
+                default:
+                    if (n == 0) {
+                        l.clear();
+                        e.clear();
+                    }
+                }
+                assert(contents(l) == std::vector<int>(e.begin(), e.end()));
+            }
+        }
+
+        // Elements with destructors are still destroyed one by one.
+        ads::list<std::string> strings(10, std::string(40, 'x'));
+        strings.assign({std::string(50, 'y'), std::string(60, 'z')});
+        strings.insert(strings.cend(), 3, std::string(70, 'w'));
+        assert(strings.size() == 5 && strings.last().size() == 70);
+        strings.erase(strings.cbegin());
+        strings.clear();
+        assert(strings.empty());
+    }
+    {
+        // singly_linked as a queue and with changes after positions.
+        ads::list<int, std::allocator<int>, ads::singly_linked> q({2, 3});
+        q.push_front(1);
+        q.push_back(4);
+        assert((contents(q) == std::vector<int>{1, 2, 3, 4}) && q.front() == 1 && q.last() == 4);
+        q.insert_after(q.cbegin(), 9);
+        q.erase_after(q.cbegin().next());
+        assert((contents(q) == std::vector<int>{1, 9, 3, 4}));
+        q.reverse();
+        assert((contents(q) == std::vector<int>{4, 3, 9, 1}) && q.last() == 1);
+        q.remove_if([](int x) { return x % 3 == 0; });
+        assert((contents(q) == std::vector<int>{4, 1}) && q.last() == 1);
+
+        auto copy = q;
+        ads::list<int, std::allocator<int>, ads::singly_linked> moved(std::move(q)), filled(2, 7);
+        assert(q.empty() && (contents(moved) == std::vector<int>{4, 1}) && contents(copy) == contents(moved));
+        moved.splice_after(moved.cbefore_begin(), filled);
+        assert(filled.empty() && (contents(moved) == std::vector<int>{7, 7, 4, 1}));
+        filled.swap(moved);
+        filled.push_back(5);
+        assert(moved.empty() && filled.size() == 5 && filled.last() == 5);
+        moved = {6};
+        moved.pop_front();
+        moved.push_back(8);
+        assert(moved.front() == 8 && moved.last() == 8);
+
+        std::vector<int> model;
+        ads::list<int, std::allocator<int>, ads::singly_linked> l;
+        for (int step = 0; step < 20000; ++step) {
+            if (rng() % 3 && !model.empty()) {
+                assert(l.front() == model.front());
+                l.pop_front();
+                model.erase(model.begin());
+            } else {
+                l.push_back(step);
+                model.push_back(step);
+            }
+            assert(l.size() == model.size());
+        }
+        assert(contents(l) == model);
+    }
+    {
+        // xor_linked: both directions, inserts and erases in the middle.
+        typedef ads::list<int, std::allocator<int>, ads::xor_linked> xor_list;
+        xor_list l({1, 2, 3});
+        l.push_front(0);
+        l.push_back(4);
+        assert((contents(l) == std::vector<int>{0, 1, 2, 3, 4}) && l.front() == 0 && l.last() == 4);
+        assert((std::vector<int>(l.rbegin(), l.rend()) == std::vector<int>{4, 3, 2, 1, 0}));
+        l.reverse();
+        assert((contents(l) == std::vector<int>{4, 3, 2, 1, 0}) && l.front() == 4 && l.last() == 0);
+        l.pop_front();
+        l.pop_back();
+        l.remove_if([](int x) { return x == 2; });
+        assert((contents(l) == std::vector<int>{3, 1}));
+
+        std::vector<int> model;
+        xor_list x;
+        for (int step = 0; step < 20000; ++step) {
+            auto i = model.empty() ? 0 : rng() % (model.size() + 1);
+            auto it = x.begin();
+            for (std::size_t j = 0; j < i; ++j)
+                ++it;
+            if (rng() % 2 || i == model.size()) {
+                it = x.insert(it, step);
+                assert(*it == step);
+                model.insert(model.begin() + i, step);
+            } else {
+                it = x.erase(it);
+                model.erase(model.begin() + i);
+                assert(it == x.end() || *it == model[i]);
+            }
+            if (model.size() > 200) {
+                x.pop_back();
+                model.pop_back();
+            }
+        }
+        assert(contents(x) == model);
+        std::vector<int> backwards(model.rbegin(), model.rend());
+        assert((std::vector<int>(x.crbegin(), x.crend()) == backwards));
+        x.reverse();
+        assert(contents(x) == backwards);
+
+        xor_list copy(x), moved(std::move(x));
+        assert(x.empty() && contents(copy) == backwards && contents(moved) == backwards);
+        x = copy;
+        x.clear();
+        x.push_back(1);
+        assert(x.size() == 1 && x.front() == 1 && x.last() == 1);
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
@@ -0,0 +1,163 @@
+#include "perfect_hash.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Every key of the set must get its own index in [0, n).
+template <class Key, class Hash, class It>
+static void check_minimal(const ads::perfect_hash<Key, Hash>& ph, It first, It last) {
+    std::vector<bool> seen(ph.size(), false);
+    for (; first != last; ++first) {
+        auto i = ph(*first);
+        assert(i < ph.size() && !seen[i]);
+        seen[i] = true;
+    }
+}
+
+int main() {
+    // Small and awkward sizes.
+    for (std::uint64_t n : {0u, 1u, 2u, 3u, 17u, 1000u}) {
+        std::vector<std::uint64_t> keys;
+        for (std::uint64_t i = 0; i < n; ++i)
+            keys.push_back(i * 7919);
+        ads::perfect_hash<std::uint64_t> ph(keys.begin(), keys.end());
+        assert(ph.size() == n);
+        check_minimal(ph, keys.begin(), keys.end());
+    }
+
+    // A million random keys at the default density.
+    std::mt19937_64 rng(1);
+    std::unordered_set<std::uint64_t> unique;
+    while (unique.size() < 1000000)
+        unique.insert(rng());
+    std::vector<std::uint64_t> keys(unique.begin(), unique.end());
+    ads::perfect_hash<std::uint64_t> ph(keys.begin(), keys.end());
+    check_minimal(ph, keys.begin(), keys.end());
+    assert(ph.bits_per_key() < 4.0);
+
+    // Strings, and duplicates.
+    {
+        std::vector<std::string> words;
+        for (int i = 0; i < 5000; ++i)
+            words.push_back("key" + std::to_string(i * i));
+        ads::perfect_hash<std::string> by_name(words.begin(), words.end());
+        check_minimal(by_name, words.begin(), words.end());
+
+        words.push_back("key4");
+        bool thrown = false;
+        try {
+            ads::perfect_hash<std::string> duplicate(words.begin(), words.end());
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // Copies and views of the buffer agree with the original.
+    {
+        ads::perfect_hash<std::uint64_t> copy(ph);
+        std::vector<std::uint64_t> raw(ph.bytes() / 8);
+        std::memcpy(raw.data(), ph.data(), ph.bytes());
+        auto view = ads::perfect_hash<std::uint64_t>::view(raw.data(), ph.bytes());
+        auto view_copy = view;
+        for (std::size_t i = 0; i < keys.size(); i += 13)
+            assert(copy(keys[i]) == ph(keys[i]) && view(keys[i]) == ph(keys[i]) && view_copy(keys[i]) == ph(keys[i]));
+        assert(view.data() == raw.data() && view.bytes() == ph.bytes());
+
+        bool thrown = false;
+        try {
+            ads::perfect_hash<std::uint64_t>::view(raw.data(), ph.bytes() - 8);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        raw[0] ^= 1;
+        thrown = false;
+        try {
+            ads::perfect_hash<std::uint64_t>::view(raw.data(), ph.bytes());
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // A map written to a file and mapped back.
+    {
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> pairs;
+        for (std::size_t i = 0; i < 100000; ++i)
+            pairs.emplace_back(keys[i], static_cast<std::uint32_t>(i));
+        ads::static_hash_map<std::uint64_t, std::uint32_t> map(pairs.begin(), pairs.end());
+        assert(map.size() == pairs.size());
+        for (auto& kv : pairs) {
+            std::uint32_t v = 0;
+            assert(map.find(kv.first, v) && v == kv.second && *map.get(kv.first) == kv.second);
+        }
+        for (std::size_t i = 100000; i < 200000; ++i)
+            assert(!map.has(keys[i]));
+
+        const std::string path = "/tmp/test_perfect_hash.bin";
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0);
+        auto written = write(fd, map.data(), map.bytes());
+        assert(written == static_cast<ssize_t>(map.bytes()));
+        void* mapped = mmap(nullptr, map.bytes(), PROT_READ, MAP_SHARED, fd, 0);
+        assert(mapped != MAP_FAILED);
+        {
+            auto loaded = ads::static_hash_map<std::uint64_t, std::uint32_t>::view(mapped, map.bytes());
+            auto copy = loaded;
+            for (auto& kv : pairs)
+                assert(*loaded.get(kv.first) == kv.second && *copy.get(kv.first) == kv.second);
+            assert(!loaded.has(keys[150000]));
+
+            bool thrown = false;
+            try {
+                ads::static_hash_map<std::uint64_t, std::uint64_t>::view(mapped, map.bytes());
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+        munmap(mapped, map.bytes());
+        close(fd);
+        unlink(path.c_str());
+
+        // Built from no keys: every lookup misses, owned or viewed.
+        std::vector<std::pair<std::uint64_t, std::uint32_t>> none;
+        ads::static_hash_map<std::uint64_t, std::uint32_t> built(none.begin(), none.end());
+        std::vector<char> raw(static_cast<const char*>(built.data()),
+                              static_cast<const char*>(built.data()) + built.bytes());
+        auto built_view = ads::static_hash_map<std::uint64_t, std::uint32_t>::view(raw.data(), raw.size());
+        for (std::size_t i = 0; i < 1000; ++i) {
+            std::uint32_t v = 0;
+            assert(!built.has(keys[i]) && !built.get(keys[i]) && !built.find(keys[i], v));
+            assert(!built_view.has(keys[i]) && !built_view.get(keys[i]));
+        }
+        assert(built.empty() && built_view.empty());
+
+        std::vector<std::uint64_t> no_keys;
+        ads::perfect_hash<std::uint64_t> none_ph(no_keys.begin(), no_keys.end());
+        std::vector<char> ph_raw(static_cast<const char*>(none_ph.data()),
+                                 static_cast<const char*>(none_ph.data()) + none_ph.bytes());
+        auto none_view = ads::perfect_hash<std::uint64_t>::view(ph_raw.data(), ph_raw.size());
+        for (std::size_t i = 0; i < 1000; ++i)
+            assert(none_ph(keys[i]) == 0 && none_view(keys[i]) == 0);
+
+        ads::static_hash_map<std::uint64_t, std::uint32_t> small {{1, 10}, {2, 20}}, empty;
+        assert(small.size() == 2 && *small.get(2) == 20 && !small.has(3));
+        assert(empty.empty() && !empty.has(1));
+        empty = small;
+        assert(empty.has(1));
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
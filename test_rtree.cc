@@ -0,0 +1,158 @@
+#include "rtree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+typedef ads::rtree<2, float, int> tree;
+typedef tree::box_type box;
+
+static box random_box(std::mt19937& rng, float world, float largest) {
+    std::uniform_real_distribution<float> at(0, world), size(0, largest);
+    box b;
+    for (std::size_t d = 0; d < 2; ++d) {
+        b.low[d] = at(rng);
+        b.high[d] = b.low[d] + size(rng);
+    }
+    return b;
+}
+
+// Every query against a scan of the live entries.
+template <class Tree, class Box>
+static void check(const Tree& t, const std::vector<std::pair<Box, int>>& live, std::mt19937& rng, int queries) {
+    assert(t.size() == live.size());
+    for (int q = 0; q < queries; ++q) {
+        auto probe = random_box(rng, 1000, q % 2 ? 50.0f : 0.0f);
+        auto found = t.query(probe);
+        std::vector<int> expected;
+        for (auto& e : live)
+            if (e.first.overlaps(probe))
+                expected.push_back(e.second);
+        std::sort(found.begin(), found.end());
+        std::sort(expected.begin(), expected.end());
+        assert(found == expected);
+    }
+}
+
+int main() {
+    std::mt19937 rng(12);
+
+    tree empty;
+    assert(empty.empty() && empty.height() == 0 && empty.query(box{{{0, 0}}, {{1, 1}}}).empty());
+    assert(!empty.erase(box{{{0, 0}}, {{1, 1}}}, 0));
+
+    tree small;
+    small.insert(box{{{0, 0}}, {{2, 2}}}, 1);
+    small.insert(box{{{1, 1}}, {{3, 3}}}, 2);
+    small.insert(box{{{5, 5}}, {{6, 6}}}, 3);
+    assert(small.size() == 3 && small.height() == 1);
+    assert(small.query(tree::point_type{{1.5f, 1.5f}}).size() == 2 && small.query(tree::point_type{{2, 2}}).size() == 2);
+    assert(small.query(tree::point_type{{4, 4}}).empty());
+    assert(small.query(box{{{3, 3}}, {{5, 5}}}).size() == 2);
+    assert(!small.erase(box{{{0, 0}}, {{2, 2}}}, 2) && small.erase(box{{{0, 0}}, {{2, 2}}}, 1) && small.size() == 2);
+
+    // Inserts and erases, with duplicates, until the tree is several levels
+    // deep, then erased down to nothing.
+    {
+        tree t;
+        std::vector<std::pair<box, int>> live;
+        for (int i = 0; i < 30000; ++i) {
+            if (rng() % 4 || live.empty()) {
+                auto b = random_box(rng, 1000, 20);
+                int v = static_cast<int>(rng() % 5000);
+                t.insert(b, v);
+                live.emplace_back(b, v);
+                if (rng() % 50 == 0) {
+                    t.insert(b, v);
+                    live.emplace_back(b, v);
+                }
+            } else {
+                auto at = rng() % live.size();
+                assert(t.erase(live[at].first, live[at].second));
+                live[at] = live.back();
+                live.pop_back();
+            }
+            if (i % 3000 == 0)
+                check(t, live, rng, 20);
+        }
+        check(t, live, rng, 200);
+        assert(t.height() >= 3);
+
+        tree copy(t);
+        tree moved(std::move(t));
+        assert(t.empty() && t.nodes() == 0 && moved.size() == live.size());
+        check(copy, live, rng, 50);
+        auto all = live;
+
+        while (!live.empty()) {
+            assert(copy.erase(live.back().first, live.back().second));
+            live.pop_back();
+            if (live.size() % 2000 == 0)
+                check(copy, live, rng, 10);
+        }
+        assert(copy.empty() && copy.nodes() == 0 && copy.height() == 0);
+        check(moved, all, rng, 50);
+    }
+
+    // Bulk loading, then mixing in updates.
+    for (std::size_t n : {1u, 15u, 16u, 17u, 300u, 50000u}) {
+        std::vector<std::pair<box, int>> live;
+        for (std::size_t i = 0; i < n; ++i)
+            live.emplace_back(random_box(rng, 1000, 5), static_cast<int>(i));
+        tree t(live);
+        assert(t.size() == n);
+        check(t, live, rng, 100);
+
+        auto whole = t.bounds();
+        for (auto& e : live)
+            assert(whole.contains(e.first));
+
+        for (int i = 0; i < 2000; ++i) {
+            if (rng() % 2) {
+                auto b = random_box(rng, 1000, 5);
+                t.insert(b, -i);
+                live.emplace_back(b, -i);
+            } else if (!live.empty()) {
+                auto at = rng() % live.size();
+                assert(t.erase(live[at].first, live[at].second));
+                live[at] = live.back();
+                live.pop_back();
+            }
+        }
+        check(t, live, rng, 100);
+    }
+
+    // Three dimensions and integer coordinates, through the scalar
+    // overlap test.
+    {
+        typedef ads::rtree<3, int, int> cube_tree;
+        std::vector<std::pair<cube_tree::box_type, int>> live;
+        for (int i = 0; i < 5000; ++i) {
+            cube_tree::box_type b;
+            for (std::size_t d = 0; d < 3; ++d) {
+                b.low[d] = static_cast<int>(rng() % 100);
+                b.high[d] = b.low[d] + static_cast<int>(rng() % 10);
+            }
+            live.emplace_back(b, i);
+        }
+        cube_tree bulk(live), grown;
+        for (auto& e : live)
+            grown.insert(e.first, e.second);
+        for (int q = 0; q < 200; ++q) {
+            cube_tree::point_type p {{static_cast<int>(rng() % 110), static_cast<int>(rng() % 110), static_cast<int>(rng() % 110)}};
+            std::vector<int> expected;
+            for (auto& e : live)
+                if (e.first.overlaps(cube_tree::box_type{p, p}))
+                    expected.push_back(e.second);
+            auto a = bulk.query(p), b = grown.query(p);
+            std::sort(a.begin(), a.end());
+            std::sort(b.begin(), b.end());
+            assert(a == expected && b == expected);
+        }
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
@@ -0,0 +1,180 @@
+#include "shortest_path.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+typedef ads::csr_graph<> graph;
+typedef ads::csr_graph<std::uint32_t, double> real_graph;
+
+// Bellman-Ford over the edge list.
+template <class Distance, class Weight>
+static std::vector<Distance> reference(std::size_t n, const std::vector<graph::edge_type>& edges,
+                                       const std::vector<Weight>& weights, bool undirected, std::uint32_t source) {
+    const Distance inf = std::numeric_limits<Distance>::max();
+    std::vector<Distance> d(n, inf);
+    d[source] = 0;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            for (int dir = 0; dir < (undirected ? 2 : 1); ++dir) {
+                auto u = dir ? edges[i].second : edges[i].first, v = dir ? edges[i].first : edges[i].second;
+                if (d[u] != inf && d[u] + static_cast<Distance>(weights[i]) < d[v]) {
+                    d[v] = d[u] + static_cast<Distance>(weights[i]);
+                    changed = true;
+                }
+            }
+        }
+    }
+    return d;
+}
+
+// Every reached vertex's path must run from source along edges whose
+// weights sum to its distance.
+template <class G, class Paths>
+static void check(const G& g, const Paths& paths, const std::vector<typename Paths::distance_type>& expected,
+                  std::uint32_t source) {
+    for (std::uint32_t v = 0; v < g.vertices(); ++v) {
+        assert(paths.distance[v] == expected[v]);
+        assert(paths.reached(v) == (paths.parent[v] != G::none));
+        if (!paths.reached(v))
+            continue;
+        auto path = paths.path_to(v);
+        assert(path.front() == source && path.back() == v);
+        typename Paths::distance_type sum = 0;
+        for (std::size_t i = 1; i < path.size(); ++i) {
+            auto targets = g.neighbours(path[i - 1]);
+            auto weights = g.weights(path[i - 1]);
+            auto best = Paths::unreachable;
+            for (std::size_t k = 0; k < targets.size(); ++k)
+                if (targets[k] == path[i] && weights[k] < best)
+                    best = weights[k];
+            assert(best != Paths::unreachable);
+            sum += best;
+        }
+        assert(sum == expected[v]);
+    }
+}
+
+int main() {
+    ads::thread_pool pool(4);
+    std::mt19937 rng(3);
+
+    // A small graph by hand: the cheap route to 3 is the long one.
+    {
+        std::vector<graph::edge_type> edges {{0, 1}, {1, 2}, {2, 3}, {0, 3}, {3, 4}, {5, 0}};
+        std::vector<std::uint32_t> weights {1, 1, 1, 5, 0, 1};
+        graph g(6, edges, weights);
+        assert(g.weighted() && g.weights(0).size() == 2 && g.weights(0)[1] == 5);
+        for (auto paths : {ads::dijkstra(g, 0u), ads::dijkstra_radix(g, 0u), ads::delta_stepping(g, 0u, 2, pool)}) {
+            assert(paths.distance[3] == 3 && paths.distance[4] == 3 && !paths.reached(5));
+            assert((paths.path_to(4) == std::vector<std::uint32_t>{0, 1, 2, 3, 4}) && paths.path_to(5).empty());
+        }
+        auto paths = ads::a_star(g, 0u, 4u, [](std::uint32_t) { return 0; });
+        assert(paths.distance[4] == 3 && paths.path_to(4).size() == 5);
+
+        bool thrown = false;
+        try {
+            ads::dijkstra(graph(3, {{0, 1}}), 0u);
+        } catch (const std::logic_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        thrown = false;
+        try {
+            ads::dijkstra(g, 6u);
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+        thrown = false;
+        try {
+            ads::delta_stepping(g, 0u, 0, pool);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+        thrown = false;
+        try {
+            graph(2, {{0, 1}}, std::vector<std::uint32_t>{1, 2});
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // Random graphs against Bellman-Ford, with zero weights, duplicate
+    // edges and several bucket widths, including ones below and above
+    // every weight.
+    for (auto kind : {ads::graph_kind::directed, ads::graph_kind::undirected}) {
+        for (int trial = 0; trial < 4; ++trial) {
+            const std::size_t n = 2000;
+            std::vector<graph::edge_type> edges(6000);
+            std::vector<std::uint32_t> weights(edges.size());
+            for (std::size_t i = 0; i < edges.size(); ++i) {
+                edges[i] = graph::edge_type(rng() % n, rng() % n);
+                weights[i] = rng() % 8 ? rng() % 100 : 0;
+            }
+            graph g(n, edges, weights, pool, kind);
+            const bool undirected = kind == ads::graph_kind::undirected;
+            for (std::uint32_t source : {0u, static_cast<std::uint32_t>(rng() % n)}) {
+                auto expected = reference<std::uint64_t>(n, edges, weights, undirected, source);
+                check(g, ads::dijkstra(g, source), expected, source);
+                check(g, ads::dijkstra_radix(g, source), expected, source);
+                for (std::uint64_t delta : {1u, 30u, 1000u})
+                    check(g, ads::delta_stepping(g, source, delta, pool), expected, source);
+
+                auto target = static_cast<std::uint32_t>(rng() % n);
+                auto zero = [](std::uint32_t) { return 0; };
+                auto paths = ads::a_star(g, source, target, zero);
+                assert(paths.distance[target] == expected[target]);
+                assert(paths.path_to(target).empty() == !paths.reached(target));
+            }
+        }
+    }
+
+    // Floating weights on a grid, with A* guided by straight-line distance.
+    {
+        const std::uint32_t side = 60, n = side * side;
+        std::vector<graph::edge_type> edges;
+        std::vector<double> weights;
+        std::uniform_real_distribution<double> stretch(1, 3);
+        for (std::uint32_t v = 0; v < n; ++v) {
+            if (v % side + 1 < side) {
+                edges.emplace_back(v, v + 1);
+                weights.push_back(stretch(rng));
+            }
+            if (v + side < n) {
+                edges.emplace_back(v, v + side);
+                weights.push_back(stretch(rng));
+            }
+        }
+        real_graph g(n, edges, weights, ads::graph_kind::undirected);
+        auto expected = reference<double>(n, edges, weights, true, 0);
+        auto a = ads::dijkstra(g, 0u);
+        auto b = ads::delta_stepping(g, 0u, 2.0, pool);
+        for (std::uint32_t v = 0; v < n; ++v)
+            assert(std::abs(a.distance[v] - expected[v]) < 1e-9 && std::abs(b.distance[v] - expected[v]) < 1e-9);
+
+        const std::uint32_t target = side / 2 * side + side / 2;
+        auto straight = [&](std::uint32_t v) {
+            double dx = double(v % side) - double(target % side), dy = double(v / side) - double(target / side);
+            return std::sqrt(dx * dx + dy * dy);
+        };
+        auto star = ads::a_star(g, 0u, target, straight);
+        auto blind = ads::a_star(g, 0u, target, [](std::uint32_t) { return 0.0; });
+        assert(std::abs(star.distance[target] - expected[target]) < 1e-9 && blind.distance[target] == star.distance[target]);
+        std::size_t explored = 0, blind_explored = 0;
+        for (std::uint32_t v = 0; v < n; ++v) {
+            explored += star.reached(v);
+            blind_explored += blind.reached(v);
+        }
+        assert(explored < blind_explored);
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
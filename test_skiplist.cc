@@ -0,0 +1,217 @@
+#include "skiplist.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+    ads::skiplist<int> s {5, 1, 4, 2, 3, 3};
+    assert(s.size() == 5);
+    assert((std::vector<int>(s.begin(), s.end()) == std::vector<int>{1, 2, 3, 4, 5}));
+    assert(s.get(0) == 1 && s.get(4) == 5 && s[2] == 3);
+    assert(s.index_of(4) == 3 && s.index_of(9) == s.size());
+
+    // Randomised against std::set, mixing value and rank operations.
+    std::mt19937 rng(1);
+    ads::skiplist<int> sl;
+    std::set<int> ref;
+    for (int i = 0; i < 20000; ++i) {
+        int x = static_cast<int>(rng() % 2000);
+        switch (rng() % 5) {
+        case 0:
+        case 1:
+            assert(sl.insert(x) == ref.insert(x).second);
+            break;
+        case 2:
+            assert(sl.erase(x) == (ref.erase(x) == 1));
+            break;
+        case 3:
+            if (!ref.empty()) {
+                auto index = rng() % ref.size();
+                auto it = std::next(ref.begin(), static_cast<long>(index));
+                assert(sl.get(index) == *it);
+                assert(sl.index_of(*it) == index);
+                if (rng() % 2) {
+                    sl.remove(index);
+                    ref.erase(it);
+                }
+            }
+            break;
+        default:
+            assert(sl.has(x) == (ref.count(x) == 1));
+            auto lb = sl.lower_bound(x);
+            auto rlb = ref.lower_bound(x);
+            assert((lb == sl.end()) == (rlb == ref.end()));
+            if (rlb != ref.end())
+                assert(*lb == *rlb);
+        }
+        assert(sl.size() == ref.size());
+    }
+    assert(std::equal(sl.begin(), sl.end(), ref.begin()));
+
+    // Ascending lookups go through the finger.
+    for (int x = 0; x < 2000; ++x)
+        assert(sl.has(x) == (ref.count(x) == 1));
+
+    // Positional add of sorted data, copy and move.
+    ads::skiplist<std::string> words;
+    for (auto w : {"apple", "banana", "cherry"})
+        words.add(words.size(), w);
+    words.add(1, "apricot");
+    words.set(3, "cranberry");
+    auto copy = words;
+    auto moved = std::move(words);
+    assert(words.empty() && copy.size() == 4 && moved.get(1) == "apricot" && moved.get(3) == "cranberry");
+
+    // Map form, ordered and searched by key, against std::map.
+    ads::skiplist_map<int, std::string> m {{3, "c"}, {1, "a"}, {2, "b"}};
+    assert(m.size() == 3 && m.get(0).first == 1 && m.at(2) == "b" && m.index_of(3) == 2);
+    assert(!m.insert(2, "x") && m[2] == "b");
+    assert(!m.insert_or_assign(2, "bb") && m.insert_or_assign(4, "d") && m.at(2) == "bb");
+    m[0] += "zero";
+    m.find(4)->second = "dd";
+    assert(m.has(0) && m.begin()->second == "zero" && m.at(4) == "dd");
+    bool threw = false;
+    try { m.at(9); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+
+    ads::skiplist_map<int, int> sm;
+    std::map<int, int> rm;
+    for (int i = 0; i < 20000; ++i) {
+        int k = static_cast<int>(rng() % 2000);
+        switch (rng() % 4) {
+        case 0:
+            sm[k] += i;
+            rm[k] += i;
+            break;
+        case 1:
+            assert(sm.insert(k, i) == rm.insert({k, i}).second);
+            break;
+        case 2:
+            assert(sm.erase(k) == (rm.erase(k) == 1));
+            break;
+        default:
+            auto it = sm.lower_bound(k);
+            auto rit = rm.lower_bound(k);
+            assert((it == sm.end()) == (rit == rm.end()));
+            if (rit != rm.end())
+                assert(it->first == rit->first && it->second == rit->second);
+        }
+    }
+    assert(sm.size() == rm.size() && std::equal(sm.begin(), sm.end(), rm.begin()));
+    auto sm_copy = sm;
+    sm.clear();
+    assert(sm.empty() && sm_copy.size() == rm.size() && sm_copy.index_of(rm.rbegin()->first) == rm.size() - 1);
+
+    // Const lookups leave the finger alone, so several threads may share them.
+    {
+        const auto& csl = sl;
+        const auto& cmap = sm_copy;
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&, t] {
+                for (int x = t; x < 2000; x += 3) {
+                    assert(csl.has(x) == (ref.count(x) == 1));
+                    auto it = cmap.find(x);
+                    assert((it == cmap.end()) == (rm.count(x) == 0));
+                    if (it != cmap.end())
+                        assert(cmap.at(x) == rm.at(x) && cmap.lower_bound(x) == it);
+                }
+            });
+        }
+        for (auto& r : readers)
+            r.join();
+    }
+
+    // Concurrent skiplist: disjoint inserts and erases from several threads.
+    ads::concurrent_skiplist<int> cs;
+    assert(cs.insert(3) && !cs.insert(3) && cs.has(3) && cs.erase(3) && !cs.has(3) && !cs.erase(3));
+
+    const int threads = 4, per_thread = 10000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]{
+            for (int i = 0; i < per_thread; ++i)
+                assert(cs.insert(t * per_thread + i));
+            for (int i = 0; i < per_thread; i += 2)
+                assert(cs.erase(t * per_thread + i));
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    assert(cs.size() == threads * per_thread / 2);
+    for (int i = 0; i < threads * per_thread; ++i)
+        assert(cs.has(i) == (i % 2 == 1));
+
+    // Contended updates on a small key range leave a sorted set behind.
+    workers.clear();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]{
+            std::mt19937 local(static_cast<unsigned>(t));
+            for (int i = 0; i < 50000; ++i) {
+                int k = static_cast<int>(local() % 500);
+                if (local() % 2)
+                    cs.insert(k);
+                else
+                    cs.erase(k);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    std::vector<int> seen;
+    cs.for_each([&](int x){ seen.push_back(x); });
+    assert(std::is_sorted(seen.begin(), seen.end()) && seen.size() == cs.size());
+
+    // Concurrent map: every stored value is a multiple of its key's tag, so
+    // a torn or misplaced value shows up; writers overwrite and erase on a
+    // small key range while readers check what they find.
+    ads::concurrent_skiplist_map<int, std::string> cm;
+    std::string out;
+    assert(cm.insert(1, "one") && !cm.insert(1, "uno") && cm.find(1, out) && out == "one");
+    assert(!cm.insert_or_assign(1, "uno") && cm.find(1, out) && out == "uno");
+    assert(cm.erase(1) && !cm.has(1) && !cm.erase(1) && cm.insert_or_assign(1, "eins") && cm.size() == 1);
+
+    ads::concurrent_skiplist_map<int, long> counts;
+    workers.clear();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]{
+            std::mt19937 local(static_cast<unsigned>(t) + 100);
+            for (int i = 0; i < 50000; ++i) {
+                int k = static_cast<int>(local() % 300);
+                long v = 0;
+                switch (local() % 4) {
+                case 0:
+                    counts.insert(k, 1000L * k);
+                    break;
+                case 1:
+                    counts.insert_or_assign(k, 1000L * k + t);
+                    break;
+                case 2:
+                    counts.erase(k);
+                    break;
+                default:
+                    if (counts.find(k, v))
+                        assert(v / 1000 == k);
+                }
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    std::vector<int> keys;
+    counts.for_each([&](int k, long v){ assert(v / 1000 == k); keys.push_back(k); });
+    assert(std::is_sorted(keys.begin(), keys.end()) && keys.size() == counts.size());
+    for (int k = 0; k < 300; ++k)
+        assert(counts.has(k) == std::binary_search(keys.begin(), keys.end(), k));
+
+    std::cout << "skiplist tests passed\n";
+}
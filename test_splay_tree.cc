@@ -0,0 +1,105 @@
+#include "splay_tree.h"
+#include "avl_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+template <class Tree>
+static std::vector<int> contents(const Tree& t) {
+    std::vector<int> out;
+    t.for_each([&](int x){ out.push_back(x); });
+    return out;
+}
+
+int main() {
+    ads::splay_tree<int> t {5, 1, 4, 2, 3, 3};
+    assert(t.size() == 5);
+    assert((contents(t) == std::vector<int>{1, 2, 3, 4, 5}));
+    assert(t.has(4) && !t.has(9) && !t.erase(9) && t.erase(1));
+    assert((contents(t) == std::vector<int>{2, 3, 4, 5}));
+
+    // Randomised against std::set.
+    std::mt19937 rng(1);
+    ads::splay_tree<int> splay;
+    std::set<int> ref;
+    for (int i = 0; i < 40000; ++i) {
+        int x = static_cast<int>(rng() % 3000);
+        switch (rng() % 4) {
+        case 0:
+        case 1:
+            assert(splay.insert(x) == ref.insert(x).second);
+            break;
+        case 2:
+            assert(splay.erase(x) == (ref.erase(x) == 1));
+            break;
+        default:
+            assert(splay.has(x) == (ref.count(x) == 1));
+        }
+        assert(splay.size() == ref.size());
+    }
+    assert(contents(splay) == std::vector<int>(ref.begin(), ref.end()));
+
+    // A path shaped tree: ascending inserts, then a deep lookup and
+    // destruction, neither of which may recurse.
+    {
+        ads::splay_tree<int> path;
+        for (int i = 0; i < 1000000; ++i)
+            path.insert(i);
+        assert(path.has(0) && path.has(999999) && path.size() == 1000000);
+    }
+
+    // Non-overlapping merges are joins.
+    ads::splay_tree<int> low, high;
+    for (int i = 0; i < 1000; ++i) {
+        low.insert(i);
+        high.insert(i + 1000);
+    }
+    high.merge(low);
+    assert(low.empty() && high.size() == 2000);
+    auto joined = contents(high);
+    for (int i = 0; i < 2000; ++i)
+        assert(joined[i] == i);
+
+    // Interleaved merge drops duplicates.
+    ads::splay_tree<int> evens, threes;
+    std::set<int> both;
+    for (int i = 0; i < 5000; i += 2) {
+        evens.insert(i);
+        both.insert(i);
+    }
+    for (int i = 0; i < 5000; i += 3) {
+        threes.insert(i);
+        both.insert(i);
+    }
+    evens.merge(threes);
+    assert(threes.empty() && evens.size() == both.size());
+    assert(contents(evens) == std::vector<int>(both.begin(), both.end()));
+
+    // Merging across tree kinds through the binary_tree interface.
+    ads::avl_tree<int> avl {1, 2, 3, 5001};
+    ads::binary_tree<int>& base = evens;
+    base.merge(avl);
+    assert(avl.empty() && evens.has(1) && evens.has(5001) && evens.size() == both.size() + 2);
+    ads::binary_tree<int>& avl_base = avl;
+    avl_base.merge(std::move(high));
+    assert(high.empty() && avl.size() == 2000 && avl.has(1999));
+
+    // Copy, move and emplace.
+    ads::splay_tree<std::string> words {"pear", "apple", "fig"};
+    auto copy = words;
+    words.remove("pear");
+    assert(copy.has("pear") && !words.has("pear") && copy.size() == 3);
+    auto moved = std::move(copy);
+    assert(copy.empty() && moved.size() == 3);
+    assert(moved.emplace(3, 'z') && !moved.emplace("zzz"));
+    copy = moved;
+    moved.clear();
+    assert(moved.empty() && copy.size() == 4 && copy.has("zzz"));
+
+    std::cout << "splay_tree tests passed\n";
+}
@@ -0,0 +1,119 @@
+#include "stack.h"
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Copies throw once the budget runs out; the move may throw, so relocation copies.
+struct fragile {
+    static int live, budget;
+    int value;
+
+    explicit fragile(int v) : value(v) { ++live; }
+    fragile(const fragile& rhs) : value(rhs.value) {
+        if (budget-- == 0)
+            throw std::runtime_error("copy");
+        ++live;
+    }
+    fragile(fragile&& rhs) : fragile(static_cast<const fragile&>(rhs)) {}
+    ~fragile() { --live; }
+};
+int fragile::live = 0, fragile::budget = -1;
+
+int main() {
+    ads::stack<int> s;
+    for (int i = 0; i < 100; ++i)
+        s.push(i);
+    assert(s.size() == 100 && s.top() == 99);
+    assert(s.pop() == 99);
+
+    std::vector<int> more {100, 101, 102};
+    s.push_range(more.begin(), more.end());
+    assert(s.top() == 102);
+
+    std::vector<int> out;
+    s.pop_n(3, std::back_inserter(out));
+    assert((out == std::vector<int>{102, 101, 100}));
+    s.pop_n(98);
+    assert(s.size() == 1 && s.pop() == 0 && s.empty());
+
+    // Move-only elements, both inline and after spilling to the heap.
+    ads::stack<std::unique_ptr<std::string>> owned;
+    for (int i = 0; i < 20; ++i)
+        owned.emplace(new std::string(std::to_string(i)));
+    auto p = owned.pop();
+    assert(*p == "19" && *owned.top() == "18");
+
+    // The list-backed configuration supports the same interface.
+    ads::stack<int, ads::list<int>> ls;
+    ls.push_range(more.begin(), more.end());
+    ls.emplace(7);
+    assert(ls.pop() == 7 && ls.top() == 102);
+    ls.pop_n(2);
+    assert(ls.size() == 1 && ls.top() == 100);
+
+    // small_vector copies and moves.
+    ads::small_vector<std::string, 2> a {"x", "y", "z"};
+    auto b = a;
+    auto c = std::move(a);
+    assert(b.size() == 3 && c.size() == 3 && a.empty() && c[2] == "z");
+
+    // A throwing relocation leaves the elements intact and frees its block.
+    {
+        ads::small_vector<fragile, 4> f;
+        for (int i = 0; i < 8; ++i)
+            f.emplace_back(i);
+        fragile::budget = 5;
+        bool threw = false;
+        try {
+            f.emplace_back(8);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && f.size() == 8 && fragile::live == 8);
+        fragile::budget = 3;
+        threw = false;
+        try {
+            f.reserve(100);
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && f.size() == 8 && fragile::live == 8);
+        for (int i = 0; i < 8; ++i)
+            assert(f[i].value == i);
+        fragile::budget = -1;
+        f.emplace_back(8);
+        assert(f.size() == 9 && fragile::live == 9 && f[8].value == 8);
+    }
+    assert(fragile::live == 0);
+
+    // Lock-free stack: every element pushed is popped exactly once.
+    ads::concurrent_stack<int> cs;
+    const int per_thread = 50000, threads = 4;
+    std::vector<std::atomic<int>> seen(per_thread * threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]{
+            int v;
+            for (int i = 0; i < per_thread; ++i) {
+                cs.push(t * per_thread + i);
+                if (i % 2 && cs.try_pop(v))
+                    seen[v].fetch_add(1);
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    int v;
+    while (cs.try_pop(v))
+        seen[v].fetch_add(1);
+    for (auto& count : seen)
+        assert(count.load() == 1);
+    assert(cs.empty());
+
+    std::cout << "stack tests passed\n";
+}
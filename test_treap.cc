@@ -0,0 +1,245 @@
+#include "treap.h"
+#include "avl_tree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+template <class Tree>
+static std::vector<int> contents(const Tree& t) {
+    std::vector<int> out;
+    t.for_each([&](int x){ out.push_back(x); });
+    return out;
+}
+
+static ads::treap<int> random_treap(std::mt19937& rng, int n, int range, std::set<int>& ref) {
+    ads::treap<int> t;
+    for (int i = 0; i < n; ++i) {
+        int x = static_cast<int>(rng() % static_cast<unsigned>(range));
+        t.insert(x);
+        ref.insert(x);
+    }
+    return t;
+}
+
+// The set operations against the std algorithms, with and without a pool.
+static void set_operations(ads::thread_pool* pool) {
+    std::mt19937 rng(pool ? 9 : 8);
+    for (int round = 0; round < 30; ++round) {
+        int n = static_cast<int>(rng() % 20000), m = static_cast<int>(rng() % 20000);
+        int range = 1 + static_cast<int>(rng() % 50000);
+        std::set<int> a_ref, b_ref;
+        std::vector<int> expect;
+
+        auto a = random_treap(rng, n, range, a_ref);
+        auto b = random_treap(rng, m, range, b_ref);
+        switch (round % 3) {
+        case 0:
+            std::set_union(a_ref.begin(), a_ref.end(), b_ref.begin(), b_ref.end(), std::back_inserter(expect));
+            pool ? a.unite(b, *pool) : a.unite(b);
+            break;
+        case 1:
+            std::set_intersection(a_ref.begin(), a_ref.end(), b_ref.begin(), b_ref.end(), std::back_inserter(expect));
+            pool ? a.intersect(b, *pool) : a.intersect(b);
+            break;
+        default:
+            std::set_difference(a_ref.begin(), a_ref.end(), b_ref.begin(), b_ref.end(), std::back_inserter(expect));
+            pool ? a.subtract(b, *pool) : a.subtract(b);
+        }
+
+        assert(b.empty() && contents(b).empty());
+        assert(a.size() == expect.size() && contents(a) == expect);
+        for (std::size_t i = 0; i < expect.size(); i += 97)
+            assert(a.get(i) == expect[i] && a.index_of(expect[i]) == i);
+    }
+}
+
+// Compares by the first member only, to see which copy a set operation
+// keeps.
+struct by_key {
+    bool operator()(const std::pair<int, int>& a, const std::pair<int, int>& b) const { return a.first < b.first; }
+};
+
+int main() {
+    ads::treap<int> t {5, 1, 4, 2, 3, 3};
+    assert(t.size() == 5);
+    assert((contents(t) == std::vector<int>{1, 2, 3, 4, 5}));
+    assert(t.has(4) && !t.has(9) && !t.erase(9) && t.erase(1));
+    assert((contents(t) == std::vector<int>{2, 3, 4, 5}));
+    assert(t.get(0) == 2 && t.get(3) == 5 && t.index_of(4) == 2 && t.index_of(100) == 4);
+    assert(!t.emplace(3) && t.emplace(6) && t.size() == 5);
+
+    // Randomised against std::set, ranks included.
+    std::mt19937 rng(1);
+    ads::treap<int> treap;
+    std::set<int> ref;
+    for (int i = 0; i < 40000; ++i) {
+        int x = static_cast<int>(rng() % 3000);
+        switch (rng() % 5) {
+        case 0:
+        case 1:
+            assert(treap.insert(x) == ref.insert(x).second);
+            break;
+        case 2:
+            assert(treap.erase(x) == (ref.erase(x) == 1));
+            break;
+        case 3:
+            assert(treap.index_of(x) == static_cast<std::size_t>(std::distance(ref.begin(), ref.lower_bound(x))));
+            break;
+        default:
+            assert(treap.has(x) == (ref.count(x) == 1));
+        }
+        assert(treap.size() == ref.size());
+    }
+    assert(contents(treap) == std::vector<int>(ref.begin(), ref.end()));
+
+    // Ascending inserts stay balanced: the priorities, not the order, set
+    // the shape.
+    {
+        ads::treap<int> sorted;
+        for (int i = 0; i < 100000; ++i)
+            sorted.insert(i);
+        assert(sorted.height() < 60);
+        ads::treap<int> copy(sorted);
+        assert(copy.size() == 100000 && copy.height() < 60 && contents(copy) == contents(sorted));
+        copy = ads::treap<int>{7};
+        assert((contents(copy) == std::vector<int>{7}));
+    }
+
+    // split and join.
+    {
+        ads::treap<int> all;
+        for (int i = 0; i < 1000; ++i)
+            all.insert(i * 2);
+        auto high = all.split(700);
+        assert(all.size() == 350 && high.size() == 650);
+        assert(all.get(349) == 698 && high.get(0) == 700);
+        auto empty = all.split(5000);
+        assert(empty.empty() && all.size() == 350);
+        all.join(high);
+        assert(all.size() == 1000 && high.empty() && all.index_of(700) == 350);
+        auto odd = all.split(701);
+        assert(odd.get(0) == 702);
+        all.join(odd);
+        assert(all.size() == 1000);
+    }
+
+    set_operations(nullptr);
+    {
+        ads::thread_pool pool(4);
+        set_operations(&pool);
+    }
+
+    // Where both sides hold an equal element, this treap's copy stays.
+    {
+        ads::treap<std::pair<int, int>, by_key> mine, theirs;
+        for (int i = 0; i < 2000; ++i) {
+            mine.insert(std::make_pair(i, 0));
+            theirs.insert(std::make_pair(i + 1000, 1));
+        }
+        mine.unite(theirs);
+        assert(mine.size() == 3000);
+        for (int i = 0; i < 3000; ++i)
+            assert(mine.get(i).second == (i < 2000 ? 0 : 1));
+
+        for (int i = 0; i < 3000; i += 2)
+            theirs.insert(std::make_pair(i, 1));
+        mine.intersect(theirs);
+        assert(mine.size() == 1500);
+        for (std::size_t i = 0; i < mine.size(); ++i)
+            assert(mine.get(i).second == (mine.get(i).first < 2000 ? 0 : 1));
+    }
+
+    // merge takes treaps whole and other trees element by element.
+    {
+        ads::treap<int> a {1, 2, 3}, b {3, 4};
+        a.merge(b);
+        assert((contents(a) == std::vector<int>{1, 2, 3, 4}) && b.empty());
+        ads::avl_tree<int> avl {0, 4, 9};
+        a.merge(avl);
+        assert((contents(a) == std::vector<int>{0, 1, 2, 3, 4, 9}) && avl.empty());
+        a.merge(a);
+        assert(a.size() == 6);
+    }
+
+    // The implicit treap against std::vector.
+    {
+        ads::implicit_treap<int> seq;
+        std::vector<int> vec;
+        for (int i = 0; i < 30000; ++i) {
+            auto pos = vec.empty() ? 0 : rng() % (vec.size() + 1);
+            int x = static_cast<int>(rng() % 100000);
+            switch (rng() % 6) {
+            case 0:
+            case 1:
+                seq.insert(pos, x);
+                vec.insert(vec.begin() + pos, x);
+                break;
+            case 2:
+                if (!vec.empty()) {
+                    pos %= vec.size();
+                    seq.erase(pos);
+                    vec.erase(vec.begin() + pos);
+                }
+                break;
+            case 3:
+                seq.push_back(x);
+                vec.push_back(x);
+                break;
+            case 4:
+                if (!vec.empty()) {
+                    pos %= vec.size();
+                    seq[pos] = x;
+                    vec[pos] = x;
+                }
+                break;
+            default:
+                if (!vec.empty()) {
+                    pos %= vec.size();
+                    assert(seq.at(pos) == vec[pos]);
+                }
+            }
+            assert(seq.size() == vec.size());
+        }
+        assert(contents(seq) == vec);
+        assert(seq.front() == vec.front() && seq.back() == vec.back());
+
+        // Cut in three and reassemble in a different order.
+        auto tail = seq.split(seq.size() * 2 / 3);
+        auto middle = seq.split(seq.size() / 2);
+        std::vector<int> rotated(vec.begin() + static_cast<std::ptrdiff_t>(seq.size()), vec.end());
+        rotated.insert(rotated.end(), vec.begin(), vec.begin() + static_cast<std::ptrdiff_t>(seq.size()));
+        middle.append(tail);
+        middle.append(seq);
+        assert(seq.empty() && tail.empty() && contents(middle) == rotated);
+
+        ads::implicit_treap<int> copy(middle);
+        assert(contents(copy) == rotated && copy.height() < 60);
+        copy.pop_front();
+        copy.pop_back();
+        assert(copy.size() == rotated.size() - 2 && copy.front() == rotated[1]);
+
+        bool thrown = false;
+        try {
+            copy.at(copy.size());
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    {
+        ads::implicit_treap<std::string> words {"b", "c"};
+        words.push_front("a");
+        words.emplace(3, 2, 'd');
+        assert(words.size() == 4 && words[0] == "a" && words[3] == "dd");
+    }
+
+    std::cout << "All tests passed." << std::endl;
+}
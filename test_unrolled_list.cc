@@ -0,0 +1,193 @@
+#include "unrolled_list.h"
+
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Counts live objects so that leaks and double destruction show up.
+struct tracked {
+    static long live;
+    int value;
+
+    tracked(int v = 0) : value(v) { ++live; }
+    tracked(const tracked& t) : value(t.value) { ++live; }
+    tracked& operator=(const tracked&) = default;
+    ~tracked() { --live; }
+
+    bool operator==(const tracked& t) const { return value == t.value; }
+    bool operator<(const tracked& t) const { return value < t.value; }
+};
+long tracked::live = 0;
+
+template <class List>
+static std::vector<int> contents(const List& l) {
+    std::vector<int> out;
+    for (auto it = l.cbegin(); it != l.cend(); ++it)
+        out.push_back(it->value);
+    std::vector<int> backwards;
+    for (auto it = l.crbegin(); it != l.crend(); ++it)
+        backwards.insert(backwards.begin(), it->value);
+    assert(out == backwards && out.size() == l.size());
+    return out;
+}
+
+typedef ads::unrolled_list<tracked> list;
+
+static list::iterator nth(list& l, std::size_t i) {
+    auto it = l.begin();
+    std::advance(it, i);
+    return it;
+}
+
+int main() {
+    std::mt19937 rng(3);
+    {
+        // Basic interface, mirroring list.
+        ads::unrolled_list<int> l({4, 3, 6, 1});
+        l.push_back(2);
+        l.push_front(9);
+        l.remove(3);
+        assert((std::vector<int>(l.begin(), l.end()) == std::vector<int>{9, 4, 6, 1, 2}));
+        assert(l.front() == 9 && l.last() == 2 && l[2] == 6 && l.at(4) == 2);
+        l.sort();
+        assert((std::vector<int>(l.begin(), l.end()) == std::vector<int>{1, 2, 4, 6, 9}));
+        l.reverse();
+        assert((std::vector<int>(l.begin(), l.end()) == std::vector<int>{9, 6, 4, 2, 1}));
+        l.pop_front();
+        l.pop_back();
+        assert((std::vector<int>(l.begin(), l.end()) == std::vector<int>{6, 4, 2}));
+
+        // Runs of pushes at either end pack chunks full.
+        ads::unrolled_list<int> packed;
+        std::size_t n = 10 * packed.chunk_capacity;
+        for (std::size_t i = 0; i < n; ++i)
+            i % 2 ? packed.push_back(static_cast<int>(i)) : packed.push_front(static_cast<int>(i));
+        assert(packed.size() == n && packed.chunks() <= 11);
+        ads::unrolled_list<int> filled(n, 7);
+        assert(filled.chunks() == 10 && filled.at(n - 1) == 7);
+
+        ads::unrolled_list<std::string> words(3, "abcdefghijklmnopqrstuvwxyz");
+        words.insert(++words.cbegin(), "x");
+        words.emplace(words.cend(), 3, 'y');
+        assert(words.size() == 5 && words.at(1) == "x" && words.last() == "yyy");
+        auto copy = words;
+        words.clear();
+        assert(words.empty() && copy.size() == 5 && copy.front().size() == 26);
+    }
+
+    // Random operations against a vector.
+    for (int round = 0; round < 30; ++round) {
+        list a, b;
+        std::vector<int> ra, rb;
+        int next = 0;
+        for (int step = 0; step < 400; ++step) {
+            int op = std::uniform_int_distribution<int>(0, 11)(rng);
+            auto pick = [&](std::size_t n) { return std::uniform_int_distribution<std::size_t>(0, n)(rng); };
+            if (op <= 3) {
+                auto i = pick(ra.size());
+                auto it = a.insert(nth(a, i), tracked(next));
+                assert(it->value == next);
+                ra.insert(ra.begin() + i, next++);
+            } else if (op == 4 && !ra.empty()) {
+                auto i = pick(ra.size() - 1);
+                auto it = a.erase(nth(a, i));
+                ra.erase(ra.begin() + i);
+                assert(i == ra.size() ? it == a.end() : it->value == ra[i]);
+            } else if (op == 5) {
+                auto i = pick(ra.size()), j = pick(ra.size());
+                if (i > j) std::swap(i, j);
+                auto it = a.erase(nth(a, i), nth(a, j));
+                ra.erase(ra.begin() + i, ra.begin() + j);
+                assert(i == ra.size() ? it == a.end() : it->value == ra[i]);
+            } else if (op == 6) {
+                auto i = pick(ra.size());
+                auto n = pick(60);
+                std::vector<tracked> values;
+                for (std::size_t k = 0; k < n; ++k)
+                    values.push_back(next + static_cast<int>(k));
+                list source(n, tracked(0));
+                auto s = source.begin();
+                for (auto& v : values)
+                    *s++ = v;
+                auto it = a.insert(nth(a, i), source.begin(), source.end());
+                for (std::size_t k = 0; k < n; ++k)
+                    ra.insert(ra.begin() + i + k, next++);
+                assert(n == 0 || it->value == ra[i]);
+            } else if (op == 7 && !ra.empty()) {
+                // Splice a range of a into b.
+                auto i = pick(ra.size()), j = pick(ra.size()), k = pick(rb.size());
+                if (i > j) std::swap(i, j);
+                b.splice(nth(b, k), a, nth(a, i), nth(a, j));
+                rb.insert(rb.begin() + k, ra.begin() + i, ra.begin() + j);
+                ra.erase(ra.begin() + i, ra.begin() + j);
+            } else if (op == 8 && !rb.empty()) {
+                // Splice a single element of b into a.
+                auto i = pick(rb.size() - 1), k = pick(ra.size());
+                a.splice(nth(a, k), b, nth(b, i));
+                ra.insert(ra.begin() + k, rb[i]);
+                rb.erase(rb.begin() + i);
+            } else if (op == 9 && ra.size() > 2) {
+                // Move a range within a.
+                auto i = pick(ra.size()), j = pick(ra.size());
+                if (i > j) std::swap(i, j);
+                auto k = pick(ra.size() - (j - i));
+                if (k > i) k += j - i;
+                a.splice(nth(a, k), a, nth(a, i), nth(a, j));
+                std::vector<int> moved(ra.begin() + i, ra.begin() + j);
+                if (k >= j) {
+                    ra.insert(ra.begin() + k, moved.begin(), moved.end());
+                    ra.erase(ra.begin() + i, ra.begin() + j);
+                } else {
+                    ra.erase(ra.begin() + i, ra.begin() + j);
+                    ra.insert(ra.begin() + k, moved.begin(), moved.end());
+                }
+            } else if (op == 10) {
+                a.remove_if([](const tracked& t) { return t.value % 7 == 0; });
+                ra.erase(std::remove_if(ra.begin(), ra.end(), [](int v) { return v % 7 == 0; }), ra.end());
+            } else if (op == 11 && step % 50 == 0) {
+                a.splice(a.cend(), b);
+                ra.insert(ra.end(), rb.begin(), rb.end());
+                rb.clear();
+            }
+            assert(contents(a) == ra && contents(b) == rb);
+            for (std::size_t i = 0; i < ra.size(); i += 17)
+                assert(a[i].value == ra[i]);
+        }
+
+        // No chunk is left much emptier than merging allows.
+        if (a.size() > 4 * a.chunk_capacity)
+            assert(a.chunks() * a.chunk_capacity / 4 <= a.size() + a.chunk_capacity);
+
+        // sort, unique and merge.
+        for (auto& t : a)
+            t.value %= 50;
+        for (auto& v : ra)
+            v %= 50;
+        a.sort();
+        std::stable_sort(ra.begin(), ra.end());
+        assert(contents(a) == ra);
+        a.unique();
+        ra.erase(std::unique(ra.begin(), ra.end()), ra.end());
+        assert(contents(a) == ra);
+        b.sort([](list::iterator x, list::iterator y) { return x->value < y->value; });
+        std::sort(rb.begin(), rb.end());
+        a.merge(b);
+        ra.insert(ra.end(), rb.begin(), rb.end());
+        std::stable_sort(ra.begin(), ra.end());
+        assert(contents(a) == ra && b.empty());
+        a.reverse();
+        std::reverse(ra.begin(), ra.end());
+        assert(contents(a) == ra);
+
+        list moved(std::move(a));
+        assert(a.empty() && contents(moved) == ra);
+        a = moved;
+        assert(contents(a) == ra);
+    }
+    assert(tracked::live == 0);
+
+    std::cout << "All tests passed." << std::endl;
+}
@@ -0,0 +1,441 @@
+/*
+ File:   thread_pool.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A small work-stealing thread pool with a fork/join interface, meant to
+    run the library's parallel algorithms without spawning raw threads.
+
+ Implementation:
+  - Every worker owns a ws_deque (deque.h) of task pointers. Forked work is
+    pushed on the worker's own deque and idle workers steal from the top of
+    other workers' deques.
+  - Tasks live in the stack frame of the fork_join call that created them,
+    so forking never allocates. fork_join does not return until the forked
+    task has finished, which keeps those frames valid.
+  - A worker waiting on a stolen task keeps stealing and running other
+    tasks instead of blocking.
+  - Work from threads outside the pool enters through a mutex protected
+    injection queue. Workers park on a condition variable while no root
+    task is running.
+  - Tasks must not throw; an escaping exception terminates the program.
+
+ TODO:
+  - Parallel versions of the algorithms in algorithm.h.
+ */
+
+
+#ifndef thread_pool_h
+#define thread_pool_h
+
+#include <atomic>              // atomic
+#include <condition_variable>  // condition_variable
+#include <cstdint>             // uint64_t
+#include <deque>               // deque (injection queue)
+#include <memory>              // unique_ptr
+#include <mutex>               // mutex
+#include <thread>              // thread
+#include <vector>              // vector
+
+#include "deque.h"
+
+namespace ads {
+
+class thread_pool {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+
+
+/* Task definition */
+private:
+    class Task {
+
+    public:
+        std::atomic<bool> done;
+
+        Task() : done(false) {}
+        virtual ~Task() = default;
+        virtual void execute() = 0;
+
+        void run() noexcept { execute(); done.store(true, std::memory_order_release); }
+    };
+
+    template <class F>
+    class function_task : public Task {
+
+    public:
+        F& function;
+
+        explicit function_task(F& f) : function(f) {}
+        void execute() override { function(); }
+    };
+
+
+/* Worker definition */
+private:
+    struct Worker {
+        thread_pool* pool;
+        size_type index;
+        std::uint64_t seed;
+        ws_deque<Task*> tasks;
+        std::thread thread;
+
+        Worker(thread_pool* p, size_type i) : pool(p), index(i), seed(i * 0x9E3779B97F4A7C15ull + 1) {}
+    };
+
+
+/* Data members */
+private:
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::deque<Task*> _injected;            // Root tasks from outside the pool.
+    std::atomic<size_type> _active{0};      // Root tasks submitted but not finished.
+    std::atomic<bool> _stop{false};
+    std::mutex _lock;
+    std::condition_variable _wake;          // Signals parked workers.
+    std::condition_variable _finished;      // Signals threads waiting in run().
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    explicit thread_pool(size_type = std::thread::hardware_concurrency());
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    ~thread_pool();
+
+    /* Capacity */
+    size_type size() const;
+
+    /* Operations */
+    template <class F>
+        void run(F&&);
+    template <class F1, class F2>
+        void fork_join(F1&&, F2&&);
+    template <class F>
+        void parallel_for(size_type, size_type, size_type, F&&);
+    static bool in_worker();
+
+/* Helper functions */
+private:
+    static Worker*& current();
+    void work(Worker*);
+    bool take_injected(Task*&);
+    bool steal(Worker*, Task*&);
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - n: The number of worker threads. Zero is treated as one.
+
+ Description:
+    Starts n workers, all parked until work is submitted.
+
+ Complexity: Linear in n.
+ */
+inline
+thread_pool::thread_pool(size_type n)
+{
+    if (n == 0)
+        n = 1;
+
+    for (size_type i = 0; i < n; ++i)
+        _workers.emplace_back(new Worker(this, i));
+
+    for (auto& w : _workers)
+        w->thread = std::thread(&thread_pool::work, this, w.get());
+}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Stops and joins every worker. Any run() calls must have returned.
+ */
+inline
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stop.store(true);
+    }
+    _wake.notify_all();
+
+    for (auto& w : _workers)
+        w->thread.join();
+}
+
+
+
+// Capacity
+
+/*
+ Function: size
+ Return value: The number of worker threads.
+ */
+inline thread_pool::size_type
+thread_pool::size() const
+{
+    return _workers.size();
+}
+
+
+
+// Operations
+
+/*
+ Function: run
+ Parameters:
+  - f: A callable taking no arguments.
+ Return value: None
+
+ Description:
+    Runs f on the pool and blocks until it has finished. f may call
+    fork_join to spawn parallel work. Called from inside one of this pool's
+    workers, f simply runs inline.
+
+ Complexity: That of f.
+ */
+template <class F>
+void
+thread_pool::run(F&& f)
+{
+    auto self = current();
+    if (self && self->pool == this) {
+        f();
+        return;
+    }
+
+    function_task<F> root(f);
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _injected.push_back(&root);
+        _active.fetch_add(1);
+    }
+    _wake.notify_all();
+
+    std::unique_lock<std::mutex> guard(_lock);
+    _finished.wait(guard, [&]{ return root.done.load(std::memory_order_acquire); });
+}
+
+
+/*
+ Function: fork_join
+ Parameters:
+  - left: A callable run by the calling worker.
+  - right: A callable made available for other workers to steal.
+ Return value: None
+
+ Description:
+    Runs left and right, potentially in parallel, and returns once both have
+    finished. If right was not stolen by the time left finishes, the caller
+    runs it itself. Outside of the pool this is equivalent to
+    run([&]{ fork_join(left, right); }).
+
+ Complexity: That of left plus right, divided by the available parallelism.
+ */
+template <class F1, class F2>
+void
+thread_pool::fork_join(F1&& left, F2&& right)
+{
+    auto self = current();
+    if (!self || self->pool != this) {
+        run([&]{ fork_join(left, right); });
+        return;
+    }
+
+    function_task<F2> forked(right);
+    self->tasks.push(&forked);
+
+    left();
+
+    // Anything pushed after 'forked' was joined by a nested fork_join, so the
+    // owner end of the deque either still holds 'forked' or is empty.
+    Task* task;
+    if (self->tasks.pop(task)) {
+        task->run();
+        return;
+    }
+
+    while (!forked.done.load(std::memory_order_acquire)) {
+        if (steal(self, task))
+            task->run();
+        else
+            std::this_thread::yield();
+    }
+}
+
+
+/*
+ Function: parallel_for
+ Parameters:
+  - first, last: The range of indices to cover.
+  - grain: The largest chunk handed to f in one call.
+  - f: Called as f(lo, hi) on disjoint chunks that together cover
+       [first, last), potentially in parallel.
+ Return value: None
+
+ Description:
+    Splits the range in halves with fork_join until chunks are at most
+    grain long. Every chunk except the last starts and ends on a multiple
+    of grain from first, so chunks can own whole words of a bitmap or be
+    numbered by (lo - first) / grain.
+
+ Complexity: That of f over the range, divided by the available
+             parallelism, plus O((last - first) / grain) forks.
+ */
+template <class F>
+void
+thread_pool::parallel_for(size_type first, size_type last, size_type grain, F&& f)
+{
+    if (grain == 0)
+        grain = 1;
+    if (last <= first)
+        return;
+    if (last - first <= grain) {
+        f(first, last);
+        return;
+    }
+
+    auto chunks = (last - first + grain - 1) / grain;
+    auto middle = first + chunks / 2 * grain;
+    fork_join([&]{ parallel_for(first, middle, grain, f); },
+              [&]{ parallel_for(middle, last, grain, f); });
+}
+
+
+/*
+ Function: in_worker
+ Return value: Whether the calling thread is a worker of any thread_pool.
+ */
+inline bool
+thread_pool::in_worker()
+{
+    return current() != nullptr;
+}
+
+
+
+// Helper functions
+
+/*
+ Function: current
+ Return value: The worker running on this thread, or null.
+ */
+inline thread_pool::Worker*&
+thread_pool::current()
+{
+    static thread_local Worker* worker = nullptr;
+    return worker;
+}
+
+
+/*
+ Function: work
+ Parameters:
+  - self: The worker this thread runs as.
+
+ Description:
+    Worker main loop. Prefers its own deque, then the injection queue, then
+    stealing. Spins politely while a root task is active and parks once
+    the pool is idle.
+ */
+inline void
+thread_pool::work(Worker* self)
+{
+    current() = self;
+
+    while (!_stop.load(std::memory_order_relaxed)) {
+        Task* task;
+        if (self->tasks.pop(task) || steal(self, task)) {
+            task->run();
+            continue;
+        }
+
+        if (take_injected(task)) {
+            task->run();
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _active.fetch_sub(1);
+            }
+            _finished.notify_all();
+            continue;
+        }
+
+        if (_active.load() != 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(_lock);
+        _wake.wait(guard, [&]{ return _stop.load() || _active.load() != 0; });
+    }
+
+    current() = nullptr;
+}
+
+
+/*
+ Function: take_injected
+ Parameters:
+  - out: Receives a root task.
+ Return value: Whether a root task was taken.
+ */
+inline bool
+thread_pool::take_injected(Task*& out)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    if (_injected.empty())
+        return false;
+
+    out = _injected.front();
+    _injected.pop_front();
+
+    return true;
+}
+
+
+/*
+ Function: steal
+ Parameters:
+  - self: The stealing worker.
+  - out: Receives the stolen task.
+ Return value: Whether a task was stolen.
+
+ Description:
+    Tries every other worker once, starting from a random victim.
+
+ Complexity: Linear in the number of workers.
+ */
+inline bool
+thread_pool::steal(Worker* self, Task*& out)
+{
+    auto n = _workers.size();
+    if (n < 2)
+        return false;
+
+    self->seed ^= self->seed << 13;
+    self->seed ^= self->seed >> 7;
+    self->seed ^= self->seed << 17;
+
+    auto start = static_cast<size_type>(self->seed % n);
+    for (size_type i = 0; i < n; ++i) {
+        auto victim = _workers[(start + i) % n].get();
+        if (victim != self && victim->tasks.steal(out))
+            return true;
+    }
+
+    return false;
+}
+
+
+} // end namespace
+
+#endif /* thread_pool_h */
@@ -0,0 +1,1695 @@
+/*
+ File:   treap.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Treaps: binary search trees that are also heaps on a random priority
+    per node, which keeps them balanced in expectation with nothing to
+    rebalance. Their strength is that splitting a tree in two and joining
+    two trees are both O(log n), and everything else is built from those.
+    treap is an ordered set with rank queries and bulk union,
+    intersection and difference; implicit_treap is a sequence indexed by
+    position, with O(log n) insertion, removal and access anywhere and
+    O(log n) cut and concatenate.
+
+ Implementation:
+  - A node's priority is a hash of its address (the splitmix64 finalizer,
+    which is a bijection), so it costs no memory and no generator state
+    and no two live nodes share one. The tree is a max-heap on it.
+  - Every node counts the nodes in its subtree. That is the key of the
+    implicit treap and gives the ordered one index_of and get, and it
+    keeps split O(log n) with size() still constant.
+  - split and join are recursive; a treap's depth is logarithmic with
+    high probability. insert and erase are iterative and only split or
+    join the one subtree where the node belongs.
+  - unite, intersect and subtract are the split/join algorithms of
+    Blelloch, Ferizovic and Sun: the root with the higher priority splits
+    the other tree, and the two halves are combined independently. Given
+    a thread_pool the top levels of that recursion fork, so the work is
+    O(m log(n / m + 1)) and the span O(log n log m).
+  - Copies and bulk construction from a sequence are linear: nodes are
+    created in order and linked into a Cartesian tree with a stack of the
+    right spine.
+ */
+
+
+#ifndef treap_h
+#define treap_h
+
+#include <algorithm>         // max
+#include <cassert>           // assert
+#include <cstdint>           // uint64_t, uintptr_t
+#include <functional>        // less, function
+#include <initializer_list>  // initializer_list
+#include <memory>            // allocator
+#include <stdexcept>         // out_of_range
+#include <utility>           // move, forward, swap
+#include <vector>            // vector
+
+#include "search_tree.h"
+#include "thread_pool.h"
+
+namespace ads {
+
+// The node shared by both treaps, and the operations that only look at
+// positions and priorities.
+template <class T>
+struct treap_node {
+    treap_node* left = nullptr;
+    treap_node* right = nullptr;
+    std::size_t count = 1;
+    T data;
+
+    template <class... Args>
+    explicit treap_node(Args&&... args) : data(std::forward<Args>(args)...) {}
+
+    static std::size_t size(const treap_node* node) { return node ? node->count : 0; }
+    void update() { count = 1 + size(left) + size(right); }
+
+    std::uint64_t priority() const
+    {
+        auto x = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(this));
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // Concatenates two treaps; every node of a comes before every node of b.
+    static treap_node* join(treap_node* a, treap_node* b)
+    {
+        if (!a || !b)
+            return a ? a : b;
+
+        if (a->priority() > b->priority()) {
+            a->right = join(a->right, b);
+            a->update();
+            return a;
+        }
+        b->left = join(a, b->left);
+        b->update();
+        return b;
+    }
+
+    // Cuts a treap into its first n nodes and the rest.
+    static void split_at(treap_node* node, std::size_t n, treap_node*& first, treap_node*& rest)
+    {
+        if (!node) {
+            first = rest = nullptr;
+            return;
+        }
+
+        if (size(node->left) < n) {
+            split_at(node->right, n - size(node->left) - 1, node->right, rest);
+            first = node;
+        } else {
+            split_at(node->left, n, first, node->left);
+            rest = node;
+        }
+        node->update();
+    }
+
+    // The node at position i, which must be in range.
+    static treap_node* nth(treap_node* node, std::size_t i)
+    {
+        for (;;) {
+            auto left = size(node->left);
+            if (i == left)
+                return node;
+            if (i < left) {
+                node = node->left;
+            } else {
+                i -= left + 1;
+                node = node->right;
+            }
+        }
+    }
+
+    // Links nodes, already in order and unlinked, into a treap.
+    static treap_node* build(const std::vector<treap_node*>& nodes)
+    {
+        std::vector<treap_node*> spine;
+        for (auto node : nodes) {
+            treap_node* last = nullptr;
+            while (!spine.empty() && spine.back()->priority() < node->priority()) {
+                last = spine.back();
+                spine.pop_back();
+            }
+            node->left = last;
+            if (!spine.empty())
+                spine.back()->right = node;
+            spine.push_back(node);
+        }
+
+        if (spine.empty())
+            return nullptr;
+        recount(spine.front());
+        return spine.front();
+    }
+
+    static std::size_t recount(treap_node* node)
+    {
+        if (!node)
+            return 0;
+        node->count = 1 + recount(node->left) + recount(node->right);
+        return node->count;
+    }
+
+    static unsigned height(const treap_node* node)
+    {
+        if (!node)
+            return 0;
+        return 1 + std::max(height(node->left), height(node->right));
+    }
+
+    // Visits the nodes in order with an explicit stack.
+    template <class Visit>
+    static void in_order(treap_node* node, Visit visit)
+    {
+        std::vector<treap_node*> path;
+        while (node || !path.empty()) {
+            if (node) {
+                path.push_back(node);
+                node = node->left;
+            } else {
+                node = path.back();
+                path.pop_back();
+                visit(node);
+                node = node->right;
+            }
+        }
+    }
+
+    // Frees a subtree by rotating left children up, so it needs no stack.
+    template <class Destroy>
+    static void destroy(treap_node* node, Destroy destroy_node)
+    {
+        while (node) {
+            if (auto left = node->left) {
+                node->left = left->right;
+                left->right = node;
+                node = left;
+            } else {
+                auto right = node->right;
+                destroy_node(node);
+                node = right;
+            }
+        }
+    }
+};
+
+
+
+template <class T, class Compare = std::less<T>, class Alloc = std::allocator<T>>
+class treap final : public search_tree<T> {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+
+/* Node definition */
+private:
+    typedef treap_node<T> Node;
+    typedef typename Alloc::template rebind<Node>::other node_alloc;
+
+    static constexpr unsigned parallel_depth = 8;   // Levels of a set operation that fork.
+
+
+/* Data members */
+private:
+    Node* _root = nullptr;
+    Compare _compare;
+    node_alloc _alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    treap() = default;
+    treap(const treap<T, Compare, Alloc>&);
+    treap(treap<T, Compare, Alloc>&&);
+    treap(std::initializer_list<T>);
+    template <class InputIt>
+        treap(InputIt, InputIt);
+    ~treap();
+
+    /* Assignment */
+    treap<T, Compare, Alloc>& operator=(treap<T, Compare, Alloc>);
+
+    /* Capacity */
+    unsigned height() const;
+
+    /* Element access */
+    bool has(const_ref) const override;
+    size_type index_of(const_ref) const;
+    const_ref get(size_type) const;
+
+    /* Modifiers */
+    bool insert(const_ref);
+    bool insert(rvalue_ref);
+    template <class... Args>
+        bool emplace(Args&&...);
+    bool erase(const_ref);
+    void add(const_ref) override;
+    void remove(const_ref) override;
+    void swap(treap<T, Compare, Alloc>&);
+    void clear() noexcept override;
+
+    /* Operations */
+    treap<T, Compare, Alloc> split(const_ref);
+    void join(treap<T, Compare, Alloc>&);
+    void unite(treap<T, Compare, Alloc>&);
+    void unite(treap<T, Compare, Alloc>&, thread_pool&);
+    void intersect(treap<T, Compare, Alloc>&);
+    void intersect(treap<T, Compare, Alloc>&, thread_pool&);
+    void subtract(treap<T, Compare, Alloc>&);
+    void subtract(treap<T, Compare, Alloc>&, thread_pool&);
+    void merge(binary_tree<T>&) override;
+    void merge(binary_tree<T>&&) override;
+    void for_each(const std::function<void(const_ref)>&) const override;
+
+/* Helper functions */
+private:
+    template <class... Args>
+        Node* create_node(Args&&...);
+    void destroy_node(Node*);
+    void destroy_tree(Node*);
+
+    bool link(Node*);
+    void split_nodes(Node*, const_ref, Node*&, Node*&, Node*&) const;
+
+    typedef Node* (treap::*set_operation)(Node*, Node*, thread_pool*, unsigned);
+    void combine(treap<T, Compare, Alloc>&, thread_pool*, set_operation);
+    Node* unite_nodes(Node*, Node*, thread_pool*, unsigned);
+    Node* intersect_nodes(Node*, Node*, thread_pool*, unsigned);
+    Node* subtract_nodes(Node*, Node*, thread_pool*, unsigned);
+    template <class Left, class Right>
+        static void both(Left, Right, thread_pool*, unsigned);
+};
+
+
+
+// Node management
+
+/*
+ Function: create_node / destroy_node / destroy_tree
+ Parameters:
+  - args: Arguments forwarded to the element's constructor.
+  - node: The node, or the root of the subtree, to free.
+
+ Description:
+    create_node leaks nothing if the element's constructor throws.
+ */
+template <class T, class Compare, class Alloc>
+template <class... Args>
+typename treap<T, Compare, Alloc>::Node*
+treap<T, Compare, Alloc>::create_node(Args&&... args)
+{
+    auto node = _alloc.allocate(1);
+    try {
+        ::new (static_cast<void*>(node)) Node(std::forward<Args>(args)...);
+    } catch (...) {
+        _alloc.deallocate(node, 1);
+        throw;
+    }
+
+    return node;
+}
+
+template <class T, class Compare, class Alloc>
+inline void
+treap<T, Compare, Alloc>::destroy_node(Node* node)
+{
+    node->~Node();
+    _alloc.deallocate(node, 1);
+}
+
+template <class T, class Compare, class Alloc>
+inline void
+treap<T, Compare, Alloc>::destroy_tree(Node* node)
+{
+    Node::destroy(node, [this](Node* n){ destroy_node(n); });
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The treap being copied or moved from.
+  - il: Initializer list of elements, in any order.
+  - first, last: A range of elements, in any order.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty treap (defaulted in the class).
+  2. independent copy of rhs. The copies get new priorities, so the shape
+     is rebuilt rather than copied.
+  3. treap that takes over rhs's nodes, leaving rhs empty.
+  4. treap holding the distinct elements of il.
+  5. treap holding the distinct elements of [first, last).
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs.
+  3. Constant.
+  4. n log n expected in the size of il.
+  5. n log n expected in the length of the range.
+ */
+
+// 2. copy
+template <class T, class Compare, class Alloc>
+treap<T, Compare, Alloc>::treap(const treap<T, Compare, Alloc>& rhs)
+    : _compare(rhs._compare)
+{
+    std::vector<Node*> nodes;
+    nodes.reserve(rhs.size());
+    try {
+        Node::in_order(rhs._root, [&](Node* node){ nodes.push_back(create_node(node->data)); });
+    } catch (...) {
+        for (auto node : nodes)
+            destroy_node(node);
+        throw;
+    }
+
+    _root = Node::build(nodes);
+    this->_size = rhs._size;
+}
+
+// 3. move
+template <class T, class Compare, class Alloc>
+treap<T, Compare, Alloc>::treap(treap<T, Compare, Alloc>&& rhs)
+{
+    swap(rhs);
+}
+
+// 4. initializer list
+template <class T, class Compare, class Alloc>
+treap<T, Compare, Alloc>::treap(std::initializer_list<T> il)
+    : treap(il.begin(), il.end())
+{}
+
+// 5. range
+template <class T, class Compare, class Alloc>
+template <class InputIt>
+treap<T, Compare, Alloc>::treap(InputIt first, InputIt last)
+{
+    try {
+        for (; first != last; ++first)
+            insert(*first);
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Compare, class Alloc>
+treap<T, Compare, Alloc>::~treap()
+{
+    clear();
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this treap.
+ */
+template <class T, class Compare, class Alloc>
+treap<T, Compare, Alloc>&
+treap<T, Compare, Alloc>::operator=(treap<T, Compare, Alloc> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Capacity
+
+/*
+ Function: height
+ Return value: The number of levels in the treap.
+
+ Complexity: Linear.
+ */
+template <class T, class Compare, class Alloc>
+unsigned
+treap<T, Compare, Alloc>::height() const
+{
+    return Node::height(_root);
+}
+
+
+
+// Element access
+
+/*
+ Function: has
+ Parameters:
+  - element: The value to look for.
+ Return value: Whether element is present.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Compare, class Alloc>
+bool
+treap<T, Compare, Alloc>::has(const_ref element) const
+{
+    for (const Node* node = _root; node;) {
+        if (_compare(element, node->data))
+            node = node->left;
+        else if (_compare(node->data, element))
+            node = node->right;
+        else
+            return true;
+    }
+
+    return false;
+}
+
+
+/*
+ Function: index_of
+ Parameters:
+  - element: The value to rank.
+ Return value: The number of elements less than element, which is its
+               index if it is present.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Compare, class Alloc>
+typename treap<T, Compare, Alloc>::size_type
+treap<T, Compare, Alloc>::index_of(const_ref element) const
+{
+    size_type rank = 0;
+    for (const Node* node = _root; node;) {
+        if (_compare(node->data, element)) {
+            rank += Node::size(node->left) + 1;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+
+    return rank;
+}
+
+
+/*
+ Function: get
+ Parameters:
+  - i: An index less than size().
+ Return value: The element with i elements less than it.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Compare, class Alloc>
+typename treap<T, Compare, Alloc>::const_ref
+treap<T, Compare, Alloc>::get(size_type i) const
+{
+    assert(i < this->_size);
+    return Node::nth(_root, i)->data;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / emplace
+ Parameters:
+  - element: The value to add.
+  - args: Arguments to construct the value from.
+ Return value: Whether the element was added; it is not if an equal one
+               is already present.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Compare, class Alloc>
+bool
+treap<T, Compare, Alloc>::insert(const_ref element)
+{
+    return !has(element) && link(create_node(element));
+}
+
+template <class T, class Compare, class Alloc>
+bool
+treap<T, Compare, Alloc>::insert(rvalue_ref element)
+{
+    return !has(element) && link(create_node(std::move(element)));
+}
+
+template <class T, class Compare, class Alloc>
+template <class... Args>
+bool
+treap<T, Compare, Alloc>::emplace(Args&&... args)
+{
+    auto node = create_node(std::forward<Args>(args)...);
+    if (has(node->data)) {
+        destroy_node(node);
+        return false;
+    }
+
+    return link(node);
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - element: The value to remove.
+ Return value: Whether it was present.
+
+ Description:
+    The node is replaced by the join of its two subtrees.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Compare, class Alloc>
+bool
+treap<T, Compare, Alloc>::erase(const_ref element)
+{
+    if (!has(element))
+        return false;
+
+    Node** slot = &_root;
+    for (;;) {
+        auto node = *slot;
+        --node->count;
+        if (_compare(element, node->data)) {
+            slot = &node->left;
+        } else if (_compare(node->data, element)) {
+            slot = &node->right;
+        } else {
+            *slot = Node::join(node->left, node->right);
+            destroy_node(node);
+            break;
+        }
+    }
+
+    --this->_size;
+    return true;
+}
+
+
+/*
+ Function: add / remove
+ Parameters:
+  - element: The value to add or remove.
+
+ Description:
+    The binary_tree interface: insert and erase without the result.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::add(const_ref element)
+{
+    insert(element);
+}
+
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::remove(const_ref element)
+{
+    erase(element);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - other: The treap to exchange contents with.
+
+ Complexity: Constant.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::swap(treap<T, Compare, Alloc>& other)
+{
+    using std::swap;
+    swap(_root, other._root);
+    swap(this->_size, other._size);
+    swap(_compare, other._compare);
+    swap(_alloc, other._alloc);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every element.
+
+ Complexity: Linear.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::clear() noexcept
+{
+    destroy_tree(_root);
+    _root = nullptr;
+    this->_size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: split
+ Parameters:
+  - element: Where to cut.
+ Return value: A treap of every element not less than element, which are
+               removed from this one.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Compare, class Alloc>
+treap<T, Compare, Alloc>
+treap<T, Compare, Alloc>::split(const_ref element)
+{
+    treap<T, Compare, Alloc> rest;
+    rest._compare = _compare;
+
+    Node *less, *equal, *greater;
+    split_nodes(_root, element, less, equal, greater);
+    _root = less;
+    rest._root = Node::join(equal, greater);
+    this->_size = Node::size(_root);
+    rest._size = Node::size(rest._root);
+    return rest;
+}
+
+
+/*
+ Function: join
+ Parameters:
+  - other: A treap whose elements all sort after this one's. Left empty.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::join(treap<T, Compare, Alloc>& other)
+{
+    if (&other == this)
+        return;
+    assert(!_root || !other._root
+           || _compare(Node::nth(_root, this->_size - 1)->data, Node::nth(other._root, 0)->data));
+
+    _root = Node::join(_root, other._root);
+    this->_size += other._size;
+    other._root = nullptr;
+    other._size = 0;
+}
+
+
+/*
+ Function: unite / intersect / subtract
+ Parameters:
+  - other: The treap to combine with. Left empty; its nodes are reused or
+           freed.
+  - pool: Runs the top levels of the recursion in parallel.
+
+ Description:
+    Makes this treap the union, intersection or difference (this minus
+    other) of the two. Where both hold an equal element this treap's copy
+    is the one kept.
+
+ Complexity: O(m log(n / m + 1)) expected, for sizes m <= n.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::unite(treap<T, Compare, Alloc>& other)
+{
+    combine(other, nullptr, &treap::unite_nodes);
+}
+
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::unite(treap<T, Compare, Alloc>& other, thread_pool& pool)
+{
+    combine(other, &pool, &treap::unite_nodes);
+}
+
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::intersect(treap<T, Compare, Alloc>& other)
+{
+    combine(other, nullptr, &treap::intersect_nodes);
+}
+
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::intersect(treap<T, Compare, Alloc>& other, thread_pool& pool)
+{
+    combine(other, &pool, &treap::intersect_nodes);
+}
+
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::subtract(treap<T, Compare, Alloc>& other)
+{
+    combine(other, nullptr, &treap::subtract_nodes);
+}
+
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::subtract(treap<T, Compare, Alloc>& other, thread_pool& pool)
+{
+    combine(other, &pool, &treap::subtract_nodes);
+}
+
+
+/*
+ Function: merge
+ Parameters:
+  - other: The tree to move every element out of.
+ Return value: None
+
+ Description:
+    Moves the elements of other into this treap, leaving other empty. A
+    treap of the same type is united with this one; any other binary_tree
+    has its elements copied in.
+
+ Complexity: O(m log(n / m + 1)) expected for treaps; m log(n + m)
+             expected otherwise.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::merge(binary_tree<T>& other)
+{
+    if (&other == this)
+        return;
+
+    if (auto same = dynamic_cast<treap<T, Compare, Alloc>*>(&other)) {
+        unite(*same);
+        return;
+    }
+
+    other.for_each([this](const_ref element){ insert(element); });
+    other.clear();
+}
+
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::merge(binary_tree<T>&& other)
+{
+    merge(other);
+}
+
+
+/*
+ Function: for_each
+ Parameters:
+  - visit: Called with each element in ascending order.
+
+ Complexity: Linear.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::for_each(const std::function<void(const_ref)>& visit) const
+{
+    Node::in_order(_root, [&](const Node* node){ visit(node->data); });
+}
+
+
+
+// Helper functions
+
+/*
+ Function: link
+ Parameters:
+  - node: A new node whose element is not present.
+ Return value: true
+
+ Description:
+    Walks down while the nodes passed outrank the new one, then splits
+    the subtree found around the new node and hangs the halves off it.
+ */
+template <class T, class Compare, class Alloc>
+bool
+treap<T, Compare, Alloc>::link(Node* node)
+{
+    auto priority = node->priority();
+    Node** slot = &_root;
+    while (*slot && (*slot)->priority() > priority) {
+        ++(*slot)->count;
+        slot = _compare(node->data, (*slot)->data) ? &(*slot)->left : &(*slot)->right;
+    }
+
+    Node* equal;
+    split_nodes(*slot, node->data, node->left, equal, node->right);
+    node->update();
+    *slot = node;
+    ++this->_size;
+    return true;
+}
+
+
+/*
+ Function: split_nodes
+ Parameters:
+  - node: The root of a subtree.
+  - element: Where to cut.
+  - less: Set to the nodes less than element.
+  - equal: Set to the node equal to element, unlinked, or null.
+  - greater: Set to the nodes greater than element.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::split_nodes(Node* node, const_ref element, Node*& less, Node*& equal, Node*& greater) const
+{
+    if (!node) {
+        less = equal = greater = nullptr;
+        return;
+    }
+
+    if (_compare(node->data, element)) {
+        split_nodes(node->right, element, node->right, equal, greater);
+        less = node;
+    } else if (_compare(element, node->data)) {
+        split_nodes(node->left, element, less, equal, node->left);
+        greater = node;
+    } else {
+        less = node->left;
+        greater = node->right;
+        equal = node;
+        node->left = node->right = nullptr;
+    }
+    node->update();
+}
+
+
+/*
+ Function: combine
+ Parameters:
+  - other: The treap to combine with this one.
+  - pool: The pool to fork on, or null.
+  - operation: unite_nodes, intersect_nodes or subtract_nodes.
+
+ Description:
+    Takes both roots, runs the operation (inside the pool if there is
+    one) and makes the result this treap's.
+ */
+template <class T, class Compare, class Alloc>
+void
+treap<T, Compare, Alloc>::combine(treap<T, Compare, Alloc>& other, thread_pool* pool, set_operation operation)
+{
+    if (&other == this) {
+        if (operation == &treap::subtract_nodes)
+            clear();
+        return;
+    }
+
+    auto a = _root, b = other._root;
+    other._root = nullptr;
+    other._size = 0;
+
+    if (pool)
+        pool->run([&]{ _root = (this->*operation)(a, b, pool, 0); });
+    else
+        _root = (this->*operation)(a, b, nullptr, 0);
+    this->_size = Node::size(_root);
+}
+
+
+/*
+ Function: unite_nodes / intersect_nodes / subtract_nodes
+ Parameters:
+  - a: A subtree of this treap.
+  - b: A subtree of the other treap.
+  - pool: The pool to fork on, or null.
+  - depth: The recursion depth, to stop forking.
+ Return value: The root of the combined subtree.
+
+ Description:
+    The root of higher priority is kept (for subtract, always a's), the
+    other subtree is split around it, and the two sides are combined
+    recursively. Nodes that do not belong in the result are freed. When
+    the kept root came from b and a held an equal element, the elements
+    are swapped so a's survives without moving a node out of heap order.
+ */
+template <class T, class Compare, class Alloc>
+typename treap<T, Compare, Alloc>::Node*
+treap<T, Compare, Alloc>::unite_nodes(Node* a, Node* b, thread_pool* pool, unsigned depth)
+{
+    if (!a || !b)
+        return a ? a : b;
+
+    Node *root, *equal, *mine_left, *mine_right, *other_left, *other_right;
+    if (a->priority() > b->priority()) {
+        root = a;
+        mine_left = a->left;
+        mine_right = a->right;
+        split_nodes(b, a->data, other_left, equal, other_right);
+    } else {
+        root = b;
+        other_left = b->left;
+        other_right = b->right;
+        split_nodes(a, b->data, mine_left, equal, mine_right);
+        if (equal) {
+            using std::swap;
+            swap(root->data, equal->data);
+        }
+    }
+    if (equal)
+        destroy_node(equal);
+
+    both([&]{ root->left = unite_nodes(mine_left, other_left, pool, depth + 1); },
+         [&]{ root->right = unite_nodes(mine_right, other_right, pool, depth + 1); },
+         pool, depth);
+    root->update();
+    return root;
+}
+
+template <class T, class Compare, class Alloc>
+typename treap<T, Compare, Alloc>::Node*
+treap<T, Compare, Alloc>::intersect_nodes(Node* a, Node* b, thread_pool* pool, unsigned depth)
+{
+    if (!a || !b) {
+        destroy_tree(a);
+        destroy_tree(b);
+        return nullptr;
+    }
+
+    Node *root, *equal, *mine_left, *mine_right, *other_left, *other_right;
+    if (a->priority() > b->priority()) {
+        root = a;
+        mine_left = a->left;
+        mine_right = a->right;
+        split_nodes(b, a->data, other_left, equal, other_right);
+    } else {
+        root = b;
+        other_left = b->left;
+        other_right = b->right;
+        split_nodes(a, b->data, mine_left, equal, mine_right);
+        if (equal) {
+            using std::swap;
+            swap(root->data, equal->data);
+        }
+    }
+
+    Node *left = nullptr, *right = nullptr;
+    both([&]{ left = intersect_nodes(mine_left, other_left, pool, depth + 1); },
+         [&]{ right = intersect_nodes(mine_right, other_right, pool, depth + 1); },
+         pool, depth);
+
+    if (!equal) {
+        destroy_node(root);
+        return Node::join(left, right);
+    }
+
+    destroy_node(equal);
+    root->left = left;
+    root->right = right;
+    root->update();
+    return root;
+}
+
+template <class T, class Compare, class Alloc>
+typename treap<T, Compare, Alloc>::Node*
+treap<T, Compare, Alloc>::subtract_nodes(Node* a, Node* b, thread_pool* pool, unsigned depth)
+{
+    if (!a || !b) {
+        destroy_tree(b);
+        return a;
+    }
+
+    Node *less, *equal, *greater;
+    split_nodes(b, a->data, less, equal, greater);
+
+    Node *left = nullptr, *right = nullptr;
+    both([&]{ left = subtract_nodes(a->left, less, pool, depth + 1); },
+         [&]{ right = subtract_nodes(a->right, greater, pool, depth + 1); },
+         pool, depth);
+
+    if (equal) {
+        destroy_node(equal);
+        destroy_node(a);
+        return Node::join(left, right);
+    }
+
+    a->left = left;
+    a->right = right;
+    a->update();
+    return a;
+}
+
+
+/*
+ Function: both
+ Parameters:
+  - left, right: The two halves of a step.
+  - pool: The pool to fork on, or null.
+  - depth: How deep the step is.
+
+ Description:
+    Forks near the top of the recursion, where the halves are large, and
+    runs them in turn below that.
+ */
+template <class T, class Compare, class Alloc>
+template <class Left, class Right>
+void
+treap<T, Compare, Alloc>::both(Left left, Right right, thread_pool* pool, unsigned depth)
+{
+    if (pool && depth < parallel_depth) {
+        pool->fork_join(left, right);
+    } else {
+        left();
+        right();
+    }
+}
+
+
+
+template <class T, class Alloc = std::allocator<T>>
+class implicit_treap final : public tree<T> {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+
+/* Node definition */
+private:
+    typedef treap_node<T> Node;
+    typedef typename Alloc::template rebind<Node>::other node_alloc;
+
+
+/* Data members */
+private:
+    Node* _root = nullptr;
+    node_alloc _alloc;
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    implicit_treap() = default;
+    implicit_treap(const implicit_treap<T, Alloc>&);
+    implicit_treap(implicit_treap<T, Alloc>&&);
+    implicit_treap(std::initializer_list<T>);
+    template <class InputIt>
+        implicit_treap(InputIt, InputIt);
+    ~implicit_treap();
+
+    /* Assignment */
+    implicit_treap<T, Alloc>& operator=(implicit_treap<T, Alloc>);
+
+    /* Capacity */
+    unsigned height() const;
+
+    /* Element access */
+    reference at(size_type);
+    const_ref at(size_type) const;
+    reference operator[](size_type);
+    const_ref operator[](size_type) const;
+    reference front();
+    const_ref front() const;
+    reference back();
+    const_ref back() const;
+
+    /* Modifiers */
+    void insert(size_type, const_ref);
+    void insert(size_type, rvalue_ref);
+    template <class... Args>
+        void emplace(size_type, Args&&...);
+    void erase(size_type);
+    void push_front(const_ref);
+    void push_back(const_ref);
+    void push_back(rvalue_ref);
+    void pop_front();
+    void pop_back();
+    void swap(implicit_treap<T, Alloc>&);
+    void clear() noexcept override;
+
+    /* Operations */
+    implicit_treap<T, Alloc> split(size_type);
+    void append(implicit_treap<T, Alloc>&);
+    void for_each(const std::function<void(const_ref)>&) const override;
+
+/* Helper functions */
+private:
+    template <class... Args>
+        Node* create_node(Args&&...);
+    void destroy_node(Node*);
+    void link(size_type, Node*);
+    template <class InputIt>
+        void assign(InputIt, InputIt);
+};
+
+
+
+// Node management
+
+/*
+ Function: create_node / destroy_node
+ Parameters:
+  - args: Arguments forwarded to the element's constructor.
+  - node: The node to free.
+
+ Description:
+    create_node leaks nothing if the element's constructor throws.
+ */
+template <class T, class Alloc>
+template <class... Args>
+typename implicit_treap<T, Alloc>::Node*
+implicit_treap<T, Alloc>::create_node(Args&&... args)
+{
+    auto node = _alloc.allocate(1);
+    try {
+        ::new (static_cast<void*>(node)) Node(std::forward<Args>(args)...);
+    } catch (...) {
+        _alloc.deallocate(node, 1);
+        throw;
+    }
+
+    return node;
+}
+
+template <class T, class Alloc>
+inline void
+implicit_treap<T, Alloc>::destroy_node(Node* node)
+{
+    node->~Node();
+    _alloc.deallocate(node, 1);
+}
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The sequence being copied or moved from.
+  - il: Initializer list of elements.
+  - first, last: A range of elements.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty sequence (defaulted in the class).
+  2. independent copy of rhs.
+  3. sequence that takes over rhs's nodes, leaving rhs empty.
+  4. sequence of the elements of il, in order.
+  5. sequence of the elements of [first, last), in order.
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs.
+  3. Constant.
+  4. Linear in the size of il.
+  5. Linear in the length of the range.
+ */
+
+// 2. copy
+template <class T, class Alloc>
+implicit_treap<T, Alloc>::implicit_treap(const implicit_treap<T, Alloc>& rhs)
+{
+    std::vector<const T*> elements;
+    elements.reserve(rhs.size());
+    Node::in_order(rhs._root, [&](const Node* node){ elements.push_back(&node->data); });
+
+    std::vector<Node*> nodes;
+    nodes.reserve(elements.size());
+    try {
+        for (auto element : elements)
+            nodes.push_back(create_node(*element));
+    } catch (...) {
+        for (auto node : nodes)
+            destroy_node(node);
+        throw;
+    }
+
+    _root = Node::build(nodes);
+    this->_size = rhs._size;
+}
+
+// 3. move
+template <class T, class Alloc>
+implicit_treap<T, Alloc>::implicit_treap(implicit_treap<T, Alloc>&& rhs)
+{
+    swap(rhs);
+}
+
+// 4. initializer list
+template <class T, class Alloc>
+implicit_treap<T, Alloc>::implicit_treap(std::initializer_list<T> il)
+{
+    assign(il.begin(), il.end());
+}
+
+// 5. range
+template <class T, class Alloc>
+template <class InputIt>
+implicit_treap<T, Alloc>::implicit_treap(InputIt first, InputIt last)
+{
+    assign(first, last);
+}
+
+
+/*
+ Function: destructor
+ */
+template <class T, class Alloc>
+implicit_treap<T, Alloc>::~implicit_treap()
+{
+    clear();
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: A copy (or moved instance) to take the contents of.
+ Return value: A reference to this sequence.
+ */
+template <class T, class Alloc>
+implicit_treap<T, Alloc>&
+implicit_treap<T, Alloc>::operator=(implicit_treap<T, Alloc> rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+
+
+// Capacity
+
+/*
+ Function: height
+ Return value: The number of levels in the treap.
+
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+unsigned
+implicit_treap<T, Alloc>::height() const
+{
+    return Node::height(_root);
+}
+
+
+
+// Element access
+
+/*
+ Function: at / operator[]
+ Parameters:
+  - i: A position.
+ Return value: The element at position i.
+
+ Description:
+    at throws std::out_of_range for a position past the end; operator[]
+    does not check.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::reference
+implicit_treap<T, Alloc>::at(size_type i)
+{
+    if (i >= this->_size)
+        throw std::out_of_range("implicit_treap::at");
+    return Node::nth(_root, i)->data;
+}
+
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::const_ref
+implicit_treap<T, Alloc>::at(size_type i) const
+{
+    if (i >= this->_size)
+        throw std::out_of_range("implicit_treap::at");
+    return Node::nth(_root, i)->data;
+}
+
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::reference
+implicit_treap<T, Alloc>::operator[](size_type i)
+{
+    assert(i < this->_size);
+    return Node::nth(_root, i)->data;
+}
+
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::const_ref
+implicit_treap<T, Alloc>::operator[](size_type i) const
+{
+    assert(i < this->_size);
+    return Node::nth(_root, i)->data;
+}
+
+
+/*
+ Function: front / back
+ Return value: The first or last element. The sequence must not be empty.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::reference
+implicit_treap<T, Alloc>::front()
+{
+    return (*this)[0];
+}
+
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::const_ref
+implicit_treap<T, Alloc>::front() const
+{
+    return (*this)[0];
+}
+
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::reference
+implicit_treap<T, Alloc>::back()
+{
+    return (*this)[this->_size - 1];
+}
+
+template <class T, class Alloc>
+typename implicit_treap<T, Alloc>::const_ref
+implicit_treap<T, Alloc>::back() const
+{
+    return (*this)[this->_size - 1];
+}
+
+
+
+// Modifiers
+
+/*
+ Function: insert / emplace
+ Parameters:
+  - i: The position the new element will have, at most size().
+  - element: The value to insert.
+  - args: Arguments to construct the value from.
+
+ Description:
+    Elements from position i on move one place later.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::insert(size_type i, const_ref element)
+{
+    assert(i <= this->_size);
+    link(i, create_node(element));
+}
+
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::insert(size_type i, rvalue_ref element)
+{
+    assert(i <= this->_size);
+    link(i, create_node(std::move(element)));
+}
+
+template <class T, class Alloc>
+template <class... Args>
+void
+implicit_treap<T, Alloc>::emplace(size_type i, Args&&... args)
+{
+    assert(i <= this->_size);
+    link(i, create_node(std::forward<Args>(args)...));
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - i: The position to remove, less than size().
+
+ Description:
+    The node is replaced by the join of its two subtrees.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::erase(size_type i)
+{
+    assert(i < this->_size);
+
+    Node** slot = &_root;
+    for (;;) {
+        auto node = *slot;
+        auto left = Node::size(node->left);
+        --node->count;
+        if (i < left) {
+            slot = &node->left;
+        } else if (i > left) {
+            i -= left + 1;
+            slot = &node->right;
+        } else {
+            *slot = Node::join(node->left, node->right);
+            destroy_node(node);
+            break;
+        }
+    }
+
+    --this->_size;
+}
+
+
+/*
+ Function: push_front / push_back / pop_front / pop_back
+ Parameters:
+  - element: The value to add.
+
+ Description:
+    Insertion and removal at either end.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::push_front(const_ref element)
+{
+    insert(0, element);
+}
+
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::push_back(const_ref element)
+{
+    insert(this->_size, element);
+}
+
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::push_back(rvalue_ref element)
+{
+    insert(this->_size, std::move(element));
+}
+
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::pop_front()
+{
+    erase(0);
+}
+
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::pop_back()
+{
+    erase(this->_size - 1);
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - other: The sequence to exchange contents with.
+
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::swap(implicit_treap<T, Alloc>& other)
+{
+    using std::swap;
+    swap(_root, other._root);
+    swap(this->_size, other._size);
+    swap(_alloc, other._alloc);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes every element.
+
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::clear() noexcept
+{
+    Node::destroy(_root, [this](Node* node){ destroy_node(node); });
+    _root = nullptr;
+    this->_size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: split
+ Parameters:
+  - i: Where to cut, at most size().
+ Return value: The elements from position i on, which are removed from
+               this sequence.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Alloc>
+implicit_treap<T, Alloc>
+implicit_treap<T, Alloc>::split(size_type i)
+{
+    assert(i <= this->_size);
+
+    implicit_treap<T, Alloc> rest;
+    Node::split_at(_root, i, _root, rest._root);
+    rest._size = this->_size - i;
+    this->_size = i;
+    return rest;
+}
+
+
+/*
+ Function: append
+ Parameters:
+  - other: The sequence to move onto the end of this one. Left empty.
+
+ Complexity: Logarithmic expected.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::append(implicit_treap<T, Alloc>& other)
+{
+    if (&other == this)
+        return;
+
+    _root = Node::join(_root, other._root);
+    this->_size += other._size;
+    other._root = nullptr;
+    other._size = 0;
+}
+
+
+/*
+ Function: for_each
+ Parameters:
+  - visit: Called with each element in order.
+
+ Complexity: Linear.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::for_each(const std::function<void(const_ref)>& visit) const
+{
+    Node::in_order(_root, [&](const Node* node){ visit(node->data); });
+}
+
+
+
+// Helper functions
+
+/*
+ Function: link
+ Parameters:
+  - i: The position for the new node.
+  - node: A new node.
+
+ Description:
+    Walks down while the nodes passed outrank the new one, then cuts the
+    subtree found at the insertion point and hangs the halves off it.
+ */
+template <class T, class Alloc>
+void
+implicit_treap<T, Alloc>::link(size_type i, Node* node)
+{
+    auto priority = node->priority();
+    Node** slot = &_root;
+    while (*slot && (*slot)->priority() > priority) {
+        auto parent = *slot;
+        auto left = Node::size(parent->left);
+        ++parent->count;
+        if (i <= left) {
+            slot = &parent->left;
+        } else {
+            i -= left + 1;
+            slot = &parent->right;
+        }
+    }
+
+    Node::split_at(*slot, i, node->left, node->right);
+    node->update();
+    *slot = node;
+    ++this->_size;
+}
+
+
+/*
+ Function: assign
+ Parameters:
+  - first, last: The elements, in order, of an empty sequence.
+
+ Description:
+    Creates every node, then links them as a Cartesian tree in one pass.
+ */
+template <class T, class Alloc>
+template <class InputIt>
+void
+implicit_treap<T, Alloc>::assign(InputIt first, InputIt last)
+{
+    std::vector<Node*> nodes;
+    try {
+        for (; first != last; ++first)
+            nodes.push_back(create_node(*first));
+    } catch (...) {
+        for (auto node : nodes)
+            destroy_node(node);
+        throw;
+    }
+
+    _root = Node::build(nodes);
+    this->_size = nodes.size();
+}
+
+
+} // end namespace
+
+#endif /* treap_h */
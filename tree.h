@@ -1,16 +1,30 @@
 /*
- preamble.
+ File:   tree.h
+ Author: Kyle Thompson
+
+ Purpose:
+    The root of the tree hierarchy. Every tree knows its size, can be
+    emptied, and can visit its elements in order.
+
+ Implementation:
+  - Node layout is left to the concrete trees. The balanced trees pack
+    their bookkeeping into spare pointer bits and the self-adjusting ones
+    have no parent pointers at all, so no single node type fits them.
+  - for_each is what lets trees of different kinds merge into one another.
  */
 
 
 #ifndef Tree_h
 #define Tree_h
 
-#include <memory>
+#include <cstddef>     // size_t
+#include <functional>  // function
+
+namespace ads {
 
 template <class T>
 class tree {
-    
+
 /* Type definitions */
 public:
     typedef std::size_t size_type;
@@ -20,30 +34,27 @@ public:
     typedef T&          reference;
     typedef T&&         rvalue_ref;
     typedef const T&    const_ref;
-    
 
-/* Node definition */
-protected:
-    class Node {
-        
-    public:
-        Node* parent;
-        T data;
-    };
-    
 
 /* Data members */
 protected:
-    Node* _root = nullptr;
     size_type _size = 0;
-    std::allocator<T> alloc;
-    
-    
+
+
 /* Member functions */
 public:
-    size_type size();
-    bool empty();
-    
+    /* Constructors */
+    virtual ~tree() = default;
+
+    /* Capacity */
+    size_type size() const;
+    bool empty() const;
+
+    /* Modifiers */
+    virtual void clear() noexcept = 0;
+
+    /* Operations */
+    virtual void for_each(const std::function<void(const_ref)>&) const = 0;
 };
 
 
@@ -51,24 +62,33 @@ public:
 // Capacity
 
 /*
- 
+ Function: size
+ Return value: The number of elements in the tree.
+
+ Complexity: Constant.
  */
 template <class T>
 inline typename tree<T>::size_type
-tree<T>::size()
+tree<T>::size() const
 {
     return _size;
 }
 
 
 /*
- 
+ Function: empty
+ Return value: Whether the tree has no elements.
+
+ Complexity: Constant.
  */
 template <class T>
 inline bool
-tree<T>::empty()
+tree<T>::empty() const
 {
     return _size == 0;
 }
 
+
+} // end namespace
+
 #endif /* Tree_h */
@@ -0,0 +1,1532 @@
+/*
+ File:   unrolled_list.h
+ Author: Kyle Thompson
+
+ Purpose:
+    A linked list of small arrays. It has the interface of list, but each
+    node holds up to chunk_capacity elements in a block of about two cache
+    lines, so a list<int> spends 24 bytes of links and count on 26
+    elements instead of 16 bytes of links on each one, and iteration walks
+    contiguous memory with one pointer chase per chunk.
+
+ Implementation:
+  - Chunks are doubly linked around a dummy node, as in list. No chunk is
+    ever empty, so an iterator is a chunk and an index into it, and end()
+    is the dummy at index 0.
+  - Inserting into a full chunk splits it in half, except at either end of
+    the chunk, where a new chunk is started (or the neighbour with room is
+    used) so runs of push_back and push_front fill chunks completely.
+  - When erasing leaves two neighbouring chunks with at most three
+    quarters of a chunk between them, they are merged. Merging stops
+    there so that an insertion right after an erase does not split again.
+  - Splicing relinks whole chunks in constant time each. Only the chunks at
+    the ends of the range are split, and afterwards merged with their new
+    neighbours when they fit.
+  - Unlike list, inserting or erasing moves the elements after it within
+    the same chunk, so it invalidates iterators into that chunk (and into
+    a neighbour it is merged with). Iterators into other chunks stay
+    valid.
+ */
+
+
+#ifndef unrolled_list_h
+#define unrolled_list_h
+
+#include <algorithm>         // max, move, move_backward, reverse, stable_sort
+#include <cassert>           // assert
+#include <initializer_list>  // initializer_list
+#include <iterator>          // iterator
+#include <memory>            // allocator, addressof
+#include <new>               // placement new
+#include <type_traits>       // aligned_storage, is_trivially_destructible
+#include <utility>           // move, forward, swap
+#include <vector>            // vector
+
+namespace ads {
+
+template <class T, class Alloc = std::allocator<T>>
+class unrolled_list {
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+
+    // Elements per chunk: as many as fit in 128 bytes with the links and
+    // count, and at least four.
+    static constexpr size_type chunk_bytes = 128;
+    static constexpr size_type chunk_capacity =
+        std::max<size_type>(4, (chunk_bytes - 2 * sizeof(void*) - sizeof(size_type)) / sizeof(T));
+
+
+/* Node definition */
+private:
+    struct Node {
+        Node* prev;
+        Node* next;
+
+        Node() : prev(this), next(this) {}
+    };
+
+    struct Chunk : Node {
+        size_type count = 0;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type slots[chunk_capacity];
+
+        T* data() { return reinterpret_cast<T*>(slots); }
+    };
+
+
+/* Iterators */
+private:
+    // The position shared by both iterators: a chunk and an index in it.
+    class chunk_position {
+
+        friend class unrolled_list<T, Alloc>;
+
+    /* Iterator data members */
+    protected:
+        Node* node;
+        size_type index;
+
+        T* get() const { return static_cast<Chunk*>(node)->data() + index; }
+
+        void increment()
+        {
+            if (++index == static_cast<Chunk*>(node)->count) {
+                node = node->next;
+                index = 0;
+            }
+        }
+
+        void decrement()
+        {
+            if (index-- == 0) {
+                node = node->prev;
+                index = static_cast<Chunk*>(node)->count - 1;
+            }
+        }
+
+    public:
+        chunk_position(Node* n, size_type i) : node(n), index(i) {}
+        bool operator==(const chunk_position& rhs) const { return node == rhs.node && index == rhs.index; }
+        bool operator!=(const chunk_position& rhs) const { return !(*this == rhs); }
+    };
+
+    template <class Value>
+    class chunk_iterator : public chunk_position, public std::iterator< std::bidirectional_iterator_tag, Value > {
+    public:
+        chunk_iterator(Node* n, size_type i) : chunk_position(n, i) {}
+    };
+
+public:
+    class iterator : public chunk_iterator<value_type> {
+
+        friend class unrolled_list<T, Alloc>;
+
+    private:
+        using chunk_position::get;
+        using chunk_position::increment;
+        using chunk_position::decrement;
+
+    /* Iterator member functions */
+    public:
+        iterator(Node* n, size_type i) : chunk_iterator<value_type>(n, i) {}
+        reference operator*() const { return *get(); }
+        pointer operator->() const { return get(); }
+        iterator& operator++() { increment(); return *this; }
+        iterator operator++(int) { iterator temp(*this); increment(); return temp; }
+        iterator& operator--() { decrement(); return *this; }
+        iterator operator--(int) { iterator temp(*this); decrement(); return temp; }
+        iterator next() const { iterator temp(*this); return ++temp; }
+        iterator prev() const { iterator temp(*this); return --temp; }
+    };
+
+
+    class const_iterator : public chunk_iterator<const value_type> {
+
+        friend class unrolled_list<T, Alloc>;
+
+    private:
+        using chunk_position::get;
+        using chunk_position::increment;
+        using chunk_position::decrement;
+
+    /* Iterator member functions */
+    public:
+        const_iterator(Node* n, size_type i) : chunk_iterator<const value_type>(n, i) {}
+        const_iterator(const iterator& it) : chunk_iterator<const value_type>(it.node, it.index) {}
+        const_ref operator*() const { return *get(); }
+        const_ptr operator->() const { return get(); }
+        const_iterator& operator++() { increment(); return *this; }
+        const_iterator operator++(int) { const_iterator temp(*this); increment(); return temp; }
+        const_iterator& operator--() { decrement(); return *this; }
+        const_iterator operator--(int) { const_iterator temp(*this); decrement(); return temp; }
+        const_iterator next() const { const_iterator temp(*this); return ++temp; }
+        const_iterator prev() const { const_iterator temp(*this); return --temp; }
+    };
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+
+/* Data members */
+private:
+    Node* _dummy;          // Dummy node between the last chunk and the first.
+    size_type _size = 0;   // Number of elements, not chunks.
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    unrolled_list();
+    unrolled_list(size_type, const_ref);
+    unrolled_list(iterator, iterator);
+    unrolled_list(const unrolled_list<T, Alloc>&);
+    unrolled_list(unrolled_list<T, Alloc>&&);
+    unrolled_list(std::initializer_list<T>);
+    ~unrolled_list();
+
+    /* Assignment */
+    unrolled_list<T, Alloc>& operator=(const unrolled_list<T, Alloc>&);
+    unrolled_list<T, Alloc>& operator=(unrolled_list<T, Alloc>&&);
+    unrolled_list<T, Alloc>& operator=(std::initializer_list<T>);
+
+    /* Iterators */
+    iterator begin() const;
+    iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    size_type chunks() const;
+
+    /* Element access */
+    reference front() const;
+    reference last() const;
+    reference at(size_type) const;
+    reference operator[](size_type) const;
+
+    /* Modifiers */
+    void assign(iterator, iterator);
+    void assign(size_type, const_ref);
+    void assign(std::initializer_list<value_type>);
+    void push_front(const_ref);
+    void push_front(rvalue_ref);
+    void push_back(const_ref);
+    void push_back(rvalue_ref);
+    template <class... Args>
+        void emplace_front(Args&&...);
+    template <class... Args>
+        void emplace_back(Args&&...);
+    template <class... Args>
+        iterator emplace(const_iterator, Args&&...);
+    void pop_front();
+    void pop_back();
+    iterator insert(const_iterator, const_ref);
+    iterator insert(const_iterator, size_type, const_ref);
+    iterator insert(const_iterator, iterator, iterator);
+    iterator insert(const_iterator, rvalue_ref);
+    iterator insert(const_iterator, std::initializer_list<value_type>);
+    iterator erase(const_iterator);
+    iterator erase(const_iterator, const_iterator);
+    void swap(unrolled_list<T, Alloc>&);
+    void clear() noexcept;
+
+    /* Operations */
+    void splice(const_iterator, unrolled_list<T, Alloc>&);
+    void splice(const_iterator, unrolled_list<T, Alloc>&&);
+    void splice(const_iterator, unrolled_list<T, Alloc>&, const_iterator);
+    void splice(const_iterator, unrolled_list<T, Alloc>&&, const_iterator);
+    void splice(const_iterator, unrolled_list<T, Alloc>&, const_iterator, const_iterator);
+    void splice(const_iterator, unrolled_list<T, Alloc>&&, const_iterator, const_iterator);
+    void remove(const_ref);
+    template <class Predicate>
+        void remove_if(Predicate);
+    void unique();
+    template <class BinaryPredicate>
+        void unique(BinaryPredicate);
+    void merge(unrolled_list<T, Alloc>&);
+    void merge(unrolled_list<T, Alloc>&&);
+    template <class Compare>
+        void merge(unrolled_list<T, Alloc>&, Compare);
+    template <class Compare>
+        void merge(unrolled_list<T, Alloc>&&, Compare);
+    void sort();
+    template <class Compare>
+        void sort(Compare);
+    void reverse() noexcept;
+
+/* Helper functions */
+private:
+    static Chunk* chunk(Node* node) { return static_cast<Chunk*>(node); }
+    static Node* create_dummy();
+    static void delete_dummy(Node*);
+    Chunk* create_chunk(Node*);
+    void destroy_chunk(Chunk*);
+
+    template <class... Args>
+        iterator place(const_iterator, Args&&...);
+    template <class InputIt>
+        iterator place_range(const_iterator, InputIt, InputIt);
+    Chunk* split(Chunk*, size_type);
+    Node* boundary(const_iterator, const_iterator* = nullptr, const_iterator* = nullptr);
+    bool mend(Node*, Node*, chunk_position* = nullptr);
+    iterator settle(Node*, iterator);
+};
+
+template <class T, class Alloc>
+constexpr typename unrolled_list<T, Alloc>::size_type unrolled_list<T, Alloc>::chunk_bytes;
+
+template <class T, class Alloc>
+constexpr typename unrolled_list<T, Alloc>::size_type unrolled_list<T, Alloc>::chunk_capacity;
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - n: The number of times to insert 'element'.
+  - element: The element to be inserted.
+  - first: Iterator to the first element to be inserted.
+  - last: Iterator to one past the last element to be inserted.
+  - rhs: The list which is being either copied or moved from.
+  - il: Initializer list of elements.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty list.
+  2. list with n instances of 'element'.
+  3. list with elements from [first, last).
+  4. duplicate, independent list from rhs.
+  5. list that takes over rhs's chunks, leaving rhs empty.
+  6. list with all elements in il, preserving order.
+
+ Complexity: Constant for 1 and 5, otherwise linear in the number of
+             elements. Filled chunks are packed full.
+ */
+
+// 1. default
+template <class T, class Alloc>
+unrolled_list<T, Alloc>::unrolled_list()
+    : _dummy(create_dummy())
+{}
+
+// 2. fill
+template <class T, class Alloc>
+unrolled_list<T, Alloc>::unrolled_list(size_type n, const_ref element)
+    : unrolled_list()
+{
+    insert(cend(), n, element);
+}
+
+// 3. range
+template <class T, class Alloc>
+unrolled_list<T, Alloc>::unrolled_list(iterator first, iterator last)
+    : unrolled_list()
+{
+    insert(cend(), first, last);
+}
+
+// 4. copy
+template <class T, class Alloc>
+unrolled_list<T, Alloc>::unrolled_list(const unrolled_list<T, Alloc>& rhs)
+    : unrolled_list()
+{
+    insert(cend(), rhs.begin(), rhs.end());
+}
+
+// 5. move
+template <class T, class Alloc>
+unrolled_list<T, Alloc>::unrolled_list(unrolled_list<T, Alloc>&& rhs)
+    : unrolled_list()
+{
+    swap(rhs);
+}
+
+// 6. initializer list
+template <class T, class Alloc>
+unrolled_list<T, Alloc>::unrolled_list(std::initializer_list<T> il)
+    : unrolled_list()
+{
+    insert(cend(), il);
+}
+
+
+/*
+ Function: destructor
+ Description:
+    Destroys every element and frees every chunk.
+ */
+template <class T, class Alloc>
+unrolled_list<T, Alloc>::~unrolled_list()
+{
+    clear();
+    delete_dummy(_dummy);
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: The other list which is being assigned from.
+  - il: An initializer list of new elements for the list.
+ Return value: A reference to this list.
+
+ Description:
+    Replaces contents of this list with...
+    1. copies of rhs's elements.
+    2. rhs's chunks, leaving rhs empty.
+    3. the elements of il.
+
+ Complexity: Linear in the size of this list and (for 1 and 3) the size
+             of rhs or il.
+ */
+
+// 1. copy assignment
+template <class T, class Alloc>
+unrolled_list<T, Alloc>&
+unrolled_list<T, Alloc>::operator=(const unrolled_list<T, Alloc>& rhs)
+{
+    if (this != &rhs) {
+        clear();
+        insert(cend(), rhs.begin(), rhs.end());
+    }
+    return *this;
+}
+
+// 2. move assignment
+template <class T, class Alloc>
+unrolled_list<T, Alloc>&
+unrolled_list<T, Alloc>::operator=(unrolled_list<T, Alloc>&& rhs)
+{
+    clear();
+    swap(rhs);
+    return *this;
+}
+
+// 3. initializer list assignment
+template <class T, class Alloc>
+unrolled_list<T, Alloc>&
+unrolled_list<T, Alloc>::operator=(std::initializer_list<T> il)
+{
+    assign(il);
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end / cbegin / cend
+ Return value: An iterator to the first element, or to the past-the-end
+               position: the dummy node at index 0.
+ */
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::begin() const
+{
+    return iterator(_dummy->next, 0);
+}
+
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::end() const
+{
+    return iterator(_dummy, 0);
+}
+
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::const_iterator
+unrolled_list<T, Alloc>::cbegin() const
+{
+    return const_iterator(_dummy->next, 0);
+}
+
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::const_iterator
+unrolled_list<T, Alloc>::cend() const
+{
+    return const_iterator(_dummy, 0);
+}
+
+
+/*
+ Function: rbegin / rend / crbegin / crend
+ Return value: Reverse iterators to the last element, and to one before
+               the first.
+ */
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::reverse_iterator
+unrolled_list<T, Alloc>::rbegin() const
+{
+    return reverse_iterator(end());
+}
+
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::reverse_iterator
+unrolled_list<T, Alloc>::rend() const
+{
+    return reverse_iterator(begin());
+}
+
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::const_reverse_iterator
+unrolled_list<T, Alloc>::crbegin() const
+{
+    return const_reverse_iterator(cend());
+}
+
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::const_reverse_iterator
+unrolled_list<T, Alloc>::crend() const
+{
+    return const_reverse_iterator(cbegin());
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty / size / chunks
+ Return value: Whether the list is empty, the number of elements, and
+               the number of chunks holding them.
+
+ Complexity: Constant, and linear in the number of chunks for chunks.
+ */
+template <class T, class Alloc>
+inline bool
+unrolled_list<T, Alloc>::empty() const
+{
+    return _size == 0;
+}
+
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::size_type
+unrolled_list<T, Alloc>::size() const
+{
+    return _size;
+}
+
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::size_type
+unrolled_list<T, Alloc>::chunks() const
+{
+    size_type n = 0;
+    for (auto node = _dummy->next; node != _dummy; node = node->next)
+        ++n;
+    return n;
+}
+
+
+
+// Element access
+
+/*
+ Function: front / last
+ Return value: A reference to the first or the last element.
+ */
+template <class T, class Alloc>
+inline T&
+unrolled_list<T, Alloc>::front() const
+{
+    assert(!empty());
+    return chunk(_dummy->next)->data()[0];
+}
+
+template <class T, class Alloc>
+inline T&
+unrolled_list<T, Alloc>::last() const
+{
+    assert(!empty());
+    auto c = chunk(_dummy->prev);
+    return c->data()[c->count - 1];
+}
+
+
+/*
+ Function: at / operator[]
+ Parameters:
+  - index: The position within the list to access.
+ Return value: A reference to the index-th element.
+
+ Complexity: Linear in index / chunk_capacity: whole chunks are skipped
+             by their counts.
+ */
+template <class T, class Alloc>
+T&
+unrolled_list<T, Alloc>::at(size_type index) const
+{
+    assert(index < _size);
+
+    auto node = _dummy->next;
+    while (index >= chunk(node)->count) {
+        index -= chunk(node)->count;
+        node = node->next;
+    }
+    return chunk(node)->data()[index];
+}
+
+template <class T, class Alloc>
+inline T&
+unrolled_list<T, Alloc>::operator[](size_type index) const
+{
+    return at(index);
+}
+
+
+
+// Modifiers
+
+/*
+ Function: assign
+ Parameters:
+  - first, last: A range of elements.
+  - n: The number of times to add 'element'.
+  - element: The element to be repeatedly added.
+  - il: An initializer list of new elements.
+ Return value: None
+
+ Description:
+    Replaces the contents of the list with...
+    1. a range of elements.
+    2. one element repeated n times.
+    3. an initializer list of new elements.
+
+ Complexity: Linear in the current size of the list and the number of
+             elements replacing them.
+ */
+
+// 1. assign range
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::assign(iterator first, iterator last)
+{
+    clear();
+    insert(cend(), first, last);
+}
+
+// 2. assign fill
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::assign(size_type n, const_ref element)
+{
+    clear();
+    insert(cend(), n, element);
+}
+
+// 3. assign initializer list
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::assign(std::initializer_list<T> il)
+{
+    clear();
+    insert(cend(), il);
+}
+
+
+/*
+ Function: push_front / push_back / emplace_front / emplace_back
+ Parameters:
+  - element / args: The new element, or its constructor's arguments.
+ Return value: None
+
+ Description:
+    Adds an element at either end, into the end chunk while it has room
+    and into a new chunk after that.
+
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::push_front(const_ref element)
+{
+    place(cbegin(), element);
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::push_front(rvalue_ref element)
+{
+    place(cbegin(), std::move(element));
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::push_back(const_ref element)
+{
+    place(cend(), element);
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::push_back(rvalue_ref element)
+{
+    place(cend(), std::move(element));
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+unrolled_list<T, Alloc>::emplace_front(Args&&... args)
+{
+    place(cbegin(), std::forward<Args>(args)...);
+}
+
+template <class T, class Alloc>
+template <class... Args>
+inline void
+unrolled_list<T, Alloc>::emplace_back(Args&&... args)
+{
+    place(cend(), std::forward<Args>(args)...);
+}
+
+
+/*
+ Function: emplace
+ Parameters:
+  - pos: The iterator to insert the new element before.
+  - args: Arguments used to construct the new element.
+ Return value: An iterator to the new element.
+
+ Complexity: O(chunk_capacity).
+ */
+template <class T, class Alloc>
+template <class... Args>
+inline typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::emplace(const_iterator pos, Args&&... args)
+{
+    return place(pos, std::forward<Args>(args)...);
+}
+
+
+/*
+ Function: pop_front / pop_back
+ Description:
+    Removes the first or the last element.
+
+ Complexity: Constant at the back, O(chunk_capacity) at the front.
+ */
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::pop_front()
+{
+    erase(cbegin());
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::pop_back()
+{
+    erase(--cend());
+}
+
+
+/*
+ Function: insert
+ Parameters:
+  - pos: The position the new elements go in front of.
+  - n: The number of duplicate elements to be inserted.
+  - element: The new item to be inserted.
+  - first, last: The range of elements to be copied.
+  - il: An initializer list of new values.
+ Return value: An iterator to the first inserted element, or pos if none
+               were.
+
+ Description:
+  1. Adds an element before pos.
+  2. Adds n copies of an element before pos.
+  3. Adds copies of [first, last) before pos.
+  4. Adds an element before pos, moving it in.
+  5. Adds the elements of an initializer list before pos.
+    Several elements are written into the room left before pos and then
+    into fresh, full chunks linked in after it.
+
+ Complexity: O(chunk_capacity) plus linear in the number of elements
+             inserted.
+ */
+
+// 1. single element
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::insert(const_iterator pos, const_ref element)
+{
+    return place(pos, element);
+}
+
+// 2. fill
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::insert(const_iterator pos, size_type n, const_ref element)
+{
+    struct repeat {
+        const_ref value;
+        size_type left;
+        bool operator!=(const repeat& rhs) const { return left != rhs.left; }
+        repeat& operator++() { --left; return *this; }
+        const_ref operator*() const { return value; }
+    };
+
+    return place_range(pos, repeat{element, n}, repeat{element, 0});
+}
+
+// 3. range
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::insert(const_iterator pos, iterator first, iterator last)
+{
+    return place_range(pos, first, last);
+}
+
+// 4. move
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::insert(const_iterator pos, rvalue_ref element)
+{
+    return place(pos, std::move(element));
+}
+
+// 5. initializer list
+template <class T, class Alloc>
+inline typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::insert(const_iterator pos, std::initializer_list<T> il)
+{
+    return place_range(pos, il.begin(), il.end());
+}
+
+
+/*
+ Function: erase
+ Parameters:
+  - pos: The element to be removed.
+  - first, last: The range of elements to be removed.
+ Return value: An iterator to the element that followed the last one
+               removed.
+
+ Description:
+    Removes...
+    1. an element, moving the rest of its chunk down.
+    2. the elements in [first, last). Chunks wholly inside the range are
+       freed without moving anything.
+    Neighbouring chunks left with room for each other are then merged.
+
+ Complexity: O(chunk_capacity) plus linear in the number of elements
+             removed.
+ */
+
+// 1. single element
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::erase(const_iterator pos)
+{
+    auto c = chunk(pos.node);
+    auto i = pos.index;
+    auto data = c->data();
+
+    std::move(data + i + 1, data + c->count, data + i);
+    data[--c->count].~T();
+    --_size;
+
+    if (c->count == 0) {
+        auto next = c->next;
+        destroy_chunk(c);
+        return iterator(next, 0);
+    }
+    return settle(c, i < c->count ? iterator(c, i) : iterator(c->next, 0));
+}
+
+// 2. range
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::erase(const_iterator first, const_iterator last)
+{
+    auto node = first.node;
+    auto i = first.index;
+
+    // Cut the tail off first's chunk and drop the chunks up to last's.
+    while (node != last.node) {
+        auto c = chunk(node);
+        auto data = c->data();
+        for (auto j = i; j < c->count; ++j)
+            data[j].~T();
+        _size -= c->count - i;
+        c->count = i;
+
+        node = node->next;
+        if (c->count == 0)
+            destroy_chunk(c);
+        i = 0;
+    }
+
+    // Then the front of last's chunk, up to last.
+    if (node != _dummy && i < last.index) {
+        auto c = chunk(node);
+        auto data = c->data();
+        auto gap = last.index - i;
+        std::move(data + last.index, data + c->count, data + i);
+        for (auto j = c->count - gap; j < c->count; ++j)
+            data[j].~T();
+        c->count -= gap;
+        _size -= gap;
+    }
+
+    if (node == _dummy)
+        return settle(_dummy->prev, end());
+    return settle(node, iterator(node, i));
+}
+
+
+/*
+ Function: swap
+ Parameters:
+  - rhs: The other list to swap with.
+ Return value: None
+
+ Complexity: Constant.
+ */
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::swap(unrolled_list<T, Alloc>& rhs)
+{
+    std::swap(_dummy, rhs._dummy);
+    std::swap(_size, rhs._size);
+}
+
+
+/*
+ Function: clear
+ Description:
+    Removes all elements, a chunk at a time.
+
+ Complexity: Linear in the size of the list; in the number of chunks if
+             T is trivially destructible.
+ */
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::clear() noexcept
+{
+    for (auto node = _dummy->next; node != _dummy;) {
+        auto c = chunk(node);
+        node = node->next;
+        if (!std::is_trivially_destructible<T>::value)
+            for (size_type i = 0; i < c->count; ++i)
+                c->data()[i].~T();
+        c->count = 0;
+        destroy_chunk(c);
+    }
+    _size = 0;
+}
+
+
+
+// Operations
+
+/*
+ Function: splice
+ Parameters:
+  - pos: The position the moved elements go in front of.
+  - x: The list the elements are taken from; may be this list, in which
+       case pos must not lie inside the moved range.
+  - i: The element in x to be moved.
+  - first, last: The range of elements in x to be moved.
+ Return value: None
+
+ Description:
+  1. Moves all of x in front of pos.
+  2. Moves one element of x in front of pos.
+  3. Moves [first, last) of x in front of pos.
+    The chunks at the ends of the range, and pos's chunk, are split so
+    the range is made of whole chunks, which are then unlinked from x and
+    linked in at pos. Chunks meeting at the seams are merged when they
+    fit. Iterators to moved elements stay valid except in the chunks that
+    were split or merged.
+
+ Complexity: O(chunk_capacity) plus linear in the number of chunks moved.
+ */
+
+// 1. entire list
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::splice(const_iterator pos, unrolled_list<T, Alloc>& x)
+{
+    if (!x.empty())
+        splice(pos, x, x.cbegin(), x.cend());
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::splice(const_iterator pos, unrolled_list<T, Alloc>&& x)
+{
+    splice(pos, x);
+}
+
+// 2. single element
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::splice(const_iterator pos, unrolled_list<T, Alloc>& x, const_iterator i)
+{
+    splice(pos, x, i, i.next());
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::splice(const_iterator pos, unrolled_list<T, Alloc>&& x, const_iterator i)
+{
+    splice(pos, x, i, i.next());
+}
+
+// 3. element range
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::splice(const_iterator pos, unrolled_list<T, Alloc>& x, const_iterator first, const_iterator last)
+{
+    if (first == last || (this == &x && (pos == first || pos == last)))
+        return;
+
+    // Split so that [first, last) is the whole chunks [head, tail] and pos
+    // starts a chunk (or is the end).
+    auto after = x.boundary(last, &first, &pos);
+    auto head = x.boundary(first, &pos);
+    auto before = boundary(pos);
+    auto tail = after->prev;
+    auto left = head->prev;
+
+    size_type moved = 0;
+    for (auto node = head; node != after; node = node->next)
+        moved += chunk(node)->count;
+
+    left->next = after;
+    after->prev = left;
+    head->prev = before->prev;
+    tail->next = before;
+    before->prev->next = head;
+    before->prev = tail;
+
+    x._size -= moved;
+    _size += moved;
+
+    x.mend(left, after);
+    mend(tail, before);
+    mend(head->prev, head);
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::splice(const_iterator pos, unrolled_list<T, Alloc>&& x, const_iterator first, const_iterator last)
+{
+    splice(pos, x, first, last);
+}
+
+
+/*
+ Function: remove / remove_if
+ Parameters:
+  - element: The value of the element to be removed.
+  - pred: The predicate used to test all elements in the list.
+ Return value: None
+
+ Description:
+    remove erases the first occurrence of element, as list does.
+    remove_if erases every element satisfying pred: the survivors are
+    moved down over the gaps in one pass and the tail is erased at once.
+
+ Complexity: Linear in the size of the list.
+ */
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::remove(const_ref element)
+{
+    auto it = std::find(cbegin(), cend(), element);
+    if (it != cend())
+        erase(it);
+}
+
+template <class T, class Alloc>
+template <class Predicate>
+void
+unrolled_list<T, Alloc>::remove_if(Predicate pred)
+{
+    auto keep = begin();
+    for (auto it = begin(); it != end(); ++it) {
+        if (!pred(*it)) {
+            if (keep != it)
+                *keep = std::move(*it);
+            ++keep;
+        }
+    }
+    erase(keep, cend());
+}
+
+
+/*
+ Function: unique
+ Parameters:
+  - predicate: Called with iterators to the last element kept and the
+               current one; true removes the current one.
+ Return value: None
+
+ Description:
+    Removes every element equal to (or, with a predicate, matching) the
+    element kept before it, compacting in one pass like remove_if.
+
+ Complexity: Linear in the size of the list.
+ */
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::unique()
+{
+    unique([](iterator first, iterator second) { return *first == *second; });
+}
+
+template <class T, class Alloc>
+template <class BinaryPredicate>
+void
+unrolled_list<T, Alloc>::unique(BinaryPredicate predicate)
+{
+    if (empty())
+        return;
+
+    auto keep = begin();
+    for (auto it = keep.next(); it != end(); ++it) {
+        if (!predicate(keep, it)) {
+            ++keep;
+            if (keep != it)
+                *keep = std::move(*it);
+        }
+    }
+    erase(++keep, cend());
+}
+
+
+/*
+ Function: merge
+ Parameters:
+  - other: Another sorted list, left empty.
+  - compare: Called with iterators into other and this list; true if the
+             element from other goes first.
+ Return value: None
+
+ Description:
+    Merges the two sorted lists, elements of this list going first among
+    equals. Elements are moved into freshly packed chunks, so iterators
+    into either list are invalidated.
+
+ Complexity: Linear in the combined size of both lists.
+ */
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::merge(unrolled_list<T, Alloc>& other)
+{
+    merge(other, [](iterator other_el, iterator this_el) { return *other_el < *this_el; });
+}
+
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::merge(unrolled_list<T, Alloc>&& other)
+{
+    merge(other);
+}
+
+template <class T, class Alloc>
+template <class Compare>
+void
+unrolled_list<T, Alloc>::merge(unrolled_list<T, Alloc>& other, Compare compare)
+{
+    if (this == &other)
+        return;
+
+    unrolled_list<T, Alloc> merged;
+    auto a = begin(), b = other.begin();
+    while (a != end() && b != other.end()) {
+        if (compare(b, a))
+            merged.push_back(std::move(*b++));
+        else
+            merged.push_back(std::move(*a++));
+    }
+    for (; a != end(); ++a)
+        merged.push_back(std::move(*a));
+    for (; b != other.end(); ++b)
+        merged.push_back(std::move(*b));
+
+    swap(merged);
+    other.clear();
+}
+
+template <class T, class Alloc>
+template <class Compare>
+inline void
+unrolled_list<T, Alloc>::merge(unrolled_list<T, Alloc>&& other, Compare compare)
+{
+    merge(other, compare);
+}
+
+
+/*
+ Function: sort
+ Parameters:
+  - compare: Called with two iterators; true if the first element goes
+             before the second.
+ Return value: None
+
+ Description:
+    Stable sort. The positions are sorted, then the elements moved out in
+    that order and back into the same slots, so the chunks keep their
+    shape.
+
+ Complexity: O(n log n).
+ */
+template <class T, class Alloc>
+inline void
+unrolled_list<T, Alloc>::sort()
+{
+    sort([](iterator first, iterator second) { return *first < *second; });
+}
+
+template <class T, class Alloc>
+template <class Compare>
+void
+unrolled_list<T, Alloc>::sort(Compare compare)
+{
+    std::vector<iterator> order;
+    order.reserve(_size);
+    for (auto it = begin(); it != end(); ++it)
+        order.push_back(it);
+    std::stable_sort(order.begin(), order.end(), compare);
+
+    std::vector<T> sorted;
+    sorted.reserve(_size);
+    for (auto it : order)
+        sorted.push_back(std::move(*it));
+
+    auto it = begin();
+    for (auto& element : sorted)
+        *it++ = std::move(element);
+}
+
+
+/*
+ Function: reverse
+ Description:
+    Reverses the order of the chunks and of the elements within each.
+
+ Complexity: Linear in the size of the list.
+ */
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::reverse() noexcept
+{
+    auto node = _dummy;
+    do {
+        std::swap(node->prev, node->next);
+        node = node->prev;
+        if (node != _dummy)
+            std::reverse(chunk(node)->data(), chunk(node)->data() + chunk(node)->count);
+    } while (node != _dummy);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: create_dummy / delete_dummy
+ Description:
+    Allocate and free the sentinel, a bare pair of links.
+ */
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::Node*
+unrolled_list<T, Alloc>::create_dummy()
+{
+    typename Alloc::template rebind<Node>::other alloc;
+    auto node = alloc.allocate(1);
+    alloc.construct(node);
+    return node;
+}
+
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::delete_dummy(Node* node)
+{
+    typename Alloc::template rebind<Node>::other alloc;
+    alloc.destroy(node);
+    alloc.deallocate(node, 1);
+}
+
+
+/*
+ Function: create_chunk / destroy_chunk
+ Parameters:
+  - next: The node the new, empty chunk is linked in front of.
+  - c: A chunk whose elements are already destroyed.
+ Return value: The new chunk.
+ */
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::Chunk*
+unrolled_list<T, Alloc>::create_chunk(Node* next)
+{
+    typename Alloc::template rebind<Chunk>::other alloc;
+    auto c = alloc.allocate(1);
+    alloc.construct(c);
+
+    c->next = next;
+    c->prev = next->prev;
+    c->prev->next = c;
+    next->prev = c;
+    return c;
+}
+
+template <class T, class Alloc>
+void
+unrolled_list<T, Alloc>::destroy_chunk(Chunk* c)
+{
+    c->prev->next = c->next;
+    c->next->prev = c->prev;
+
+    typename Alloc::template rebind<Chunk>::other alloc;
+    alloc.destroy(c);
+    alloc.deallocate(c, 1);
+}
+
+
+/*
+ Function: place
+ Parameters:
+  - pos: Where the new element goes.
+  - args: Its constructor's arguments.
+ Return value: An iterator to the new element.
+
+ Description:
+    Picks the chunk the element goes in: the end of the previous chunk
+    when pos starts a chunk and the previous one has room, a new chunk
+    when pos is at either end of a full chunk, and otherwise pos's chunk,
+    split in half first if full. Appending to a chunk with room
+    constructs in place; anywhere else the element is built first and the
+    elements after it are moved up one slot.
+ */
+template <class T, class Alloc>
+template <class... Args>
+typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::place(const_iterator pos, Args&&... args)
+{
+    auto node = pos.node;
+    auto i = pos.index;
+    if (node == _dummy || (i == 0 && node->prev != _dummy && chunk(node->prev)->count < chunk_capacity)) {
+        node = node->prev;
+        i = node == _dummy ? 0 : chunk(node)->count;
+    }
+
+    if (node != _dummy && i == chunk(node)->count && i < chunk_capacity) {
+        auto c = chunk(node);
+        ::new (static_cast<void*>(c->data() + i)) T(std::forward<Args>(args)...);
+        ++c->count;
+        ++_size;
+        return iterator(c, i);
+    }
+
+    T element(std::forward<Args>(args)...);
+    Chunk* c;
+    if (node == _dummy) {
+        c = create_chunk(_dummy);
+    } else {
+        c = chunk(node);
+        if (c->count == chunk_capacity) {
+            if (i == 0) {
+                c = create_chunk(c);
+            } else if (i == chunk_capacity) {
+                c = create_chunk(c->next);
+                i = 0;
+            } else {
+                auto upper = split(c, chunk_capacity / 2);
+                if (i > chunk_capacity / 2) {
+                    c = upper;
+                    i -= chunk_capacity / 2;
+                }
+            }
+        }
+    }
+
+    auto data = c->data();
+    if (i == c->count) {
+        ::new (static_cast<void*>(data + i)) T(std::move(element));
+    } else {
+        ::new (static_cast<void*>(data + c->count)) T(std::move(data[c->count - 1]));
+        std::move_backward(data + i, data + c->count - 1, data + c->count);
+        data[i] = std::move(element);
+    }
+    ++c->count;
+    ++_size;
+    return iterator(c, i);
+}
+
+
+/*
+ Function: place_range
+ Parameters:
+  - pos: Where the new elements go.
+  - first, last: The elements to copy.
+ Return value: An iterator to the first new element, or pos if there
+               were none.
+
+ Description:
+    Splits pos's chunk at pos, tops up the lower half and fills new
+    chunks after it, each one full before the next is started. The upper
+    half is merged into the last of them if it fits.
+ */
+template <class T, class Alloc>
+template <class InputIt>
+typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::place_range(const_iterator pos, InputIt first, InputIt last)
+{
+    if (!(first != last))
+        return iterator(pos.node, pos.index);
+
+    auto next = boundary(pos);
+    Chunk* c = next->prev == _dummy ? nullptr : chunk(next->prev);
+    chunk_position result(nullptr, 0);
+    for (; first != last; ++first) {
+        if (!c || c->count == chunk_capacity)
+            c = create_chunk(next);
+        if (!result.node)
+            result = chunk_position(c, c->count);
+        ::new (static_cast<void*>(c->data() + c->count)) T(*first);
+        ++c->count;
+        ++_size;
+    }
+
+    mend(c, next);
+    return iterator(result.node, result.index);
+}
+
+
+/*
+ Function: split
+ Parameters:
+  - c: A chunk.
+  - at: An index in c, above zero.
+ Return value: A new chunk after c holding what was c[at, count).
+ */
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::Chunk*
+unrolled_list<T, Alloc>::split(Chunk* c, size_type at)
+{
+    auto upper = create_chunk(c->next);
+    auto from = c->data(), to = upper->data();
+    for (auto i = at; i < c->count; ++i) {
+        ::new (static_cast<void*>(to + (i - at))) T(std::move(from[i]));
+        from[i].~T();
+    }
+    upper->count = c->count - at;
+    c->count = at;
+    return upper;
+}
+
+
+/*
+ Function: boundary
+ Parameters:
+  - pos: A position in this list.
+  - a, b: Other iterators to keep pointing at the same elements.
+ Return value: A node that begins at pos: pos's chunk if pos is its first
+               element, the dummy for end(), and otherwise the upper half
+               of pos's chunk, split off.
+ */
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::Node*
+unrolled_list<T, Alloc>::boundary(const_iterator pos, const_iterator* a, const_iterator* b)
+{
+    if (pos.index == 0)
+        return pos.node;
+
+    auto upper = split(chunk(pos.node), pos.index);
+    for (auto it : {a, b}) {
+        if (it && it->node == pos.node && it->index >= pos.index) {
+            it->node = upper;
+            it->index -= pos.index;
+        }
+    }
+    return upper;
+}
+
+
+/*
+ Function: mend
+ Parameters:
+  - left, right: Neighbouring nodes.
+  - it: An iterator to keep pointing at the same element.
+ Return value: Whether right was merged into left.
+
+ Description:
+    Moves right's elements to the end of left and frees right when both
+    are chunks with at most three quarters of a chunk between them.
+ */
+template <class T, class Alloc>
+bool
+unrolled_list<T, Alloc>::mend(Node* left, Node* right, chunk_position* it)
+{
+    if (left == _dummy || right == _dummy)
+        return false;
+
+    auto l = chunk(left), r = chunk(right);
+    if (l->count + r->count > chunk_capacity - chunk_capacity / 4)
+        return false;
+
+    auto from = r->data(), to = l->data() + l->count;
+    for (size_type i = 0; i < r->count; ++i) {
+        ::new (static_cast<void*>(to + i)) T(std::move(from[i]));
+        from[i].~T();
+    }
+    if (it && it->node == right) {
+        it->node = left;
+        it->index += l->count;
+    }
+    l->count += r->count;
+    r->count = 0;
+    destroy_chunk(r);
+    return true;
+}
+
+
+/*
+ Function: settle
+ Parameters:
+  - c: A chunk that just lost elements.
+  - it: An iterator to keep pointing at the same element.
+ Return value: it, updated for any merge.
+
+ Description:
+    Merges c with its successor, then with its predecessor, where they
+    fit.
+ */
+template <class T, class Alloc>
+typename unrolled_list<T, Alloc>::iterator
+unrolled_list<T, Alloc>::settle(Node* c, iterator it)
+{
+    if (c == _dummy)
+        return it;
+    mend(c, c->next, &it);
+    mend(c->prev, c, &it);
+    return it;
+}
+
+
+} // end namespace
+
+#endif /* unrolled_list_h */
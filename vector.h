@@ -1,9 +1,35 @@
+/*
+ File:   vector.h
+ Author: Kyle Thompson
+
+ Purpose:
+    Contiguous, geometrically growing sequences.
+
+ Implementation:
+  - small_vector keeps its first N elements in storage embedded in the
+    object itself and only touches the allocator once it outgrows them.
+    When it does, capacity doubles so pushes are amortized constant.
+  - Elements are relocated with move_if_noexcept, so a throwing move
+    constructor falls back to copying and leaves the source intact.
+
+ TODO:
+  - Finish vector.
+ */
+
+
 #ifndef vector_h
 #define vector_h
 
+#include <algorithm>    // max
+#include <cassert>      // assert
+#include <iterator>     // iterator_traits
+#include <memory>       // allocator, allocator_traits
+#include <type_traits>  // aligned_storage
+#include <utility>      // move, forward, move_if_noexcept
+
 template <class T, class Alloc = std::allocator<T>>
 class vector {
-    
+
 /* Type definitions */
 public:
     typedef std::size_t size_type;
@@ -13,18 +39,649 @@ public:
     typedef T&          reference;
     typedef T&&         rvalue_ref;
     typedef const T&    const_ref;
-    
+
 /* Iterators */
-    
-    
+
+
 /* Data members */
     T* _data;
     size_type _size = 0;
-    
-    
+
+
 /* Member functions */
-    
-    
+
+
 };
 
+
+namespace ads {
+
+template <class T, std::size_t N, class Alloc = std::allocator<T>>
+class small_vector {
+
+    static_assert(N > 0, "small_vector needs at least one inline slot");
+
+/* Type definitions */
+public:
+    typedef std::size_t size_type;
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_ptr;
+    typedef T&          reference;
+    typedef T&&         rvalue_ref;
+    typedef const T&    const_ref;
+    typedef T*          iterator;
+    typedef const T*    const_iterator;
+
+private:
+    typedef std::allocator_traits<Alloc> traits;
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot;
+
+
+/* Data members */
+private:
+    T* _data;                 // Either the inline slots or a heap block.
+    size_type _size = 0;
+    size_type _capacity = N;
+    Alloc _alloc;
+    slot _inline[N];
+
+
+/* Member functions */
+public:
+    /* Constructors */
+    small_vector();
+    small_vector(const small_vector<T, N, Alloc>&);
+    small_vector(small_vector<T, N, Alloc>&&);
+    small_vector(std::initializer_list<T>);
+    ~small_vector();
+
+    /* Assignment */
+    small_vector<T, N, Alloc>& operator=(const small_vector<T, N, Alloc>&);
+    small_vector<T, N, Alloc>& operator=(small_vector<T, N, Alloc>&&);
+
+    /* Iterators */
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    /* Capacity */
+    bool empty() const;
+    size_type size() const;
+    size_type capacity() const;
+    bool is_inline() const;
+    void reserve(size_type);
+
+    /* Element access */
+    reference operator[](size_type);
+    const_ref operator[](size_type) const;
+    reference front();
+    reference last();
+    const_ref last() const;
+    pointer data();
+
+    /* Modifiers */
+    void push_back(const_ref);
+    void push_back(rvalue_ref);
+    template <class... Args>
+        reference emplace_back(Args&&...);
+    template <class InputIt>
+        void append(InputIt, InputIt);
+    void pop_back();
+    void pop_back(size_type);
+    void clear() noexcept;
+
+/* Helper functions */
+private:
+    T* inline_data();
+    void grow(size_type);
+    void relocate(T*, size_type);
+    void release();
+};
+
+
+
+// Constructors
+
+/*
+ Function: constructor
+ Parameters:
+  - rhs: The small_vector which is being either copied or moved from.
+  - il: Initializer list of elements.
+ Return value: None
+
+ Description:
+    Makes a(n)...
+  1. empty small_vector using only inline storage.
+  2. duplicate, independent copy of rhs.
+  3. small_vector holding rhs's elements. A heap block is stolen outright;
+     inline elements are moved one by one.
+  4. small_vector with all elements in il, preserving order.
+
+ Complexity:
+  1. Constant.
+  2. Linear in the size of rhs.
+  3. Constant if rhs is on the heap, otherwise linear in its size.
+  4. Linear in the size of il.
+ */
+
+// 1. default
+template <class T, std::size_t N, class Alloc>
+small_vector<T, N, Alloc>::small_vector()
+    : _data(inline_data())
+{}
+
+// 2. copy
+template <class T, std::size_t N, class Alloc>
+small_vector<T, N, Alloc>::small_vector(const small_vector<T, N, Alloc>& rhs)
+    : small_vector()
+{
+    append(rhs.begin(), rhs.end());
+}
+
+// 3. move
+template <class T, std::size_t N, class Alloc>
+small_vector<T, N, Alloc>::small_vector(small_vector<T, N, Alloc>&& rhs)
+    : small_vector()
+{
+    *this = std::move(rhs);
+}
+
+// 4. initializer list
+template <class T, std::size_t N, class Alloc>
+small_vector<T, N, Alloc>::small_vector(std::initializer_list<T> il)
+    : small_vector()
+{
+    append(il.begin(), il.end());
+}
+
+
+/*
+ Function: destructor
+
+ Description:
+    Destroys all elements and frees any heap block.
+ */
+template <class T, std::size_t N, class Alloc>
+small_vector<T, N, Alloc>::~small_vector()
+{
+    clear();
+    release();
+}
+
+
+
+// Assignment
+
+/*
+ Function: operator=
+ Parameters:
+  - rhs: The small_vector which is being assigned from.
+ Return value: A reference to this small_vector.
+
+ Description:
+    1. Replaces the contents with copies of rhs's elements.
+    2. Replaces the contents with rhs's elements, leaving rhs empty.
+
+ Complexity: Linear in the size of both small_vectors, except a move from a
+             heap block which is linear in the size of this one.
+ */
+
+// 1. copy assignment
+template <class T, std::size_t N, class Alloc>
+small_vector<T, N, Alloc>&
+small_vector<T, N, Alloc>::operator=(const small_vector<T, N, Alloc>& rhs)
+{
+    if (this != &rhs) {
+        clear();
+        append(rhs.begin(), rhs.end());
+    }
+
+    return *this;
+}
+
+// 2. move assignment
+template <class T, std::size_t N, class Alloc>
+small_vector<T, N, Alloc>&
+small_vector<T, N, Alloc>::operator=(small_vector<T, N, Alloc>&& rhs)
+{
+    if (this == &rhs)
+        return *this;
+
+    clear();
+
+    if (!rhs.is_inline()) {
+        release();
+        _data = rhs._data;
+        _size = rhs._size;
+        _capacity = rhs._capacity;
+
+        rhs._data = rhs.inline_data();
+        rhs._size = 0;
+        rhs._capacity = N;
+    } else {
+        append(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+        rhs.clear();
+    }
+
+    return *this;
+}
+
+
+
+// Iterators
+
+/*
+ Function: begin / end
+ Return value: Pointers to the first and one past the last element.
+ */
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::iterator
+small_vector<T, N, Alloc>::begin()
+{
+    return _data;
+}
+
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::iterator
+small_vector<T, N, Alloc>::end()
+{
+    return _data + _size;
+}
+
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::const_iterator
+small_vector<T, N, Alloc>::begin() const
+{
+    return _data;
+}
+
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::const_iterator
+small_vector<T, N, Alloc>::end() const
+{
+    return _data + _size;
+}
+
+
+
+// Capacity
+
+/*
+ Function: empty
+ Return value: Whether or not the small_vector is empty.
+ */
+template <class T, std::size_t N, class Alloc>
+inline bool
+small_vector<T, N, Alloc>::empty() const
+{
+    return _size == 0;
+}
+
+
+/*
+ Function: size
+ Return value: The number of elements.
+ */
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::size_type
+small_vector<T, N, Alloc>::size() const
+{
+    return _size;
+}
+
+
+/*
+ Function: capacity
+ Return value: The number of elements that fit without reallocating.
+ */
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::size_type
+small_vector<T, N, Alloc>::capacity() const
+{
+    return _capacity;
+}
+
+
+/*
+ Function: is_inline
+ Return value: Whether the elements are still in the embedded storage.
+ */
+template <class T, std::size_t N, class Alloc>
+inline bool
+small_vector<T, N, Alloc>::is_inline() const
+{
+    return _data == reinterpret_cast<const T*>(_inline);
+}
+
+
+/*
+ Function: reserve
+ Parameters:
+  - n: The minimum capacity wanted.
+ Return value: None
+
+ Complexity: Linear in the size if a reallocation happens.
+ */
+template <class T, std::size_t N, class Alloc>
+void
+small_vector<T, N, Alloc>::reserve(size_type n)
+{
+    if (n > _capacity)
+        grow(n);
+}
+
+
+
+// Element access
+
+/*
+ Function: operator[]
+ Parameters:
+  - index: The position to access.
+ Return value: A reference to the index-th element.
+ */
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::reference
+small_vector<T, N, Alloc>::operator[](size_type index)
+{
+    assert(index < _size);
+    return _data[index];
+}
+
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::const_ref
+small_vector<T, N, Alloc>::operator[](size_type index) const
+{
+    assert(index < _size);
+    return _data[index];
+}
+
+
+/*
+ Function: front / last
+ Return value: A reference to the first or last element.
+ */
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::reference
+small_vector<T, N, Alloc>::front()
+{
+    assert(!empty());
+    return _data[0];
+}
+
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::reference
+small_vector<T, N, Alloc>::last()
+{
+    assert(!empty());
+    return _data[_size - 1];
+}
+
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::const_ref
+small_vector<T, N, Alloc>::last() const
+{
+    assert(!empty());
+    return _data[_size - 1];
+}
+
+
+/*
+ Function: data
+ Return value: A pointer to the contiguous elements.
+ */
+template <class T, std::size_t N, class Alloc>
+inline typename small_vector<T, N, Alloc>::pointer
+small_vector<T, N, Alloc>::data()
+{
+    return _data;
+}
+
+
+
+// Modifiers
+
+/*
+ Function: push_back
+ Parameters:
+  - element: The element to append.
+ Return value: None
+
+ Complexity: Amortized constant.
+ */
+template <class T, std::size_t N, class Alloc>
+inline void
+small_vector<T, N, Alloc>::push_back(const_ref element)
+{
+    emplace_back(element);
+}
+
+template <class T, std::size_t N, class Alloc>
+inline void
+small_vector<T, N, Alloc>::push_back(rvalue_ref element)
+{
+    emplace_back(std::move(element));
+}
+
+
+/*
+ Function: emplace_back
+ Parameters:
+  - args: Arguments used to construct the new T object in place.
+ Return value: A reference to the new element.
+
+ Description:
+    If the small_vector is full the new element is constructed in the new
+    block before the old elements are relocated, so args may safely refer
+    to an existing element. Should either step throw, the new block is
+    freed and the small_vector is unchanged.
+
+ Complexity: Amortized constant.
+ */
+template <class T, std::size_t N, class Alloc>
+template <class... Args>
+inline typename small_vector<T, N, Alloc>::reference
+small_vector<T, N, Alloc>::emplace_back(Args&&... args)
+{
+    if (_size == _capacity) {
+        auto cap = _capacity * 2;
+        T* block = traits::allocate(_alloc, cap);
+        try {
+            traits::construct(_alloc, block + _size, std::forward<Args>(args)...);
+            try {
+                relocate(block, cap);
+            } catch (...) {
+                traits::destroy(_alloc, block + _size);
+                throw;
+            }
+        } catch (...) {
+            traits::deallocate(_alloc, block, cap);
+            throw;
+        }
+    } else {
+        traits::construct(_alloc, _data + _size, std::forward<Args>(args)...);
+    }
+
+    return _data[_size++];
+}
+
+
+/*
+ Function: append
+ Parameters:
+  - first: The first element in a range.
+  - last: One past the last element in a range.
+ Return value: None
+
+ Description:
+    Copies (or moves, given move iterators) a range onto the end. Forward
+    ranges reserve their full length up front so at most one reallocation
+    happens.
+
+ Complexity: Linear in the length of the range.
+ */
+template <class T, std::size_t N, class Alloc>
+template <class InputIt>
+void
+small_vector<T, N, Alloc>::append(InputIt first, InputIt last)
+{
+    typedef typename std::iterator_traits<InputIt>::iterator_category category;
+    if (std::is_base_of<std::forward_iterator_tag, category>::value)
+        reserve(_size + static_cast<size_type>(std::distance(first, last)));
+
+    for (; first != last; ++first)
+        emplace_back(*first);
+}
+
+
+/*
+ Function: pop_back
+ Parameters:
+  - n: The number of elements to remove.
+ Return value: None
+
+ Description:
+    Destroys the last element, or the last n elements. Storage is kept.
+
+ Complexity: Constant, or linear in n.
+ */
+template <class T, std::size_t N, class Alloc>
+inline void
+small_vector<T, N, Alloc>::pop_back()
+{
+    assert(!empty());
+    traits::destroy(_alloc, _data + --_size);
+}
+
+template <class T, std::size_t N, class Alloc>
+void
+small_vector<T, N, Alloc>::pop_back(size_type n)
+{
+    assert(n <= _size);
+    while (n-- > 0)
+        traits::destroy(_alloc, _data + --_size);
+}
+
+
+/*
+ Function: clear
+ Return value: None
+
+ Description:
+    Destroys all elements. Storage is kept.
+
+ Complexity: Linear in the size.
+ */
+template <class T, std::size_t N, class Alloc>
+inline void
+small_vector<T, N, Alloc>::clear() noexcept
+{
+    pop_back(_size);
+}
+
+
+
+// Helper functions
+
+/*
+ Function: inline_data
+ Return value: The embedded storage viewed as T*.
+ */
+template <class T, std::size_t N, class Alloc>
+inline T*
+small_vector<T, N, Alloc>::inline_data()
+{
+    return reinterpret_cast<T*>(_inline);
+}
+
+
+/*
+ Function: grow
+ Parameters:
+  - n: The minimum new capacity.
+ Return value: None
+
+ Description:
+    Relocates the elements into a heap block of at least n slots, at least
+    doubling the capacity. Should relocating throw, the block is freed and
+    the small_vector is unchanged.
+
+ Complexity: Linear in the size.
+ */
+template <class T, std::size_t N, class Alloc>
+void
+small_vector<T, N, Alloc>::grow(size_type n)
+{
+    auto cap = std::max(n, _capacity * 2);
+    T* block = traits::allocate(_alloc, cap);
+    try {
+        relocate(block, cap);
+    } catch (...) {
+        traits::deallocate(_alloc, block, cap);
+        throw;
+    }
+}
+
+
+/*
+ Function: relocate
+ Parameters:
+  - block: Uninitialised storage for cap elements.
+  - cap: The size of block.
+ Return value: None
+
+ Description:
+    Constructs every element in block with move_if_noexcept, then destroys
+    the originals and adopts block. Should a construction throw, the
+    elements built so far are destroyed and the originals are untouched;
+    freeing block is left to the caller.
+
+ Complexity: Linear in the size.
+ */
+template <class T, std::size_t N, class Alloc>
+void
+small_vector<T, N, Alloc>::relocate(T* block, size_type cap)
+{
+    size_type i = 0;
+    try {
+        for (; i < _size; ++i)
+            traits::construct(_alloc, block + i, std::move_if_noexcept(_data[i]));
+    } catch (...) {
+        while (i-- > 0)
+            traits::destroy(_alloc, block + i);
+        throw;
+    }
+
+    for (i = 0; i < _size; ++i)
+        traits::destroy(_alloc, _data + i);
+    release();
+    _data = block;
+    _capacity = cap;
+}
+
+
+/*
+ Function: release
+ Return value: None
+
+ Description:
+    Frees the heap block, if any. Elements must already be destroyed or
+    relocated.
+ */
+template <class T, std::size_t N, class Alloc>
+inline void
+small_vector<T, N, Alloc>::release()
+{
+    if (!is_inline())
+        traits::deallocate(_alloc, _data, _capacity);
+
+    _data = inline_data();
+    _capacity = N;
+}
+
+
+} // end namespace
+
 #endif /* vector_h */